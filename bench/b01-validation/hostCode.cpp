@@ -0,0 +1,171 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Measures the overhead of OWL's validation layer (see
+// owl/ll/Validation.h) on the host-side hot paths: setting variables,
+// building the SBT, setting instance transforms, and (re-)building
+// an instance group; each is run once with validation disabled and
+// once with it enabled, using the harness in
+// bench/common/BenchHarness.h.
+
+// public owl API
+#include <owl/owl.h>
+#include "deviceCode.h"
+#include "bench/common/BenchHarness.h"
+#include <owl/common/math/AffineSpace.h>
+// std
+#include <functional>
+#include <vector>
+#include <string>
+
+extern "C" char ptxCode[];
+
+using namespace owl::bench;
+
+std::vector<vec3f> vertices =
+  {
+    { -1.f,-1.f,0.f },
+    { +1.f,-1.f,0.f },
+    { -1.f,+1.f,0.f },
+    { +1.f,+1.f,0.f },
+  };
+
+std::vector<vec3i> indices =
+  {
+    { 0,1,2 }, { 1,3,2 },
+  };
+
+int main(int ac, char **av)
+{
+  int numGeoms     = 10000;
+  int numInstances = 100000;
+  // the SBT and group rebuilds are expensive, so only one warmup
+  // and a few reps by default
+  Harness harness
+    ("b01-validation",ac,av,[&](int ac, char **av, int i) {
+      const std::string arg = av[i];
+      if (i+1 >= ac)
+        return 0;
+      if (arg == "--num-geoms") {
+        numGeoms = std::atoi(av[i+1]);
+        return 2;
+      }
+      if (arg == "--num-instances") {
+        numInstances = std::atoi(av[i+1]);
+        return 2;
+      }
+      return 0;
+    },/*warmup*/1,/*reps*/10);
+  
+  // ##################################################################
+  // set up a scene with many (tiny) geoms, and many instances of them
+  // ##################################################################
+  OWLContext owl = owlContextCreate(nullptr,1);
+  OWLModule module = owlModuleCreate(owl,ptxCode);
+
+  OWLVarDecl trianglesGeomVars[] = {
+    { "color",      OWL_FLOAT3, OWL_OFFSETOF(TrianglesGeomData,color) },
+    { "materialID", OWL_INT,    OWL_OFFSETOF(TrianglesGeomData,materialID) },
+    { "index",      OWL_BUFPTR, OWL_OFFSETOF(TrianglesGeomData,index) },
+    { "vertex",     OWL_BUFPTR, OWL_OFFSETOF(TrianglesGeomData,vertex) },
+    { nullptr /* sentinel to mark end of list */ }
+  };
+  OWLGeomType trianglesGeomType
+    = owlGeomTypeCreate(owl,OWL_TRIANGLES,sizeof(TrianglesGeomData),
+                        trianglesGeomVars,-1);
+  owlGeomTypeSetClosestHit(trianglesGeomType,0,module,"TriangleMesh");
+
+  OWLBuffer vertexBuffer
+    = owlDeviceBufferCreate(owl,OWL_FLOAT3,vertices.size(),vertices.data());
+  OWLBuffer indexBuffer
+    = owlDeviceBufferCreate(owl,OWL_INT3,indices.size(),indices.data());
+
+  std::vector<OWLGeom> geoms(numGeoms);
+  std::vector<OWLVariable> colorVars(numGeoms);
+  for (int i=0;i<numGeoms;i++) {
+    geoms[i] = owlGeomCreate(owl,trianglesGeomType);
+    owlTrianglesSetVertices(geoms[i],vertexBuffer,
+                            vertices.size(),sizeof(vec3f),0);
+    owlTrianglesSetIndices(geoms[i],indexBuffer,
+                           indices.size(),sizeof(vec3i),0);
+    owlGeomSetBuffer(geoms[i],"vertex",vertexBuffer);
+    owlGeomSetBuffer(geoms[i],"index",indexBuffer);
+    owlGeomSet1i(geoms[i],"materialID",i);
+    colorVars[i] = owlGeomGetVariable(geoms[i],"color");
+  }
+  OWLGroup trianglesGroup
+    = owlTrianglesGeomGroupCreate(owl,geoms.size(),geoms.data());
+  owlGroupBuildAccel(trianglesGroup);
+
+  OWLGroup world = owlInstanceGroupCreate(owl,numInstances);
+  for (int i=0;i<numInstances;i++)
+    owlInstanceGroupSetChild(world,i,trianglesGroup);
+
+  OWLVarDecl rayGenVars[] = {
+    { "world",      OWL_GROUP,  OWL_OFFSETOF(RayGenData,world) },
+    { "camera_pos", OWL_FLOAT3, OWL_OFFSETOF(RayGenData,camera_pos) },
+    { "camera_dir", OWL_FLOAT3, OWL_OFFSETOF(RayGenData,camera_dir) },
+    { "frameID",    OWL_INT,    OWL_OFFSETOF(RayGenData,frameID) },
+    { /* sentinel to mark end of list */ }
+  };
+  OWLRayGen rayGen
+    = owlRayGenCreate(owl,module,"rayGen",
+                      sizeof(RayGenData),
+                      rayGenVars,-1);
+  OWLVariable frameIDVar = owlRayGenGetVariable(rayGen,"frameID");
+
+  owlGroupBuildAccel(world);
+  owlRayGenSetGroup(rayGen,"world",world);
+  owlBuildPrograms(owl);
+  owlBuildPipeline(owl);
+  owlBuildSBT(owl);
+
+  // ##################################################################
+  // and run the actual benchmarks, without and with validation
+  // ##################################################################
+  auto measure = [&](const std::string &name, size_t opsPerRep,
+                     const std::function<void()> &body) {
+    owlEnableValidation(false);
+    harness.run(name+" (validation off)",opsPerRep,body);
+    owlEnableValidation(true);
+    harness.run(name+" (validation on)",opsPerRep,body);
+  };
+
+  measure("variable set (per geom)",numGeoms,[&](){
+      for (int i=0;i<numGeoms;i++)
+        owlVariableSet3f(colorVars[i],i,i,i);
+    });
+  measure("variable set (raygen)",numGeoms,[&](){
+      for (int i=0;i<numGeoms;i++)
+        owlVariableSet1i(frameIDVar,i);
+    });
+  measure("instance transform set",numInstances,[&](){
+      for (int i=0;i<numInstances;i++) {
+        const affine3f xfm = affine3f::translate(vec3f((float)i,0.f,0.f));
+        owlInstanceGroupSetTransform(world,i,(const float *)&xfm,
+                                     OWL_MATRIX_FORMAT_OWL);
+      }
+    });
+  measure("build SBT",1,[&](){
+      owlBuildSBT(owl);
+    });
+  measure("instance group rebuild",1,[&](){
+      owlGroupBuildAccel(world);
+    });
+  
+  owlContextDestroy(owl);
+  return harness.finish();
+}
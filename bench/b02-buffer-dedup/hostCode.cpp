@@ -0,0 +1,110 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Measures the host-side cost of buffer deduplication (see
+// owl/ll/BufferDedup.h): hashing throughput for large buffers, and
+// the cost of hashing plus table lookup for the "many identical
+// small meshes" case that dedup is meant for. Uses the harness in
+// bench/common/BenchHarness.h.
+
+#include "owl/ll/BufferDedup.h"
+#include "bench/common/BenchHarness.h"
+// std
+#include <vector>
+#include <string>
+#include <iostream>
+#include <random>
+
+using owl::common::prettyNumber;
+using namespace owl::ll;
+using namespace owl::bench;
+
+/*! to make sure the compiler can't optimize the hashing away */
+volatile uint64_t sink = 0;
+
+int main(int ac, char **av)
+{
+  size_t bigBufferSize = 256*1024*1024;
+  int    numMeshes     = 10000;
+  int    numUnique     = 100;
+  Harness harness
+    ("b02-buffer-dedup",ac,av,[&](int ac, char **av, int i) {
+      const std::string arg = av[i];
+      if (i+1 >= ac)
+        return 0;
+      if (arg == "--big-buffer-mb") {
+        bigBufferSize = size_t(std::atoi(av[i+1]))*1024*1024;
+        return 2;
+      }
+      if (arg == "--num-meshes") {
+        numMeshes = std::atoi(av[i+1]);
+        return 2;
+      }
+      if (arg == "--num-unique") {
+        numUnique = std::atoi(av[i+1]);
+        return 2;
+      }
+      return 0;
+    },/*warmup*/1,/*reps*/10);
+
+  std::mt19937 rng(0x12345);
+  
+  // ##################################################################
+  // hashing throughput on one big buffer; one 'op' is one (KB) page,
+  // so ns/op stays comparable across buffer sizes
+  // ##################################################################
+  std::vector<uint8_t> bigBuffer(bigBufferSize);
+  for (auto &b : bigBuffer) b = (uint8_t)rng();
+  harness.run("hash big buffer (per KB)",bigBufferSize/1024,[&](){
+      sink = sink + contentHash64(bigBuffer.data(),bigBuffer.size());
+    });
+  
+  // ##################################################################
+  // many small meshes, only a few of them unique - what a typical
+  // DCC export with lots of copies of the same asset looks like
+  // ##################################################################
+  const size_t meshSize = 10000*3*sizeof(float);
+  std::vector<std::vector<uint8_t>> uniqueMeshes(numUnique);
+  for (auto &mesh : uniqueMeshes) {
+    mesh.resize(meshSize);
+    for (auto &b : mesh) b = (uint8_t)rng();
+  }
+  size_t bytesSaved = 0;
+  harness.run("hash+lookup (per mesh)",numMeshes,[&](){
+      ContentDedupTable<int> table;
+      std::vector<std::shared_ptr<int>> allocations;
+      for (int i=0;i<numMeshes;i++) {
+        const std::vector<uint8_t> &mesh = uniqueMeshes[i % numUnique];
+        const uint64_t hash = contentHash64(mesh.data(),mesh.size());
+        std::shared_ptr<int> alloc = table.find(hash,mesh.size());
+        if (!alloc) {
+          alloc = std::make_shared<int>(i);
+          table.insert(hash,mesh.size(),alloc);
+        }
+        allocations.push_back(alloc);
+      }
+      bytesSaved = table.bytesSaved;
+    });
+
+  const int result = harness.finish();
+  if (harness.selected("hash+lookup (per mesh)"))
+    ((harness.jsonFile == "-") ? std::cerr : std::cout)
+      << "#owl.bench(b02-buffer-dedup): " << numMeshes << " meshes ("
+      << numUnique << " unique) of " << prettyNumber(meshSize)
+      << "B each; dedup would save " << prettyNumber(bytesSaved) << "B of "
+      << prettyNumber(meshSize*numMeshes) << "B (per device)" << std::endl;
+  return result;
+}
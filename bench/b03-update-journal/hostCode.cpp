@@ -0,0 +1,161 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Measures the host-side cost of owlContextApplyUpdates (see
+// owl/ng/cpp/UpdateJournal.h): how fast scene update streams can be
+// encoded, and decoded plus coalesced, before anything touches the
+// GPU. The stream either gets generated (a number of frames' worth
+// of instance transforms, visibility masks, and variable writes, so
+// there is something to coalesce), or read from a file, or from
+// stdin ("--input -"), so recorded or externally produced streams
+// can be piped in; "--write <file>" dumps the generated stream.
+// Times are reported per (uncoalesced) update, using the harness in
+// bench/common/BenchHarness.h.
+
+#include "owl/ng/cpp/UpdateJournal.h"
+#include "bench/common/BenchHarness.h"
+// std
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+
+using owl::common::prettyNumber;
+using owl::common::vec3f;
+using namespace owl;
+using namespace owl::journal;
+using namespace owl::bench;
+
+/*! generates 'numFrames' frames' worth of updates for a scene of
+    'numGroups' instance groups with 'numInstances' children each:
+    per frame, a contiguous run of 'movingFraction' of each group's
+    instances moves, a few instances get shown or hidden, and the
+    camera variable of the ray gen gets written */
+std::vector<uint8_t> generateStream(int numGroups, int numInstances,
+                                    int numFrames, float movingFraction)
+{
+  std::mt19937 rng(0x1337);
+  std::uniform_real_distribution<float> rnd(-1.f,1.f);
+  Writer writer;
+  const int numMoving = std::max(1,int(numInstances*movingFraction));
+  std::vector<affine3f> xfms(numMoving);
+  for (int frame=0;frame<numFrames;frame++) {
+    for (int group=0;group<numGroups;group++) {
+      for (auto &xfm : xfms)
+        xfm = affine3f(owl::common::one)
+          * affine3f::translate(vec3f(rnd(rng),rnd(rng),rnd(rng)));
+      const int first = (frame*numMoving/2) % (numInstances-numMoving+1);
+      writer.transforms(group,first,numMoving,xfms.data());
+
+      const uint8_t mask = (frame & 1) ? 0 : 255;
+      writer.visibilityMasks(group,(frame*7)%numInstances,1,&mask);
+    }
+    const float camera[12] = { rnd(rng),rnd(rng),rnd(rng) };
+    writer.variable(TARGET_RAYGEN,0,0,camera,sizeof(camera));
+  }
+  return writer.bytes;
+}
+
+std::vector<uint8_t> readStream(const std::string &fileName)
+{
+  if (fileName == "-")
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(std::cin),
+                                std::istreambuf_iterator<char>());
+  std::ifstream in(fileName,std::ios::binary);
+  if (!in)
+    throw std::runtime_error("could not open '"+fileName+"'");
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(in),
+                              std::istreambuf_iterator<char>());
+}
+
+/*! to make sure the compiler can't optimize the decoding away */
+volatile size_t sink = 0;
+
+int main(int ac, char **av)
+{
+  int         numGroups      = 4;
+  int         numInstances   = 100000;
+  int         numFrames      = 8;
+  float       movingFraction = .25f;
+  std::string inFileName;
+  std::string outFileName;
+  Harness harness
+    ("b03-update-journal",ac,av,[&](int ac, char **av, int i) {
+      const std::string arg = av[i];
+      if (i+1 >= ac)
+        return 0;
+      if (arg == "--num-groups")
+        numGroups = std::atoi(av[i+1]);
+      else if (arg == "--num-instances")
+        numInstances = std::atoi(av[i+1]);
+      else if (arg == "--num-frames")
+        numFrames = std::atoi(av[i+1]);
+      else if (arg == "--moving")
+        movingFraction = (float)std::atof(av[i+1]);
+      else if (arg == "--input")
+        inFileName = av[i+1];
+      else if (arg == "--write")
+        outFileName = av[i+1];
+      else
+        return 0;
+      return 2;
+    },/*warmup*/1,/*reps*/10);
+
+  const bool generated = inFileName.empty();
+  std::vector<uint8_t> stream
+    = generated
+    ? generateStream(numGroups,numInstances,numFrames,movingFraction)
+    : readStream(inFileName);
+  if (!outFileName.empty()) {
+    std::ofstream out(outFileName,std::ios::binary);
+    out.write((const char *)stream.data(),stream.size());
+    if (!out)
+      throw std::runtime_error("could not write '"+outFileName+"'");
+  }
+
+  // decode once up front, for the number of updates per rep
+  Batch batch = decode(stream.data(),stream.size());
+  const size_t numUpdates = batch.numUpdatesBeforeCoalescing;
+  
+  if (generated)
+    harness.run("generate+encode (per update)",numUpdates,[&](){
+        stream = generateStream(numGroups,numInstances,
+                                numFrames,movingFraction);
+      });
+  else
+    harness.skip("generate+encode (per update)",
+                 "stream read from --input");
+  harness.run("decode+coalesce (per update)",numUpdates,[&](){
+      batch = decode(stream.data(),stream.size());
+      sink = sink + batch.numUpdates();
+    });
+
+  const int result = harness.finish();
+  ((harness.jsonFile == "-") ? std::cerr : std::cout)
+    << "#owl.bench(b03-update-journal): stream of "
+    << prettyNumber(stream.size()) << "B from "
+    << (generated
+        ? std::to_string(numFrames)+" generated frames"
+        : (inFileName == "-" ? std::string("stdin") : inFileName))
+    << ": " << batch.numRecords << " records, "
+    << prettyNumber(numUpdates) << " updates, "
+    << prettyNumber(batch.numUpdates()) << " after coalescing" << std::endl;
+  return result;
+}
@@ -0,0 +1,181 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Measures what reference counting costs on the API's hot paths:
+// resolving a handle to a typed object (what APIHandle::get<T>() and
+// borrow<T>() do on every API call), and setting a variable to a
+// buffer (which has to keep the buffer alive). Each is run with
+// std::shared_ptr - what the node graph used before - and with owl's
+// intrusive Ref (owl/ng/cpp/RefCounted.h), both owning and
+// borrowed. Uses stand-ins with the same shape as the node graph
+// classes, so it runs without a GPU.
+
+#include "owl/ng/cpp/RefCounted.h"
+#include "bench/common/BenchHarness.h"
+// std
+#include <memory>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <random>
+
+using namespace owl::bench;
+
+/*! the std::shared_ptr flavor of the node graph's object classes */
+namespace shared {
+  struct Object : public std::enable_shared_from_this<Object> {
+    virtual ~Object() {}
+  };
+  struct Buffer : public Object {
+    int data = 0;
+  };
+  struct Variable : public Object {
+    virtual void set(const std::shared_ptr<Buffer> &value) = 0;
+  };
+  struct BufferVariable : public Variable {
+    void set(const std::shared_ptr<Buffer> &value) override { buffer = value; }
+    std::shared_ptr<Buffer> buffer;
+  };
+  struct Handle {
+    template<typename T> std::shared_ptr<T> get()
+    { return std::dynamic_pointer_cast<T>(object); }
+    std::shared_ptr<Object> object;
+  };
+}
+
+/*! ... and the intrusively refcounted one */
+namespace intrusive {
+  struct Object : public owl::RefCounted {
+  };
+  struct Buffer : public Object {
+    int data = 0;
+  };
+  struct Variable : public Object {
+    virtual void set(const owl::Ref<Buffer> &value) = 0;
+  };
+  struct BufferVariable : public Variable {
+    void set(const owl::Ref<Buffer> &value) override { buffer = value; }
+    owl::Ref<Buffer> buffer;
+  };
+  struct Handle {
+    template<typename T> owl::Ref<T> get()
+    { return owl::Ref<T>(dynamic_cast<T*>(object.get())); }
+    template<typename T> T *borrow()
+    { return dynamic_cast<T*>(object.get()); }
+    owl::Ref<Object> object;
+  };
+}
+
+/*! to make sure the compiler can't optimize the lookups away */
+volatile int sink = 0;
+
+int main(int ac, char **av)
+{
+  int numHandles = 100000;
+  int numCalls   = 10000000;
+  Harness harness
+    ("b04-refcount",ac,av,[&](int ac, char **av, int i) {
+      const std::string arg = av[i];
+      if (i+1 >= ac)
+        return 0;
+      if (arg == "--num-handles") {
+        numHandles = std::atoi(av[i+1]);
+        return 2;
+      }
+      if (arg == "--num-calls") {
+        numCalls = std::atoi(av[i+1]);
+        return 2;
+      }
+      return 0;
+    },/*warmup*/1,/*reps*/10);
+
+  // same (random) call sequence for all variants, so they all see
+  // the same cache behavior
+  std::mt19937 rng(0x4242);
+  std::vector<int> calls(numCalls);
+  for (auto &c : calls) c = int(rng() % numHandles);
+
+  std::vector<shared::Handle>    sharedBuffers(numHandles),    sharedVars(numHandles);
+  std::vector<intrusive::Handle> intrusiveBuffers(numHandles), intrusiveVars(numHandles);
+  for (int i=0;i<numHandles;i++) {
+    sharedBuffers[i].object    = std::make_shared<shared::Buffer>();
+    sharedVars[i].object       = std::make_shared<shared::BufferVariable>();
+    intrusiveBuffers[i].object = owl::makeRef<intrusive::Buffer>();
+    intrusiveVars[i].object    = owl::makeRef<intrusive::BufferVariable>();
+  }
+
+  // ##################################################################
+  // handle resolution
+  // ##################################################################
+  harness.run("resolve: shared_ptr",numCalls,[&](){
+      int sum = 0;
+      for (int c : calls)
+        sum += sharedBuffers[c].get<shared::Buffer>()->data;
+      sink = sink + sum;
+    });
+  harness.run("resolve: Ref (owning)",numCalls,[&](){
+      int sum = 0;
+      for (int c : calls)
+        sum += intrusiveBuffers[c].get<intrusive::Buffer>()->data;
+      sink = sink + sum;
+    });
+  harness.run("resolve: borrowed",numCalls,[&](){
+      int sum = 0;
+      for (int c : calls)
+        sum += intrusiveBuffers[c].borrow<intrusive::Buffer>()->data;
+      sink = sink + sum;
+    });
+
+  // ##################################################################
+  // variable set: the variable has to hold on to its buffer, so
+  // there's always one reference that has to be taken; the
+  // question is how many more get taken (and dropped) on the way
+  // ##################################################################
+  harness.run("variable set: shared_ptr",numCalls,[&](){
+      for (int c : calls) {
+        std::shared_ptr<shared::Variable> var
+          = sharedVars[c].get<shared::Variable>();
+        std::shared_ptr<shared::Buffer> buffer
+          = sharedBuffers[numHandles-1-c].get<shared::Buffer>();
+        var->set(buffer);
+      }
+    });
+  harness.run("variable set: Ref (owning)",numCalls,[&](){
+      for (int c : calls) {
+        owl::Ref<intrusive::Variable> var
+          = intrusiveVars[c].get<intrusive::Variable>();
+        owl::Ref<intrusive::Buffer> buffer
+          = intrusiveBuffers[numHandles-1-c].get<intrusive::Buffer>();
+        var->set(buffer);
+      }
+    });
+  harness.run("variable set: borrowed",numCalls,[&](){
+      for (int c : calls) {
+        intrusive::Variable *var
+          = intrusiveVars[c].borrow<intrusive::Variable>();
+        var->set(intrusiveBuffers[numHandles-1-c].borrow<intrusive::Buffer>());
+      }
+    });
+
+  const int result = harness.finish();
+  ((harness.jsonFile == "-") ? std::cerr : std::cout)
+    << "#owl.bench(b04-refcount): " << numCalls << " calls on "
+    << numHandles << " handles, "
+    << (OWL_ATOMIC_REFCOUNT ? "atomic" : "non-atomic") << " Ref counts"
+    << std::endl;
+  return result;
+}
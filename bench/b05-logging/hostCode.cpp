@@ -0,0 +1,87 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Measures what OWL_LOG() (owl/ll/Logging.h) costs inside a hot loop
+// - like the ones that write SBT records or set up build inputs for
+// each child of a group: without any log statement, with a
+// disabled one, and with an enabled one that goes to a (no-op) custom
+// sink, ie, the cost of formatting alone.
+
+#include "owl/ll/Logging.h"
+#include "bench/common/BenchHarness.h"
+// std
+#include <vector>
+#include <string>
+
+using owl::ll::Logging;
+using namespace owl::bench;
+
+/*! to make sure the compiler can't optimize the loops away */
+volatile size_t sink = 0;
+
+void ignoreMessage(int32_t, const char *, void *) {}
+
+int main(int ac, char **av)
+{
+  int numItems = 10000000;
+  Harness harness
+    ("b05-logging",ac,av,[&](int ac, char **av, int i) {
+      const std::string arg = av[i];
+      if (arg == "--num-items" && i+1 < ac) {
+        numItems = std::atoi(av[i+1]);
+        return 2;
+      }
+      return 0;
+    },/*warmup*/1,/*reps*/10);
+
+  std::vector<uint32_t> items(numItems);
+  for (int i=0;i<numItems;i++) items[i] = i*0x9e3779b9u;
+  
+  harness.run("no log statement",numItems,[&](){
+      size_t sum = 0;
+      for (int i=0;i<numItems;i++)
+        sum += items[i] >> 3;
+      sink = sink + sum;
+    });
+  
+  Logging::setLevel(Logging::LEVEL_INFO);
+  harness.run("disabled OWL_LOG",numItems,[&](){
+      size_t sum = 0;
+      for (int i=0;i<numItems;i++) {
+        sum += items[i] >> 3;
+        OWL_LOG(LEVEL_DEBUG,"item " << i << " = " << items[i]);
+      }
+      sink = sink + sum;
+    });
+
+  // formatting every item is way slower, so only do a fraction
+  const int numFormatted = std::max(1,numItems/100);
+  Logging::setSink(ignoreMessage,nullptr);
+  Logging::setLevel(Logging::LEVEL_DEBUG);
+  harness.run("enabled OWL_LOG (no-op sink)",numFormatted,[&](){
+      size_t sum = 0;
+      for (int i=0;i<numFormatted;i++) {
+        sum += items[i] >> 3;
+        OWL_LOG(LEVEL_DEBUG,"item " << i << " = " << items[i]);
+      }
+      sink = sink + sum;
+    });
+  Logging::setSink(nullptr,nullptr);
+  Logging::setLevel(Logging::LEVEL_INFO);
+  
+  return harness.finish();
+}
@@ -0,0 +1,200 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+/*! \file bench/b06-scene-scaling/SceneGenerators.h host-side
+    generators for the scene families of the scene scaling benchmark.
+    All generators are parallel, and derive each element's random
+    numbers from a hash of (seed,element index) only, so the scene
+    is the same no matter how many threads generated it */
+
+#pragma once
+
+#include <owl/common/math/vec.h>
+#include <owl/common/math/AffineSpace.h>
+#include "owl/common/parallel/parallel_for.h"
+// std
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace owl {
+  namespace bench {
+    using owl::common::vec3f;
+    using owl::common::vec3i;
+    using owl::common::vec4f;
+    using owl::common::affine3f;
+
+    /*! number of elements each parallel task generates */
+    static const size_t generateBlockSize = 16*1024;
+
+    /*! splitmix64 finalizer */
+    inline uint64_t hash64(uint64_t x)
+    {
+      x += 0x9e3779b97f4a7c15ULL;
+      x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+      return x ^ (x >> 31);
+    }
+
+    /*! the 'k'th random number in [0,1) of element 'i' */
+    inline float random01(uint64_t seed, size_t i, int k)
+    {
+      const uint64_t h = hash64(seed ^ hash64(i*8+k));
+      return (h >> 40) * (1.f/(1<<24));
+    }
+
+    /*! a random position in the cube [0,edge)^3 */
+    inline vec3f randomPosition(uint64_t seed, size_t i, float edge)
+    {
+      return edge * vec3f(random01(seed,i,0),
+                          random01(seed,i,1),
+                          random01(seed,i,2));
+    }
+
+    /*! edge length of the cube that holds 'numObjects' unit-sized
+        objects at constant density, so the quality of their accel
+        does not change with scale */
+    inline float domainEdge(size_t numObjects)
+    {
+      return 4.f*std::cbrt((float)std::max(numObjects,size_t(1)));
+    }
+
+    /*! 'numSpheres' random spheres, as (center,radius) */
+    inline std::vector<vec4f> generateSpheres(size_t numSpheres,
+                                              uint64_t seed)
+    {
+      std::vector<vec4f> spheres(numSpheres);
+      const float edge = domainEdge(numSpheres);
+      owl::common::parallel_for_blocked
+        (0,numSpheres,generateBlockSize,[&](size_t begin, size_t end){
+          for (size_t i=begin;i<end;i++) {
+            const vec3f center = randomPosition(seed,i,edge);
+            const float radius = .2f + .8f*random01(seed,i,3);
+            spheres[i] = vec4f(center.x,center.y,center.z,radius);
+          }
+        });
+      return spheres;
+    }
+
+    /*! 'numBoxes' random boxes, as a single triangle mesh with 8
+        vertices and 12 triangles per box */
+    inline void generateBoxes(size_t numBoxes,
+                              uint64_t seed,
+                              std::vector<vec3f> &vertices,
+                              std::vector<vec3i> &indices)
+    {
+      if (numBoxes > size_t(std::numeric_limits<int>::max())/8)
+        throw std::runtime_error("cannot generate "+std::to_string(numBoxes)
+                                 +" boxes in a single mesh: vertex indices"
+                                 " would overflow");
+      static const int boxIndices[12][3] = {
+        { 0,1,3 }, { 0,3,2 }, { 4,6,7 }, { 4,7,5 },
+        { 0,4,5 }, { 0,5,1 }, { 2,3,7 }, { 2,7,6 },
+        { 0,2,6 }, { 0,6,4 }, { 1,5,7 }, { 1,7,3 },
+      };
+      vertices.resize(8*numBoxes);
+      indices.resize(12*numBoxes);
+      const float edge = domainEdge(numBoxes);
+      owl::common::parallel_for_blocked
+        (0,numBoxes,generateBlockSize,[&](size_t begin, size_t end){
+          for (size_t i=begin;i<end;i++) {
+            const vec3f lower = randomPosition(seed,i,edge);
+            const vec3f size(.2f+.8f*random01(seed,i,3),
+                             .2f+.8f*random01(seed,i,4),
+                             .2f+.8f*random01(seed,i,5));
+            for (int c=0;c<8;c++)
+              vertices[8*i+c] = lower + size*vec3f((c&1) ? 1.f : 0.f,
+                                                   (c&2) ? 1.f : 0.f,
+                                                   (c&4) ? 1.f : 0.f);
+            const int base = int(8*i);
+            for (int t=0;t<12;t++)
+              indices[12*i+t] = vec3i(base+boxIndices[t][0],
+                                      base+boxIndices[t][1],
+                                      base+boxIndices[t][2]);
+          }
+        });
+    }
+
+    /*! 'numInstances' random transforms (rotation about the z axis,
+        uniform scale, and translation), for instancing a single
+        unit-sized mesh */
+    inline std::vector<affine3f> generateFanOut(size_t numInstances,
+                                                uint64_t seed)
+    {
+      std::vector<affine3f> xfms(numInstances);
+      const float edge = domainEdge(numInstances);
+      owl::common::parallel_for_blocked
+        (0,numInstances,generateBlockSize,[&](size_t begin, size_t end){
+          for (size_t i=begin;i<end;i++) {
+            const float angle = 2.f*float(M_PI)*random01(seed,i,3);
+            const float scale = .2f + .8f*random01(seed,i,4);
+            xfms[i]
+              = affine3f::translate(randomPosition(seed,i,edge))
+              * affine3f::rotate(vec3f(0.f,0.f,1.f),angle)
+              * affine3f::scale(vec3f(scale));
+          }
+        });
+      return xfms;
+    }
+
+    /*! the unit pyramid that the sierpinski family instantiates (the
+        same as in samples/s08-sierpinski) */
+    inline void sierpinskiPyramid(std::vector<vec3f> &vertices,
+                                  std::vector<vec3i> &indices)
+    {
+      vertices = {
+        { -0.5f,-0.5f,-0.5f },
+        { +0.5f,-0.5f,-0.5f },
+        { +0.5f,+0.5f,-0.5f },
+        { -0.5f,+0.5f,-0.5f },
+        { 0.0f,0.0f,+0.5f },
+      };
+      indices = {
+        { 0,1,3 }, { 1,2,3 },
+        { 0,4,1 }, { 0,3,4 },
+        { 3,2,4 }, { 1,4,2 },
+      };
+    }
+
+    /*! the transforms of the five children of each sierpinski level
+        (relative to the level below) */
+    inline std::vector<affine3f> sierpinskiChildTransforms()
+    {
+      const affine3f half = affine3f::scale(vec3f(.5f));
+      return {
+        half * affine3f::translate(vec3f(-.5f,-.5f,-.5f)),
+        half * affine3f::translate(vec3f(+.5f,-.5f,-.5f)),
+        half * affine3f::translate(vec3f(-.5f,+.5f,-.5f)),
+        half * affine3f::translate(vec3f(+.5f,+.5f,-.5f)),
+        half * affine3f::translate(vec3f(0.f,0.f,+.5f)),
+      };
+    }
+
+    /*! number of pyramids a sierpinski scene of the given number of
+        levels expands to */
+    inline size_t sierpinskiNumLeaves(int numLevels)
+    {
+      size_t result = 1;
+      for (int level=1;level<numLevels;level++)
+        result *= 5;
+      return result;
+    }
+
+  } // ::owl::bench
+} // ::owl
@@ -0,0 +1,60 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "deviceCode.h"
+#include <optix_device.h>
+
+/* only the bounds program ever runs (when building the spheres'
+   accel); the others are needed so there are valid program groups
+   to write SBT records for */
+
+OPTIX_BOUNDS_PROGRAM(Spheres)(const void  *geomData,
+                              box3f       &primBounds,
+                              const int    primID)
+{
+  const SpheresGeomData &self = *(const SpheresGeomData*)geomData;
+  const vec4f sphere = self.spheres[primID];
+  const vec3f center(sphere.x,sphere.y,sphere.z);
+  primBounds = box3f()
+    .extend(center - sphere.w)
+    .extend(center + sphere.w);
+}
+
+OPTIX_INTERSECT_PROGRAM(Spheres)()
+{
+  const int primID = optixGetPrimitiveIndex();
+  const vec4f sphere = owl::getProgramData<SpheresGeomData>().spheres[primID];
+  const vec3f org = optixGetObjectRayOrigin();
+  const vec3f dir = optixGetObjectRayDirection();
+  const vec3f oc  = org - vec3f(sphere.x,sphere.y,sphere.z);
+  const float a = dot(dir,dir);
+  const float b = dot(oc,dir);
+  const float c = dot(oc,oc) - sphere.w*sphere.w;
+  const float discriminant = b*b - a*c;
+  if (discriminant < 0.f) return;
+  const float t = (-b - sqrtf(discriminant)) / a;
+  if (t > optixGetRayTmin() && t < optixGetRayTmax())
+    optixReportIntersection(t,0);
+}
+
+OPTIX_CLOSEST_HIT_PROGRAM(Spheres)()
+{}
+
+OPTIX_CLOSEST_HIT_PROGRAM(TriangleMesh)()
+{}
+
+OPTIX_RAYGEN_PROGRAM(rayGen)()
+{}
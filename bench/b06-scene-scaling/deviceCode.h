@@ -0,0 +1,42 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include <owl/owl.h>
+#include <owl/common/math/vec.h>
+
+using namespace owl;
+
+/*! N spheres in a single user geom, one vec4f (center,radius) per
+    primitive */
+struct SpheresGeomData
+{
+  vec4f *spheres;
+};
+
+/*! used for both the boxes and the (sierpinski/fan-out) pyramids */
+struct TrianglesGeomData
+{
+  vec3i *index;
+  vec3f *vertex;
+};
+
+struct RayGenData
+{
+  OptixTraversableHandle world;
+  int    frameID;
+};
@@ -0,0 +1,468 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Scene scalability sweeps: generates each of a few scene families at
+// a series of scales, and measures - for each scale - what it costs
+// on the host to generate the scene, to construct it in OWL (buffer
+// uploads, geoms, and geom accels), to pack its instances (setting
+// children and transforms, and building the instance accels), and
+// to build the SBT, as well as how much device memory it ends up
+// using per object. The families are
+//
+//   spheres      N random spheres in one user geom
+//   boxes        N random boxes in one triangle mesh
+//   sierpinski   the nested instances of samples/s08-sierpinski, with
+//                the scale being the number of levels
+//   fanout       N random instances of a single box mesh
+//
+// Each scale point runs in a fresh context, and results are the
+// median over all reps; use --csv and/or --json to get the scaling
+// curves in a form that can be plotted or compared between releases.
+// The harness' --filter selects families by name.
+
+// public owl API
+#include <owl/owl.h>
+#include "deviceCode.h"
+#include "SceneGenerators.h"
+#include "bench/common/BenchHarness.h"
+#include <cuda_runtime.h>
+// std
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+extern "C" char ptxCode[];
+
+using owl::common::getCurrentTime;
+using namespace owl::bench;
+
+static const char *allFamilies[] = {
+  "spheres", "boxes", "sierpinski", "fanout"
+};
+
+/*! the scales we sweep over if none are given on the command line */
+std::vector<size_t> defaultScales(const std::string &family)
+{
+  if (family == "sierpinski")
+    return { 1, 2, 3, 4, 5, 6, 7, 8 };
+  if (family == "fanout")
+    return { 100, 1000, 10000, 100000, 1000000 };
+  return { 1000, 10000, 100000, 1000000, 10000000 };
+}
+
+/*! what we measured for one rep of one scale point; times are in
+    seconds */
+struct Sample {
+  double genTime       = 0.;
+  double constructTime = 0.;
+  double packTime      = 0.;
+  double sbtTime       = 0.;
+  size_t hostBytes     = 0;
+  size_t uploadBytes   = 0;
+  size_t deviceBytes   = 0;
+};
+
+struct ScalePoint {
+  std::string         family;
+  size_t              scale;
+  /*! number of spheres, boxes, or (leaf) instances */
+  size_t              numObjects;
+  /*! number of primitives the scene expands to */
+  size_t              numPrims;
+  std::vector<Sample> samples;
+
+  Stats timeStats(double Sample::*time) const
+  {
+    std::vector<double> ms;
+    for (auto &s : samples) ms.push_back(s.*time * 1000.);
+    return computeStats(ms);
+  }
+  size_t medianBytes(size_t Sample::*bytes) const
+  {
+    std::vector<double> values;
+    for (auto &s : samples) values.push_back((double)(s.*bytes));
+    return (size_t)computeStats(values).median;
+  }
+};
+
+/*! current value of the given (process-wide) counter */
+uint64_t getCounter(OWLContext owl, const char *name)
+{
+  const OWLMetrics *metrics = owlContextGetMetrics(owl);
+  uint64_t value = 0;
+  for (size_t i=0;i<metrics->numCounters;i++)
+    if (!strcmp(metrics->counters[i].name,name))
+      value = metrics->counters[i].value;
+  owlMetricsRelease(metrics);
+  return value;
+}
+
+size_t usedDeviceMemory()
+{
+  size_t free = 0, total = 0;
+  cudaMemGetInfo(&free,&total);
+  return total - free;
+}
+
+template<typename T>
+size_t bytesOf(const std::vector<T> &v) { return v.size()*sizeof(T); }
+
+/*! generates, builds, and tears down one scene of the given family
+    and scale, in a fresh context */
+Sample runOnce(const std::string &family, size_t scale, uint64_t seed)
+{
+  Sample sample;
+  OWLContext owl = owlContextCreate(nullptr,1);
+  if (family == "sierpinski")
+    owlSetMaxInstancingDepth(owl,(int)scale);
+  OWLModule module = owlModuleCreate(owl,ptxCode);
+
+  OWLVarDecl spheresGeomVars[] = {
+    { "spheres", OWL_BUFPTR, OWL_OFFSETOF(SpheresGeomData,spheres) },
+    { nullptr /* sentinel to mark end of list */ }
+  };
+  OWLGeomType spheresGeomType
+    = owlGeomTypeCreate(owl,OWL_GEOMETRY_USER,sizeof(SpheresGeomData),
+                        spheresGeomVars,-1);
+  owlGeomTypeSetClosestHit(spheresGeomType,0,module,"Spheres");
+  owlGeomTypeSetIntersectProg(spheresGeomType,0,module,"Spheres");
+  owlGeomTypeSetBoundsProg(spheresGeomType,module,"Spheres");
+
+  OWLVarDecl trianglesGeomVars[] = {
+    { "index",  OWL_BUFPTR, OWL_OFFSETOF(TrianglesGeomData,index) },
+    { "vertex", OWL_BUFPTR, OWL_OFFSETOF(TrianglesGeomData,vertex) },
+    { nullptr /* sentinel to mark end of list */ }
+  };
+  OWLGeomType trianglesGeomType
+    = owlGeomTypeCreate(owl,OWL_TRIANGLES,sizeof(TrianglesGeomData),
+                        trianglesGeomVars,-1);
+  owlGeomTypeSetClosestHit(trianglesGeomType,0,module,"TriangleMesh");
+
+  OWLVarDecl rayGenVars[] = {
+    { "world",   OWL_GROUP, OWL_OFFSETOF(RayGenData,world) },
+    { "frameID", OWL_INT,   OWL_OFFSETOF(RayGenData,frameID) },
+    { /* sentinel to mark end of list */ }
+  };
+  OWLRayGen rayGen
+    = owlRayGenCreate(owl,module,"rayGen",
+                      sizeof(RayGenData),
+                      rayGenVars,-1);
+  // (the bounds programs have to exist before we can build the
+  // spheres' accel)
+  owlBuildPrograms(owl);
+  owlBuildPipeline(owl);
+
+  const size_t memBefore    = usedDeviceMemory();
+  const uint64_t uploadBefore
+    = getCounter(owl,"owl_buffer_upload_bytes_total");
+
+  // ------------------------------------------------------------------
+  // generate the scene on the host
+  // ------------------------------------------------------------------
+  std::vector<vec4f>    spheres;
+  std::vector<vec3f>    vertices;
+  std::vector<vec3i>    indices;
+  std::vector<affine3f> xfms;
+  double t0 = getCurrentTime();
+  if (family == "spheres")
+    spheres = generateSpheres(scale,seed);
+  else if (family == "boxes")
+    generateBoxes(scale,seed,vertices,indices);
+  else if (family == "fanout") {
+    generateBoxes(1,seed,vertices,indices);
+    xfms = generateFanOut(scale,seed);
+  } else {
+    sierpinskiPyramid(vertices,indices);
+    xfms = sierpinskiChildTransforms();
+  }
+  double t1 = getCurrentTime();
+  sample.genTime   = t1-t0;
+  sample.hostBytes
+    = bytesOf(spheres)+bytesOf(vertices)+bytesOf(indices)+bytesOf(xfms);
+
+  // ------------------------------------------------------------------
+  // construct the geometry, and its accel
+  // ------------------------------------------------------------------
+  t0 = getCurrentTime();
+  OWLGroup world;
+  if (family == "spheres") {
+    OWLBuffer spheresBuffer
+      = owlDeviceBufferCreate(owl,OWL_FLOAT4,spheres.size(),spheres.data());
+    OWLGeom geom = owlGeomCreate(owl,spheresGeomType);
+    owlGeomSetPrimCount(geom,spheres.size());
+    owlGeomSetBuffer(geom,"spheres",spheresBuffer);
+    world = owlUserGeomGroupCreate(owl,1,&geom);
+  } else {
+    OWLBuffer vertexBuffer
+      = owlDeviceBufferCreate(owl,OWL_FLOAT3,vertices.size(),vertices.data());
+    OWLBuffer indexBuffer
+      = owlDeviceBufferCreate(owl,OWL_INT3,indices.size(),indices.data());
+    OWLGeom geom = owlGeomCreate(owl,trianglesGeomType);
+    owlTrianglesSetVertices(geom,vertexBuffer,
+                            vertices.size(),sizeof(vec3f),0);
+    owlTrianglesSetIndices(geom,indexBuffer,
+                           indices.size(),sizeof(vec3i),0);
+    owlGeomSetBuffer(geom,"vertex",vertexBuffer);
+    owlGeomSetBuffer(geom,"index",indexBuffer);
+    world = owlTrianglesGeomGroupCreate(owl,1,&geom);
+  }
+  owlGroupBuildAccel(world);
+  t1 = getCurrentTime();
+  sample.constructTime = t1-t0;
+
+  // ------------------------------------------------------------------
+  // pack the instances (if any), and build the instance accel(s)
+  // ------------------------------------------------------------------
+  t0 = getCurrentTime();
+  if (family == "fanout") {
+    std::vector<OWLGroup> children(xfms.size(),world);
+    OWLGroup group
+      = owlInstanceGroupCreate(owl,children.size(),children.data());
+    for (size_t i=0;i<xfms.size();i++)
+      owlInstanceGroupSetTransform(group,(int)i,(const float *)&xfms[i],
+                                   OWL_MATRIX_FORMAT_OWL);
+    owlGroupBuildAccel(group);
+    world = group;
+  } else if (family == "sierpinski") {
+    for (size_t level=1;level<scale;level++) {
+      OWLGroup group = owlInstanceGroupCreate(owl,xfms.size());
+      for (size_t i=0;i<xfms.size();i++) {
+        owlInstanceGroupSetChild(group,(int)i,world);
+        owlInstanceGroupSetTransform(group,(int)i,(const float *)&xfms[i],
+                                     OWL_MATRIX_FORMAT_OWL);
+      }
+      owlGroupBuildAccel(group);
+      world = group;
+    }
+  }
+  t1 = getCurrentTime();
+  sample.packTime = t1-t0;
+
+  // ------------------------------------------------------------------
+  // and the SBT
+  // ------------------------------------------------------------------
+  owlRayGenSetGroup(rayGen,"world",world);
+  t0 = getCurrentTime();
+  owlBuildSBT(owl);
+  t1 = getCurrentTime();
+  sample.sbtTime = t1-t0;
+
+  cudaDeviceSynchronize();
+  sample.deviceBytes
+    = std::max(usedDeviceMemory(),memBefore) - memBefore;
+  sample.uploadBytes
+    = getCounter(owl,"owl_buffer_upload_bytes_total") - uploadBefore;
+  owlContextDestroy(owl);
+  return sample;
+}
+
+/*! parses a comma-separated list of scales; accepts '1e6' and the
+    like */
+std::vector<size_t> parseScales(const std::string &list)
+{
+  std::vector<size_t> scales;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss,item,',')) {
+    const double scale = std::stod(item);
+    if (scale < 1.)
+      throw std::runtime_error("invalid scale '"+item+"'");
+    scales.push_back((size_t)scale);
+  }
+  return scales;
+}
+
+void writeCSV(std::ostream &out, const std::vector<ScalePoint> &points)
+{
+  out << "family,scale,objects,prims,"
+      << "gen_ms,construct_ms,pack_ms,sbt_ms,"
+      << "host_bytes,upload_bytes,device_bytes,device_bytes_per_object\n";
+  out << std::setprecision(9) << std::defaultfloat;
+  for (auto &p : points) {
+    const size_t deviceBytes = p.medianBytes(&Sample::deviceBytes);
+    out << p.family << "," << p.scale << ","
+        << p.numObjects << "," << p.numPrims << ","
+        << p.timeStats(&Sample::genTime).median << ","
+        << p.timeStats(&Sample::constructTime).median << ","
+        << p.timeStats(&Sample::packTime).median << ","
+        << p.timeStats(&Sample::sbtTime).median << ","
+        << p.medianBytes(&Sample::hostBytes) << ","
+        << p.medianBytes(&Sample::uploadBytes) << ","
+        << deviceBytes << ","
+        << double(deviceBytes)/std::max(p.numObjects,size_t(1)) << "\n";
+  }
+}
+
+void writeJSON(std::ostream &out, const std::vector<ScalePoint> &points,
+               int numReps, uint64_t seed)
+{
+  auto writeTime = [&](const char *name, const Stats &stats) {
+    out << "\"" << name << "\": { \"min\": " << stats.min
+        << ", \"median\": " << stats.median
+        << ", \"max\": " << stats.max << " }";
+  };
+  out << std::setprecision(9) << std::defaultfloat;
+  out << "{\n  \"suite\": \"b06-scene-scaling\""
+      << ",\n  \"reps\": " << numReps
+      << ",\n  \"seed\": " << seed
+#ifdef NDEBUG
+      << ",\n  \"build\": \"release\""
+#else
+      << ",\n  \"build\": \"debug\""
+#endif
+      << ",\n  \"points\": [";
+  for (size_t i=0;i<points.size();i++) {
+    const ScalePoint &p = points[i];
+    out << (i ? ",\n" : "\n")
+        << "    { \"family\": \"" << p.family << "\""
+        << ", \"scale\": " << p.scale
+        << ", \"objects\": " << p.numObjects
+        << ", \"prims\": " << p.numPrims
+        << ",\n      \"ms\": { ";
+    writeTime("gen",p.timeStats(&Sample::genTime));
+    out << ", ";
+    writeTime("construct",p.timeStats(&Sample::constructTime));
+    out << ",\n              ";
+    writeTime("pack",p.timeStats(&Sample::packTime));
+    out << ", ";
+    writeTime("sbt",p.timeStats(&Sample::sbtTime));
+    out << " },\n      \"bytes\": { \"host\": "
+        << p.medianBytes(&Sample::hostBytes)
+        << ", \"upload\": " << p.medianBytes(&Sample::uploadBytes)
+        << ", \"device\": " << p.medianBytes(&Sample::deviceBytes)
+        << " } }";
+  }
+  out << "\n  ]\n}\n";
+}
+
+/*! writes the results with the given writer to 'fileName' ('-' for
+    stdout); returns false if that failed */
+bool writeResults(const std::string &fileName,
+                  const std::function<void(std::ostream &)> &write)
+{
+  if (fileName == "-") {
+    write(std::cout);
+    return true;
+  }
+  std::ofstream out(fileName);
+  write(out);
+  if (out) return true;
+  std::cerr << "#owl.bench(b06): could not write '"
+            << fileName << "'" << std::endl;
+  return false;
+}
+
+int main(int ac, char **av)
+{
+  std::vector<std::string> families;
+  std::vector<size_t>      scales;
+  uint64_t    seed = 0x5eed;
+  std::string csvFile;
+  // each rep is a whole scene build, so no warmup and only a few
+  // reps by default
+  Harness harness
+    ("b06-scene-scaling",ac,av,[&](int ac, char **av, int i) {
+      const std::string arg = av[i];
+      if (i+1 >= ac)
+        return 0;
+      if (arg == "--family") {
+        const std::string family = av[i+1];
+        if (family == "all")
+          families.insert(families.end(),
+                          std::begin(allFamilies),std::end(allFamilies));
+        else if (std::find(std::begin(allFamilies),std::end(allFamilies),
+                           family) != std::end(allFamilies))
+          families.push_back(family);
+        else
+          throw std::runtime_error("unknown scene family '"+family+"'");
+        return 2;
+      }
+      if (arg == "--scales") {
+        scales = parseScales(av[i+1]);
+        return 2;
+      }
+      if (arg == "--seed") {
+        seed = std::stoull(av[i+1]);
+        return 2;
+      }
+      if (arg == "--csv") {
+        csvFile = av[i+1];
+        return 2;
+      }
+      return 0;
+    },/*warmup*/0,/*reps*/3);
+  const std::string &jsonFile = harness.jsonFile;
+  if (families.empty())
+    families.assign(std::begin(allFamilies),std::end(allFamilies));
+
+  // (with results going to stdout the table goes to stderr, so the
+  // output stays machine-readable)
+  std::ostream &table
+    = (csvFile == "-" || jsonFile == "-") ? std::cerr : std::cout;
+
+  std::vector<ScalePoint> points;
+  for (auto &family : families) {
+    if (!harness.selected(family)) continue;
+    for (auto scale : scales.empty() ? defaultScales(family) : scales) {
+      ScalePoint p;
+      p.family = family;
+      p.scale  = scale;
+      if (family == "sierpinski") {
+        if (scale > 20)
+          throw std::runtime_error("too many sierpinski levels");
+        p.numObjects = sierpinskiNumLeaves((int)scale);
+        p.numPrims   = 6*p.numObjects;
+      } else {
+        p.numObjects = scale;
+        p.numPrims   = (family == "spheres") ? scale : 12*scale;
+      }
+      for (int rep=0;rep<harness.numWarmup;rep++)
+        runOnce(family,scale,seed);
+      for (int rep=0;rep<harness.numReps;rep++)
+        p.samples.push_back(runOnce(family,scale,seed));
+      points.push_back(p);
+
+      const size_t deviceBytes = p.medianBytes(&Sample::deviceBytes);
+      table << "#owl.bench(b06): " << std::setw(10) << std::left << family
+            << std::right << " scale " << std::setw(10) << scale
+            << std::fixed << std::setprecision(3)
+            << " gen "       << std::setw(10) << p.timeStats(&Sample::genTime).median
+            << " construct " << std::setw(10) << p.timeStats(&Sample::constructTime).median
+            << " pack "      << std::setw(10) << p.timeStats(&Sample::packTime).median
+            << " sbt "       << std::setw(8)  << p.timeStats(&Sample::sbtTime).median
+            << " (ms), "     << std::setprecision(1)
+            << double(deviceBytes)/std::max(p.numObjects,size_t(1))
+            << " device bytes/object" << std::endl;
+    }
+  }
+
+  bool ok = true;
+  if (!csvFile.empty())
+    ok &= writeResults(csvFile,[&](std::ostream &out){
+        writeCSV(out,points);
+      });
+  if (!jsonFile.empty())
+    ok &= writeResults(jsonFile,[&](std::ostream &out){
+        writeJSON(out,points,harness.numReps,seed);
+      });
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "deviceCode.h"
+#include <optix_device.h>
+
+extern "C" __constant__ LaunchParams optixLaunchParams;
+
+OPTIX_RAYGEN_PROGRAM(rayGen)()
+{
+  const LaunchParams &lp = optixLaunchParams;
+  const vec2i pixelID = owl::getLaunchIndex();
+
+  const vec2f screen = (vec2f(pixelID)+vec2f(.5f)) / vec2f(lp.fbSize);
+  owl::Ray ray;
+  ray.origin    = lp.camera.pos;
+  ray.direction = normalize(lp.camera.dir_00
+                            + screen.u * lp.camera.dir_du
+                            + screen.v * lp.camera.dir_dv);
+
+  vec3f color;
+  owl::traceRay(lp.world,ray,color);
+  lp.fbPtr[pixelID.x+lp.fbSize.x*pixelID.y] = owl::make_rgba(color);
+}
+
+OPTIX_CLOSEST_HIT_PROGRAM(TriangleMesh)()
+{
+  const TrianglesGeomData &self = owl::getProgramData<TrianglesGeomData>();
+  const vec3i index  = self.index[optixGetPrimitiveIndex()];
+  const vec3f &A     = self.vertex[index.x];
+  const vec3f &B     = self.vertex[index.y];
+  const vec3f &C     = self.vertex[index.z];
+  const vec3f Ng     = normalize(cross(B-A,C-A));
+  const vec3f rayDir = optixGetWorldRayDirection();
+  owl::getPRD<vec3f>() = vec3f(.2f + .8f*fabsf(dot(rayDir,Ng)));
+}
+
+OPTIX_MISS_PROGRAM(miss)()
+{
+  owl::getPRD<vec3f>() = vec3f(.1f);
+}
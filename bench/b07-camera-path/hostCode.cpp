@@ -0,0 +1,255 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Plays back a camera path on a headless ViewerWidget (see
+// ViewerWidget::playCameraPath() and
+// owl/common/viewerWidget/CameraPath.h), so a flythrough recorded in
+// a viewer can be replayed - frame for frame the same cameras - on a
+// benchmark host without a display. The scene is a grid of
+// instanced cubes; without '--camera-path' the path is an orbit
+// around it, which '--write-path' saves for later runs. Each rep
+// plays the whole path, timed by the harness in
+// bench/common/BenchHarness.h; the per-frame update and render times
+// of the last rep get summarized, and written with '--csv'.
+
+#include <owl/owl.h>
+#include "deviceCode.h"
+#include "bench/common/BenchHarness.h"
+#include "owl/common/viewerWidget/ViewerWidget.h"
+#include <owl/common/math/AffineSpace.h>
+#include <cuda_runtime.h>
+// std
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+extern "C" char ptxCode[];
+
+using namespace owl::bench;
+using namespace owl::viewer;
+
+std::vector<vec3f> vertices =
+  {
+    { -1.f,-1.f,-1.f },
+    { +1.f,-1.f,-1.f },
+    { -1.f,+1.f,-1.f },
+    { +1.f,+1.f,-1.f },
+    { -1.f,-1.f,+1.f },
+    { +1.f,-1.f,+1.f },
+    { -1.f,+1.f,+1.f },
+    { +1.f,+1.f,+1.f }
+  };
+
+std::vector<vec3i> indices =
+  {
+    { 0,1,3 }, { 2,3,0 },
+    { 5,7,6 }, { 5,6,4 },
+    { 0,4,5 }, { 0,5,1 },
+    { 2,3,7 }, { 2,7,6 },
+    { 1,5,7 }, { 1,7,3 },
+    { 4,0,2 }, { 4,2,6 }
+  };
+
+/*! a widget without a window that renders into a device buffer;
+    render() waits for its frame, so playback times the whole frame */
+struct PlaybackWidget : public ViewerWidget {
+  PlaybackWidget(const vec2i &fbSize,
+                 OWLRayGen rayGen,
+                 OWLLaunchParams launchParams)
+    : ViewerWidget(fbSize),
+      rayGen(rayGen),
+      launchParams(launchParams)
+  {}
+
+  void cameraChanged() override
+  {
+    const SimpleCamera &camera = getCamera();
+    owlLaunchParamsSet3f(launchParams,"camera.pos",
+                         (const owl3f&)camera.lens.center);
+    owlLaunchParamsSet3f(launchParams,"camera.dir_00",
+                         (const owl3f&)camera.screen.lower_left);
+    owlLaunchParamsSet3f(launchParams,"camera.dir_du",
+                         (const owl3f&)camera.screen.horizontal);
+    owlLaunchParamsSet3f(launchParams,"camera.dir_dv",
+                         (const owl3f&)camera.screen.vertical);
+  }
+
+  void render() override
+  {
+    const vec2i fbSize = getWindowSize();
+    owlParamsLaunch2D(rayGen,fbSize.x,fbSize.y,launchParams);
+    cudaStreamSynchronize(owlParamsGetCudaStream(launchParams,0));
+  }
+
+  OWLRayGen       rayGen;
+  OWLLaunchParams launchParams;
+};
+
+/*! 'numFrames' cameras on a circle around the grid, one 60th of a
+    second apart */
+CameraPath orbitPath(int numFrames, float gridExtent, float aspect)
+{
+  CameraPath path;
+  const vec3f center(gridExtent/2.f);
+  for (int i=0;i<numFrames;i++) {
+    const float angle = 2.f*float(M_PI)*i/numFrames;
+    const vec3f from
+      = center + gridExtent*vec3f(cosf(angle),.4f,sinf(angle));
+    CameraPathFrame frame;
+    frame.time = i/60.;
+    frame.camera.setAspect(aspect);
+    frame.camera.setOrientation(from,center,vec3f(0.f,1.f,0.f),60.f);
+    path.frames.push_back(frame);
+  }
+  return path;
+}
+
+int main(int ac, char **av)
+{
+  std::string inFileName;
+  std::string outFileName;
+  std::string csvFile;
+  vec2i fbSize(1024,768);
+  int   gridSize  = 32;
+  int   numFrames = 120;
+  // each rep plays the whole path
+  Harness harness
+    ("b07-camera-path",ac,av,[&](int ac, char **av, int i) {
+      const std::string arg = av[i];
+      if (arg == "--fb-size" && i+2 < ac) {
+        fbSize = vec2i(std::atoi(av[i+1]),std::atoi(av[i+2]));
+        return 3;
+      }
+      if (i+1 >= ac)
+        return 0;
+      if (arg == "--camera-path")
+        inFileName = av[i+1];
+      else if (arg == "--write-path")
+        outFileName = av[i+1];
+      else if (arg == "--csv")
+        csvFile = av[i+1];
+      else if (arg == "--grid-size")
+        gridSize = std::atoi(av[i+1]);
+      else if (arg == "--num-frames")
+        numFrames = std::atoi(av[i+1]);
+      else
+        return 0;
+      return 2;
+    },/*warmup*/1,/*reps*/3);
+
+  // ##################################################################
+  // a grid of gridSize^3 instances of one cube
+  // ##################################################################
+  OWLContext owl = owlContextCreate(nullptr,1);
+  OWLModule module = owlModuleCreate(owl,ptxCode);
+
+  OWLVarDecl trianglesGeomVars[] = {
+    { "index",  OWL_BUFPTR, OWL_OFFSETOF(TrianglesGeomData,index) },
+    { "vertex", OWL_BUFPTR, OWL_OFFSETOF(TrianglesGeomData,vertex) },
+    { nullptr /* sentinel to mark end of list */ }
+  };
+  OWLGeomType trianglesGeomType
+    = owlGeomTypeCreate(owl,OWL_TRIANGLES,sizeof(TrianglesGeomData),
+                        trianglesGeomVars,-1);
+  owlGeomTypeSetClosestHit(trianglesGeomType,0,module,"TriangleMesh");
+
+  OWLBuffer vertexBuffer
+    = owlDeviceBufferCreate(owl,OWL_FLOAT3,vertices.size(),vertices.data());
+  OWLBuffer indexBuffer
+    = owlDeviceBufferCreate(owl,OWL_INT3,indices.size(),indices.data());
+  OWLGeom cube = owlGeomCreate(owl,trianglesGeomType);
+  owlTrianglesSetVertices(cube,vertexBuffer,vertices.size(),sizeof(vec3f),0);
+  owlTrianglesSetIndices(cube,indexBuffer,indices.size(),sizeof(vec3i),0);
+  owlGeomSetBuffer(cube,"vertex",vertexBuffer);
+  owlGeomSetBuffer(cube,"index",indexBuffer);
+  OWLGroup cubeGroup = owlTrianglesGeomGroupCreate(owl,1,&cube);
+  owlGroupBuildAccel(cubeGroup);
+
+  const int numInstances = gridSize*gridSize*gridSize;
+  OWLGroup world = owlInstanceGroupCreate(owl,numInstances);
+  for (int i=0;i<numInstances;i++) {
+    const vec3f pos(4.f*(i%gridSize),
+                    4.f*((i/gridSize)%gridSize),
+                    4.f*(i/(gridSize*gridSize)));
+    const affine3f xfm = affine3f::translate(pos);
+    owlInstanceGroupSetChild(world,i,cubeGroup);
+    owlInstanceGroupSetTransform(world,i,(const float *)&xfm,
+                                 OWL_MATRIX_FORMAT_OWL);
+  }
+  owlGroupBuildAccel(world);
+
+  owlMissProgCreate(owl,module,"miss",0,nullptr,-1);
+  OWLRayGen rayGen = owlRayGenCreate(owl,module,"rayGen",0,nullptr,-1);
+
+  OWLBuffer frameBuffer
+    = owlDeviceBufferCreate(owl,OWL_INT,fbSize.x*fbSize.y,nullptr);
+  OWLVarDecl launchParamsVars[] = {
+    { "fbPtr",         OWL_BUFPTR, OWL_OFFSETOF(LaunchParams,fbPtr) },
+    { "fbSize",        OWL_INT2,   OWL_OFFSETOF(LaunchParams,fbSize) },
+    { "world",         OWL_GROUP,  OWL_OFFSETOF(LaunchParams,world) },
+    { "camera.pos",    OWL_FLOAT3, OWL_OFFSETOF(LaunchParams,camera.pos) },
+    { "camera.dir_00", OWL_FLOAT3, OWL_OFFSETOF(LaunchParams,camera.dir_00) },
+    { "camera.dir_du", OWL_FLOAT3, OWL_OFFSETOF(LaunchParams,camera.dir_du) },
+    { "camera.dir_dv", OWL_FLOAT3, OWL_OFFSETOF(LaunchParams,camera.dir_dv) },
+    { /* sentinel to mark end of list */ }
+  };
+  OWLLaunchParams launchParams
+    = owlLaunchParamsCreate(owl,sizeof(LaunchParams),launchParamsVars,-1);
+  owlLaunchParamsSetBuffer(launchParams,"fbPtr",frameBuffer);
+  owlLaunchParamsSet2i(launchParams,"fbSize",fbSize.x,fbSize.y);
+  owlLaunchParamsSetGroup(launchParams,"world",world);
+
+  owlBuildPrograms(owl);
+  owlBuildPipeline(owl);
+  owlBuildSBT(owl);
+
+  // ##################################################################
+  // the path, and its playback
+  // ##################################################################
+  const CameraPath path
+    = inFileName.empty()
+    ? orbitPath(numFrames,4.f*gridSize,fbSize.x/float(fbSize.y))
+    : CameraPath::load(inFileName);
+  if (!outFileName.empty())
+    path.save(outFileName);
+
+  PlaybackWidget widget(fbSize,rayGen,launchParams);
+  CameraPathStats stats;
+  harness.run("camera path playback (per frame)",path.frames.size(),[&](){
+      stats = widget.playCameraPath(path);
+    });
+
+  const int result = harness.finish();
+  std::ostream &summary = (harness.jsonFile == "-") ? std::cerr : std::cout;
+  summary << "#owl.bench(b07-camera-path): " << path.frames.size()
+          << " frames of " << fbSize.x << "x" << fbSize.y << " from "
+          << (inFileName.empty() ? std::string("an orbit") : inFileName)
+          << ", " << numInstances << " instances" << std::endl;
+  stats.writeSummary(summary);
+  if (!csvFile.empty()) {
+    std::ofstream csv(csvFile);
+    stats.writeCSV(csv);
+    if (!csv) {
+      std::cerr << "#owl.bench(b07-camera-path): could not write '"
+                << csvFile << "'" << std::endl;
+      return 1;
+    }
+  }
+
+  owlContextDestroy(owl);
+  return result;
+}
@@ -0,0 +1,271 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+/*! \file bench/common/BenchHarness.h A small, header-only harness
+    for host-side microbenchmarks: runs each case a number of warmup
+    and measured repetitions, reports min/median/mean/percentiles of
+    the time per operation, and writes the results as JSON, so runs
+    of different releases can be compared by a script. */
+
+#pragma once
+
+#include <owl/common/owl-common.h>
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace owl {
+  namespace bench {
+
+    /*! statistics over the measured reps of one case, in nanoseconds
+        per operation */
+    struct Stats {
+      double min, median, mean, p90, p99, max;
+    };
+
+    /*! 'p'th percentile (p in [0,1]) of the given (sorted) values,
+        interpolating between the two closest ranks */
+    inline double percentile(const std::vector<double> &sorted, double p)
+    {
+      if (sorted.empty()) return 0.;
+      const double pos = p*(sorted.size()-1);
+      const size_t lo  = (size_t)pos;
+      const size_t hi  = std::min(lo+1,sorted.size()-1);
+      return sorted[lo] + (pos-lo)*(sorted[hi]-sorted[lo]);
+    }
+
+    inline Stats computeStats(std::vector<double> values)
+    {
+      Stats stats = { 0., 0., 0., 0., 0., 0. };
+      if (values.empty()) return stats;
+      std::sort(values.begin(),values.end());
+      double sum = 0.;
+      for (auto v : values) sum += v;
+      stats.min    = values.front();
+      stats.max    = values.back();
+      stats.mean   = sum / values.size();
+      stats.median = percentile(values,.5);
+      stats.p90    = percentile(values,.9);
+      stats.p99    = percentile(values,.99);
+      return stats;
+    }
+
+    struct Harness {
+      /*! parses the harness' own command line arguments:
+
+          --warmup <n>    unmeasured reps before measuring (default
+                          'defaultWarmup')
+          --reps <n>      measured reps per case (default 'defaultReps')
+          --filter <s>    only run cases whose name contains 's'
+          --json <file>   write results to 'file' ('-' for stdout)
+
+          Any other argument throws, unless 'extraArg' (which gets
+          the argument list and the current position, and returns
+          the number of arguments it consumed) takes care of it */
+      template<typename ExtraArgs>
+      Harness(const std::string &suite, int ac, char **av,
+              const ExtraArgs &extraArg,
+              int defaultWarmup = 3,
+              int defaultReps   = 21)
+        : numWarmup(defaultWarmup),
+          numReps(defaultReps),
+          suite(suite)
+      {
+        for (int i=1;i<ac;i++) {
+          const std::string arg = av[i];
+          if (arg == "--warmup" && i+1 < ac)
+            numWarmup = std::atoi(av[++i]);
+          else if (arg == "--reps" && i+1 < ac)
+            numReps = std::atoi(av[++i]);
+          else if (arg == "--filter" && i+1 < ac)
+            filter = av[++i];
+          else if (arg == "--json" && i+1 < ac)
+            jsonFile = av[++i];
+          else {
+            const int consumed = extraArg(ac,av,i);
+            if (consumed <= 0)
+              throw std::runtime_error("unknown cmdline argument '"+arg+"'");
+            i += consumed-1;
+          }
+        }
+        if (numReps < 1)
+          throw std::runtime_error("need at least one rep");
+      }
+
+      Harness(const std::string &suite, int ac, char **av)
+        : Harness(suite,ac,av,[](int,char **,int){ return 0; })
+      {}
+
+      /*! whether the case of the given name passes the filter */
+      bool selected(const std::string &name) const
+      { return name.find(filter) != std::string::npos; }
+      
+      /*! runs 'body' - which has to do 'opsPerRep' operations of
+          what's being measured - numWarmup+numReps times, and records
+          the time of each measured rep */
+      template<typename Lambda>
+      void run(const std::string &name, size_t opsPerRep, const Lambda &body)
+      {
+        if (!selected(name)) return;
+        for (int i=0;i<numWarmup;i++)
+          body();
+        Result result;
+        result.name      = name;
+        result.opsPerRep = opsPerRep;
+        for (int i=0;i<numReps;i++) {
+          const auto t0 = std::chrono::steady_clock::now();
+          body();
+          const auto t1 = std::chrono::steady_clock::now();
+          result.repSeconds.push_back
+            (std::chrono::duration<double>(t1-t0).count());
+        }
+        std::vector<double> nsPerOp;
+        for (auto t : result.repSeconds)
+          nsPerOp.push_back(t*1e9/std::max(opsPerRep,size_t(1)));
+        result.stats = computeStats(nsPerOp);
+        results.push_back(result);
+      }
+
+      /*! records that a case could not be run, and why */
+      void skip(const std::string &name, const std::string &reason)
+      {
+        if (selected(name))
+          skipped.push_back({name,reason});
+      }
+
+      /*! prints a table of all results, and writes the JSON file (if
+          requested); returns main()'s exit code */
+      int finish() const
+      {
+        std::ostream &table = (jsonFile == "-") ? std::cerr : std::cout;
+        table << OWL_TERMINAL_BLUE << "#owl.bench(" << suite << "): "
+              << results.size() << " cases, " << numWarmup << " warmup + "
+              << numReps << " reps each" << OWL_TERMINAL_DEFAULT << std::endl;
+        table << std::setw(44) << std::left << "# case (ns/op)"
+              << std::right
+              << std::setw(12) << "min"
+              << std::setw(12) << "median"
+              << std::setw(12) << "p90"
+              << std::setw(12) << "p99" << std::endl;
+        for (auto &r : results)
+          table << std::setw(44) << std::left << r.name
+                << std::right << std::fixed << std::setprecision(3)
+                << std::setw(12) << r.stats.min
+                << std::setw(12) << r.stats.median
+                << std::setw(12) << r.stats.p90
+                << std::setw(12) << r.stats.p99 << std::endl;
+        for (auto &s : skipped)
+          table << std::setw(44) << std::left << s.name
+                << "skipped: " << s.reason << std::endl;
+
+        if (jsonFile.empty())
+          return 0;
+        if (jsonFile == "-") {
+          writeJSON(std::cout);
+          return 0;
+        }
+        std::ofstream out(jsonFile);
+        writeJSON(out);
+        if (!out) {
+          std::cerr << "#owl.bench(" << suite << "): could not write '"
+                    << jsonFile << "'" << std::endl;
+          return 1;
+        }
+        return 0;
+      }
+
+      int         numWarmup;
+      int         numReps;
+      std::string filter;
+      std::string jsonFile;
+      
+    private:
+      struct Result {
+        std::string         name;
+        size_t              opsPerRep;
+        std::vector<double> repSeconds;
+        Stats               stats;
+      };
+      struct Skipped {
+        std::string name;
+        std::string reason;
+      };
+
+      static void writeString(std::ostream &out, const std::string &s)
+      {
+        out << '"';
+        for (char c : s) {
+          if (c == '"' || c == '\\') out << '\\';
+          if ((unsigned char)c >= 0x20) out << c;
+        }
+        out << '"';
+      }
+      
+      void writeJSON(std::ostream &out) const
+      {
+        out << std::setprecision(9) << std::defaultfloat;
+        out << "{\n  \"suite\": ";
+        writeString(out,suite);
+        out << ",\n  \"warmup\": " << numWarmup
+            << ",\n  \"reps\": " << numReps
+#ifdef NDEBUG
+            << ",\n  \"build\": \"release\""
+#else
+            << ",\n  \"build\": \"debug\""
+#endif
+            << ",\n  \"results\": [";
+        for (size_t i=0;i<results.size();i++) {
+          const Result &r = results[i];
+          out << (i ? ",\n" : "\n") << "    { \"name\": ";
+          writeString(out,r.name);
+          out << ", \"ops_per_rep\": " << r.opsPerRep
+              << ",\n      \"ns_per_op\": { \"min\": " << r.stats.min
+              << ", \"median\": " << r.stats.median
+              << ", \"mean\": "   << r.stats.mean
+              << ", \"p90\": "    << r.stats.p90
+              << ", \"p99\": "    << r.stats.p99
+              << ", \"max\": "    << r.stats.max << " }"
+              << ",\n      \"rep_seconds\": [";
+          for (size_t j=0;j<r.repSeconds.size();j++)
+            out << (j ? ", " : "") << r.repSeconds[j];
+          out << "] }";
+        }
+        out << "\n  ],\n  \"skipped\": [";
+        for (size_t i=0;i<skipped.size();i++) {
+          out << (i ? ",\n" : "\n") << "    { \"name\": ";
+          writeString(out,skipped[i].name);
+          out << ", \"reason\": ";
+          writeString(out,skipped[i].reason);
+          out << " }";
+        }
+        out << "\n  ]\n}\n";
+      }
+      
+      const std::string    suite;
+      std::vector<Result>  results;
+      std::vector<Skipped> skipped;
+    };
+    
+  } // ::owl::bench
+} // ::owl
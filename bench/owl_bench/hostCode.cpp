@@ -0,0 +1,270 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// owl_bench: the host-side microbenchmark suite. Measures the CPU
+// cost of the node graph's and ll layer's hot paths that do not need
+// a GPU - variable lookup and set, SBT variable writing, object
+// registries, SBT range allocation, instance transform packing, and
+// the owl::common math functors - using the harness in
+// bench/common/BenchHarness.h. Run with '--json <file>' to get
+// machine-readable results for tracking regressions.
+
+#include "bench/common/BenchHarness.h"
+#include "owl/ng/cpp/SBTObject.h"
+#include "owl/ng/cpp/ObjectRegistry.h"
+#include "owl/ng/api/APIContext.h"
+#include "owl/ng/api/APIHandle.h"
+#include "owl/ll/Device.h"
+#include "owl/ll/InstanceTransforms.h"
+#include "owl/common/math/AffineSpace.h"
+#include "owl/common/math/box.h"
+// std
+#include <random>
+#include <vector>
+
+using namespace owl;
+using namespace owl::common;
+
+/*! registry that doesn't need a context (and thus, no device) */
+struct BenchRegistry : public ObjectRegistry {
+  void reallocContextIDs(int newMaxIDs) override {}
+};
+
+struct BenchObject : public RegisteredObject {
+  BenchObject(ObjectRegistry &registry)
+    : RegisteredObject(nullptr,registry)
+  {}
+};
+
+/*! variables of a typical geometry, in the order an app would
+    declare them */
+struct BenchVars {
+  vec3f    color;
+  float    radius;
+  int32_t  materialID;
+  vec4f    params;
+  vec2i    range;
+  uint64_t flags;
+  vec3f    emission;
+  float    roughness;
+  vec3ui   dims;
+  int64_t  firstPrim;
+  vec2f    uvScale;
+  uint32_t numPrims;
+};
+
+std::vector<OWLVarDecl> benchVarDecls =
+  {
+    { "color",      OWL_FLOAT3, OWL_OFFSETOF(BenchVars,color)      },
+    { "radius",     OWL_FLOAT,  OWL_OFFSETOF(BenchVars,radius)     },
+    { "materialID", OWL_INT,    OWL_OFFSETOF(BenchVars,materialID) },
+    { "params",     OWL_FLOAT4, OWL_OFFSETOF(BenchVars,params)     },
+    { "range",      OWL_INT2,   OWL_OFFSETOF(BenchVars,range)      },
+    { "flags",      OWL_ULONG,  OWL_OFFSETOF(BenchVars,flags)      },
+    { "emission",   OWL_FLOAT3, OWL_OFFSETOF(BenchVars,emission)   },
+    { "roughness",  OWL_FLOAT,  OWL_OFFSETOF(BenchVars,roughness)  },
+    { "dims",       OWL_UINT3,  OWL_OFFSETOF(BenchVars,dims)       },
+    { "firstPrim",  OWL_LONG,   OWL_OFFSETOF(BenchVars,firstPrim)  },
+    { "uvScale",    OWL_FLOAT2, OWL_OFFSETOF(BenchVars,uvScale)    },
+    { "numPrims",   OWL_UINT,   OWL_OFFSETOF(BenchVars,numPrims)   },
+  };
+
+/*! to make sure the compiler can't optimize the work away */
+volatile float sink = 0.f;
+
+int main(int ac, char **av)
+{
+  size_t numItems    = 1000000;
+  bool   withContext = false;
+  bench::Harness harness
+    ("owl_bench",ac,av,[&](int ac, char **av, int i) {
+      const std::string arg = av[i];
+      if (arg == "--num-items" && i+1 < ac) {
+        numItems = std::atol(av[i+1]);
+        return 2;
+      }
+      if (arg == "--with-context") {
+        withContext = true;
+        return 1;
+      }
+      return 0;
+    });
+
+  // ##################################################################
+  // variables
+  // ##################################################################
+  {
+    BenchRegistry typeRegistry, objectRegistry;
+    SBTObjectType::SP type
+      = makeRef<SBTObjectType>(nullptr,typeRegistry,
+                               sizeof(BenchVars),benchVarDecls);
+    Ref<SBTObjectBase> object
+      = makeRef<SBTObjectBase>(nullptr,objectRegistry,type);
+
+    // what the set-by-name API calls do: look up the variable by
+    // name, then set it through its (virtual) typed setter
+    const size_t numSets = numItems;
+    harness.run("variable set by name (first declared)",numSets,[&](){
+        for (size_t i=0;i<numSets;i++)
+          object->getVariable("color")->set(vec3f((float)i));
+      });
+    harness.run("variable set by name (last declared)",numSets,[&](){
+        for (size_t i=0;i<numSets;i++)
+          object->getVariable("numPrims")->set((uint32_t)i);
+      });
+    harness.run("variable set (already looked up)",numSets,[&](){
+        Variable *var = object->variables[0].get();
+        for (size_t i=0;i<numSets;i++)
+          var->set(vec3f((float)i));
+      });
+
+    // one SBT record worth of variables per 'op'
+    const size_t numRecords = numItems/10;
+    std::vector<uint8_t> record(sizeof(BenchVars));
+    harness.run("SBTObjectBase::writeVariables",numRecords,[&](){
+        for (size_t i=0;i<numRecords;i++)
+          object->writeVariables(record.data(),0);
+        sink = sink + record[0];
+      });
+  }
+
+  // ##################################################################
+  // object registries: creating objects allocates (or re-uses) an
+  // ID and tracks the object; destroying it forgets it again
+  // ##################################################################
+  {
+    BenchRegistry registry;
+    const size_t numObjects = numItems/10;
+    std::vector<Ref<BenchObject>> objects(numObjects);
+    harness.run("ObjectRegistry alloc+free",numObjects,[&](){
+        for (auto &obj : objects)
+          obj = makeRef<BenchObject>(registry);
+        for (auto &obj : objects)
+          obj = nullptr;
+      });
+  }
+
+  // ##################################################################
+  // API handles - these need a real context, and thus a device
+  // ##################################################################
+  if (!withContext)
+    harness.skip("APIContext handle create+release",
+                 "needs a device; run with --with-context");
+  else {
+    OWLContext owl = owlContextCreate(nullptr,0);
+    APIContext::SP context = ((APIHandle *)owl)->getContext();
+    const size_t numHandles = numItems/10;
+    std::vector<APIHandle *> handles(numHandles);
+    Object::SP object = makeRef<Object>();
+    harness.run("APIContext handle create+release",numHandles,[&](){
+        for (auto &handle : handles)
+          handle = context->createHandle(object);
+        for (auto &handle : handles)
+          delete handle;
+      });
+    context = nullptr;
+    owlContextDestroy(owl);
+  }
+
+  // ##################################################################
+  // SBT hit group range allocation, with the fragmentation of geoms
+  // of different sizes coming and going
+  // ##################################################################
+  {
+    const size_t numRanges = 1000;
+    std::mt19937 rng(0x4242);
+    std::vector<size_t> sizes(numRanges);
+    for (auto &s : sizes) s = 1+rng()%8;
+    std::vector<int> begins(numRanges);
+    harness.run("RangeAllocator alloc+release",4*numRanges,[&](){
+        ll::RangeAllocator allocator;
+        for (size_t i=0;i<numRanges;i++)
+          begins[i] = allocator.alloc(sizes[i]);
+        for (size_t i=0;i<numRanges;i+=2)
+          allocator.release(begins[i],sizes[i]);
+        for (size_t i=0;i<numRanges;i+=2)
+          begins[i] = allocator.alloc(sizes[i]);
+        for (size_t i=0;i<numRanges;i++)
+          allocator.release(begins[i],sizes[i]);
+      });
+  }
+
+  // ##################################################################
+  // instance transform packing (affine3f -> optix' row-major 3x4)
+  // ##################################################################
+  std::mt19937 rng(0x1234);
+  std::uniform_real_distribution<float> uniform(-1.f,1.f);
+  std::vector<affine3f> xfms(numItems);
+  for (auto &xfm : xfms)
+    xfm
+      = affine3f::translate(vec3f(uniform(rng),uniform(rng),uniform(rng)))
+      * affine3f::rotate(normalize(vec3f(uniform(rng),uniform(rng),1.f)),
+                         uniform(rng));
+  {
+    std::vector<OptixInstance> instances(numItems);
+    harness.run("instance transform packing",numItems,[&](){
+        for (size_t i=0;i<numItems;i++)
+          ll::setOptixInstanceTransform(instances[i],xfms[i]);
+        sink = sink + instances[numItems/2].transform[3];
+      });
+  }
+
+  // ##################################################################
+  // owl::common math
+  // ##################################################################
+  {
+    std::vector<vec3f> points(numItems);
+    for (auto &p : points) p = vec3f(uniform(rng),uniform(rng),uniform(rng));
+    std::vector<vec3f> result(numItems);
+
+    harness.run("math: xfmPoint",numItems,[&](){
+        for (size_t i=0;i<numItems;i++)
+          result[i] = xfmPoint(xfms[i],points[i]);
+        sink = sink + result[numItems/2].x;
+      });
+    harness.run("math: xfmNormal",numItems,[&](){
+        for (size_t i=0;i<numItems;i++)
+          result[i] = xfmNormal(xfms[i],points[i]);
+        sink = sink + result[numItems/2].x;
+      });
+    harness.run("math: normalize(cross)",numItems,[&](){
+        for (size_t i=0;i<numItems;i++)
+          result[i] = normalize(cross(points[i],points[numItems-1-i]));
+        sink = sink + result[numItems/2].x;
+      });
+    harness.run("math: affine3f compose",numItems,[&](){
+        affine3f sum(owl::common::one);
+        for (size_t i=0;i<numItems;i++)
+          sum = sum * xfms[i];
+        sink = sink + sum.p.x;
+      });
+    harness.run("math: affine3f inverse",numItems,[&](){
+        float sum = 0.f;
+        for (size_t i=0;i<numItems;i++)
+          sum += rcp(xfms[i]).p.x;
+        sink = sink + sum;
+      });
+    harness.run("math: box3f extend",numItems,[&](){
+        box3f bounds;
+        for (size_t i=0;i<numItems;i++)
+          bounds.extend(points[i]);
+        sink = sink + bounds.lower.x;
+      });
+  }
+  
+  return harness.finish();
+}
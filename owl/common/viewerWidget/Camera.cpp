@@ -141,6 +141,14 @@ namespace owl {
         fc.motionSpeed /= 2.f;
         std::cout << "# viewer: new motion speed is " << fc.motionSpeed << std::endl;
         break;
+      case 'R':
+        if (widget->isRecordingCameraPath())
+          widget->stopCameraPathRecording(widget->cameraPathFileName);
+        else {
+          std::cout << "# viewer: (R)ecording camera path" << std::endl;
+          widget->startCameraPathRecording();
+        }
+        break;
       case 'C':
         std::cout << "(C)urrent camera:" << std::endl;
         std::cout << "- from :" << fc.position << std::endl;
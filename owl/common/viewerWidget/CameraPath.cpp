@@ -0,0 +1,151 @@
+// ======================================================================== //
+// Copyright 2018-2019 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "CameraPath.h"
+// std
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace owl {
+  namespace viewer {
+
+    /*! first line of every camera path file */
+    static const char *cameraPathHeader = "owl-camera-path 1";
+
+    static void writeVec3f(std::ostream &out, const vec3f &v)
+    {
+      out << " " << v.x << " " << v.y << " " << v.z;
+    }
+
+    static bool readVec3f(std::istream &in, vec3f &v)
+    {
+      return (bool)(in >> v.x >> v.y >> v.z);
+    }
+
+    void CameraPath::save(const std::string &fileName) const
+    {
+      std::ofstream out(fileName);
+      if (!out)
+        throw std::runtime_error("could not open '"+fileName
+                                 +"' for writing the camera path");
+      out << cameraPathHeader << std::endl
+          << "# time position frame.vx frame.vy frame.vz poiDistance "
+          << "focalDistance upVector forceUp motionSpeed aspect fovy"
+          << std::endl;
+      // 9 digits give back the exact same float, and 17 the exact
+      // same double
+      for (auto &frame : frames) {
+        const FullCamera &fc = frame.camera;
+        out << std::setprecision(17) << frame.time << std::setprecision(9);
+        writeVec3f(out,fc.position);
+        writeVec3f(out,fc.frame.vx);
+        writeVec3f(out,fc.frame.vy);
+        writeVec3f(out,fc.frame.vz);
+        out << " " << fc.poiDistance << " " << fc.focalDistance;
+        writeVec3f(out,fc.upVector);
+        out << " " << int(fc.forceUp)
+            << " " << fc.motionSpeed
+            << " " << fc.aspect
+            << " " << fc.fovyInDegrees << std::endl;
+      }
+      if (!out)
+        throw std::runtime_error("could not write camera path to '"
+                                 +fileName+"'");
+    }
+
+    CameraPath CameraPath::load(const std::string &fileName)
+    {
+      std::ifstream in(fileName);
+      if (!in)
+        throw std::runtime_error("could not open camera path '"+fileName+"'");
+      std::string line;
+      if (!std::getline(in,line) || line != cameraPathHeader)
+        throw std::runtime_error("'"+fileName+"' is not a camera path");
+
+      CameraPath path;
+      for (int lineNo=2;std::getline(in,line);lineNo++) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        CameraPathFrame frame;
+        FullCamera &fc = frame.camera;
+        int forceUp = 0;
+        std::string rest;
+        if (!(fields >> frame.time) ||
+            !readVec3f(fields,fc.position) ||
+            !readVec3f(fields,fc.frame.vx) ||
+            !readVec3f(fields,fc.frame.vy) ||
+            !readVec3f(fields,fc.frame.vz) ||
+            !(fields >> fc.poiDistance >> fc.focalDistance) ||
+            !readVec3f(fields,fc.upVector) ||
+            !(fields >> forceUp >> fc.motionSpeed >> fc.aspect >> fc.fovyInDegrees) ||
+            (fields >> rest))
+          throw std::runtime_error("malformed camera path frame in '"+fileName
+                                   +"', line "+std::to_string(lineNo));
+        fc.forceUp = (forceUp != 0);
+        path.frames.push_back(frame);
+      }
+      return path;
+    }
+
+    void CameraPathStats::writeCSV(std::ostream &out) const
+    {
+      out << "frame,path_time,update_ms,render_ms" << std::endl;
+      for (size_t i=0;i<frames.size();i++)
+        out << i << ","
+            << frames[i].pathTime << ","
+            << 1000.*frames[i].updateTime << ","
+            << 1000.*frames[i].renderTime << std::endl;
+    }
+
+    /*! writes min/median/mean/max of the given times, in ms */
+    static void writeTimes(std::ostream &out, const char *what,
+                           std::vector<double> times)
+    {
+      std::sort(times.begin(),times.end());
+      double sum = 0.;
+      for (auto t : times) sum += t;
+      out << "# viewer: " << what
+          << " min " << 1000.*times.front()
+          << " median " << 1000.*times[times.size()/2]
+          << " mean " << 1000.*sum/times.size()
+          << " max " << 1000.*times.back() << " (ms)" << std::endl;
+    }
+
+    void CameraPathStats::writeSummary(std::ostream &out) const
+    {
+      if (frames.empty()) {
+        out << "# viewer: camera path playback: no frames" << std::endl;
+        return;
+      }
+      std::vector<double> update, render;
+      double total = 0.;
+      for (auto &frame : frames) {
+        update.push_back(frame.updateTime);
+        render.push_back(frame.renderTime);
+        total += frame.updateTime+frame.renderTime;
+      }
+      out << "# viewer: camera path playback of " << frames.size()
+          << " frames, " << (total > 0. ? frames.size()/total : 0.)
+          << " fps" << std::endl;
+      writeTimes(out,"update",update);
+      writeTimes(out,"render",render);
+    }
+
+  } // ::owl::viewer
+} // ::owl
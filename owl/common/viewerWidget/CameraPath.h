@@ -0,0 +1,71 @@
+// ======================================================================== //
+// Copyright 2018-2019 Ingo Wald                                            //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "Camera.h"
+// std
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace owl {
+  namespace viewer {
+
+    /*! one recorded camera state */
+    struct OWL_VIEWER_INTERFACE CameraPathFrame {
+      /*! seconds since recording started */
+      double     time { 0. };
+      FullCamera camera;
+    };
+
+    /*! a sequence of camera states with timestamps, as recorded from
+        a ViewerWidget's camera (see
+        ViewerWidget::startCameraPathRecording()), and as played back
+        by ViewerWidget::playCameraPath(). Paths get stored as text,
+        one frame per line, with enough digits that loading gives
+        back the exact same cameras */
+    struct OWL_VIEWER_INTERFACE CameraPath {
+      /*! write to/read from the given file; throw on failure */
+      void save(const std::string &fileName) const;
+      static CameraPath load(const std::string &fileName);
+
+      std::vector<CameraPathFrame> frames;
+    };
+
+    /*! times of one frame of a camera path playback, in seconds */
+    struct OWL_VIEWER_INTERFACE CameraPathFrameTimes {
+      /*! the frame's timestamp in the path */
+      double pathTime   { 0. };
+      /*! updateCamera(), including the app's cameraChanged() */
+      double updateTime { 0. };
+      /*! the app's render() */
+      double renderTime { 0. };
+    };
+
+    /*! results of a camera path playback */
+    struct OWL_VIEWER_INTERFACE CameraPathStats {
+      /*! one line per frame, as 'frame,path_time,update_ms,render_ms' */
+      void writeCSV(std::ostream &out) const;
+      /*! min, median, mean and max of update and render times, and
+          the frame rate they add up to */
+      void writeSummary(std::ostream &out) const;
+
+      std::vector<CameraPathFrameTimes> frames;
+    };
+
+  } // ::owl::viewer
+} // ::owl
@@ -23,6 +23,9 @@
 #include "Camera.h"
 #include "InspectMode.h"
 #include "FlyMode.h"
+// std
+#include <algorithm>
+#include <iostream>
 
 namespace owl {
   namespace viewer {
@@ -36,6 +39,12 @@ namespace owl {
     {
     }
 
+    ViewerWidget::ViewerWidget(const vec2i &frameSize)
+      : windowSize(frameSize)
+    {
+      fullCamera.setAspect(frameSize.x/float(frameSize.y));
+    }
+
     /*! re-draw the current frame. This function itself isn't
       virtual, but it calls the framebuffer's render(), which
       is */
@@ -48,10 +57,67 @@ namespace owl {
     void ViewerWidget::updateCamera()
     {
       fullCamera.digestInto(simpleCamera);
+      if (recordingCameraPath) {
+        CameraPathFrame frame;
+        frame.time   = getCurrentTime()-cameraPathRecordingStart;
+        frame.camera = fullCamera;
+        cameraPathRecording.frames.push_back(frame);
+      }
       // if (isActive)
       cameraChanged();
     }
 
+    void ViewerWidget::startCameraPathRecording()
+    {
+      cameraPathRecording.frames.clear();
+      cameraPathRecordingStart = getCurrentTime();
+      recordingCameraPath = true;
+      // the current camera is where the path starts
+      updateCamera();
+    }
+
+    void ViewerWidget::stopCameraPathRecording(const std::string &fileName)
+    {
+      recordingCameraPath = false;
+      cameraPathRecording.save(fileName);
+      std::cout << "# viewer: wrote camera path of "
+                << cameraPathRecording.frames.size() << " frames to "
+                << fileName << std::endl;
+      cameraPathRecording.frames.clear();
+    }
+
+    CameraPathStats ViewerWidget::playCameraPath(const CameraPath &path,
+                                                 int numWarmupFrames)
+    {
+      // don't record what we play back
+      const bool wasRecording = recordingCameraPath;
+      recordingCameraPath = false;
+
+      for (int i=0;i<std::min(numWarmupFrames,(int)path.frames.size());i++) {
+        fullCamera = path.frames[i].camera;
+        updateCamera();
+        render();
+      }
+
+      CameraPathStats stats;
+      for (auto &frame : path.frames) {
+        CameraPathFrameTimes times;
+        times.pathTime = frame.time;
+        const double t0 = getCurrentTime();
+        fullCamera = frame.camera;
+        updateCamera();
+        const double t1 = getCurrentTime();
+        render();
+        const double t2 = getCurrentTime();
+        times.updateTime = t1-t0;
+        times.renderTime = t2-t1;
+        stats.frames.push_back(times);
+      }
+
+      recordingCameraPath = wasRecording;
+      return stats;
+    }
+
     void ViewerWidget::enableInspectMode(RotateMode rm,
                                          const box3f &validPoiRange,
                                          float minPoiDist,
@@ -18,6 +18,7 @@
 
 #include "GlutWindow.h"
 #include "Camera.h"
+#include "CameraPath.h"
 
 namespace owl {
   namespace viewer {
@@ -30,10 +31,19 @@ namespace owl {
 
       ViewerWidget(GlutWindow::SP window);
 
+      /*! creates a widget without a window (and without needing glut
+        or a display), for rendering frames of the given size
+        off-screen - eg, for playing back camera paths on headless
+        benchmark machines */
+      ViewerWidget(const vec2i &frameSize);
+
+      /*! whether this widget has no window to display to */
+      bool isHeadless() const { return !window; }
+
 
       /*! window notifies us that we got resized */
       virtual void resize(const vec2i &newSize) {
-        window->resize(newSize);
+        if (window) window->resize(newSize);
         windowSize = newSize;
       }
       /*! gets called whenever the viewer needs us to re-render out widget */
@@ -167,6 +177,28 @@ namespace owl {
           app that the camera got changed */
       void updateCamera();
 
+      /*! starts recording every camera change, with a timestamp; the
+          'R' key starts and stops recording to cameraPathFileName */
+      void startCameraPathRecording();
+      /*! stops recording, and writes the recorded path to the given
+          file */
+      void stopCameraPathRecording(const std::string &fileName);
+      bool isRecordingCameraPath() const { return recordingCameraPath; }
+
+      /*! plays back the given camera path, one frame per recorded
+          camera: for each, sets the camera and calls updateCamera()
+          (and thus the app's cameraChanged()), then render(), and
+          times both. Nothing here touches the window, so this also
+          works on headless widgets; for meaningful render times,
+          render() has to have finished its frame when it
+          returns. The first 'numWarmupFrames' frames get rendered
+          once more up front, without being timed */
+      CameraPathStats playCameraPath(const CameraPath &path,
+                                     int numWarmupFrames = 0);
+
+      /*! file the 'R' key records camera paths to */
+      std::string cameraPathFileName { "owl-camera-path.txt" };
+
     private:
       friend struct GlutWindow;
       friend struct FullCameraManip;
@@ -188,6 +220,11 @@ namespace owl {
 
       /*! gets set to true when the window first gets shown */
       bool isActive { false };
+
+      /*! the camera path being recorded, if any */
+      CameraPath cameraPathRecording;
+      double     cameraPathRecordingStart { 0. };
+      bool       recordingCameraPath { false };
     };
 
   } // ::owl::viewer
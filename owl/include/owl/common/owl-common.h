@@ -108,6 +108,14 @@
 #define MAYBE_UNUSED
 #endif
 
+#ifdef __GNUC__
+# define OWL_LIKELY(cond)   __builtin_expect(!!(cond),1)
+# define OWL_UNLIKELY(cond) __builtin_expect(!!(cond),0)
+#else
+# define OWL_LIKELY(cond)   (cond)
+# define OWL_UNLIKELY(cond) (cond)
+#endif
+
 
 
 
@@ -207,6 +207,177 @@ extern "C" {
   LLOResult lloSetMaxInstancingDepth(LLOContext llo,
                                      int32_t maxInstanceDepth);
   
+  /*! enables or disables OWL's validation checks (valid IDs,
+    dangling references, instancing depth, ...). This is a
+    process-wide setting; the default is 'on' for debug builds and
+    'off' for release builds, and can also be set through the
+    OWL_VALIDATION environment variable */
+  OWL_LL_INTERFACE
+  LLOResult lloSetValidation(int32_t enabled);
+
+  /*! enables or disables tracing of OWL's API calls and internal
+    phases (see owl/ll/Tracing.h). This is a process-wide setting; if
+    'fileName' is non-null, the trace gets written to that file (in
+    Chrome trace_event format) at exit. Tracing can also be enabled
+    through the OWL_TRACE environment variable, which names that
+    file */
+  OWL_LL_INTERFACE
+  LLOResult lloSetTracing(int32_t enabled, const char *fileName);
+
+  /*! writes all trace events recorded so far to the given file */
+  OWL_LL_INTERFACE
+  LLOResult lloDumpTrace(const char *fileName);
+
+  /*! sink for OWL's log messages (see lloSetLogCallback); 'level'
+    is one of 1 (error), 2 (warning), 3 (info), or 4 (debug) */
+  typedef void
+  (*LLOLogCB)(int32_t level,
+              const char *message,
+              void *userData);
+
+  /*! sets the highest level of messages that get logged: 0 (none), 1
+    (error), 2 (warning), 3 (info), or 4 (debug). This is a
+    process-wide setting; the default is 'info' for debug builds and
+    'error' for release builds, and can also be set through the
+    OWL_LOG_LEVEL environment variable */
+  OWL_LL_INTERFACE
+  LLOResult lloSetLogLevel(int32_t level);
+
+  /*! sends all log messages to the given callback instead of stdout;
+    a null callback restores the default. Once this returns, the
+    previous callback will no longer get called */
+  OWL_LL_INTERFACE
+  LLOResult lloSetLogCallback(LLOLogCB callback, void *userData);
+
+  /*! the parts of OWL whose host allocations get counted separately
+    (see lloGetHostAllocStats) */
+  typedef enum {
+    /*! API handles, and the bookkeeping for them */
+    LLO_HOST_ALLOC_HANDLES = 0,
+    /*! variables of SBT objects and launch params */
+    LLO_HOST_ALLOC_VARIABLES,
+    /*! host copies of launch params */
+    LLO_HOST_ALLOC_LAUNCH,
+    /*! scratch arrays of accel builds */
+    LLO_HOST_ALLOC_ACCEL,
+    LLO_HOST_ALLOC_NUM_SITES
+  } LLOHostAllocSite;
+
+  typedef void *
+  (*LLOHostAllocFn)(size_t numBytes, void *userData);
+  typedef void
+  (*LLOHostFreeFn)(void *ptr, size_t numBytes, void *userData);
+
+  /*! counts of one LLOHostAllocSite since program start */
+  typedef struct _LLOHostAllocStats {
+    uint64_t numAllocs;
+    uint64_t numFrees;
+    uint64_t bytesAllocated;
+    uint64_t bytesFreed;
+  } LLOHostAllocStats;
+
+  /*! makes OWL's counted host allocations (see LLOHostAllocSite) go
+    through the given functions; passing null for both restores
+    malloc/free. This is a process-wide setting, and fails while OWL
+    still holds memory from the previous functions - ie, it has to
+    be called while no context exists */
+  OWL_LL_INTERFACE
+  LLOResult lloSetHostAllocator(LLOHostAllocFn allocFn,
+                                LLOHostFreeFn  freeFn,
+                                void *userData);
+
+  /*! returns the allocation counts of the given site */
+  OWL_LL_INTERFACE
+  LLOResult lloGetHostAllocStats(int32_t site,
+                                 LLOHostAllocStats *stats);
+
+  /*! enables or disables hardware performance counters around OWL's
+    internal phases (see owl/ll/PerfCounters.h), and returns in
+    'active' whether they are active afterwards. This is a
+    process-wide setting; it can also be enabled through the
+    OWL_PERF_COUNTERS environment variable. Counters that are not
+    available - OWL built without them, not on linux, or the kernel
+    not letting us open them - are not an error; 'active' is then
+    just 0 */
+  OWL_LL_INTERFACE
+  LLOResult lloSetPerfCounters(int32_t enabled, int32_t *active);
+  
+  /*! enables or disables 'frame pipelining': when enabled, all SBT
+    builds (lloSbtHitProgsBuild, lloSbtRayGensBuild,
+    lloSbtMissProgsBuild) write into a second copy of the respective
+    SBT records, while launches that are still in flight keep using
+    the first copy; the next launch then swaps in the newer copy. This
+    allows for building the SBT of frame N+1 while frame N is still
+    rendering, without having to synchronize first. */
+  OWL_LL_INTERFACE
+  LLOResult lloSetFramePipelining(LLOContext llo,
+                                  int32_t enabled);
+
+  /*! enables or disables automatic splitting of groups that exceed
+    optix' MAX_INSTANCES_PER_IAS or MAX_PRIMITIVES_PER_GAS limits:
+    when enabled, building such a group partitions it into several
+    parts that each stay within the limit, and builds the group's
+    traversable as an instance accel over those parts (keeping
+    instance IDs, primitive IDs and SBT offsets the same as for the
+    un-split group). Note this adds one level of instancing for each
+    group that gets split, which has to be accounted for in
+    lloSetMaxInstancingDepth. Off by default, in which case building
+    such groups throws an error. */
+  OWL_LL_INTERFACE
+  LLOResult lloSetGroupSplitting(LLOContext llo,
+                                 int32_t enabled);
+
+  /*! kind of group an LLOBuildStats is for */
+  typedef enum {
+    LLO_BUILD_KIND_TRIANGLES = 0,
+    LLO_BUILD_KIND_USER,
+    LLO_BUILD_KIND_INSTANCE
+  } LLOBuildKind;
+
+  /*! statistics of one group's accel build on one device (see
+    lloSetBuildStatsCallback). If a group build consists of several
+    optix builds (split groups, baked transforms) sizes and device
+    times are over all of them, except for the temp size, which is
+    the largest one any of them needed */
+  typedef struct _LLOBuildStats {
+    int32_t groupID;
+    int32_t deviceID;
+    /*! one of LLOBuildKind */
+    int32_t kind;
+    /*! triangles, user prims, or (flattened, baked) instances */
+    size_t  numPrimitives;
+    size_t  numBuildInputs;
+    /*! number of optix accels built */
+    size_t  numAccels;
+    /*! size of the user geoms' bounds arrays (zero for other kinds) */
+    size_t  boundsSizeInBytes;
+    size_t  tempSizeInBytes;
+    size_t  outputSizeInBytes;
+    /*! equal to outputSizeInBytes for accels that don't get compacted */
+    size_t  compactedSizeInBytes;
+    /*! compactedSizeInBytes / outputSizeInBytes */
+    double  compactionRatio;
+    /*! wall-clock time of the whole build on the host, and time the
+      optix builds (and compactions) took on the device */
+    double  hostBuildSeconds;
+    double  deviceBuildSeconds;
+  } LLOBuildStats;
+
+  /*! receives the stats of each accel build; the stats are only
+    valid during the call */
+  typedef void
+  (*LLOBuildStatsCB)(const LLOBuildStats *stats,
+                     void *userData);
+
+  /*! sets a callback that gets called (on the thread that built the
+    group) after every group accel build, once per device; a null
+    callback disables it. Measuring the device time adds a sync per
+    optix build, which the builds do anyway */
+  OWL_LL_INTERFACE
+  LLOResult lloSetBuildStatsCallback(LLOContext llo,
+                                     LLOBuildStatsCB callback,
+                                     void *userData);
+
   OWL_LL_INTERFACE
   LLOResult lloSetRayTypeCount(LLOContext llo,
                                size_t rayTypeCount);
@@ -347,6 +518,20 @@ extern "C" {
                                LLOWriteRayGenDataCB writeRayGenDataCB,
                                const void          *callBackData);
 
+  /*! re-builds only the SBT entry of the given ray gen program,
+   *  using the given callback to query the app as to what values to
+   *  write for it, and uploads only that record's bytes - so, eg,
+   *  per-frame camera changes don't require re-building (or even
+   *  touching) the hit group records. Falls back to building all ray
+   *  gen records if they have not been built yet, or if ray gen
+   *  programs were added since - in which case the callback gets
+   *  called for every ray gen ID, just like for lloSbtRayGensBuild */
+  OWL_LL_INTERFACE
+  LLOResult lloSbtRayGenBuild(LLOContext           llo,
+                              int32_t              rayGenID,
+                              LLOWriteRayGenDataCB writeRayGenDataCB,
+                              const void          *callBackData);
+
   /*! builds the SBT's miss program entries, using the given
    *  callback to query the app as as to what values to write for a
    *  given miss program */
@@ -365,6 +550,23 @@ extern "C" {
   
   OWL_LL_INTERFACE
   int32_t lloGetDeviceCount(LLOContext llo);
+
+  /*! enables or disables deduplication of device buffers: when
+    enabled, every device buffer created with initial data gets its
+    contents hashed, and if an existing buffer has the same contents
+    the new buffer shares that buffer's allocation (on each device)
+    instead of allocating and uploading its own. Buffers created this
+    way get a new allocation of their own (and thus a new device
+    address) on their first upload or resize. */
+  OWL_LL_INTERFACE
+  LLOResult lloSetBufferDedup(LLOContext llo,
+                              int32_t    enabled);
+
+  /*! returns the total number of bytes (summed over all devices)
+    that did not have to be allocated thanks to buffer
+    deduplication */
+  OWL_LL_INTERFACE
+  size_t lloGetBufferDedupBytesSaved(LLOContext llo);
   
   /*! returns the device-side pointer of the given buffer, on the
    *  given device */
@@ -394,6 +596,13 @@ extern "C" {
   uint32_t lloGroupGetSbtOffset(LLOContext llo,
                                 int32_t    groupID);
 
+  /*! returns how much device memory the given group's accel uses on
+    each device (including instance arrays, split parts, and baked or
+    merged geometry); 0 if it has not been built */
+  OWL_LL_INTERFACE
+  size_t lloGroupGetAccelMemory(LLOContext llo,
+                                int32_t    groupID);
+
   OWL_LL_INTERFACE
   LLOResult lloGeomTypeCreate(LLOContext llo,
                               int32_t geomTypeID,
@@ -506,6 +715,140 @@ extern "C" {
                                      int32_t    groupID,
                                      int32_t    childNo,
                                      int32_t    childGroupID);
+
+  /*! enables (or disables) host-side flattening of nested instance
+    groups below the given instance group: when enabled, building
+    this group composes all transforms in its subtree on the host,
+    and builds a single-level IAS over all geom groups reachable
+    from it; so nested instance groups below it do not need to be
+    built, and do not count against the max instancing depth. Each
+    such flattened instance gets as instance ID the index of the
+    child of this group that it came from.
+
+    \param maxFlattenedInstances upper limit on the number of
+    instances the flattening may create; building the group fails if
+    the subtree expands to more than that.
+  */
+  OWL_LL_INTERFACE
+  LLOResult lloInstanceGroupSetFlattening(LLOContext llo,
+                                          int32_t    groupID,
+                                          int32_t    enabled,
+                                          size_t     maxFlattenedInstances);
+
+  /*! sets the visibility masks of children [firstChild,
+    firstChild+count) of the given instance group; children whose
+    mask was never set use 255
+  */
+  OWL_LL_INTERFACE
+  LLOResult lloInstanceGroupSetVisibilityMasks(LLOContext     llo,
+                                               int32_t        groupID,
+                                               int32_t        firstChild,
+                                               size_t         count,
+                                               const uint8_t *masks);
+
+  /*! sets the instance flags of children [firstChild,
+    firstChild+count) of the given instance group; the values are
+    OptixInstanceFlags. Children whose flags were never set use
+    OPTIX_INSTANCE_FLAG_NONE
+  */
+  OWL_LL_INTERFACE
+  LLOResult lloInstanceGroupSetInstanceFlags(LLOContext      llo,
+                                             int32_t         groupID,
+                                             int32_t         firstChild,
+                                             size_t          count,
+                                             const uint32_t *flags);
+
+  /*! sets the instance IDs (as returned by optixGetInstanceId()) of
+    children [firstChild,firstChild+count) of the given instance
+    group; children whose ID was never set use their child index
+  */
+  OWL_LL_INTERFACE
+  LLOResult lloInstanceGroupSetInstanceIDs(LLOContext      llo,
+                                           int32_t         groupID,
+                                           int32_t         firstChild,
+                                           size_t          count,
+                                           const uint32_t *instanceIDs);
+
+  /*! enables (or disables) spatial sorting of the instances of the
+    given instance group: when enabled, the group's instances get
+    handed to the IAS builder in the morton order of their origins
+    (after flattening, if that is enabled as well) rather than in
+    child order, which helps build and traversal locality for large
+    groups whose children come in no particular spatial order. Each
+    instance keeps its instance ID, so optixGetInstanceId() still
+    returns the child index. Disabled by default.
+  */
+  OWL_LL_INTERFACE
+  LLOResult lloInstanceGroupSetSpatialSort(LLOContext llo,
+                                           int32_t    groupID,
+                                           int32_t    enabled);
+
+  /*! enables (or disables) transform baking for the given instance
+    group: when building the group's accel, instances of triangle geom
+    groups that have at most maxTrianglesPerGroup triangles, and that
+    get instanced at most maxInstancesPerGroup times in this group,
+    get replaced with world-space copies of their triangles (transformed
+    on the host), all of which go into one single triangles accel that
+    then gets a single instance in this group. This trades memory for
+    fewer (and less overlapping) instances, which often traces faster
+    for scenes with many tiny instanced meshes. Groups get considered
+    in the order of their first instance, and only as long as the
+    baked data of all their instances stays within memoryBudget bytes.
+
+    Only instances with the default visibility mask and no instance
+    flags get baked. Each baked triangle still uses the SBT record of
+    the geom it came from, but optixGetPrimitiveIndex() returns its
+    index in the baked mesh, and optixGetInstanceId() returns the
+    number of children of this group. Passing 0 for
+    maxTrianglesPerGroup disables baking, which is the default.
+  */
+  OWL_LL_INTERFACE
+  LLOResult lloInstanceGroupSetTransformBaking(LLOContext llo,
+                                               int32_t    groupID,
+                                               size_t     maxTrianglesPerGroup,
+                                               size_t     maxInstancesPerGroup,
+                                               size_t     memoryBudget);
+
+  /*! statistics of an instance group's last transform baking pass */
+  typedef struct _LLOTransformBakingStats {
+    /*! number of instances before/after baking */
+    size_t instancesBefore, instancesAfter;
+    /*! number of instances that got baked, and the number of
+      world-space triangles that created */
+    size_t instancesBaked, trianglesBaked;
+    /*! bytes of baked vertex, index, and SBT index data */
+    size_t bytesUsed;
+  } LLOTransformBakingStats;
+
+  /*! returns the stats of the given instance group's last transform
+    baking pass (all zero but the instance counts if nothing got
+    baked) */
+  OWL_LL_INTERFACE
+  LLOResult lloInstanceGroupGetTransformBakingStats(LLOContext llo,
+                                                    int32_t    groupID,
+                                                    LLOTransformBakingStats *stats);
+
+  /*! enables (or disables) merging of small meshes in the given
+    triangles geom group: when building the group's accel, runs of
+    consecutive children that each have at most maxTrianglesPerMesh
+    triangles (and share the same geom type) get concatenated on the
+    host into a single build input, with a per-primitive SBT index
+    offset that still selects each original geom's SBT record - so
+    programs see the same SBT data as without merging.
+
+    Note that within a merged build input optixGetPrimitiveIndex()
+    returns the index into the *merged* mesh, not into the geom's own
+    index array; programs attached to such geoms should use
+    optixGetTriangleVertexData() (enabled for such accels) instead of
+    looking up their own arrays. The merged arrays are a copy of the
+    geoms' data at build time, so changing a geom's vertices requires
+    a rebuild (as it does anyway). Passing 0 disables merging, which
+    is the default.
+  */
+  OWL_LL_INTERFACE
+  LLOResult lloTrianglesGeomGroupSetMeshMerging(LLOContext llo,
+                                                int32_t    groupID,
+                                                size_t     maxTrianglesPerMesh);
   
   OWL_LL_INTERFACE
   LLOResult lloGeomGroupSetChild(LLOContext llo,
@@ -559,6 +902,24 @@ void lloSbtRayGensBuild(LLOContext llo,
      (const void *)&l);
 }
 
+/*! C++-only wrapper of callback method with lambda function */
+template<typename Lambda>
+void lloSbtRayGenBuild(LLOContext llo,
+                       int32_t rayGenID,
+                       const Lambda &l)
+{
+  lloSbtRayGenBuild
+    (llo,rayGenID,
+     [](uint8_t *output,
+        int devID, int rgID, 
+        const void *cbData)
+     {
+       const Lambda *lambda = (const Lambda *)cbData;
+       (*lambda)(output,devID,rgID);
+     },
+     (const void *)&l);
+}
+
 /*! C++-only wrapper of callback method with lambda function */
 template<typename Lambda>
 void lloSbtHitProgsBuild(LLOContext llo,
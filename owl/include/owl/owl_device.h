@@ -64,6 +64,30 @@ namespace owl {
     return *(const T*)getProgramDataPointer();
   }
 
+  /*! for closest hit and any hit programs of triangle geoms: the
+      index of the hit triangle in the geom's own index buffer. This
+      is the same as optixGetPrimitiveIndex(), except for geoms whose
+      group merged them with other small meshes (see
+      owlTrianglesGeomGroupSetMeshMerging), where the latter is the
+      index in the merged mesh. Does not apply to triangles that got
+      baked by owlInstanceGroupSetTransformBaking.
+
+      owl stores the geom's first primitive in the merged mesh right
+      behind the geom type's variables - but only while some group
+      of the context merges meshes; without merging, call
+      optixGetPrimitiveIndex() instead. T has to be the geom type's
+      variable struct, with sizeof(T) exactly the data size given to
+      owlGeomTypeCreate(): for anything else (or without merging)
+      this silently reads garbage. */
+  template<typename T>
+  inline __device__ int getPrimitiveIndexInGeom()
+  {
+    const uint8_t *data = (const uint8_t*)getProgramDataPointer();
+    const uint32_t primBase
+      = *(const uint32_t*)(data + (sizeof(T)+3)/4*4);
+    return int(optixGetPrimitiveIndex() - primBase);
+  }
+
 
   // ==================================================================
   // general convenience/helper functions - may move to samples
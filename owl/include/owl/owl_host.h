@@ -94,6 +94,25 @@ typedef enum
    OWL_MATRIX_FORMAT_ROW_MAJOR
   } OWLMatrixFormat;
 
+/*! flags that can be set per instance (\see
+  owlInstanceGroupSetInstanceFlags); these can be or'ed together, and
+  correspond to optix' instance flags of the same names */
+typedef enum
+  {
+   OWL_INSTANCE_FLAG_NONE                          = 0,
+   /*! disables front/back face culling for this instance */
+   OWL_INSTANCE_FLAG_DISABLE_TRIANGLE_FACE_CULLING = 1<<0,
+   /*! flips which side of this instance's triangles counts as the
+     front face */
+   OWL_INSTANCE_FLAG_FLIP_TRIANGLE_FACING          = 1<<1,
+   /*! treats all geometry of this instance as opaque, i.e., never
+     calls any-hit programs */
+   OWL_INSTANCE_FLAG_DISABLE_ANYHIT                = 1<<2,
+   /*! calls any-hit programs for all geometry of this instance, even
+     if it is marked as opaque */
+   OWL_INSTANCE_FLAG_ENFORCE_ANYHIT                = 1<<3
+  } OWLInstanceFlags;
+
 typedef enum
   {
     OWL_FLOAT=100,
@@ -221,6 +240,7 @@ typedef struct _OWLGroup         *OWLGroup;
 typedef struct _OWLRayGen        *OWLRayGen;
 typedef struct _OWLMissProg      *OWLMissProg;
 typedef struct _OWLLaunchParams  *OWLLaunchParams;
+typedef struct _OWLLODSet        *OWLLODSet;
 
 // typedef OWLGeom OWLTriangles;
 
@@ -283,6 +303,422 @@ owlContextSetRayTypeCount(OWLContext context,
 OWL_API void
 owlSetMaxInstancingDepth(OWLContext context,
                          int32_t maxInstanceDepth);
+
+/*! enables or disables OWL's validation layer: checks for invalid
+  IDs, handles to objects that were already destroyed, variables
+  referencing destroyed buffers, node graphs that exceed the max
+  instancing depth, etc.
+
+  This is a process-wide setting. The default is 'on' in debug builds
+  and 'off' in release builds (where the checks cost a single branch
+  each); it can also be set through the OWL_VALIDATION environment
+  variable ("0" or "1"). */
+OWL_API void
+owlEnableValidation(int32_t enabled);
+
+/*! enables or disables tracing: when enabled, OWL records begin and
+  end time, thread, and (some) arguments of each API call, and of its
+  internal phases - module, program, and pipeline builds, accel
+  builds, SBT builds, and launches. If 'fileName' is non-null the
+  trace gets written to that file at exit, in Chrome's trace_event
+  JSON format (viewable in chrome://tracing or ui.perfetto.dev).
+
+  This is a process-wide setting. It is off by default (where it
+  costs a single branch per API call and phase), and can also be
+  enabled through the OWL_TRACE environment variable, which then
+  names the file to write the trace to. Each thread keeps only its
+  most recent 64K events. */
+OWL_API void
+owlEnableTracing(int32_t enabled, const char *fileName);
+
+/*! writes all trace events recorded so far to the given file; should
+  not be called while other threads are in OWL API calls */
+OWL_API void
+owlDumpTrace(const char *fileName);
+
+typedef enum
+  {
+   OWL_LOG_NONE    = 0,
+   OWL_LOG_ERROR   = 1,
+   OWL_LOG_WARNING = 2,
+   OWL_LOG_INFO    = 3,
+   /*! messages that can show up once per launch, group build, or
+     SBT build */
+   OWL_LOG_DEBUG   = 4
+  } OWLLogLevel;
+
+/*! callback that receives OWL's log messages (see
+  owlSetLogCallback); 'message' has no trailing newline */
+typedef void (*OWLLogCallback)(OWLLogLevel level,
+                               const char *message,
+                               void *userData);
+
+/*! sets the highest level of messages that OWL logs; all others
+  cost a single branch each, and do not even get formatted.
+
+  This is a process-wide setting. The default is OWL_LOG_INFO in
+  debug builds and OWL_LOG_ERROR in release builds; it can also be
+  set through the OWL_LOG_LEVEL environment variable (a number, or
+  one of "none", "error", "warning", "info", "debug"). */
+OWL_API void
+owlSetLogLevel(OWLLogLevel level);
+
+/*! sends all of OWL's log messages to the given callback instead of
+  stdout; passing null restores the default. The callback may get
+  called from any thread that calls into OWL, but never concurrently;
+  owlSetLogCallback itself should not be called concurrently with
+  itself */
+OWL_API void
+owlSetLogCallback(OWLLogCallback callback, void *userData);
+
+/*! enables or disables 'frame pipelining' for the given context.
+
+  By default, owlBuildSBT() overwrites the one and only copy of the
+  SBT, so the app has to make sure that no launch is still using it
+  (ie, has to synchronize) before changing any variables and
+  rebuilding the SBT for the next frame.
+
+  With frame pipelining enabled owlBuildSBT() writes into a second
+  copy of the SBT while launches that are still in flight keep using
+  the first one; the next launch then automatically swaps to the
+  newer copy. This allows for preparing frame N+1 on the host while
+  frame N is still rendering. Enabling this costs one extra copy of
+  all SBT records (on each device). */
+OWL_API void
+owlContextSetFramePipelining(OWLContext context,
+                             int32_t enabled);
+
+/*! enables or disables automatic splitting of groups that exceed
+  OptiX's per-accel limits (MAX_INSTANCES_PER_IAS for instance groups,
+  MAX_PRIMITIVES_PER_GAS for geom groups).
+
+  By default, building such a group fails. With splitting enabled,
+  the group instead gets partitioned into several parts that each
+  stay within the limit (instance groups spatially, by their
+  instances' origins; geom groups into consecutive primitive ranges),
+  and its accel becomes an instance accel over those parts. Instance
+  IDs, instance flags, visibility masks, primitive IDs and SBT
+  offsets stay the same as for the un-split group: instance groups
+  instance the parts of a split geom group directly, with the
+  settings of the child that refers to it, so split geom groups do
+  not add a level of instancing (traced directly, a split geom group
+  reports an instance ID of 0). Each instance group that gets split
+  does add one level of instancing, so make sure to account for that
+  in owlSetMaxInstancingDepth().
+
+  The OWL_MAX_PRIMS_PER_GAS and OWL_MAX_INSTANCES_PER_IAS environment
+  variables (read on context creation) lower the limits splitting
+  works against, eg to test it on small scenes. */
+OWL_API void
+owlContextSetGroupSplitting(OWLContext context,
+                            int32_t enabled);
+
+/*! kind of group an OWLBuildStats is for */
+typedef enum
+  {
+   OWL_BUILD_KIND_TRIANGLES = 0,
+   OWL_BUILD_KIND_USER,
+   OWL_BUILD_KIND_INSTANCE
+  }
+  OWLBuildKind;
+
+/*! statistics of one group's accel build on one device, as passed to
+  the callback set with owlContextSetBuildStatsCallback() */
+typedef struct _OWLBuildStats {
+  /*! the group's ID (see owlGroupGetID), and the device it got
+    built on */
+  int32_t      groupID;
+  int32_t      deviceID;
+  OWLBuildKind kind;
+  /*! number of triangles, user prims, or instances (after flattening
+    and transform baking) the accel got built over */
+  size_t       numPrimitives;
+  /*! number of optix build inputs, and of optix accels built; more
+    than one accel means the group got split, or had transforms
+    baked */
+  size_t       numBuildInputs;
+  size_t       numAccels;
+  /*! size of the user geoms' bounds arrays (zero for other kinds) */
+  size_t       boundsSizeInBytes;
+  /*! the largest temp buffer any of the group's optix builds needed */
+  size_t       tempSizeInBytes;
+  /*! size of the builds' outputs, and what they got compacted to;
+    the two are the same for accels that do not get compacted
+    (user geoms and instances) */
+  size_t       outputSizeInBytes;
+  size_t       compactedSizeInBytes;
+  /*! compactedSizeInBytes / outputSizeInBytes */
+  double       compactionRatio;
+  /*! wall-clock time of the whole build on the host (including
+    bounds, instance packing, uploads), and time the optix builds
+    and compactions took on the device */
+  double       hostBuildSeconds;
+  double       deviceBuildSeconds;
+} OWLBuildStats;
+
+typedef void (*OWLBuildStatsCallback)(const OWLBuildStats *stats,
+                                      void *userData);
+
+/*! sets a callback that gets called after every owlGroupBuildAccel()
+  (and every rebuild done by owlContextApplyUpdates), once per
+  device, on the thread that triggered the build; the stats are only
+  valid during the call. Pass a null callback to disable it. Build
+  stats also get logged at debug level (see owlSetLogLevel). */
+OWL_API void
+owlContextSetBuildStatsCallback(OWLContext context,
+                                OWLBuildStatsCallback callback,
+                                void *userData);
+
+/*! enables or disables deduplication of device buffers.
+
+  Scenes from DCC exporters often contain many identical meshes that
+  each come with their own buffers. With dedup enabled, every
+  owlDeviceBufferCreate() with initial data hashes that data, and if
+  a buffer with identical contents already exists the new buffer
+  shares its allocation on each device, instead of allocating and
+  uploading another copy. (Buffers only share an allocation after
+  their contents got compared byte by byte, so hash collisions can
+  not alias different data.)
+
+  An owlBufferUpload() to a buffer that still shares its allocation
+  with others gives it a new allocation of its own (and thus a new
+  device address, just like owlBufferResize() does), so the other
+  buffers remain unaffected; triangle geoms using that buffer pick up
+  the new address automatically, but - as after any upload - groups
+  over them have to be rebuilt. Off by default. */
+OWL_API void
+owlContextSetBufferDedup(OWLContext context,
+                         int32_t enabled);
+
+/*! returns how many bytes of device memory (summed over all devices)
+  did not have to be allocated and uploaded thanks to buffer
+  dedup */
+OWL_API size_t
+owlContextGetBufferDedupBytesSaved(OWLContext context);
+
+/*! inspects the context's current scene, and writes a report to the
+  given file (null or "-" meaning stdout): instancing depth and
+  fan-out histograms, geoms per group, SBT record size and padding,
+  likely duplicate buffers, tiny meshes and tiny instanced groups,
+  device memory per category, and concrete recommendations (buffer
+  dedup, flattening, mesh merging, transform baking, smaller geom
+  data), each with an estimate of the memory it would save.
+
+  All of this runs on the host, in time linear in the scene size.
+  Accel sizes are only known for groups that have been built.
+  Setting the OWL_INSPECT environment variable to a file name (see
+  scripts/owl-inspect) writes the same report at the first
+  owlBuildSBT(), without changing the app. */
+OWL_API void
+owlContextDumpStats(OWLContext context,
+                    const char *fileName);
+
+/*! number of buckets of each OWLMetricsHistogram */
+#define OWL_METRICS_NUM_BUCKETS 48
+
+/*! one counter or gauge of an OWLMetrics snapshot; names follow the
+  Prometheus conventions, and may carry labels, such as
+  'owl_api_calls_total{entry="owlBufferCreate"}' */
+typedef struct {
+  const char *name;
+  uint64_t    value;
+} OWLMetricsValue;
+
+/*! a latency histogram of an OWLMetrics snapshot. Bucket 'i' counts
+  values in [2^(i-1),2^i) nanoseconds (bucket 0 only counts zeros),
+  the last one also everything above */
+typedef struct {
+  const char *name;
+  uint64_t    count;
+  uint64_t    sumNs;
+  uint64_t    maxNs;
+  uint64_t    buckets[OWL_METRICS_NUM_BUCKETS];
+} OWLMetricsHistogram;
+
+/*! a snapshot of OWL's metrics, as returned by owlContextGetMetrics;
+  all arrays are sorted by name */
+typedef struct {
+  size_t                     numCounters;
+  const OWLMetricsValue     *counters;
+  size_t                     numGauges;
+  const OWLMetricsValue     *gauges;
+  size_t                     numHistograms;
+  const OWLMetricsHistogram *histograms;
+} OWLMetrics;
+
+/*! returns a snapshot of OWL's always-on metrics; the snapshot has
+  to be released with owlMetricsRelease.
+
+  Counters are running totals since process start, summed over all
+  contexts (and, for per-device work such as SBT records and buffer
+  uploads, over all devices): API calls per entry point, SBT records
+  and bytes written, buffer uploads and bytes, and instances encoded
+  for instance accel builds. Histograms hold the latencies of accel
+  builds per kind of group. Gauges are current values of the given
+  context, such as its number of live API handles, and the bytes of
+  OWL's counted host allocations (see owlGetHostAllocStats) that are
+  currently live, per site.
+
+  Counting is per-thread and lock-free; only taking a snapshot merges
+  the threads' counts, so this can be called at any time, from any
+  thread. */
+OWL_API const OWLMetrics *
+owlContextGetMetrics(OWLContext context);
+
+/*! returns the given snapshot in the Prometheus text exposition
+  format (with histograms in seconds); the string is owned by the
+  snapshot, and valid until it gets released */
+OWL_API const char *
+owlMetricsToText(const OWLMetrics *metrics);
+
+/*! releases a snapshot returned by owlContextGetMetrics */
+OWL_API void
+owlMetricsRelease(const OWLMetrics *metrics);
+
+/*! the parts of OWL whose host allocations get counted separately */
+typedef enum
+  {
+   /*! API handles - including the temporary ones of
+     owl<Object>Set<Type>() - and the bookkeeping for them */
+   OWL_HOST_ALLOC_HANDLES = 0,
+   /*! variables of geoms, programs, and launch params */
+   OWL_HOST_ALLOC_VARIABLES,
+   /*! host copies of launch params */
+   OWL_HOST_ALLOC_LAUNCH,
+   /*! scratch arrays of instance accel builds */
+   OWL_HOST_ALLOC_ACCEL,
+   OWL_HOST_ALLOC_NUM_SITES
+  } OWLHostAllocSite;
+
+typedef void *(*OWLHostAllocFn)(size_t numBytes, void *userData);
+typedef void  (*OWLHostFreeFn)(void *ptr, size_t numBytes, void *userData);
+
+/*! counts of one OWLHostAllocSite since program start */
+typedef struct {
+  uint64_t numAllocs;
+  uint64_t numFrees;
+  uint64_t bytesAllocated;
+  uint64_t bytesFreed;
+} OWLHostAllocStats;
+
+/*! makes OWL's host allocations on (or close to) the per-frame paths
+  - see OWLHostAllocSite - go through the given functions. The
+  allocation function has to return memory aligned like malloc()'s
+  does; the free function gets the size of the block back. Passing
+  null for both restores malloc/free. This is a process-wide setting
+  that can only be changed while no context exists - before creating
+  the first one, or after destroying the last one - as it throws
+  while OWL still holds memory from the previous functions.
+
+  Whichever functions are in use, OWL counts allocations and bytes
+  per site (see owlGetHostAllocStats), which is how apps - and OWL's
+  own tests - can check that a steady-state frame of
+  owl<Object>Set<Type>(), owlInstanceGroupSetTransform(),
+  owlGroupBuildAccel(), owlBuildSBT() and owlParamsLaunch2D() does
+  not allocate any host memory. That holds with validation off,
+  logging below OWL_LOG_INFO, and instance flattening, sorting and
+  transform baking disabled; device memory is not counted here. */
+OWL_API void
+owlSetHostAllocator(OWLHostAllocFn allocFn,
+                    OWLHostFreeFn  freeFn,
+                    void *userData);
+
+/*! returns the allocation counts of the given site */
+OWL_API OWLHostAllocStats
+owlGetHostAllocStats(OWLHostAllocSite site);
+
+/*! writes a table of all sites' allocation counts to the given file
+  (null or "-" meaning stdout) */
+OWL_API void
+owlDumpHostAllocStats(const char *fileName);
+
+/*! enables or disables hardware performance counters - cycles,
+  instructions, cache misses and branch misses, in user space - around
+  OWL's host-side phases: SBT builds, instance packing for instance
+  accel builds, variable writes into SBT records and launch params,
+  and object registry operations. Each phase's counts show up in
+  owlContextGetMetrics(), as, eg,
+  'owl_perf_cycles_total{phase="sbt_build"}', next to how often it ran
+  ('owl_perf_scopes_total{phase="sbt_build"}'). Counts are inclusive,
+  so variable writes also count towards the SBT build they happen in.
+
+  This needs OWL built with the OWL_PERF_COUNTERS cmake option, on
+  linux, and a kernel that lets the process open perf events (see
+  /proc/sys/kernel/perf_event_paranoid); anything else is not an
+  error - the counters just stay off, after a single warning. Returns
+  1 if the counters are active afterwards, 0 if not.
+
+  This is a process-wide setting. It is off by default, and can also
+  be enabled through the OWL_PERF_COUNTERS environment variable
+  ("1"). */
+OWL_API int32_t
+owlEnablePerfCounters(int32_t enabled);
+
+/*! record types of the scene update stream consumed by
+  owlContextApplyUpdates() */
+typedef enum
+  {
+   /*! payload: int32 group, uint32 firstChild, uint32 count, then
+     'count' affine transforms of 12 floats each (vx,vy,vz,p) */
+   OWL_UPDATE_TRANSFORMS       = 1,
+   /*! payload: int32 group, uint32 firstChild, uint32 count, then
+     'count' int32 IDs of the groups to use as new children */
+   OWL_UPDATE_CHILDREN         = 2,
+   /*! payload: int32 group, uint32 firstChild, uint32 count, then
+     'count' uint8 visibility masks */
+   OWL_UPDATE_VISIBILITY_MASKS = 3,
+   /*! payload: uint32 target (OWLUpdateTarget), int32 object,
+     uint32 variable index (in declaration order), uint32 numBytes,
+     then the variable's new value */
+   OWL_UPDATE_VARIABLE         = 4
+  } OWLUpdateType;
+
+/*! kinds of objects an OWL_UPDATE_VARIABLE record can write to */
+typedef enum
+  {
+   OWL_UPDATE_TARGET_GEOM     = 0,
+   OWL_UPDATE_TARGET_RAYGEN   = 1,
+   OWL_UPDATE_TARGET_MISSPROG = 2
+  } OWLUpdateTarget;
+
+#define OWL_UPDATES_MAGIC   0x4a4c574f
+#define OWL_UPDATES_VERSION 1
+
+/*! applies one batch of scene updates - as produced by, say, a
+  simulation or a network stream - and then rebuilds everything
+  these updates touched exactly once: the accels of all modified
+  instance groups and of all instance groups above them, and the
+  SBT.
+
+  The batch is a little-endian binary stream of a uint32 magic
+  (OWL_UPDATES_MAGIC) and a uint32 version (OWL_UPDATES_VERSION),
+  followed by any number of records. Each record is a uint32 type
+  (OWLUpdateType) and a uint32 payload size, followed by the
+  payload, zero-padded to a multiple of 4 bytes. Objects are
+  referred to by their IDs (see owlGroupGetID() etc). Adding or
+  removing instances is not supported by this format; use
+  pre-allocated children that get shown and hidden through their
+  visibility masks instead.
+
+  Redundant updates get coalesced, ie, if a batch contains several
+  updates of the same child's transform (or of the same variable),
+  only the last one gets applied. The batch gets validated as a
+  whole before anything gets applied; malformed batches (or ones
+  that refer to objects that do not exist, or to variables that
+  are not plain data) throw, and leave the scene unchanged.
+
+  Returns the number of updates applied after coalescing. */
+OWL_API size_t
+owlContextApplyUpdates(OWLContext context,
+                       const void *data,
+                       size_t size);
+
+/*! return the IDs by which scene update streams (see
+  owlContextApplyUpdates()) refer to the given objects */
+OWL_API int32_t owlGroupGetID(OWLGroup group);
+OWL_API int32_t owlGeomGetID(OWLGeom geom);
+OWL_API int32_t owlRayGenGetID(OWLRayGen rayGen);
+OWL_API int32_t owlMissProgGetID(OWLMissProg missProg);
   
 
 OWL_API void
@@ -432,6 +868,15 @@ owlBufferDestroy(OWLBuffer buffer);
 OWL_API void 
 owlBufferUpload(OWLBuffer buffer, const void *hostPtr);
 
+/*! re-builds (and uploads) only the given ray gen's SBT record,
+  with the current values of its variables. Use this instead of
+  owlBuildSBT() when only ray gen variables (say, the camera)
+  changed since the last build, to avoid re-writing all hit group
+  records; owlBuildSBT() has to have been called at least once
+  before (else this falls back to building all ray gen records). */
+OWL_API void
+owlRayGenBuildSBT(OWLRayGen rayGen);
+
 /*! executes an optix lauch of given size, with given launch
   program. Note this is asynchronous, and may _not_ be
   completed by the time this function returns. */
@@ -478,6 +923,168 @@ owlInstanceGroupSetTransform(OWLGroup group,
                              const float *floats,
                              OWLMatrixFormat matrixFormat);
 
+/*! sets the visibility mask of the given child of an instance group:
+  a ray only sees this instance if the mask passed to optixTrace()
+  and this mask have at least one bit in common. Defaults to 255
+  (visible to all rays). */
+OWL_API void
+owlInstanceGroupSetVisibilityMask(OWLGroup group,
+                                  int whichChild,
+                                  uint8_t mask);
+
+/*! bulk variant of owlInstanceGroupSetVisibilityMask, setting the
+  masks of children [firstChild,firstChild+count) from 'masks' */
+OWL_API void
+owlInstanceGroupSetVisibilityMaskRange(OWLGroup group,
+                                       int firstChild,
+                                       size_t count,
+                                       const uint8_t *masks);
+
+/*! sets the OWLInstanceFlags of the given child of an instance
+  group. Defaults to OWL_INSTANCE_FLAG_NONE. */
+OWL_API void
+owlInstanceGroupSetInstanceFlags(OWLGroup group,
+                                 int whichChild,
+                                 uint32_t flags);
+
+/*! bulk variant of owlInstanceGroupSetInstanceFlags, setting the
+  flags of children [firstChild,firstChild+count) from 'flags' */
+OWL_API void
+owlInstanceGroupSetInstanceFlagsRange(OWLGroup group,
+                                      int firstChild,
+                                      size_t count,
+                                      const uint32_t *flags);
+
+/*! sets the instance ID of the given child of an instance group,
+  i.e., the value optixGetInstanceId() returns for hits in that
+  instance; several children can use the same ID. Defaults to the
+  child's index. */
+OWL_API void
+owlInstanceGroupSetInstanceID(OWLGroup group,
+                              int whichChild,
+                              uint32_t instanceID);
+
+/*! bulk variant of owlInstanceGroupSetInstanceID, setting the IDs of
+  children [firstChild,firstChild+count) from 'instanceIDs' */
+OWL_API void
+owlInstanceGroupSetInstanceIDRange(OWLGroup group,
+                                   int firstChild,
+                                   size_t count,
+                                   const uint32_t *instanceIDs);
+
+/*! creates a level-of-detail set: numLevels groups that represent the
+  same object at decreasing detail (finest first), with the geometric
+  error of each level relative to the finest one, in the groups' own
+  (object-space) units; errors must not decrease from one level to
+  the next. \see owlInstanceGroupSetChildLOD */
+OWL_API OWLLODSet
+owlLODSetCreate(OWLContext context,
+                size_t numLevels,
+                const OWLGroup *levels,
+                const float *geometricErrors);
+
+/*! lets the given child of an instance group use the given LOD set
+  rather than a fixed group; the child starts out at the set's finest
+  level until the next owlInstanceGroupSelectLOD(). Setting the child
+  through owlInstanceGroupSetChild() later on ends its use of the LOD
+  set. */
+OWL_API void
+owlInstanceGroupSetChildLOD(OWLGroup group,
+                            int whichChild,
+                            OWLLODSet lodSet);
+
+/*! for each child of the given instance group that uses an LOD set,
+  picks the coarsest level whose geometric error, scaled by the
+  child's transform and divided by its distance to cameraPos (a
+  float3), stays within 'threshold' - which thus is about the allowed
+  angular error, in radians; a pixel-sized error is the camera's
+  field of view divided by the image's resolution. Levels are picked
+  in parallel, and only children whose level changed get updated;
+  returns the number of those, i.e., if this returns 0 the group's
+  accel does not need to be rebuilt. */
+OWL_API size_t
+owlInstanceGroupSelectLOD(OWLGroup group,
+                          const float *cameraPos,
+                          float threshold);
+
+/*! enables (or disables) flattening of nested instance groups below
+  the given instance group: if enabled, building this group composes
+  all transforms below it on the host, and creates a single-level
+  instance list over all geom groups reachable from it, so the
+  pipeline only needs an instancing depth of one for this group no
+  matter how deeply its children are nested. optixGetInstanceId()
+  still returns the instance ID of the child of *this* group that the
+  hit instance came from, and visibility masks along the way get
+  and'ed together. Building fails if flattening would create more
+  than maxFlattenedInstances instances. Disabled by default. */
+OWL_API void
+owlInstanceGroupSetFlattening(OWLGroup group,
+                              int32_t enabled,
+                              size_t maxFlattenedInstances);
+
+/*! enables sorting the instances of the given instance group by the
+  morton code of their origins before building its accel, which
+  improves build and traversal locality for large groups whose
+  children were created in no particular spatial order. Instance IDs
+  are not affected, i.e., optixGetInstanceId() still returns the
+  child index. Disabled by default. */
+OWL_API void
+owlInstanceGroupSetSpatialSort(OWLGroup group,
+                               int32_t enabled);
+
+/*! enables baking of small instanced meshes in the given instance
+  group: instances of triangle geom groups with at most
+  maxTrianglesPerGroup triangles, that get instanced at most
+  maxInstancesPerGroup times in this group, get transformed into
+  world space on the host, and all such copies go into a single
+  accel with a single instance - as long as they fit into
+  memoryBudget bytes. Each triangle keeps using its geom's SBT record
+  and variables, but optixGetPrimitiveIndex() returns its index in
+  the baked mesh, and optixGetInstanceId() returns the number of
+  children of this group. Instances with a non-default visibility
+  mask or instance flags never get baked. Passing 0 for
+  maxTrianglesPerGroup (the default) disables baking. */
+OWL_API void
+owlInstanceGroupSetTransformBaking(OWLGroup group,
+                                   size_t maxTrianglesPerGroup,
+                                   size_t maxInstancesPerGroup,
+                                   size_t memoryBudget);
+
+/*! statistics of an instance group's last transform baking pass */
+typedef struct _OWLTransformBakingStats {
+  /*! number of instances before/after baking */
+  size_t instancesBefore, instancesAfter;
+  /*! number of instances that got baked, and the number of
+    world-space triangles that created */
+  size_t instancesBaked, trianglesBaked;
+  /*! bytes of baked vertex, index, and SBT index data */
+  size_t bytesUsed;
+} OWLTransformBakingStats;
+
+/*! returns the stats of the given instance group's last transform
+  baking pass, i.e., of its last accel build */
+OWL_API OWLTransformBakingStats
+owlInstanceGroupGetTransformBakingStats(OWLGroup group);
+
+/*! enables merging of small meshes in the given triangles geom
+  group: runs of consecutive geoms with at most maxTrianglesPerMesh
+  triangles each (and of the same geom type) get concatenated into a
+  single build input when the group's accel gets built, which makes
+  groups of many tiny meshes (say, boxes) much cheaper to build and
+  trace. Each geom still uses its own SBT record and variables, but
+  in its programs optixGetPrimitiveIndex() returns the index into the
+  merged mesh rather than into the geom's index buffer - use
+  owl::getPrimitiveIndexInGeom<T>() (see owl_device.h) for the
+  latter, or optixGetTriangleVertexData() to get the hit triangle's
+  vertices directly. Changes to which geoms get merged only show up
+  in those programs after the next owlBuildSBT(). While any group of
+  the context merges meshes, all hit group records carry an extra
+  four bytes for getPrimitiveIndexInGeom() (which can grow each
+  record by 16 bytes). Passing 0 (the default) disables merging. */
+OWL_API void
+owlTrianglesGeomGroupSetMeshMerging(OWLGroup group,
+                                    size_t maxTrianglesPerMesh);
+
 OWL_API void
 owlGeomTypeSetClosestHit(OWLGeomType type,
                          int rayType,
@@ -517,6 +1124,7 @@ OWL_API void owlModuleRelease(OWLModule module);
 OWL_API void owlBufferRelease(OWLBuffer buffer);
 OWL_API void owlRayGenRelease(OWLRayGen rayGen);
 OWL_API void owlGroupRelease(OWLGroup group);
+OWL_API void owlLODSetRelease(OWLLODSet lodSet);
 
 // -------------------------------------------------------
 // VariableGet for the various types
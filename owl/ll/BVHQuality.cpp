@@ -0,0 +1,567 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "BVHQuality.h"
+#include "owl/common/parallel/parallel_for.h"
+// std
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+namespace owl {
+  namespace ll {
+
+    /*! ranges with at least this many prims get their bounds and SAH
+        bins computed in parallel */
+    static const size_t parallelThreshold = 64*1024;
+    /*! block size of those parallel passes; fixed, so the result
+        does not depend on the number of threads */
+    static const size_t blockSize = 16*1024;
+    /*! sub-trees with at most this many prims get built serially -
+        but in parallel with each other */
+    static const size_t subtreeThreshold = 4*1024;
+
+    namespace {
+      struct PrimRef {
+        box3f bounds;
+        vec3f center;
+        int   primID;
+      };
+
+      struct Node {
+        box3f  bounds;
+        /*! the two children of inner nodes; -1 for leaves */
+        int    child[2];
+        size_t begin, end;
+        int    depth;
+      };
+
+      struct BuildTask {
+        int    nodeID;
+        size_t begin, end;
+        int    depth;
+      };
+
+      inline float surfaceArea(const box3f &box)
+      {
+        return box.empty() ? 0.f : area(box);
+      }
+
+      inline bool isValid(const box3f &box)
+      {
+        for (int dim=0;dim<3;dim++)
+          if (!std::isfinite(box.lower[dim]) ||
+              !std::isfinite(box.upper[dim]) ||
+              box.lower[dim] > box.upper[dim])
+            return false;
+        return true;
+      }
+
+      /*! bounds of a range of prims, and of their centers */
+      struct RangeBounds {
+        void extend(const PrimRef &prim)
+        {
+          bounds.extend(prim.bounds);
+          centers.extend(prim.center);
+        }
+        void merge(const RangeBounds &other)
+        {
+          bounds.extend(other.bounds);
+          centers.extend(other.centers);
+        }
+
+        box3f bounds, centers;
+      };
+
+      /*! maps prim centers to SAH bins, per axis */
+      struct BinMapping {
+        BinMapping(const box3f &centers, int numBins)
+          : lower(centers.lower), numBins(numBins)
+        {
+          const vec3f extent = centers.span();
+          for (int dim=0;dim<3;dim++)
+            // (slightly less than numBins, so the upper end of the
+            // range still falls into the last bin)
+            scale[dim] = extent[dim] > 0.f
+              ? (numBins*(1.f-1e-5f))/extent[dim]
+              : 0.f;
+        }
+
+        inline int bin(const vec3f &center, int dim) const
+        {
+          const int b = int((center[dim]-lower[dim])*scale[dim]);
+          return std::min(std::max(b,0),numBins-1);
+        }
+
+        vec3f lower, scale;
+        int   numBins;
+      };
+
+      /*! per-axis SAH bins of a range of prims */
+      struct Bins {
+        Bins(int numBins)
+          : bounds(3*numBins), count(3*numBins,0)
+        {}
+        void merge(const Bins &other)
+        {
+          for (size_t i=0;i<bounds.size();i++) {
+            bounds[i].extend(other.bounds[i]);
+            count[i] += other.count[i];
+          }
+        }
+
+        std::vector<box3f>  bounds;
+        std::vector<size_t> count;
+      };
+
+      /*! computes 'init' merged with blockFct() of all of
+          [begin,end); in parallel (over fixed blocks) for large
+          ranges */
+      template<typename T, typename BlockFct>
+      T reduceRange(size_t begin, size_t end, const T &init,
+                    const BlockFct &blockFct)
+      {
+        T result = init;
+        if (end-begin < parallelThreshold) {
+          blockFct(result,begin,end);
+          return result;
+        }
+        const size_t numBlocks = (end-begin+blockSize-1)/blockSize;
+        std::vector<T> partial(numBlocks,init);
+        owl::common::parallel_for
+          (numBlocks,[&](size_t blockID){
+            const size_t blockBegin = begin+blockID*blockSize;
+            blockFct(partial[blockID],blockBegin,
+                     std::min(blockBegin+blockSize,end));
+          });
+        for (auto &p : partial)
+          result.merge(p);
+        return result;
+      }
+
+      class Builder {
+      public:
+        Builder(std::vector<PrimRef> &prims, const BVHQualityConfig &config)
+          : prims(prims),
+            numBins(std::max(config.numBins,2)),
+            maxLeafSize(std::max(config.maxLeafSize,1)),
+            traversalCost(config.traversalCost),
+            intersectionCost(config.intersectionCost)
+        {}
+
+        /*! builds the tree over all prims; node 0 is the root */
+        void build(std::vector<Node> &nodes)
+        {
+          nodes.clear();
+          if (prims.empty()) return;
+
+          // ------------------------------------------------------------------
+          // top of the tree: one node at a time (with parallel
+          // binning), until all open nodes are small enough to be
+          // built on their own
+          // ------------------------------------------------------------------
+          std::vector<BuildTask> subtrees;
+          std::vector<BuildTask> open;
+          nodes.push_back(Node());
+          open.push_back({ 0, 0, prims.size(), 0 });
+          while (!open.empty()) {
+            const BuildTask task = open.back();
+            open.pop_back();
+            if (task.end-task.begin <= subtreeThreshold)
+              subtrees.push_back(task);
+            else
+              buildNode(nodes,task,open);
+          }
+
+          // ------------------------------------------------------------------
+          // then all sub-trees in parallel, each into its own node
+          // array, which then get appended in a fixed order
+          // ------------------------------------------------------------------
+          std::vector<std::vector<Node>> subtreeNodes(subtrees.size());
+          owl::common::parallel_for
+            (subtrees.size(),[&](size_t subtreeID){
+              std::vector<Node> &local = subtreeNodes[subtreeID];
+              std::vector<BuildTask> stack;
+              local.push_back(Node());
+              BuildTask root = subtrees[subtreeID];
+              root.nodeID = 0;
+              stack.push_back(root);
+              while (!stack.empty()) {
+                const BuildTask task = stack.back();
+                stack.pop_back();
+                buildNode(local,task,stack);
+              }
+            });
+          for (size_t subtreeID=0;subtreeID<subtrees.size();subtreeID++) {
+            const std::vector<Node> &local = subtreeNodes[subtreeID];
+            const int rootID = subtrees[subtreeID].nodeID;
+            const int base   = (int)nodes.size();
+            auto globalID = [&](int localID)
+              { return localID == 0 ? rootID : base+localID-1; };
+            for (size_t localID=0;localID<local.size();localID++) {
+              Node node = local[localID];
+              for (int c=0;c<2;c++)
+                if (node.child[c] >= 0)
+                  node.child[c] = globalID(node.child[c]);
+              if (localID == 0)
+                nodes[rootID] = node;
+              else
+                nodes.push_back(node);
+            }
+          }
+        }
+
+      private:
+        /*! sets up the given task's node, and - unless it becomes a
+            leaf - its two children, whose tasks go into 'todo' */
+        void buildNode(std::vector<Node> &nodes,
+                       const BuildTask &task,
+                       std::vector<BuildTask> &todo)
+        {
+          const RangeBounds range
+            = reduceRange(task.begin,task.end,RangeBounds(),
+                          [&](RangeBounds &rb, size_t begin, size_t end){
+                            for (size_t i=begin;i<end;i++)
+                              rb.extend(prims[i]);
+                          });
+          Node &node    = nodes[task.nodeID];
+          node.bounds   = range.bounds;
+          node.child[0] = node.child[1] = -1;
+          node.begin    = task.begin;
+          node.end      = task.end;
+          node.depth    = task.depth;
+
+          const size_t mid = split(task.begin,task.end,range);
+          if (mid == task.begin)
+            return;
+
+          const int left = (int)nodes.size();
+          nodes.push_back(Node());
+          nodes.push_back(Node());
+          nodes[task.nodeID].child[0] = left;
+          nodes[task.nodeID].child[1] = left+1;
+          todo.push_back({ left,   task.begin, mid, task.depth+1 });
+          todo.push_back({ left+1, mid, task.end, task.depth+1 });
+        }
+
+        /*! partitions [begin,end) along the best SAH split and
+            returns where the right half starts, or returns 'begin'
+            if the range should be a leaf */
+        size_t split(size_t begin, size_t end, const RangeBounds &range)
+        {
+          const size_t count     = end-begin;
+          const bool   mustSplit = count > (size_t)maxLeafSize;
+          if (count <= 1)
+            return begin;
+
+          const float nodeArea = surfaceArea(range.bounds);
+          if (nodeArea > 0.f) {
+            const BinMapping mapping(range.centers,numBins);
+            const Bins bins
+              = reduceRange(begin,end,Bins(numBins),
+                            [&](Bins &b, size_t blockBegin, size_t blockEnd){
+                              for (size_t i=blockBegin;i<blockEnd;i++)
+                                for (int dim=0;dim<3;dim++) {
+                                  const int bin
+                                    = dim*numBins+mapping.bin(prims[i].center,dim);
+                                  b.bounds[bin].extend(prims[i].bounds);
+                                  b.count[bin]++;
+                                }
+                            });
+
+            int   bestDim  = -1;
+            int   bestBin  = 0;
+            float bestCost = std::numeric_limits<float>::infinity();
+            std::vector<float>  rightArea(numBins);
+            std::vector<size_t> rightCount(numBins);
+            for (int dim=0;dim<3;dim++) {
+              if (mapping.scale[dim] == 0.f) continue;
+              const box3f  *binBounds = bins.bounds.data()+dim*numBins;
+              const size_t *binCount  = bins.count.data()+dim*numBins;
+              box3f  right;
+              size_t numRight = 0;
+              for (int bin=numBins-1;bin>0;bin--) {
+                right.extend(binBounds[bin]);
+                numRight += binCount[bin];
+                rightArea[bin]  = surfaceArea(right);
+                rightCount[bin] = numRight;
+              }
+              box3f  left;
+              size_t numLeft = 0;
+              for (int bin=1;bin<numBins;bin++) {
+                left.extend(binBounds[bin-1]);
+                numLeft += binCount[bin-1];
+                if (numLeft == 0 || rightCount[bin] == 0) continue;
+                const float cost
+                  = traversalCost
+                  + intersectionCost
+                  * (surfaceArea(left)*numLeft + rightArea[bin]*rightCount[bin])
+                  / nodeArea;
+                if (cost < bestCost) {
+                  bestDim  = dim;
+                  bestBin  = bin;
+                  bestCost = cost;
+                }
+              }
+            }
+
+            if (bestDim >= 0 && (mustSplit || bestCost < intersectionCost*count)) {
+              PrimRef *mid
+                = std::partition(prims.data()+begin,prims.data()+end,
+                                 [&](const PrimRef &prim)
+                                 { return mapping.bin(prim.center,bestDim) < bestBin; });
+              return mid-prims.data();
+            }
+          }
+          if (!mustSplit)
+            return begin;
+
+          // too many prims for a leaf, but nothing the SAH can split
+          // (eg, all centers in the same spot): object median split
+          const vec3f extent = range.centers.span();
+          const int dim
+            = (extent.x >= extent.y && extent.x >= extent.z)
+            ? 0 : (extent.y >= extent.z ? 1 : 2);
+          const size_t mid = begin+count/2;
+          std::nth_element(prims.begin()+begin,prims.begin()+mid,prims.begin()+end,
+                           [dim](const PrimRef &a, const PrimRef &b)
+                           { return a.center[dim] < b.center[dim]
+                               || (a.center[dim] == b.center[dim] && a.primID < b.primID); });
+          return mid;
+        }
+
+        std::vector<PrimRef> &prims;
+        const int   numBins;
+        const int   maxLeafSize;
+        const float traversalCost;
+        const float intersectionCost;
+      };
+    }
+
+    BVHQualityReport analyzeBVHQuality(const box3f *bounds,
+                                       size_t numPrims,
+                                       const BVHQualityConfig &config)
+    {
+      if (numPrims > (size_t)std::numeric_limits<int>::max())
+        throw std::runtime_error("too many prims for BVH analysis");
+      BVHQualityReport report;
+      report.numPrims = numPrims;
+
+      std::vector<PrimRef> prims;
+      prims.reserve(numPrims);
+      for (size_t primID=0;primID<numPrims;primID++) {
+        if (!isValid(bounds[primID])) {
+          report.numInvalidPrims++;
+          continue;
+        }
+        PrimRef prim;
+        prim.bounds = bounds[primID];
+        prim.center = bounds[primID].center();
+        prim.primID = (int)primID;
+        prims.push_back(prim);
+      }
+
+      std::vector<Node> nodes;
+      Builder(prims,config).build(nodes);
+      if (nodes.empty())
+        return report;
+
+      // ------------------------------------------------------------------
+      // walk the tree
+      // ------------------------------------------------------------------
+      report.bounds = nodes[0].bounds;
+      const float  rootArea    = surfaceArea(report.bounds);
+      const double invRootArea = rootArea > 0.f ? 1./rootArea : 0.;
+      report.flatCost = config.intersectionCost*prims.size();
+
+      struct LeafCost {
+        double cost;
+        int    nodeID;
+      };
+      std::vector<LeafCost> leafCosts;
+      double sumOverlapRatio = 0.;
+      for (size_t nodeID=0;nodeID<nodes.size();nodeID++) {
+        const Node  &node     = nodes[nodeID];
+        const float  nodeArea = surfaceArea(node.bounds);
+        const double relArea  = nodeArea*invRootArea;
+        report.maxDepth = std::max(report.maxDepth,node.depth);
+        if (node.child[0] < 0) {
+          const size_t count = node.end-node.begin;
+          const double cost  = config.intersectionCost*relArea*count;
+          report.numLeaves++;
+          report.sahLeafCost += cost;
+          if (report.leafSizeHistogram.size() <= count)
+            report.leafSizeHistogram.resize(count+1,0);
+          report.leafSizeHistogram[count]++;
+          leafCosts.push_back({ cost, (int)nodeID });
+        } else {
+          report.numInnerNodes++;
+          report.sahInnerCost += config.traversalCost*relArea;
+          const box3f overlap
+            = intersection(nodes[node.child[0]].bounds,
+                           nodes[node.child[1]].bounds);
+          const float overlapArea = surfaceArea(overlap);
+          report.overlapArea += overlapArea*invRootArea;
+          if (nodeArea > 0.f)
+            sumOverlapRatio += overlapArea/nodeArea;
+        }
+      }
+      report.sahCost = report.sahInnerCost+report.sahLeafCost;
+      if (report.numInnerNodes)
+        report.meanOverlapRatio = sumOverlapRatio/report.numInnerNodes;
+
+      // ------------------------------------------------------------------
+      // worst offenders (ties broken by ID, so reports are stable)
+      // ------------------------------------------------------------------
+      std::vector<BVHQualityReport::Prim> primAreas(prims.size());
+      for (size_t i=0;i<prims.size();i++) {
+        primAreas[i].primID = prims[i].primID;
+        primAreas[i].area   = float(surfaceArea(prims[i].bounds)*invRootArea);
+        report.sumPrimArea += primAreas[i].area;
+      }
+      const size_t numWorst = (size_t)std::max(config.numWorstOffenders,0);
+      const size_t numPrimsReported = std::min(numWorst,primAreas.size());
+      std::partial_sort(primAreas.begin(),primAreas.begin()+numPrimsReported,
+                        primAreas.end(),
+                        [](const BVHQualityReport::Prim &a,
+                           const BVHQualityReport::Prim &b)
+                        { return a.area > b.area
+                            || (a.area == b.area && a.primID < b.primID); });
+      report.largestPrims.assign(primAreas.begin(),
+                                 primAreas.begin()+numPrimsReported);
+
+      const size_t numLeavesReported = std::min(numWorst,leafCosts.size());
+      std::partial_sort(leafCosts.begin(),leafCosts.begin()+numLeavesReported,
+                        leafCosts.end(),
+                        [](const LeafCost &a, const LeafCost &b)
+                        { return a.cost > b.cost
+                            || (a.cost == b.cost && a.nodeID < b.nodeID); });
+      for (size_t i=0;i<numLeavesReported;i++) {
+        const Node &node = nodes[leafCosts[i].nodeID];
+        BVHQualityReport::Leaf leaf;
+        leaf.cost = leafCosts[i].cost;
+        leaf.area = float(surfaceArea(node.bounds)*invRootArea);
+        for (size_t j=node.begin;j<node.end;j++)
+          leaf.primIDs.push_back(prims[j].primID);
+        std::sort(leaf.primIDs.begin(),leaf.primIDs.end());
+        report.costliestLeaves.push_back(leaf);
+      }
+      return report;
+    }
+
+    BVHQualityReport analyzeBVHQuality(const vec3f *vertices,
+                                       size_t numVertices,
+                                       const vec3i *indices,
+                                       size_t numTriangles,
+                                       const BVHQualityConfig &config)
+    {
+      std::vector<box3f> bounds(numTriangles);
+      std::atomic<size_t> firstInvalid(numTriangles);
+      owl::common::parallel_for_blocked
+        (0,numTriangles,blockSize,[&](size_t begin, size_t end){
+          for (size_t triID=begin;triID<end;triID++) {
+            const vec3i index = indices[triID];
+            box3f &box = bounds[triID];
+            bool valid = true;
+            for (int i=0;i<3;i++) {
+              if (index[i] < 0 || (size_t)index[i] >= numVertices) {
+                valid = false;
+                break;
+              }
+              box.extend(vertices[index[i]]);
+            }
+            if (valid) continue;
+            size_t current = firstInvalid.load();
+            while (triID < current &&
+                   !firstInvalid.compare_exchange_weak(current,triID))
+              ;
+          }
+        });
+      if (firstInvalid.load() < numTriangles) {
+        const size_t triID = firstInvalid.load();
+        throw std::runtime_error("triangle #"+std::to_string(triID)
+                                 +" refers to a vertex that does not exist ("
+                                 +std::to_string(numVertices)+" vertices)");
+      }
+      return analyzeBVHQuality(bounds.data(),numTriangles,config);
+    }
+
+    void writeReport(std::ostream &out, const BVHQualityReport &report)
+    {
+      const size_t numValid = report.numPrims-report.numInvalidPrims;
+      out << "#owl.bvh: input" << std::endl
+          << "  prims              " << report.numPrims;
+      if (report.numInvalidPrims)
+        out << " (" << report.numInvalidPrims
+            << " with empty or non-finite bounds, skipped)";
+      out << std::endl;
+      if (numValid == 0)
+        return;
+      out << "  bounds             " << report.bounds << std::endl;
+
+      const std::ios::fmtflags flags = out.flags();
+      const std::streamsize precision = out.precision();
+      out << std::fixed << std::setprecision(3);
+      out << "#owl.bvh: tree" << std::endl
+          << "  inner nodes        " << report.numInnerNodes << std::endl
+          << "  leaves             " << report.numLeaves << " (avg "
+          << double(numValid)/report.numLeaves << " prims)" << std::endl
+          << "  max depth          " << report.maxDepth << std::endl
+          << "  leaf sizes        ";
+      for (size_t size=0;size<report.leafSizeHistogram.size();size++)
+        if (report.leafSizeHistogram[size])
+          out << " " << size << ":" << report.leafSizeHistogram[size];
+      out << std::endl;
+
+      out << "#owl.bvh: cost (areas relative to the root)" << std::endl
+          << "  SAH cost           " << report.sahCost
+          << " (inner nodes " << report.sahInnerCost
+          << ", leaves " << report.sahLeafCost
+          << "; a single leaf would be " << report.flatCost << ")" << std::endl
+          << "  child overlap      " << report.overlapArea
+          << " (avg " << 100.*report.meanOverlapRatio
+          << "% of a node's area)" << std::endl
+          << "  sum of prim areas  " << report.sumPrimArea
+          << " (prims a ray through the root hits, on average)" << std::endl;
+
+      out << "#owl.bvh: largest prims" << std::endl;
+      for (auto &prim : report.largestPrims)
+        out << "  prim " << std::setw(10) << std::left << prim.primID
+            << std::right << " area " << prim.area << std::endl;
+
+      out << "#owl.bvh: costliest leaves" << std::endl;
+      const size_t maxPrimIDs = 8;
+      for (auto &leaf : report.costliestLeaves) {
+        out << "  cost " << leaf.cost << " ("
+            << (report.sahCost > 0. ? 100.*leaf.cost/report.sahCost : 0.)
+            << "% of total), area " << leaf.area << ", prims";
+        for (size_t i=0;i<std::min(leaf.primIDs.size(),maxPrimIDs);i++)
+          out << " " << leaf.primIDs[i];
+        if (leaf.primIDs.size() > maxPrimIDs)
+          out << " ... (" << leaf.primIDs.size() << " total)";
+        out << std::endl;
+      }
+      out.flags(flags);
+      out.precision(precision);
+    }
+
+  } // ::owl::ll
+} //::owl
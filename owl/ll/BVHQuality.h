@@ -0,0 +1,136 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "owl/common/math/box.h"
+// std
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+namespace owl {
+  namespace ll {
+    using owl::common::vec3f;
+    using owl::common::vec3i;
+    using owl::common::box3f;
+
+    /*! host-side BVH quality analysis: builds a reference binned-SAH
+        BVH over the same inputs OWL hands to optix' builders - the
+        box3f's of a user geom's bounds buffer, or a triangle mesh's
+        vertex and index buffers - and reports how good a BVH over
+        them can be: its SAH cost, how much sibling nodes overlap,
+        how large its leaves are, and which prims and leaves cost the
+        most. Optix' own BVHs are different (and opaque), but inputs
+        that make this one bad - eg, huge, overlapping user geom
+        bounds - make those bad, too. Only needs owl::common math,
+        and builds in parallel where TBB is available. */
+
+    /*! parameters of the reference BVH, and of the report */
+    struct BVHQualityConfig {
+      /*! number of SAH bins per axis */
+      int   numBins           = 16;
+      /*! leaves never get larger than this; smaller leaves are made
+          whenever the SAH says splitting does not pay off */
+      int   maxLeafSize       = 8;
+      /*! SAH cost of traversing one inner node, and of intersecting
+          one prim */
+      float traversalCost     = 1.f;
+      float intersectionCost  = 1.f;
+      /*! how many of the worst prims and leaves to report */
+      int   numWorstOffenders = 10;
+    };
+
+    /*! result of analyzeBVHQuality(). All areas are relative to the
+        surface area of the root, ie, they are the probabilities of a
+        random ray that hits the root also hitting the given box */
+    struct BVHQualityReport {
+      /*! prims we got, and those that got skipped because their
+          bounds are empty or not finite */
+      size_t numPrims        = 0;
+      size_t numInvalidPrims = 0;
+      box3f  bounds;
+
+      size_t numInnerNodes   = 0;
+      size_t numLeaves       = 0;
+      int    maxDepth        = 0;
+
+      /*! SAH cost of the whole tree, and the parts of it spent in
+          inner nodes and leaves */
+      double sahCost         = 0.;
+      double sahInnerCost    = 0.;
+      double sahLeafCost     = 0.;
+      /*! for reference: the SAH cost of a single leaf with all
+          (valid) prims */
+      double flatCost        = 0.;
+
+      /*! sum, over all inner nodes, of the area in which their two
+          children overlap; every unit of this is a guaranteed extra
+          node visit for rays in that area */
+      double overlapArea     = 0.;
+      /*! average, over inner nodes, of the fraction of the node's
+          area its children overlap in (0 for perfectly separated
+          children) */
+      double meanOverlapRatio = 0.;
+      /*! sum of all prims' areas: the expected number of prims
+          whose bounds a ray through the root hits, which no BVH can
+          get below. Values far above the scene's actual depth
+          complexity mean the prims' bounds are much larger than the
+          prims, or overlap a lot */
+      double sumPrimArea     = 0.;
+
+      /*! bin 'n' counts leaves with 'n' prims */
+      std::vector<size_t> leafSizeHistogram;
+
+      /*! one of the prims with the largest bounds */
+      struct Prim {
+        int   primID;
+        float area;
+      };
+      /*! one of the leaves that contribute most to the SAH cost */
+      struct Leaf {
+        /*! the leaf's share of sahCost */
+        double           cost;
+        float            area;
+        std::vector<int> primIDs;
+      };
+      /*! largest prims first, costliest leaves first */
+      std::vector<Prim> largestPrims;
+      std::vector<Leaf> costliestLeaves;
+    };
+
+    /*! analyzes the given prim bounds, as in a user geom's bounds
+        buffer */
+    BVHQualityReport analyzeBVHQuality(const box3f *bounds,
+                                       size_t numPrims,
+                                       const BVHQualityConfig &config
+                                       = BVHQualityConfig());
+
+    /*! analyzes the given triangle mesh (prim IDs being triangle
+        indices); throws on indices that refer to vertices that do
+        not exist */
+    BVHQualityReport analyzeBVHQuality(const vec3f *vertices,
+                                       size_t numVertices,
+                                       const vec3i *indices,
+                                       size_t numTriangles,
+                                       const BVHQualityConfig &config
+                                       = BVHQualityConfig());
+
+    /*! writes a human-readable version of the given report */
+    void writeReport(std::ostream &out, const BVHQualityReport &report);
+
+  } // ::owl::ll
+} //::owl
@@ -0,0 +1,116 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "BufferDedup.h"
+#include "owl/common/parallel/parallel_for.h"
+// std
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace owl {
+  namespace ll {
+
+    /*! size of the chunks that get hashed in parallel; must never
+        change for a given table, else identical contents would get
+        different hashes */
+    static const size_t hashChunkSize = 256*1024;
+
+    static inline uint64_t rotl64(uint64_t v, int r)
+    {
+      return (v << r) | (v >> (64-r));
+    }
+
+    /*! final avalanche step (as in murmurhash3's fmix64) */
+    static inline uint64_t fmix64(uint64_t h)
+    {
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      h *= 0xc4ceb9fe1a85ec53ULL;
+      h ^= h >> 33;
+      return h;
+    }
+
+    /*! mixes one 64-bit word into the running hash */
+    static inline uint64_t mixWord(uint64_t h, uint64_t v)
+    {
+      v *= 0x87c37b91114253d5ULL;
+      v  = rotl64(v,31);
+      v *= 0x4cf5ad432745937fULL;
+      h ^= v;
+      h  = rotl64(h,27)*5 + 0x52dce729ULL;
+      return h;
+    }
+
+    /*! hashes one chunk, 8 bytes at a time, using four independent
+        lanes so the multiplies can overlap */
+    static uint64_t hashChunk(const uint8_t *data, size_t numBytes,
+                              uint64_t seed)
+    {
+      uint64_t lane[4] = {
+        seed, seed ^ 0x9e3779b97f4a7c15ULL,
+        rotl64(seed,17), ~seed
+      };
+      size_t pos = 0;
+      for (;pos+32<=numBytes;pos+=32) {
+        uint64_t v[4];
+        memcpy(v,data+pos,sizeof(v));
+        lane[0] = mixWord(lane[0],v[0]);
+        lane[1] = mixWord(lane[1],v[1]);
+        lane[2] = mixWord(lane[2],v[2]);
+        lane[3] = mixWord(lane[3],v[3]);
+      }
+      uint64_t h = lane[0];
+      h = mixWord(h,lane[1]);
+      h = mixWord(h,lane[2]);
+      h = mixWord(h,lane[3]);
+      for (;pos+8<=numBytes;pos+=8) {
+        uint64_t v;
+        memcpy(&v,data+pos,sizeof(v));
+        h = mixWord(h,v);
+      }
+      if (pos < numBytes) {
+        uint64_t tail = 0;
+        memcpy(&tail,data+pos,numBytes-pos);
+        h = mixWord(h,tail);
+      }
+      return fmix64(h ^ numBytes);
+    }
+
+    uint64_t contentHash64(const void *data, size_t numBytes)
+    {
+      const uint8_t *bytes = (const uint8_t *)data;
+      const size_t numChunks = (numBytes+hashChunkSize-1)/hashChunkSize;
+      if (numChunks <= 1)
+        return hashChunk(bytes,numBytes,0);
+
+      std::vector<uint64_t> chunkHash(numChunks);
+      owl::common::parallel_for
+        (numChunks,[&](size_t chunkID){
+          const size_t begin = chunkID*hashChunkSize;
+          const size_t size  = std::min(hashChunkSize,numBytes-begin);
+          chunkHash[chunkID] = hashChunk(bytes+begin,size,chunkID);
+        });
+
+      uint64_t h = numBytes;
+      for (auto ch : chunkHash)
+        h = mixWord(h,ch);
+      return fmix64(h);
+    }
+
+  } // ::owl::ll
+} //::owl
@@ -0,0 +1,107 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <utility>
+
+namespace owl {
+  namespace ll {
+
+    /*! computes a 64-bit hash over the given memory block; large
+        blocks get hashed in parallel, in fixed-size chunks whose
+        hashes then get combined in order, so the result does not
+        depend on the number of threads (nor on the alignment of
+        'data'). This is *not* a cryptographic hash. */
+    uint64_t contentHash64(const void *data, size_t numBytes);
+
+    /*! table for sharing allocations between buffers with identical
+        contents (as used by buffer deduplication, see
+        lloSetBufferDedup). Candidates are found by their size and
+        their contentHash64() (and can then be verified by the
+        caller, see the three-argument find()); the table only holds weak
+        references, so an allocation goes away as soon as the last
+        buffer using it does, and the table never keeps anything
+        alive by itself.
+
+        This class does not know anything about CUDA, and is
+        templated over what it shares only so it can be tested on the
+        host. */
+    template<typename T>
+    struct ContentDedupTable {
+      /*! returns the shared allocation with the given contents if we
+          have one that is still alive, or null otherwise. A
+          successful lookup counts towards bytesSaved */
+      std::shared_ptr<T> find(uint64_t hash, size_t numBytes)
+      {
+        return find(hash,numBytes,[](const T &){ return true; });
+      }
+
+      /*! same as find(hash,numBytes), but only returns the
+          allocation if 'sameContents(allocation)' confirms it really
+          holds the contents we are looking for - hash and size alone
+          can collide */
+      template<typename SameContents>
+      std::shared_ptr<T> find(uint64_t hash, size_t numBytes,
+                              const SameContents &sameContents)
+      {
+        auto it = entries.find(Key(hash,numBytes));
+        if (it == entries.end())
+          return nullptr;
+        std::shared_ptr<T> existing = it->second.lock();
+        if (!existing) {
+          // everybody that used this allocation is gone
+          entries.erase(it);
+          return nullptr;
+        }
+        if (!sameContents(*existing))
+          return nullptr;
+        bytesSaved += numBytes;
+        numDeduped++;
+        return existing;
+      }
+
+      /*! remember the given allocation as holding the given
+          contents */
+      void insert(uint64_t hash, size_t numBytes,
+                  const std::shared_ptr<T> &allocation)
+      {
+        entries[Key(hash,numBytes)] = allocation;
+      }
+
+      /*! number of (hash,size) entries currently in the table,
+          including expired ones that haven't been cleaned up yet */
+      size_t size() const { return entries.size(); }
+
+      /*! total number of bytes that did not have to be allocated
+          (and uploaded) because an identical allocation already
+          existed */
+      size_t bytesSaved = 0;
+      /*! number of buffers that got deduplicated */
+      size_t numDeduped = 0;
+
+    private:
+      typedef std::pair<uint64_t,size_t> Key;
+      std::map<Key,std::weak_ptr<T>> entries;
+    };
+
+  } // ::owl::ll
+} //::owl
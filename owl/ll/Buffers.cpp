@@ -44,26 +44,44 @@ namespace owl {
 
     DeviceBuffer::DeviceBuffer(const size_t elementCount,
                                const size_t elementSize)
-      : Buffer(elementCount, elementSize)
+      : Buffer(elementCount, elementSize),
+        devMem(std::make_shared<DeviceMemory>())
+    {
+      devMem->alloc(elementCount*elementSize);
+      d_pointer = devMem->get();
+    }
+    
+    DeviceBuffer::DeviceBuffer(const size_t elementCount,
+                               const size_t elementSize,
+                               const std::shared_ptr<DeviceMemory> &sharedMem)
+      : Buffer(elementCount, elementSize),
+        devMem(sharedMem),
+        dedupShared(true)
     {
-      devMem.alloc(elementCount*elementSize);
-      d_pointer = devMem.get();
+      assert(devMem && devMem->size() == elementCount*elementSize);
+      d_pointer = devMem->get();
     }
     
     DeviceBuffer::~DeviceBuffer()
     {
-      devMem.free();
+      // frees the memory unless other (deduplicated) buffers still
+      // use it
+      devMem = nullptr;
     }
 
     void DeviceBuffer::resize(Device *device, size_t newElementCount) 
     {
       device->context->pushActive();
 
-      devMem.free();
+      if (dedupShared) {
+        devMem = std::make_shared<DeviceMemory>();
+        dedupShared = false;
+      }
+      devMem->free();
       
       this->elementCount = newElementCount;
-      devMem.alloc(elementCount*elementSize);
-      d_pointer = devMem.get();
+      devMem->alloc(elementCount*elementSize);
+      d_pointer = devMem->get();
       
       device->context->popActive();
     }
@@ -71,7 +89,15 @@ namespace owl {
     void DeviceBuffer::upload(Device *device, const void *hostPtr) 
     {
       device->context->pushActive();
-      devMem.upload(hostPtr,"DeviceBuffer::upload");
+      if (dedupShared && devMem.use_count() > 1) {
+        // others still use the shared copy, so get our own (note
+        // this changes the buffer's device address)
+        devMem = std::make_shared<DeviceMemory>();
+        devMem->alloc(elementCount*elementSize);
+        d_pointer = devMem->get();
+        dedupShared = false;
+      }
+      devMem->upload(hostPtr,"DeviceBuffer::upload");
       device->context->popActive();
     }
 
@@ -53,10 +53,28 @@ namespace owl {
     {
       DeviceBuffer(const size_t elementCount,
                    const size_t elementSize);
+      /*! creates a buffer that uses the given, already existing
+          allocation (which holds the right contents) - used for
+          buffer deduplication */
+      DeviceBuffer(const size_t elementCount,
+                   const size_t elementSize,
+                   const std::shared_ptr<DeviceMemory> &sharedMem);
       ~DeviceBuffer();
       void resize(Device *device, size_t newElementCount) override;
       void upload(Device *device, const void *hostPtr) override;
-      DeviceMemory devMem;
+
+      /*! the device memory of this buffer; usually only used by this
+          buffer, but with buffer deduplication enabled this may be
+          shared with other buffers that have the same contents */
+      std::shared_ptr<DeviceMemory> devMem;
+      /*! whether 'devMem' is (or may be) shared through the device's
+          dedup table; if so, an upload while other buffers still
+          share it, as well as any resize, gives this buffer a new
+          allocation of its own (and thus a new address), since the
+          others rely on the old one not changing. A buffer that is
+          the only one left using its allocation gets uploaded to in
+          place */
+      bool dedupShared = false;
     };
     
     /*! buffer type that corresponds to CUDA's "host pinned memory"
@@ -0,0 +1,69 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "BuildStats.h"
+#include "owl/common/owl-common.h"
+// std
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace owl {
+  namespace ll {
+    using owl::common::prettyNumber;
+
+    void BuildStats::addAccel(size_t numInputs,
+                              size_t tempSize,
+                              size_t outputSize,
+                              size_t compactedSize)
+    {
+      numBuildInputs       += numInputs;
+      numAccels            += 1;
+      tempSizeInBytes       = std::max(tempSizeInBytes,tempSize);
+      outputSizeInBytes    += outputSize;
+      compactedSizeInBytes += compactedSize;
+    }
+
+    double BuildStats::compactionRatio() const
+    {
+      return outputSizeInBytes
+        ? double(compactedSizeInBytes)/double(outputSizeInBytes)
+        : 1.;
+    }
+
+    std::string BuildStats::toText() const
+    {
+      static const char *kindName[] = { "triangles", "user", "instance" };
+      std::stringstream ss;
+      ss << ((kind >= KIND_TRIANGLES && kind <= KIND_INSTANCE)
+             ? kindName[kind] : "unknown")
+         << " group #" << groupID << ": "
+         << prettyNumber(numPrimitives) << " prims in "
+         << numBuildInputs << " input(s), " << numAccels << " accel(s); ";
+      if (boundsSizeInBytes)
+        ss << prettyNumber(boundsSizeInBytes) << "B bounds, ";
+      ss << prettyNumber(tempSizeInBytes) << "B temp, "
+         << prettyNumber(outputSizeInBytes) << "B output, "
+         << prettyNumber(compactedSizeInBytes) << "B compacted ("
+         << int(100.*compactionRatio()+.5) << "%); "
+         << std::fixed << std::setprecision(3)
+         << hostBuildSeconds*1000. << "ms host, "
+         << deviceBuildSeconds*1000. << "ms device";
+      return ss.str();
+    }
+    
+  } // ::owl::ll
+} //::owl
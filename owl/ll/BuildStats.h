@@ -0,0 +1,77 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace owl {
+  namespace ll {
+
+    /*! statistics of one group's accel build, as delivered to the
+        build stats callback (see lloSetBuildStatsCallback). A group
+        build can consist of several optix builds (split groups,
+        baked transforms); sizes and device times are over all of
+        them. None of this needs CUDA or optix. */
+    struct BuildStats {
+      /*! kind of group that got built; same values as LLOBuildKind */
+      enum { KIND_TRIANGLES = 0, KIND_USER, KIND_INSTANCE };
+      
+      int32_t groupID  = -1;
+      int32_t deviceID = 0;
+      int32_t kind     = KIND_TRIANGLES;
+      /*! number of primitives (triangles, user prims, or instances
+          after flattening and baking) the group's accel is built
+          over */
+      size_t  numPrimitives  = 0;
+      /*! number of optix build inputs, and of optix accels built */
+      size_t  numBuildInputs = 0;
+      size_t  numAccels      = 0;
+      /*! size of the user geoms' bounds arrays; zero for other kinds */
+      size_t  boundsSizeInBytes    = 0;
+      /*! the largest temp buffer any of the optix builds needed
+          (they get allocated one after another, so this is the
+          peak) */
+      size_t  tempSizeInBytes      = 0;
+      /*! summed over all optix builds: size of the builds' outputs,
+          and what they got compacted to (the same as the output
+          size for builds that do not get compacted) */
+      size_t  outputSizeInBytes    = 0;
+      size_t  compactedSizeInBytes = 0;
+      /*! wall-clock time of the whole build on the host, and time
+          the optix builds (and compactions) took on the device */
+      double  hostBuildSeconds   = 0.;
+      double  deviceBuildSeconds = 0.;
+
+      /*! accounts for one optix accel build with the given number of
+          build inputs and buffer sizes */
+      void addAccel(size_t numInputs,
+                    size_t tempSize,
+                    size_t outputSize,
+                    size_t compactedSize);
+
+      /*! compacted over output size; 1 if nothing got compacted */
+      double compactionRatio() const;
+
+      /*! human-readable one-line summary, for logging */
+      std::string toText() const;
+    };
+    
+  } // ::owl::ll
+} //::owl
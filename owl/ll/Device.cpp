@@ -21,29 +21,30 @@
 extern inline OptixResult optixInit( void** handlePtr );
 
 #define LOG(message)                                            \
-  if (Context::logging()) \
-  std::cout << "#owl.ll(" << context->owlDeviceID << "): "      \
-  << message                                                    \
-  << std::endl
-
-#define LOG_OK(message)                                 \
-  if (Context::logging()) \
-  std::cout << OWL_TERMINAL_GREEN                       \
-  << "#owl.ll(" << context->owlDeviceID << "): "        \
-  << message << OWL_TERMINAL_DEFAULT << std::endl
-
-#define CLOG(message)                                   \
-  if (Context::logging()) \
-  std::cout << "#owl.ll(" << owlDeviceID << "): "       \
-  << message                                            \
-  << std::endl
-
-#define CLOG_OK(message)                                \
-  if (Context::logging()) \
-  std::cout << OWL_TERMINAL_GREEN                       \
-  << "#owl.ll(" << owlDeviceID << "): "                 \
-  << message << OWL_TERMINAL_DEFAULT << std::endl
+  OWL_LOG(LEVEL_INFO,"#owl.ll(" << context->owlDeviceID << "): "  \
+          << message)
 
+#define LOG_OK(message)                                         \
+  OWL_LOG_COLOR(LEVEL_INFO,OWL_TERMINAL_GREEN,                  \
+                "#owl.ll(" << context->owlDeviceID << "): "     \
+                << message)
+
+/*! for messages that can show up once per launch, group build, or
+    SBT build */
+#define LOG_DEBUG(message)                                      \
+  OWL_LOG(LEVEL_DEBUG,"#owl.ll(" << context->owlDeviceID << "): " \
+          << message)
+
+#define CLOG(message)                                           \
+  OWL_LOG(LEVEL_INFO,"#owl.ll(" << owlDeviceID << "): " << message)
+
+#define CLOG_OK(message)                                        \
+  OWL_LOG_COLOR(LEVEL_INFO,OWL_TERMINAL_GREEN,                  \
+                "#owl.ll(" << owlDeviceID << "): " << message)
+
+#define CLOG_WARNING(message)                                   \
+  OWL_LOG(LEVEL_WARNING,"#owl.ll(" << owlDeviceID << "): "      \
+          << message)
 
 // iw - the variants Context::pushActive/popActive are *not*
 // thread-safe (they store the value in the context, so for async
@@ -59,10 +60,8 @@ namespace owl {
     {
       WarnOnce(const char *message)
       {
-        std::cout << OWL_TERMINAL_RED
-                  << "#owl.ll(warning): "
-                  << message
-                  << OWL_TERMINAL_DEFAULT << std::endl;
+        OWL_LOG_COLOR(LEVEL_WARNING,OWL_TERMINAL_RED,
+                      "#owl.ll(warning): " << message);
       }
     };
       
@@ -71,8 +70,13 @@ namespace owl {
                                const char *message,
                                void *)
     {
+      // optix levels: 1 is fatal, 2 error, 3 warning, 4 print
       if (level == 1 || level == 2)
-        fprintf( stderr, "[%2d][%12s]: %s\n", level, tag, message );
+        OWL_LOG(LEVEL_ERROR,"[" << level << "][" << tag << "]: " << message);
+      else if (level == 3)
+        OWL_LOG(LEVEL_WARNING,"[" << level << "][" << tag << "]: " << message);
+      else
+        OWL_LOG(LEVEL_DEBUG,"[" << level << "][" << tag << "]: " << message);
     }
 
     LaunchParams::LaunchParams(Context *context, size_t sizeOfData)
@@ -129,6 +133,183 @@ namespace owl {
       freedRanges.push_back({begin,size});
     }
 
+    SBTRecords::~SBTRecords()
+    {
+      if (hostMemory) cudaFreeHost(hostMemory);
+      if (uploadDone) cudaEventDestroy(uploadDone);
+      for (auto &launchDone : launchesDone)
+        cudaEventDestroy(launchDone.event);
+    }
+
+    /*! prepare the slot the next build writes to, waiting for any
+        launch that might still use it; returns the slot with its
+        (zero-initialized) host memory sized for the given number of
+        records */
+    SBTRecords &SBTRecordsStaging::beginWrite(Context *context,
+                                              size_t recordCount,
+                                              size_t recordSize)
+    {
+      assert("check we're not already writing" && writing < 0);
+      writing = staging.writeSlot();
+      SBTRecords &records = slot[writing];
+
+      if (staging.needsWait(writing)) {
+        // the last launches that used this slot - on whichever
+        // streams - might still be reading from it ...
+        assert(!records.launchesDone.empty());
+        for (auto &launchDone : records.launchesDone)
+          CUDA_CHECK(cudaEventSynchronize(launchDone.event));
+        staging.retire(writing);
+      }
+      if (records.uploadDone)
+        // ... and a previous async upload might still be reading our
+        // host memory
+        CUDA_CHECK(cudaEventSynchronize(records.uploadDone));
+
+      const size_t sizeInBytes = recordCount * recordSize;
+      if (records.hostMemorySize < sizeInBytes) {
+        if (records.hostMemory)
+          CUDA_CHECK(cudaFreeHost(records.hostMemory));
+        CUDA_CHECK(cudaMallocHost((void**)&records.hostMemory,sizeInBytes));
+        records.hostMemorySize = sizeInBytes;
+      }
+      // note: changing the size will re-alloc, which (through
+      // cudaFree) implicitly syncs the device; that's OK since it
+      // only happens when the scene layout changes, not on regular
+      // per-frame updates
+      if (records.deviceMemory.size() != sizeInBytes)
+        records.deviceMemory.alloc(sizeInBytes);
+      if (sizeInBytes)
+        memset(records.hostMemory,0,sizeInBytes);
+      
+      records.recordCount = recordCount;
+      records.recordSize  = recordSize;
+      return records;
+    }
+
+    /*! upload the slot returned by the last beginWrite(), and make it
+        the newest version */
+    void SBTRecordsStaging::endWrite(Context *context)
+    {
+      assert("check we're actually writing" && writing >= 0);
+      SBTRecords &records = slot[writing];
+      writingAll = true;
+      endUpdate(context,0,records.recordCount * records.recordSize);
+    }
+
+    /*! like beginWrite(), but with the slot's host memory holding
+        the newest version of all records */
+    SBTRecords &SBTRecordsStaging::beginUpdate(Context *context)
+    {
+      assert("check records have been built" && staging.valid());
+      const int newest = staging.newestSlot();
+      const SBTRecords &current = slot[newest];
+      const size_t recordCount = current.recordCount;
+      const size_t recordSize  = current.recordSize;
+      if (staging.writeSlot() == newest) {
+        // same slot (always the case without pipelining): keep the
+        // host copy as is, it matches what's on the device
+        writing = newest;
+        SBTRecords &records = slot[writing];
+        if (records.uploadDone)
+          CUDA_CHECK(cudaEventSynchronize(records.uploadDone));
+        writingAll = false;
+        return records;
+      }
+      // the other slot: start from a copy of the newest version, and
+      // upload all of it, since its device copy is an older version
+      SBTRecords &records = beginWrite(context,recordCount,recordSize);
+      if (recordCount && recordSize)
+        memcpy(records.hostMemory,current.hostMemory,recordCount*recordSize);
+      writingAll = true;
+      return records;
+    }
+
+    /*! upload bytes [begin,begin+size) of the slot being written (or
+        all of it, if required), and make it the newest version */
+    void SBTRecordsStaging::endUpdate(Context *context,
+                                      size_t begin, size_t size)
+    {
+      assert("check we're actually writing" && writing >= 0);
+      SBTRecords &records = slot[writing];
+      if (writingAll) {
+        begin = 0;
+        size  = records.recordCount * records.recordSize;
+      }
+      assert(begin+size <= records.recordCount * records.recordSize);
+      void *devicePtr = addPointerOffset(records.deviceMemory.get(),begin);
+      if (staging.isPipelined()) {
+        // async upload on the context's stream; whatever stream the
+        // next launch runs on will wait for 'uploadDone'
+        if (!records.uploadDone)
+          CUDA_CHECK(cudaEventCreateWithFlags(&records.uploadDone,
+                                              cudaEventDisableTiming));
+        if (size)
+          CUDA_CHECK(cudaMemcpyAsync(devicePtr,
+                                     records.hostMemory+begin,size,
+                                     cudaMemcpyHostToDevice,
+                                     context->stream));
+        CUDA_CHECK(cudaEventRecord(records.uploadDone,context->stream));
+      } else if (size) {
+        CUDA_CHECK(cudaMemcpy(devicePtr,records.hostMemory+begin,size,
+                              cudaMemcpyHostToDevice));
+      }
+      staging.commit(writing);
+      writing    = -1;
+      writingAll = true;
+    }
+
+    /*! return the records to use for a launch on the given stream
+        (swapping in the newest version if required) */
+    SBTRecords &SBTRecordsStaging::acquireForLaunch(cudaStream_t stream)
+    {
+      launched = staging.acquireForLaunch();
+      SBTRecords &records = slot[launched];
+      if (staging.isPipelined() && records.uploadDone)
+        CUDA_CHECK(cudaStreamWaitEvent(stream,records.uploadDone,0));
+      return records;
+    }
+
+    /*! mark the launch that was just issued on given stream as using
+        the slot returned by the last acquireForLaunch() */
+    void SBTRecordsStaging::launchIssued(cudaStream_t stream)
+    {
+      if (launched < 0) return;
+      if (staging.isPipelined()) {
+        SBTRecords &records = slot[launched];
+        // launches on the same stream complete in order, so each
+        // stream only needs its latest launch recorded
+        cudaEvent_t event = nullptr;
+        for (auto &launchDone : records.launchesDone)
+          if (launchDone.stream == stream)
+            event = launchDone.event;
+        if (!event) {
+          CUDA_CHECK(cudaEventCreateWithFlags(&event,
+                                              cudaEventDisableTiming));
+          records.launchesDone.push_back({stream,event});
+        }
+        CUDA_CHECK(cudaEventRecord(event,stream));
+      }
+      launched = -1;
+    }
+
+    /*! queries the given optix limit, lowered to the value of the
+        given environment variable if that is set (and smaller) */
+    static uint32_t queryAccelLimit(OptixDeviceContext optixContext,
+                                    OptixDeviceProperty property,
+                                    const char *envVar)
+    {
+      uint32_t limit = 0;
+      OPTIX_CHECK(optixDeviceContextGetProperty(optixContext,property,
+                                                &limit,sizeof(limit)));
+      if (const char *fromEnv = getenv(envVar)) {
+        const long override = atol(fromEnv);
+        if (override > 0 && uint64_t(override) < limit)
+          limit = uint32_t(override);
+      }
+      return limit;
+    }
+
     /*! Construct a new owl device on given cuda device. Throws an
       exception if for any reason that cannot be done */
     Context::Context(int owlDeviceID,
@@ -153,6 +334,15 @@ namespace owl {
       OPTIX_CHECK(optixDeviceContextSetLogCallback
                   (optixContext,context_log_cb,this,4));
 
+      maxPrimsPerGAS
+        = queryAccelLimit(optixContext,
+                          OPTIX_DEVICE_PROPERTY_LIMIT_MAX_PRIMITIVES_PER_GAS,
+                          "OWL_MAX_PRIMS_PER_GAS");
+      maxInstsPerIAS
+        = queryAccelLimit(optixContext,
+                          OPTIX_DEVICE_PROPERTY_LIMIT_MAX_INSTANCES_PER_IAS,
+                          "OWL_MAX_INSTANCES_PER_IAS");
+
       configurePipelineOptions();
     }
 
@@ -170,6 +360,18 @@ namespace owl {
       context->configurePipelineOptions();
     }
 
+    void Device::setGroupSplitting(bool enabled)
+    {
+      context->splitOversizedGroups = enabled;
+    }
+
+    void Device::setBuildStatsCallback(LLOBuildStatsCB callback,
+                                       void *userData)
+    {
+      context->buildStatsCallback = callback;
+      context->buildStatsUserData = userData;
+    }
+
     /*! sets the pipelineCompileOptions etc. based on
       maxConfiguredInstanceDepth */
     void Context::configurePipelineOptions()
@@ -827,12 +1029,12 @@ namespace owl {
       for (auto &pg : device->rayGenPGs)
         allPGs.push_back(pg.pg);
       if (device->geomTypes.empty())
-        CLOG("warning: no geometry types defined");
+        CLOG_WARNING("warning: no geometry types defined");
       for (auto &geomType : device->geomTypes)
         for (auto &pg : geomType.perRayType)
           allPGs.push_back(pg.pg);
       if (device->missProgPGs.empty())
-        CLOG("warning: no miss programs defined");
+        CLOG_WARNING("warning: no miss programs defined");
       for (auto &pg : device->missProgPGs)
         allPGs.push_back(pg.pg);
 
@@ -905,17 +1107,63 @@ namespace owl {
       // context->pushActive();
       DeviceBuffer *buffer = new DeviceBuffer(elementCount,elementSize);
       if (initData) {
-        buffer->devMem.upload(initData,"createDeviceBuffer: uploading initData");
+        buffer->devMem->upload(initData,"createDeviceBuffer: uploading initData");
+        OWL_COUNTER_ADD("owl_buffer_uploads_total",1);
+        OWL_COUNTER_ADD("owl_buffer_upload_bytes_total",
+                        elementCount*elementSize);
         // LOG("uploading " << elementCount
         //     << " items of size " << elementSize
         //     << " from host ptr " << initData
-        //     << " to device ptr " << buffer->devMem.get());
+        //     << " to device ptr " << buffer->devMem->get());
       }
       assert("check buffer properly created" && buffer != nullptr);
       buffers[bufferID] = buffer;
       // context->popActive();
       STACK_POP_ACTIVE();
     }
+
+    /*! same as deviceBufferCreate, but first checks if there already
+        is an allocation with the same contents (identified by size
+        and contentHash) that the new buffer can share */
+    void Device::deviceBufferCreateDeduped(int bufferID,
+                                           size_t elementCount,
+                                           size_t elementSize,
+                                           const void *initData,
+                                           uint64_t contentHash)
+    {
+      assert("check valid buffer ID" && bufferID >= 0);
+      assert("check valid buffer ID" && bufferID <  buffers.size());
+      assert("check buffer ID available" && buffers[bufferID] == nullptr);
+      assert(initData);
+      const size_t numBytes = elementCount*elementSize;
+      // hash and size only find candidates; only share an allocation
+      // that really holds the same bytes
+      context->pushActive();
+      std::shared_ptr<DeviceMemory> existing
+        = bufferDedupTable.find(contentHash,numBytes,
+                                [&](DeviceMemory &candidate) {
+                                  std::vector<uint8_t> contents(numBytes);
+                                  candidate.download(contents.data());
+                                  return memcmp(contents.data(),initData,
+                                                numBytes) == 0;
+                                });
+      context->popActive();
+      if (existing) {
+        buffers[bufferID]
+          = new DeviceBuffer(elementCount,elementSize,existing);
+        OWL_COUNTER_ADD("owl_buffer_dedup_bytes_saved_total",numBytes);
+        LOG_DEBUG("deduplicated buffer #" << bufferID << " ("
+            << prettyNumber(numBytes) << "B, "
+            << prettyNumber(bufferDedupTable.bytesSaved)
+            << "B saved so far)");
+        return;
+      }
+
+      deviceBufferCreate(bufferID,elementCount,elementSize,initData);
+      DeviceBuffer *buffer = (DeviceBuffer *)buffers[bufferID];
+      buffer->dedupShared = true;
+      bufferDedupTable.insert(contentHash,numBytes,buffer->devMem);
+    }
     
       /*! create a managed memory buffer */
     void Device::managedMemoryBufferCreate(int bufferID,
@@ -993,9 +1241,11 @@ namespace owl {
         = checkGetBuffer(bufferID);
       assert("double-check valid buffer" && buffer);
 
-      triangles->vertexPointer = addPointerOffset(buffer->get(),offset);
-      triangles->vertexStride  = stride;
-      triangles->vertexCount   = count;
+      triangles->vertexPointer  = addPointerOffset(buffer->get(),offset);
+      triangles->vertexStride   = stride;
+      triangles->vertexCount    = count;
+      triangles->vertexBufferID = bufferID;
+      triangles->vertexOffset   = offset;
     }
 
     /*! returns the given buffers device pointer */
@@ -1014,14 +1264,40 @@ namespace owl {
       
     void Device::bufferResize(int bufferID, size_t newItemCount)
     {
-      checkGetBuffer(bufferID)->resize(this,newItemCount);
+      Buffer *buffer = checkGetBuffer(bufferID);
+      const void *oldPointer = buffer->get();
+      buffer->resize(this,newItemCount);
+      if (buffer->get() != oldPointer)
+        updateBufferReferences(bufferID);
     }
     
     void Device::bufferUpload(int bufferID, const void *hostPtr)
     {
-      checkGetBuffer(bufferID)->upload(this,hostPtr);
+      Buffer *buffer = checkGetBuffer(bufferID);
+      const void *oldPointer = buffer->get();
+      buffer->upload(this,hostPtr);
+      if (buffer->get() != oldPointer)
+        updateBufferReferences(bufferID);
+      OWL_COUNTER_ADD("owl_buffer_uploads_total",1);
+      OWL_COUNTER_ADD("owl_buffer_upload_bytes_total",
+                      buffer->elementCount*buffer->elementSize);
     }
 
+
+    void Device::updateBufferReferences(int bufferID)
+    {
+      Buffer *buffer = checkGetBuffer(bufferID);
+      for (auto geom : geoms) {
+        TrianglesGeom *triangles = dynamic_cast<TrianglesGeom*>(geom);
+        if (!triangles) continue;
+        if (triangles->vertexBufferID == bufferID)
+          triangles->vertexPointer
+            = addPointerOffset(buffer->get(),triangles->vertexOffset);
+        if (triangles->indexBufferID == bufferID)
+          triangles->indexPointer
+            = addPointerOffset(buffer->get(),triangles->indexOffset);
+      }
+    }
     
     void Device::trianglesGeomSetIndexBuffer(int geomID,
                                              int bufferID,
@@ -1037,16 +1313,159 @@ namespace owl {
         = checkGetBuffer(bufferID);
       assert("double-check valid buffer" && buffer);
 
-      triangles->indexPointer = addPointerOffset(buffer->get(),offset);
-      triangles->indexCount   = count;
-      triangles->indexStride  = stride;
+      triangles->indexPointer  = addPointerOffset(buffer->get(),offset);
+      triangles->indexCount    = count;
+      triangles->indexStride   = stride;
+      triangles->indexBufferID = bufferID;
+      triangles->indexOffset   = offset;
+    }
+    
+    /*! helper for validateGroupGraph: 'validated' remembers the
+        smallest depth each group was already validated at (in- and
+        outside of flattened subtrees), so shared subtrees only get
+        walked once. Everything below a flattened group
+        ('inFlattened') ends up in a single, one-level IAS, so nested
+        instance groups there do not add to the instancing depth, no
+        matter how deep they are nested */
+    static void validateSubtree(Group *group,
+                                int instancingDepth,
+                                int maxInstancingDepth,
+                                bool inFlattened,
+                                const std::vector<Geom *> &geoms,
+                                const std::set<Group *> &liveGroups,
+                                std::map<std::pair<Group *,bool>,int> &validated)
+    {
+      const std::pair<Group *,bool> key(group,inFlattened);
+      auto it = validated.find(key);
+      if (it != validated.end() && it->second <= instancingDepth)
+        return;
+      validated[key] = instancingDepth;
+      
+      if (group->containsGeom()) {
+        GeomGroup *gg = (GeomGroup *)group;
+        for (auto geom : gg->children) {
+          if (!geom) continue;
+          OWL_VALIDATE(geom->geomID < geoms.size() && geoms[geom->geomID] == geom,
+                       "geom group references a geom that was already destroyed");
+        }
+        return;
+      }
+
+      // note this check (and 'validated', for flattened subtrees)
+      // also guarantees that we terminate on cyclic graphs
+      OWL_VALIDATE(instancingDepth < maxInstancingDepth,
+                   "node graph exceeds the configured max instancing depth of "
+                   +std::to_string(maxInstancingDepth)
+                   +" (see owlSetMaxInstancingDepth())");
+      InstanceGroup *ig = (InstanceGroup *)group;
+      const bool flattened = inFlattened || ig->flatten;
+      for (auto child : ig->children) {
+        OWL_VALIDATE(child != nullptr,
+                     "instance group has a child that was never set");
+        OWL_VALIDATE(liveGroups.find(child) != liveGroups.end(),
+                     "instance group references a group that was already destroyed");
+        // geom groups below a flattened group end up one level below
+        // it; instance groups in between don't count
+        const int childDepth
+          = (flattened && child->containsInstances())
+          ? instancingDepth
+          : instancingDepth+1;
+        validateSubtree(child,childDepth,maxInstancingDepth,flattened,
+                        geoms,liveGroups,validated);
+      }
+    }
+    
+    /*! (only called if validation is enabled) checks that the
+        subtree under the given group does not reference any destroyed
+        geoms or groups, and that its instancing depth does not exceed
+        the configured maxInstancingDepth */
+    void Device::validateGroupGraph(Group *group)
+    {
+      std::set<Group *> liveGroups(groups.begin(),groups.end());
+      std::map<std::pair<Group *,bool>,int> validated;
+      validateSubtree(group,0,context->maxInstancingDepth,/*inFlattened*/false,
+                      geoms,liveGroups,validated);
     }
     
+    AccelBuildTimer::AccelBuildTimer(Context *context)
+      : stats(context->buildStats)
+    {
+      if (!stats) return;
+      CUDA_CALL(EventCreate(&begin));
+      CUDA_CALL(EventCreate(&end));
+      // the builders all use the default stream
+      CUDA_CALL(EventRecord(begin,0));
+    }
+
+    AccelBuildTimer::~AccelBuildTimer()
+    {
+      if (begin) cudaEventDestroy(begin);
+      if (end)   cudaEventDestroy(end);
+    }
+
+    void AccelBuildTimer::stop()
+    {
+      if (!stats) return;
+      CUDA_CALL(EventRecord(end,0));
+      CUDA_CALL(EventSynchronize(end));
+      float ms = 0.f;
+      CUDA_CALL(EventElapsedTime(&ms,begin,end));
+      stats->deviceBuildSeconds += ms * 1e-3;
+    }
+
     void Device::groupBuildAccel(int groupID)
     {
       Group *group = checkGetGroup(groupID);
+      if (OWL_VALIDATION_ACTIVE())
+        validateGroupGraph(group);
       group->destroyAccel(context);
-      group->buildAccel(context);
+
+      // only collect build stats if somebody is going to look at them
+      if (!context->buildStatsCallback && !OWL_LOG_ENABLED(LEVEL_DEBUG)) {
+        group->buildAccel(context);
+        return;
+      }
+
+      BuildStats stats;
+      stats.groupID  = groupID;
+      stats.deviceID = context->owlDeviceID;
+      stats.kind
+        = dynamic_cast<InstanceGroup *>(group)
+        ? BuildStats::KIND_INSTANCE
+        : (dynamic_cast<UserGeomGroup *>(group)
+           ? BuildStats::KIND_USER
+           : BuildStats::KIND_TRIANGLES);
+      context->buildStats = &stats;
+      const double t0 = getCurrentTime();
+      try {
+        group->buildAccel(context);
+      } catch (...) {
+        context->buildStats = nullptr;
+        throw;
+      }
+      stats.hostBuildSeconds = getCurrentTime() - t0;
+      context->buildStats = nullptr;
+
+      LOG_DEBUG("built " << stats.toText());
+      if (!context->buildStatsCallback)
+        return;
+      static_assert((int)BuildStats::KIND_INSTANCE == (int)LLO_BUILD_KIND_INSTANCE,
+                    "build kinds have to match LLOBuildKind");
+      LLOBuildStats s;
+      s.groupID              = stats.groupID;
+      s.deviceID             = stats.deviceID;
+      s.kind                 = stats.kind;
+      s.numPrimitives        = stats.numPrimitives;
+      s.numBuildInputs       = stats.numBuildInputs;
+      s.numAccels            = stats.numAccels;
+      s.boundsSizeInBytes    = stats.boundsSizeInBytes;
+      s.tempSizeInBytes      = stats.tempSizeInBytes;
+      s.outputSizeInBytes    = stats.outputSizeInBytes;
+      s.compactedSizeInBytes = stats.compactedSizeInBytes;
+      s.compactionRatio      = stats.compactionRatio();
+      s.hostBuildSeconds     = stats.hostBuildSeconds;
+      s.deviceBuildSeconds   = stats.deviceBuildSeconds;
+      context->buildStatsCallback(&s,context->buildStatsUserData);
     }
 
     /*! return given group's current traversable. note this function
@@ -1062,6 +1481,29 @@ namespace owl {
       Group *group = checkGetGroup(groupID);
       return group->getSBTOffset();
     }
+
+    size_t Device::groupGetAccelMemory(int groupID)
+    {
+      Group *group = checkGetGroup(groupID);
+      size_t size = group->bvhMemory.size() + group->splitInstanceBuffer.size();
+      for (auto &part : group->splitParts)
+        size += part.instanceBuffer.size() + part.bvhMemory.size();
+      if (InstanceGroup *ig = dynamic_cast<InstanceGroup *>(group))
+        size
+          += ig->optixInstanceBuffer.size()
+          +  ig->outputBuffer.size()
+          +  ig->bakedVertices.size()
+          +  ig->bakedIndices.size()
+          +  ig->bakedSbtIndices.size()
+          +  ig->bakedBvhMemory.size();
+      if (TrianglesGeomGroup *tg = dynamic_cast<TrianglesGeomGroup *>(group))
+        for (auto &merged : tg->mergedMeshes)
+          size
+            += merged.vertices.size()
+            +  merged.indices.size()
+            +  merged.sbtIndexOffsets.size();
+      return size;
+    }
     
     
 
@@ -1089,44 +1531,66 @@ namespace owl {
 
 
 
+    /*! where in a hit group record's program data the geom's prim
+        base (see GeomGroup::childPrimBase) goes: right after the
+        geom type's own data, 4-byte aligned. Has to match
+        owl::getPrimitiveIndexInGeom() in owl_device.h */
+    static size_t primBaseOffset(size_t hitProgDataSize)
+    {
+      return smallestMultipleOf<sizeof(uint32_t)>(hitProgDataSize);
+    }
+
+    /*! whether hit group records carry the geoms' prim bases, which
+        they only do if any triangles group merges meshes - the extra
+        four bytes can grow every record by a whole SBT alignment */
+    bool Device::hitRecordsHavePrimBase() const
+    {
+      for (auto group : groups) {
+        TrianglesGeomGroup *tgg = dynamic_cast<TrianglesGeomGroup *>(group);
+        if (tgg && tgg->maxMergedMeshTriangles > 0)
+          return true;
+      }
+      return false;
+    }
+
     void Device::sbtHitProgsBuild(LLOWriteHitProgDataCB writeHitProgDataCB,
                                   const void *callBackUserData)
     {
-      LOG("building SBT hit group records");
+      LOG_DEBUG("building SBT hit group records");
       context->pushActive();
-      // TODO: move this to explicit destroyhitgroups
-      if (sbt.hitGroupRecordsBuffer.alloced())
-        sbt.hitGroupRecordsBuffer.free();
 
+      // (with mesh merging, each record's data also holds the geom's
+      // prim base)
+      const bool withPrimBase = hitRecordsHavePrimBase();
       size_t maxHitProgDataSize = 0;
       for (int geomID=0;geomID<geoms.size();geomID++) {
         Geom *geom = geoms[geomID];
         if (!geom) continue;
         GeomType &gt = geomTypes[geom->geomTypeID];
-        maxHitProgDataSize = std::max(maxHitProgDataSize,gt.hitProgDataSize);
+        if (gt.hitProgDataSize == size_t(-1))
+          throw std::runtime_error("in sbtHitProgsBuild: at least on geometry uses a type for which geomTypeCreate has not been called");
+        maxHitProgDataSize
+          = std::max(maxHitProgDataSize,
+                     withPrimBase
+                     ? primBaseOffset(gt.hitProgDataSize)+sizeof(uint32_t)
+                     : gt.hitProgDataSize);
       }
-      
-      if (maxHitProgDataSize == size_t(-1))
-        throw std::runtime_error("in sbtHitProgsBuild: at least on geometry uses a type for which geomTypeCreate has not been called");
-      assert("make sure all geoms had their program size set"
-             && maxHitProgDataSize != (size_t)-1);
+
       size_t numHitGroupEntries = sbt.rangeAllocator.maxAllocedID;
       size_t numHitGroupRecords = numHitGroupEntries*context->numRayTypes;
       size_t hitGroupRecordSize
         = OPTIX_SBT_RECORD_HEADER_SIZE
         + smallestMultipleOf<OPTIX_SBT_RECORD_ALIGNMENT>(maxHitProgDataSize);
       assert((OPTIX_SBT_RECORD_HEADER_SIZE % OPTIX_SBT_RECORD_ALIGNMENT) == 0);
-      sbt.hitGroupRecordSize = hitGroupRecordSize;
-      sbt.hitGroupRecordCount = numHitGroupRecords;
-
-      size_t totalHitGroupRecordsArraySize
-        = numHitGroupRecords * hitGroupRecordSize;
-      std::vector<uint8_t> hitGroupRecords(totalHitGroupRecordsArraySize);
+      SBTRecords &hitGroupRecords
+        = sbt.hitGroups.beginWrite(context,numHitGroupRecords,hitGroupRecordSize);
 
       // ------------------------------------------------------------------
       // now, write all records (only on the host so far): we need to
       // write one record per geometry, per ray type
       // ------------------------------------------------------------------
+      {
+      OWL_PERF_SCOPE(PHASE_VARIABLE_WRITES);
       for (auto group : groups) {
         if (!group) continue;
         if (!group->containsGeom()) continue;
@@ -1137,6 +1601,8 @@ namespace owl {
           if (!geom) continue;
           
           const int geomID    = geom->geomID;
+          OWL_VALIDATE(geomID < geoms.size() && geoms[geomID] == geom,
+                       "geom group references a geom that was already destroyed");
           for (int rayTypeID=0;rayTypeID<context->numRayTypes;rayTypeID++) {
             // ------------------------------------------------------------------
             // compute pointer to entire record:
@@ -1145,7 +1611,7 @@ namespace owl {
               = (sbtOffset+childID)*context->numRayTypes + rayTypeID;
             assert(recordID < numHitGroupRecords);
             uint8_t *const sbtRecord
-              = hitGroupRecords.data() + recordID*hitGroupRecordSize;
+              = hitGroupRecords.hostMemory + recordID*hitGroupRecordSize;
 
             // ------------------------------------------------------------------
             // pack record header with the corresponding hit group:
@@ -1172,82 +1638,135 @@ namespace owl {
                                geomID,
                                rayTypeID,
                                callBackUserData);
+            if (withPrimBase) {
+              const uint32_t primBase
+                = gg->childPrimBase.empty() ? 0 : gg->childPrimBase[childID];
+              memcpy(sbtRecordData+primBaseOffset(geomType.hitProgDataSize),
+                     &primBase,sizeof(primBase));
+            }
           }
         }
       }
-      sbt.hitGroupRecordsBuffer.alloc(hitGroupRecords.size());
-      sbt.hitGroupRecordsBuffer.upload(hitGroupRecords);
+      }
+      sbt.hitGroups.endWrite(context);
+      OWL_COUNTER_ADD("owl_sbt_records_written_total{kind=\"hitgroup\"}",
+                      numHitGroupRecords);
+      OWL_COUNTER_ADD("owl_sbt_bytes_written_total{kind=\"hitgroup\"}",
+                      numHitGroupRecords*hitGroupRecordSize);
       context->popActive();
-      LOG_OK("done building (and uploading) SBT hit group records");
+      LOG_DEBUG("done building (and uploading) SBT hit group records");
     }
       
-    void Device::sbtRayGensBuild(LLOWriteRayGenDataCB writeRayGenDataCB,
-                                 const void *callBackUserData)
+    /*! size of one ray gen record: all records are as large as the
+        one with the largest program data */
+    size_t Device::rayGenRecordSize() const
     {
-      static size_t numTimesCalled = 0;
-      ++numTimesCalled;
-      
-      if (numTimesCalled < 10)
-        LOG("building SBT ray gen records (only showing first 10 instances)");
-      context->pushActive();
-      // TODO: move this to explicit destroyhitgroups
-      if (sbt.rayGenRecordsBuffer.alloced())
-        sbt.rayGenRecordsBuffer.free();
-
       size_t maxRayGenDataSize = 0;
       for (int rgID=0;rgID<(int)rayGenPGs.size();rgID++) 
         maxRayGenDataSize = std::max(maxRayGenDataSize,
                                      rayGenPGs[rgID].program.dataSize);
-      size_t numRayGenRecords = rayGenPGs.size();
-      size_t rayGenRecordSize
-        = OPTIX_SBT_RECORD_HEADER_SIZE
-        + smallestMultipleOf<OPTIX_SBT_RECORD_ALIGNMENT>(maxRayGenDataSize);
-      sbt.rayGenRecordSize = rayGenRecordSize;
-      sbt.rayGenRecordCount = numRayGenRecords;
       assert((OPTIX_SBT_RECORD_HEADER_SIZE % OPTIX_SBT_RECORD_ALIGNMENT) == 0);
-      size_t totalRayGenRecordsArraySize
-        = numRayGenRecords * rayGenRecordSize;
-      std::vector<uint8_t> rayGenRecords(totalRayGenRecordsArraySize);
+      return OPTIX_SBT_RECORD_HEADER_SIZE
+        + smallestMultipleOf<OPTIX_SBT_RECORD_ALIGNMENT>(maxRayGenDataSize);
+    }
 
+    /*! writes (on the host) the record of ray gen 'rgID' to the
+        given memory */
+    void Device::writeRayGenRecord(uint8_t *sbtRecord,
+                                   int rgID,
+                                   LLOWriteRayGenDataCB writeRayGenDataCB,
+                                   const void *callBackUserData)
+    {
       // ------------------------------------------------------------------
-      // now, write all records (only on the host so far): we need to
-      // write one record per geometry, per ray type
+      // pack record header with the corresponding hit group:
       // ------------------------------------------------------------------
-      for (int rgID=0;rgID<(int)rayGenPGs.size();rgID++) {
-        // ------------------------------------------------------------------
-        // compute pointer to entire record:
-        // ------------------------------------------------------------------
-        const int recordID = rgID;
-        uint8_t *const sbtRecord
-          = rayGenRecords.data() + recordID*rayGenRecordSize;
-        
-        // ------------------------------------------------------------------
-        // pack record header with the corresponding hit group:
-        // ------------------------------------------------------------------
-        // first, compute pointer to record:
-        char    *const sbtRecordHeader = (char *)sbtRecord;
-        // ... find the PG that goes into the record header...
-        const RayGenPG &rgPG
-          = rayGenPGs[rgID];
-        // ... and tell optix to write that into the record
-        OPTIX_CALL(SbtRecordPackHeader(rgPG.pg,sbtRecordHeader));
+      // first, compute pointer to record:
+      char    *const sbtRecordHeader = (char *)sbtRecord;
+      // ... find the PG that goes into the record header...
+      const RayGenPG &rgPG
+        = rayGenPGs[rgID];
+      // ... and tell optix to write that into the record
+      OPTIX_CALL(SbtRecordPackHeader(rgPG.pg,sbtRecordHeader));
           
-        // ------------------------------------------------------------------
-        // finally, let the user fill in the record's payload using
-        // the callback
-        // ------------------------------------------------------------------
-        uint8_t *const sbtRecordData
-          = sbtRecord + OPTIX_SBT_RECORD_HEADER_SIZE;
-        writeRayGenDataCB(sbtRecordData,
-                          context->owlDeviceID,
-                          rgID,
-                          callBackUserData);
+      // ------------------------------------------------------------------
+      // finally, let the user fill in the record's payload using
+      // the callback
+      // ------------------------------------------------------------------
+      uint8_t *const sbtRecordData
+        = sbtRecord + OPTIX_SBT_RECORD_HEADER_SIZE;
+      writeRayGenDataCB(sbtRecordData,
+                        context->owlDeviceID,
+                        rgID,
+                        callBackUserData);
+    }
+      
+    void Device::sbtRayGensBuild(LLOWriteRayGenDataCB writeRayGenDataCB,
+                                 const void *callBackUserData)
+    {
+      LOG_DEBUG("building SBT ray gen records");
+      context->pushActive();
+
+      size_t numRayGenRecords = rayGenPGs.size();
+      size_t rayGenRecordSize = this->rayGenRecordSize();
+      SBTRecords &rayGenRecords
+        = sbt.rayGens.beginWrite(context,numRayGenRecords,rayGenRecordSize);
+
+      // ------------------------------------------------------------------
+      // now, write all records (only on the host so far): one per ray
+      // gen program, in ray gen ID order
+      // ------------------------------------------------------------------
+      {
+        OWL_PERF_SCOPE(PHASE_VARIABLE_WRITES);
+        for (int rgID=0;rgID<(int)rayGenPGs.size();rgID++) {
+          const int recordID = rgID;
+          writeRayGenRecord(rayGenRecords.hostMemory + recordID*rayGenRecordSize,
+                            rgID,writeRayGenDataCB,callBackUserData);
+        }
+      }
+      sbt.rayGens.endWrite(context);
+      OWL_COUNTER_ADD("owl_sbt_records_written_total{kind=\"raygen\"}",
+                      numRayGenRecords);
+      OWL_COUNTER_ADD("owl_sbt_bytes_written_total{kind=\"raygen\"}",
+                      numRayGenRecords*rayGenRecordSize);
+      context->popActive();
+      LOG_DEBUG("done building (and uploading) SBT ray gen records");
+    }
+
+    /*! re-writes (and re-uploads) only the SBT record of ray gen
+        'rgID'; falls back to building all ray gen records (calling
+        the callback for each of them) if they haven't been built
+        yet, or if their layout changed since */
+    void Device::sbtRayGenBuild(int rgID,
+                                LLOWriteRayGenDataCB writeRayGenDataCB,
+                                const void *callBackUserData)
+    {
+      assert("check valid ray gen program ID" && rgID >= 0);
+      assert("check valid ray gen program ID" && rgID <  rayGenPGs.size());
+      
+      const size_t rayGenRecordSize = this->rayGenRecordSize();
+      const bool layoutChanged
+        = !sbt.rayGens.alloced()
+        || sbt.rayGens.newest().recordCount != rayGenPGs.size()
+        || sbt.rayGens.newest().recordSize  != rayGenRecordSize;
+      if (layoutChanged) {
+        sbtRayGensBuild(writeRayGenDataCB,callBackUserData);
+        return;
+      }
+
+      context->pushActive();
+      SBTRecords &rayGenRecords = sbt.rayGens.beginUpdate(context);
+      uint8_t *const sbtRecord
+        = rayGenRecords.hostMemory + rgID*rayGenRecordSize;
+      memset(sbtRecord,0,rayGenRecordSize);
+      {
+        OWL_PERF_SCOPE(PHASE_VARIABLE_WRITES);
+        writeRayGenRecord(sbtRecord,rgID,writeRayGenDataCB,callBackUserData);
       }
-      sbt.rayGenRecordsBuffer.alloc(rayGenRecords.size());
-      sbt.rayGenRecordsBuffer.upload(rayGenRecords);
+      sbt.rayGens.endUpdate(context,rgID*rayGenRecordSize,rayGenRecordSize);
+      OWL_COUNTER_ADD("owl_sbt_records_written_total{kind=\"raygen\"}",1);
+      OWL_COUNTER_ADD("owl_sbt_bytes_written_total{kind=\"raygen\"}",
+                      rayGenRecordSize);
       context->popActive();
-      if (numTimesCalled < 10)
-        LOG_OK("done building (and uploading) SBT ray gen records (only showing first 10 instances)");
     }
       
     void Device::sbtMissProgsBuild(LLOWriteMissProgDataCB writeMissProgDataCB,
@@ -1255,14 +1774,11 @@ namespace owl {
     {
       if (missProgPGs.size() == 0) return;
       
-      LOG("building SBT miss prog records");
+      LOG_DEBUG("building SBT miss prog records");
       assert("check correct number of miss progs"
              && missProgPGs.size() == context->numRayTypes);
       
       context->pushActive();
-      // TODO: move this to explicit destroyhitgroups
-      if (sbt.missProgRecordsBuffer.alloced())
-        sbt.missProgRecordsBuffer.free();
 
       size_t maxMissProgDataSize = 0;
       for (int mpID=0;mpID<(int)missProgPGs.size();mpID++) {
@@ -1275,23 +1791,22 @@ namespace owl {
         = OPTIX_SBT_RECORD_HEADER_SIZE
         + smallestMultipleOf<OPTIX_SBT_RECORD_ALIGNMENT>(maxMissProgDataSize);
       assert((OPTIX_SBT_RECORD_HEADER_SIZE % OPTIX_SBT_RECORD_ALIGNMENT) == 0);
-      sbt.missProgRecordSize = missProgRecordSize;
-      sbt.missProgRecordCount = numMissProgRecords;
-      size_t totalMissProgRecordsArraySize
-        = numMissProgRecords * missProgRecordSize;
-      std::vector<uint8_t> missProgRecords(totalMissProgRecordsArraySize);
+      SBTRecords &missProgRecords
+        = sbt.missProgs.beginWrite(context,numMissProgRecords,missProgRecordSize);
 
       // ------------------------------------------------------------------
       // now, write all records (only on the host so far): we need to
       // write one record per geometry, per ray type
       // ------------------------------------------------------------------
+      {
+      OWL_PERF_SCOPE(PHASE_VARIABLE_WRITES);
       for (int mpID=0;mpID<(int)missProgPGs.size();mpID++) {
         // ------------------------------------------------------------------
         // compute pointer to entire record:
         // ------------------------------------------------------------------
         const int recordID = mpID;
         uint8_t *const sbtRecord
-          = missProgRecords.data() + recordID*missProgRecordSize;
+          = missProgRecords.hostMemory + recordID*missProgRecordSize;
         
         // ------------------------------------------------------------------
         // pack record header with the corresponding hit group:
@@ -1315,39 +1830,41 @@ namespace owl {
                             mpID,
                             callBackUserData);
       }
-      sbt.missProgRecordsBuffer.alloc(missProgRecords.size());
-      sbt.missProgRecordsBuffer.upload(missProgRecords);
+      }
+      sbt.missProgs.endWrite(context);
+      OWL_COUNTER_ADD("owl_sbt_records_written_total{kind=\"miss\"}",
+                      numMissProgRecords);
+      OWL_COUNTER_ADD("owl_sbt_bytes_written_total{kind=\"miss\"}",
+                      numMissProgRecords*missProgRecordSize);
       context->popActive();
-      LOG_OK("done building (and uploading) SBT miss prog records");
+      LOG_DEBUG("done building (and uploading) SBT miss prog records");
     }
 
-    void Device::launch(int rgID, const vec2i &dims)
+    /*! fill in the optix SBT for a launch of raygen 'rgID' on the
+        given stream */
+    void Device::prepareLaunchSBT(OptixShaderBindingTable &localSBT,
+                                  int rgID,
+                                  cudaStream_t stream)
     {
-      context->pushActive();
-      // LOG("launching ...");
-      assert("check valid launch dims" && dims.x > 0);
-      assert("check valid launch dims" && dims.y > 0);
       assert("check valid ray gen program ID" && rgID >= 0);
       assert("check valid ray gen program ID" && rgID <  rayGenPGs.size());
 
-      assert("check raygen records built" && sbt.rayGenRecordCount != 0);
-      OptixShaderBindingTable localSBT = {};
+      assert("check raygen records built" && sbt.rayGens.alloced());
+      SBTRecords &rayGenRecords = sbt.rayGens.acquireForLaunch(stream);
       localSBT.raygenRecord
-        = (CUdeviceptr)addPointerOffset(sbt.rayGenRecordsBuffer.get(),
-                                        rgID * sbt.rayGenRecordSize);
+        = (CUdeviceptr)addPointerOffset(rayGenRecords.deviceMemory.get(),
+                                        rgID * rayGenRecords.recordSize);
 
-      if (!sbt.missProgRecordsBuffer.alloced() &&
-          !sbt.hitGroupRecordsBuffer.alloced()) {
-        // apparently this program does not have any hit records *or*
+      if (!sbt.missProgs.alloced() &&
+          !sbt.hitGroups.alloced()) {
+        // Apparently this program does not have any hit records *or*
         // miss records, which means either something's horribly wrong
         // in the app, or this is more cuda-style "raygen-only" launch
         // (i.e., a launch of a raygen program that doesn't actually trace
-        // any rays. If the latter, let's "fake" a valid SBT by
+        // any rays). If the latter, let's "fake" a valid SBT by
         // writing in some (senseless) values to not trigger optix's
-        // own sanity checks
-#ifndef NDEBUG
+        // own sanity checks.
         static WarnOnce warn("launching an optix pipeline that has neither miss nor hitgroup programs set. This may be OK if you *only* have a raygen program, but is usually a sign of a bug - please double-check");
-#endif
         localSBT.missRecordBase
           = (CUdeviceptr)32;
         localSBT.missRecordStrideInBytes
@@ -1362,25 +1879,47 @@ namespace owl {
         localSBT.hitgroupRecordCount
           = 1;
       } else {
-        assert("check miss records built" && sbt.missProgRecordCount != 0);
+        assert("check miss records built" && sbt.missProgs.alloced());
+        SBTRecords &missProgRecords = sbt.missProgs.acquireForLaunch(stream);
         localSBT.missRecordBase
-          = (CUdeviceptr)sbt.missProgRecordsBuffer.get();
+          = (CUdeviceptr)missProgRecords.deviceMemory.get();
         localSBT.missRecordStrideInBytes
-          = (uint32_t)sbt.missProgRecordSize;
+          = (uint32_t)missProgRecords.recordSize;
         localSBT.missRecordCount
-          = (uint32_t)sbt.missProgRecordCount;
+          = (uint32_t)missProgRecords.recordCount;
 
-        assert("check hit records built" && sbt.hitGroupRecordCount != 0);
+        assert("check hit records built" && sbt.hitGroups.alloced());
+        SBTRecords &hitGroupRecords = sbt.hitGroups.acquireForLaunch(stream);
         localSBT.hitgroupRecordBase
-          = (CUdeviceptr)sbt.hitGroupRecordsBuffer.get();
+          = (CUdeviceptr)hitGroupRecords.deviceMemory.get();
         localSBT.hitgroupRecordStrideInBytes
-          = (uint32_t)sbt.hitGroupRecordSize;
+          = (uint32_t)hitGroupRecords.recordSize;
         localSBT.hitgroupRecordCount
-          = (uint32_t)sbt.hitGroupRecordCount;
+          = (uint32_t)hitGroupRecords.recordCount;
       }
+    }
+
+    /*! mark all SBT records used by the launch that was just issued
+        on given stream as in flight */
+    void Device::launchIssued(cudaStream_t stream)
+    {
+      sbt.rayGens.launchIssued(stream);
+      sbt.missProgs.launchIssued(stream);
+      sbt.hitGroups.launchIssued(stream);
+    }
+    
+    void Device::launch(int rgID, const vec2i &dims)
+    {
+      context->pushActive();
+      // LOG("launching ...");
+      assert("check valid launch dims" && dims.x > 0);
+      assert("check valid launch dims" && dims.y > 0);
+
+      OptixShaderBindingTable localSBT = {};
+      prepareLaunchSBT(localSBT,rgID,context->stream);
 
       if (!sbt.launchParamsBuffer.alloced()) {
-        LOG("creating dummy launch params buffer ...");
+        LOG_DEBUG("creating dummy launch params buffer ...");
         sbt.launchParamsBuffer.alloc(8);
       }
 
@@ -1392,6 +1931,7 @@ namespace owl {
                         &localSBT,
                         dims.x,dims.y,1
                         ));
+      launchIssued(context->stream);
 
       // cudaDeviceSynchronize();
       context->popActive();
@@ -1502,61 +2042,18 @@ namespace owl {
       
       // call the callback to generate the host-side copy of the
       // launch params struct
-      writeLaunchParamsCB(lp->hostMemory.data(),context->owlDeviceID,cbData);
+      {
+        OWL_PERF_SCOPE(PHASE_VARIABLE_WRITES);
+        writeLaunchParamsCB(lp->hostMemory.data(),context->owlDeviceID,cbData);
+      }
       
       lp->deviceMemory.uploadAsync(lp->hostMemory.data(),
                                    lp->stream);
       assert("check valid launch dims" && dims.x > 0);
       assert("check valid launch dims" && dims.y > 0);
-      assert("check valid ray gen program ID" && rgID >= 0);
-      assert("check valid ray gen program ID" && rgID <  rayGenPGs.size());
 
-      assert("check raygen records built" && sbt.rayGenRecordCount != 0);
       OptixShaderBindingTable localSBT = {};
-      localSBT.raygenRecord
-        = (CUdeviceptr)addPointerOffset(sbt.rayGenRecordsBuffer.get(),
-                                        rgID * sbt.rayGenRecordSize);
-
-      if (!sbt.missProgRecordsBuffer.alloced() &&
-          !sbt.hitGroupRecordsBuffer.alloced()) {
-        // Apparently this program does not have any hit records *or*
-        // miss records, which means either something's horribly wrong
-        // in the app, or this is more cuda-style "raygen-only" launch
-        // (i.e., a launch of a raygen program that doesn't actually trace
-        // any rays). If the latter, let's "fake" a valid SBT by
-        // writing in some (senseless) values to not trigger optix's
-        // own sanity checks.
-        static WarnOnce warn("launching an optix pipeline that has neither miss nor hitgroup programs set. This may be OK if you *only* have a raygen program, but is usually a sign of a bug - please double-check");
-        localSBT.missRecordBase
-          = (CUdeviceptr)32;
-        localSBT.missRecordStrideInBytes
-          = (uint32_t)32;
-        localSBT.missRecordCount
-          = 1;
-
-        localSBT.hitgroupRecordBase
-          = (CUdeviceptr)32;
-        localSBT.hitgroupRecordStrideInBytes
-          = (uint32_t)32;
-        localSBT.hitgroupRecordCount
-          = 1;
-      } else {
-        assert("check miss records built" && sbt.missProgRecordCount != 0);
-        localSBT.missRecordBase
-          = (CUdeviceptr)sbt.missProgRecordsBuffer.get();
-        localSBT.missRecordStrideInBytes
-          = (uint32_t)sbt.missProgRecordSize;
-        localSBT.missRecordCount
-          = (uint32_t)sbt.missProgRecordCount;
-
-        assert("check hit records built" && sbt.hitGroupRecordCount != 0);
-        localSBT.hitgroupRecordBase
-          = (CUdeviceptr)sbt.hitGroupRecordsBuffer.get();
-        localSBT.hitgroupRecordStrideInBytes
-          = (uint32_t)sbt.hitGroupRecordSize;
-        localSBT.hitgroupRecordCount
-          = (uint32_t)sbt.hitGroupRecordCount;
-      }
+      prepareLaunchSBT(localSBT,rgID,lp->stream);
 
       OPTIX_CALL(Launch(context->pipeline,
                         lp->stream,
@@ -1565,10 +2062,27 @@ namespace owl {
                         &localSBT,
                         dims.x,dims.y,1
                         ));
+      launchIssued(lp->stream);
       STACK_POP_ACTIVE();
     }
     
 
+    /*! enables or disables 'frame pipelining' (see Device.h) */
+    void Device::setFramePipelining(bool enabled)
+    {
+      STACK_PUSH_ACTIVE(context);
+      // whatever got launched so far did not record any events we
+      // could wait on, so make sure it's all done before we start
+      // tracking launches per slot
+      CUDA_CHECK(cudaDeviceSynchronize());
+      for (SBTRecordsStaging *part : { &sbt.rayGens, &sbt.hitGroups, &sbt.missProgs }) {
+        for (int slot=0;slot<FrameStaging::numSlots;slot++)
+          part->staging.retire(slot);
+        part->staging.setPipelined(enabled);
+      }
+      STACK_POP_ACTIVE();
+    }
+
     void Device::setRayTypeCount(size_t rayTypeCount)
     {
       // TODO: sanity check values, and that nothing has been created
@@ -21,6 +21,15 @@
 // for the hit group callback type, which is part of the API
 #include "owl/ll/DeviceGroup.h"
 #include "owl/ll/Buffers.h"
+#include "owl/ll/FrameStaging.h"
+#include "owl/ll/Validation.h"
+#include "owl/ll/Logging.h"
+#include "owl/ll/Metrics.h"
+#include "owl/ll/BuildStats.h"
+#include "owl/ll/BufferDedup.h"
+#include "owl/ll/TransformBaking.h"
+#include "owl/ll/HostAllocator.h"
+#include "owl/ll/PerfCounters.h"
 
 namespace owl {
   namespace ll {
@@ -44,15 +53,6 @@ namespace owl {
 
     struct Context {
 
-      static int logging()
-      {
-#ifdef NDEBUG
-        return false;
-#else
-        return true;
-#endif
-      }
-      
       Context(int owlDeviceID, int cudaDeviceID);
       ~Context();
       
@@ -101,6 +101,25 @@ namespace owl {
           `setMaxInstancingDepth` */
       int maxInstancingDepth = 1;      
       int numRayTypes { 1 };
+      /*! whether groups that exceed optix' per-accel limits get
+          automatically split (see GroupSplitting.h), or throw */
+      bool splitOversizedGroups = false;
+      /*! optix' MAX_PRIMITIVES_PER_GAS and MAX_INSTANCES_PER_IAS
+          limits, as queried on context creation. The
+          OWL_MAX_PRIMS_PER_GAS and OWL_MAX_INSTANCES_PER_IAS
+          environment variables can lower them (eg, to exercise group
+          splitting on small scenes) */
+      uint32_t maxPrimsPerGAS = 0;
+      uint32_t maxInstsPerIAS = 0;
+
+      /*! if set, gets called with the stats of each accel build (see
+          lloSetBuildStatsCallback) */
+      LLOBuildStatsCB buildStatsCallback = nullptr;
+      void           *buildStatsUserData = nullptr;
+      /*! stats of the group build currently in progress (if anybody
+          wants them), which the accel builders add to; null
+          otherwise */
+      BuildStats     *buildStats = nullptr;
     };
     
     struct Module {
@@ -153,7 +172,7 @@ namespace owl {
           host-side copy, too, so we can leave the launch2D call
           without having to first wait for the cudaMemcpy to
           complete */
-      std::vector<uint8_t> hostMemory;
+      HostVector<uint8_t,HostAllocator::SITE_LAUNCH> hostMemory;
       
       /*! the cuda device memory we copy the launch params to */
       DeviceMemory         deviceMemory;
@@ -182,18 +201,88 @@ namespace owl {
     };
     
     
-    struct SBT {
-      size_t rayGenRecordCount   = 0;
-      size_t rayGenRecordSize    = 0;
-      DeviceMemory rayGenRecordsBuffer;
+    /*! one copy of one kind of SBT records (eg, all hit group
+        records), plus the host-side staging memory we build them
+        in. Host memory is pinned so the upload can be async in
+        pipelined mode; both host and device memory are only
+        re-allocated if the required size changes */
+    struct SBTRecords {
+      ~SBTRecords();
+      
+      size_t       recordSize  = 0;
+      size_t       recordCount = 0;
+      DeviceMemory deviceMemory;
+      uint8_t     *hostMemory     = nullptr;
+      size_t       hostMemorySize = 0;
+      /*! recorded after the (async) upload of this slot */
+      cudaEvent_t  uploadDone = nullptr;
+      /*! one event per stream that launched with this slot,
+          recorded after the last such launch on that stream; the slot
+          can only get rewritten once all of them completed (launches
+          with different launch params run on different streams, so
+          a single event would only cover the latest one) */
+      struct LaunchDone {
+        cudaStream_t stream;
+        cudaEvent_t  event;
+      };
+      std::vector<LaunchDone> launchesDone;
+    };
 
-      size_t hitGroupRecordSize  = 0;
-      size_t hitGroupRecordCount = 0;
-      DeviceMemory hitGroupRecordsBuffer;
+    /*! a (possibly double-buffered) set of SBT records of one
+        kind. See FrameStaging for the logic of which slot gets
+        written and which gets launched */
+    struct SBTRecordsStaging {
+      /*! prepare the slot the next build writes to, waiting for any
+          launch that might still use it; returns the slot with its
+          (zero-initialized) host memory sized for the given number
+          of records */
+      SBTRecords &beginWrite(Context *context,
+                             size_t recordCount,
+                             size_t recordSize);
+      /*! upload the slot returned by the last beginWrite(), and make
+          it the newest version */
+      void endWrite(Context *context);
 
-      size_t missProgRecordSize  = 0;
-      size_t missProgRecordCount = 0;
-      DeviceMemory missProgRecordsBuffer;
+      /*! like beginWrite(), but for changing only some of the
+          records: the returned slot's host memory holds the newest
+          version of all records (same count and size), so the
+          caller only has to overwrite the ones that changed */
+      SBTRecords &beginUpdate(Context *context);
+      /*! upload bytes [begin,begin+size) of the slot returned by the
+          last beginUpdate(), and make it the newest version. If that
+          slot's device copy was not the newest version (which can
+          only happen with pipelining) all of it gets uploaded */
+      void endUpdate(Context *context, size_t begin, size_t size);
+
+      /*! return the records to use for a launch on the given stream
+          (swapping in the newest version if required) */
+      SBTRecords &acquireForLaunch(cudaStream_t stream);
+      /*! mark the launch that was just issued on given stream as
+          using the slot returned by the last acquireForLaunch() */
+      void launchIssued(cudaStream_t stream);
+
+      /*! whether these records have been built, and are not
+          empty */
+      bool alloced() const
+      { return staging.valid() && slot[staging.newestSlot()].recordCount != 0; }
+      /*! the slot holding the most recently built records */
+      const SBTRecords &newest() const { return slot[staging.newestSlot()]; }
+      
+      FrameStaging staging;
+      SBTRecords   slot[FrameStaging::numSlots];
+      /*! slot currently being written, if any */
+      int          writing  = -1;
+      /*! whether the slot being written has to be uploaded in full,
+          even for an endUpdate() */
+      bool         writingAll = true;
+      /*! slot handed out by the last acquireForLaunch(), if any */
+      int          launched = -1;
+    };
+    
+    struct SBT {
+      SBTRecordsStaging rayGens;
+      SBTRecordsStaging hitGroups;
+      SBTRecordsStaging missProgs;
 
       DeviceMemory launchParamsBuffer;
       
@@ -252,6 +341,30 @@ namespace owl {
       void  *indexPointer  = nullptr;
       size_t indexStride   = 0;
       size_t indexCount    = 0;
+      /*! the buffers (and byte offsets into them) the two pointers
+          above got derived from, so they can be updated if one of
+          those buffers gets a new address (see
+          Device::updateBufferReferences) */
+      int    vertexBufferID = -1;
+      size_t vertexOffset   = 0;
+      int    indexBufferID  = -1;
+      size_t indexOffset    = 0;
+
+      /*! downloads this geom's vertex/index arrays into the given
+          staging vectors, and returns a host view of them */
+      MeshView download(std::vector<uint8_t> &vertexStaging,
+                        std::vector<uint8_t> &indexStaging) const;
+    };
+    
+    /*! the accel for one part of a group that exceeded optix'
+        limits, and got split */
+    struct SubAccel {
+      DeviceMemory           instanceBuffer;
+      DeviceMemory           bvhMemory;
+      OptixTraversableHandle traversable = 0;
+      /*! sbt offset an instance of this part has to use (only
+          matters for parts of geom groups) */
+      uint32_t               sbtOffset   = 0;
     };
     
     struct Group {
@@ -271,7 +384,58 @@ namespace owl {
         a geom/group that is still being refrerenced by a
         group. */
       int numTimesReferenced = 0;
+
+      /*! only used if this group exceeded optix' per-accel limits,
+          and got split into several parts: the accels of those
+          parts; 'traversable' is then an instance accel over them.
+          Instance groups that have a split geom group as a child
+          instance its parts directly, rather than this accel (see
+          InstanceGroup::instanceSplitParts) */
+      std::vector<SubAccel> splitParts;
+      DeviceMemory          splitInstanceBuffer;
+      void buildOverSplitParts(Context *context,
+                               const std::vector<uint32_t> &partSBTOffsets);
+      void destroySplitParts();
     };
+    
+    /*! host-side arrays of optix instances (and of the groups they
+        refer to) for instance accel builds; these come from
+        HostAllocator, so steady-state rebuilds can be checked to not
+        allocate */
+    typedef HostVector<OptixInstance,HostAllocator::SITE_ACCEL> OptixInstanceArray;
+    typedef HostVector<Group *,HostAllocator::SITE_ACCEL>       GroupPtrArray;
+    
+    /*! builds an instance accel over the given optix instances */
+    void buildInstanceAccel(Context *context,
+                            const OptixInstanceArray &optixInstances,
+                            DeviceMemory &optixInstanceBuffer,
+                            DeviceMemory &bvhMemory,
+                            OptixTraversableHandle &traversable);
+    
+    /*! builds (and compacts) a triangles accel over the given build
+        inputs */
+    void buildTrianglesAccel(Context *context,
+                             std::vector<OptixBuildInput> &triangleInputs,
+                             DeviceMemory &bvhMemory,
+                             OptixTraversableHandle &traversable,
+                             uint32_t extraBuildFlags);
+
+    /*! measures how long the optix build (and compaction) calls
+        between construction and stop() take on the device, and
+        accounts for that in the context's current build stats. Does
+        nothing if nobody asked for build stats */
+    struct AccelBuildTimer {
+      AccelBuildTimer(Context *context);
+      ~AccelBuildTimer();
+      /*! call after the last of the calls to measure; waits for
+          them to finish */
+      void stop();
+    private:
+      BuildStats *stats;
+      cudaEvent_t begin = nullptr;
+      cudaEvent_t end   = nullptr;
+    };
+    
     struct InstanceGroup : public Group {
       InstanceGroup(size_t numChildren)
         : children(numChildren)
@@ -286,6 +450,84 @@ namespace owl {
       DeviceMemory outputBuffer;
       std::vector<Group *>  children;
       std::vector<affine3f> transforms;
+      /*! per-child visibility masks, optix instance flags, and
+          instance IDs; each may be empty, meaning 'all 255', 'no
+          flags', and 'the child index', respectively */
+      std::vector<uint8_t>  visibilityMasks;
+      std::vector<uint32_t> instanceFlags;
+      std::vector<uint32_t> instanceIDs;
+
+      /*! if enabled, nested instance groups below this group get
+          flattened on the host, and the IAS we build is a single
+          level over all the geom groups in this subtree (see
+          InstanceFlattening.h) */
+      bool   flatten = false;
+      /*! max number of instances that flattening may expand to
+          before we give up (and throw) */
+      size_t maxFlattenedInstances = 0;
+
+      /*! if enabled, the instances get uploaded in morton order of
+          their origins rather than in child order (see
+          MortonSort.h); their instance IDs stay the same */
+      bool   spatialSort = false;
+      /*! if spatially sorted, the permutation the last build used:
+          slot 'i' of the uploaded instance buffer holds what would
+          have been instance 'instanceOrder[i]' without sorting (but
+          after baking, if enabled) */
+      std::vector<uint32_t> instanceOrder;
+
+      /*! scratch arrays of buildAccel; kept around (and only ever
+          re-assigned) so rebuilding a group whose child count did
+          not grow does not allocate */
+      OptixInstanceArray scratchInstances;
+      GroupPtrArray      scratchInstanceGroups;
+
+      /*! transform baking (see TransformBaking.h): instances of
+          triangle geom groups with at most maxBakedTriangles
+          triangles, that get instanced at most maxBakedInstances
+          times, get replaced with world-space copies of their
+          triangles, as long as those fit into bakingMemoryBudget
+          bytes; maxBakedTriangles == 0 disables baking */
+      size_t maxBakedTriangles  = 0;
+      size_t maxBakedInstances  = 0;
+      size_t bakingMemoryBudget = 0;
+      /*! stats of the last build's baking pass */
+      TransformBakingStats bakingStats;
+      /*! the baked geometry (and its accel) of the last build */
+      DeviceMemory           bakedVertices;
+      DeviceMemory           bakedIndices;
+      DeviceMemory           bakedSbtIndices;
+      DeviceMemory           bakedBvhMemory;
+      OptixTraversableHandle bakedTraversable = 0;
+
+      /*! replaces all bakeable instances among the given ones with a
+          single instance of a (newly built) world-space triangles
+          accel; instanceGroups[i] is the group instance 'i' refers
+          to */
+      void bakeTransforms(Context *context,
+                          OptixInstanceArray &optixInstances,
+                          const GroupPtrArray &instanceGroups);
+      /*! frees the baked geometry of the last build, if any */
+      void destroyBakedGeometry();
+      /*! reorders the given instances in morton order of their
+          origins, and remembers the permutation in instanceOrder */
+      void sortInstances(Context *context,
+                         OptixInstanceArray &optixInstances);
+      /*! replaces each of the given instances that refers to a
+          split geom group with one instance per part of that group */
+      void instanceSplitParts(Context *context,
+                              OptixInstanceArray &optixInstances,
+                              GroupPtrArray &instanceGroups);
+      /*! fills in the optix instances for the flattened graph below
+          this group */
+      void flattenInstances(Context *context,
+                            OptixInstanceArray &optixInstances,
+                            GroupPtrArray &instanceGroups);
+      /*! builds the accel for a group that has more than
+          maxInstsPerIAS instances, by splitting it */
+      void buildSplitAccel(Context *context,
+                           const OptixInstanceArray &optixInstances,
+                           size_t maxInstsPerIAS);
     };
 
     /*! \warning currently using std::vector of *geoms*, but will have
@@ -304,7 +546,24 @@ namespace owl {
 
       std::vector<Geom *> children;
       const size_t sbtOffset;
+      /*! for each child, where its primitives start within the build
+          input it went into in the last accel build - non-zero only
+          for meshes that got merged with others; empty until the
+          first build. Gets written into the children's hit records,
+          for owl::getPrimitiveIndexInGeom(), if any group in the
+          context merges meshes */
+      std::vector<uint32_t> childPrimBase;
+    };
+    /*! the concatenated arrays of a run of small meshes that got
+        merged into a single build input (see MeshMerging.h) */
+    struct MergedMeshBuffers {
+      DeviceMemory vertices;
+      DeviceMemory indices;
+      /*! per primitive, the index of the mesh (within the run) it
+          came from */
+      DeviceMemory sbtIndexOffsets;
     };
+    
     struct TrianglesGeomGroup : public GeomGroup {
       TrianglesGeomGroup(size_t numChildren,
                          size_t sbtOffset)
@@ -315,6 +574,13 @@ namespace owl {
       
       virtual void destroyAccel(Context *context) override;
       virtual void buildAccel(Context *context) override;
+
+      /*! children with at most this many triangles get merged with
+          their (equally small) neighbours into shared build inputs;
+          0 means 'no merging' */
+      size_t maxMergedMeshTriangles = 0;
+      /*! the merged meshes of the last accel build */
+      std::vector<MergedMeshBuffers> mergedMeshes;
     };
     struct UserGeomGroup : public GeomGroup {
       UserGeomGroup(size_t numChildren,
@@ -351,6 +617,15 @@ namespace owl {
           buildPrograms() and createPipeline(), so should be called
           *before* those functions get called */
       void setMaxInstancingDepth(int maxInstancingDepth);
+      
+      /*! enables or disables automatic splitting of groups that
+          exceed optix' per-accel limits */
+      void setGroupSplitting(bool enabled);
+
+      /*! sets the callback that gets the stats of every accel build
+          on this device; null disables it */
+      void setBuildStatsCallback(LLOBuildStatsCB callback,
+                                 void *userData);
 
       void createPipeline()
       {
@@ -537,9 +812,49 @@ namespace owl {
       void instanceGroupSetChild(int groupID,
                                  int childNo,
                                  int childGroupID);
+      /*! enables/disables host-side flattening of nested instance
+          groups below the given instance group */
+      void instanceGroupSetFlattening(int groupID,
+                                      bool enabled,
+                                      size_t maxFlattenedInstances);
+      /*! set the visibility masks of 'count' children of the given
+          instance group, starting at child 'firstChild' */
+      void instanceGroupSetVisibilityMasks(int groupID,
+                                           int firstChild,
+                                           size_t count,
+                                           const uint8_t *masks);
+      /*! set the (optix) instance flags of 'count' children of the
+          given instance group, starting at child 'firstChild' */
+      void instanceGroupSetInstanceFlags(int groupID,
+                                         int firstChild,
+                                         size_t count,
+                                         const uint32_t *flags);
+      /*! set the instance IDs of 'count' children of the given
+          instance group, starting at child 'firstChild' */
+      void instanceGroupSetInstanceIDs(int groupID,
+                                       int firstChild,
+                                       size_t count,
+                                       const uint32_t *instanceIDs);
+      /*! enables/disables morton-order sorting of the instances of
+          the given instance group */
+      void instanceGroupSetSpatialSort(int groupID,
+                                       bool enabled);
+      /*! configures transform baking for the given instance group;
+          maxTrianglesPerGroup == 0 disables it */
+      void instanceGroupSetTransformBaking(int groupID,
+                                           size_t maxTrianglesPerGroup,
+                                           size_t maxInstancesPerGroup,
+                                           size_t memoryBudget);
+      /*! returns the stats of the given instance group's last
+          transform baking pass */
+      TransformBakingStats instanceGroupGetTransformBakingStats(int groupID);
       void geomGroupSetChild(int groupID,
                              int childNo,
                              int childID);
+      /*! enables merging of small meshes in the given triangles geom
+          group; '0' disables it */
+      void trianglesGeomGroupSetMeshMerging(int groupID,
+                                            size_t maxTrianglesPerMesh);
 
       /*! destroy the given buffer, and release all host and/or device
           memory associated with it */
@@ -554,11 +869,24 @@ namespace owl {
       
       void bufferResize(int bufferID, size_t newItemCount);
       void bufferUpload(int bufferID, const void *hostPtr);
+      /*! re-derives the vertex/index pointers of all triangles geoms
+          that use the given buffer, after that buffer got a new
+          device address (resize, or first write to a deduplicated
+          buffer); accels still have to be rebuilt by the app, as
+          after any other change to their geoms */
+      void updateBufferReferences(int bufferID);
       
       void deviceBufferCreate(int bufferID,
                               size_t elementCount,
                               size_t elementSize,
                               const void *initData);
+      /*! same as deviceBufferCreate, but shares the allocation of an
+          existing buffer with the same contents, if there is one */
+      void deviceBufferCreateDeduped(int bufferID,
+                                     size_t elementCount,
+                                     size_t elementSize,
+                                     const void *initData,
+                                     uint64_t contentHash);
 
       /*! create a managed memory buffer */
       void managedMemoryBufferCreate(int bufferID,
@@ -596,6 +924,9 @@ namespace owl {
         assert("check for valid ID" && ID >= 0);
         assert("check for valid ID" && ID < geoms.size());
         assert("check still valid"  && geoms[ID] != nullptr);
+        OWL_VALIDATE(geoms[ID]->numTimesReferenced == 0,
+                     "destroying geom #"+std::to_string(ID)
+                     +" that is still referenced by a group");
         // set to null, which should automatically destroy
         geoms[ID] = nullptr;
       }
@@ -617,47 +948,57 @@ namespace owl {
       // group related struff
       // ------------------------------------------------------------------
       void groupBuildAccel(int groupID);
+
+      /*! (only called if validation is enabled) checks that the
+          subtree under the given group does not reference any
+          destroyed geoms or groups, and that its instancing depth
+          does not exceed the configured maxInstancingDepth */
+      void validateGroupGraph(Group *group);
       
       /*! return given group's current traversable. note this function
         will *not* check if the group has alreadybeen built, if it
         has to be rebuilt, etc. */
       OptixTraversableHandle groupGetTraversable(int groupID);
       uint32_t groupGetSBTOffset(int groupID);
+      /*! device memory of the given group's accel, including
+          everything that only exists for it (instance arrays, split
+          parts, baked and merged geometry) */
+      size_t   groupGetAccelMemory(int groupID);
       
       // accessor helpers:
       Geom *checkGetGeom(int geomID)
       {
-        assert("check valid geom ID" && geomID >= 0);
-        assert("check valid geom ID" && geomID <  geoms.size());
+        OWL_VALIDATE(geomID >= 0,"check valid geom ID");
+        OWL_VALIDATE(geomID <  geoms.size(),"check valid geom ID");
         Geom *geom = geoms[geomID];
-        assert("check valid geom" && geom != nullptr);
+        OWL_VALIDATE(geom != nullptr,"check valid geom");
         return geom;
       }
       LaunchParams *checkGetLaunchParams(int launchParamsID)
       {
-        assert("check valid launchParams ID" && launchParamsID >= 0);
-        assert("check valid launchParams ID" && launchParamsID <  launchParams.size());
+        OWL_VALIDATE(launchParamsID >= 0,"check valid launchParams ID");
+        OWL_VALIDATE(launchParamsID <  launchParams.size(),"check valid launchParams ID");
         LaunchParams *launchParams = this->launchParams[launchParamsID];
-        assert("check valid launchParams" && launchParams != nullptr);
+        OWL_VALIDATE(launchParams != nullptr,"check valid launchParams");
         return launchParams;
       }
 
       GeomType *checkGetGeomType(int geomTypeID)
       {
-        assert("check valid geomType ID" && geomTypeID >= 0);
-        assert("check valid geomType ID" && geomTypeID <  geomTypes.size());
+        OWL_VALIDATE(geomTypeID >= 0,"check valid geomType ID");
+        OWL_VALIDATE(geomTypeID <  geomTypes.size(),"check valid geomType ID");
         GeomType *geomType = &geomTypes[geomTypeID];
-        assert("check valid geomType" && geomType != nullptr);
+        OWL_VALIDATE(geomType != nullptr,"check valid geomType");
         return geomType;
       }
 
       // accessor helpers:
       Group *checkGetGroup(int groupID)
       {
-        assert("check valid group ID" && groupID >= 0);
-        assert("check valid group ID" && groupID <  groups.size());
+        OWL_VALIDATE(groupID >= 0,"check valid group ID");
+        OWL_VALIDATE(groupID <  groups.size(),"check valid group ID");
         Group *group = groups[groupID];
-        assert("check valid group" && group != nullptr);
+        OWL_VALIDATE(group != nullptr,"check valid group");
         return group;
       }
 
@@ -665,20 +1006,20 @@ namespace owl {
       GeomGroup *checkGetGeomGroup(int groupID)
       {
         Group *group = checkGetGroup(groupID);
-        assert("check valid group" && group != nullptr);
+        OWL_VALIDATE(group != nullptr,"check valid group");
         GeomGroup *gg = dynamic_cast<GeomGroup*>(group);
-        assert("check group is a geom group" && gg != nullptr);
+        OWL_VALIDATE(gg != nullptr,"check group is a geom group");
         return gg;
       }
       // accessor helpers:
       UserGeomGroup *checkGetUserGeomGroup(int groupID)
       {
         Group *group = checkGetGroup(groupID);
-        assert("check valid group" && group != nullptr);
+        OWL_VALIDATE(group != nullptr,"check valid group");
         UserGeomGroup *ugg = dynamic_cast<UserGeomGroup*>(group);
         if (!ugg)
           OWL_EXCEPT("group is not a user geometry group");
-        assert("check group is a user geom group" && ugg != nullptr);
+        OWL_VALIDATE(ugg != nullptr,"check group is a user geom group");
         return ugg;
       }
       // accessor helpers:
@@ -688,16 +1029,16 @@ namespace owl {
         InstanceGroup *ig = dynamic_cast<InstanceGroup*>(group);
         if (!ig)
           OWL_EXCEPT("group is not a instance group");
-        assert("check group is a user geom group" && ig != nullptr);
+        OWL_VALIDATE(ig != nullptr,"check group is an instance group");
         return ig;
       }
       
       Buffer *checkGetBuffer(int bufferID)
       {
-        assert("check valid buffer ID" && bufferID >= 0);
-        assert("check valid buffer ID" && bufferID <  buffers.size());
+        OWL_VALIDATE(bufferID >= 0,"check valid buffer ID");
+        OWL_VALIDATE(bufferID <  buffers.size(),"check valid buffer ID");
         Buffer *buffer = buffers[bufferID];
-        assert("check valid buffer" && buffer != nullptr);
+        OWL_VALIDATE(buffer != nullptr,"check valid buffer");
         return buffer;
       }
 
@@ -708,7 +1049,7 @@ namespace owl {
         assert(geom);
         TrianglesGeom *asTriangles
           = dynamic_cast<TrianglesGeom*>(geom);
-        assert("check geom is triangle geom" && asTriangles != nullptr);
+        OWL_VALIDATE(asTriangles != nullptr,"check geom is triangle geom");
         return asTriangles;
       }
 
@@ -719,7 +1060,7 @@ namespace owl {
         assert(geom);
         UserGeom *asUser
           = dynamic_cast<UserGeom*>(geom);
-        assert("check geom is triangle geom" && asUser != nullptr);
+        OWL_VALIDATE(asUser != nullptr,"check geom is user geom");
         return asUser;
       }
 
@@ -731,13 +1072,46 @@ namespace owl {
                                      size_t maxGeomDataSize,
                                      LLOWriteUserGeomBoundsDataCB cb,
                                      const void *cbData);
+      /*! whether hit group records carry the geoms' prim bases for
+          owl::getPrimitiveIndexInGeom() - only if any triangles
+          group merges meshes */
+      bool hitRecordsHavePrimBase() const;
       void sbtHitProgsBuild(LLOWriteHitProgDataCB writeHitProgDataCB,
                             const void *callBackUserData);
       void sbtRayGensBuild(LLOWriteRayGenDataCB writeRayGenDataCB,
                            const void *callBackUserData);
+      /*! re-writes (and re-uploads) only the SBT record of the given
+          ray gen program */
+      void sbtRayGenBuild(int rgID,
+                          LLOWriteRayGenDataCB writeRayGenDataCB,
+                          const void *callBackUserData);
+      /*! size of one ray gen record, for the current ray gen programs */
+      size_t rayGenRecordSize() const;
+      /*! writes (on the host) the record of ray gen 'rgID' to the
+          given memory */
+      void writeRayGenRecord(uint8_t *sbtRecord,
+                             int rgID,
+                             LLOWriteRayGenDataCB writeRayGenDataCB,
+                             const void *callBackUserData);
       void sbtMissProgsBuild(LLOWriteMissProgDataCB writeMissProgDataCB,
                              const void *callBackUserData);
 
+      /*! enables or disables 'frame pipelining': if enabled, all
+          SBT builds write to a second copy of the SBT records while
+          launches keep using the first, and the two get swapped upon
+          the next launch. This allows for building the SBT for frame
+          N+1 while frame N is still in flight */
+      void setFramePipelining(bool enabled);
+
+      /*! fill in the optix SBT for a launch of raygen 'rgID' on the
+          given stream */
+      void prepareLaunchSBT(OptixShaderBindingTable &localSBT,
+                            int rgID,
+                            cudaStream_t stream);
+      /*! mark all SBT records used by the launch that was just
+          issued on given stream as in flight */
+      void launchIssued(cudaStream_t stream);
+      
       void launch(int rgID, const vec2i &dims);
 
       void launch(int rgID,
@@ -759,6 +1133,10 @@ namespace owl {
       std::vector<Group *>        groups;
       std::vector<Buffer *>       buffers;
       SBT                         sbt;
+
+      /*! allocations shared between device buffers with identical
+          contents (only used if buffer dedup is enabled) */
+      ContentDedupTable<DeviceMemory> bufferDedupTable;
     };
     
   } // ::owl::ll
@@ -16,18 +16,15 @@
 
 #include "owl/ll/Device.h"
 #include "owl/ll/DeviceGroup.h"
+#include "owl/ll/Tracing.h"
+#include "owl/ll/PerfCounters.h"
 
-#define LOG(message)                            \
-  if (Context::logging())                       \
-    std::cout << "#owl.ll: "                    \
-              << message                        \
-              << std::endl
+#define LOG(message)                                    \
+  OWL_LOG(LEVEL_INFO,"#owl.ll: " << message)
 
 #define LOG_OK(message)                                 \
-  if (Context::logging())                               \
-    std::cout << OWL_TERMINAL_LIGHT_GREEN               \
-              << "#owl.ll: "                            \
-              << message << OWL_TERMINAL_DEFAULT << std::endl
+  OWL_LOG_COLOR(LEVEL_INFO,OWL_TERMINAL_LIGHT_GREEN,    \
+                "#owl.ll: " << message)
 
 namespace owl {
   namespace ll {
@@ -150,6 +147,25 @@ namespace owl {
         device->setMaxInstancingDepth(maxInstancingDepth);
     }
 
+    void DeviceGroup::setFramePipelining(bool enabled)
+    {
+      for (auto device : devices)
+        device->setFramePipelining(enabled);
+    }
+
+    void DeviceGroup::setGroupSplitting(bool enabled)
+    {
+      for (auto device : devices)
+        device->setGroupSplitting(enabled);
+    }
+
+    void DeviceGroup::setBuildStatsCallback(LLOBuildStatsCB callback,
+                                            void *userData)
+    {
+      for (auto device : devices)
+        device->setBuildStatsCallback(callback,userData);
+    }
+
     void DeviceGroup::setRayTypeCount(size_t rayTypeCount)
     {
       for (auto device : devices)
@@ -175,6 +191,7 @@ namespace owl {
     
     void DeviceGroup::buildModules()
     {
+      OWL_TRACE_SCOPE("build","buildModules");
       for (auto device : devices)
         device->buildModules();
       LOG_OK("module(s) successfully (re-)built");
@@ -332,6 +349,7 @@ namespace owl {
 
     void DeviceGroup::buildPrograms()
     {
+      OWL_TRACE_SCOPE("build","buildPrograms");
       for (auto device : devices)
         device->buildPrograms();
       LOG_OK("device programs (re-)built");
@@ -339,6 +357,7 @@ namespace owl {
     
     void DeviceGroup::createPipeline()
     {
+      OWL_TRACE_SCOPE("build","createPipeline");
       for (auto device : devices)
         device->createPipeline();
       LOG_OK("optix pipeline created");
@@ -355,10 +374,32 @@ namespace owl {
                                          size_t elementSize,
                                          const void *initData)
     {
+      if (dedupBuffers && initData) {
+        // hash only once, for all devices
+        const uint64_t contentHash
+          = contentHash64(initData,elementCount*elementSize);
+        for (auto device : devices) 
+          device->deviceBufferCreateDeduped(bufferID,elementCount,elementSize,
+                                            initData,contentHash);
+        return;
+      }
       for (auto device : devices) 
         device->deviceBufferCreate(bufferID,elementCount,elementSize,initData);
     }
 
+    void DeviceGroup::setBufferDedup(bool enabled)
+    {
+      dedupBuffers = enabled;
+    }
+    
+    size_t DeviceGroup::getBufferDedupBytesSaved()
+    {
+      size_t bytesSaved = 0;
+      for (auto device : devices)
+        bytesSaved += device->bufferDedupTable.bytesSaved;
+      return bytesSaved;
+    }
+
     void DeviceGroup::hostPinnedBufferCreate(int bufferID,
                                              size_t elementCount,
                                              size_t elementSize)
@@ -425,6 +466,7 @@ namespace owl {
 
     void DeviceGroup::groupBuildAccel(int groupID)
     {
+      OWL_TRACE_SCOPE("accel","groupBuildAccel","groupID",groupID);
       try {
         for (auto device : devices) 
           device->groupBuildAccel(groupID);
@@ -442,6 +484,11 @@ namespace owl {
       return devices[0]->groupGetSBTOffset(groupID);
     }
 
+    size_t DeviceGroup::groupGetAccelMemory(int groupID)
+    {
+      return devices[0]->groupGetAccelMemory(groupID);
+    }
+
     OptixTraversableHandle DeviceGroup::groupGetTraversable(int groupID, int deviceID)
     {
       return checkGetDevice(deviceID)->groupGetTraversable(groupID);
@@ -450,6 +497,8 @@ namespace owl {
     void DeviceGroup::sbtHitProgsBuild(LLOWriteHitProgDataCB writeHitProgDataCB,
                                        const void *callBackData)
     {
+      OWL_TRACE_SCOPE("sbt","sbtHitProgsBuild");
+      OWL_PERF_SCOPE(PHASE_SBT_BUILD);
       for (auto device : devices) 
         device->sbtHitProgsBuild(writeHitProgDataCB,
                                  callBackData);
@@ -467,14 +516,30 @@ namespace owl {
     void DeviceGroup::sbtRayGensBuild(LLOWriteRayGenDataCB writeRayGenCB,
                                       const void *callBackData)
     {
+      OWL_TRACE_SCOPE("sbt","sbtRayGensBuild");
+      OWL_PERF_SCOPE(PHASE_SBT_BUILD);
       for (auto device : devices) 
         device->sbtRayGensBuild(writeRayGenCB,
                                 callBackData);
     }
     
+    void DeviceGroup::sbtRayGenBuild(int rayGenID,
+                                     LLOWriteRayGenDataCB writeRayGenCB,
+                                     const void *callBackData)
+    {
+      OWL_TRACE_SCOPE("sbt","sbtRayGenBuild","rayGenID",rayGenID);
+      OWL_PERF_SCOPE(PHASE_SBT_BUILD);
+      for (auto device : devices) 
+        device->sbtRayGenBuild(rayGenID,
+                               writeRayGenCB,
+                               callBackData);
+    }
+    
     void DeviceGroup::sbtMissProgsBuild(LLOWriteMissProgDataCB writeMissProgCB,
                                         const void *callBackData)
     {
+      OWL_TRACE_SCOPE("sbt","sbtMissProgsBuild");
+      OWL_PERF_SCOPE(PHASE_SBT_BUILD);
       for (auto device : devices) 
         device->sbtMissProgsBuild(writeMissProgCB,
                                   callBackData);
@@ -517,6 +582,80 @@ namespace owl {
                                       childGroupID);
     }
 
+    void DeviceGroup::instanceGroupSetFlattening(int groupID,
+                                                 bool enabled,
+                                                 size_t maxFlattenedInstances)
+    {
+      for (auto device : devices)
+        device->instanceGroupSetFlattening(groupID,
+                                           enabled,
+                                           maxFlattenedInstances);
+    }
+
+    void DeviceGroup::instanceGroupSetVisibilityMasks(int groupID,
+                                                      int firstChild,
+                                                      size_t count,
+                                                      const uint8_t *masks)
+    {
+      for (auto device : devices)
+        device->instanceGroupSetVisibilityMasks(groupID,firstChild,
+                                                count,masks);
+    }
+
+    void DeviceGroup::instanceGroupSetInstanceFlags(int groupID,
+                                                    int firstChild,
+                                                    size_t count,
+                                                    const uint32_t *flags)
+    {
+      for (auto device : devices)
+        device->instanceGroupSetInstanceFlags(groupID,firstChild,
+                                              count,flags);
+    }
+
+    void DeviceGroup::instanceGroupSetInstanceIDs(int groupID,
+                                                  int firstChild,
+                                                  size_t count,
+                                                  const uint32_t *instanceIDs)
+    {
+      for (auto device : devices)
+        device->instanceGroupSetInstanceIDs(groupID,firstChild,
+                                            count,instanceIDs);
+    }
+
+    void DeviceGroup::instanceGroupSetSpatialSort(int groupID,
+                                                  bool enabled)
+    {
+      for (auto device : devices)
+        device->instanceGroupSetSpatialSort(groupID,enabled);
+    }
+
+    void DeviceGroup::instanceGroupSetTransformBaking(int groupID,
+                                                      size_t maxTrianglesPerGroup,
+                                                      size_t maxInstancesPerGroup,
+                                                      size_t memoryBudget)
+    {
+      for (auto device : devices)
+        device->instanceGroupSetTransformBaking(groupID,
+                                                maxTrianglesPerGroup,
+                                                maxInstancesPerGroup,
+                                                memoryBudget);
+    }
+
+    TransformBakingStats
+    DeviceGroup::instanceGroupGetTransformBakingStats(int groupID)
+    {
+      assert(!devices.empty());
+      return devices[0]->instanceGroupGetTransformBakingStats(groupID);
+    }
+
+    void DeviceGroup::trianglesGeomGroupSetMeshMerging(int groupID,
+                                                       size_t maxTrianglesPerMesh)
+    {
+      for (auto device : devices)
+        device->trianglesGeomGroupSetMeshMerging(groupID,
+                                                 maxTrianglesPerMesh);
+    }
+
     void DeviceGroup::bufferResize(int bufferID, size_t newItemCount)
     {
       for (auto device : devices)
@@ -574,6 +713,8 @@ namespace owl {
       
     void DeviceGroup::launch(int rgID, const vec2i &dims)
     {
+      OWL_TRACE_SCOPE("launch","launch","rayGenID",rgID,"numPixels",
+                      int64_t(dims.x)*dims.y);
       for (auto device : devices) device->launch(rgID,dims);
       CUDA_SYNC_CHECK();
     }
@@ -584,6 +725,8 @@ namespace owl {
                              LLOWriteLaunchParamsCB writeLaunchParamsCB,
                              const void *cbData)
     {
+      OWL_TRACE_SCOPE("launch","launch","rayGenID",rgID,"numPixels",
+                      int64_t(dims.x)*dims.y);
       for (auto device : devices)
         device->launch(rgID,dims,
                        launchParamsID,
@@ -650,10 +793,10 @@ namespace owl {
           assert(dev);
           devices.push_back(dev);
         } catch (std::exception &e) {
-          std::cout << OWL_TERMINAL_RED
-                    << "#owl.ll: Error creating optix device on CUDA device #"
-                    << deviceIDs[i] << ": " << e.what() << " ... dropping this device"
-                    << OWL_TERMINAL_DEFAULT << std::endl;
+          OWL_LOG_COLOR(LEVEL_ERROR,OWL_TERMINAL_RED,
+                        "#owl.ll: Error creating optix device on CUDA device #"
+                        << deviceIDs[i] << ": " << e.what()
+                        << " ... dropping this device");
         }
       }
 
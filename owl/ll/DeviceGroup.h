@@ -18,6 +18,7 @@
 
 #include "owl/ll/helper/optix.h"
 #include <owl/llowl.h>
+#include "owl/ll/TransformBaking.h"
 
 #define OWL_THROWS_EXCEPTIONS 1
 #if OWL_THROWS_EXCEPTIONS
@@ -89,6 +90,20 @@ namespace owl {
         Note this value will have to be set *before* the pipeline
         gets created */
       void setMaxInstancingDepth(int maxInstancingDepth);
+
+      /*! enables or disables 'frame pipelining', in which SBT builds
+          write to a second copy of the SBT while the previous launch
+          may still be using the first one */
+      void setFramePipelining(bool enabled);
+
+      /*! enables or disables automatic splitting of groups that
+          exceed optix' per-accel limits */
+      void setGroupSplitting(bool enabled);
+
+      /*! sets the callback that gets the stats of every accel build
+          (on every device) */
+      void setBuildStatsCallback(LLOBuildStatsCB callback,
+                                 void *userData);
       
       void allocModules(size_t count);
       void allocLaunchParams(size_t count);
@@ -220,6 +235,47 @@ namespace owl {
       void instanceGroupSetChild(int groupID,
                                  int childNo,
                                  int childGroupID);
+      /*! enables/disables host-side flattening of nested instance
+          groups below the given instance group */
+      void instanceGroupSetFlattening(int groupID,
+                                      bool enabled,
+                                      size_t maxFlattenedInstances);
+      /*! set the visibility masks of 'count' children of the given
+          instance group, starting at child 'firstChild' */
+      void instanceGroupSetVisibilityMasks(int groupID,
+                                           int firstChild,
+                                           size_t count,
+                                           const uint8_t *masks);
+      /*! set the (optix) instance flags of 'count' children of the
+          given instance group, starting at child 'firstChild' */
+      void instanceGroupSetInstanceFlags(int groupID,
+                                         int firstChild,
+                                         size_t count,
+                                         const uint32_t *flags);
+      /*! set the instance IDs of 'count' children of the given
+          instance group, starting at child 'firstChild' */
+      void instanceGroupSetInstanceIDs(int groupID,
+                                       int firstChild,
+                                       size_t count,
+                                       const uint32_t *instanceIDs);
+      /*! enables/disables morton-order sorting of the instances of
+          the given instance group */
+      void instanceGroupSetSpatialSort(int groupID,
+                                       bool enabled);
+      /*! configures transform baking for the given instance group;
+          maxTrianglesPerGroup == 0 disables it */
+      void instanceGroupSetTransformBaking(int groupID,
+                                           size_t maxTrianglesPerGroup,
+                                           size_t maxInstancesPerGroup,
+                                           size_t memoryBudget);
+      /*! returns the stats of the given instance group's last
+          transform baking pass; all devices bake the same, so these
+          are the first device's */
+      TransformBakingStats instanceGroupGetTransformBakingStats(int groupID);
+      /*! enables merging of small meshes in the given triangles geom
+          group; '0' disables it */
+      void trianglesGeomGroupSetMeshMerging(int groupID,
+                                            size_t maxTrianglesPerMesh);
       void geomGroupSetChild(int groupID,
                              int childNo,
                              int childID);
@@ -235,6 +291,13 @@ namespace owl {
                               size_t elementSize,
                               const void *initData);
       
+      /*! enables or disables deduplication of device buffers with
+          identical contents */
+      void setBufferDedup(bool enabled);
+      /*! total number of bytes (summed over all devices) that did
+          not have to be allocated thanks to buffer deduplication */
+      size_t getBufferDedupBytesSaved();
+      
       /*! create a host-pinned memory buffer */
       void hostPinnedBufferCreate(int bufferID,
                                   size_t elementCount,
@@ -283,6 +346,7 @@ namespace owl {
       void groupAccelBuild(int groupID) { groupBuildAccel(groupID); }
       OptixTraversableHandle groupGetTraversable(int groupID, int deviceID);
       uint32_t groupGetSBTOffset(int groupID);
+      size_t   groupGetAccelMemory(int groupID);
 
 
       void groupBuildPrimitiveBounds(int groupID,
@@ -293,6 +357,10 @@ namespace owl {
                             const void *callBackData);
       void sbtRayGensBuild(LLOWriteRayGenDataCB WriteRayGenDataCB,
                            const void *callBackData);
+      /*! re-writes only the SBT record of the given ray gen */
+      void sbtRayGenBuild(int rayGenID,
+                          LLOWriteRayGenDataCB WriteRayGenDataCB,
+                          const void *callBackData);
       void sbtMissProgsBuild(LLOWriteMissProgDataCB WriteMissProgDataCB,
                              const void *callBackData);
       
@@ -372,6 +440,9 @@ namespace owl {
       Device *checkGetDevice(int deviceID);
       
       const std::vector<Device *> devices;
+
+      /*! whether device buffers with initial data get deduplicated */
+      bool dedupBuffers = false;
     };
 
   } // ::owl::ll
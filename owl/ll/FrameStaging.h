@@ -0,0 +1,125 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+// std
+#include <cassert>
+#include <cstdint>
+
+namespace owl {
+  namespace ll {
+
+    /*! tracks which of two 'staging slots' (eg, two copies of the
+        hit group records) is currently used by launches, and which
+        one the next build has to write to.
+
+        In the default (non-pipelined) mode there is only ever one
+        slot in use, and every build simply overwrites it (which is
+        what OWL always did, and which requires the app to wait for
+        all launches to finish before changing the scene).
+
+        In 'pipelined' mode builds always go into the *back* slot
+        while launches keep using the *front* slot, so the host can
+        prepare frame N+1 while frame N is still rendering; the next
+        launch then swaps in whichever slot holds the most recently
+        committed version.
+
+        This class only does the book-keeping (no CUDA in here), so
+        it can be tested on the host; the actual waiting on in-flight
+        launches is done by the owner, based on what needsWait()
+        says. */
+    struct FrameStaging {
+      enum { numSlots = 2 };
+
+      /*! enable or disable pipelined mode; when disabling we switch
+          to the most recent slot right away, so the single slot we
+          keep using from then on is the up-to-date one */
+      void setPipelined(bool enabled)
+      {
+        if (!enabled) front = newestSlot();
+        pipelined = enabled;
+      }
+
+      /*! the slot the next build has to write to */
+      int writeSlot() const
+      {
+        return pipelined ? (1-front) : front;
+      }
+
+      /*! returns true if the given slot was handed out to a launch
+          that has not been retired yet, meaning the owner has to
+          wait for that launch before overwriting the slot. In
+          non-pipelined mode we never wait (same as before) */
+      bool needsWait(int slot) const
+      {
+        assert(slot >= 0 && slot < numSlots);
+        return pipelined && inFlight[slot];
+      }
+
+      /*! tell us that the launch(es) that last used this slot are
+          done */
+      void retire(int slot)
+      {
+        assert(slot >= 0 && slot < numSlots);
+        inFlight[slot] = false;
+      }
+
+      /*! a build has finished writing (and uploading) the given slot;
+          it now holds the newest version */
+      void commit(int slot)
+      {
+        assert(slot >= 0 && slot < numSlots);
+        assert(!needsWait(slot));
+        version[slot] = ++latestVersion;
+      }
+
+      /*! returns the slot a launch should use, swapping front and
+          back if the back slot holds a newer version. Marks that
+          slot as in flight. */
+      int acquireForLaunch()
+      {
+        front = newestSlot();
+        inFlight[front] = true;
+        return front;
+      }
+
+      /*! whether any version has been committed yet */
+      bool valid() const { return latestVersion != 0; }
+
+      /*! version currently in the given slot; 0 means 'never
+          written' */
+      uint64_t slotVersion(int slot) const { return version[slot]; }
+
+      /*! the slot holding the most recently committed version */
+      int newestSlot() const
+      {
+        return version[1-front] > version[front] ? (1-front) : front;
+      }
+      
+      int  frontSlot()   const { return front; }
+      bool isPipelined() const { return pipelined; }
+
+    private:
+      bool     pipelined          = false;
+      int      front              = 0;
+      uint64_t latestVersion      = 0;
+      uint64_t version[numSlots]  = { 0, 0 };
+      bool     inFlight[numSlots] = { false, false };
+    };
+
+  } // ::owl::ll
+} //::owl
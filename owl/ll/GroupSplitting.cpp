@@ -0,0 +1,117 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "GroupSplitting.h"
+#include "owl/common/math/box.h"
+// std
+#include <algorithm>
+#include <stdexcept>
+
+namespace owl {
+  namespace ll {
+    using owl::common::box3f;
+
+    /*! splits the instances in [begin,end) into exactly 'numParts'
+        parts, by splitting at the longest axis such that each side
+        gets a number of instances proportional to the number of
+        parts it still has to produce */
+    static void splitInstances(const std::vector<vec3f> &positions,
+                               int *begin, int *end,
+                               size_t numParts,
+                               std::vector<std::vector<int>> &parts)
+    {
+      if (numParts == 1) {
+        parts.push_back(std::vector<int>(begin,end));
+        return;
+      }
+
+      box3f bounds;
+      for (int *it=begin;it!=end;it++)
+        bounds.extend(positions[*it]);
+      const vec3f extent = bounds.span();
+      const int dim
+        = (extent.x >= extent.y && extent.x >= extent.z)
+        ? 0
+        : (extent.y >= extent.z ? 1 : 2);
+
+      const size_t count     = end-begin;
+      const size_t leftParts = numParts/2;
+      const size_t leftCount = count * leftParts / numParts;
+      std::nth_element(begin,begin+leftCount,end,
+                       [&](int a, int b){
+                         return positions[a][dim] < positions[b][dim];
+                       });
+      splitInstances(positions,begin,begin+leftCount,leftParts,parts);
+      splitInstances(positions,begin+leftCount,end,numParts-leftParts,parts);
+    }
+
+    std::vector<std::vector<int>>
+    partitionInstances(const std::vector<vec3f> &positions,
+                       size_t maxPerPart)
+    {
+      if (maxPerPart == 0)
+        throw std::runtime_error("invalid max part size of 0 for "
+                                 "instance partitioning");
+      std::vector<std::vector<int>> parts;
+      if (positions.empty())
+        return parts;
+
+      std::vector<int> ids(positions.size());
+      for (size_t i=0;i<ids.size();i++) ids[i] = (int)i;
+
+      // the minimum number of parts; the count-balanced split
+      // guarantees none of them ends up above the limit
+      const size_t numParts = (ids.size()+maxPerPart-1)/maxPerPart;
+      splitInstances(positions,ids.data(),ids.data()+ids.size(),
+                     numParts,parts);
+      return parts;
+    }
+
+    std::vector<std::vector<PrimRange>>
+    partitionPrimRanges(const std::vector<size_t> &primCounts,
+                        size_t maxPrimsPerPart)
+    {
+      if (maxPrimsPerPart == 0)
+        throw std::runtime_error("invalid max part size of 0 for "
+                                 "primitive partitioning");
+      std::vector<std::vector<PrimRange>> parts(1);
+      size_t primsInPart = 0;
+      for (int child=0;child<(int)primCounts.size();child++) {
+        if (primCounts[child] == 0) {
+          // still needs a (empty) build input, else the children of
+          // this part would no longer be consecutive
+          parts.back().push_back({ child, 0, 0 });
+          continue;
+        }
+        size_t begin = 0;
+        while (begin < primCounts[child]) {
+          if (primsInPart == maxPrimsPerPart) {
+            parts.push_back({});
+            primsInPart = 0;
+          }
+          const size_t end
+            = std::min(primCounts[child],
+                       begin + (maxPrimsPerPart - primsInPart));
+          parts.back().push_back({ child, begin, end });
+          primsInPart += end - begin;
+          begin = end;
+        }
+      }
+      return parts;
+    }
+
+  } // ::owl::ll
+} //::owl
@@ -0,0 +1,76 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "owl/common/math/vec.h"
+// std
+#include <vector>
+
+namespace owl {
+  namespace ll {
+    using owl::common::vec3f;
+
+    /*! host-side partitioning logic for groups that exceed optix'
+        per-accel limits (MAX_INSTANCES_PER_IAS and
+        MAX_PRIMITIVES_PER_GAS). If group splitting is enabled such
+        groups get built as an instance accel over several smaller
+        accels, each of which stays within the limit (see
+        InstanceGroup::buildAccel and the geom group builders).
+
+        None of this needs CUDA or optix, and the limits are plain
+        parameters, so it can be tested on the host with
+        artificially low limits. */
+
+    /*! partitions a set of instances (given by their positions) into
+        the minimum number of parts that have at most
+        'maxPerPart' instances each, by recursively splitting at the
+        (count-balanced) median of the longest axis - so each part
+        is spatially coherent. Returns, for each part, the indices
+        of the instances in it; every input index appears in exactly
+        one part. */
+    std::vector<std::vector<int>>
+    partitionInstances(const std::vector<vec3f> &positions,
+                       size_t maxPerPart);
+
+    /*! a range [begin,end) of primitives of one child (geom) of a
+        geom group */
+    struct PrimRange {
+      int    child;
+      size_t begin;
+      size_t end;
+    };
+
+    /*! splits the primitives of a geom group's children (given by
+        each child's prim count) into parts of at most
+        'maxPrimsPerPart' primitives each; large children get split
+        into several prim ranges. Within each part the ranges are
+        sorted by child, and their children are consecutive and
+        unique - which is what we need to keep the SBT offsets of
+        the parts consistent with those of the original group
+        (part 'i' simply uses the SBT offset of its first child).
+        Always returns at least one (possibly empty) part.
+
+        Note we cannot re-order primitives here (that would change
+        the primitive IDs the app sees), so each part is a
+        contiguous range of the input, which is about as spatially
+        coherent as the input order is. */
+    std::vector<std::vector<PrimRange>>
+    partitionPrimRanges(const std::vector<size_t> &primCounts,
+                        size_t maxPrimsPerPart);
+
+  } // ::owl::ll
+} //::owl
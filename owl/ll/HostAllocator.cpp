@@ -0,0 +1,192 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "HostAllocator.h"
+#include "owl/common/owl-common.h"
+// std
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace owl {
+  namespace ll {
+
+    namespace {
+      struct SiteCounts {
+        std::atomic<uint64_t> numAllocs      { 0 };
+        std::atomic<uint64_t> numFrees       { 0 };
+        std::atomic<uint64_t> bytesAllocated { 0 };
+        std::atomic<uint64_t> bytesFreed     { 0 };
+      };
+
+      void *defaultAlloc(size_t numBytes, void *) { return malloc(numBytes); }
+      void  defaultFree(void *ptr, size_t, void *) { ::free(ptr); }
+
+      /*! like the metrics' state, this never gets destroyed, so
+          objects that get freed by static destructors can still give
+          their memory back */
+      struct AllocatorState {
+        std::mutex               mutex;
+        HostAllocator::AllocFn   allocFn  = defaultAlloc;
+        HostAllocator::FreeFn    freeFn   = defaultFree;
+        void                    *userData = nullptr;
+        SiteCounts               sites[HostAllocator::NUM_SITES];
+      };
+
+      AllocatorState &state()
+      {
+        static AllocatorState *state = new AllocatorState;
+        return *state;
+      }
+
+      inline SiteCounts &countsOf(int site)
+      {
+        assert(site >= 0 && site < HostAllocator::NUM_SITES);
+        return state().sites[site];
+      }
+    }
+
+    void HostAllocator::set(AllocFn allocFn, FreeFn freeFn, void *userData)
+    {
+      if ((allocFn == nullptr) != (freeFn == nullptr))
+        throw std::runtime_error("host allocator needs both an allocation "
+                                 "and a free function (or neither)");
+      AllocatorState &s = state();
+      std::lock_guard<std::mutex> lock(s.mutex);
+      for (int site=0;site<NUM_SITES;site++)
+        if (stats(site).bytesLive() != 0)
+          throw std::runtime_error("cannot change the host allocator while "
+                                   "owl still holds memory from the "
+                                   "current one");
+      s.allocFn  = allocFn ? allocFn : defaultAlloc;
+      s.freeFn   = freeFn  ? freeFn  : defaultFree;
+      s.userData = allocFn ? userData : nullptr;
+    }
+
+    void *HostAllocator::allocate(size_t numBytes, int site)
+    {
+      AllocatorState &s = state();
+      void *ptr = s.allocFn(numBytes ? numBytes : 1,s.userData);
+      if (!ptr)
+        throw std::bad_alloc();
+      SiteCounts &counts = countsOf(site);
+      counts.numAllocs.fetch_add(1,std::memory_order_relaxed);
+      counts.bytesAllocated.fetch_add(numBytes,std::memory_order_relaxed);
+      return ptr;
+    }
+
+    void HostAllocator::free(void *ptr, size_t numBytes, int site)
+    {
+      if (!ptr) return;
+      AllocatorState &s = state();
+      s.freeFn(ptr,numBytes ? numBytes : 1,s.userData);
+      SiteCounts &counts = countsOf(site);
+      counts.numFrees.fetch_add(1,std::memory_order_relaxed);
+      counts.bytesFreed.fetch_add(numBytes,std::memory_order_relaxed);
+    }
+
+    HostAllocator::Stats HostAllocator::stats(int site)
+    {
+      if (site < 0 || site >= NUM_SITES)
+        throw std::runtime_error("invalid host allocation site");
+      const SiteCounts &counts = countsOf(site);
+      Stats stats;
+      // frees first, so a concurrent alloc/free pair can not make
+      // bytesLive() go negative
+      stats.numFrees       = counts.numFrees.load(std::memory_order_relaxed);
+      stats.bytesFreed     = counts.bytesFreed.load(std::memory_order_relaxed);
+      stats.numAllocs      = counts.numAllocs.load(std::memory_order_relaxed);
+      stats.bytesAllocated = counts.bytesAllocated.load(std::memory_order_relaxed);
+      return stats;
+    }
+
+    const char *HostAllocator::siteName(int site)
+    {
+      static const char *names[NUM_SITES]
+        = { "handles", "variables", "launch", "accel" };
+      return (site >= 0 && site < NUM_SITES) ? names[site] : "invalid";
+    }
+
+    std::string HostAllocator::report()
+    {
+      std::stringstream ss;
+      ss << std::left << std::setw(10) << "site"
+         << std::right << std::setw(12) << "allocs"
+         << std::setw(12) << "frees"
+         << std::setw(12) << "allocated"
+         << std::setw(12) << "live" << std::endl;
+      for (int site=0;site<NUM_SITES;site++) {
+        const Stats s = stats(site);
+        ss << std::left << std::setw(10) << siteName(site)
+           << std::right << std::setw(12) << s.numAllocs
+           << std::setw(12) << s.numFrees
+           << std::setw(12) << (owl::common::prettyNumber(s.bytesAllocated)+"B")
+           << std::setw(12) << (owl::common::prettyNumber(s.bytesLive())+"B")
+           << std::endl;
+      }
+      return ss.str();
+    }
+
+    HostFreeList::HostFreeList(size_t blockSize, int site)
+      : blockSize(std::max(blockSize,sizeof(Block))),
+        site(site)
+    {}
+
+    void *HostFreeList::allocate(size_t size)
+    {
+      if (size > blockSize)
+        throw std::runtime_error("object too large for its free list");
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (head) {
+          Block *block = head;
+          head = block->next;
+          return block;
+        }
+      }
+      return HostAllocator::allocate(blockSize,site);
+    }
+
+    void HostFreeList::free(void *ptr)
+    {
+      if (!ptr) return;
+      std::lock_guard<std::mutex> lock(mutex);
+      Block *block = (Block *)ptr;
+      block->next = head;
+      head = block;
+    }
+
+    void HostFreeList::trim()
+    {
+      Block *list;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        list = head;
+        head = nullptr;
+      }
+      while (list) {
+        Block *next = list->next;
+        HostAllocator::free(list,blockSize,site);
+        list = next;
+      }
+    }
+
+  } // ::owl::ll
+} //::owl
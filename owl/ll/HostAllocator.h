@@ -0,0 +1,151 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace owl {
+  namespace ll {
+
+    /*! pluggable allocator for OWL's own host-side allocations on
+        (or close to) the per-frame paths - API handles, variables,
+        launch params, and the scratch arrays of accel builds - that
+        counts allocations and bytes per site, so apps (and tests)
+        can check that steady-state frames do not allocate.
+
+        By default memory comes from malloc(); apps can plug in
+        their own functions (see lloSetHostAllocator), but only
+        while OWL holds no memory from the previous ones. Counting
+        is always on: it's a few relaxed atomics per allocation, and
+        the point of all this is that there should not be many of
+        those. Like tracing and metrics this is process-wide. */
+    struct HostAllocator {
+      /*! where an allocation comes from; same values as
+          LLOHostAllocSite */
+      enum Site {
+        /*! API handles (and the bookkeeping for them) */
+        SITE_HANDLES = 0,
+        /*! variables of SBT objects and launch params */
+        SITE_VARIABLES,
+        /*! host copies of launch params */
+        SITE_LAUNCH,
+        /*! scratch arrays of accel builds */
+        SITE_ACCEL,
+        NUM_SITES
+      };
+
+      typedef void *(*AllocFn)(size_t numBytes, void *userData);
+      typedef void  (*FreeFn)(void *ptr, size_t numBytes, void *userData);
+
+      /*! counts of one site since program start */
+      struct Stats {
+        uint64_t numAllocs      = 0;
+        uint64_t numFrees       = 0;
+        uint64_t bytesAllocated = 0;
+        uint64_t bytesFreed     = 0;
+        uint64_t bytesLive() const { return bytesAllocated-bytesFreed; }
+      };
+
+      /*! replaces the functions all further allocations go through;
+          null functions restore malloc/free. Throws if OWL still
+          holds memory from the current ones */
+      static void set(AllocFn allocFn, FreeFn freeFn, void *userData);
+
+      /*! allocates from the current functions, and counts that
+          towards the given site; throws std::bad_alloc on failure */
+      static void *allocate(size_t numBytes, int site);
+      /*! gives back memory that allocate() returned for the same
+          size and site */
+      static void  free(void *ptr, size_t numBytes, int site);
+
+      static Stats stats(int site);
+      static const char *siteName(int site);
+
+      /*! human-readable table of all sites' counts */
+      static std::string report();
+    };
+
+    /*! STL allocator that goes through HostAllocator, for the
+        containers on OWL's hot paths */
+    template<typename T, int Site>
+    struct HostAllocatorT {
+      typedef T value_type;
+      template<typename U> struct rebind { typedef HostAllocatorT<U,Site> other; };
+
+      HostAllocatorT() {}
+      template<typename U>
+      HostAllocatorT(const HostAllocatorT<U,Site> &) {}
+
+      T *allocate(size_t n)
+      { return (T*)HostAllocator::allocate(n*sizeof(T),Site); }
+      void deallocate(T *ptr, size_t n)
+      { HostAllocator::free(ptr,n*sizeof(T),Site); }
+    };
+    template<typename T, typename U, int Site>
+    inline bool operator==(const HostAllocatorT<T,Site> &,
+                           const HostAllocatorT<U,Site> &)
+    { return true; }
+    template<typename T, typename U, int Site>
+    inline bool operator!=(const HostAllocatorT<T,Site> &,
+                           const HostAllocatorT<U,Site> &)
+    { return false; }
+
+    /*! a std::vector whose memory comes from HostAllocator */
+    template<typename T, int Site>
+    using HostVector = std::vector<T,HostAllocatorT<T,Site>>;
+
+    /*! base class for objects that get allocated through
+        HostAllocator; needs a virtual destructor in the hierarchy so
+        deleting through a base pointer frees the right size */
+    template<int Site>
+    struct HostAllocated {
+      static void *operator new(size_t size)
+      { return HostAllocator::allocate(size,Site); }
+      static void operator delete(void *ptr, size_t size)
+      { HostAllocator::free(ptr,size,Site); }
+    };
+
+    /*! free list of equally-sized blocks from HostAllocator, for
+        objects that get created and destroyed at high rates (such as
+        the API handles of owl<Object>Set<Type>() calls): once the
+        list is warm, creating and destroying objects does not
+        allocate any more. Blocks get handed back to HostAllocator
+        only by trim(). Thread-safe. */
+    struct HostFreeList {
+      HostFreeList(size_t blockSize, int site);
+      
+      void *allocate(size_t size);
+      void  free(void *ptr);
+      /*! gives all blocks on the list back to HostAllocator */
+      void  trim();
+
+    private:
+      struct Block { Block *next; };
+      const size_t blockSize;
+      const int    site;
+      std::mutex   mutex;
+      Block       *head = nullptr;
+    };
+    
+  } // ::owl::ll
+} //::owl
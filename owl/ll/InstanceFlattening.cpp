@@ -0,0 +1,224 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "InstanceFlattening.h"
+#include "owl/common/parallel/parallel_for.h"
+// std
+#include <stdexcept>
+#include <string>
+
+namespace owl {
+  namespace ll {
+
+    /*! number of sub-trees we try to split the graph into before
+        going parallel */
+    static const size_t targetNumTasks = 1024;
+
+    namespace {
+      enum { NOT_VISITED = 0, IN_PROGRESS, DONE };
+
+      /*! a sub-tree whose (fully composed) instances go into a fixed
+          range of the output array */
+      struct FlattenTask {
+        int      node;
+        int      rootChild;
+        affine3f xfm;
+        uint8_t  mask;
+        /*! flags of the instance that referenced 'node' */
+        uint32_t flags;
+        size_t   outBegin;
+      };
+
+      inline affine3f childTransform(const InstanceNode &node, int childID)
+      {
+        return node.transforms.empty()
+          ? affine3f(owl::common::one)
+          : node.transforms[childID];
+      }
+
+      inline uint8_t childMask(const InstanceNode &node, int childID)
+      {
+        return node.masks.empty() ? 255 : node.masks[childID];
+      }
+
+      inline uint32_t childFlags(const InstanceNode &node, int childID)
+      {
+        return node.flags.empty() ? 0 : node.flags[childID];
+      }
+
+      /*! computes (and memoizes) how many leaf instances the given
+          node expands to. Counts saturate at 'limit' so we can't
+          overflow on deeply nested graphs; in-progress markers detect
+          cycles */
+      size_t countLeaves(const std::vector<InstanceNode> &nodes,
+                         int nodeID,
+                         size_t limit,
+                         std::vector<size_t> &count,
+                         std::vector<int> &state)
+      {
+        if (nodeID < 0 || nodeID >= (int)nodes.size())
+          throw std::runtime_error("invalid node in instance graph");
+        if (state[nodeID] == DONE)
+          return count[nodeID];
+        if (state[nodeID] == IN_PROGRESS)
+          throw std::runtime_error("instance graph contains a cycle; cannot "
+                                   "flatten it");
+
+        const InstanceNode &node = nodes[nodeID];
+        size_t result = 0;
+        if (node.isLeaf)
+          result = 1;
+        else {
+          if (!node.transforms.empty() &&
+              node.transforms.size() != node.children.size())
+            throw std::runtime_error("instance node has a transform count "
+                                     "that does not match its child count");
+          if ((!node.masks.empty() &&
+               node.masks.size() != node.children.size()) ||
+              (!node.flags.empty() &&
+               node.flags.size() != node.children.size()))
+            throw std::runtime_error("instance node has a mask or flags count "
+                                     "that does not match its child count");
+          state[nodeID] = IN_PROGRESS;
+          for (auto child : node.children) {
+            result += countLeaves(nodes,child,limit,count,state);
+            if (result > limit) result = limit;
+          }
+        }
+        state[nodeID] = DONE;
+        count[nodeID] = result;
+        return result;
+      }
+
+      /*! writes all leaf instances of the given sub-tree, in
+          depth-first order, starting at out[outPos] */
+      void emitLeaves(const std::vector<InstanceNode> &nodes,
+                      const std::vector<size_t> &count,
+                      int nodeID,
+                      int rootChild,
+                      const affine3f &xfm,
+                      uint8_t mask,
+                      uint32_t flags,
+                      FlatInstance *out,
+                      size_t &outPos)
+      {
+        const InstanceNode &node = nodes[nodeID];
+        if (node.isLeaf) {
+          FlatInstance &fi = out[outPos++];
+          fi.leaf      = nodeID;
+          fi.rootChild = rootChild;
+          fi.xfm       = xfm;
+          fi.mask      = mask;
+          fi.flags     = flags;
+          return;
+        }
+        for (int childID=0;childID<(int)node.children.size();childID++) {
+          const int child = node.children[childID];
+          if (count[child] == 0) continue;
+          emitLeaves(nodes,count,child,rootChild,
+                     xfm * childTransform(node,childID),
+                     mask & childMask(node,childID),
+                     childFlags(node,childID),
+                     out,outPos);
+        }
+      }
+    }
+
+    std::vector<FlatInstance>
+    flattenInstanceGraph(const std::vector<InstanceNode> &nodes,
+                         int root,
+                         size_t maxInstances)
+    {
+      std::vector<size_t> count(nodes.size(),0);
+      std::vector<int>    state(nodes.size(),NOT_VISITED);
+      // saturate one past the limit, so we can tell 'exactly at the
+      // limit' from 'above it'
+      const size_t numInstances
+        = countLeaves(nodes,root,maxInstances+1,count,state);
+      if (numInstances > maxInstances)
+        throw std::runtime_error("flattening this instance graph would create "
+                                 "more than the allowed "
+                                 +std::to_string(maxInstances)
+                                 +" instances");
+
+      std::vector<FlatInstance> result(numInstances);
+      if (numInstances == 0)
+        return result;
+      if (nodes[root].isLeaf) {
+        result[0] = { root, 0, affine3f(owl::common::one), 255, 0 };
+        return result;
+      }
+
+      // ------------------------------------------------------------------
+      // split the graph into enough independent sub-trees to keep all
+      // threads busy; since we know how many instances each sub-tree
+      // expands to, each one gets a fixed output range, so the result
+      // is the same as a serial depth-first traversal would produce
+      // ------------------------------------------------------------------
+      std::vector<FlattenTask> tasks;
+      {
+        const InstanceNode &rootNode = nodes[root];
+        size_t outPos = 0;
+        for (int childID=0;childID<(int)rootNode.children.size();childID++) {
+          const int child = rootNode.children[childID];
+          if (count[child] == 0) continue;
+          tasks.push_back({ child, childID,
+                            childTransform(rootNode,childID),
+                            childMask(rootNode,childID),
+                            childFlags(rootNode,childID),
+                            outPos });
+          outPos += count[child];
+        }
+      }
+      while (tasks.size() < targetNumTasks) {
+        std::vector<FlattenTask> expanded;
+        bool didExpand = false;
+        for (auto &task : tasks) {
+          const InstanceNode &node = nodes[task.node];
+          if (node.isLeaf) {
+            expanded.push_back(task);
+            continue;
+          }
+          didExpand = true;
+          size_t outPos = task.outBegin;
+          for (int childID=0;childID<(int)node.children.size();childID++) {
+            const int child = node.children[childID];
+            if (count[child] == 0) continue;
+            expanded.push_back({ child, task.rootChild,
+                                 task.xfm * childTransform(node,childID),
+                                 uint8_t(task.mask & childMask(node,childID)),
+                                 childFlags(node,childID),
+                                 outPos });
+            outPos += count[child];
+          }
+        }
+        if (!didExpand) break;
+        tasks = std::move(expanded);
+      }
+
+      FlatInstance *out = result.data();
+      owl::common::parallel_for
+        (tasks.size(),[&](size_t taskID){
+          const FlattenTask &task = tasks[taskID];
+          size_t outPos = task.outBegin;
+          emitLeaves(nodes,count,task.node,task.rootChild,task.xfm,
+                     task.mask,task.flags,out,outPos);
+        });
+      return result;
+    }
+
+  } // ::owl::ll
+} //::owl
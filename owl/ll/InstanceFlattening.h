@@ -0,0 +1,84 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "owl/common/math/AffineSpace.h"
+// std
+#include <cstdint>
+#include <vector>
+
+namespace owl {
+  namespace ll {
+    using owl::common::affine3f;
+
+    /*! one node of the (host-side, index-based) instance graph that
+        gets flattened; this is intentionally decoupled from the
+        actual ll::Group classes so the flattening itself does not
+        need CUDA or optix, and can be tested on the host */
+    struct InstanceNode {
+      /*! leaves are the things that end up in the flat instance list
+          (ie, geom groups); non-leaves are instance groups */
+      bool isLeaf = true;
+      /*! indices of the children (into the same node array); only
+          for non-leaves */
+      std::vector<int>      children;
+      /*! one transform per child; may be empty, meaning all children
+          use the identity */
+      std::vector<affine3f> transforms;
+      /*! one visibility mask per child; may be empty, meaning all
+          children use 255 */
+      std::vector<uint8_t>  masks;
+      /*! one (optix) instance flags value per child; may be empty,
+          meaning no flags */
+      std::vector<uint32_t> flags;
+    };
+
+    /*! one instance of the flattened, single-level instance list */
+    struct FlatInstance {
+      /*! index of the leaf node this instance refers to */
+      int      leaf;
+      /*! index of the root's child this instance came from (ie, what
+          the app would have gotten as instance ID in the non-flattened
+          case) */
+      int      rootChild;
+      /*! full, composed transform from leaf space to root space */
+      affine3f xfm;
+      /*! AND of all visibility masks along the path from the root,
+          since a ray has to pass each of them */
+      uint8_t  mask;
+      /*! flags of the instance closest to the leaf, which is the one
+          whose flags optix applies to the leaf's geometry */
+      uint32_t flags;
+    };
+
+    /*! flattens the (possibly multi-level) instance graph rooted at
+        node 'root' into a single list of leaf instances with fully
+        composed transforms. The output is in depth-first order
+        (same order as a recursive traversal would visit the
+        leaves), independent of how many threads were used to
+        compute it.
+
+        Throws a std::runtime_error if the graph contains a cycle, or
+        if it would expand to more than maxInstances leaf
+        instances. */
+    std::vector<FlatInstance>
+    flattenInstanceGraph(const std::vector<InstanceNode> &nodes,
+                         int root,
+                         size_t maxInstances);
+
+  } // ::owl::ll
+} //::owl
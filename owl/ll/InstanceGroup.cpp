@@ -15,30 +15,24 @@
 // ======================================================================== //
 
 #include "Device.h"
+#include "InstanceFlattening.h"
+#include "InstanceTransforms.h"
+#include "GroupSplitting.h"
+#include "MortonSort.h"
+#include "TransformBaking.h"
+#include "owl/common/parallel/parallel_for.h"
+#include <map>
 
+/*! group builds can happen every frame, so everything in here
+    logs at debug level */
 #define LOG(message)                                            \
-  if (Context::logging()) \
-  std::cout << "#owl.ll(" << context->owlDeviceID << "): "      \
-  << message                                                    \
-  << std::endl
-
-#define LOG_OK(message)                                 \
-  if (Context::logging()) \
-  std::cout << OWL_TERMINAL_GREEN                       \
-  << "#owl.ll(" << context->owlDeviceID << "): "        \
-  << message << OWL_TERMINAL_DEFAULT << std::endl
-
-#define CLOG(message)                                   \
-  if (Context::logging()) \
-  std::cout << "#owl.ll(" << owlDeviceID << "): "       \
-  << message                                            \
-  << std::endl
-
-#define CLOG_OK(message)                                \
-  if (Context::logging()) \
-  std::cout << OWL_TERMINAL_GREEN                       \
-  << "#owl.ll(" << owlDeviceID << "): "                 \
-  << message << OWL_TERMINAL_DEFAULT << std::endl
+  OWL_LOG(LEVEL_DEBUG,"#owl.ll(" << context->owlDeviceID << "): " \
+          << message)
+
+#define LOG_OK(message)                                         \
+  OWL_LOG_COLOR(LEVEL_DEBUG,OWL_TERMINAL_GREEN,                 \
+                "#owl.ll(" << context->owlDeviceID << "): "     \
+                << message)
 
 namespace owl {
   namespace ll {
@@ -51,8 +45,8 @@ namespace owl {
                                            const affine3f &xfm)
     {
       InstanceGroup *ig = checkGetInstanceGroup(groupID);
-      assert("check valid child slot" && childNo >= 0);
-      assert("check valid child slot" && childNo <  ig->children.size());
+      OWL_VALIDATE(childNo >= 0 && childNo < ig->children.size(),
+                   "invalid child slot in instanceGroupSetTransform");
       
       if (ig->transforms.empty())
         ig->transforms.resize(ig->children.size());
@@ -65,6 +59,8 @@ namespace owl {
                                        int childGroupID)
     {
       InstanceGroup *ig = checkGetInstanceGroup(groupID);
+      OWL_VALIDATE(childNo >= 0 && childNo < ig->children.size(),
+                   "invalid child slot in instanceGroupSetChild");
       Group *newChild = checkGetGroup(childGroupID);
       if (ig->transforms.empty())
         ig->transforms.resize(ig->children.size());
@@ -75,6 +71,112 @@ namespace owl {
       newChild->numTimesReferenced++;
     }
 
+    /*! enables/disables host-side flattening of nested instance
+        groups below the given instance group */
+    void Device::instanceGroupSetFlattening(int groupID,
+                                            bool enabled,
+                                            size_t maxFlattenedInstances)
+    {
+      InstanceGroup *ig = checkGetInstanceGroup(groupID);
+      ig->flatten               = enabled;
+      ig->maxFlattenedInstances = maxFlattenedInstances;
+    }
+
+    /*! helper for the per-child instance properties: writes
+        values[0..count) to children [firstChild,firstChild+count)
+        of 'perChild', after first filling it with defaults if it
+        was still empty */
+    template<typename T, typename DefaultFct>
+    static void setChildRange(InstanceGroup *ig,
+                              std::vector<T> &perChild,
+                              int firstChild,
+                              size_t count,
+                              const T *values,
+                              const DefaultFct &defaultValue,
+                              const char *what)
+    {
+      OWL_VALIDATE(firstChild >= 0
+                   && firstChild+count <= ig->children.size(),
+                   what);
+      if (count == 0) return;
+      assert(values);
+      if (perChild.empty()) {
+        perChild.resize(ig->children.size());
+        for (size_t childID=0;childID<perChild.size();childID++)
+          perChild[childID] = defaultValue(childID);
+      }
+      std::copy(values,values+count,perChild.begin()+firstChild);
+    }
+
+    /*! set the visibility masks of 'count' children of the given
+        instance group, starting at child 'firstChild' */
+    void Device::instanceGroupSetVisibilityMasks(int groupID,
+                                                 int firstChild,
+                                                 size_t count,
+                                                 const uint8_t *masks)
+    {
+      InstanceGroup *ig = checkGetInstanceGroup(groupID);
+      setChildRange(ig,ig->visibilityMasks,firstChild,count,masks,
+                    [](size_t){ return (uint8_t)255; },
+                    "invalid child range in instanceGroupSetVisibilityMasks");
+    }
+
+    /*! set the (optix) instance flags of 'count' children of the
+        given instance group, starting at child 'firstChild' */
+    void Device::instanceGroupSetInstanceFlags(int groupID,
+                                               int firstChild,
+                                               size_t count,
+                                               const uint32_t *flags)
+    {
+      InstanceGroup *ig = checkGetInstanceGroup(groupID);
+      setChildRange(ig,ig->instanceFlags,firstChild,count,flags,
+                    [](size_t){ return (uint32_t)OPTIX_INSTANCE_FLAG_NONE; },
+                    "invalid child range in instanceGroupSetInstanceFlags");
+    }
+
+    /*! set the instance IDs of 'count' children of the given
+        instance group, starting at child 'firstChild' */
+    void Device::instanceGroupSetInstanceIDs(int groupID,
+                                             int firstChild,
+                                             size_t count,
+                                             const uint32_t *instanceIDs)
+    {
+      InstanceGroup *ig = checkGetInstanceGroup(groupID);
+      setChildRange(ig,ig->instanceIDs,firstChild,count,instanceIDs,
+                    [](size_t childID){ return (uint32_t)childID; },
+                    "invalid child range in instanceGroupSetInstanceIDs");
+    }
+
+    /*! enables/disables morton-order sorting of the instances of
+        the given instance group */
+    void Device::instanceGroupSetSpatialSort(int groupID,
+                                             bool enabled)
+    {
+      InstanceGroup *ig = checkGetInstanceGroup(groupID);
+      ig->spatialSort = enabled;
+    }
+
+    /*! configures transform baking for the given instance group;
+        maxTrianglesPerGroup == 0 disables it */
+    void Device::instanceGroupSetTransformBaking(int groupID,
+                                                 size_t maxTrianglesPerGroup,
+                                                 size_t maxInstancesPerGroup,
+                                                 size_t memoryBudget)
+    {
+      InstanceGroup *ig = checkGetInstanceGroup(groupID);
+      ig->maxBakedTriangles  = maxTrianglesPerGroup;
+      ig->maxBakedInstances  = maxInstancesPerGroup;
+      ig->bakingMemoryBudget = memoryBudget;
+    }
+
+    /*! returns the stats of the given instance group's last
+        transform baking pass */
+    TransformBakingStats
+    Device::instanceGroupGetTransformBakingStats(int groupID)
+    {
+      return checkGetInstanceGroup(groupID)->bakingStats;
+    }
+
     void Device::instanceGroupCreate(/*! the group we are defining */
                                      int groupID,
                                      /* list of children. list can be
@@ -106,6 +208,327 @@ namespace owl {
         }
     }
 
+    /*! composes all transforms in the instance graph below this
+        group on the host, and emits one optix instance per geom
+        group that is (indirectly) reachable from here; so the
+        resulting IAS is always single-level no matter how deeply
+        the app nested its instance groups. The instance ID of each
+        such instance is the index of the child of *this* group it
+        came from, same as without flattening. */
+    void InstanceGroup::flattenInstances(Context *context,
+                                         OptixInstanceArray &optixInstances,
+                                         GroupPtrArray &instanceGroups)
+    {
+      // ------------------------------------------------------------------
+      // convert the group graph into plain (index-based) instance
+      // nodes; only the nodes' *indices* are needed for flattening
+      // ------------------------------------------------------------------
+      std::vector<Group *>       groupOf;
+      std::vector<InstanceNode>  nodes;
+      std::map<Group *,int>      nodeOf;
+      std::vector<Group *>       todo;
+      auto getNode = [&](Group *group) -> int {
+        auto it = nodeOf.find(group);
+        if (it != nodeOf.end()) return it->second;
+        const int nodeID = (int)nodes.size();
+        nodeOf[group] = nodeID;
+        groupOf.push_back(group);
+        nodes.push_back(InstanceNode());
+        todo.push_back(group);
+        return nodeID;
+      };
+      getNode(this);
+      while (!todo.empty()) {
+        Group *group = todo.back();
+        todo.pop_back();
+        const int nodeID = nodeOf[group];
+        if (group->containsGeom())
+          continue;
+        InstanceGroup *ig = (InstanceGroup *)group;
+        std::vector<int> children(ig->children.size());
+        for (int childID=0;childID<ig->children.size();childID++) {
+          if (!ig->children[childID])
+            throw std::runtime_error("cannot flatten instance group with "
+                                     "a child that was never set");
+          children[childID] = getNode(ig->children[childID]);
+        }
+        // note: 'getNode' may have grown 'nodes', so only take the
+        // reference now
+        InstanceNode &node = nodes[nodeID];
+        node.isLeaf     = false;
+        node.children   = std::move(children);
+        node.transforms = ig->transforms;
+        node.masks      = ig->visibilityMasks;
+        node.flags      = ig->instanceFlags;
+      }
+
+      const std::vector<FlatInstance> flat
+        = flattenInstanceGraph(nodes,/*root*/0,maxFlattenedInstances);
+      LOG("flattened instance graph of " << nodes.size() << " groups into "
+          << prettyNumber(flat.size()) << " instances");
+      
+      optixInstances.resize(flat.size());
+      instanceGroups.resize(flat.size());
+      const size_t numRayTypes = context->numRayTypes;
+      owl::common::parallel_for
+        (flat.size(),[&](size_t instID){
+          const FlatInstance &fi = flat[instID];
+          Group *leaf = groupOf[fi.leaf];
+          assert(leaf->traversable);
+          instanceGroups[instID] = leaf;
+          
+          OptixInstance &oi    = optixInstances[instID];
+          setOptixInstanceTransform(oi,fi.xfm);
+          oi.flags             = fi.flags;
+          oi.instanceId        = instanceIDs.empty()
+            ? (unsigned)fi.rootChild
+            : instanceIDs[fi.rootChild];
+          oi.visibilityMask    = fi.mask;
+          oi.sbtOffset         = (unsigned)(numRayTypes * leaf->getSBTOffset());
+          oi.traversableHandle = leaf->traversable;
+        });
+    }
+
+    /*! replaces each instance of a geom group that got split (see
+        Group::splitParts) with one instance per part, with the same
+        transform, instance ID, flags and mask. Optix takes the
+        instance ID and flags from the instance closest to the
+        geometry accel, so instancing the group's own accel over its
+        parts would show the part's ID, and lose the flags; this way
+        hits in split geom groups look exactly the same as without
+        splitting, and splitting doesn't add a level of instancing.
+        Doesn't touch (nor allocate anything for) instances of
+        groups that didn't get split */
+    void InstanceGroup::instanceSplitParts(Context *context,
+                                           OptixInstanceArray &optixInstances,
+                                           GroupPtrArray &instanceGroups)
+    {
+      assert(instanceGroups.size() == optixInstances.size());
+      size_t numExpanded = 0;
+      for (auto group : instanceGroups)
+        numExpanded
+          += (group->containsGeom() && !group->splitParts.empty())
+          ? group->splitParts.size()
+          : 1;
+      if (numExpanded == optixInstances.size())
+        return;
+
+      OptixInstanceArray expanded;
+      GroupPtrArray      expandedGroups;
+      expanded.reserve(numExpanded);
+      expandedGroups.reserve(numExpanded);
+      for (size_t instID=0;instID<optixInstances.size();instID++) {
+        Group *group = instanceGroups[instID];
+        if (!group->containsGeom() || group->splitParts.empty()) {
+          expanded.push_back(optixInstances[instID]);
+          expandedGroups.push_back(group);
+          continue;
+        }
+        for (auto &part : group->splitParts) {
+          OptixInstance oi     = optixInstances[instID];
+          oi.sbtOffset         = part.sbtOffset;
+          oi.traversableHandle = part.traversable;
+          expanded.push_back(oi);
+          expandedGroups.push_back(group);
+        }
+      }
+      LOG("instancing the parts of split geom groups: "
+          << optixInstances.size() << " instances became "
+          << expanded.size());
+      optixInstances.swap(expanded);
+      instanceGroups.swap(expandedGroups);
+    }
+
+    /*! reorders the given instances in morton order of their
+        origins (the instances' translations - we don't know the
+        children's bounds on this level), and remembers the
+        permutation in instanceOrder */
+    void InstanceGroup::sortInstances(Context *context,
+                                      OptixInstanceArray &optixInstances)
+    {
+      const size_t numInstances = optixInstances.size();
+      std::vector<vec3f> origins(numInstances);
+      owl::common::parallel_for
+        (numInstances,[&](size_t instID){
+          const float *xfm = optixInstances[instID].transform;
+          origins[instID] = vec3f(xfm[0*4+3],xfm[1*4+3],xfm[2*4+3]);
+        });
+      instanceOrder = mortonOrder(origins);
+
+      OptixInstanceArray sorted(numInstances);
+      owl::common::parallel_for
+        (numInstances,[&](size_t slot){
+          sorted[slot] = optixInstances[instanceOrder[slot]];
+        });
+      optixInstances.swap(sorted);
+      LOG("sorted " << prettyNumber(numInstances)
+          << " instances in morton order");
+    }
+
+    /*! replaces all instances of (small enough) triangle geom groups
+        with a single instance of an accel over world-space copies of
+        their triangles. Only instances with default mask and flags
+        qualify, since the baked geometry only gets one instance */
+    void InstanceGroup::bakeTransforms(Context *context,
+                                       OptixInstanceArray &optixInstances,
+                                       const GroupPtrArray &instanceGroups)
+    {
+      assert(instanceGroups.size() == optixInstances.size());
+      bakingStats = TransformBakingStats();
+      bakingStats.instancesBefore = optixInstances.size();
+      bakingStats.instancesAfter  = optixInstances.size();
+      
+      const uint32_t maxPrimsPerGAS = context->maxPrimsPerGAS;
+
+      // ------------------------------------------------------------------
+      // find the candidates, and decide which of them to bake
+      // ------------------------------------------------------------------
+      std::vector<TrianglesGeomGroup *> candidates;
+      std::map<Group *,int>             candidateOf;
+      std::vector<int> instanceCandidate(optixInstances.size(),-1);
+      for (size_t instID=0;instID<optixInstances.size();instID++) {
+        const OptixInstance &oi = optixInstances[instID];
+        if (oi.visibilityMask != 255 || oi.flags != OPTIX_INSTANCE_FLAG_NONE)
+          continue;
+        TrianglesGeomGroup *tgg
+          = dynamic_cast<TrianglesGeomGroup *>(instanceGroups[instID]);
+        if (!tgg) continue;
+        auto it = candidateOf.find(tgg);
+        if (it == candidateOf.end()) {
+          it = candidateOf.insert({tgg,(int)candidates.size()}).first;
+          candidates.push_back(tgg);
+        }
+        instanceCandidate[instID] = it->second;
+      }
+      if (candidates.empty())
+        return;
+
+      std::vector<size_t> groupTriangles(candidates.size(),0);
+      std::vector<size_t> groupVertices(candidates.size(),0);
+      for (size_t groupID=0;groupID<candidates.size();groupID++)
+        for (auto geom : candidates[groupID]->children) {
+          TrianglesGeom *tris = (TrianglesGeom *)geom;
+          groupTriangles[groupID] += tris->indexCount;
+          groupVertices[groupID]  += tris->vertexCount;
+        }
+      const std::vector<bool> bake
+        = planTransformBaking(groupTriangles,groupVertices,instanceCandidate,
+                              maxBakedTriangles,maxBakedInstances,
+                              bakingMemoryBudget,maxPrimsPerGAS);
+
+      // ------------------------------------------------------------------
+      // stage the baked groups' meshes on the host
+      // ------------------------------------------------------------------
+      size_t numStagedGeoms = 0;
+      for (size_t groupID=0;groupID<candidates.size();groupID++)
+        if (bake[groupID])
+          numStagedGeoms += candidates[groupID]->children.size();
+      if (numStagedGeoms == 0)
+        return;
+      
+      // note: resize only once - the mesh views point into these
+      std::vector<std::vector<uint8_t>> vertexStaging(numStagedGeoms);
+      std::vector<std::vector<uint8_t>> indexStaging(numStagedGeoms);
+      std::vector<std::vector<BakeMesh>> meshes(candidates.size());
+      size_t numStaged = 0;
+      for (size_t groupID=0;groupID<candidates.size();groupID++) {
+        if (!bake[groupID]) continue;
+        TrianglesGeomGroup *tgg = candidates[groupID];
+        for (size_t childID=0;childID<tgg->children.size();childID++) {
+          TrianglesGeom *tris = (TrianglesGeom *)tgg->children[childID];
+          const MeshView mesh = tris->download(vertexStaging[numStaged],
+                                               indexStaging[numStaged]);
+          numStaged++;
+          meshes[groupID].push_back({ mesh,
+                                      (uint32_t)(tgg->sbtOffset+childID) });
+        }
+      }
+
+      // ------------------------------------------------------------------
+      // bake, and split the instances into baked and kept ones
+      // ------------------------------------------------------------------
+      std::vector<BakeInstance>  toBake;
+      OptixInstanceArray         keptInstances;
+      for (size_t instID=0;instID<optixInstances.size();instID++) {
+        const int group = instanceCandidate[instID];
+        if (group >= 0 && bake[group])
+          toBake.push_back
+            ({ group, getOptixInstanceTransform(optixInstances[instID]) });
+        else
+          keptInstances.push_back(optixInstances[instID]);
+      }
+      const BakedGeometry baked = bakeInstances(meshes,toBake);
+
+      uint32_t numSbtRecords = 0;
+      for (auto sbtIndex : baked.sbtIndices)
+        numSbtRecords = std::max(numSbtRecords,sbtIndex+1);
+      
+      bakedVertices.alloc(baked.vertices.size()*sizeof(vec3f));
+      bakedVertices.upload(baked.vertices);
+      bakedIndices.alloc(baked.indices.size()*sizeof(vec3i));
+      bakedIndices.upload(baked.indices);
+      bakedSbtIndices.alloc(baked.sbtIndices.size()*sizeof(uint32_t));
+      bakedSbtIndices.upload(baked.sbtIndices);
+
+      // ------------------------------------------------------------------
+      // build the baked accel: a single build input whose per-prim SBT
+      // index offsets are the (absolute) SBT records of the geoms the
+      // triangles came from, so its instance uses an SBT offset of 0
+      // ------------------------------------------------------------------
+      CUdeviceptr d_vertices = (CUdeviceptr)bakedVertices.get();
+      std::vector<uint32_t> inputFlags(numSbtRecords,0);
+      std::vector<OptixBuildInput> triangleInputs(1);
+      triangleInputs[0].type = OPTIX_BUILD_INPUT_TYPE_TRIANGLES;
+      auto &ta = triangleInputs[0].triangleArray;
+      ta.vertexFormat                = OPTIX_VERTEX_FORMAT_FLOAT3;
+      ta.vertexStrideInBytes         = sizeof(vec3f);
+      ta.numVertices                 = (uint32_t)baked.vertices.size();
+      ta.vertexBuffers               = &d_vertices;
+      ta.indexFormat                 = OPTIX_INDICES_FORMAT_UNSIGNED_INT3;
+      ta.indexStrideInBytes          = sizeof(vec3i);
+      ta.numIndexTriplets            = (uint32_t)baked.indices.size();
+      ta.indexBuffer                 = (CUdeviceptr)bakedIndices.get();
+      ta.flags                       = inputFlags.data();
+      ta.numSbtRecords               = numSbtRecords;
+      ta.sbtIndexOffsetBuffer        = (CUdeviceptr)bakedSbtIndices.get();
+      ta.sbtIndexOffsetSizeInBytes   = sizeof(uint32_t);
+      ta.sbtIndexOffsetStrideInBytes = sizeof(uint32_t);
+      buildTrianglesAccel(context,triangleInputs,
+                          bakedBvhMemory,bakedTraversable,0);
+
+      OptixInstance bakedInstance = {};
+      setOptixInstanceTransform(bakedInstance,affine3f(owl::common::one));
+      bakedInstance.flags             = OPTIX_INSTANCE_FLAG_NONE;
+      // an ID no child of this group uses by default
+      bakedInstance.instanceId        = (unsigned)children.size();
+      bakedInstance.visibilityMask    = 255;
+      bakedInstance.sbtOffset         = 0;
+      bakedInstance.traversableHandle = bakedTraversable;
+      keptInstances.push_back(bakedInstance);
+      optixInstances.swap(keptInstances);
+
+      bakingStats.instancesAfter = optixInstances.size();
+      bakingStats.instancesBaked = toBake.size();
+      bakingStats.trianglesBaked = baked.indices.size();
+      bakingStats.bytesUsed
+        = bakedVertices.size()+bakedIndices.size()+bakedSbtIndices.size();
+      LOG("baked " << prettyNumber(bakingStats.instancesBaked)
+          << " instances into " << prettyNumber(bakingStats.trianglesBaked)
+          << " world-space triangles (" << prettyNumber(bakingStats.bytesUsed)
+          << "B); instances: " << prettyNumber(bakingStats.instancesBefore)
+          << " -> " << prettyNumber(bakingStats.instancesAfter));
+    }
+
+    /*! frees the baked geometry of the last build, if any */
+    void InstanceGroup::destroyBakedGeometry()
+    {
+      bakedVertices.free();
+      bakedIndices.free();
+      bakedSbtIndices.free();
+      bakedBvhMemory.free();
+      bakedTraversable = 0;
+    }
+    
     void InstanceGroup::destroyAccel(Context *context) 
     {
       context->pushActive();
@@ -113,82 +536,27 @@ namespace owl {
         bvhMemory.free();
         traversable = 0;
       }
+      destroySplitParts();
+      destroyBakedGeometry();
       context->popActive();
     }
     
-    void InstanceGroup::buildAccel(Context *context) 
+    /*! builds an instance accel over the given optix instances, into
+        the given memory. The instance buffer has to stay alive for as
+        long as the accel does */
+    void buildInstanceAccel(Context *context,
+                            const OptixInstanceArray &optixInstances,
+                            DeviceMemory &optixInstanceBuffer,
+                            DeviceMemory &bvhMemory,
+                            OptixTraversableHandle &traversable)
     {
-      assert("check does not yet exist" && traversable == 0);
-      assert("check does not yet exist" && bvhMemory.empty());
-      
-      context->pushActive();
-      LOG("building instance accel over "
-          << children.size() << " groups");
-
-      // ==================================================================
-      // sanity check that that many instances are actualy allowed by optix:
-      // ==================================================================
-      uint32_t maxInstsPerIAS = 0;
-      optixDeviceContextGetProperty
-        (context->optixContext,
-         OPTIX_DEVICE_PROPERTY_LIMIT_MAX_INSTANCES_PER_IAS,
-         &maxInstsPerIAS,
-         sizeof(maxInstsPerIAS));
-      if (children.size() > maxInstsPerIAS)
-        throw std::runtime_error("number of children in instnace group exceeds "
-                                 "OptiX's MAX_INSTANCES_PER_IAS limit");
-      
-      // ==================================================================
-      // create instance build inputs
-      // ==================================================================
       OptixBuildInput              instanceInput  {};
       OptixAccelBuildOptions       accelOptions   {};
-      //! the N build inputs that go into the builder
-      std::vector<OptixBuildInput> buildInputs(children.size());
-      std::vector<OptixInstance>   optixInstances(children.size());
-
-     // for now we use the same flags for all geoms
-      uint32_t instanceGroupInputFlags[1] = { 0 };
-      // { OPTIX_GEOMETRY_FLAG_DISABLE_ANYHIT
-
-      // now go over all children to set up the buildinputs
-      for (int childID=0;childID<children.size();childID++) {
-        Group *child = children[childID];
-        assert(child);
-        
-        const affine3f xfm
-          = transforms.empty()
-          ? affine3f(owl::common::one)
-          : transforms[childID];
-
-        OptixInstance &oi    = optixInstances[childID];
-        oi.transform[0*4+0]  = xfm.l.vx.x;
-        oi.transform[0*4+1]  = xfm.l.vy.x;
-        oi.transform[0*4+2]  = xfm.l.vz.x;
-        oi.transform[0*4+3]  = xfm.p.x;
-        
-        oi.transform[1*4+0]  = xfm.l.vx.y;
-        oi.transform[1*4+1]  = xfm.l.vy.y;
-        oi.transform[1*4+2]  = xfm.l.vz.y;
-        oi.transform[1*4+3]  = xfm.p.y;
-        
-        oi.transform[2*4+0]  = xfm.l.vx.z;
-        oi.transform[2*4+1]  = xfm.l.vy.z;
-        oi.transform[2*4+2]  = xfm.l.vz.z;
-        oi.transform[2*4+3]  = xfm.p.z;
-        
-        oi.flags             = OPTIX_INSTANCE_FLAG_NONE;
-        oi.instanceId        = childID; // ???
-        oi.visibilityMask    = 255;
-        oi.sbtOffset         = context->numRayTypes * child->getSBTOffset();
-        oi.visibilityMask    = 255;
-        assert(child->traversable);
-        oi.traversableHandle = child->traversable;
-      }
 
       optixInstanceBuffer.alloc(optixInstances.size()*
                                 sizeof(optixInstances[0]));
       optixInstanceBuffer.upload(optixInstances.data(),"optixinstances");
+      OWL_COUNTER_ADD("owl_instances_encoded_total",optixInstances.size());
     
       // ==================================================================
       // set up build input
@@ -235,6 +603,7 @@ namespace owl {
       DeviceMemory &outputBuffer = bvhMemory;
       outputBuffer.alloc(bufferSizes.outputSizeInBytes);
             
+      AccelBuildTimer buildTimer(context);
       OPTIX_CHECK(optixAccelBuild(context->optixContext,
                                   /* todo: stream */0,
                                   &accelOptions,
@@ -253,6 +622,12 @@ namespace owl {
                                   ));
       
       CUDA_SYNC_CHECK();
+      buildTimer.stop();
+      if (context->buildStats)
+        context->buildStats->addAccel(1,
+                                      bufferSizes.tempSizeInBytes,
+                                      bufferSizes.outputSizeInBytes,
+                                      bufferSizes.outputSizeInBytes);
     
       // ==================================================================
       // aaaaaand .... clean up
@@ -260,6 +635,165 @@ namespace owl {
       // TODO: move those free's to the destructor, so we can delay the
       // frees until all objects are done
       tempBuildBuffer.free();
+    }
+
+    /*! builds this group's traversable as a single-level instance
+        accel over the (already built) splitParts, with identity
+        transforms. Since optix uses the SBT offset (and instance ID)
+        of the instance that directly references a geometry accel,
+        the per-part SBT offsets only matter for geom groups; for
+        split instance groups they get ignored.
+
+        This accel only gets used if the group gets traced directly;
+        instance groups instance the parts of split geom groups
+        themselves, with their own instance IDs and flags (see
+        InstanceGroup::instanceSplitParts) */
+    void Group::buildOverSplitParts(Context *context,
+                                    const std::vector<uint32_t> &partSBTOffsets)
+    {
+      assert(partSBTOffsets.size() == splitParts.size());
+      OptixInstanceArray optixInstances(splitParts.size());
+      for (size_t partID=0;partID<splitParts.size();partID++) {
+        splitParts[partID].sbtOffset = partSBTOffsets[partID];
+        OptixInstance &oi    = optixInstances[partID];
+        setOptixInstanceTransform(oi,affine3f(owl::common::one));
+        oi.flags             = OPTIX_INSTANCE_FLAG_NONE;
+        oi.instanceId        = 0;
+        oi.visibilityMask    = 255;
+        oi.sbtOffset         = partSBTOffsets[partID];
+        oi.traversableHandle = splitParts[partID].traversable;
+      }
+      buildInstanceAccel(context,optixInstances,
+                         splitInstanceBuffer,bvhMemory,traversable);
+    }
+
+    /*! frees the accels of all the parts this group may have been
+        split into */
+    void Group::destroySplitParts()
+    {
+      splitParts.clear();
+      splitInstanceBuffer.free();
+    }
+    
+    /*! builds an accel for more instances than a single IAS can
+        hold: partitions the instances into spatially coherent parts
+        (by their origins), builds one IAS per part, and one more
+        over those parts */
+    void InstanceGroup::buildSplitAccel(Context *context,
+                                        const OptixInstanceArray &optixInstances,
+                                        size_t maxInstsPerIAS)
+    {
+      std::vector<vec3f> positions(optixInstances.size());
+      for (size_t instID=0;instID<optixInstances.size();instID++) {
+        const float *xfm = optixInstances[instID].transform;
+        positions[instID] = vec3f(xfm[0*4+3],xfm[1*4+3],xfm[2*4+3]);
+      }
+      const std::vector<std::vector<int>> parts
+        = partitionInstances(positions,maxInstsPerIAS);
+      if (parts.size() > maxInstsPerIAS)
+        throw std::runtime_error("instance group too large even for "
+                                 "automatic group splitting");
+      LOG("instance group exceeds MAX_INSTANCES_PER_IAS, splitting into "
+          << parts.size() << " parts");
+      
+      // note: resize only once - DeviceMemory is not safe to copy
+      splitParts.resize(parts.size());
+      for (size_t partID=0;partID<parts.size();partID++) {
+        OptixInstanceArray partInstances;
+        partInstances.reserve(parts[partID].size());
+        for (auto instID : parts[partID])
+          partInstances.push_back(optixInstances[instID]);
+        SubAccel &sub = splitParts[partID];
+        buildInstanceAccel(context,partInstances,
+                           sub.instanceBuffer,sub.bvhMemory,sub.traversable);
+      }
+      buildOverSplitParts(context,std::vector<uint32_t>(parts.size(),0));
+    }
+    
+    void InstanceGroup::buildAccel(Context *context) 
+    {
+      OWL_HISTOGRAM_SCOPE("owl_accel_build_seconds{kind=\"instance\"}");
+      assert("check does not yet exist" && traversable == 0);
+      assert("check does not yet exist" && bvhMemory.empty());
+      
+      context->pushActive();
+      LOG("building instance accel over "
+          << children.size() << " groups");
+
+      const uint32_t maxInstsPerIAS = context->maxInstsPerIAS;
+      
+      // ==================================================================
+      // create instance build inputs
+      // ==================================================================
+      OptixInstanceArray &optixInstances = scratchInstances;
+      /*! the group each instance refers to */
+      GroupPtrArray      &instanceGroups = scratchInstanceGroups;
+      {
+      OWL_PERF_SCOPE(PHASE_INSTANCE_PACKING);
+      optixInstances.assign(children.size(),OptixInstance{});
+      instanceGroups.assign(children.begin(),children.end());
+
+      // now go over all children to set up the buildinputs (or,
+      // if flattening, over all geom groups reachable from here)
+      if (flatten)
+        flattenInstances(context,optixInstances,instanceGroups);
+      else for (int childID=0;childID<children.size();childID++) {
+        Group *child = children[childID];
+        assert(child);
+        
+        const affine3f xfm
+          = transforms.empty()
+          ? affine3f(owl::common::one)
+          : transforms[childID];
+
+        OptixInstance &oi    = optixInstances[childID];
+        setOptixInstanceTransform(oi,xfm);
+        oi.flags             = instanceFlags.empty()
+          ? (uint32_t)OPTIX_INSTANCE_FLAG_NONE
+          : instanceFlags[childID];
+        oi.instanceId        = instanceIDs.empty()
+          ? childID
+          : instanceIDs[childID];
+        oi.visibilityMask    = visibilityMasks.empty()
+          ? 255
+          : visibilityMasks[childID];
+        oi.sbtOffset         = context->numRayTypes * child->getSBTOffset();
+        assert(child->traversable);
+        oi.traversableHandle = child->traversable;
+      }
+      }
+
+      instanceSplitParts(context,optixInstances,instanceGroups);
+
+      if (maxBakedTriangles > 0)
+        bakeTransforms(context,optixInstances,instanceGroups);
+      else
+        bakingStats = TransformBakingStats();
+
+      // instance IDs are already set, so re-ordering the instances
+      // doesn't change what the app sees
+      if (spatialSort) {
+        OWL_PERF_SCOPE(PHASE_INSTANCE_PACKING);
+        sortInstances(context,optixInstances);
+      } else
+        instanceOrder.clear();
+
+      if (context->buildStats)
+        context->buildStats->numPrimitives = optixInstances.size();
+      
+      // ==================================================================
+      // sanity check that that many instances are actualy allowed by
+      // optix - or, if enabled, split the group
+      // ==================================================================
+      if (optixInstances.size() > maxInstsPerIAS) {
+        if (!context->splitOversizedGroups)
+          throw std::runtime_error("number of (flattened) children in instance "
+                                   "group exceeds OptiX's "
+                                   "MAX_INSTANCES_PER_IAS limit");
+        buildSplitAccel(context,optixInstances,maxInstsPerIAS);
+      } else
+        buildInstanceAccel(context,optixInstances,
+                           optixInstanceBuffer,bvhMemory,traversable);
       context->popActive();
       
       LOG_OK("successfully built instance group accel");
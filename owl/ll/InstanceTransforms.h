@@ -0,0 +1,60 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#pragma once
+
+#include "owl/common/math/AffineSpace.h"
+#include <optix.h>
+
+namespace owl {
+  namespace ll {
+    using owl::common::affine3f;
+    using owl::common::vec3f;
+
+    /*! writes given (column-major) affine transform into the
+        row-major 3x4 layout optix wants */
+    inline void setOptixInstanceTransform(OptixInstance &oi,
+                                          const affine3f &xfm)
+    {
+      oi.transform[0*4+0]  = xfm.l.vx.x;
+      oi.transform[0*4+1]  = xfm.l.vy.x;
+      oi.transform[0*4+2]  = xfm.l.vz.x;
+      oi.transform[0*4+3]  = xfm.p.x;
+        
+      oi.transform[1*4+0]  = xfm.l.vx.y;
+      oi.transform[1*4+1]  = xfm.l.vy.y;
+      oi.transform[1*4+2]  = xfm.l.vz.y;
+      oi.transform[1*4+3]  = xfm.p.y;
+        
+      oi.transform[2*4+0]  = xfm.l.vx.z;
+      oi.transform[2*4+1]  = xfm.l.vy.z;
+      oi.transform[2*4+2]  = xfm.l.vz.z;
+      oi.transform[2*4+3]  = xfm.p.z;
+    }
+
+    /*! the inverse of setOptixInstanceTransform() */
+    inline affine3f getOptixInstanceTransform(const OptixInstance &oi)
+    {
+      const float *t = oi.transform;
+      return affine3f(vec3f(t[0*4+0],t[1*4+0],t[2*4+0]),
+                      vec3f(t[0*4+1],t[1*4+1],t[2*4+1]),
+                      vec3f(t[0*4+2],t[1*4+2],t[2*4+2]),
+                      vec3f(t[0*4+3],t[1*4+3],t[2*4+3]));
+    }
+
+  } // ::owl::ll
+} //::owl
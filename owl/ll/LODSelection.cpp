@@ -0,0 +1,83 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "LODSelection.h"
+#include "owl/common/parallel/parallel_for.h"
+// std
+#include <algorithm>
+#include <stdexcept>
+
+namespace owl {
+  namespace ll {
+
+    /*! number of children each task picks levels for */
+    static const size_t childrenPerTask = 16*1024;
+
+    int selectLODLevel(const std::vector<float> &levelErrors,
+                       float distance,
+                       float scale,
+                       float threshold)
+    {
+      const float allowed = threshold * distance;
+      for (int level=(int)levelErrors.size()-1;level>0;--level)
+        if (levelErrors[level]*scale <= allowed)
+          return level;
+      return 0;
+    }
+
+    std::vector<int>
+    selectLODs(const std::vector<LODChild> &children,
+               const std::vector<std::vector<float>> &lodSetErrors,
+               const vec3f &cameraPos,
+               float threshold,
+               std::vector<int> &levels)
+    {
+      if (levels.size() != children.size())
+        throw std::runtime_error("LOD selection: number of levels does not "
+                                 "match number of children");
+      const size_t numChildren = children.size();
+      const size_t numTasks
+        = (numChildren+childrenPerTask-1)/childrenPerTask;
+      
+      // each task picks the levels of its own range of children, and
+      // remembers which of those changed ...
+      std::vector<std::vector<int>> changedPerTask(numTasks);
+      owl::common::parallel_for
+        (numTasks,[&](size_t taskID){
+          const size_t begin = taskID*childrenPerTask;
+          const size_t end   = std::min(numChildren,begin+childrenPerTask);
+          for (size_t childID=begin;childID<end;childID++) {
+            const LODChild &child = children[childID];
+            if (child.lodSet < 0) continue;
+            const float distance = length(child.position - cameraPos);
+            const int level
+              = selectLODLevel(lodSetErrors[child.lodSet],
+                               distance,child.scale,threshold);
+            if (level == levels[childID]) continue;
+            levels[childID] = level;
+            changedPerTask[taskID].push_back((int)childID);
+          }
+        });
+
+      // ... so concatenating them in task order keeps them sorted
+      std::vector<int> changed;
+      for (auto &taskChanged : changedPerTask)
+        changed.insert(changed.end(),taskChanged.begin(),taskChanged.end());
+      return changed;
+    }
+
+  } // ::owl::ll
+} //::owl
@@ -0,0 +1,73 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "owl/common/math/vec.h"
+// std
+#include <vector>
+
+namespace owl {
+  namespace ll {
+    using owl::common::vec3f;
+
+    /*! host-side level-of-detail selection for the children of an
+        instance group (see owlInstanceGroupSelectLOD). Each child
+        that uses an LOD set can reference any of that set's levels,
+        finest first; each level comes with the (object-space)
+        geometric error it has relative to the finest one. None of
+        this needs CUDA or optix. */
+
+    /*! what we need to know about one instance group child to pick
+        its LOD */
+    struct LODChild {
+      /*! index of the LOD set this child uses, or -1 if it does not
+          use one (and thus never changes) */
+      int   lodSet   = -1;
+      /*! world-space origin of the instance */
+      vec3f position = vec3f(0.f);
+      /*! largest scale factor of the instance's transform, which
+          is what its geometric errors get scaled with */
+      float scale    = 1.f;
+    };
+
+    /*! returns the coarsest level whose geometric error, as seen
+        from the given distance, is within 'threshold' - i.e., the
+        largest 'k' with levelErrors[k]*scale <= threshold*distance,
+        or the finest level (0) if none is. 'threshold' thus is the
+        allowed error per unit of distance, which is about the
+        allowed angular error in radians. levelErrors must be
+        non-decreasing. */
+    int selectLODLevel(const std::vector<float> &levelErrors,
+                       float distance,
+                       float scale,
+                       float threshold);
+
+    /*! picks the level for each child (in parallel) as seen from
+        the given camera position; 'levels' holds each child's
+        current level on input, and the newly selected one on
+        output. Returns the (sorted) indices of all children whose
+        level changed - these, and only these, need to be updated
+        in the instance group. */
+    std::vector<int>
+    selectLODs(const std::vector<LODChild> &children,
+               const std::vector<std::vector<float>> &lodSetErrors,
+               const vec3f &cameraPos,
+               float threshold,
+               std::vector<int> &levels);
+
+  } // ::owl::ll
+} //::owl
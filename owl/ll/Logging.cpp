@@ -0,0 +1,97 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#include "Logging.h"
+// std
+#include <iostream>
+#include <mutex>
+#include <ctype.h>
+#include <stdlib.h>
+
+namespace owl {
+  namespace ll {
+
+    /*! the current sink; never destroyed, so messages logged from
+        static destructors still have somewhere to go */
+    struct LogState {
+      std::mutex     mutex;
+      Logging::Sink  sink     = nullptr;
+      void          *userData = nullptr;
+    };
+
+    static LogState &state()
+    {
+      static LogState *s = new LogState;
+      return *s;
+    }
+    
+    /*! default value: INFO for debug builds and ERROR for release
+        builds, unless overridden by the OWL_LOG_LEVEL environment
+        variable */
+    static int initialLogLevel()
+    {
+      const char *fromEnv = getenv("OWL_LOG_LEVEL");
+      if (fromEnv && *fromEnv) {
+        static const char *names[] = {
+          "none", "error", "warning", "info", "debug"
+        };
+        std::string name = fromEnv;
+        for (auto &c : name) c = (char)tolower(c);
+        for (int i=0;i<5;i++)
+          if (name == names[i])
+            return i;
+        return atoi(fromEnv);
+      }
+#ifdef NDEBUG
+      return Logging::LEVEL_ERROR;
+#else
+      return Logging::LEVEL_INFO;
+#endif
+    }
+    
+    std::atomic<int> Logging::level { initialLogLevel() };
+
+    void Logging::setSink(Sink sink, void *userData)
+    {
+      LogState &s = state();
+      std::lock_guard<std::mutex> lock(s.mutex);
+      s.sink     = sink;
+      s.userData = userData;
+    }
+    
+    void Logging::emit(int level,
+                       const char *color,
+                       const std::string &message)
+    {
+      LogState &s = state();
+      std::lock_guard<std::mutex> lock(s.mutex);
+      if (s.sink) {
+        s.sink(level,message.c_str(),s.userData);
+        return;
+      }
+      if (color)
+        std::cout << color << message << OWL_TERMINAL_DEFAULT << '\n';
+      else
+        std::cout << message << '\n';
+      // only flush for messages the app should not miss if it
+      // crashes right after
+      if (level <= LEVEL_WARNING)
+        std::cout << std::flush;
+    }
+    
+  } // ::owl::ll
+} //::owl
@@ -0,0 +1,109 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#pragma once
+
+#include <owl/common/owl-common.h>
+// std
+#include <atomic>
+#include <sstream>
+#include <string>
+
+namespace owl {
+  namespace ll {
+
+    /*! runtime-configurable logging for all of OWL (ll and ng).
+
+        Every message has a level, and only gets formatted (and sent
+        to the sink) if that level is enabled. The default level is
+        INFO in debug builds and ERROR in release builds; either can
+        be overridden at runtime through the OWL_LOG_LEVEL environment
+        variable (a number, or one of "none", "error", "warning",
+        "info", "debug"), or through owlSetLogLevel()/lloSetLogLevel(),
+        so release binaries can produce debug logs, too. Like
+        validation this is a process-wide setting.
+
+        Messages that can show up once per launch, per group build, or
+        per SBT build are at DEBUG level. Messages go to stdout unless
+        the app installs a sink of its own (owlSetLogCallback()/
+        lloSetLogCallback()).
+
+        When a message's level is disabled, it costs a single
+        (predicted) branch on 'level' - none of the message's
+        arguments get evaluated. */
+    struct Logging {
+      enum {
+        LEVEL_NONE = 0,
+        LEVEL_ERROR,
+        LEVEL_WARNING,
+        LEVEL_INFO,
+        LEVEL_DEBUG
+      };
+
+      /*! a sink that messages get sent to instead of stdout; gets
+          called with the (plain, uncolored) message, without a
+          trailing newline */
+      typedef void (*Sink)(int32_t level,
+                           const char *message,
+                           void *userData);
+      
+      /*! highest level that currently gets logged; use through the
+          OWL_LOG() macros. Atomic since it gets changed while other
+          threads log, but only ever loaded relaxed */
+      static std::atomic<int> level;
+
+      static int  getLevel()
+      { return level.load(std::memory_order_relaxed); }
+      static void setLevel(int newLevel)
+      { level.store(newLevel,std::memory_order_relaxed); }
+
+      /*! installs the given sink; a null sink restores the default
+          (stdout) one. Once this returns, the previous sink will no
+          longer be called */
+      static void setSink(Sink sink, void *userData);
+
+      /*! sends an already-formatted message to the current sink;
+          'color' (which may be null) is only used by the default
+          sink. Messages never get interleaved, even when logged from
+          different threads */
+      static void emit(int level,
+                       const char *color,
+                       const std::string &message);
+    };
+    
+  } // ::owl::ll
+} //::owl
+
+/*! whether messages of the given level (eg, LEVEL_DEBUG) currently
+    get logged */
+#define OWL_LOG_ENABLED(lvl)                                    \
+  OWL_UNLIKELY(::owl::ll::Logging::lvl <= ::owl::ll::Logging::getLevel())
+
+/*! logs a message that gets formatted like a std::ostream
+    expression, eg 'OWL_LOG(LEVEL_INFO,"built " << n << " prims")'; the
+    message only gets evaluated if the given level is enabled */
+#define OWL_LOG_COLOR(lvl,color,message)                        \
+  do {                                                          \
+    if (OWL_LOG_ENABLED(lvl)) {                                 \
+      std::stringstream owl_log_ss;                             \
+      owl_log_ss << message;                                    \
+      ::owl::ll::Logging::emit(::owl::ll::Logging::lvl,         \
+                               color,owl_log_ss.str());         \
+    }                                                           \
+  } while (0)
+
+#define OWL_LOG(lvl,message) OWL_LOG_COLOR(lvl,nullptr,message)
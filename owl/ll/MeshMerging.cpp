@@ -0,0 +1,97 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "MeshMerging.h"
+#include "owl/common/parallel/parallel_for.h"
+// std
+#include <cstring>
+#include <stdexcept>
+
+namespace owl {
+  namespace ll {
+
+    std::vector<MeshRun>
+    planMeshMerging(const std::vector<size_t> &triangleCounts,
+                    const std::vector<int>    &geomTypes,
+                    size_t maxTrianglesPerMesh,
+                    size_t maxTrianglesPerRun)
+    {
+      if (geomTypes.size() != triangleCounts.size())
+        throw std::runtime_error("mesh merging: number of geom types does "
+                                 "not match number of meshes");
+      std::vector<MeshRun> runs;
+      size_t trianglesInRun = 0;
+      bool   runIsMergeable = false;
+      for (int child=0;child<(int)triangleCounts.size();child++) {
+        const size_t numTriangles = triangleCounts[child];
+        const bool   isSmall      = numTriangles <= maxTrianglesPerMesh;
+        if (runIsMergeable && isSmall
+            && geomTypes[child] == geomTypes[runs.back().firstChild]
+            && trianglesInRun + numTriangles <= maxTrianglesPerRun) {
+          runs.back().numChildren++;
+          trianglesInRun += numTriangles;
+          continue;
+        }
+        runs.push_back({ child, 1 });
+        trianglesInRun = numTriangles;
+        runIsMergeable = isSmall;
+      }
+      return runs;
+    }
+
+    MergedMesh mergeMeshes(const std::vector<MeshView> &meshes)
+    {
+      MergedMesh merged;
+      merged.primBegin.resize(meshes.size());
+      merged.vertexBegin.resize(meshes.size());
+      size_t numPrims = 0, numVertices = 0;
+      for (size_t meshID=0;meshID<meshes.size();meshID++) {
+        merged.primBegin[meshID]   = numPrims;
+        merged.vertexBegin[meshID] = numVertices;
+        numPrims    += meshes[meshID].indexCount;
+        numVertices += meshes[meshID].vertexCount;
+      }
+      merged.vertices.resize(numVertices);
+      merged.indices.resize(numPrims);
+      merged.meshOfPrim.resize(numPrims);
+
+      // each mesh writes to its own, fixed range of the output
+      owl::common::parallel_for
+        (meshes.size(),[&](size_t meshID){
+          const MeshView &mesh = meshes[meshID];
+          const uint8_t *vertices = (const uint8_t *)mesh.vertices;
+          const uint8_t *indices  = (const uint8_t *)mesh.indices;
+          const size_t   vertexBegin = merged.vertexBegin[meshID];
+          const size_t   primBegin   = merged.primBegin[meshID];
+          // (memcpy, since strided inputs need not be aligned)
+          for (size_t i=0;i<mesh.vertexCount;i++) {
+            float v[3];
+            memcpy(v,vertices+i*mesh.vertexStride,sizeof(v));
+            merged.vertices[vertexBegin+i] = vec3f(v[0],v[1],v[2]);
+          }
+          for (size_t i=0;i<mesh.indexCount;i++) {
+            int idx[3];
+            memcpy(idx,indices+i*mesh.indexStride,sizeof(idx));
+            merged.indices[primBegin+i]
+              = vec3i(idx[0],idx[1],idx[2]) + vec3i((int)vertexBegin);
+            merged.meshOfPrim[primBegin+i] = (uint32_t)meshID;
+          }
+        });
+      return merged;
+    }
+
+  } // ::owl::ll
+} //::owl
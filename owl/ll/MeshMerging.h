@@ -0,0 +1,100 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "owl/common/math/vec.h"
+// std
+#include <cstdint>
+#include <vector>
+
+namespace owl {
+  namespace ll {
+    using owl::common::vec3f;
+    using owl::common::vec3i;
+
+    /*! host-side logic for merging many small triangle meshes of a
+        triangles geom group into fewer, larger build inputs (see
+        lloTrianglesGeomGroupSetMeshMerging). A merged build input
+        uses one SBT record per original geom, and a per-primitive SBT
+        index offset that says which geom each primitive came from -
+        so the SBT layout of the group stays exactly the same as
+        without merging, and each primitive still finds its original
+        geom's SBT data. Each geom's hit records also get where its
+        primitives start in the merged mesh, which is what
+        owl::getPrimitiveIndexInGeom() uses to map merged primitive
+        IDs back to the geom's own.
+
+        None of this needs CUDA or optix, so it can be tested on the
+        host. */
+
+    /*! a run of consecutive children of a geom group that go into
+        the same build input; runs with a single child get built
+        from that child's own arrays, as without merging */
+    struct MeshRun {
+      int firstChild;
+      int numChildren;
+    };
+
+    /*! splits the children of a triangles geom group (given by their
+        triangle counts and geom types) into runs of consecutive
+        children: children with at most 'maxTrianglesPerMesh'
+        triangles get merged with their direct neighbours as long as
+        those are also small, are of the same geom type, and the run
+        doesn't exceed 'maxTrianglesPerRun' triangles. Every child
+        appears in exactly one run, in order. */
+    std::vector<MeshRun>
+    planMeshMerging(const std::vector<size_t> &triangleCounts,
+                    const std::vector<int>    &geomTypes,
+                    size_t maxTrianglesPerMesh,
+                    size_t maxTrianglesPerRun);
+
+    /*! host view of one mesh's arrays; vertices are float3s, indices
+        int3s, each at the given stride in bytes */
+    struct MeshView {
+      const void *vertices;
+      size_t      vertexStride;
+      size_t      vertexCount;
+      const void *indices;
+      size_t      indexStride;
+      size_t      indexCount;
+    };
+
+    /*! the result of merging a run of meshes: tightly packed
+        vertices and indices, plus what maps each merged primitive
+        back to where it came from */
+    struct MergedMesh {
+      std::vector<vec3f>    vertices;
+      /*! indices into 'vertices', i.e., each mesh's indices offset
+          by that mesh's vertexBegin */
+      std::vector<vec3i>    indices;
+      /*! for each merged primitive, the index (within the run) of
+          the mesh it came from; this is what goes into the build
+          input's SBT index offset buffer */
+      std::vector<uint32_t> meshOfPrim;
+      /*! for each mesh, where its primitives / vertices start in the
+          merged arrays (so primitive 'i' of a mesh is merged
+          primitive primBegin+i) */
+      std::vector<size_t>   primBegin;
+      std::vector<size_t>   vertexBegin;
+    };
+
+    /*! concatenates the given meshes (in parallel, one task per
+        mesh) into one merged mesh */
+    MergedMesh mergeMeshes(const std::vector<MeshView> &meshes);
+
+  } // ::owl::ll
+} //::owl
@@ -0,0 +1,287 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#include "Metrics.h"
+// std
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+namespace owl {
+  namespace ll {
+
+    namespace {
+      /*! one thread's counts. Only the owning thread ever writes, so
+          the atomics are only there to make reading from other
+          threads well-defined; all accesses are relaxed, and updates
+          are plain load-add-store (no locked instructions) */
+      struct MetricsBlock {
+        struct Histogram {
+          std::atomic<uint64_t> count   { 0 };
+          std::atomic<uint64_t> sum     { 0 };
+          std::atomic<uint64_t> max     { 0 };
+          std::atomic<uint64_t> buckets[Metrics::NUM_BUCKETS];
+        };
+        MetricsBlock()
+        {
+          for (auto &c : counters) c.store(0,std::memory_order_relaxed);
+          for (auto &h : histograms)
+            for (auto &b : h.buckets) b.store(0,std::memory_order_relaxed);
+        }
+        std::atomic<uint64_t> counters[Metrics::MAX_COUNTERS];
+        Histogram             histograms[Metrics::MAX_HISTOGRAMS];
+      };
+
+      inline void addTo(std::atomic<uint64_t> &a, uint64_t value)
+      {
+        a.store(a.load(std::memory_order_relaxed)+value,
+                std::memory_order_relaxed);
+      }
+      
+      /*! names and all blocks ever created; like the tracer's state
+          this never gets destroyed, so threads (and static
+          destructors) can still count during exit */
+      struct MetricsState {
+        std::mutex mutex;
+        std::vector<std::string> counterNames;
+        std::vector<std::string> histogramNames;
+        std::map<std::string,int> counterIDs;
+        std::map<std::string,int> histogramIDs;
+        std::vector<std::unique_ptr<MetricsBlock>> blocks;
+        /*! blocks whose threads have exited */
+        std::vector<MetricsBlock *> freeBlocks;
+      };
+
+      MetricsState &state()
+      {
+        static MetricsState *state = new MetricsState;
+        return *state;
+      }
+
+      /*! hands the calling thread's block back when the thread
+          exits */
+      struct ThreadBlock {
+        ~ThreadBlock()
+        {
+          if (!block) return;
+          MetricsState &s = state();
+          std::lock_guard<std::mutex> lock(s.mutex);
+          s.freeBlocks.push_back(block);
+        }
+        MetricsBlock *block = nullptr;
+      };
+      
+      thread_local ThreadBlock threadBlock;
+
+      MetricsBlock *acquireBlock()
+      {
+        MetricsState &s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (!s.freeBlocks.empty()) {
+          MetricsBlock *block = s.freeBlocks.back();
+          s.freeBlocks.pop_back();
+          return block;
+        }
+        s.blocks.emplace_back(new MetricsBlock);
+        return s.blocks.back().get();
+      }
+      
+      inline MetricsBlock &myBlock()
+      {
+        MetricsBlock *block = threadBlock.block;
+        if (OWL_UNLIKELY(!block))
+          block = threadBlock.block = acquireBlock();
+        return *block;
+      }
+
+      int lookupOrCreate(std::map<std::string,int> &ids,
+                         std::vector<std::string> &names,
+                         const std::string &name,
+                         size_t maxCount,
+                         const char *what)
+      {
+        auto it = ids.find(name);
+        if (it != ids.end())
+          return it->second;
+        if (names.size() >= maxCount)
+          throw std::runtime_error("too many different owl metrics "
+                                   +std::string(what)+" (when adding '"
+                                   +name+"')");
+        const int id = (int)names.size();
+        names.push_back(name);
+        ids[name] = id;
+        return id;
+      }
+
+      /*! splits 'name{labels}' into 'name' and 'labels' */
+      void splitLabels(const std::string &fullName,
+                       std::string &name,
+                       std::string &labels)
+      {
+        const size_t pos = fullName.find('{');
+        if (pos == std::string::npos) {
+          name   = fullName;
+          labels = "";
+        } else {
+          name   = fullName.substr(0,pos);
+          labels = fullName.substr(pos+1,fullName.size()-pos-2);
+        }
+      }
+    }
+
+    int Metrics::counterID(const std::string &name)
+    {
+      MetricsState &s = state();
+      std::lock_guard<std::mutex> lock(s.mutex);
+      return lookupOrCreate(s.counterIDs,s.counterNames,name,
+                            MAX_COUNTERS,"counters");
+    }
+    
+    int Metrics::histogramID(const std::string &name)
+    {
+      MetricsState &s = state();
+      std::lock_guard<std::mutex> lock(s.mutex);
+      return lookupOrCreate(s.histogramIDs,s.histogramNames,name,
+                            MAX_HISTOGRAMS,"histograms");
+    }
+
+    void Metrics::add(int counterID, uint64_t value)
+    {
+      addTo(myBlock().counters[counterID],value);
+    }
+
+    int Metrics::bucketOf(uint64_t ns)
+    {
+      int bucket = 0;
+      while (ns) { bucket++; ns >>= 1; }
+      return std::min(bucket,(int)NUM_BUCKETS-1);
+    }
+    
+    void Metrics::record(int histogramID, uint64_t ns)
+    {
+      MetricsBlock::Histogram &h = myBlock().histograms[histogramID];
+      addTo(h.count,1);
+      addTo(h.sum,ns);
+      addTo(h.buckets[bucketOf(ns)],1);
+      if (ns > h.max.load(std::memory_order_relaxed))
+        h.max.store(ns,std::memory_order_relaxed);
+    }
+
+    Metrics::Snapshot Metrics::snapshot()
+    {
+      MetricsState &s = state();
+      std::lock_guard<std::mutex> lock(s.mutex);
+      Snapshot result;
+      result.counters.resize(s.counterNames.size());
+      for (size_t i=0;i<s.counterNames.size();i++) {
+        Snapshot::Counter &c = result.counters[i];
+        c.name  = s.counterNames[i];
+        c.value = 0;
+        for (auto &block : s.blocks)
+          c.value += block->counters[i].load(std::memory_order_relaxed);
+      }
+      result.histograms.resize(s.histogramNames.size());
+      for (size_t i=0;i<s.histogramNames.size();i++) {
+        Snapshot::Histogram &h = result.histograms[i];
+        h.name  = s.histogramNames[i];
+        h.count = h.sum = h.max = 0;
+        std::fill(h.buckets,h.buckets+NUM_BUCKETS,0);
+        for (auto &block : s.blocks) {
+          const MetricsBlock::Histogram &bh = block->histograms[i];
+          h.count += bh.count.load(std::memory_order_relaxed);
+          h.sum   += bh.sum.load(std::memory_order_relaxed);
+          h.max    = std::max(h.max,(uint64_t)bh.max.load(std::memory_order_relaxed));
+          for (int b=0;b<NUM_BUCKETS;b++)
+            h.buckets[b] += bh.buckets[b].load(std::memory_order_relaxed);
+        }
+      }
+      // sorted by name, so all labels of a metric are next to each
+      // other (as the text format wants them)
+      std::sort(result.counters.begin(),result.counters.end(),
+                [](const Snapshot::Counter &a, const Snapshot::Counter &b)
+                { return a.name < b.name; });
+      std::sort(result.histograms.begin(),result.histograms.end(),
+                [](const Snapshot::Histogram &a, const Snapshot::Histogram &b)
+                { return a.name < b.name; });
+      return result;
+    }
+
+    uint64_t Metrics::Snapshot::counter(const std::string &name) const
+    {
+      for (auto &c : counters)
+        if (c.name == name) return c.value;
+      return 0;
+    }
+
+    const Metrics::Snapshot::Histogram *
+    Metrics::Snapshot::histogram(const std::string &name) const
+    {
+      for (auto &h : histograms)
+        if (h.name == name) return &h;
+      return nullptr;
+    }
+
+    std::string Metrics::Snapshot::toText() const
+    {
+      std::stringstream out;
+      out << std::setprecision(9);
+      std::string lastName;
+      auto writeValues = [&](const std::vector<Counter> &values,
+                             const char *type) {
+        for (auto &c : values) {
+          std::string name, labels;
+          splitLabels(c.name,name,labels);
+          if (name != lastName)
+            out << "# TYPE " << name << " " << type << "\n";
+          lastName = name;
+          out << c.name << " " << c.value << "\n";
+        }
+      };
+      writeValues(counters,"counter");
+      writeValues(gauges,"gauge");
+      for (auto &h : histograms) {
+        std::string name, labels;
+        splitLabels(h.name,name,labels);
+        if (name != lastName)
+          out << "# TYPE " << name << " histogram\n";
+        lastName = name;
+        const std::string sep = labels.empty() ? "" : ",";
+        // skip the (empty) buckets above the largest value
+        const int lastBucket = bucketOf(h.max);
+        uint64_t cumulative = 0;
+        for (int b=0;b<lastBucket;b++) {
+          cumulative += h.buckets[b];
+          out << name << "_bucket{" << labels << sep
+              << "le=\"" << (double(uint64_t(1)<<b)*1e-9) << "\"} "
+              << cumulative << "\n";
+        }
+        out << name << "_bucket{" << labels << sep << "le=\"+Inf\"} "
+            << h.count << "\n";
+        const std::string braced = labels.empty() ? "" : "{"+labels+"}";
+        out << name << "_sum" << braced << " " << (h.sum*1e-9) << "\n";
+        out << name << "_count" << braced << " " << h.count << "\n";
+      }
+      return out.str();
+    }
+    
+  } // ::owl::ll
+} //::owl
@@ -0,0 +1,150 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#pragma once
+
+#include <owl/common/owl-common.h>
+// std
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace owl {
+  namespace ll {
+
+    /*! always-on aggregate metrics - counters (SBT records written,
+        buffer bytes uploaded, API calls per entry point, ...) and
+        latency histograms (accel builds per kind, ...) - meant to be
+        cheap enough to leave on in production, and to get scraped
+        through owlContextGetMetrics().
+
+        Each thread counts into a block of its own, so counting
+        neither locks nor shares cache lines with other threads; the
+        blocks only get merged when somebody takes a snapshot. Blocks
+        of threads that exited get reused by new threads (their
+        counts still go into the totals). Like tracing and logging,
+        metrics are process-wide, not per context.
+
+        Metrics are identified by name; names may carry labels in the
+        Prometheus text format, eg 'owl_api_calls_total{entry="x"}'. */
+    struct Metrics {
+      enum {
+        MAX_COUNTERS   = 512,
+        MAX_HISTOGRAMS = 32,
+        /*! histogram bucket 'i' counts values in [2^(i-1),2^i)
+            nanoseconds (bucket 0 only counts zeros); the last bucket
+            also counts everything above */
+        NUM_BUCKETS    = 48
+      };
+
+      /*! a merged copy of all metrics at one point in time */
+      struct Snapshot {
+        struct Counter {
+          std::string name;
+          uint64_t    value;
+        };
+        struct Histogram {
+          std::string name;
+          uint64_t    count;
+          /*! sum and max of all recorded values, in nanoseconds */
+          uint64_t    sum;
+          uint64_t    max;
+          uint64_t    buckets[NUM_BUCKETS];
+        };
+
+        /*! returns the counter with the given name, or 0 if there is
+            no such counter (yet) */
+        uint64_t counter(const std::string &name) const;
+
+        /*! returns the histogram with the given name, or null */
+        const Histogram *histogram(const std::string &name) const;
+
+        /*! writes all metrics in the Prometheus text exposition
+            format (histograms in seconds, with cumulative buckets) */
+        std::string toText() const;
+        
+        std::vector<Counter>   counters;
+        /*! current values (as opposed to running totals); the
+            registry itself doesn't track any, but whoever takes the
+            snapshot can add some, such as per-context ones */
+        std::vector<Counter>   gauges;
+        std::vector<Histogram> histograms;
+      };
+
+      /*! returns the ID of the counter with the given name, creating
+          that counter if required; throws if there are more than
+          MAX_COUNTERS different ones. Use through OWL_COUNTER_ADD() */
+      static int counterID(const std::string &name);
+
+      /*! same for histograms */
+      static int histogramID(const std::string &name);
+
+      /*! adds 'value' to the calling thread's copy of the given
+          counter */
+      static void add(int counterID, uint64_t value);
+
+      /*! adds one value (in nanoseconds) to the calling thread's copy
+          of the given histogram */
+      static void record(int histogramID, uint64_t ns);
+
+      /*! the histogram bucket a given value goes into */
+      static int bucketOf(uint64_t ns);
+      
+      /*! merges all threads' blocks, sorted by name; may be called
+          while other threads keep counting */
+      static Snapshot snapshot();
+    };
+
+    /*! records how long its own lifetime took into a histogram */
+    struct MetricsTimer {
+      inline MetricsTimer(int histogramID)
+        : histogramID(histogramID),
+          begin(std::chrono::steady_clock::now())
+      {}
+      inline ~MetricsTimer()
+      {
+        Metrics::record(histogramID,
+                        std::chrono::duration_cast<std::chrono::nanoseconds>
+                        (std::chrono::steady_clock::now()-begin).count());
+      }
+      const int histogramID;
+      const std::chrono::steady_clock::time_point begin;
+    };
+    
+  } // ::owl::ll
+} //::owl
+
+#define OWL_METRICS_CONCAT_(a,b) a##b
+#define OWL_METRICS_CONCAT(a,b) OWL_METRICS_CONCAT_(a,b)
+
+/*! adds 'value' to the counter of the given name; the name only
+    gets looked up the first time this line executes, so it has to
+    be the same every time */
+#define OWL_COUNTER_ADD(name,value)                                     \
+  do {                                                                  \
+    static const int owlCounterID = ::owl::ll::Metrics::counterID(name); \
+    ::owl::ll::Metrics::add(owlCounterID,value);                        \
+  } while (0)
+
+/*! records how long the rest of the enclosing scope takes into the
+    histogram of the given name (with the same restriction as for
+    OWL_COUNTER_ADD()) */
+#define OWL_HISTOGRAM_SCOPE(name)                                       \
+  static const int OWL_METRICS_CONCAT(owlHistogramID,__LINE__)          \
+    = ::owl::ll::Metrics::histogramID(name);                            \
+  ::owl::ll::MetricsTimer OWL_METRICS_CONCAT(owlMetricsTimer,__LINE__)  \
+    (OWL_METRICS_CONCAT(owlHistogramID,__LINE__))
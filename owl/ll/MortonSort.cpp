@@ -0,0 +1,155 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "MortonSort.h"
+#include "owl/common/parallel/parallel_for.h"
+// std
+#include <algorithm>
+#include <stdexcept>
+
+namespace owl {
+  namespace ll {
+
+    /*! number of bits sorted per radix pass; 6 passes cover the 63
+        bits of our morton codes */
+    static const int    radixBits   = 11;
+    static const size_t numBuckets  = size_t(1) << radixBits;
+    /*! number of keys each block of a radix pass works on; blocks
+        are what we parallelize over */
+    static const size_t keysPerBlock = 64*1024;
+
+    /*! spreads the lower 21 bits of 'v' out such that there are two
+        zero bits between each pair of bits */
+    static inline uint64_t spreadBits21(uint64_t v)
+    {
+      v &= 0x1fffffULL;
+      v = (v | v << 32) & 0x1f00000000ffffULL;
+      v = (v | v << 16) & 0x1f0000ff0000ffULL;
+      v = (v | v <<  8) & 0x100f00f00f00f00fULL;
+      v = (v | v <<  4) & 0x10c30c30c30c30c3ULL;
+      v = (v | v <<  2) & 0x1249249249249249ULL;
+      return v;
+    }
+
+    /*! quantizes one coordinate to 21 bits */
+    static inline uint64_t quantize21(float v, float lo, float hi)
+    {
+      const float extent = hi - lo;
+      if (!(extent > 0.f)) return 0;
+      const float rel = (v - lo) / extent;
+      const float maxVal = float((1<<21)-1);
+      return (uint64_t)std::max(0.f,std::min(maxVal,rel*maxVal));
+    }
+
+    uint64_t mortonCode63(const vec3f &point, const box3f &bounds)
+    {
+      const uint64_t x = quantize21(point.x,bounds.lower.x,bounds.upper.x);
+      const uint64_t y = quantize21(point.y,bounds.lower.y,bounds.upper.y);
+      const uint64_t z = quantize21(point.z,bounds.lower.z,bounds.upper.z);
+      return (spreadBits21(x) << 2) | (spreadBits21(y) << 1) | spreadBits21(z);
+    }
+
+    std::vector<uint32_t> radixSortOrder(const std::vector<uint64_t> &keys)
+    {
+      if (keys.size() > (size_t)UINT32_MAX)
+        throw std::runtime_error("too many keys for radix sort");
+      const size_t numKeys = keys.size();
+      std::vector<uint32_t> order(numKeys), tmpOrder(numKeys);
+      std::vector<uint64_t> sorted(keys), tmpSorted(numKeys);
+      for (size_t i=0;i<numKeys;i++) order[i] = (uint32_t)i;
+      if (numKeys < 2)
+        return order;
+
+      // no need to sort bits that are zero in all keys
+      uint64_t allBits = 0;
+      for (auto key : keys) allBits |= key;
+      
+      const size_t numBlocks = (numKeys+keysPerBlock-1)/keysPerBlock;
+      std::vector<size_t> offsets(numBlocks*numBuckets);
+      for (int shift=0;shift<64 && (allBits >> shift);shift+=radixBits) {
+        // per-block histograms ...
+        owl::common::parallel_for
+          (numBlocks,[&](size_t blockID){
+            size_t *count = &offsets[blockID*numBuckets];
+            std::fill(count,count+numBuckets,0);
+            const size_t begin = blockID*keysPerBlock;
+            const size_t end   = std::min(numKeys,begin+keysPerBlock);
+            for (size_t i=begin;i<end;i++)
+              count[(sorted[i] >> shift) & (numBuckets-1)]++;
+          });
+        // ... turned into per-(bucket,block) output offsets; going
+        // over blocks in order for each bucket is what keeps the sort
+        // stable ...
+        size_t sum = 0;
+        for (size_t bucket=0;bucket<numBuckets;bucket++)
+          for (size_t blockID=0;blockID<numBlocks;blockID++) {
+            size_t &offset = offsets[blockID*numBuckets+bucket];
+            const size_t count = offset;
+            offset = sum;
+            sum += count;
+          }
+        // ... and each block scatters its keys to its own ranges
+        owl::common::parallel_for
+          (numBlocks,[&](size_t blockID){
+            size_t *offset = &offsets[blockID*numBuckets];
+            const size_t begin = blockID*keysPerBlock;
+            const size_t end   = std::min(numKeys,begin+keysPerBlock);
+            for (size_t i=begin;i<end;i++) {
+              const size_t pos
+                = offset[(sorted[i] >> shift) & (numBuckets-1)]++;
+              tmpSorted[pos] = sorted[i];
+              tmpOrder[pos]  = order[i];
+            }
+          });
+        sorted.swap(tmpSorted);
+        order.swap(tmpOrder);
+      }
+      return order;
+    }
+
+    std::vector<uint32_t> mortonOrder(const std::vector<vec3f> &points)
+    {
+      const size_t numPoints = points.size();
+      const size_t numBlocks = (numPoints+keysPerBlock-1)/keysPerBlock;
+      
+      // bounds, as a parallel reduction over blocks
+      std::vector<box3f> blockBounds(numBlocks);
+      owl::common::parallel_for
+        (numBlocks,[&](size_t blockID){
+          const size_t begin = blockID*keysPerBlock;
+          const size_t end   = std::min(numPoints,begin+keysPerBlock);
+          box3f bounds;
+          for (size_t i=begin;i<end;i++)
+            bounds.extend(points[i]);
+          blockBounds[blockID] = bounds;
+        });
+      box3f bounds;
+      for (auto &bb : blockBounds)
+        if (!bb.empty()) bounds.extend(bb);
+
+      std::vector<uint64_t> keys(numPoints);
+      owl::common::parallel_for
+        (numBlocks,[&](size_t blockID){
+          const size_t begin = blockID*keysPerBlock;
+          const size_t end   = std::min(numPoints,begin+keysPerBlock);
+          for (size_t i=begin;i<end;i++)
+            keys[i] = mortonCode63(points[i],bounds);
+        });
+      return radixSortOrder(keys);
+    }
+
+  } // ::owl::ll
+} //::owl
@@ -0,0 +1,53 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "owl/common/math/box.h"
+// std
+#include <cstdint>
+#include <vector>
+
+namespace owl {
+  namespace ll {
+    using owl::common::vec3f;
+    using owl::common::box3f;
+
+    /*! host-side spatial sorting of instances, used to emit the
+        instances of an instance group in morton order (see
+        lloInstanceGroupSetSpatialSort), which gives the IAS builder
+        (and, later, traversal) much better memory locality than the
+        app's creation order. None of this needs CUDA or optix. */
+
+    /*! computes the 63-bit morton code (21 bits per axis) of the
+        given point, quantized relative to the given bounds; points
+        outside the bounds get clamped */
+    uint64_t mortonCode63(const vec3f &point, const box3f &bounds);
+
+    /*! stable, parallel LSD radix sort of the given 64-bit keys;
+        returns the permutation that sorts them, i.e., 'order[i]' is
+        the index of the key that ends up in slot 'i'. Equal keys
+        keep their relative input order. */
+    std::vector<uint32_t> radixSortOrder(const std::vector<uint64_t> &keys);
+
+    /*! returns the order in which to emit the given points to get
+        them sorted by their morton codes (relative to their common
+        bounds); keys get computed in parallel, and sorted with
+        radixSortOrder() */
+    std::vector<uint32_t> mortonOrder(const std::vector<vec3f> &points);
+
+  } // ::owl::ll
+} //::owl
@@ -0,0 +1,296 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "PerfCounters.h"
+#include "Metrics.h"
+#include "Logging.h"
+// std
+#include <cstring>
+#include <mutex>
+#include <stdlib.h>
+#if OWL_PERF_COUNTERS && defined(__linux__)
+# define OWL_HAVE_PERF_EVENTS 1
+# include <errno.h>
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#else
+# define OWL_HAVE_PERF_EVENTS 0
+#endif
+
+namespace owl {
+  namespace ll {
+
+    namespace {
+      /*! why the counters are not available, if they aren't; never
+          destroyed, like the other process-wide state */
+      struct PerfState {
+        std::mutex  mutex;
+        std::string unavailableReason;
+        bool        warned = false;
+      };
+
+      PerfState &state()
+      {
+        static PerfState *state = new PerfState;
+        return *state;
+      }
+
+      /*! metrics counter IDs, per phase: [0] counts scopes, [1+e]
+          the counts of event 'e' */
+      struct PerfMetricIDs {
+        PerfMetricIDs()
+        {
+          for (int phase=0;phase<PerfCounters::NUM_PHASES;phase++)
+            for (int event=-1;event<PerfCounters::NUM_EVENTS;event++)
+              ids[phase][1+event]
+                = Metrics::counterID(PerfCounters::metricName(phase,event));
+        }
+        int ids[PerfCounters::NUM_PHASES][1+PerfCounters::NUM_EVENTS];
+      };
+
+      const PerfMetricIDs &metricIDs()
+      {
+        static PerfMetricIDs *ids = new PerfMetricIDs;
+        return *ids;
+      }
+
+      /*! marks the counters as not available (on this machine, or
+          at least in this process), and warns about it once */
+      void markUnavailable(const std::string &reason)
+      {
+        PerfState &s = state();
+        bool warn = false;
+        {
+          std::lock_guard<std::mutex> lock(s.mutex);
+          s.unavailableReason = reason;
+          warn = !s.warned;
+          s.warned = true;
+        }
+        PerfCounters::active = false;
+        if (warn)
+          OWL_LOG(LEVEL_WARNING,"#owl.ll: hardware performance counters "
+                  "are not available (" << reason << "); disabling them");
+      }
+      
+#if OWL_HAVE_PERF_EVENTS
+      /*! the calling thread's counters: one perf event group, led by
+          the first event that could be opened */
+      struct ThreadCounters {
+        enum { UNTRIED, OPEN, FAILED };
+        
+        ~ThreadCounters()
+        {
+          for (int i=0;i<numOpen;i++)
+            close(fds[i]);
+        }
+
+        /*! tries to open all events; returns false if none could be
+            opened, with the first error in 'error' */
+        bool open(int &error)
+        {
+          static const uint64_t configs[PerfCounters::NUM_EVENTS] = {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES
+          };
+          error = 0;
+          for (int event=0;event<PerfCounters::NUM_EVENTS;event++) {
+            perf_event_attr attr;
+            memset(&attr,0,sizeof(attr));
+            attr.size           = sizeof(attr);
+            attr.type           = PERF_TYPE_HARDWARE;
+            attr.config         = configs[event];
+            // user space only, which is also what unprivileged
+            // processes get to see with perf_event_paranoid=2
+            attr.exclude_kernel = 1;
+            attr.exclude_hv     = 1;
+            attr.read_format
+              = PERF_FORMAT_GROUP
+              | PERF_FORMAT_TOTAL_TIME_ENABLED
+              | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            const int leader = numOpen ? fds[0] : -1;
+            const int fd
+              = (int)syscall(__NR_perf_event_open,&attr,
+                             /*this thread*/0,/*any cpu*/-1,
+                             leader,PERF_FLAG_FD_CLOEXEC);
+            if (fd < 0) {
+              if (!error) error = errno;
+              continue;
+            }
+            fds[numOpen]    = fd;
+            events[numOpen] = event;
+            numOpen++;
+          }
+          state = numOpen ? OPEN : FAILED;
+          return numOpen > 0;
+        }
+        
+        bool read(PerfCounters::Reading &reading)
+        {
+          // nr, time enabled, time running, then one value per event
+          uint64_t buffer[3+PerfCounters::NUM_EVENTS];
+          const ssize_t expected = (3+numOpen)*sizeof(uint64_t);
+          if (::read(fds[0],buffer,expected) != expected)
+            return false;
+          reading.timeEnabled = buffer[1];
+          reading.timeRunning = buffer[2];
+          for (int event=0;event<PerfCounters::NUM_EVENTS;event++)
+            reading.values[event] = 0;
+          for (int i=0;i<numOpen;i++)
+            reading.values[events[i]] = buffer[3+i];
+          return true;
+        }
+        
+        int state   = UNTRIED;
+        int numOpen = 0;
+        int fds[PerfCounters::NUM_EVENTS];
+        int events[PerfCounters::NUM_EVENTS];
+      };
+
+      thread_local ThreadCounters threadCounters;
+      
+      std::string openError(int error)
+      {
+        std::string reason
+          = std::string("perf_event_open: ")+strerror(error);
+        if (error == EACCES || error == EPERM)
+          reason += "; see /proc/sys/kernel/perf_event_paranoid";
+        return reason;
+      }
+#endif
+    }
+
+    /*! default value: on if the OWL_PERF_COUNTERS environment
+        variable says so (whether the counters can actually be
+        opened only shows once a thread first reads them) */
+    static bool initialPerfCountersState()
+    {
+      const char *fromEnv = getenv("OWL_PERF_COUNTERS");
+      return OWL_HAVE_PERF_EVENTS && fromEnv && atoi(fromEnv) != 0;
+    }
+    
+    bool PerfCounters::active = initialPerfCountersState();
+
+    bool PerfCounters::setEnabled(bool enabled)
+    {
+      if (!enabled) {
+        active = false;
+        return false;
+      }
+#if OWL_HAVE_PERF_EVENTS
+      ThreadCounters &tc = threadCounters;
+      if (tc.state == ThreadCounters::UNTRIED) {
+        int error = 0;
+        if (!tc.open(error)) {
+          markUnavailable(openError(error));
+          return false;
+        }
+      }
+      if (tc.state != ThreadCounters::OPEN)
+        return false;
+      {
+        PerfState &s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.unavailableReason.clear();
+      }
+      active = true;
+      return true;
+#else
+      markUnavailable("owl was built without OWL_PERF_COUNTERS, or not "
+                      "for linux");
+      return false;
+#endif
+    }
+
+    std::string PerfCounters::status()
+    {
+      PerfState &s = state();
+      std::lock_guard<std::mutex> lock(s.mutex);
+      if (active)
+        return "active";
+      if (!s.unavailableReason.empty())
+        return "unavailable: "+s.unavailableReason;
+      return "disabled";
+    }
+
+    const char *PerfCounters::phaseName(int phase)
+    {
+      static const char *names[NUM_PHASES]
+        = { "sbt_build", "instance_packing", "variable_writes", "registry" };
+      return (phase >= 0 && phase < NUM_PHASES) ? names[phase] : "invalid";
+    }
+    
+    const char *PerfCounters::eventName(int event)
+    {
+      static const char *names[NUM_EVENTS]
+        = { "cycles", "instructions", "cache_misses", "branch_misses" };
+      return (event >= 0 && event < NUM_EVENTS) ? names[event] : "invalid";
+    }
+
+    std::string PerfCounters::metricName(int phase, int event)
+    {
+      return std::string("owl_perf_")
+        + (event < 0 ? "scopes" : eventName(event))
+        + "_total{phase=\"" + phaseName(phase) + "\"}";
+    }
+
+    bool PerfCounters::read(Reading &reading)
+    {
+#if OWL_HAVE_PERF_EVENTS
+      ThreadCounters &tc = threadCounters;
+      if (OWL_UNLIKELY(tc.state == ThreadCounters::UNTRIED)) {
+        int error = 0;
+        if (!tc.open(error)) {
+          // on a machine where nobody gets to use them, stop trying
+          markUnavailable(openError(error));
+          return false;
+        }
+      }
+      return tc.state == ThreadCounters::OPEN && tc.read(reading);
+#else
+      (void)reading;
+      return false;
+#endif
+    }
+
+    void PerfCounters::accumulate(int phase, const Reading &begin)
+    {
+      Reading end;
+      if (!read(end))
+        return;
+      const PerfMetricIDs &ids = metricIDs();
+      Metrics::add(ids.ids[phase][0],1);
+
+      // if the kernel had to multiplex our group with other users of
+      // the PMU it only counted for part of the time; scale up, the
+      // same way 'perf stat' does
+      const uint64_t enabled = end.timeEnabled - begin.timeEnabled;
+      const uint64_t running = end.timeRunning - begin.timeRunning;
+      if (running == 0)
+        return;
+      for (int event=0;event<NUM_EVENTS;event++) {
+        uint64_t delta = end.values[event] - begin.values[event];
+        if (running < enabled)
+          delta = uint64_t(double(delta)*double(enabled)/double(running));
+        Metrics::add(ids.ids[phase][1+event],delta);
+      }
+    }
+    
+  } // ::owl::ll
+} //::owl
@@ -0,0 +1,152 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include <owl/common/owl-common.h>
+// std
+#include <string>
+
+/*! whether OWL gets built with support for hardware performance
+    counters at all (cmake option of the same name); only has an
+    effect on linux */
+#ifndef OWL_PERF_COUNTERS
+# define OWL_PERF_COUNTERS 0
+#endif
+
+namespace owl {
+  namespace ll {
+
+    /*! optional hardware performance counters - cycles, instructions,
+        cache misses, and branch misses, of the calling thread, in
+        user space only - around some of OWL's host-side phases, read
+        through linux' perf_event_open(). Each phase's counts get
+        added to the metrics registry (see Metrics.h), as, eg,
+        'owl_perf_cycles_total{phase="sbt_build"}', together with
+        the number of times the phase ran, so they show up in
+        owlContextGetMetrics() like all other metrics. Counts are
+        inclusive: variable writes happen during SBT builds, for
+        example, and count towards both phases.
+
+        Counters are off by default. They can be enabled through the
+        OWL_PERF_COUNTERS environment variable ("1"), or through
+        owlEnablePerfCounters()/lloSetPerfCounters(); like tracing
+        this is a process-wide setting. If the kernel does not let
+        us open the counters (perf_event_paranoid, containers, VMs
+        without a PMU, ...) they quietly turn themselves off again
+        after one warning, and status() says why.
+
+        When off, each scope costs a single (predicted) branch; when
+        on, reading the counters takes a system call at the begin
+        and end of each scope, which is why phases are coarse (eg,
+        all variable writes of one SBT build, not each one). Building
+        without OWL_PERF_COUNTERS compiles the scopes away. */
+    struct PerfCounters {
+      enum Phase {
+        /*! building (and uploading) the SBT's records */
+        PHASE_SBT_BUILD = 0,
+        /*! filling in the optix instances of an instance accel build
+            (including flattening and sorting, but not transform
+            baking, which builds accels of its own) */
+        PHASE_INSTANCE_PACKING,
+        /*! writing variables into SBT records and launch params */
+        PHASE_VARIABLE_WRITES,
+        /*! creating and releasing objects' IDs in the registries */
+        PHASE_REGISTRY,
+        NUM_PHASES
+      };
+      enum Event {
+        EVENT_CYCLES = 0,
+        EVENT_INSTRUCTIONS,
+        EVENT_CACHE_MISSES,
+        EVENT_BRANCH_MISSES,
+        NUM_EVENTS
+      };
+
+      /*! one reading of the calling thread's counters; events that
+          could not be opened read as zero */
+      struct Reading {
+        uint64_t timeEnabled;
+        uint64_t timeRunning;
+        uint64_t values[NUM_EVENTS];
+      };
+
+      /*! whether counters are currently enabled; use through
+          OWL_PERF_SCOPE() */
+      static bool active;
+
+      /*! enables or disables the counters; returns whether they are
+          active afterwards - enabling fails (without throwing) if
+          OWL was built without OWL_PERF_COUNTERS, or if the calling
+          thread cannot open them */
+      static bool setEnabled(bool enabled);
+
+      /*! human-readable state of the counters: whether they are on,
+          and if they are not available, why not */
+      static std::string status();
+
+      static const char *phaseName(int phase);
+      static const char *eventName(int event);
+
+      /*! name of the metrics counter that holds the given event's
+          counts of the given phase; event -1 is the one counting
+          how often the phase ran */
+      static std::string metricName(int phase, int event);
+
+      /*! reads the calling thread's counters (opening them on the
+          thread's first call); returns false if they are not
+          available on this thread */
+      static bool read(Reading &reading);
+
+      /*! adds the counts since 'begin' to the given phase */
+      static void accumulate(int phase, const Reading &begin);
+    };
+
+    /*! counts the events of its own lifetime towards a phase (if
+        counters are enabled) */
+    struct PerfScope {
+      inline PerfScope(int phase)
+        : phase(phase)
+      {
+        active = OWL_UNLIKELY(PerfCounters::active)
+          && PerfCounters::read(begin);
+      }
+      inline ~PerfScope()
+      {
+        if (OWL_UNLIKELY(active))
+          PerfCounters::accumulate(phase,begin);
+      }
+
+      const int             phase;
+      bool                  active;
+      PerfCounters::Reading begin;
+    };
+    
+  } // ::owl::ll
+} //::owl
+
+#define OWL_PERF_CONCAT_(a,b) a##b
+#define OWL_PERF_CONCAT(a,b) OWL_PERF_CONCAT_(a,b)
+
+/*! counts the rest of the enclosing scope towards the given phase,
+    eg OWL_PERF_SCOPE(PHASE_SBT_BUILD) */
+#if OWL_PERF_COUNTERS
+# define OWL_PERF_SCOPE(phase)                                          \
+  ::owl::ll::PerfScope OWL_PERF_CONCAT(owlPerfScope,__LINE__)           \
+  (::owl::ll::PerfCounters::phase)
+#else
+# define OWL_PERF_SCOPE(phase) do {} while (0)
+#endif
@@ -0,0 +1,523 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "SceneInspection.h"
+#include "BufferDedup.h"
+#include "owl/common/owl-common.h"
+// std
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace owl {
+  namespace ll {
+    using owl::common::prettyNumber;
+
+    /*! what optix puts in front of every SBT record, and what every
+        record's size gets rounded up to (OPTIX_SBT_RECORD_HEADER_SIZE
+        and OPTIX_SBT_RECORD_ALIGNMENT; we do not want to include
+        optix here just for those) */
+    static const size_t sbtHeaderSize    = 32;
+    static const size_t sbtRecordAlign   = 16;
+    /*! approximate device memory per baked triangle: three
+        world-space vertices, one index triple, and one SBT index */
+    static const size_t bytesPerBakedTriangle = 3*12+12+4;
+    /*! number of samples sampledContentHash() takes */
+    static const size_t numFingerprintSamples = 64;
+    static const size_t fingerprintSampleSize = 64;
+
+    namespace {
+      enum { NOT_VISITED = 0, IN_PROGRESS, DONE };
+
+      /*! what we compute (and memoize) per group while walking the
+          graph */
+      struct GroupInfo {
+        int    state      = NOT_VISITED;
+        /*! number of instance levels in and below this group */
+        int    depth      = 0;
+        /*! number of instances this group would expand to when
+            flattened; saturates */
+        size_t leaves     = 0;
+        /*! triangles or user prims over all geoms; geom groups
+            only */
+        size_t numPrims   = 0;
+        bool   referenced = false;
+      };
+
+      struct BufferKey {
+        uint64_t fingerprint;
+        size_t   size;
+        bool operator==(const BufferKey &other) const
+        { return fingerprint == other.fingerprint && size == other.size; }
+      };
+      struct BufferKeyHash {
+        size_t operator()(const BufferKey &key) const
+        { return size_t(key.fingerprint ^ (key.size * 0x9e3779b97f4a7c15ULL)); }
+      };
+
+      inline size_t log2Bin(size_t v)
+      {
+        size_t bin = 0;
+        while (v) { bin++; v >>= 1; }
+        return bin;
+      }
+
+      inline void addToHistogram(std::vector<size_t> &histogram, size_t bin)
+      {
+        if (histogram.size() <= bin)
+          histogram.resize(bin+1,0);
+        histogram[bin]++;
+      }
+
+      inline size_t roundUp(size_t v, size_t align)
+      {
+        return (v+align-1)/align*align;
+      }
+
+      /*! bytes a hit record needs after its header for geom data of
+          the given size: the data, then - if any group merges meshes
+          - (4-byte aligned) the geom's prim base that owl stores for
+          getPrimitiveIndexInGeom() */
+      inline size_t recordDataSize(size_t geomDataSize, bool withPrimBase)
+      {
+        if (!withPrimBase)
+          return roundUp(geomDataSize,sbtRecordAlign);
+        return roundUp(roundUp(geomDataSize,4)+sizeof(uint32_t),
+                       sbtRecordAlign);
+      }
+
+      inline size_t saturatingAdd(size_t a, size_t b)
+      {
+        const size_t limit = std::numeric_limits<size_t>::max()/2;
+        return (a > limit-std::min(b,limit)) ? limit : a+b;
+      }
+
+      inline void addRecommendation(SceneReport &report,
+                                    const std::string &text,
+                                    int64_t estimatedBytesSaved)
+      {
+        Recommendation rec;
+        rec.text                = text;
+        rec.estimatedBytesSaved = estimatedBytesSaved;
+        report.recommendations.push_back(rec);
+      }
+
+      /*! computes depth and leaf count of the given group, and of
+          everything below it; in-progress markers detect cycles */
+      void visitGroup(const SceneDescription &scene,
+                      std::vector<GroupInfo> &info,
+                      int groupID)
+      {
+        GroupInfo &gi = info[groupID];
+        if (gi.state == DONE)
+          return;
+        if (gi.state == IN_PROGRESS)
+          throw std::runtime_error("instance graph contains a cycle");
+        const InspectGroup &group = scene.groups[groupID];
+        if (group.kind != InspectGroup::INSTANCE) {
+          gi.depth  = 0;
+          gi.leaves = 1;
+          gi.state  = DONE;
+          return;
+        }
+        gi.state = IN_PROGRESS;
+        int    depth  = 0;
+        size_t leaves = 0;
+        for (auto child : group.children) {
+          if (child < 0) continue;
+          visitGroup(scene,info,child);
+          depth  = std::max(depth,info[child].depth);
+          leaves = saturatingAdd(leaves,info[child].leaves);
+        }
+        gi.depth  = depth+1;
+        gi.leaves = leaves;
+        gi.state  = DONE;
+      }
+
+      /*! checks that all IDs the description refers to exist */
+      void validate(const SceneDescription &scene)
+      {
+        for (auto &geom : scene.geoms) {
+          if (geom.kind == InspectGeom::UNUSED) continue;
+          for (int bufferID : { geom.vertexBuffer, geom.indexBuffer })
+            if (bufferID >= (int)scene.buffers.size() ||
+                (bufferID >= 0 && !scene.buffers[bufferID].valid))
+              throw std::runtime_error("scene description refers to an "
+                                       "invalid buffer");
+        }
+        for (auto &group : scene.groups) {
+          if (group.kind == InspectGroup::UNUSED) continue;
+          for (auto child : group.children) {
+            if (child < 0) continue;
+            if (group.kind == InspectGroup::INSTANCE
+                ? (child >= (int)scene.groups.size() ||
+                   scene.groups[child].kind == InspectGroup::UNUSED)
+                : (child >= (int)scene.geoms.size() ||
+                   scene.geoms[child].kind == InspectGeom::UNUSED))
+              throw std::runtime_error("scene description refers to an "
+                                       "invalid group child");
+          }
+        }
+      }
+    }
+
+    uint64_t sampledContentHash(const void *data, size_t numBytes)
+    {
+      const uint8_t *bytes = (const uint8_t *)data;
+      // no need to mix in the size here: buffers only count as
+      // duplicates if their sizes match, too
+      uint64_t h = 0;
+      if (numBytes <= numFingerprintSamples*fingerprintSampleSize)
+        h = contentHash64(bytes,numBytes);
+      else {
+        uint8_t samples[numFingerprintSamples*fingerprintSampleSize];
+        // first sample at the start, last one at the very end
+        const size_t range = numBytes-fingerprintSampleSize;
+        for (size_t i=0;i<numFingerprintSamples;i++)
+          memcpy(samples+i*fingerprintSampleSize,
+                 bytes+i*range/(numFingerprintSamples-1),
+                 fingerprintSampleSize);
+        h = contentHash64(samples,sizeof(samples));
+      }
+      return h ? h : 1;
+    }
+
+    SceneReport inspectScene(const SceneDescription &scene,
+                             const InspectionOptions &options)
+    {
+      validate(scene);
+      SceneReport report;
+
+      // ------------------------------------------------------------------
+      // geoms, and which buffers they use for what
+      // ------------------------------------------------------------------
+      enum { ROLE_OTHER = 0, ROLE_VERTEX, ROLE_INDEX };
+      std::vector<uint8_t> bufferRole(scene.buffers.size(),ROLE_OTHER);
+      size_t largestDataSize = 0, secondLargestDataSize = 0;
+      for (auto &geom : scene.geoms) {
+        if (geom.kind == InspectGeom::UNUSED) continue;
+        if (geom.kind == InspectGeom::TRIANGLES) {
+          report.numTrianglesGeoms++;
+          if (geom.numPrims <= options.tinyMeshPrims)
+            report.numTinyMeshes++;
+          if (geom.indexBuffer >= 0)
+            bufferRole[geom.indexBuffer] = ROLE_INDEX;
+          if (geom.vertexBuffer >= 0)
+            bufferRole[geom.vertexBuffer] = ROLE_VERTEX;
+        } else
+          report.numUserGeoms++;
+        if (geom.sbtDataSize > largestDataSize) {
+          secondLargestDataSize = largestDataSize;
+          largestDataSize       = geom.sbtDataSize;
+        } else if (geom.sbtDataSize < largestDataSize)
+          secondLargestDataSize = std::max(secondLargestDataSize,
+                                           geom.sbtDataSize);
+      }
+
+      // ------------------------------------------------------------------
+      // buffers: memory per category, and likely duplicates
+      // ------------------------------------------------------------------
+      std::unordered_set<BufferKey,BufferKeyHash> seenContents;
+      for (size_t bufferID=0;bufferID<scene.buffers.size();bufferID++) {
+        const InspectBuffer &buffer = scene.buffers[bufferID];
+        if (!buffer.valid) continue;
+        report.numBuffers++;
+        switch (bufferRole[bufferID]) {
+        case ROLE_VERTEX: report.vertexBytes      += buffer.sizeInBytes; break;
+        case ROLE_INDEX:  report.indexBytes       += buffer.sizeInBytes; break;
+        default:          report.otherBufferBytes += buffer.sizeInBytes; break;
+        }
+        if (buffer.fingerprint == 0 || buffer.sizeInBytes == 0) continue;
+        if (!seenContents.insert({buffer.fingerprint,buffer.sizeInBytes}).second) {
+          report.numDuplicateBuffers++;
+          report.duplicateBytes += buffer.sizeInBytes;
+        }
+      }
+
+      // ------------------------------------------------------------------
+      // groups: graph structure, accels, and hit records
+      // ------------------------------------------------------------------
+      std::vector<GroupInfo> info(scene.groups.size());
+      bool withPrimBase = false;
+      for (auto &group : scene.groups)
+        withPrimBase |= group.meshMerging;
+      report.largestGeomDataSize = largestDataSize;
+      report.sbtRecordSize
+        = sbtHeaderSize + recordDataSize(largestDataSize,withPrimBase);
+      size_t mergeableInputs = 0;
+      size_t tinyBLASAccelBytes = 0;
+      for (size_t groupID=0;groupID<scene.groups.size();groupID++) {
+        const InspectGroup &group = scene.groups[groupID];
+        if (group.kind == InspectGroup::UNUSED) continue;
+        if (group.kind == InspectGroup::INSTANCE) {
+          report.numInstanceGroups++;
+          report.numInstances       += group.children.size();
+          report.instanceAccelBytes += group.accelSizeInBytes;
+          addToHistogram(report.fanOutHistogram,log2Bin(group.children.size()));
+          for (auto child : group.children)
+            if (child >= 0) info[child].referenced = true;
+          continue;
+        }
+
+        report.numGeomGroups++;
+        report.geomAccelBytes += group.accelSizeInBytes;
+        addToHistogram(report.geomsPerGroupHistogram,
+                       log2Bin(group.children.size()));
+        // every child gets one hit record per ray type, whether it
+        // is set or not
+        const size_t numRecords = group.children.size()*scene.numRayTypes;
+        report.numHitRecords += numRecords;
+        size_t numPrims = 0, numTinyMeshes = 0;
+        for (auto child : group.children) {
+          const size_t dataSize
+            = child < 0 ? 0 : scene.geoms[child].sbtDataSize;
+          report.sbtPaddingBytes
+            += scene.numRayTypes
+            *  (report.sbtRecordSize
+                - sbtHeaderSize - recordDataSize(dataSize,withPrimBase));
+          if (child < 0) continue;
+          const InspectGeom &geom = scene.geoms[child];
+          numPrims += geom.numPrims;
+          if (geom.kind == InspectGeom::TRIANGLES &&
+              geom.numPrims <= options.tinyMeshPrims)
+            numTinyMeshes++;
+        }
+        info[groupID].numPrims = numPrims;
+        if (group.kind == InspectGroup::TRIANGLES && numTinyMeshes > 1)
+          mergeableInputs += numTinyMeshes-1;
+        if (group.kind == InspectGroup::TRIANGLES &&
+            numPrims <= options.tinyBLASPrims) {
+          report.numTinyBLASes++;
+          tinyBLASAccelBytes += group.accelSizeInBytes;
+        }
+      }
+      report.sbtHitRecordBytes = report.numHitRecords*report.sbtRecordSize;
+
+      // depths, leaf counts, and instances of tiny BLASes
+      size_t bakedTriangles = 0;
+      for (size_t groupID=0;groupID<scene.groups.size();groupID++) {
+        const InspectGroup &group = scene.groups[groupID];
+        if (group.kind != InspectGroup::INSTANCE) continue;
+        visitGroup(scene,info,(int)groupID);
+        if (!info[groupID].referenced)
+          report.numRootGroups++;
+        addToHistogram(report.depthHistogram,info[groupID].depth);
+        report.maxInstanceDepth
+          = std::max(report.maxInstanceDepth,info[groupID].depth);
+        for (auto child : group.children) {
+          if (child < 0) continue;
+          const InspectGroup &childGroup = scene.groups[child];
+          if (childGroup.kind == InspectGroup::TRIANGLES &&
+              info[child].numPrims <= options.tinyBLASPrims) {
+            report.numTinyBLASInstances++;
+            bakedTriangles += info[child].numPrims;
+          }
+        }
+      }
+
+      // ------------------------------------------------------------------
+      // recommendations
+      // ------------------------------------------------------------------
+      if (report.numDuplicateBuffers) {
+        std::stringstream ss;
+        ss << report.numDuplicateBuffers << " buffer(s) ("
+           << prettyNumber(report.duplicateBytes) << "B) look like copies "
+           << "of other buffers; enable owlContextSetBufferDedup() before "
+           << "creating them (with initial data) to share their memory";
+        addRecommendation(report,ss.str(),(int64_t)report.duplicateBytes);
+      }
+
+      if (report.maxInstanceDepth > 1) {
+        // flattening replaces the inner instance groups below each
+        // deep root (their instance arrays and accels) with one
+        // instance per leaf in the root's instance array
+        std::vector<bool> isInner(scene.groups.size(),false);
+        size_t numDeepRoots = 0, numLeaves = 0, numRootChildren = 0;
+        size_t innerBytes = 0;
+        std::vector<int> stack;
+        for (size_t groupID=0;groupID<scene.groups.size();groupID++) {
+          const InspectGroup &group = scene.groups[groupID];
+          if (group.kind != InspectGroup::INSTANCE ||
+              info[groupID].referenced || info[groupID].depth < 2)
+            continue;
+          numDeepRoots++;
+          numLeaves        = saturatingAdd(numLeaves,info[groupID].leaves);
+          numRootChildren += group.children.size();
+          for (auto child : group.children)
+            if (child >= 0) stack.push_back(child);
+          while (!stack.empty()) {
+            const int nodeID = stack.back(); stack.pop_back();
+            const InspectGroup &node = scene.groups[nodeID];
+            if (node.kind != InspectGroup::INSTANCE || isInner[nodeID])
+              continue;
+            isInner[nodeID] = true;
+            innerBytes += node.accelSizeInBytes
+              ? node.accelSizeInBytes
+              : node.children.size()*inspectInstanceSize;
+            for (auto child : node.children)
+              if (child >= 0) stack.push_back(child);
+          }
+        }
+        if (numDeepRoots) {
+          std::stringstream ss;
+          ss << numDeepRoots << " root instance group(s) have up to "
+             << report.maxInstanceDepth << " levels of instancing; "
+             << "flattening them (owlInstanceGroupSetFlattening) turns "
+             << "them into two-level scenes with " << prettyNumber(numLeaves)
+             << " instance(s), which optix traces in hardware "
+             << "(owlSetMaxInstancingDepth(1))";
+          const int64_t addedBytes
+            = (int64_t)((numLeaves-std::min(numLeaves,numRootChildren))
+                        *inspectInstanceSize);
+          addRecommendation(report,ss.str(),(int64_t)innerBytes-addedBytes);
+        }
+      }
+
+      if (mergeableInputs) {
+        std::stringstream ss;
+        ss << report.numTinyMeshes << " triangle mesh(es) have at most "
+           << options.tinyMeshPrims << " triangles; merging them "
+           << "(owlTrianglesGeomGroupSetMeshMerging) saves up to "
+           << prettyNumber(mergeableInputs) << " build input(s)";
+        addRecommendation(report,ss.str(),0);
+      }
+
+      if (report.numTinyBLASInstances) {
+        std::stringstream ss;
+        ss << prettyNumber(report.numTinyBLASInstances) << " instance(s) "
+           << "refer to " << report.numTinyBLASes << " triangle group(s) "
+           << "with at most " << options.tinyBLASPrims << " triangles; "
+           << "baking their transforms (owlInstanceGroupSetTransformBaking) "
+           << "saves a BLAS traversal per ray";
+        const int64_t savedBytes
+          = (int64_t)(report.numTinyBLASInstances*inspectInstanceSize
+                      + tinyBLASAccelBytes)
+          - (int64_t)(bakedTriangles*bytesPerBakedTriangle);
+        addRecommendation(report,ss.str(),savedBytes);
+      }
+
+      if (report.sbtPaddingBytes*4 > report.sbtHitRecordBytes) {
+        // if the largest geom data lived in a buffer, with only a
+        // pointer to it in the SBT, records would only have to fit
+        // the second largest data (or that pointer)
+        const size_t newRecordSize
+          = sbtHeaderSize
+          + recordDataSize(std::max(secondLargestDataSize,sizeof(void*)),
+                           withPrimBase);
+        if (newRecordSize < report.sbtRecordSize) {
+          std::stringstream ss;
+          ss << prettyNumber(report.sbtPaddingBytes) << "B of the "
+             << prettyNumber(report.sbtHitRecordBytes) << "B of hit "
+             << "records are padding, since every record has room for the "
+             << "largest geom data (" << largestDataSize << " bytes); "
+             << "keeping that data in a buffer, and only a pointer to it "
+             << "in the geom, shrinks records to " << newRecordSize
+             << " bytes";
+          addRecommendation(report,ss.str(),
+                            (int64_t)(report.numHitRecords
+                                      *(report.sbtRecordSize-newRecordSize)));
+        }
+      }
+
+      std::stable_sort(report.recommendations.begin(),
+                       report.recommendations.end(),
+                       [](const Recommendation &a, const Recommendation &b)
+                       { return a.estimatedBytesSaved > b.estimatedBytesSaved; });
+      return report;
+    }
+
+    /*! prints a log2-binned histogram as 'range:count' pairs */
+    static void writeLog2Histogram(std::ostream &out,
+                                   const std::vector<size_t> &histogram)
+    {
+      for (size_t bin=0;bin<histogram.size();bin++) {
+        if (!histogram[bin]) continue;
+        if (bin <= 1)
+          out << " " << bin;
+        else
+          out << " " << (size_t(1)<<(bin-1)) << "-" << ((size_t(1)<<bin)-1);
+        out << ":" << histogram[bin];
+      }
+      out << std::endl;
+    }
+
+    static std::string prettyBytes(int64_t bytes)
+    {
+      return (bytes < 0 ? "-" : "")
+        + prettyNumber((size_t)(bytes < 0 ? -bytes : bytes)) + "B";
+    }
+
+    void writeReport(std::ostream &out, const SceneReport &report)
+    {
+      out << "#owl.inspect: scene" << std::endl
+          << "  buffers            " << report.numBuffers << std::endl
+          << "  geoms              " << report.numTrianglesGeoms
+          << " triangles, " << report.numUserGeoms << " user" << std::endl
+          << "  geom groups        " << report.numGeomGroups << std::endl
+          << "  instance groups    " << report.numInstanceGroups
+          << " (" << report.numRootGroups << " root(s), "
+          << report.numInstances << " instance(s))" << std::endl;
+
+      out << "#owl.inspect: structure" << std::endl
+          << "  max instance depth " << report.maxInstanceDepth << std::endl
+          << "  depth histogram   ";
+      for (size_t depth=0;depth<report.depthHistogram.size();depth++)
+        if (report.depthHistogram[depth])
+          out << " " << depth << ":" << report.depthHistogram[depth];
+      out << std::endl << "  fan-out histogram ";
+      writeLog2Histogram(out,report.fanOutHistogram);
+      out << "  geoms per group   ";
+      writeLog2Histogram(out,report.geomsPerGroupHistogram);
+      out << "  tiny meshes        " << report.numTinyMeshes << std::endl
+          << "  tiny BLASes        " << report.numTinyBLASes << " ("
+          << report.numTinyBLASInstances << " instance(s))" << std::endl
+          << "  likely duplicates  " << report.numDuplicateBuffers
+          << " buffer(s), " << prettyBytes(report.duplicateBytes) << std::endl;
+
+      out << "#owl.inspect: SBT" << std::endl
+          << "  hit records        " << report.numHitRecords << " x "
+          << report.sbtRecordSize << " bytes (largest geom data: "
+          << report.largestGeomDataSize << " bytes)" << std::endl
+          << "  padding            " << prettyBytes(report.sbtPaddingBytes)
+          << std::endl;
+
+      out << "#owl.inspect: memory (per device)" << std::endl
+          << "  vertex buffers     " << prettyBytes(report.vertexBytes) << std::endl
+          << "  index buffers      " << prettyBytes(report.indexBytes) << std::endl
+          << "  other buffers      " << prettyBytes(report.otherBufferBytes) << std::endl
+          << "  geom accels        " << prettyBytes(report.geomAccelBytes) << std::endl
+          << "  instance accels    " << prettyBytes(report.instanceAccelBytes) << std::endl
+          << "  SBT hit records    " << prettyBytes(report.sbtHitRecordBytes) << std::endl;
+
+      out << "#owl.inspect: recommendations" << std::endl;
+      if (report.recommendations.empty())
+        out << "  (none)" << std::endl;
+      for (auto &rec : report.recommendations) {
+        out << "  - " << rec.text;
+        if (rec.estimatedBytesSaved > 0)
+          out << " [saves ~" << prettyBytes(rec.estimatedBytesSaved) << "]";
+        else if (rec.estimatedBytesSaved < 0)
+          out << " [costs ~" << prettyBytes(-rec.estimatedBytesSaved) << "]";
+        out << std::endl;
+      }
+    }
+
+  } // ::owl::ll
+} //::owl
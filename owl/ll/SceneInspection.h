@@ -0,0 +1,184 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace owl {
+  namespace ll {
+
+    /*! host-side scene inspection (see owlContextDumpStats): walks a
+        flat description of a scene's buffers, geoms and groups, and
+        reports how the scene is structured, where its memory goes,
+        and what could be done to make it smaller or faster. Nothing
+        here needs CUDA or optix, and everything is linear in the
+        size of the scene, so it can be run on scenes with tens of
+        millions of objects, and tested on the host. */
+
+    /*! what the inspector needs to know about one buffer */
+    struct InspectBuffer {
+      /*! false for IDs that are not (or no longer) in use */
+      bool     valid       = false;
+      size_t   sizeInBytes = 0;
+      /*! cheap fingerprint of the buffer's contents (see
+          sampledContentHash); 0 if the contents never went through
+          the host, in which case the buffer never counts as a
+          duplicate */
+      uint64_t fingerprint = 0;
+    };
+
+    /*! what the inspector needs to know about one geom */
+    struct InspectGeom {
+      enum { UNUSED = -1, TRIANGLES = 0, USER };
+      int    kind        = UNUSED;
+      /*! number of triangles or user prims */
+      size_t numPrims    = 0;
+      /*! triangles only: vertex and index buffer IDs (-1 if not
+          set) */
+      int    vertexBuffer = -1;
+      int    indexBuffer  = -1;
+      /*! size of the geom type's SBT data */
+      size_t sbtDataSize = 0;
+    };
+
+    /*! what the inspector needs to know about one group */
+    struct InspectGroup {
+      enum { UNUSED = -1, TRIANGLES = 0, USER, INSTANCE };
+      int              kind = UNUSED;
+      /*! geom IDs for geom groups, group IDs for instance groups;
+          -1 for children that are not set */
+      std::vector<int> children;
+      /*! device memory of the group's accel on one device, including
+          instance arrays, split parts and baked or merged geometry;
+          0 if it has not been built yet */
+      size_t           accelSizeInBytes = 0;
+      /*! whether this (triangles) group merges small meshes; if any
+          group does, all hit records carry a prim base */
+      bool             meshMerging = false;
+    };
+
+    /*! a whole scene, with each object at the index of its ID */
+    struct SceneDescription {
+      std::vector<InspectBuffer> buffers;
+      std::vector<InspectGeom>   geoms;
+      std::vector<InspectGroup>  groups;
+      size_t                     numRayTypes = 1;
+    };
+
+    /*! thresholds of what the inspector considers 'tiny' */
+    struct InspectionOptions {
+      /*! triangle meshes with at most this many triangles are tiny,
+          and candidates for mesh merging */
+      size_t tinyMeshPrims = 64;
+      /*! triangle geom groups with at most this many triangles are
+          tiny BLASes, and their instances candidates for transform
+          baking */
+      size_t tinyBLASPrims = 256;
+    };
+
+    /*! one suggestion of the inspector */
+    struct Recommendation {
+      std::string text;
+      /*! estimated device memory this would save (per device);
+          negative if it costs memory (in exchange for speed), and
+          zero if it is about build or trace time only */
+      int64_t     estimatedBytesSaved = 0;
+    };
+
+    /*! result of inspectScene(). Histograms with log2 bins have bin
+        'i' count values in [2^(i-1),2^i), with bin 0 counting
+        zeros */
+    struct SceneReport {
+      size_t numBuffers        = 0;
+      size_t numTrianglesGeoms = 0;
+      size_t numUserGeoms      = 0;
+      size_t numGeomGroups     = 0;
+      size_t numInstanceGroups = 0;
+      /*! summed over all instance groups */
+      size_t numInstances      = 0;
+      /*! instance groups that no other group refers to */
+      size_t numRootGroups     = 0;
+
+      /*! the largest number of instance levels above any geom
+          group; 1 is a regular two-level scene */
+      int                 maxInstanceDepth = 0;
+      /*! bin 'd' counts instance groups with 'd' instance levels
+          in and below them */
+      std::vector<size_t> depthHistogram;
+      /*! log2 bins of the number of children of instance groups */
+      std::vector<size_t> fanOutHistogram;
+      /*! log2 bins of the number of geoms of geom groups */
+      std::vector<size_t> geomsPerGroupHistogram;
+
+      /*! size of one hit record, and of the part of it needed for
+          the largest geom data */
+      size_t sbtRecordSize        = 0;
+      size_t largestGeomDataSize  = 0;
+      size_t numHitRecords        = 0;
+      /*! bytes in hit records that only exist because all records
+          get padded to the largest geom data */
+      size_t sbtPaddingBytes      = 0;
+
+      /*! buffers whose size and fingerprint match those of an
+          earlier buffer, and their total size */
+      size_t numDuplicateBuffers  = 0;
+      size_t duplicateBytes       = 0;
+      /*! triangle meshes with at most tinyMeshPrims triangles */
+      size_t numTinyMeshes        = 0;
+      /*! triangle geom groups with at most tinyBLASPrims triangles,
+          and the number of instances referring to them */
+      size_t numTinyBLASes        = 0;
+      size_t numTinyBLASInstances = 0;
+
+      /*! device memory per category (on one device) */
+      size_t vertexBytes        = 0;
+      size_t indexBytes         = 0;
+      size_t otherBufferBytes   = 0;
+      size_t geomAccelBytes     = 0;
+      size_t instanceAccelBytes = 0;
+      size_t sbtHitRecordBytes  = 0;
+
+      std::vector<Recommendation> recommendations;
+    };
+
+    /*! size of one optix instance in an instance array */
+    static const size_t inspectInstanceSize = 80;
+
+    /*! analyzes the given scene; throws on descriptions that refer
+        to objects that do not exist */
+    SceneReport inspectScene(const SceneDescription &scene,
+                             const InspectionOptions &options
+                             = InspectionOptions());
+
+    /*! writes a human-readable version of the given report */
+    void writeReport(std::ostream &out, const SceneReport &report);
+
+    /*! a cheap fingerprint of a memory block, from its size and a
+        fixed number of evenly spaced samples of it, so it costs the
+        same for every buffer size. Blocks with different
+        fingerprints are different; blocks with the same one are
+        only *likely* the same (buffer dedup always compares full
+        contentHash64()s). Never returns 0. */
+    uint64_t sampledContentHash(const void *data, size_t numBytes);
+
+  } // ::owl::ll
+} //::owl
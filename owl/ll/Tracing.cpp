@@ -0,0 +1,196 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "Tracing.h"
+// std
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+namespace owl {
+  namespace ll {
+
+    namespace {
+      /*! one thread's events; events[numRecorded % RING_SIZE] is the
+          next one to get (over-)written */
+      struct TraceRing {
+        TraceRing(int threadID)
+          : events(Tracing::RING_SIZE), threadID(threadID)
+        {}
+        std::vector<Tracing::Event> events;
+        uint64_t numRecorded = 0;
+        const int threadID;
+      };
+
+      /*! all threads' rings. Rings outlive their threads (so their
+          events still get dumped), and the whole state deliberately
+          never gets destroyed, so dumping at exit cannot race with
+          static destructors */
+      struct TraceState {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<TraceRing>> rings;
+        std::string exitFileName;
+        bool dumpAtExitRegistered = false;
+        const std::chrono::steady_clock::time_point epoch
+          = std::chrono::steady_clock::now();
+      };
+      
+      TraceState &state()
+      {
+        static TraceState *state = new TraceState;
+        return *state;
+      }
+
+      thread_local TraceRing *threadRing = nullptr;
+
+      TraceRing *createThreadRing()
+      {
+        TraceState &s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.rings.emplace_back(new TraceRing((int)s.rings.size()));
+        return s.rings.back().get();
+      }
+
+      void writeString(std::ostream &out, const char *s)
+      {
+        out << '"';
+        for (;s && *s;s++) {
+          if (*s == '"' || *s == '\\') out << '\\';
+          if ((unsigned char)*s >= 0x20) out << *s;
+        }
+        out << '"';
+      }
+
+      void dumpAtExit()
+      {
+        std::string fileName;
+        {
+          TraceState &s = state();
+          std::lock_guard<std::mutex> lock(s.mutex);
+          fileName = s.exitFileName;
+        }
+        if (!fileName.empty() && !Tracing::dump(fileName.c_str()))
+          std::cerr << OWL_TERMINAL_RED
+                    << "#owl: could not write trace to '" << fileName << "'"
+                    << OWL_TERMINAL_DEFAULT << std::endl;
+      }
+    }
+
+    /*! default value: on if the OWL_TRACE environment variable names
+        a file to write the trace to */
+    static bool initialTracingState()
+    {
+      const char *fromEnv = getenv("OWL_TRACE");
+      if (!fromEnv || !*fromEnv)
+        return false;
+      Tracing::setEnabled(true,fromEnv);
+      return true;
+    }
+    
+    std::atomic<bool> Tracing::active { initialTracingState() };
+    
+    void Tracing::setEnabled(bool enabled, const char *fileName)
+    {
+      if (fileName) {
+        TraceState &s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.exitFileName = fileName;
+        if (!s.dumpAtExitRegistered) {
+          atexit(dumpAtExit);
+          s.dumpAtExitRegistered = true;
+        }
+      }
+      active.store(enabled,std::memory_order_relaxed);
+    }
+
+    uint64_t Tracing::now()
+    {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>
+        (std::chrono::steady_clock::now()-state().epoch).count();
+    }
+
+    void Tracing::record(const Event &event)
+    {
+      TraceRing *ring = threadRing;
+      if (OWL_UNLIKELY(!ring))
+        ring = threadRing = createThreadRing();
+      ring->events[ring->numRecorded++ % RING_SIZE] = event;
+    }
+
+    void Tracing::clear()
+    {
+      TraceState &s = state();
+      std::lock_guard<std::mutex> lock(s.mutex);
+      for (auto &ring : s.rings)
+        ring->numRecorded = 0;
+    }
+
+    bool Tracing::dump(const char *fileName)
+    {
+      std::ofstream out(fileName);
+      if (!out)
+        return false;
+
+      TraceState &s = state();
+      std::lock_guard<std::mutex> lock(s.mutex);
+      out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+      bool first = true;
+      for (auto &ring : s.rings) {
+        out << (first ? "\n" : ",\n")
+            << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+            << ring->threadID << ",\"args\":{\"name\":\"owl thread "
+            << ring->threadID << "\"}}";
+        first = false;
+
+        // oldest first; if the ring wrapped around, the oldest
+        // events are gone
+        const uint64_t end   = ring->numRecorded;
+        const uint64_t begin = end > RING_SIZE ? end-RING_SIZE : 0;
+        for (uint64_t i=begin;i<end;i++) {
+          const Event &event = ring->events[i % RING_SIZE];
+          out << ",\n{\"name\":";
+          writeString(out,event.name);
+          out << ",\"cat\":";
+          writeString(out,event.category);
+          out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->threadID
+              << ",\"ts\":" << (event.begin/1000) << "." 
+              << std::setw(3) << std::setfill('0') << (event.begin%1000)
+              << ",\"dur\":" << ((event.end-event.begin)/1000) << "."
+              << std::setw(3) << std::setfill('0') << ((event.end-event.begin)%1000)
+              << std::setfill(' ');
+          if (event.argNames[0]) {
+            out << ",\"args\":{";
+            for (int arg=0;arg<2 && event.argNames[arg];arg++) {
+              if (arg) out << ",";
+              writeString(out,event.argNames[arg]);
+              out << ":" << event.argValues[arg];
+            }
+            out << "}";
+          }
+          out << "}";
+        }
+      }
+      out << "\n]}\n";
+      return (bool)out;
+    }
+    
+  } // ::owl::ll
+} //::owl
@@ -0,0 +1,130 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include <owl/common/owl-common.h>
+// std
+#include <atomic>
+
+namespace owl {
+  namespace ll {
+
+    /*! low-overhead tracer for OWL's API calls and internal phases
+        (module, program, and pipeline builds, accel builds, SBT
+        builds, launches); traces get written in Chrome's trace_event
+        JSON format, so they can be viewed in chrome://tracing or
+        ui.perfetto.dev.
+
+        Tracing is off by default. It can be enabled at runtime
+        through the OWL_TRACE environment variable (naming the file
+        the trace gets written to at exit), or through
+        owlEnableTracing()/lloSetTracing(); like validation it is a
+        process-wide setting. Each thread records into a ring buffer
+        of its own, so recording neither locks nor allocates (other
+        than on a thread's first event), and long runs keep the most
+        recent events.
+
+        When off, each traced scope costs a single (predicted) branch
+        on 'active'. Note launches are asynchronous, so their events
+        measure the host side of the launch only. */
+    struct Tracing {
+      /*! one complete ('X') event: a named scope, with up to two
+          integer arguments */
+      struct Event {
+        const char *category;
+        const char *name;
+        /*! nanoseconds since the tracer's epoch */
+        uint64_t    begin;
+        uint64_t    end;
+        const char *argNames[2];
+        int64_t     argValues[2];
+      };
+
+      /*! number of events each thread's ring buffer can hold */
+      enum { RING_SIZE = 1<<16 };
+      
+      /*! whether tracing is currently enabled; use through
+          OWL_TRACE_SCOPE(). Atomic since it gets switched while other
+          threads are in API calls, but only ever loaded relaxed -
+          scopes that start right around a switch may or may not get
+          traced */
+      static std::atomic<bool> active;
+
+      static bool isActive()
+      { return active.load(std::memory_order_relaxed); }
+
+      /*! enables or disables tracing; if 'fileName' is non-null the
+          trace gets written to that file at exit */
+      static void setEnabled(bool enabled, const char *fileName);
+
+      /*! writes all events recorded so far to the given file; should
+          only be called while no traced calls are in flight. Returns
+          false if the file could not be written */
+      static bool dump(const char *fileName);
+
+      /*! drops all events recorded so far */
+      static void clear();
+
+      /*! nanoseconds since the tracer's epoch */
+      static uint64_t now();
+
+      /*! adds the given event to the calling thread's ring buffer */
+      static void record(const Event &event);
+    };
+
+    /*! records one event for its own lifetime (if tracing is
+        enabled); argument names have to be string literals, or at
+        least outlive the trace */
+    struct TraceScope {
+      inline TraceScope(const char *category, const char *name,
+                        const char *arg0Name = nullptr, int64_t arg0 = 0,
+                        const char *arg1Name = nullptr, int64_t arg1 = 0)
+        : active(Tracing::isActive())
+      {
+        if (OWL_UNLIKELY(active)) {
+          event.category     = category;
+          event.name         = name;
+          event.argNames[0]  = arg0Name;
+          event.argValues[0] = arg0;
+          event.argNames[1]  = arg1Name;
+          event.argValues[1] = arg1;
+          event.begin        = Tracing::now();
+        }
+      }
+      inline ~TraceScope()
+      {
+        if (OWL_UNLIKELY(active)) {
+          event.end = Tracing::now();
+          Tracing::record(event);
+        }
+      }
+
+      const bool      active;
+      Tracing::Event event;
+    };
+    
+  } // ::owl::ll
+} //::owl
+
+#define OWL_TRACE_CONCAT_(a,b) a##b
+#define OWL_TRACE_CONCAT(a,b) OWL_TRACE_CONCAT_(a,b)
+
+/*! traces the rest of the enclosing scope as an event of given
+    category and name, with up to two optional (name,int) arguments,
+    eg, OWL_TRACE_SCOPE("sbt","buildRayGens","rayGenID",rgID) */
+#define OWL_TRACE_SCOPE(category,...)                                   \
+  ::owl::ll::TraceScope OWL_TRACE_CONCAT(owlTraceScope,__LINE__)(category,__VA_ARGS__)
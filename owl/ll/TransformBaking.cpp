@@ -0,0 +1,166 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "TransformBaking.h"
+#include "owl/common/parallel/parallel_for.h"
+// std
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#if defined(__SSE__) || defined(_M_X64)
+# include <xmmintrin.h>
+# define OWL_BAKE_SSE 1
+#endif
+
+namespace owl {
+  namespace ll {
+
+    static_assert(sizeof(vec3f) == 3*sizeof(float),
+                  "baking assumes tightly packed vec3fs");
+    
+    size_t bakedBytesPerInstance(size_t numTriangles, size_t numVertices)
+    {
+      return numVertices*sizeof(vec3f)
+        + numTriangles*(sizeof(vec3i)+sizeof(uint32_t));
+    }
+
+    std::vector<bool>
+    planTransformBaking(const std::vector<size_t> &groupTriangles,
+                        const std::vector<size_t> &groupVertices,
+                        const std::vector<int>    &instanceGroups,
+                        size_t maxTrianglesPerGroup,
+                        size_t maxInstancesPerGroup,
+                        size_t memoryBudget,
+                        size_t maxTotalTriangles)
+    {
+      const size_t numGroups = groupTriangles.size();
+      if (groupVertices.size() != numGroups)
+        throw std::runtime_error("transform baking: number of vertex counts "
+                                 "does not match number of groups");
+      std::vector<size_t> numInstances(numGroups,0);
+      std::vector<int>    firstUseOrder;
+      for (auto group : instanceGroups) {
+        if (group < 0) continue;
+        if (group >= (int)numGroups)
+          throw std::runtime_error("transform baking: invalid group index");
+        if (numInstances[group]++ == 0)
+          firstUseOrder.push_back(group);
+      }
+
+      std::vector<bool> bake(numGroups,false);
+      size_t bytesUsed = 0, trianglesUsed = 0;
+      for (auto group : firstUseOrder) {
+        if (groupTriangles[group] > maxTrianglesPerGroup) continue;
+        if (numInstances[group]   > maxInstancesPerGroup) continue;
+        const size_t bytes
+          = numInstances[group]
+          * bakedBytesPerInstance(groupTriangles[group],groupVertices[group]);
+        const size_t triangles = numInstances[group] * groupTriangles[group];
+        if (bytesUsed + bytes > memoryBudget) continue;
+        if (trianglesUsed + triangles > maxTotalTriangles) continue;
+        bake[group]    = true;
+        bytesUsed     += bytes;
+        trianglesUsed += triangles;
+      }
+      return bake;
+    }
+
+    void transformPoints(const affine3f &xfm,
+                         const void *in, size_t inStride,
+                         size_t count,
+                         vec3f *out)
+    {
+      const uint8_t *src = (const uint8_t *)in;
+#if OWL_BAKE_SSE
+      const __m128 vx = _mm_setr_ps(xfm.l.vx.x,xfm.l.vx.y,xfm.l.vx.z,0.f);
+      const __m128 vy = _mm_setr_ps(xfm.l.vy.x,xfm.l.vy.y,xfm.l.vy.z,0.f);
+      const __m128 vz = _mm_setr_ps(xfm.l.vz.x,xfm.l.vz.y,xfm.l.vz.z,0.f);
+      const __m128 p  = _mm_setr_ps(xfm.p.x,   xfm.p.y,   xfm.p.z,   0.f);
+      for (size_t i=0;i<count;i++) {
+        float v[3];
+        memcpy(v,src+i*inStride,sizeof(v));
+        const __m128 r
+          = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[0]),vx),
+                                  _mm_mul_ps(_mm_set1_ps(v[1]),vy)),
+                       _mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[2]),vz),p));
+        if (i+1 < count)
+          // writes one float past this vertex, into the next one -
+          // which gets overwritten in the next iteration anyway
+          _mm_storeu_ps((float*)&out[i],r);
+        else {
+          float last[4];
+          _mm_storeu_ps(last,r);
+          out[i] = vec3f(last[0],last[1],last[2]);
+        }
+      }
+#else
+      for (size_t i=0;i<count;i++) {
+        float v[3];
+        memcpy(v,src+i*inStride,sizeof(v));
+        out[i] = xfmPoint(xfm,vec3f(v[0],v[1],v[2]));
+      }
+#endif
+    }
+
+    BakedGeometry bakeInstances(const std::vector<std::vector<BakeMesh>> &groups,
+                                const std::vector<BakeInstance> &instances)
+    {
+      // where each instance's vertices and triangles go
+      std::vector<size_t> vertexBegin(instances.size()+1,0);
+      std::vector<size_t> triBegin(instances.size()+1,0);
+      for (size_t instID=0;instID<instances.size();instID++) {
+        const int group = instances[instID].group;
+        if (group < 0 || group >= (int)groups.size())
+          throw std::runtime_error("transform baking: invalid group index");
+        size_t numVertices = 0, numTriangles = 0;
+        for (auto &mesh : groups[group]) {
+          numVertices  += mesh.mesh.vertexCount;
+          numTriangles += mesh.mesh.indexCount;
+        }
+        vertexBegin[instID+1] = vertexBegin[instID] + numVertices;
+        triBegin[instID+1]    = triBegin[instID]    + numTriangles;
+      }
+
+      BakedGeometry baked;
+      baked.vertices.resize(vertexBegin.back());
+      baked.indices.resize(triBegin.back());
+      baked.sbtIndices.resize(triBegin.back());
+      owl::common::parallel_for
+        (instances.size(),[&](size_t instID){
+          const BakeInstance &inst = instances[instID];
+          size_t vertexPos = vertexBegin[instID];
+          size_t triPos    = triBegin[instID];
+          for (auto &bm : groups[inst.group]) {
+            const MeshView &mesh = bm.mesh;
+            transformPoints(inst.xfm,mesh.vertices,mesh.vertexStride,
+                            mesh.vertexCount,&baked.vertices[vertexPos]);
+            const uint8_t *indices = (const uint8_t *)mesh.indices;
+            for (size_t i=0;i<mesh.indexCount;i++) {
+              int idx[3];
+              memcpy(idx,indices+i*mesh.indexStride,sizeof(idx));
+              baked.indices[triPos+i]
+                = vec3i(idx[0],idx[1],idx[2]) + vec3i((int)vertexPos);
+              baked.sbtIndices[triPos+i] = bm.sbtIndex;
+            }
+            vertexPos += mesh.vertexCount;
+            triPos    += mesh.indexCount;
+          }
+        });
+      return baked;
+    }
+
+  } // ::owl::ll
+} //::owl
@@ -0,0 +1,112 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "MeshMerging.h"
+#include "owl/common/math/AffineSpace.h"
+// std
+#include <cstdint>
+#include <vector>
+
+namespace owl {
+  namespace ll {
+    using owl::common::affine3f;
+
+    /*! host-side logic for transform baking (see
+        lloInstanceGroupSetTransformBaking): instances of small
+        triangle geom groups get replaced with world-space copies of
+        their triangles, all of which go into a single geometry
+        accel - trading memory for fewer instances to traverse.
+        None of this needs CUDA or optix. */
+
+    /*! one geom of a group that may get baked: its (host) arrays,
+        and the SBT record (in units of SBT records per ray type)
+        its primitives use */
+    struct BakeMesh {
+      MeshView mesh;
+      uint32_t sbtIndex;
+    };
+
+    /*! one instance to bake: which group it instantiates, and with
+        what transform */
+    struct BakeInstance {
+      int      group;
+      affine3f xfm;
+    };
+
+    /*! before/after statistics of the last transform baking pass */
+    struct TransformBakingStats {
+      /*! number of instances before / after baking; 'after'
+          includes the one instance of the baked geometry */
+      size_t instancesBefore = 0;
+      size_t instancesAfter  = 0;
+      /*! number of instances that got baked */
+      size_t instancesBaked  = 0;
+      /*! number of (world-space) triangles the baked geometry has */
+      size_t trianglesBaked  = 0;
+      /*! bytes of vertex, index, and SBT index data the baked
+          geometry takes (not counting its accel) */
+      size_t bytesUsed       = 0;
+    };
+
+    /*! bytes the baked arrays take for one instance of a group with
+        the given number of triangles and vertices */
+    size_t bakedBytesPerInstance(size_t numTriangles, size_t numVertices);
+
+    /*! decides which groups get baked: a group gets baked if it has
+        at most maxTrianglesPerGroup triangles and at most
+        maxInstancesPerGroup (bakeable) instances. Groups get
+        considered in the order of their first instance, and only as
+        long as all their baked instances still fit into both the
+        memory budget and maxTotalTriangles. instanceGroups[i] is the
+        group instance i refers to, or -1 if it cannot be baked. */
+    std::vector<bool>
+    planTransformBaking(const std::vector<size_t> &groupTriangles,
+                        const std::vector<size_t> &groupVertices,
+                        const std::vector<int>    &instanceGroups,
+                        size_t maxTrianglesPerGroup,
+                        size_t maxInstancesPerGroup,
+                        size_t memoryBudget,
+                        size_t maxTotalTriangles);
+
+    /*! transforms 'count' points (stored with the given stride in
+        bytes) by the given affine transform into 'out'; uses SSE
+        where available */
+    void transformPoints(const affine3f &xfm,
+                         const void *in, size_t inStride,
+                         size_t count,
+                         vec3f *out);
+
+    /*! the world-space result of baking a list of instances */
+    struct BakedGeometry {
+      std::vector<vec3f>    vertices;
+      std::vector<vec3i>    indices;
+      /*! per triangle, the SBT record (in units of SBT records per
+          ray type) of the geom it came from */
+      std::vector<uint32_t> sbtIndices;
+    };
+
+    /*! bakes the given instances of the given groups into a single
+        world-space mesh, in parallel over instances (each of which
+        writes to a fixed range of the output). Triangles come out
+        in instance order, and within each instance in the order of
+        the group's meshes */
+    BakedGeometry bakeInstances(const std::vector<std::vector<BakeMesh>> &groups,
+                                const std::vector<BakeInstance> &instances);
+
+  } // ::owl::ll
+} //::owl
@@ -15,31 +15,20 @@
 // ======================================================================== //
 
 #include "Device.h"
+#include "GroupSplitting.h"
+#include "MeshMerging.h"
 #include <fstream>
 
+/*! group builds can happen every frame, so everything in here
+    logs at debug level */
 #define LOG(message)                                            \
-  if (Context::logging()) \
-    std::cout << "#owl.ll(" << context->owlDeviceID << "): "    \
-  << message                                                    \
-  << std::endl
+  OWL_LOG(LEVEL_DEBUG,"#owl.ll(" << context->owlDeviceID << "): " \
+          << message)
 
-#define LOG_OK(message)                                 \
-  if (Context::logging()) \
-    std::cout << OWL_TERMINAL_GREEN                     \
-  << "#owl.ll(" << context->owlDeviceID << "): "        \
-  << message << OWL_TERMINAL_DEFAULT << std::endl
-
-#define CLOG(message)                                   \
-  if (Context::logging()) \
-    std::cout << "#owl.ll(" << owlDeviceID << "): "     \
-  << message                                            \
-  << std::endl
-
-#define CLOG_OK(message)                                \
-  if (Context::logging()) \
-  std::cout << OWL_TERMINAL_GREEN                       \
-  << "#owl.ll(" << owlDeviceID << "): "                 \
-  << message << OWL_TERMINAL_DEFAULT << std::endl
+#define LOG_OK(message)                                         \
+  OWL_LOG_COLOR(LEVEL_DEBUG,OWL_TERMINAL_GREEN,                 \
+                "#owl.ll(" << context->owlDeviceID << "): "     \
+                << message)
 
 namespace owl {
   namespace ll {
@@ -80,99 +69,72 @@ namespace owl {
         bvhMemory.free();
         traversable = 0;
       }
+      destroySplitParts();
+      mergedMeshes.clear();
+      childPrimBase.clear();
       context->popActive();
     }
     
-    void TrianglesGeomGroup::buildAccel(Context *context) 
+    /*! enables merging of small meshes in the given triangles geom
+        group (see lloTrianglesGeomGroupSetMeshMerging); '0' disables
+        it */
+    void Device::trianglesGeomGroupSetMeshMerging(int groupID,
+                                                  size_t maxTrianglesPerMesh)
     {
-      assert("check does not yet exist" && traversable == 0);
-      assert("check does not yet exist" && bvhMemory.empty());
-      
-      context->pushActive();
-      LOG("building triangles accel over "
-          << children.size() << " geometries");
-
-      size_t sumPrims = 0;
-      uint32_t maxPrimsPerGAS = 0;
-      optixDeviceContextGetProperty
-        (context->optixContext,
-         OPTIX_DEVICE_PROPERTY_LIMIT_MAX_PRIMITIVES_PER_GAS,
-         &maxPrimsPerGAS,
-         sizeof(maxPrimsPerGAS));
-      
-      // ==================================================================
-      // create triangle inputs
-      // ==================================================================
-      //! the N build inputs that go into the builder
-      std::vector<OptixBuildInput> triangleInputs(children.size());
-      /*! *arrays* of the vertex pointers - the buildinputs cointina
-       *pointers* to the pointers, so need a temp copy here */
-      std::vector<CUdeviceptr> vertexPointers(children.size());
-      std::vector<CUdeviceptr> indexPointers(children.size());
-
-      // for now we use the same flags for all geoms
-      uint32_t triangleInputFlags[1] = { 0 };
-      // { OPTIX_GEOMETRY_FLAG_DISABLE_ANYHIT
-
-      // now go over all children to set up the buildinputs
-      for (int childID=0;childID<children.size();childID++) {
-        // the three fields we're setting:
-        CUdeviceptr     &d_vertices    = vertexPointers[childID];
-        CUdeviceptr     &d_indices     = indexPointers[childID];
-        OptixBuildInput &triangleInput = triangleInputs[childID];
-
-        // the child wer're setting them with (with sanity checks)
-        Geom *geom = children[childID];
-        assert("double-check geom isn't null" && geom != nullptr);
-        assert("sanity check refcount" && geom->numTimesReferenced >= 0);
-       
-        TrianglesGeom *tris = dynamic_cast<TrianglesGeom*>(geom);
-        assert("double-check it's really triangles" && tris != nullptr);
-        
-        // now fill in the values:
-        d_vertices = (CUdeviceptr )tris->vertexPointer;
-        if (d_vertices == 0)
-          OWL_EXCEPT("in TrianglesGeomGroup::buildAccel(): "
-                     "triangles geom has null vertex array");
-        assert("triangles geom has vertex array set" && d_vertices);
-        
-        d_indices  = (CUdeviceptr )tris->indexPointer;
-        assert("triangles geom has index array set" && d_indices);
+      TrianglesGeomGroup *group
+        = dynamic_cast<TrianglesGeomGroup*>(checkGetGroup(groupID));
+      if (!group)
+        OWL_EXCEPT("group is not a triangles geometry group");
+      group->maxMergedMeshTriangles = maxTrianglesPerMesh;
+    }
+    
+    /*! one build input's worth of triangles: either a single child
+        geom's own arrays, or the merged arrays of a run of
+        consecutive small children */
+    struct TrianglesBuildItem {
+      CUdeviceptr vertices;
+      size_t      vertexStride;
+      size_t      vertexCount;
+      CUdeviceptr indices;
+      size_t      indexStride;
+      size_t      primCount;
+      /*! per-prim SBT index offsets (merged runs only), else 0 */
+      CUdeviceptr sbtIndexOffsets;
+      /*! the first child (and thus, SBT record) of this item */
+      int         firstChild;
+      int         numChildren;
+    };
 
-        triangleInput.type = OPTIX_BUILD_INPUT_TYPE_TRIANGLES;
-        auto &ta = triangleInput.triangleArray;
-        ta.vertexFormat        = OPTIX_VERTEX_FORMAT_FLOAT3;
-        ta.vertexStrideInBytes = (uint32_t)tris->vertexStride;
-        ta.numVertices         = (uint32_t)tris->vertexCount;
-        ta.vertexBuffers       = &d_vertices;
-      
-        ta.indexFormat         = OPTIX_INDICES_FORMAT_UNSIGNED_INT3;
-        ta.indexStrideInBytes  = (uint32_t)tris->indexStride;
-        ta.numIndexTriplets    = (uint32_t)tris->indexCount;
-        ta.indexBuffer         = d_indices;
+    /*! downloads this geom's vertex/index arrays into the given
+        staging vectors, and returns a host view of them */
+    MeshView TrianglesGeom::download(std::vector<uint8_t> &vertexStaging,
+                                     std::vector<uint8_t> &indexStaging) const
+    {
+      // the last element only needs its own 12 bytes, not a full stride
+      const size_t vertexBytes
+        = vertexCount ? (vertexCount-1)*vertexStride+sizeof(vec3f) : 0;
+      const size_t indexBytes
+        = indexCount ? (indexCount-1)*indexStride+sizeof(vec3i) : 0;
+      vertexStaging.resize(vertexBytes);
+      indexStaging.resize(indexBytes);
+      if (vertexBytes)
+        CUDA_CALL(Memcpy(vertexStaging.data(),vertexPointer,
+                         vertexBytes,cudaMemcpyDeviceToHost));
+      if (indexBytes)
+        CUDA_CALL(Memcpy(indexStaging.data(),indexPointer,
+                         indexBytes,cudaMemcpyDeviceToHost));
+      return { vertexStaging.data(), vertexStride, vertexCount,
+               indexStaging.data(),  indexStride,  indexCount };
+    }
 
-        // -------------------------------------------------------
-        // sanity check that we don't have too many prims
-        // -------------------------------------------------------
-        sumPrims += ta.numIndexTriplets;
-        if (sumPrims > maxPrimsPerGAS) 
-          throw std::runtime_error("number of prim in user geom group exceeds "
-                                   "OptiX's MAX_PRIMITIVES_PER_GAS limit");
-        
-        // we always have exactly one SBT entry per shape (i.e., triangle
-        // mesh), and no per-primitive materials:
-        ta.flags                       = triangleInputFlags;
-        // iw, jan 7, 2020: note this is not the "actual" number of
-        // SBT entires we'll generate when we build the SBT, only the
-        // number of per-ray-type 'groups' of SBT entities (i.e., before
-        // scaling by the SBT_STRIDE that gets passed to
-        // optixTrace. So, for the build input this value remains *1*).
-        ta.numSbtRecords               = 1; 
-        ta.sbtIndexOffsetBuffer        = 0; 
-        ta.sbtIndexOffsetSizeInBytes   = 0; 
-        ta.sbtIndexOffsetStrideInBytes = 0; 
-      }
-      
+    /*! builds (and compacts) a triangles accel over the given
+        build inputs */
+    void buildTrianglesAccel(Context *context,
+                             std::vector<OptixBuildInput> &triangleInputs,
+                             DeviceMemory &bvhMemory,
+                             OptixTraversableHandle &traversable,
+                             uint32_t extraBuildFlags)
+    {
       // ==================================================================
       // BLAS setup: buildinputs set up, build the blas
       // ==================================================================
@@ -184,7 +146,9 @@ namespace owl {
       accelOptions.buildFlags =
         OPTIX_BUILD_FLAG_PREFER_FAST_TRACE
         |
-        OPTIX_BUILD_FLAG_ALLOW_COMPACTION;
+        OPTIX_BUILD_FLAG_ALLOW_COMPACTION
+        |
+        extraBuildFlags;
 
       accelOptions.motionOptions.numKeys  = 1;
       accelOptions.operation              = OPTIX_BUILD_OPERATION_BUILD;
@@ -223,6 +187,7 @@ namespace owl {
       emitDesc.type = OPTIX_PROPERTY_TYPE_COMPACTED_SIZE;
       emitDesc.result = (CUdeviceptr)compactedSizeBuffer.get();
       
+      AccelBuildTimer buildTimer(context);
       OPTIX_CHECK(optixAccelBuild(context->optixContext,
                                   /* todo: stream */0,
                                   &accelOptions,
@@ -261,6 +226,12 @@ namespace owl {
                               bvhMemory.size(),
                               &traversable));
       CUDA_SYNC_CHECK();
+      buildTimer.stop();
+      if (context->buildStats)
+        context->buildStats->addAccel(triangleInputs.size(),
+                                      blasBufferSizes.tempSizeInBytes,
+                                      blasBufferSizes.outputSizeInBytes,
+                                      compactedSize);
 
 #if 0
       std::vector<uint8_t> dumpBuffer(bvhMemory.size());
@@ -276,6 +247,220 @@ namespace owl {
       outputBuffer.free(); // << the UNcompacted, temporary output buffer
       tempBuffer.free();
       compactedSizeBuffer.free();
+    }
+    
+    void TrianglesGeomGroup::buildAccel(Context *context) 
+    {
+      OWL_HISTOGRAM_SCOPE("owl_accel_build_seconds{kind=\"triangles\"}");
+      assert("check does not yet exist" && traversable == 0);
+      assert("check does not yet exist" && bvhMemory.empty());
+      
+      context->pushActive();
+      LOG("building triangles accel over "
+          << children.size() << " geometries");
+
+      size_t sumPrims = 0;
+      const uint32_t maxPrimsPerGAS = context->maxPrimsPerGAS;
+
+      // ==================================================================
+      // decide which (runs of) children go into which build input -
+      // one per child, unless merging of small meshes is enabled
+      // ==================================================================
+      std::vector<size_t> triangleCounts(children.size());
+      std::vector<int>    geomTypes(children.size());
+      for (int childID=0;childID<children.size();childID++) {
+        // the child wer're setting them with (with sanity checks)
+        Geom *geom = children[childID];
+        assert("double-check geom isn't null" && geom != nullptr);
+        assert("sanity check refcount" && geom->numTimesReferenced >= 0);
+       
+        TrianglesGeom *tris = dynamic_cast<TrianglesGeom*>(geom);
+        assert("double-check it's really triangles" && tris != nullptr);
+        if (tris->vertexPointer == nullptr)
+          OWL_EXCEPT("in TrianglesGeomGroup::buildAccel(): "
+                     "triangles geom has null vertex array");
+        assert("triangles geom has index array set" && tris->indexPointer);
+        triangleCounts[childID] = tris->indexCount;
+        geomTypes[childID]      = tris->geomTypeID;
+        sumPrims += tris->indexCount;
+      }
+      if (context->buildStats)
+        context->buildStats->numPrimitives = sumPrims;
+      std::vector<MeshRun> runs;
+      if (maxMergedMeshTriangles > 0)
+        runs = planMeshMerging(triangleCounts,geomTypes,
+                               maxMergedMeshTriangles,maxPrimsPerGAS);
+      else
+        for (int childID=0;childID<children.size();childID++)
+          runs.push_back({ childID, 1 });
+
+      size_t numMergedRuns = 0;
+      for (auto &run : runs)
+        if (run.numChildren > 1) numMergedRuns++;
+      if (numMergedRuns)
+        LOG("merging small meshes: " << children.size()
+            << " geometries go into " << runs.size() << " build inputs");
+      // note: resize only once - DeviceMemory is not safe to copy
+      mergedMeshes.resize(numMergedRuns);
+      size_t numMergedItems = 0;
+      childPrimBase.assign(children.size(),0);
+
+      std::vector<TrianglesBuildItem> items;
+      for (auto &run : runs) {
+        if (run.numChildren == 1) {
+          TrianglesGeom *tris = (TrianglesGeom*)children[run.firstChild];
+          items.push_back({ (CUdeviceptr)tris->vertexPointer,
+                            tris->vertexStride, tris->vertexCount,
+                            (CUdeviceptr)tris->indexPointer,
+                            tris->indexStride, tris->indexCount,
+                            0, run.firstChild, 1 });
+          continue;
+        }
+        // stage the run's arrays on the host, concatenate them, and
+        // upload the result as one mesh
+        std::vector<std::vector<uint8_t>> vertexStaging(run.numChildren);
+        std::vector<std::vector<uint8_t>> indexStaging(run.numChildren);
+        std::vector<MeshView> views(run.numChildren);
+        for (int i=0;i<run.numChildren;i++)
+          views[i] = ((TrianglesGeom*)children[run.firstChild+i])
+            ->download(vertexStaging[i],indexStaging[i]);
+        const MergedMesh merged = mergeMeshes(views);
+        for (int i=0;i<run.numChildren;i++)
+          childPrimBase[run.firstChild+i] = (uint32_t)merged.primBegin[i];
+
+        MergedMeshBuffers &buffers = mergedMeshes[numMergedItems++];
+        buffers.vertices.alloc(merged.vertices.size()*sizeof(vec3f));
+        buffers.vertices.upload(merged.vertices);
+        buffers.indices.alloc(merged.indices.size()*sizeof(vec3i));
+        buffers.indices.upload(merged.indices);
+        buffers.sbtIndexOffsets.alloc(merged.meshOfPrim.size()*sizeof(uint32_t));
+        buffers.sbtIndexOffsets.upload(merged.meshOfPrim);
+        items.push_back({ (CUdeviceptr)buffers.vertices.get(),
+                          sizeof(vec3f), merged.vertices.size(),
+                          (CUdeviceptr)buffers.indices.get(),
+                          sizeof(vec3i), merged.indices.size(),
+                          (CUdeviceptr)buffers.sbtIndexOffsets.get(),
+                          run.firstChild, run.numChildren });
+      }
+      
+      // ==================================================================
+      // sanity check that we don't have too many prims - or, if
+      // enabled, split the group into parts that each are within the
+      // limit
+      // ==================================================================
+      if (sumPrims > maxPrimsPerGAS && !context->splitOversizedGroups) 
+        throw std::runtime_error("number of prim in user geom group exceeds "
+                                 "OptiX's MAX_PRIMITIVES_PER_GAS limit");
+      std::vector<size_t> primCounts(items.size());
+      for (size_t itemID=0;itemID<items.size();itemID++)
+        primCounts[itemID] = items[itemID].primCount;
+      const std::vector<std::vector<PrimRange>> parts
+        = partitionPrimRanges(primCounts,maxPrimsPerGAS);
+      const bool split = parts.size() > 1;
+      if (split) {
+        LOG("triangles geom group exceeds MAX_PRIMITIVES_PER_GAS, splitting into "
+            << parts.size() << " parts");
+        // note: resize only once - DeviceMemory is not safe to copy
+        splitParts.resize(parts.size());
+      }
+      
+      // for now we use the same flags for all geoms; merged build
+      // inputs need one entry per SBT record
+      size_t maxRunLength = 1;
+      for (auto &run : runs)
+        maxRunLength = std::max(maxRunLength,(size_t)run.numChildren);
+      std::vector<uint32_t> triangleInputFlags(maxRunLength,0);
+      // { OPTIX_GEOMETRY_FLAG_DISABLE_ANYHIT
+      
+      // merged meshes' primitive IDs no longer match their geoms'
+      // (see owl::getPrimitiveIndexInGeom()), so also let programs
+      // query the hit triangle's vertices directly
+      const uint32_t extraBuildFlags
+        = numMergedItems ? OPTIX_BUILD_FLAG_ALLOW_RANDOM_VERTEX_ACCESS : 0;
+
+      std::vector<uint32_t> partSBTOffsets;
+      for (size_t partID=0;partID<parts.size();partID++) {
+        const std::vector<PrimRange> &part = parts[partID];
+        
+        // ==================================================================
+        // create triangle inputs
+        // ==================================================================
+        //! the N build inputs that go into the builder
+        std::vector<OptixBuildInput> triangleInputs(part.size());
+        /*! *arrays* of the vertex pointers - the buildinputs cointina
+         *pointers* to the pointers, so need a temp copy here */
+        std::vector<CUdeviceptr> vertexPointers(part.size());
+        std::vector<CUdeviceptr> indexPointers(part.size());
+
+        // now go over all build items to set up the buildinputs
+        for (int rangeID=0;rangeID<part.size();rangeID++) {
+          const PrimRange &range = part[rangeID];
+          // the three fields we're setting:
+          CUdeviceptr     &d_vertices    = vertexPointers[rangeID];
+          CUdeviceptr     &d_indices     = indexPointers[rangeID];
+          OptixBuildInput &triangleInput = triangleInputs[rangeID];
+
+          const TrianglesBuildItem &item = items[range.child];
+        
+          // now fill in the values:
+          d_vertices = item.vertices;
+          d_indices  = item.indices + range.begin * item.indexStride;
+
+          triangleInput.type = OPTIX_BUILD_INPUT_TYPE_TRIANGLES;
+          auto &ta = triangleInput.triangleArray;
+          ta.vertexFormat        = OPTIX_VERTEX_FORMAT_FLOAT3;
+          ta.vertexStrideInBytes = (uint32_t)item.vertexStride;
+          ta.numVertices         = (uint32_t)item.vertexCount;
+          ta.vertexBuffers       = &d_vertices;
+      
+          ta.indexFormat         = OPTIX_INDICES_FORMAT_UNSIGNED_INT3;
+          ta.indexStrideInBytes  = (uint32_t)item.indexStride;
+          ta.numIndexTriplets    = (uint32_t)(range.end - range.begin);
+          ta.indexBuffer         = d_indices;
+          // keeps primitive IDs the same as in the un-split mesh
+          ta.primitiveIndexOffset = (uint32_t)range.begin;
+        
+          // we always have exactly one SBT entry per shape (i.e., triangle
+          // mesh), and no per-primitive materials:
+          ta.flags                       = triangleInputFlags.data();
+          // iw, jan 7, 2020: note this is not the "actual" number of
+          // SBT entires we'll generate when we build the SBT, only the
+          // number of per-ray-type 'groups' of SBT entities (i.e., before
+          // scaling by the SBT_STRIDE that gets passed to
+          // optixTrace. So, for the build input this value remains *1*
+          // - or, for merged meshes, the number of meshes merged).
+          ta.numSbtRecords               = item.numChildren; 
+          if (item.sbtIndexOffsets) {
+            ta.sbtIndexOffsetBuffer
+              = item.sbtIndexOffsets + range.begin * sizeof(uint32_t);
+            ta.sbtIndexOffsetSizeInBytes   = sizeof(uint32_t); 
+            ta.sbtIndexOffsetStrideInBytes = sizeof(uint32_t);
+          } else {
+            ta.sbtIndexOffsetBuffer        = 0; 
+            ta.sbtIndexOffsetSizeInBytes   = 0; 
+            ta.sbtIndexOffsetStrideInBytes = 0;
+          }
+        }
+
+        if (!split) {
+          buildTrianglesAccel(context,triangleInputs,bvhMemory,traversable,
+                              extraBuildFlags);
+          continue;
+        }
+        buildTrianglesAccel(context,triangleInputs,
+                            splitParts[partID].bvhMemory,
+                            splitParts[partID].traversable,
+                            extraBuildFlags);
+        // the build inputs of each part are consecutive children, so
+        // the part's SBT records start at those of its first child
+        // (even if that one's part of a merged mesh that started in
+        // the previous part)
+        partSBTOffsets.push_back
+          ((uint32_t)(context->numRayTypes
+                      * (sbtOffset + items[part[0].child].firstChild)));
+      }
+      if (split)
+        buildOverSplitParts(context,partSBTOffsets);
       
       context->popActive();
 
@@ -15,59 +15,23 @@
 // ======================================================================== //
 
 #include "Device.h"
+#include "GroupSplitting.h"
 #include <fstream>
 
+/*! group builds can happen every frame, so everything in here
+    logs at debug level */
 #define LOG(message)                                            \
-  if (Context::logging())                                       \
-    std::cout << "#owl.ll(" << context->owlDeviceID << "): "    \
-              << message                                        \
-              << std::endl
+  OWL_LOG(LEVEL_DEBUG,"#owl.ll(" << context->owlDeviceID << "): " \
+          << message)
 
 #define LOG_OK(message)                                         \
-  if (Context::logging())                                       \
-    std::cout << OWL_TERMINAL_GREEN                             \
-              << "#owl.ll(" << context->owlDeviceID << "): "    \
-              << message << OWL_TERMINAL_DEFAULT << std::endl
-
-#define CLOG(message)                                   \
-  if (Context::logging())                               \
-    std::cout << "#owl.ll(" << owlDeviceID << "): "     \
-              << message                                \
-              << std::endl
-
-#define CLOG_OK(message)                                        \
-  if (Context::logging())                                       \
-    std::cout << OWL_TERMINAL_GREEN                             \
-              << "#owl.ll(" << owlDeviceID << "): "             \
-              << message << OWL_TERMINAL_DEFAULT << std::endl
+  OWL_LOG_COLOR(LEVEL_DEBUG,OWL_TERMINAL_GREEN,                 \
+                "#owl.ll(" << context->owlDeviceID << "): "     \
+                << message)
 
 namespace owl {
   namespace ll {
 
-    void dbgPrintBVHSizes(size_t numItems,
-                          size_t boundsArraySize,
-                          size_t tempMemSize,
-                          size_t initialBVHSize,
-                          size_t finalBVHSize)
-    {
-#if _WIN32
-      static char *wantToPrint = nullptr;
-#else
-      static char *wantToPrint = getenv("OWL_PRINT_BVH_MEM");
-#endif
-      if (!wantToPrint) return;
-      
-      std::cout << OWL_TERMINAL_YELLOW
-                << "@owl: bvh build mem: "
-                << prettyNumber(numItems) << " items, "
-                << prettyNumber(boundsArraySize) << "b bounds, "
-                << prettyNumber(tempMemSize) << "b temp, "
-                << prettyNumber(initialBVHSize) << "b initBVH, "
-                << prettyNumber(finalBVHSize) << "b finalBVH"
-                << OWL_TERMINAL_DEFAULT
-                << std::endl;
-    }
-    
     void Device::groupBuildPrimitiveBounds(int groupID,
                                            size_t maxGeomDataSize,
                                            LLOWriteUserGeomBoundsDataCB cb,
@@ -81,12 +45,7 @@ namespace owl {
       DeviceMemory tempMem;
       tempMem.alloc(maxGeomDataSize);
       size_t sumPrims = 0;
-      uint32_t maxPrimsPerGAS = 0;
-      optixDeviceContextGetProperty
-        (context->optixContext,
-         OPTIX_DEVICE_PROPERTY_LIMIT_MAX_PRIMITIVES_PER_GAS,
-         &maxPrimsPerGAS,
-         sizeof(maxPrimsPerGAS));
+      const uint32_t maxPrimsPerGAS = context->maxPrimsPerGAS;
       
       for (int childID=0;childID<ugg->children.size();childID++) {
         Geom *child = ugg->children[childID];
@@ -106,7 +65,7 @@ namespace owl {
         
         uint32_t numPrims = (uint32_t)ug->numPrims;
         sumPrims += numPrims;
-        if (sumPrims > maxPrimsPerGAS) 
+        if (sumPrims > maxPrimsPerGAS && !context->splitOversizedGroups) 
           throw std::runtime_error("number of prim in user geom group exceeds "
                                    "OptiX's MAX_PRIMITIVES_PER_GAS limit");
         // size of each thread block during bounds function call
@@ -162,72 +121,17 @@ namespace owl {
         bvhMemory.free();
         traversable = 0;
       }
+      destroySplitParts();
       context->popActive();
     }
     
-    void UserGeomGroup::buildAccel(Context *context) 
+    /*! builds a user geom accel over the given build inputs */
+    static void
+    buildUserGeomAccel(Context *context,
+                       std::vector<OptixBuildInput> &userGeomInputs,
+                       DeviceMemory &bvhMemory,
+                       OptixTraversableHandle &traversable)
     {
-      assert("check does not yet exist" && traversable == 0);
-      assert("check does not yet exist" && bvhMemory.empty());
-      
-      context->pushActive();
-      LOG("building user accel over "
-          << children.size() << " geometries");
-      // ==================================================================
-      // create triangle inputs
-      // ==================================================================
-      //! the N build inputs that go into the builder
-      std::vector<OptixBuildInput> userGeomInputs(children.size());
-      /*! *arrays* of the vertex pointers - the buildinputs cointina
-       *pointers* to the pointers, so need a temp copy here */
-      std::vector<CUdeviceptr> boundsPointers(children.size());
-
-     // for now we use the same flags for all geoms
-      uint32_t userGeomInputFlags[1]
-        = { 0 };
-      // { OPTIX_GEOMETRY_FLAG_DISABLE_ANYHIT };
-
-      // now go over all children to set up the buildinputs
-      for (int childID=0;childID<children.size();childID++) {
-        // the three fields we're setting:
-
-        CUdeviceptr     &d_bounds = boundsPointers[childID];
-        OptixBuildInput &userGeomInput = userGeomInputs[childID];
-        
-        // the child wer're setting them with (with sanity checks)
-        Geom *geom = children[childID];
-        assert("double-check geom isn't null" && geom != nullptr);
-        assert("sanity check refcount" && geom->numTimesReferenced >= 0);
-       
-        UserGeom *userGeom = dynamic_cast<UserGeom*>(geom);
-        assert("double-check it's really user"
-               && userGeom != nullptr);
-        assert("user geom has valid bounds buffer *or* user-supplied bounds"
-               && (userGeom->internalBufferForBoundsProgram.alloced()
-                   || userGeom->d_boundsMemory));
-        d_bounds = (CUdeviceptr)userGeom->d_boundsMemory;
-        
-        userGeomInput.type = OPTIX_BUILD_INPUT_TYPE_CUSTOM_PRIMITIVES;
-        auto &aa = userGeomInput.aabbArray;
-        aa.aabbBuffers   = &d_bounds;
-        aa.numPrimitives = (uint32_t)userGeom->numPrims;
-        aa.strideInBytes = sizeof(box3f);
-        aa.primitiveIndexOffset = 0;
-      
-        // we always have exactly one SBT entry per shape (i.e., triangle
-        // mesh), and no per-primitive materials:
-        aa.flags                       = userGeomInputFlags;
-        // iw, jan 7, 2020: note this is not the "actual" number of
-        // SBT entires we'll generate when we build the SBT, only the
-        // number of per-ray-type 'groups' of SBT enties (i.e., before
-        // scaling by the SBT_STRIDE that gets passed to
-        // optixTrace. So, for the build input this value remains *1*).
-        aa.numSbtRecords               = 1; //context->numRayTypes;
-        aa.sbtIndexOffsetBuffer        = 0; 
-        aa.sbtIndexOffsetSizeInBytes   = 0; 
-        aa.sbtIndexOffsetStrideInBytes = 0; 
-      }
-
       // ==================================================================
       // BLAS setup: buildinputs set up, build the blas
       // ==================================================================
@@ -263,6 +167,7 @@ namespace owl {
       tempBuffer.alloc(blasBufferSizes.tempSizeInBytes);
 
       bvhMemory.alloc(blasBufferSizes.outputSizeInBytes);
+      AccelBuildTimer buildTimer(context);
       OPTIX_CHECK(optixAccelBuild(context->optixContext,
                                   /* todo: stream */0,
                                   &accelOptions,
@@ -282,6 +187,12 @@ namespace owl {
                                   ));
 
       CUDA_SYNC_CHECK();
+      buildTimer.stop();
+      if (context->buildStats)
+        context->buildStats->addAccel(userGeomInputs.size(),
+                                      blasBufferSizes.tempSizeInBytes,
+                                      blasBufferSizes.outputSizeInBytes,
+                                      blasBufferSizes.outputSizeInBytes);
 
 #if 0
       // for debugging only - dumps the BVH to disk
@@ -293,11 +204,126 @@ namespace owl {
       exit(0);
 #endif
       
+      tempBuffer.free();
+    }
+    
+    void UserGeomGroup::buildAccel(Context *context) 
+    {
+      OWL_HISTOGRAM_SCOPE("owl_accel_build_seconds{kind=\"user\"}");
+      assert("check does not yet exist" && traversable == 0);
+      assert("check does not yet exist" && bvhMemory.empty());
+      
+      context->pushActive();
+      LOG("building user accel over "
+          << children.size() << " geometries");
+
+      // ==================================================================
+      // if enabled (and required), split the group into parts that
+      // each are within optix' prims-per-GAS limit; the limit itself
+      // was already checked when building the bounds
+      // ==================================================================
+      const uint32_t maxPrimsPerGAS = context->maxPrimsPerGAS;
+      std::vector<size_t> primCounts(children.size());
+      for (int childID=0;childID<children.size();childID++) {
+        // the child wer're setting them with (with sanity checks)
+        Geom *geom = children[childID];
+        assert("double-check geom isn't null" && geom != nullptr);
+        assert("sanity check refcount" && geom->numTimesReferenced >= 0);
+       
+        UserGeom *userGeom = dynamic_cast<UserGeom*>(geom);
+        assert("double-check it's really user"
+               && userGeom != nullptr);
+        assert("user geom has valid bounds buffer *or* user-supplied bounds"
+               && (userGeom->internalBufferForBoundsProgram.alloced()
+                   || userGeom->d_boundsMemory));
+        primCounts[childID] = userGeom->numPrims;
+      }
+      const std::vector<std::vector<PrimRange>> parts
+        = partitionPrimRanges(primCounts,maxPrimsPerGAS);
+      const bool split = parts.size() > 1;
+      if (split) {
+        if (!context->splitOversizedGroups) 
+          throw std::runtime_error("number of prim in user geom group exceeds "
+                                   "OptiX's MAX_PRIMITIVES_PER_GAS limit");
+        LOG("user geom group exceeds MAX_PRIMITIVES_PER_GAS, splitting into "
+            << parts.size() << " parts");
+        // note: resize only once - DeviceMemory is not safe to copy
+        splitParts.resize(parts.size());
+      }
+      
+     // for now we use the same flags for all geoms
+      uint32_t userGeomInputFlags[1]
+        = { 0 };
+      // { OPTIX_GEOMETRY_FLAG_DISABLE_ANYHIT };
+
+      std::vector<uint32_t> partSBTOffsets;
+      for (size_t partID=0;partID<parts.size();partID++) {
+        const std::vector<PrimRange> &part = parts[partID];
+        
+        // ==================================================================
+        // create user geom inputs
+        // ==================================================================
+        //! the N build inputs that go into the builder
+        std::vector<OptixBuildInput> userGeomInputs(part.size());
+        /*! *arrays* of the vertex pointers - the buildinputs cointina
+         *pointers* to the pointers, so need a temp copy here */
+        std::vector<CUdeviceptr> boundsPointers(part.size());
+
+        // now go over all children to set up the buildinputs
+        for (int rangeID=0;rangeID<part.size();rangeID++) {
+          const PrimRange &range = part[rangeID];
+          // the three fields we're setting:
+
+          CUdeviceptr     &d_bounds = boundsPointers[rangeID];
+          OptixBuildInput &userGeomInput = userGeomInputs[rangeID];
+        
+          UserGeom *userGeom = (UserGeom*)children[range.child];
+          d_bounds
+            = (CUdeviceptr)userGeom->d_boundsMemory
+            + range.begin * sizeof(box3f);
+        
+          userGeomInput.type = OPTIX_BUILD_INPUT_TYPE_CUSTOM_PRIMITIVES;
+          auto &aa = userGeomInput.aabbArray;
+          aa.aabbBuffers   = &d_bounds;
+          aa.numPrimitives = (uint32_t)(range.end - range.begin);
+          aa.strideInBytes = sizeof(box3f);
+          // keeps primitive IDs the same as in the un-split geom
+          aa.primitiveIndexOffset = (uint32_t)range.begin;
+      
+          // we always have exactly one SBT entry per shape (i.e., triangle
+          // mesh), and no per-primitive materials:
+          aa.flags                       = userGeomInputFlags;
+          // iw, jan 7, 2020: note this is not the "actual" number of
+          // SBT entires we'll generate when we build the SBT, only the
+          // number of per-ray-type 'groups' of SBT enties (i.e., before
+          // scaling by the SBT_STRIDE that gets passed to
+          // optixTrace. So, for the build input this value remains *1*).
+          aa.numSbtRecords               = 1; //context->numRayTypes;
+          aa.sbtIndexOffsetBuffer        = 0; 
+          aa.sbtIndexOffsetSizeInBytes   = 0; 
+          aa.sbtIndexOffsetStrideInBytes = 0; 
+        }
+
+        if (split)
+          buildUserGeomAccel(context,userGeomInputs,
+                             splitParts[partID].bvhMemory,
+                             splitParts[partID].traversable);
+        else
+          buildUserGeomAccel(context,userGeomInputs,
+                             bvhMemory,traversable);
+        // the build inputs of each part are consecutive children, so
+        // the part's SBT records start at those of its first child
+        if (split)
+          partSBTOffsets.push_back
+            ((uint32_t)(context->numRayTypes * (sbtOffset + part[0].child)));
+      }
+      if (split)
+        buildOverSplitParts(context,partSBTOffsets);
+      
       // ==================================================================
       // finish - clean up
       // ==================================================================
 
-      tempBuffer.free();
       context->popActive();
 
       LOG_OK("successfully built user geom group accel");
@@ -312,17 +338,10 @@ namespace owl {
         if (userGeom->internalBufferForBoundsProgram.alloced())
           userGeom->internalBufferForBoundsProgram.free();
       }
-      dbgPrintBVHSizes(/*numItems*/
-                       sumPrims,
-                       /*boundsArraySize*/
-                       sumBoundsMem,
-                       /*tempMemSize*/
-                       blasBufferSizes.tempSizeInBytes,
-                       /*initialBVHSize*/
-                       blasBufferSizes.outputSizeInBytes,
-                       /*finalBVHSize*/
-                       0
-                       );
+      if (context->buildStats) {
+        context->buildStats->numPrimitives     = sumPrims;
+        context->buildStats->boundsSizeInBytes = sumBoundsMem;
+      }
     }
     
 
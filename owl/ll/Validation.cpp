@@ -0,0 +1,52 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "Validation.h"
+// std
+#include <sstream>
+#include <stdlib.h>
+
+namespace owl {
+  namespace ll {
+
+    /*! default value: on for debug builds, unless overridden by the
+        OWL_VALIDATION environment variable */
+    static bool initialValidationState()
+    {
+      const char *fromEnv = getenv("OWL_VALIDATION");
+      if (fromEnv)
+        return atoi(fromEnv) != 0;
+#ifdef NDEBUG
+      return false;
+#else
+      return true;
+#endif
+    }
+    
+    bool Validation::active = initialValidationState();
+
+    void Validation::fail(const std::string &message,
+                          const char *file,
+                          int line)
+    {
+      std::stringstream ss;
+      ss << "owl validation failed: " << message
+         << " (" << file << ":" << line << ")";
+      throw std::runtime_error(ss.str());
+    }
+    
+  } // ::owl::ll
+} //::owl
@@ -0,0 +1,68 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include <owl/common/owl-common.h>
+
+namespace owl {
+  namespace ll {
+
+    /*! the one switch for all of OWL's (ll and ng) validation checks
+        - valid IDs, dangling references, instancing depth, etc.
+
+        Validation is on by default in debug builds, and off in
+        release builds; either can be overridden at runtime through
+        the OWL_VALIDATION environment variable ("0" or "1"), or
+        through owlEnableValidation()/lloSetValidation(). It is a
+        process-wide setting, not a per-context one.
+
+        When off, each check costs a single (predicted) branch on
+        'active'; when building with OWL_DISABLE_VALIDATION the checks
+        compile away completely. Checks that are expensive (eg, walking
+        the node graph) should only be done inside an explicit
+        OWL_VALIDATION_ACTIVE() block. */
+    struct Validation {
+      /*! whether validation is currently enabled; use through the
+          OWL_VALIDATION_ACTIVE() macro */
+      static bool active;
+
+      static void setEnabled(bool enabled) { active = enabled; }
+      
+      /*! throws a std::runtime_error for a failed check; never
+          inlined, so the hot paths only see the branch */
+      static void fail(const std::string &message,
+                       const char *file,
+                       int line);
+    };
+    
+  } // ::owl::ll
+} //::owl
+
+#if OWL_DISABLE_VALIDATION
+# define OWL_VALIDATION_ACTIVE() false
+#else
+# define OWL_VALIDATION_ACTIVE() OWL_UNLIKELY(::owl::ll::Validation::active)
+#endif
+
+/*! if validation is enabled, check that 'cond' holds, and throw an
+    exception with given message if it doesn't. Note 'message' only
+    gets evaluated if the check actually fails */
+#define OWL_VALIDATE(cond,message)                                      \
+  do {                                                                  \
+    if (OWL_VALIDATION_ACTIVE() && !(cond))                             \
+      ::owl::ll::Validation::fail(message,__FILE__,__LINE__);           \
+  } while (0)
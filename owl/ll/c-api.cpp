@@ -19,6 +19,11 @@
 
 // internal C++ classes that implement this API
 #include "owl/ll/DeviceGroup.h"
+#include "owl/ll/Validation.h"
+#include "owl/ll/Tracing.h"
+#include "owl/ll/Logging.h"
+#include "owl/ll/HostAllocator.h"
+#include "owl/ll/PerfCounters.h"
 
 #ifndef NDEBUG
 # define EXCEPTIONS_ARE_FATAL 1
@@ -631,6 +636,22 @@ namespace owl {
         });
     }
 
+    /*! re-builds only the SBT entry of the given ray gen program,
+     *  using the given callback to query the app as to what values
+     *  to write for it */
+    OWL_LL_INTERFACE
+    LLOResult lloSbtRayGenBuild(LLOContext llo,
+                                int32_t    rayGenID,
+                                LLOWriteRayGenDataCB writeRayGenDataCB,
+                                const void *callbackData)
+    {
+      return squashExceptions
+        ([&](){
+          DeviceGroup *dg = (DeviceGroup *)llo;
+          dg->sbtRayGenBuild(rayGenID,writeRayGenDataCB,callbackData);
+        });
+    }
+
     OWL_LL_INTERFACE
     LLOResult lloSbtHitProgsBuild(LLOContext llo,
                                   LLOWriteHitProgDataCB writeHitProgDataCB,
@@ -687,6 +708,29 @@ namespace owl {
         return -1;
       }
     }
+
+    OWL_LL_INTERFACE
+    LLOResult lloSetBufferDedup(LLOContext llo,
+                                int32_t    enabled)
+    {
+      return squashExceptions
+        ([&](){
+          DeviceGroup *dg = (DeviceGroup *)llo;
+          dg->setBufferDedup(enabled != 0);
+        });
+    }
+
+    OWL_LL_INTERFACE
+    size_t lloGetBufferDedupBytesSaved(LLOContext llo)
+    {
+      try {
+        DeviceGroup *dg = (DeviceGroup *)llo;
+        return dg->getBufferDedupBytesSaved();
+      } catch (const std::runtime_error &e) {
+        lastErrorText = e.what();
+        return 0;
+      }
+    }
   
     /*! returns the device-side pointer of the given buffer, on the
      *  given device */
@@ -757,6 +801,19 @@ namespace owl {
         return (OptixTraversableHandle)0;
       }
     }
+
+    OWL_LL_INTERFACE
+    size_t lloGroupGetAccelMemory(LLOContext llo,
+                                  int32_t    groupID)
+    {
+      try {
+        DeviceGroup *dg = (DeviceGroup *)llo;
+        return dg->groupGetAccelMemory(groupID);
+      } catch (const std::runtime_error &e) {
+        lastErrorText = e.what();
+        return 0;
+      }
+    }
     
 
   
@@ -806,6 +863,136 @@ namespace owl {
           dg->instanceGroupSetChild(groupID,childID,childGroupID);
         });
     }
+
+    /*! enables (or disables) host-side flattening of all nested
+        instance groups below the given instance group; see
+        llowl.h */
+    OWL_LL_INTERFACE
+    LLOResult lloInstanceGroupSetFlattening(LLOContext llo,
+                                            int32_t    groupID,
+                                            int32_t    enabled,
+                                            size_t     maxFlattenedInstances)
+    {
+      return squashExceptions
+        ([&](){
+          DeviceGroup *dg = (DeviceGroup *)llo;
+          dg->instanceGroupSetFlattening(groupID,enabled != 0,
+                                         maxFlattenedInstances);
+        });
+    }
+
+    OWL_LL_INTERFACE
+    LLOResult lloInstanceGroupSetVisibilityMasks(LLOContext     llo,
+                                                 int32_t        groupID,
+                                                 int32_t        firstChild,
+                                                 size_t         count,
+                                                 const uint8_t *masks)
+    {
+      return squashExceptions
+        ([&](){
+          DeviceGroup *dg = (DeviceGroup *)llo;
+          dg->instanceGroupSetVisibilityMasks(groupID,firstChild,
+                                              count,masks);
+        });
+    }
+
+    OWL_LL_INTERFACE
+    LLOResult lloInstanceGroupSetInstanceFlags(LLOContext      llo,
+                                               int32_t         groupID,
+                                               int32_t         firstChild,
+                                               size_t          count,
+                                               const uint32_t *flags)
+    {
+      return squashExceptions
+        ([&](){
+          DeviceGroup *dg = (DeviceGroup *)llo;
+          dg->instanceGroupSetInstanceFlags(groupID,firstChild,
+                                            count,flags);
+        });
+    }
+
+    OWL_LL_INTERFACE
+    LLOResult lloInstanceGroupSetInstanceIDs(LLOContext      llo,
+                                             int32_t         groupID,
+                                             int32_t         firstChild,
+                                             size_t          count,
+                                             const uint32_t *instanceIDs)
+    {
+      return squashExceptions
+        ([&](){
+          DeviceGroup *dg = (DeviceGroup *)llo;
+          dg->instanceGroupSetInstanceIDs(groupID,firstChild,
+                                          count,instanceIDs);
+        });
+    }
+
+    /*! enables (or disables) morton-order sorting of the instances
+        of the given instance group; see llowl.h */
+    OWL_LL_INTERFACE
+    LLOResult lloInstanceGroupSetSpatialSort(LLOContext llo,
+                                             int32_t    groupID,
+                                             int32_t    enabled)
+    {
+      return squashExceptions
+        ([&](){
+          DeviceGroup *dg = (DeviceGroup *)llo;
+          dg->instanceGroupSetSpatialSort(groupID,enabled != 0);
+        });
+    }
+
+    /*! configures transform baking for the given instance group;
+        see llowl.h */
+    OWL_LL_INTERFACE
+    LLOResult lloInstanceGroupSetTransformBaking(LLOContext llo,
+                                                 int32_t    groupID,
+                                                 size_t     maxTrianglesPerGroup,
+                                                 size_t     maxInstancesPerGroup,
+                                                 size_t     memoryBudget)
+    {
+      return squashExceptions
+        ([&](){
+          DeviceGroup *dg = (DeviceGroup *)llo;
+          dg->instanceGroupSetTransformBaking(groupID,
+                                              maxTrianglesPerGroup,
+                                              maxInstancesPerGroup,
+                                              memoryBudget);
+        });
+    }
+
+    /*! returns the stats of the given instance group's last transform
+        baking pass */
+    OWL_LL_INTERFACE
+    LLOResult lloInstanceGroupGetTransformBakingStats(LLOContext llo,
+                                                      int32_t    groupID,
+                                                      LLOTransformBakingStats *stats)
+    {
+      return squashExceptions
+        ([&](){
+          assert(stats);
+          DeviceGroup *dg = (DeviceGroup *)llo;
+          const TransformBakingStats s
+            = dg->instanceGroupGetTransformBakingStats(groupID);
+          stats->instancesBefore = s.instancesBefore;
+          stats->instancesAfter  = s.instancesAfter;
+          stats->instancesBaked  = s.instancesBaked;
+          stats->trianglesBaked  = s.trianglesBaked;
+          stats->bytesUsed       = s.bytesUsed;
+        });
+    }
+
+    /*! enables (or disables) merging of small meshes in the given
+        triangles geom group; see llowl.h */
+    OWL_LL_INTERFACE
+    LLOResult lloTrianglesGeomGroupSetMeshMerging(LLOContext llo,
+                                                  int32_t    groupID,
+                                                  size_t     maxTrianglesPerMesh)
+    {
+      return squashExceptions
+        ([&](){
+          DeviceGroup *dg = (DeviceGroup *)llo;
+          dg->trianglesGeomGroupSetMeshMerging(groupID,maxTrianglesPerMesh);
+        });
+    }
     
     OWL_LL_INTERFACE
     LLOResult lloGeomGroupSetChild(LLOContext llo,
@@ -831,6 +1018,122 @@ namespace owl {
         });
     }
 
+    OWL_LL_INTERFACE
+    LLOResult lloSetValidation(int32_t enabled)
+    {
+      Validation::setEnabled(enabled != 0);
+      return LLO_SUCCESS;
+    }
+
+    OWL_LL_INTERFACE
+    LLOResult lloSetTracing(int32_t enabled, const char *fileName)
+    {
+      return squashExceptions
+        ([&](){
+          Tracing::setEnabled(enabled != 0,fileName);
+        });
+    }
+
+    OWL_LL_INTERFACE
+    LLOResult lloDumpTrace(const char *fileName)
+    {
+      return squashExceptions
+        ([&](){
+          if (!Tracing::dump(fileName))
+            throw std::runtime_error("could not write trace to '"
+                                     +std::string(fileName)+"'");
+        });
+    }
+
+    OWL_LL_INTERFACE
+    LLOResult lloSetLogLevel(int32_t level)
+    {
+      Logging::setLevel(level);
+      return LLO_SUCCESS;
+    }
+
+    OWL_LL_INTERFACE
+    LLOResult lloSetLogCallback(LLOLogCB callback, void *userData)
+    {
+      return squashExceptions
+        ([&](){
+          Logging::setSink(callback,userData);
+        });
+    }
+
+    static_assert(LLO_HOST_ALLOC_NUM_SITES == (int)HostAllocator::NUM_SITES,
+                  "LLOHostAllocSite does not match HostAllocator::Site");
+    
+    OWL_LL_INTERFACE
+    LLOResult lloSetHostAllocator(LLOHostAllocFn allocFn,
+                                  LLOHostFreeFn  freeFn,
+                                  void *userData)
+    {
+      return squashExceptions
+        ([&](){
+          HostAllocator::set(allocFn,freeFn,userData);
+        });
+    }
+
+    OWL_LL_INTERFACE
+    LLOResult lloGetHostAllocStats(int32_t site,
+                                   LLOHostAllocStats *stats)
+    {
+      return squashExceptions
+        ([&](){
+          if (site < 0 || site >= HostAllocator::NUM_SITES)
+            throw std::runtime_error("invalid host allocation site");
+          assert(stats);
+          const HostAllocator::Stats s = HostAllocator::stats(site);
+          stats->numAllocs      = s.numAllocs;
+          stats->numFrees       = s.numFrees;
+          stats->bytesAllocated = s.bytesAllocated;
+          stats->bytesFreed     = s.bytesFreed;
+        });
+    }
+
+    OWL_LL_INTERFACE
+    LLOResult lloSetPerfCounters(int32_t enabled, int32_t *active)
+    {
+      const bool isActive = PerfCounters::setEnabled(enabled != 0);
+      if (active) *active = isActive;
+      return LLO_SUCCESS;
+    }
+
+    OWL_LL_INTERFACE
+    LLOResult lloSetFramePipelining(LLOContext llo,
+                                    int32_t enabled)
+    {
+      return squashExceptions
+        ([&](){
+          DeviceGroup *dg = (DeviceGroup *)llo;
+          dg->setFramePipelining(enabled != 0);
+        });
+    }
+
+    OWL_LL_INTERFACE
+    LLOResult lloSetGroupSplitting(LLOContext llo,
+                                   int32_t enabled)
+    {
+      return squashExceptions
+        ([&](){
+          DeviceGroup *dg = (DeviceGroup *)llo;
+          dg->setGroupSplitting(enabled != 0);
+        });
+    }
+
+    OWL_LL_INTERFACE
+    LLOResult lloSetBuildStatsCallback(LLOContext llo,
+                                       LLOBuildStatsCB callback,
+                                       void *userData)
+    {
+      return squashExceptions
+        ([&](){
+          DeviceGroup *dg = (DeviceGroup *)llo;
+          dg->setBuildStatsCallback(callback,userData);
+        });
+    }
+
     OWL_LL_INTERFACE
     LLOResult lloSetRayTypeCount(LLOContext llo,
                                  size_t rayTypeCount)
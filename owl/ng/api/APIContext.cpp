@@ -17,32 +17,41 @@
 #include "APIContext.h"
 #include "APIHandle.h"
 #include "owl/ll/Device.h"
+// std
+#include <atomic>
 
-#define LOG(message)                            \
-  if (ll::Context::logging())                   \
-    std::cout                                   \
-      << OWL_TERMINAL_LIGHT_BLUE                \
-      << "#owl.ng: "                            \
-      << message                              \
-      << OWL_TERMINAL_DEFAULT << std::endl
+#define LOG(message)                                    \
+  OWL_LOG_COLOR(LEVEL_INFO,OWL_TERMINAL_LIGHT_BLUE,     \
+                "#owl.ng: " << message)
+
+#define LOG_OK(message)                                 \
+  OWL_LOG_COLOR(LEVEL_INFO,OWL_TERMINAL_BLUE,           \
+                "#owl.ng: " << message)
 
-#define LOG_OK(message)                         \
-  if (ll::Context::logging())                   \
-    std::cout                                   \
-      << OWL_TERMINAL_BLUE                      \
-      << "#owl.ng: "                            \
-      << message                              \
-      << OWL_TERMINAL_DEFAULT << std::endl
   
 namespace owl {
+
+  /*! contexts that got created, but not yet destroyed */
+  static std::atomic<int> numLiveContexts { 0 };
+  
+  APIContext::APIContext(int32_t *requestedDeviceIDs,
+                         int      numRequestedDevices)
+    : Context(requestedDeviceIDs,
+              numRequestedDevices)
+  {
+    numLiveContexts++;
+  }
   
   void APIContext::forget(APIHandle *object)
   {
     std::lock_guard<std::mutex> lock(monitor);
     assert(object);
-    auto it = activeHandles.find(object);
-    assert(it != activeHandles.end());
-    activeHandles.erase(it);
+    assert(object->slot < activeHandles.size());
+    assert(activeHandles[object->slot] == object);
+    APIHandle *last = activeHandles.back();
+    activeHandles[object->slot] = last;
+    last->slot = object->slot;
+    activeHandles.pop_back();
   }
 
   void APIContext::releaseAll()
@@ -53,16 +62,20 @@ namespace owl {
     for (auto handle : activeHandles)
       LOG(" - " + handle->toString());
 
-    // create a COPY of the handles we need to destroy, else
-    // destroying the handles modifies the std::set while we're
-    // iterating through it!
-    std::set<APIHandle *> stillActiveHandles = activeHandles;
-    for (auto handle : stillActiveHandles)  {
+    // destroying a handle removes it from activeHandles, so always
+    // destroy the last one (which doesn't move any others)
+    while (!activeHandles.empty()) {
+      APIHandle *handle = activeHandles.back();
       assert(handle);
       delete handle;
     }
 
     assert(activeHandles.empty());
+    // give back the (empty) handle array, and - once no context is
+    // left to reuse them - the handle free list's blocks
+    ll::HostVector<APIHandle *,ll::HostAllocator::SITE_HANDLES>().swap(activeHandles);
+    if (--numLiveContexts == 0)
+      APIHandle::trimFreeList();
   }
   
   void APIContext::track(APIHandle *object)
@@ -71,9 +84,8 @@ namespace owl {
 
     std::lock_guard<std::mutex> lock(monitor);
     
-    auto it = activeHandles.find(object);
-    assert(it == activeHandles.end());
-    activeHandles.insert(object);
+    object->slot = activeHandles.size();
+    activeHandles.push_back(object);
   }
 
   APIHandle *APIContext::createHandle(Object::SP object)
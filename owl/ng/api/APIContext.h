@@ -15,6 +15,7 @@
 // ======================================================================== //
 
 #include "owl/ng/cpp/Context.h"
+#include "owl/ll/HostAllocator.h"
 #include <mutex>
 
 namespace owl {
@@ -22,13 +23,10 @@ namespace owl {
   struct APIHandle;
   
   struct APIContext : public Context {
-    typedef std::shared_ptr<APIContext> SP;
+    typedef Ref<APIContext> SP;
 
     APIContext(int32_t *requestedDeviceIDs,
-               int      numRequestedDevices)
-      : Context(requestedDeviceIDs,
-                numRequestedDevices)
-    {}
+               int      numRequestedDevices);
     
     APIHandle *createHandle(Object::SP object);
 
@@ -37,9 +35,13 @@ namespace owl {
     void forget(APIHandle *object);
 
     /*! delete - and thereby, release - all handles that we still
-      own. */
+      own. Once that happened for the last live context, OWL holds no
+      more handle memory, so the app can change the host allocator
+      again. */
     void releaseAll();
-    std::set<APIHandle *> activeHandles;
+    /*! all handles we own, in no particular order; each handle knows
+        its slot, so forgetting one is a swap with the last */
+    ll::HostVector<APIHandle *,ll::HostAllocator::SITE_HANDLES> activeHandles;
     
     std::mutex monitor;
   };
@@ -19,13 +19,37 @@
 
 namespace owl {
 
+  /*! never destroyed, so handles that outlive static destruction
+      can still be deleted */
+  static ll::HostFreeList &handleFreeList()
+  {
+    static ll::HostFreeList *freeList
+      = new ll::HostFreeList(sizeof(APIHandle),
+                             ll::HostAllocator::SITE_HANDLES);
+    return *freeList;
+  }
+
+  void *APIHandle::operator new(size_t size)
+  {
+    return handleFreeList().allocate(size);
+  }
+  
+  void APIHandle::operator delete(void *ptr)
+  {
+    handleFreeList().free(ptr);
+  }
+
+  void APIHandle::trimFreeList()
+  {
+    handleFreeList().trim();
+  }
+
   APIHandle::APIHandle(Object::SP object, APIContext *context)
   {
     assert(object);
     assert(context);
     this->object  = object;
-    this->context = std::dynamic_pointer_cast<APIContext>
-      (context->shared_from_this());
+    this->context = context;
     assert(this->object);
     assert(this->context);
   }
@@ -34,8 +34,14 @@ namespace owl {
   struct APIHandle {
     APIHandle(Object::SP object, APIContext *context);
     virtual ~APIHandle();
-    template<typename T> inline std::shared_ptr<T> get();
-    inline std::shared_ptr<APIContext> getContext() const { return context; }
+    /*! returns a new reference to the object behind this handle */
+    template<typename T> inline Ref<T> get();
+    /*! returns the object behind this handle *without* taking a
+        reference to it; for use on hot paths that only use the
+        object for the duration of the API call (the app's handle
+        keeps it alive until then) */
+    template<typename T> inline T *borrow();
+    inline Ref<APIContext> getContext() const { return context; }
     inline bool isContext() const
     {
       return ((void*)object.get() == (void*)context.get());
@@ -46,18 +52,31 @@ namespace owl {
       return object->toString();
     }
     void clear() { object = nullptr; context = nullptr; }
-    std::shared_ptr<Object>     object;
-    std::shared_ptr<APIContext> context;
+
+    /*! handles get created and released for every
+        owl<Object>Set<Type>() call, so they come from a free list
+        rather than from the heap */
+    static void *operator new(size_t size);
+    static void  operator delete(void *ptr);
+    /*! gives the free list's blocks back to the host allocator */
+    static void  trimFreeList();
+    
+    Ref<Object>     object;
+    Ref<APIContext> context;
+    /*! our index in our context's activeHandles */
+    size_t          slot = 0;
   };
 
-  /*! helper functoin that, for a given handle, retrieves a shared-ptr
+  /*! helper functoin that, for a given handle, retrieves a pointer
       to the obejct referenced by this handle, with automatic
       type-cast to the expected type, and error handling if this
       handle does not match the expected type */
-  template<typename T> inline std::shared_ptr<T> APIHandle::get()
+  template<typename T> inline T *APIHandle::borrow()
   {
+    OWL_VALIDATE(object != nullptr,
+                 "using a handle whose object was already destroyed");
     assert(object);
-    std::shared_ptr<T> asT = std::dynamic_pointer_cast<T>(object);
+    T *asT = dynamic_cast<T*>(object.get());
     if (object && !asT) {
       const std::string objectTypeID = typeid(*object.get()).name();
 	
@@ -71,4 +90,9 @@ namespace owl {
     return asT;
   }
   
+  template<typename T> inline Ref<T> APIHandle::get()
+  {
+    return Ref<T>(borrow<T>());
+  }
+  
 } // ::owl  
@@ -17,38 +17,55 @@
 #include <owl/owl.h>
 #include "APIContext.h"
 #include "APIHandle.h"
+#include "owl/ng/cpp/LODSet.h"
+#include "owl/ng/cpp/UpdateJournal.h"
+#include "owl/ll/Tracing.h"
+#include "owl/ll/Metrics.h"
+#include "owl/ll/HostAllocator.h"
+#include "owl/ll/PerfCounters.h"
+// std
+#include <algorithm>
+#include <fstream>
 
 namespace owl {
 
+/*! every API call gets counted, per entry point (see
+    owl/ll/Metrics.h) */
+#define OWL_COUNT_API_CALL()                                    \
+  OWL_COUNTER_ADD(std::string("owl_api_calls_total{entry=\"")  \
+                  +__FUNCTION__+"\"}",1)
+
 #if 1
-# define LOG_API_CALL() /* ignore */
+/*! every API call is a trace event (see owl/ll/Tracing.h); calls
+    that are interesting to correlate with what happens inside use
+    LOG_API_CALL_ARGS() to record (up to two) of their arguments */
+# define LOG_API_CALL()                                         \
+  OWL_TRACE_SCOPE("api",__FUNCTION__);                          \
+  OWL_COUNT_API_CALL()
+# define LOG_API_CALL_ARGS(...)                                 \
+  OWL_TRACE_SCOPE("api",__FUNCTION__,__VA_ARGS__);              \
+  OWL_COUNT_API_CALL()
 #else 
 # define LOG_API_CALL() std::cout << "% " << __FUNCTION__ << "(...)" << std::endl;
+# define LOG_API_CALL_ARGS(...) LOG_API_CALL()
 #endif
 
 
-#define LOG(message)                            \
-  if (ll::Context::logging())                   \
-    std::cout                                   \
-      << OWL_TERMINAL_LIGHT_BLUE                \
-      << "#owl.ng: "                            \
-      << message                                \
-      << OWL_TERMINAL_DEFAULT << std::endl
-
-#define LOG_OK(message)                         \
-  if (ll::Context::logging())                   \
-    std::cout                                   \
-      << OWL_TERMINAL_BLUE                      \
-      << "#owl.ng: "                            \
-      << message                                \
-      << OWL_TERMINAL_DEFAULT << std::endl
+#define LOG(message)                                    \
+  OWL_LOG_COLOR(LEVEL_INFO,OWL_TERMINAL_LIGHT_BLUE,     \
+                "#owl.ng: " << message)
+
+#define LOG_OK(message)                                 \
+  OWL_LOG_COLOR(LEVEL_INFO,OWL_TERMINAL_BLUE,           \
+                "#owl.ng: " << message)
+
   
   OWL_API OWLContext owlContextCreate(int32_t *requestedDeviceIDs,
                                       int      numRequestedDevices)
   {
     LOG_API_CALL();
-    APIContext::SP context = std::make_shared<APIContext>(requestedDeviceIDs,
-                                                          numRequestedDevices);
+    APIContext::SP context = makeRef<APIContext>(requestedDeviceIDs,
+                                                 numRequestedDevices);
     LOG("context created...");
     return (OWLContext)context->createHandle(context);
   }
@@ -98,6 +115,354 @@ namespace owl {
     assert(context);
     context->setMaxInstancingDepth(maxInstanceDepth);
   }
+
+  /*! enables or disables the (process-wide) validation layer */
+  OWL_API void
+  owlEnableValidation(int32_t enabled)
+  {
+    LOG_API_CALL();
+    lloSetValidation(enabled);
+  }
+
+  /*! enables or disables the (process-wide) tracer */
+  OWL_API void
+  owlEnableTracing(int32_t enabled, const char *fileName)
+  {
+    LOG_API_CALL();
+    lloSetTracing(enabled,fileName);
+  }
+
+  OWL_API void
+  owlDumpTrace(const char *fileName)
+  {
+    LOG_API_CALL();
+    assert(fileName);
+    if (lloDumpTrace(fileName) != LLO_SUCCESS)
+      throw std::runtime_error("could not write trace to '"
+                               +std::string(fileName)+"'");
+  }
+
+  /*! sets the (process-wide) log level */
+  OWL_API void
+  owlSetLogLevel(OWLLogLevel level)
+  {
+    LOG_API_CALL();
+    lloSetLogLevel(level);
+  }
+
+  /*! the app's log callback; ll's sink takes the level as a plain
+      int, so we go through a trampoline */
+  struct AppLogCallback {
+    OWLLogCallback callback;
+    void          *userData;
+  };
+  static AppLogCallback *appLogCallback = nullptr;
+
+  static void forwardLogMessage(int32_t level,
+                                const char *message,
+                                void *userData)
+  {
+    AppLogCallback *app = (AppLogCallback *)userData;
+    app->callback((OWLLogLevel)level,message,app->userData);
+  }
+  
+  OWL_API void
+  owlSetLogCallback(OWLLogCallback callback, void *userData)
+  {
+    LOG_API_CALL();
+    AppLogCallback *prev = appLogCallback;
+    appLogCallback
+      = callback
+      ? new AppLogCallback{callback,userData}
+      : nullptr;
+    lloSetLogCallback(callback ? forwardLogMessage : nullptr,
+                      appLogCallback);
+    // ll won't call the previous sink any more, so it's safe to go
+    delete prev;
+  }
+
+  /*! enables or disables 'frame pipelining' (double-buffered SBT) */
+  OWL_API void
+  owlContextSetFramePipelining(OWLContext _context,
+                               int32_t enabled)
+  {
+    LOG_API_CALL();
+    assert(_context);
+    APIContext::SP context
+      = ((APIHandle *)_context)->get<APIContext>();
+    assert(context);
+    context->setFramePipelining(enabled != 0);
+  }
+
+  /*! enables or disables automatic splitting of oversized groups */
+  OWL_API void
+  owlContextSetGroupSplitting(OWLContext _context,
+                              int32_t enabled)
+  {
+    LOG_API_CALL();
+    assert(_context);
+    APIContext::SP context
+      = ((APIHandle *)_context)->get<APIContext>();
+    assert(context);
+    context->setGroupSplitting(enabled != 0);
+  }
+
+  OWL_API void
+  owlContextSetBuildStatsCallback(OWLContext _context,
+                                  OWLBuildStatsCallback callback,
+                                  void *userData)
+  {
+    LOG_API_CALL();
+    assert(_context);
+    APIContext::SP context
+      = ((APIHandle *)_context)->get<APIContext>();
+    assert(context);
+    context->setBuildStatsCallback(callback,userData);
+  }
+
+  /*! enables or disables deduplication of device buffers */
+  OWL_API void
+  owlContextSetBufferDedup(OWLContext _context,
+                           int32_t enabled)
+  {
+    LOG_API_CALL();
+    assert(_context);
+    APIContext::SP context
+      = ((APIHandle *)_context)->get<APIContext>();
+    assert(context);
+    context->setBufferDedup(enabled != 0);
+  }
+
+  OWL_API size_t
+  owlContextGetBufferDedupBytesSaved(OWLContext _context)
+  {
+    LOG_API_CALL();
+    assert(_context);
+    APIContext::SP context = ((APIHandle *)_context)->getContext();
+    assert(context);
+    return lloGetBufferDedupBytesSaved(context->llo);
+  }
+
+  OWL_API void
+  owlContextDumpStats(OWLContext _context,
+                      const char *fileName)
+  {
+    LOG_API_CALL();
+    assert(_context);
+    APIContext::SP context = ((APIHandle *)_context)->getContext();
+    assert(context);
+    context->dumpStats(fileName);
+  }
+
+  static_assert(OWL_METRICS_NUM_BUCKETS == (int)ll::Metrics::NUM_BUCKETS,
+                "OWL_METRICS_NUM_BUCKETS does not match ll::Metrics");
+
+  /*! what an OWLMetrics handed out by owlContextGetMetrics points
+      into */
+  struct MetricsSnapshot : public OWLMetrics {
+    ll::Metrics::Snapshot            snapshot;
+    std::vector<OWLMetricsValue>     counterValues;
+    std::vector<OWLMetricsValue>     gaugeValues;
+    std::vector<OWLMetricsHistogram> histogramValues;
+    std::string                      text;
+  };
+
+  static void exportValues(const std::vector<ll::Metrics::Snapshot::Counter> &in,
+                           std::vector<OWLMetricsValue> &out)
+  {
+    out.resize(in.size());
+    for (size_t i=0;i<in.size();i++) {
+      out[i].name  = in[i].name.c_str();
+      out[i].value = in[i].value;
+    }
+  }
+  
+  OWL_API const OWLMetrics *
+  owlContextGetMetrics(OWLContext _context)
+  {
+    LOG_API_CALL();
+    assert(_context);
+    APIContext::SP context = ((APIHandle *)_context)->getContext();
+    assert(context);
+
+    MetricsSnapshot *metrics = new MetricsSnapshot;
+    metrics->snapshot = ll::Metrics::snapshot();
+    {
+      std::lock_guard<std::mutex> lock(context->monitor);
+      metrics->snapshot.gauges.push_back
+        ({"owl_api_handles",(uint64_t)context->activeHandles.size()});
+    }
+    for (int site=0;site<ll::HostAllocator::NUM_SITES;site++)
+      metrics->snapshot.gauges.push_back
+        ({std::string("owl_host_alloc_live_bytes{site=\"")
+          +ll::HostAllocator::siteName(site)+"\"}",
+          ll::HostAllocator::stats(site).bytesLive()});
+    metrics->snapshot.gauges.push_back
+      ({"owl_perf_counters_active",(uint64_t)ll::PerfCounters::active});
+    std::sort(metrics->snapshot.gauges.begin(),
+              metrics->snapshot.gauges.end(),
+              [](const ll::Metrics::Snapshot::Counter &a,
+                 const ll::Metrics::Snapshot::Counter &b)
+              { return a.name < b.name; });
+    exportValues(metrics->snapshot.counters,metrics->counterValues);
+    exportValues(metrics->snapshot.gauges,metrics->gaugeValues);
+    auto &histograms = metrics->snapshot.histograms;
+    metrics->histogramValues.resize(histograms.size());
+    for (size_t i=0;i<histograms.size();i++) {
+      OWLMetricsHistogram &h = metrics->histogramValues[i];
+      h.name  = histograms[i].name.c_str();
+      h.count = histograms[i].count;
+      h.sumNs = histograms[i].sum;
+      h.maxNs = histograms[i].max;
+      std::copy(histograms[i].buckets,
+                histograms[i].buckets+OWL_METRICS_NUM_BUCKETS,
+                h.buckets);
+    }
+    metrics->numCounters   = metrics->counterValues.size();
+    metrics->counters      = metrics->counterValues.data();
+    metrics->numGauges     = metrics->gaugeValues.size();
+    metrics->gauges        = metrics->gaugeValues.data();
+    metrics->numHistograms = metrics->histogramValues.size();
+    metrics->histograms    = metrics->histogramValues.data();
+    return metrics;
+  }
+
+  OWL_API const char *
+  owlMetricsToText(const OWLMetrics *_metrics)
+  {
+    LOG_API_CALL();
+    assert(_metrics);
+    MetricsSnapshot *metrics
+      = (MetricsSnapshot *)static_cast<const MetricsSnapshot *>(_metrics);
+    if (metrics->text.empty())
+      metrics->text = metrics->snapshot.toText();
+    return metrics->text.c_str();
+  }
+
+  OWL_API void
+  owlMetricsRelease(const OWLMetrics *metrics)
+  {
+    LOG_API_CALL();
+    delete static_cast<const MetricsSnapshot *>(metrics);
+  }
+
+  static_assert((int)OWL_HOST_ALLOC_HANDLES   == (int)LLO_HOST_ALLOC_HANDLES &&
+                (int)OWL_HOST_ALLOC_VARIABLES == (int)LLO_HOST_ALLOC_VARIABLES &&
+                (int)OWL_HOST_ALLOC_LAUNCH    == (int)LLO_HOST_ALLOC_LAUNCH &&
+                (int)OWL_HOST_ALLOC_ACCEL     == (int)LLO_HOST_ALLOC_ACCEL &&
+                (int)OWL_HOST_ALLOC_NUM_SITES == (int)LLO_HOST_ALLOC_NUM_SITES,
+                "OWLHostAllocSite does not match LLOHostAllocSite");
+  
+  OWL_API void
+  owlSetHostAllocator(OWLHostAllocFn allocFn,
+                      OWLHostFreeFn  freeFn,
+                      void *userData)
+  {
+    LOG_API_CALL();
+    if (lloSetHostAllocator(allocFn,freeFn,userData) != LLO_SUCCESS)
+      throw std::runtime_error("could not change the host allocator: OWL "
+                               "still holds memory from the current one");
+  }
+  
+  OWL_API OWLHostAllocStats
+  owlGetHostAllocStats(OWLHostAllocSite site)
+  {
+    LOG_API_CALL();
+    LLOHostAllocStats stats;
+    if (lloGetHostAllocStats(site,&stats) != LLO_SUCCESS)
+      throw std::runtime_error("invalid host allocation site");
+    OWLHostAllocStats result;
+    result.numAllocs      = stats.numAllocs;
+    result.numFrees       = stats.numFrees;
+    result.bytesAllocated = stats.bytesAllocated;
+    result.bytesFreed     = stats.bytesFreed;
+    return result;
+  }
+
+  OWL_API void
+  owlDumpHostAllocStats(const char *fileName)
+  {
+    LOG_API_CALL();
+    const std::string report = ll::HostAllocator::report();
+    if (!fileName || std::string(fileName) == "-") {
+      std::cout << report;
+      return;
+    }
+    std::ofstream out(fileName);
+    if (!out)
+      throw std::runtime_error("could not open '"+std::string(fileName)
+                               +"' for the host allocation report");
+    out << report;
+  }
+
+  OWL_API int32_t
+  owlEnablePerfCounters(int32_t enabled)
+  {
+    LOG_API_CALL();
+    int32_t active = 0;
+    lloSetPerfCounters(enabled,&active);
+    return active;
+  }
+
+  static_assert((int)OWL_UPDATE_TRANSFORMS       == (int)journal::TRANSFORMS &&
+                (int)OWL_UPDATE_CHILDREN         == (int)journal::CHILDREN &&
+                (int)OWL_UPDATE_VISIBILITY_MASKS == (int)journal::VISIBILITY_MASKS &&
+                (int)OWL_UPDATE_VARIABLE         == (int)journal::VARIABLE,
+                "OWLUpdateType does not match the update journal's record types");
+  static_assert((int)OWL_UPDATE_TARGET_GEOM     == (int)journal::TARGET_GEOM &&
+                (int)OWL_UPDATE_TARGET_RAYGEN   == (int)journal::TARGET_RAYGEN &&
+                (int)OWL_UPDATE_TARGET_MISSPROG == (int)journal::TARGET_MISSPROG &&
+                OWL_UPDATES_MAGIC   == (int)journal::MAGIC &&
+                OWL_UPDATES_VERSION == (int)journal::VERSION,
+                "OWLUpdateTarget does not match the update journal's targets");
+
+  OWL_API size_t
+  owlContextApplyUpdates(OWLContext _context,
+                         const void *data,
+                         size_t size)
+  {
+    LOG_API_CALL_ARGS("size",size);
+    assert(_context);
+    APIContext::SP context = ((APIHandle *)_context)->getContext();
+    assert(context);
+    return context->applyUpdates(data,size);
+  }
+
+  OWL_API int32_t owlGroupGetID(OWLGroup _group)
+  {
+    LOG_API_CALL();
+    assert(_group);
+    Group *group = ((APIHandle *)_group)->borrow<Group>();
+    assert(group);
+    return group->ID;
+  }
+  
+  OWL_API int32_t owlGeomGetID(OWLGeom _geom)
+  {
+    LOG_API_CALL();
+    assert(_geom);
+    Geom *geom = ((APIHandle *)_geom)->borrow<Geom>();
+    assert(geom);
+    return geom->ID;
+  }
+  
+  OWL_API int32_t owlRayGenGetID(OWLRayGen _rayGen)
+  {
+    LOG_API_CALL();
+    assert(_rayGen);
+    RayGen *rayGen = ((APIHandle *)_rayGen)->borrow<RayGen>();
+    assert(rayGen);
+    return rayGen->ID;
+  }
+  
+  OWL_API int32_t owlMissProgGetID(OWLMissProg _missProg)
+  {
+    LOG_API_CALL();
+    assert(_missProg);
+    MissProg *missProg = ((APIHandle *)_missProg)->borrow<MissProg>();
+    assert(missProg);
+    return missProg->ID;
+  }
   
   
   OWL_API void owlBuildSBT(OWLContext _context)
@@ -134,29 +499,41 @@ namespace owl {
                                  int dims_x, int dims_y,
                                  OWLLaunchParams _launchParams)
   {
-    LOG_API_CALL();
+    LOG_API_CALL_ARGS("dims_x",dims_x,"dims_y",dims_y);
 
     assert(_rayGen);
-    RayGen::SP rayGen
-      = ((APIHandle *)_rayGen)->get<RayGen>();
+    RayGen *rayGen
+      = ((APIHandle *)_rayGen)->borrow<RayGen>();
     assert(rayGen);
 
     assert(_launchParams);
-    LaunchParams::SP launchParams
-      = ((APIHandle *)_launchParams)->get<LaunchParams>();
+    LaunchParams *launchParams
+      = ((APIHandle *)_launchParams)->borrow<LaunchParams>();
     assert(launchParams);
 
     rayGen->launch(vec2i(dims_x,dims_y),launchParams);
   }
 
+  OWL_API void owlRayGenBuildSBT(OWLRayGen _rayGen)
+  {
+    LOG_API_CALL();
+
+    assert(_rayGen);
+    RayGen *rayGen
+      = ((APIHandle *)_rayGen)->borrow<RayGen>();
+    assert(rayGen);
+
+    rayGen->writeSBTRecord();
+  }
+
   OWL_API void owlRayGenLaunch2D(OWLRayGen _rayGen,
                                  int dims_x, int dims_y)
   {
-    LOG_API_CALL();
+    LOG_API_CALL_ARGS("dims_x",dims_x,"dims_y",dims_y);
 
     assert(_rayGen);
-    RayGen::SP rayGen
-      = ((APIHandle *)_rayGen)->get<RayGen>();
+    RayGen *rayGen
+      = ((APIHandle *)_rayGen)->borrow<RayGen>();
     assert(rayGen);
 
     rayGen->launch(vec2i(dims_x,dims_y));
@@ -354,7 +731,7 @@ namespace owl {
                               size_t numGeometries,
                               OWLGeom *initValues)
   {
-    LOG_API_CALL();
+    LOG_API_CALL_ARGS("numGeometries",numGeometries);
     assert(_context);
     APIContext::SP context = ((APIHandle *)_context)->get<APIContext>();
     assert(context);
@@ -379,7 +756,7 @@ namespace owl {
                          size_t numGeometries,
                          OWLGeom *initValues)
   {
-    LOG_API_CALL();
+    LOG_API_CALL_ARGS("numGeometries",numGeometries);
     assert(_context);
     APIContext::SP context = ((APIHandle *)_context)->get<APIContext>();
     assert(context);
@@ -404,7 +781,7 @@ namespace owl {
                          size_t     numInstances,
                          OWLGroup  *initValues)
   {
-    LOG_API_CALL();
+    LOG_API_CALL_ARGS("numInstances",numInstances);
     assert(_context);
     APIContext::SP context = ((APIHandle *)_context)->get<APIContext>();
     assert(context);
@@ -444,7 +821,7 @@ namespace owl {
                         size_t count,
                         const void *init)
   {
-    LOG_API_CALL();
+    LOG_API_CALL_ARGS("type",type,"count",count);
     assert(_context);
     APIContext::SP context = ((APIHandle *)_context)->get<APIContext>();
     assert(context);
@@ -461,7 +838,7 @@ namespace owl {
                             OWLDataType type,
                             size_t      count)
   {
-    LOG_API_CALL();
+    LOG_API_CALL_ARGS("type",type,"count",count);
     assert(_context);
     APIContext::SP context = ((APIHandle *)_context)->get<APIContext>();
     assert(context);
@@ -479,7 +856,7 @@ namespace owl {
                                size_t      count,
                                const void *init)
   {
-    LOG_API_CALL();
+    LOG_API_CALL_ARGS("type",type,"count",count);
     assert(_context);
     APIContext::SP context = ((APIHandle *)_context)->get<APIContext>();
     assert(context);
@@ -521,7 +898,7 @@ namespace owl {
   OWL_API void 
   owlBufferResize(OWLBuffer _buffer, size_t newItemCount)
   {
-    LOG_API_CALL();
+    LOG_API_CALL_ARGS("newItemCount",newItemCount);
     assert(_buffer);
     Buffer::SP buffer = ((APIHandle *)_buffer)->get<Buffer>();
     assert(buffer);
@@ -660,6 +1037,12 @@ namespace owl {
     releaseObject<Group>((APIHandle*)group);
   }
   
+  OWL_API void owlLODSetRelease(OWLLODSet lodSet)
+  {
+    LOG_API_CALL();
+    releaseObject<LODSet>((APIHandle*)lodSet);
+  }
+  
   OWL_API void owlRayGenRelease(OWLRayGen handle)
   {
     LOG_API_CALL();
@@ -710,8 +1093,8 @@ namespace owl {
     
     assert(_group);
 
-    Group::SP group
-      = ((APIHandle *)_group)->get<Group>();
+    Group *group
+      = ((APIHandle *)_group)->borrow<Group>();
     assert(group);
     
     group->buildAccel();
@@ -845,8 +1228,8 @@ namespace owl {
   {
     assert(handle);
 
-    Variable::SP variable
-      = handle->get<Variable>();
+    Variable *variable
+      = handle->borrow<Variable>();
     assert(variable);
 
     variable->set(value);
@@ -981,8 +1364,8 @@ namespace owl {
     APIHandle *handle = (APIHandle*)_variable;
     assert(handle);
 
-    Variable::SP variable
-      = handle->get<Variable>();
+    Variable *variable
+      = handle->borrow<Variable>();
     assert(variable);
 
     variable->setRaw(valuePtr);
@@ -996,14 +1379,14 @@ namespace owl {
                            int whichChild,
                            OWLGroup _child)
   {
-    LOG_API_CALL();
+    LOG_API_CALL_ARGS("whichChild",whichChild);
 
     assert(_group);
-    InstanceGroup::SP group = ((APIHandle*)_group)->get<InstanceGroup>();
+    InstanceGroup *group = ((APIHandle*)_group)->borrow<InstanceGroup>();
     assert(group);
 
     assert(_child);
-    Group::SP child = ((APIHandle *)_child)->get<Group>();
+    Group *child = ((APIHandle *)_child)->borrow<Group>();
     assert(child);
 
     group->setChild(whichChild, child);
@@ -1015,7 +1398,7 @@ namespace owl {
                                const float *floats,
                                OWLMatrixFormat matrixFormat)
   {
-    LOG_API_CALL();
+    LOG_API_CALL_ARGS("whichChild",whichChild);
 
     assert("check for valid transform" && floats != nullptr);
     affine3f xfm;
@@ -1034,11 +1417,234 @@ namespace owl {
     }
     
     assert(_group);
-    InstanceGroup::SP group = ((APIHandle*)_group)->get<InstanceGroup>();
+    InstanceGroup *group = ((APIHandle*)_group)->borrow<InstanceGroup>();
     assert(group);
 
     group->setTransform(whichChild, xfm);
   }
 
+  OWL_API void
+  owlInstanceGroupSetFlattening(OWLGroup _group,
+                                int32_t enabled,
+                                size_t maxFlattenedInstances)
+  {
+    LOG_API_CALL();
+    
+    assert(_group);
+    InstanceGroup::SP group = ((APIHandle*)_group)->get<InstanceGroup>();
+    assert(group);
+
+    group->setFlattening(enabled != 0, maxFlattenedInstances);
+  }
+
+  OWL_API void
+  owlInstanceGroupSetVisibilityMask(OWLGroup _group,
+                                    int whichChild,
+                                    uint8_t mask)
+  {
+    LOG_API_CALL();
+    
+    assert(_group);
+    InstanceGroup::SP group = ((APIHandle*)_group)->get<InstanceGroup>();
+    assert(group);
+
+    group->setVisibilityMasks(whichChild,1,&mask);
+  }
+
+  OWL_API void
+  owlInstanceGroupSetVisibilityMaskRange(OWLGroup _group,
+                                         int firstChild,
+                                         size_t count,
+                                         const uint8_t *masks)
+  {
+    LOG_API_CALL();
+    
+    assert(_group);
+    InstanceGroup::SP group = ((APIHandle*)_group)->get<InstanceGroup>();
+    assert(group);
+
+    group->setVisibilityMasks(firstChild,count,masks);
+  }
+
+  OWL_API void
+  owlInstanceGroupSetInstanceFlags(OWLGroup _group,
+                                   int whichChild,
+                                   uint32_t flags)
+  {
+    LOG_API_CALL();
+    
+    assert(_group);
+    InstanceGroup::SP group = ((APIHandle*)_group)->get<InstanceGroup>();
+    assert(group);
+
+    group->setInstanceFlags(whichChild,1,&flags);
+  }
+
+  OWL_API void
+  owlInstanceGroupSetInstanceFlagsRange(OWLGroup _group,
+                                        int firstChild,
+                                        size_t count,
+                                        const uint32_t *flags)
+  {
+    LOG_API_CALL();
+    
+    assert(_group);
+    InstanceGroup::SP group = ((APIHandle*)_group)->get<InstanceGroup>();
+    assert(group);
+
+    group->setInstanceFlags(firstChild,count,flags);
+  }
+
+  OWL_API void
+  owlInstanceGroupSetInstanceID(OWLGroup _group,
+                                int whichChild,
+                                uint32_t instanceID)
+  {
+    LOG_API_CALL();
+    
+    assert(_group);
+    InstanceGroup::SP group = ((APIHandle*)_group)->get<InstanceGroup>();
+    assert(group);
+
+    group->setInstanceIDs(whichChild,1,&instanceID);
+  }
+
+  OWL_API void
+  owlInstanceGroupSetInstanceIDRange(OWLGroup _group,
+                                     int firstChild,
+                                     size_t count,
+                                     const uint32_t *instanceIDs)
+  {
+    LOG_API_CALL();
+    
+    assert(_group);
+    InstanceGroup::SP group = ((APIHandle*)_group)->get<InstanceGroup>();
+    assert(group);
+
+    group->setInstanceIDs(firstChild,count,instanceIDs);
+  }
+
+  OWL_API OWLLODSet
+  owlLODSetCreate(OWLContext _context,
+                  size_t numLevels,
+                  const OWLGroup *_levels,
+                  const float *geometricErrors)
+  {
+    LOG_API_CALL();
+    assert(_context);
+    APIContext::SP context = ((APIHandle *)_context)->get<APIContext>();
+    assert(context);
+    assert(_levels);
+    assert(geometricErrors);
+
+    std::vector<Group::SP> levels(numLevels);
+    for (size_t i=0;i<numLevels;i++) {
+      assert(_levels[i]);
+      levels[i] = ((APIHandle *)_levels[i])->get<Group>();
+    }
+    LODSet::SP lodSet
+      = makeRef<LODSet>(context.get(),levels,
+                        std::vector<float>(geometricErrors,
+                                           geometricErrors+numLevels));
+    return (OWLLODSet)context->createHandle(lodSet);
+  }
+
+  OWL_API void
+  owlInstanceGroupSetChildLOD(OWLGroup _group,
+                              int whichChild,
+                              OWLLODSet _lodSet)
+  {
+    LOG_API_CALL();
+
+    assert(_group);
+    InstanceGroup::SP group = ((APIHandle*)_group)->get<InstanceGroup>();
+    assert(group);
+
+    assert(_lodSet);
+    LODSet::SP lodSet = ((APIHandle *)_lodSet)->get<LODSet>();
+    assert(lodSet);
+
+    group->setChildLOD(whichChild,lodSet);
+  }
+
+  OWL_API size_t
+  owlInstanceGroupSelectLOD(OWLGroup _group,
+                            const float *cameraPos,
+                            float threshold)
+  {
+    LOG_API_CALL();
+
+    assert(_group);
+    InstanceGroup::SP group = ((APIHandle*)_group)->get<InstanceGroup>();
+    assert(group);
+    assert(cameraPos);
+
+    return group->selectLOD(vec3f(cameraPos[0],cameraPos[1],cameraPos[2]),
+                            threshold);
+  }
+
+  OWL_API void
+  owlInstanceGroupSetSpatialSort(OWLGroup _group,
+                                 int32_t enabled)
+  {
+    LOG_API_CALL();
+    
+    assert(_group);
+    InstanceGroup::SP group = ((APIHandle*)_group)->get<InstanceGroup>();
+    assert(group);
+
+    group->setSpatialSort(enabled != 0);
+  }
+
+  OWL_API void
+  owlInstanceGroupSetTransformBaking(OWLGroup _group,
+                                     size_t maxTrianglesPerGroup,
+                                     size_t maxInstancesPerGroup,
+                                     size_t memoryBudget)
+  {
+    LOG_API_CALL();
+    
+    assert(_group);
+    InstanceGroup::SP group = ((APIHandle*)_group)->get<InstanceGroup>();
+    assert(group);
+
+    group->setTransformBaking(maxTrianglesPerGroup,
+                              maxInstancesPerGroup,
+                              memoryBudget);
+  }
+
+  OWL_API OWLTransformBakingStats
+  owlInstanceGroupGetTransformBakingStats(OWLGroup _group)
+  {
+    LOG_API_CALL();
+    
+    assert(_group);
+    InstanceGroup::SP group = ((APIHandle*)_group)->get<InstanceGroup>();
+    assert(group);
+
+    const LLOTransformBakingStats s = group->getTransformBakingStats();
+    OWLTransformBakingStats stats;
+    stats.instancesBefore = s.instancesBefore;
+    stats.instancesAfter  = s.instancesAfter;
+    stats.instancesBaked  = s.instancesBaked;
+    stats.trianglesBaked  = s.trianglesBaked;
+    stats.bytesUsed       = s.bytesUsed;
+    return stats;
+  }
+
+  OWL_API void
+  owlTrianglesGeomGroupSetMeshMerging(OWLGroup _group,
+                                      size_t maxTrianglesPerMesh)
+  {
+    LOG_API_CALL();
+    
+    assert(_group);
+    TrianglesGeomGroup::SP group
+      = ((APIHandle*)_group)->get<TrianglesGeomGroup>();
+    assert(group);
+
+    group->setMeshMerging(maxTrianglesPerMesh);
+  }
+
 
 } // ::owl
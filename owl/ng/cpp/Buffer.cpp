@@ -16,13 +16,16 @@
 
 #include "Buffer.h"
 #include "Context.h"
+#include "owl/ll/SceneInspection.h"
 
 namespace owl {
 
   Buffer::Buffer(Context *const context,
-                 OWLDataType type)
+                 OWLDataType type,
+                 size_t count)
     : RegisteredObject(context,context->buffers),
-      type(type)
+      type(type),
+      count(count)
   {}
 
   Buffer::~Buffer()
@@ -38,17 +41,20 @@ namespace owl {
   void Buffer::resize(size_t newSize)
   {
     lloBufferResize(context->llo,this->ID,newSize*sizeOf(type));
+    count       = newSize;
+    fingerprint = 0;
   }
   
   void Buffer::upload(const void *hostPtr)
   {
     lloBufferUpload(context->llo,this->ID,hostPtr);
+    fingerprint = ll::sampledContentHash(hostPtr,count*sizeOf(type));
   }
 
   HostPinnedBuffer::HostPinnedBuffer(Context *const context,
                                      OWLDataType type,
                                      size_t count)
-    : Buffer(context,type)
+    : Buffer(context,type,count)
   {
     lloHostPinnedBufferCreate(context->llo,
                               this->ID,
@@ -63,24 +69,28 @@ namespace owl {
                                              be null, but has to be of
                                              size 'amount' if not */
                                            const void *initData)
-    : Buffer(context,type)
+    : Buffer(context,type,count)
   {
     lloManagedMemoryBufferCreate(context->llo,
                                  this->ID,
                                  count*sizeOf(type),
                                  initData);
+    if (initData)
+      fingerprint = ll::sampledContentHash(initData,count*sizeOf(type));
   }
   
   DeviceBuffer::DeviceBuffer(Context *const context,
                              OWLDataType type,
                              size_t count,
                              const void *init)
-    : Buffer(context,type)
+    : Buffer(context,type,count)
   {
     lloDeviceBufferCreate(context->llo,
                           this->ID,
                           count*sizeOf(type),
                           init);
+    if (init)
+      fingerprint = ll::sampledContentHash(init,count*sizeOf(type));
   }
 
 
@@ -22,9 +22,9 @@ namespace owl {
 
   struct Buffer : public RegisteredObject
   {
-    typedef std::shared_ptr<Buffer> SP;
+    typedef Ref<Buffer> SP;
     
-    Buffer(Context *const context, OWLDataType type);
+    Buffer(Context *const context, OWLDataType type, size_t count);
     
     /*! destructor - free device data, de-regsiter, and destruct */
     virtual ~Buffer();
@@ -42,10 +42,16 @@ namespace owl {
     void destroy();
 
     OWLDataType type;
+    /*! number of elements of 'type' */
+    size_t      count;
+    /*! cheap fingerprint of the contents (see
+        ll::sampledContentHash), for the scene inspector's duplicate
+        detection; 0 if the contents never went through the host */
+    uint64_t    fingerprint = 0;
   };
 
   struct DeviceBuffer : public Buffer {
-    typedef std::shared_ptr<DeviceBuffer> SP;
+    typedef Ref<DeviceBuffer> SP;
     
     DeviceBuffer(Context *const context,
                  OWLDataType type,
@@ -57,7 +63,7 @@ namespace owl {
   };
   
   struct HostPinnedBuffer : public Buffer {
-    typedef std::shared_ptr<HostPinnedBuffer> SP;
+    typedef Ref<HostPinnedBuffer> SP;
     
     HostPinnedBuffer(Context *const context,
                      OWLDataType type,
@@ -68,7 +74,7 @@ namespace owl {
   };
   
   struct ManagedMemoryBuffer : public Buffer {
-    typedef std::shared_ptr<ManagedMemoryBuffer> SP;
+    typedef Ref<ManagedMemoryBuffer> SP;
     
     ManagedMemoryBuffer(Context *const context,
                         OWLDataType type,
@@ -17,23 +17,23 @@
 #include "Context.h"
 #include "Module.h"
 #include "Geometry.h"
+#include "UpdateJournal.h"
 #include "owl/ll/Device.h"
-
-#define LOG(message)                            \
-  if (ll::Context::logging())                   \
-    std::cout                                   \
-      << OWL_TERMINAL_LIGHT_BLUE                \
-      << "#owl.ng: "                            \
-      << message                                \
-      << OWL_TERMINAL_DEFAULT << std::endl
-
-#define LOG_OK(message)                         \
-  if (ll::Context::logging())                   \
-    std::cout                                   \
-      << OWL_TERMINAL_BLUE                      \
-      << "#owl.ng: "                            \
-      << message                                \
-      << OWL_TERMINAL_DEFAULT << std::endl
+// std
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <set>
+
+#define LOG(message)                                    \
+  OWL_LOG_COLOR(LEVEL_INFO,OWL_TERMINAL_LIGHT_BLUE,     \
+                "#owl.ng: " << message)
+
+#define LOG_OK(message)                                 \
+  OWL_LOG_COLOR(LEVEL_INFO,OWL_TERMINAL_BLUE,           \
+                "#owl.ng: " << message)
 
 namespace owl {
 
@@ -45,8 +45,8 @@ namespace owl {
                               int      numRequestedDevices)
   {
     LOG("creating node-graph context");
-    return std::make_shared<Context>(requestedDeviceIDs,
-                                     numRequestedDevices);
+    return makeRef<Context>(requestedDeviceIDs,
+                            numRequestedDevices);
   }
   
   Context::Context(int32_t *requestedDeviceIDs,
@@ -76,7 +76,7 @@ namespace owl {
   Buffer::SP Context::hostPinnedBufferCreate(OWLDataType type,
                                              size_t count)
   {
-    Buffer::SP buffer = std::make_shared<HostPinnedBuffer>(this,type,count);
+    Buffer::SP buffer = makeRef<HostPinnedBuffer>(this,type,count);
     assert(buffer);
     return buffer;
   }
@@ -90,7 +90,7 @@ namespace owl {
                                      const void *init)
   {
     Buffer::SP buffer
-      = std::make_shared<ManagedMemoryBuffer>(this,type,count,init);
+      = makeRef<ManagedMemoryBuffer>(this,type,count,init);
     assert(buffer);
     return buffer;
   }
@@ -100,32 +100,32 @@ namespace owl {
                                          const void *init)
   {
     Buffer::SP buffer
-      = std::make_shared<DeviceBuffer>(this,type,count,init);
+      = makeRef<DeviceBuffer>(this,type,count,init);
     assert(buffer);
     return buffer;
   }
 
   RayGen::SP
-  Context::createRayGen(const std::shared_ptr<RayGenType> &type)
+  Context::createRayGen(const Ref<RayGenType> &type)
   {
-    return std::make_shared<RayGen>(this,type);
+    return makeRef<RayGen>(this,type);
   }
 
   LaunchParams::SP
-  Context::createLaunchParams(const std::shared_ptr<LaunchParamsType> &type)
+  Context::createLaunchParams(const Ref<LaunchParamsType> &type)
   {
-    return std::make_shared<LaunchParams>(this,type);
+    return makeRef<LaunchParams>(this,type);
   }
 
   MissProg::SP
-  Context::createMissProg(const std::shared_ptr<MissProgType> &type)
+  Context::createMissProg(const Ref<MissProgType> &type)
   {
-    return std::make_shared<MissProg>(this,type);
+    return makeRef<MissProg>(this,type);
   }
 
   InstanceGroup::SP Context::createInstanceGroup(size_t numChildren)
   {
-    return std::make_shared<InstanceGroup>(this,numChildren);
+    return makeRef<InstanceGroup>(this,numChildren);
   }
 
   RayGenType::SP
@@ -134,10 +134,10 @@ namespace owl {
                             size_t varStructSize,
                             const std::vector<OWLVarDecl> &varDecls)
   {
-    return std::make_shared<RayGenType>(this,
-                                        module,progName,
-                                        varStructSize,
-                                        varDecls);
+    return makeRef<RayGenType>(this,
+                               module,progName,
+                               varStructSize,
+                               varDecls);
   }
   
 
@@ -145,9 +145,9 @@ namespace owl {
   Context::createLaunchParamsType(size_t varStructSize,
                                   const std::vector<OWLVarDecl> &varDecls)
   {
-    return std::make_shared<LaunchParamsType>(this,
-                                              varStructSize,
-                                              varDecls);
+    return makeRef<LaunchParamsType>(this,
+                                     varStructSize,
+                                     varDecls);
   }
   
 
@@ -157,21 +157,21 @@ namespace owl {
                             size_t varStructSize,
                             const std::vector<OWLVarDecl> &varDecls)
   {
-    return std::make_shared<MissProgType>(this,
-                                        module,progName,
-                                        varStructSize,
-                                        varDecls);
+    return makeRef<MissProgType>(this,
+                               module,progName,
+                               varStructSize,
+                               varDecls);
   }
   
 
   GeomGroup::SP Context::trianglesGeomGroupCreate(size_t numChildren)
   {
-    return std::make_shared<TrianglesGeomGroup>(this,numChildren);
+    return makeRef<TrianglesGeomGroup>(this,numChildren);
   }
 
   GeomGroup::SP Context::userGeomGroupCreate(size_t numChildren)
   {
-    return std::make_shared<UserGeomGroup>(this,numChildren);
+    return makeRef<UserGeomGroup>(this,numChildren);
   }
 
 
@@ -182,9 +182,9 @@ namespace owl {
   {
     switch(kind) {
     case OWL_GEOMETRY_TRIANGLES:
-      return std::make_shared<TrianglesGeomType>(this,varStructSize,varDecls);
+      return makeRef<TrianglesGeomType>(this,varStructSize,varDecls);
     case OWL_GEOMETRY_USER:
-      return std::make_shared<UserGeomType>(this,varStructSize,varDecls);
+      return makeRef<UserGeomType>(this,varStructSize,varDecls);
     default:
       OWL_NOTIMPLEMENTED;
     }
@@ -192,28 +192,33 @@ namespace owl {
 
   Module::SP Context::createModule(const std::string &ptxCode)
   {
-    return std::make_shared<Module>(this,ptxCode);//,modules.allocID());
+    return makeRef<Module>(this,ptxCode);//,modules.allocID());
   }
 
-  std::shared_ptr<Geom> UserGeomType::createGeom()
+  Ref<Geom> UserGeomType::createGeom()
   {
-    GeomType::SP self
-      = std::dynamic_pointer_cast<GeomType>(shared_from_this());
-    assert(self);
-    return std::make_shared<UserGeom>(context,self);
+    GeomType::SP self = this;
+    return makeRef<UserGeom>(context,self);
   }
 
-  std::shared_ptr<Geom> TrianglesGeomType::createGeom()
+  Ref<Geom> TrianglesGeomType::createGeom()
   {
-    GeomType::SP self
-      = std::dynamic_pointer_cast<GeomType>(shared_from_this());
-    assert(self);
-    return std::make_shared<TrianglesGeom>(context,self);
+    GeomType::SP self = this;
+    return makeRef<TrianglesGeom>(context,self);
   }
 
 
   void Context::buildSBT()
   {
+    // OWL_INSPECT=<file> writes a scene report at the first SBT build
+    // (this is what scripts/owl-inspect uses); by then the app has
+    // usually created and built all of its scene
+    if (!inspectionDumped) {
+      inspectionDumped = true;
+      if (const char *fileName = getenv("OWL_INSPECT"))
+        dumpStats(fileName);
+    }
+
     // ----------- build hitgroups -----------
     lloSbtHitProgsBuild
       (llo,
@@ -246,18 +251,159 @@ namespace owl {
        [&](uint8_t *output,
            int devID,
            int rgID) {
-
-         // TODO: need the ID of the miss prog we're writing!
-         int rayGenID = 0;
-         assert(rayGens.size() == 1);
-         
-         const RayGen *rayGen = rayGens.getPtr(rayGenID);
-         assert(rayGen);
-         rayGen->writeVariables(output,devID);
+         // one record per ray gen ID; IDs that are not in use
+         // (yet, or any more) simply keep an empty record
+         const RayGen *rayGen = rayGens.tryGetPtr(rgID);
+         if (rayGen)
+           rayGen->writeVariables(output,devID);
        });
   
   }
 
+  /*! looks up the SBT object a VARIABLE update refers to, or null
+      if there is none */
+  static SBTObjectBase *updateTarget(Context *context,
+                                     uint32_t target, int32_t object)
+  {
+    switch (target) {
+    case journal::TARGET_GEOM:
+      return context->geoms.tryGetPtr(object);
+    case journal::TARGET_RAYGEN:
+      return context->rayGens.tryGetPtr(object);
+    case journal::TARGET_MISSPROG:
+      return context->missProgs.tryGetPtr(object);
+    default:
+      return nullptr;
+    }
+  }
+
+  size_t Context::applyUpdates(const void *data, size_t numBytes)
+  {
+    const journal::Batch batch = journal::decode(data,numBytes);
+
+    // ------------------------------------------------------------------
+    // validate everything up front, so a bad batch doesn't get
+    // applied only halfway
+    // ------------------------------------------------------------------
+    auto instanceGroup = [&](int32_t groupID, uint32_t child) {
+      InstanceGroup *ig
+        = dynamic_cast<InstanceGroup *>(groups.tryGetPtr(groupID));
+      if (!ig)
+        throw std::runtime_error("scene update refers to group #"
+                                 +std::to_string(groupID)
+                                 +", which is not an instance group");
+      if (child >= ig->children.size())
+        throw std::runtime_error("scene update refers to child #"
+                                 +std::to_string(child)+" of a group "
+                                 "that has only "
+                                 +std::to_string(ig->children.size())
+                                 +" children");
+      return ig;
+    };
+    for (auto &update : batch.transforms)
+      instanceGroup(update.group,update.child);
+    for (auto &update : batch.masks)
+      instanceGroup(update.group,update.child);
+    for (auto &update : batch.children) {
+      instanceGroup(update.group,update.child);
+      if (!groups.tryGetPtr(update.newChild))
+        throw std::runtime_error("scene update tries to set child to group #"
+                                 +std::to_string(update.newChild)
+                                 +", which does not exist");
+    }
+    for (auto &update : batch.variables) {
+      SBTObjectBase *object = updateTarget(this,update.target,update.object);
+      if (!object)
+        throw std::runtime_error("scene update refers to a non-existing "
+                                 "object #"+std::to_string(update.object));
+      if (update.varIndex >= object->variables.size())
+        throw std::runtime_error("scene update refers to variable #"
+                                 +std::to_string(update.varIndex)
+                                 +" of an object that has only "
+                                 +std::to_string(object->variables.size())
+                                 +" variables");
+      const OWLVarDecl *decl = object->variables[update.varIndex]->varDecl;
+      // only plain data can get streamed; buffers and groups need
+      // their handles
+      if (decl->type >= OWL_BUFFER && decl->type < OWL_USER_TYPE_BEGIN)
+        throw std::runtime_error("variable '"+std::string(decl->name)
+                                 +"' cannot be set through a scene update");
+      if (update.dataSize != sizeOf(decl->type))
+        throw std::runtime_error("scene update for variable '"
+                                 +std::string(decl->name)
+                                 +"' has wrong size");
+    }
+
+    // ------------------------------------------------------------------
+    // apply
+    // ------------------------------------------------------------------
+    std::set<Group *> dirty;
+    for (auto &update : batch.children) {
+      InstanceGroup *ig = instanceGroup(update.group,update.child);
+      ig->setChild(update.child,groups.getSP(update.newChild));
+      dirty.insert(ig);
+    }
+    for (auto &update : batch.masks) {
+      InstanceGroup *ig = instanceGroup(update.group,update.child);
+      ig->setVisibilityMasks(update.child,1,&update.mask);
+      dirty.insert(ig);
+    }
+    for (auto &update : batch.transforms) {
+      InstanceGroup *ig = instanceGroup(update.group,update.child);
+      ig->setTransform(update.child,update.xfm);
+      dirty.insert(ig);
+    }
+    for (auto &update : batch.variables) {
+      SBTObjectBase *object = updateTarget(this,update.target,update.object);
+      object->variables[update.varIndex]
+        ->setRaw(batch.variableData.data()+update.dataBegin);
+    }
+
+    // ------------------------------------------------------------------
+    // commit: all instance groups above a modified group refer to
+    // its old traversable, so they need rebuilding, too - children
+    // before their parents
+    // ------------------------------------------------------------------
+    if (!dirty.empty()) {
+      std::map<Group *,std::vector<Group *>> parentsOf;
+      for (size_t groupID=0;groupID<groups.size();groupID++) {
+        InstanceGroup *ig
+          = dynamic_cast<InstanceGroup *>(groups.tryGetPtr((int)groupID));
+        if (!ig) continue;
+        for (auto &child : ig->children)
+          if (child) parentsOf[child.get()].push_back(ig);
+      }
+      std::vector<Group *> todo(dirty.begin(),dirty.end());
+      while (!todo.empty()) {
+        Group *group = todo.back();
+        todo.pop_back();
+        for (auto parent : parentsOf[group])
+          if (dirty.insert(parent).second)
+            todo.push_back(parent);
+      }
+
+      std::set<Group *> built;
+      std::function<void(Group *)> rebuild = [&](Group *group) {
+        if (!built.insert(group).second) return;
+        if (InstanceGroup *ig = dynamic_cast<InstanceGroup *>(group))
+          for (auto &child : ig->children)
+            if (child && dirty.count(child.get()))
+              rebuild(child.get());
+        group->buildAccel();
+      };
+      for (auto group : dirty)
+        rebuild(group);
+    }
+    if (!dirty.empty() || !batch.variables.empty())
+      buildSBT();
+
+    OWL_LOG(LEVEL_DEBUG,
+            "#owl.ng: applied " << batch.numUpdates() << " scene updates ("
+            << batch.numUpdatesBeforeCoalescing << " before coalescing), "
+            << "rebuilt " << dirty.size() << " groups");
+    return batch.numUpdates();
+  }
+
   void Context::buildPipeline()
   {
     lloCreatePipeline(llo);
@@ -300,5 +446,121 @@ namespace owl {
   {
     lloSetMaxInstancingDepth(llo,maxInstanceDepth);
   }
+
+  void Context::setFramePipelining(bool enabled)
+  {
+    lloSetFramePipelining(llo,enabled);
+  }
+
+  void Context::setGroupSplitting(bool enabled)
+  {
+    lloSetGroupSplitting(llo,enabled);
+  }
+
+  static void forwardBuildStats(const LLOBuildStats *s, void *userData)
+  {
+    Context *context = (Context *)userData;
+    OWLBuildStats stats;
+    stats.groupID              = s->groupID;
+    stats.deviceID             = s->deviceID;
+    stats.kind                 = (OWLBuildKind)s->kind;
+    stats.numPrimitives        = s->numPrimitives;
+    stats.numBuildInputs       = s->numBuildInputs;
+    stats.numAccels            = s->numAccels;
+    stats.boundsSizeInBytes    = s->boundsSizeInBytes;
+    stats.tempSizeInBytes      = s->tempSizeInBytes;
+    stats.outputSizeInBytes    = s->outputSizeInBytes;
+    stats.compactedSizeInBytes = s->compactedSizeInBytes;
+    stats.compactionRatio      = s->compactionRatio;
+    stats.hostBuildSeconds     = s->hostBuildSeconds;
+    stats.deviceBuildSeconds   = s->deviceBuildSeconds;
+    context->buildStatsCallback(&stats,context->buildStatsUserData);
+  }
+  
+  void Context::setBuildStatsCallback(OWLBuildStatsCallback callback,
+                                      void *userData)
+  {
+    buildStatsCallback = callback;
+    buildStatsUserData = userData;
+    lloSetBuildStatsCallback(llo,callback ? forwardBuildStats : nullptr,this);
+  }
+
+  void Context::setBufferDedup(bool enabled)
+  {
+    lloSetBufferDedup(llo,enabled);
+  }
+
+  ll::SceneDescription Context::describeScene()
+  {
+    ll::SceneDescription scene;
+    scene.numRayTypes = numRayTypes;
+
+    scene.buffers.resize(buffers.size());
+    for (size_t bufferID=0;bufferID<buffers.size();bufferID++) {
+      const Buffer *buffer = buffers.tryGetPtr((int)bufferID);
+      if (!buffer) continue;
+      ll::InspectBuffer &ib = scene.buffers[bufferID];
+      ib.valid       = true;
+      ib.sizeInBytes = buffer->count*sizeOf(buffer->type);
+      ib.fingerprint = buffer->fingerprint;
+    }
+
+    scene.geoms.resize(geoms.size());
+    for (size_t geomID=0;geomID<geoms.size();geomID++) {
+      const Geom *geom = geoms.tryGetPtr((int)geomID);
+      if (!geom) continue;
+      ll::InspectGeom &ig = scene.geoms[geomID];
+      ig.sbtDataSize = geom->geometryType->varStructSize;
+      if (const TrianglesGeom *mesh = dynamic_cast<const TrianglesGeom *>(geom)) {
+        ig.kind         = ll::InspectGeom::TRIANGLES;
+        ig.numPrims     = mesh->numTriangles;
+        ig.vertexBuffer = mesh->vertexBufferID;
+        ig.indexBuffer  = mesh->indexBufferID;
+      } else {
+        ig.kind     = ll::InspectGeom::USER;
+        ig.numPrims = ((const UserGeom *)geom)->primCount;
+      }
+    }
+
+    scene.groups.resize(groups.size());
+    for (size_t groupID=0;groupID<groups.size();groupID++) {
+      const Group *group = groups.tryGetPtr((int)groupID);
+      if (!group) continue;
+      ll::InspectGroup &ig = scene.groups[groupID];
+      ig.accelSizeInBytes = lloGroupGetAccelMemory(llo,(int32_t)groupID);
+      if (const InstanceGroup *instances = dynamic_cast<const InstanceGroup *>(group)) {
+        ig.kind = ll::InspectGroup::INSTANCE;
+        ig.children.reserve(instances->children.size());
+        for (auto &child : instances->children)
+          ig.children.push_back(child ? child->ID : -1);
+      } else {
+        const GeomGroup *gg = (const GeomGroup *)group;
+        ig.kind = dynamic_cast<const UserGeomGroup *>(group)
+          ? ll::InspectGroup::USER
+          : ll::InspectGroup::TRIANGLES;
+        if (const TrianglesGeomGroup *triangles
+            = dynamic_cast<const TrianglesGeomGroup *>(group))
+          ig.meshMerging = triangles->maxMergedMeshTriangles > 0;
+        ig.children.reserve(gg->geometries.size());
+        for (auto &child : gg->geometries)
+          ig.children.push_back(child ? child->ID : -1);
+      }
+    }
+    return scene;
+  }
+
+  void Context::dumpStats(const char *fileName)
+  {
+    const ll::SceneReport report = ll::inspectScene(describeScene());
+    if (!fileName || std::string(fileName) == "-") {
+      ll::writeReport(std::cout,report);
+      return;
+    }
+    std::ofstream out(fileName);
+    if (!out)
+      throw std::runtime_error("could not open '"+std::string(fileName)
+                               +"' for the scene report");
+    ll::writeReport(out,report);
+  }
   
 } // ::owl
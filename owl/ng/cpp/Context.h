@@ -24,13 +24,14 @@
 #include "MissProg.h"
 // ll
 #include "../ll/Device.h"
+#include "owl/ll/SceneInspection.h"
 
 namespace owl {
 
   std::string typeToString(const OWLDataType type);
   
   struct Context : public Object {
-    typedef std::shared_ptr<Context> SP;
+    typedef Ref<Context> SP;
 
     static Context::SP create(int32_t *requestedDeviceIDs,
                               int      numRequestedDevices);
@@ -77,6 +78,41 @@ namespace owl {
       instances) */
     void setMaxInstancingDepth(int32_t maxInstanceDepth);
 
+    /*! enables or disables double-buffering of the SBT, so buildSBT()
+        for the next frame can overlap with a launch still in flight */
+    void setFramePipelining(bool enabled);
+
+    /*! enables or disables automatic splitting of groups that exceed
+        optix' per-accel limits */
+    void setGroupSplitting(bool enabled);
+
+    /*! sets the app's callback for the stats of each accel build */
+    void setBuildStatsCallback(OWLBuildStatsCallback callback,
+                               void *userData);
+
+    /*! enables or disables deduplication of device buffers with
+        identical contents */
+    void setBufferDedup(bool enabled);
+
+    /*! applies one batch of scene updates in the binary format of
+        owlContextApplyUpdates() (see owl_host.h), then rebuilds
+        what these updates touched - the accels of all modified
+        groups and of all instance groups above them, then the SBT -
+        exactly once. The whole batch gets validated before anything
+        gets applied, so a malformed batch (or one that refers to
+        objects that do not exist) throws and leaves the scene
+        unchanged. Returns the number of updates applied after
+        coalescing */
+    size_t applyUpdates(const void *data, size_t numBytes);
+
+    /*! collects what the scene inspector needs to know about all
+        buffers, geoms and groups of this context */
+    ll::SceneDescription describeScene();
+
+    /*! inspects the current scene (see ll::inspectScene), and writes
+        the report to the given file; null or "-" means stdout */
+    void dumpStats(const char *fileName);
+    
   /*! experimentation code for sbt construction */
     void buildSBT();
     void buildPipeline();
@@ -112,7 +148,7 @@ namespace owl {
                               const void *init);
     
     RayGen::SP
-    createRayGen(const std::shared_ptr<RayGenType> &type);
+    createRayGen(const Ref<RayGenType> &type);
     
     RayGenType::SP
     createRayGenType(Module::SP module,
@@ -121,14 +157,14 @@ namespace owl {
                      const std::vector<OWLVarDecl> &varDecls);
     
     LaunchParams::SP
-    createLaunchParams(const std::shared_ptr<LaunchParamsType> &type);
+    createLaunchParams(const Ref<LaunchParamsType> &type);
     
     LaunchParamsType::SP
     createLaunchParamsType(size_t varStructSize,
                            const std::vector<OWLVarDecl> &varDecls);
     
     MissProg::SP
-    createMissProg(const std::shared_ptr<MissProgType> &type);
+    createMissProg(const Ref<MissProgType> &type);
     
     MissProgType::SP
     createMissProgType(Module::SP module,
@@ -145,6 +181,15 @@ namespace owl {
 
     LLOContext llo;
     //    ll::DeviceGroup::SP ll;
+
+    /*! the app's build stats callback; ll calls it through a
+        trampoline that converts the stats */
+    OWLBuildStatsCallback buildStatsCallback = nullptr;
+    void                 *buildStatsUserData = nullptr;
+
+    /*! whether buildSBT() already wrote the report requested via
+        the OWL_INSPECT environment variable */
+    bool inspectionDumped = false;
   };
 
 } // ::owl
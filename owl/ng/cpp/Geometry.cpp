@@ -77,6 +77,7 @@ namespace owl {
   void UserGeom::setPrimCount(size_t count)
   {
     lloUserGeomSetPrimCount(context->llo,this->ID,count);
+    primCount = count;
   }
 
 
@@ -89,6 +90,7 @@ namespace owl {
   {
     lloTrianglesGeomSetVertexBuffer(context->llo,this->ID,
                                     vertices->ID,count,stride,offset);
+    vertexBufferID = vertices->ID;
   }
   
   void TrianglesGeom::setIndices(Buffer::SP indices,
@@ -98,6 +100,8 @@ namespace owl {
   {
     lloTrianglesGeomSetIndexBuffer(context->llo,this->ID,
                                     indices->ID,count,stride,offset);
+    indexBufferID = indices->ID;
+    numTriangles  = count;
   }
 
   void GeomType::setClosestHitProgram(int rayType,
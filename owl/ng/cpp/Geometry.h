@@ -31,7 +31,7 @@ namespace owl {
   };
   
   struct GeomType : public SBTObjectType {
-    typedef std::shared_ptr<GeomType> SP;
+    typedef Ref<GeomType> SP;
     
     GeomType(Context *const context,
              size_t varStructSize,
@@ -49,22 +49,22 @@ namespace owl {
                                       const std::string &progName);
 
     std::vector<ProgramDesc> anyHit;
-    virtual std::shared_ptr<Geom> createGeom() = 0;
+    virtual Ref<Geom> createGeom() = 0;
   };
 
   struct TrianglesGeomType : public GeomType {
-    typedef std::shared_ptr<TrianglesGeomType> SP;
+    typedef Ref<TrianglesGeomType> SP;
     
     TrianglesGeomType(Context *const context,
                       size_t varStructSize,
                       const std::vector<OWLVarDecl> &varDecls);
 
     virtual std::string toString() const { return "TriangleGeomType"; }
-    virtual std::shared_ptr<Geom> createGeom() override;
+    virtual Ref<Geom> createGeom() override;
   };
 
   struct UserGeomType : public GeomType {
-    typedef std::shared_ptr<UserGeomType> SP;
+    typedef Ref<UserGeomType> SP;
     
     UserGeomType(Context *const context,
                  size_t varStructSize,
@@ -77,14 +77,14 @@ namespace owl {
                                const std::string &progName);
     
     virtual std::string toString() const { return "UserGeomType"; }
-    virtual std::shared_ptr<Geom> createGeom() override;
+    virtual Ref<Geom> createGeom() override;
 
     ProgramDesc boundsProg;
     std::vector<ProgramDesc> intersectProg;
   };
   
   struct Geom : public SBTObject<GeomType> {
-    typedef std::shared_ptr<Geom> SP;
+    typedef Ref<Geom> SP;
 
     Geom(Context *const context,
              GeomType::SP geometryType);
@@ -94,7 +94,7 @@ namespace owl {
   };
 
   struct TrianglesGeom : public Geom {
-    typedef std::shared_ptr<TrianglesGeom> SP;
+    typedef Ref<TrianglesGeom> SP;
 
     TrianglesGeom(Context *const context,
                   GeomType::SP geometryType);
@@ -108,16 +108,25 @@ namespace owl {
                     size_t stride,
                     size_t offset);
     virtual std::string toString() const { return "TrianglesGeom"; }
+
+    /*! what the scene inspector needs to know about the mesh; we
+        only keep the buffers' IDs here, the refs live on the ll
+        layer */
+    int    vertexBufferID = -1;
+    int    indexBufferID  = -1;
+    size_t numTriangles   = 0;
   };
 
   struct UserGeom : public Geom {
-    typedef std::shared_ptr<UserGeom> SP;
+    typedef Ref<UserGeom> SP;
 
     UserGeom(Context *const context,
              GeomType::SP geometryType);
 
     virtual std::string toString() const { return "UserGeom"; }
     void setPrimCount(size_t count);
+
+    size_t primCount = 0;
   };
   
 } // ::owl
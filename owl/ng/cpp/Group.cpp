@@ -15,6 +15,7 @@
 // ======================================================================== //
 
 #include "Group.h"
+#include "LODSet.h"
 #include "Context.h"
 
 namespace owl {
@@ -69,7 +70,9 @@ namespace owl {
   InstanceGroup::InstanceGroup(Context *const context,
                                size_t numChildren)
     : Group(context,context->groups),
-      children(numChildren)
+      children(numChildren),
+      lodChildren(numChildren),
+      lodLevels(numChildren,0)
   {
     lloInstanceGroupCreate(context->llo,this->ID,
                            nullptr,numChildren);
@@ -83,6 +86,15 @@ namespace owl {
                                 nullptr,numChildren);
   }
   
+  /*! merge runs of geoms with at most this many triangles into
+      shared build inputs; 0 disables merging */
+  void TrianglesGeomGroup::setMeshMerging(size_t maxTrianglesPerMesh)
+  {
+    lloTrianglesGeomGroupSetMeshMerging(context->llo,this->ID,
+                                        maxTrianglesPerMesh);
+    maxMergedMeshTriangles = maxTrianglesPerMesh;
+  }
+
   UserGeomGroup::UserGeomGroup(Context *const context,
                                  size_t numChildren)
     : GeomGroup(context,numChildren)
@@ -101,16 +113,129 @@ namespace owl {
     lloInstanceGroupSetTransform(context->llo,this->ID,
                                  childID,
                                  (const float *)&xfm);
+
+    ll::LODChild &lodChild = lodChildren[childID];
+    lodChild.position = xfm.p;
+    lodChild.scale    = std::max(length(xfm.l.vx),
+                                 std::max(length(xfm.l.vy),
+                                          length(xfm.l.vz)));
+  }
+
+  // the OWLInstanceFlags get passed through to optix as they are
+  static_assert((int)OWL_INSTANCE_FLAG_DISABLE_TRIANGLE_FACE_CULLING
+                == (int)OPTIX_INSTANCE_FLAG_DISABLE_TRIANGLE_FACE_CULLING
+                && (int)OWL_INSTANCE_FLAG_FLIP_TRIANGLE_FACING
+                == (int)OPTIX_INSTANCE_FLAG_FLIP_TRIANGLE_FACING
+                && (int)OWL_INSTANCE_FLAG_DISABLE_ANYHIT
+                == (int)OPTIX_INSTANCE_FLAG_DISABLE_ANYHIT
+                && (int)OWL_INSTANCE_FLAG_ENFORCE_ANYHIT
+                == (int)OPTIX_INSTANCE_FLAG_ENFORCE_ANYHIT,
+                "OWLInstanceFlags out of sync with OptixInstanceFlags");
+
+  void InstanceGroup::setVisibilityMasks(int firstChild, size_t count,
+                                         const uint8_t *masks)
+  {
+    lloInstanceGroupSetVisibilityMasks(context->llo,this->ID,
+                                       firstChild,count,masks);
+  }
+
+  void InstanceGroup::setInstanceFlags(int firstChild, size_t count,
+                                       const uint32_t *flags)
+  {
+    lloInstanceGroupSetInstanceFlags(context->llo,this->ID,
+                                     firstChild,count,flags);
+  }
+
+  void InstanceGroup::setInstanceIDs(int firstChild, size_t count,
+                                     const uint32_t *instanceIDs)
+  {
+    lloInstanceGroupSetInstanceIDs(context->llo,this->ID,
+                                   firstChild,count,instanceIDs);
+  }
+
+  /*! enable/disable host-side flattening of nested instance
+      groups below this group */
+  void InstanceGroup::setFlattening(bool enabled,
+                                    size_t maxFlattenedInstances)
+  {
+    lloInstanceGroupSetFlattening(context->llo,this->ID,
+                                  enabled,maxFlattenedInstances);
+  }
+
+  /*! enable/disable morton-order sorting of this group's
+      instances */
+  void InstanceGroup::setSpatialSort(bool enabled)
+  {
+    lloInstanceGroupSetSpatialSort(context->llo,this->ID,enabled);
+  }
+
+  void InstanceGroup::setTransformBaking(size_t maxTrianglesPerGroup,
+                                         size_t maxInstancesPerGroup,
+                                         size_t memoryBudget)
+  {
+    lloInstanceGroupSetTransformBaking(context->llo,this->ID,
+                                       maxTrianglesPerGroup,
+                                       maxInstancesPerGroup,
+                                       memoryBudget);
+  }
+
+  LLOTransformBakingStats InstanceGroup::getTransformBakingStats()
+  {
+    LLOTransformBakingStats stats;
+    lloInstanceGroupGetTransformBakingStats(context->llo,this->ID,&stats);
+    return stats;
   }
 
   void InstanceGroup::setChild(int childID, Group::SP child)
   {
     assert(childID >= 0);
     assert(childID < children.size());
+    lodChildren[childID].lodSet = -1;
+    assignChild(childID,child);
+  }
+
+  void InstanceGroup::assignChild(int childID, Group::SP child)
+  {
     children[childID] = child;
     lloInstanceGroupSetChild(context->llo,this->ID,
                              childID,
                              child->ID);
   }
+
+  /*! let the given child use the given LOD set; the child starts
+      out with the set's finest level, until the next selectLOD() */
+  void InstanceGroup::setChildLOD(int childID, LODSet::SP lodSet)
+  {
+    assert(childID >= 0);
+    assert(childID < children.size());
+    assert(lodSet);
+    auto it = lodSetIndex.find(lodSet.get());
+    if (it == lodSetIndex.end()) {
+      it = lodSetIndex.insert({lodSet.get(),(int)lodSets.size()}).first;
+      lodSets.push_back(lodSet);
+    }
+    lodChildren[childID].lodSet = it->second;
+    lodLevels[childID]          = 0;
+    assignChild(childID,lodSet->levels[0]);
+  }
+
+  /*! picks the level of each child that uses an LOD set, and
+      updates those children whose level changed */
+  size_t InstanceGroup::selectLOD(const vec3f &cameraPos, float threshold)
+  {
+    if (lodSets.empty())
+      return 0;
+    std::vector<std::vector<float>> lodSetErrors;
+    for (auto &lodSet : lodSets)
+      lodSetErrors.push_back(lodSet->errors);
+    const std::vector<int> changed
+      = ll::selectLODs(lodChildren,lodSetErrors,cameraPos,threshold,
+                       lodLevels);
+    for (auto childID : changed) {
+      const LODSet::SP &lodSet = lodSets[lodChildren[childID].lodSet];
+      assignChild(childID,lodSet->levels[lodLevels[childID]]);
+    }
+    return changed.size();
+  }
   
 } // ::owl
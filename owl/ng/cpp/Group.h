@@ -18,11 +18,16 @@
 
 #include "RegisteredObject.h"
 #include "Geometry.h"
+#include "owl/ll/LODSelection.h"
+// std
+#include <map>
 
 namespace owl {
 
+  struct LODSet;
+  
   struct Group : public RegisteredObject {
-    typedef std::shared_ptr<Group> SP;
+    typedef Ref<Group> SP;
     
     Group(Context *const context,
           ObjectRegistry &registry)
@@ -36,7 +41,7 @@ namespace owl {
 
   
   struct GeomGroup : public Group {
-    typedef std::shared_ptr<GeomGroup> SP;
+    typedef Ref<GeomGroup> SP;
 
     GeomGroup(Context *const context,
               size_t numChildren);
@@ -47,8 +52,18 @@ namespace owl {
   };
 
   struct TrianglesGeomGroup : public GeomGroup {
+    typedef Ref<TrianglesGeomGroup> SP;
+    
     TrianglesGeomGroup(Context *const context,
                    size_t numChildren);
+
+    /*! merge runs of geoms with at most this many triangles into
+        shared build inputs; 0 disables merging */
+    void setMeshMerging(size_t maxTrianglesPerMesh);
+
+    /*! what setMeshMerging() was last called with */
+    size_t maxMergedMeshTriangles = 0;
+    
     virtual std::string toString() const { return "TrianglesGeomGroup"; }
   };
 
@@ -60,14 +75,52 @@ namespace owl {
   };
 
   struct InstanceGroup : public Group {
-    typedef std::shared_ptr<InstanceGroup> SP;
+    typedef Ref<InstanceGroup> SP;
     
     InstanceGroup(Context *const context,
                   size_t numChildren);
+    /*! set given child to a fixed group (and stop using an LOD set
+        for it, if it did) */
     void setChild(int childID, Group::SP child);
 
+    /*! let the given child use the given LOD set; the child starts
+        out with the set's finest level, until the next selectLOD() */
+    void setChildLOD(int childID, Ref<LODSet> lodSet);
+
+    /*! picks the level of each child that uses an LOD set, as seen
+        from the given camera position (see ll::selectLODs), and
+        updates those children whose level changed. Returns the
+        number of changed children, so if this returns 0 the group's
+        accel does not need to be rebuilt */
+    size_t selectLOD(const vec3f &cameraPos, float threshold);
+
     /*! set transformation matrix of given child */
     void setTransform(int childID, const affine3f &xfm);
+
+    /*! set visibility masks / instance flags / instance IDs of
+        children [firstChild,firstChild+count) */
+    void setVisibilityMasks(int firstChild, size_t count,
+                            const uint8_t *masks);
+    void setInstanceFlags(int firstChild, size_t count,
+                          const uint32_t *flags);
+    void setInstanceIDs(int firstChild, size_t count,
+                        const uint32_t *instanceIDs);
+
+    /*! enable/disable host-side flattening of nested instance
+        groups below this group */
+    void setFlattening(bool enabled, size_t maxFlattenedInstances);
+
+    /*! enable/disable morton-order sorting of this group's
+        instances */
+    void setSpatialSort(bool enabled);
+
+    /*! configure transform baking of small instanced meshes below
+        this group; maxTrianglesPerGroup == 0 disables it */
+    void setTransformBaking(size_t maxTrianglesPerGroup,
+                            size_t maxInstancesPerGroup,
+                            size_t memoryBudget);
+    /*! stats of this group's last transform baking pass */
+    LLOTransformBakingStats getTransformBakingStats();
     
     virtual std::string toString() const { return "InstanceGroup"; }
 
@@ -75,6 +128,21 @@ namespace owl {
         the ll layer _and_ here for the refcounting to work; the
         transforms are only stored once, on the ll layer */
     std::vector<Group::SP> children;
+
+    /*! per child, what LOD selection needs to know about it; the
+        positions and scales get tracked by setTransform() even for
+        children that (yet) don't use an LOD set */
+    std::vector<ll::LODChild>            lodChildren;
+    /*! per child, the level of its LOD set it currently uses */
+    std::vector<int>                     lodLevels;
+    /*! the LOD sets referenced by lodChildren[].lodSet */
+    std::vector<Ref<LODSet>> lodSets;
+    std::map<LODSet *,int>               lodSetIndex;
+    
+  private:
+    /*! sets the child on the ll layer, without touching its LOD
+        set */
+    void assignChild(int childID, Group::SP child);
   };
 
 } // ::owl
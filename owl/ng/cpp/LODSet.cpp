@@ -0,0 +1,42 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "LODSet.h"
+#include "Context.h"
+
+namespace owl {
+
+  LODSet::LODSet(Context *const context,
+                 const std::vector<Group::SP> &levels,
+                 const std::vector<float> &errors)
+    : ContextObject(context),
+      levels(levels),
+      errors(errors)
+  {
+    if (levels.empty())
+      throw std::runtime_error("LOD set needs at least one level");
+    if (errors.size() != levels.size())
+      throw std::runtime_error("LOD set needs one geometric error per level");
+    for (auto &level : levels)
+      if (!level)
+        throw std::runtime_error("LOD set level is not a valid group");
+    for (size_t i=1;i<errors.size();i++)
+      OWL_VALIDATE(errors[i-1] <= errors[i],
+                   "LOD set errors must not decrease from finer to "
+                   "coarser levels");
+  }
+
+} // ::owl
@@ -0,0 +1,41 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "Group.h"
+
+namespace owl {
+
+  /*! a set of groups that represent the same object at different
+      levels of detail, finest first, each with its (object-space)
+      geometric error relative to the finest level. Instance group
+      children can reference an LOD set instead of a fixed group,
+      and owlInstanceGroupSelectLOD() then picks the level to use */
+  struct LODSet : public ContextObject {
+    typedef Ref<LODSet> SP;
+    
+    LODSet(Context *const context,
+           const std::vector<Group::SP> &levels,
+           const std::vector<float> &errors);
+    
+    virtual std::string toString() const { return "LODSet"; }
+
+    const std::vector<Group::SP> levels;
+    const std::vector<float>     errors;
+  };
+
+} // ::owl
@@ -22,7 +22,7 @@
 namespace owl {
 
   struct LaunchParamsType : public SBTObjectType {
-    typedef std::shared_ptr<LaunchParamsType> SP;
+    typedef Ref<LaunchParamsType> SP;
     LaunchParamsType(Context *const context,
                size_t varStructSize,
                const std::vector<OWLVarDecl> &varDecls);
@@ -34,7 +34,7 @@ namespace owl {
       params data - this is all this object does: store values and
       write them when requested */
   struct LaunchParams : public SBTObject<LaunchParamsType> {
-    typedef std::shared_ptr<LaunchParams> SP;
+    typedef Ref<LaunchParams> SP;
     
     LaunchParams(Context *const context,
            LaunchParamsType::SP type);
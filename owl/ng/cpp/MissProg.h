@@ -22,7 +22,7 @@
 namespace owl {
 
   struct MissProgType : public SBTObjectType {
-    typedef std::shared_ptr<MissProgType> SP;
+    typedef Ref<MissProgType> SP;
     MissProgType(Context *const context,
                Module::SP module,
                const std::string &progName,
@@ -36,7 +36,7 @@ namespace owl {
   };
   
   struct MissProg : public SBTObject<MissProgType> {
-    typedef std::shared_ptr<MissProg> SP;
+    typedef Ref<MissProg> SP;
     
     MissProg(Context *const context,
            MissProgType::SP type);
@@ -24,7 +24,7 @@ namespace owl {
   /*! captures the concept of a module that contains one or more
     programs. */
   struct Module : public RegisteredObject {
-    typedef std::shared_ptr<Module> SP;
+    typedef Ref<Module> SP;
 
     Module(Context *context, const std::string &ptxCode);
     // Module(const std::string &ptxCode,
@@ -19,6 +19,8 @@
 #include "owl/owl.h"
 #include "owl/ll/common.h"
 #include "owl/ll/DeviceGroup.h"
+#include "owl/ll/Validation.h"
+#include "RefCounted.h"
 
 namespace owl {
 
@@ -28,8 +30,8 @@ namespace owl {
   struct Context;
 
   /*! common "root" abstraction for every object this library creates */
-  struct Object : public std::enable_shared_from_this<Object> {
-    typedef std::shared_ptr<Object> SP;
+  struct Object : public RefCounted {
+    typedef Ref<Object> SP;
 
     Object();
 
@@ -37,8 +39,8 @@ namespace owl {
     virtual std::string toString() const { return "Object"; }
 
     template<typename T>
-    inline std::shared_ptr<T> as() 
-    { return std::dynamic_pointer_cast<T>(shared_from_this()); }
+    inline Ref<T> as() 
+    { return Ref<T>(dynamic_cast<T*>(this)); }
 
     /*! a unique ID we assign to each newly created object - this
         allows any caching algorithms to check if a given object was
@@ -52,7 +54,7 @@ namespace owl {
   
   /*! a object that belongs to a context */
   struct ContextObject : public Object {
-    typedef std::shared_ptr<ContextObject> SP;
+    typedef Ref<ContextObject> SP;
     
     ContextObject(Context *const context)
       : context(context)
@@ -23,6 +23,8 @@
 #include "RayGen.h"
 #include "MissProg.h"
 
+#include "owl/ll/PerfCounters.h"
+
 namespace owl {
 
   void ObjectRegistry::forget(RegisteredObject *object)
@@ -34,6 +36,7 @@ namespace owl {
       // reference count and thus hasn't been deleted yet.
       return;
     
+    OWL_PERF_SCOPE(PHASE_REGISTRY);
     std::lock_guard<std::mutex> lock(mutex);
     assert(object->ID >= 0);
     assert(object->ID < objects.size());
@@ -48,6 +51,7 @@ namespace owl {
   void ObjectRegistry::track(RegisteredObject *object)
   {
     assert(object);
+    OWL_PERF_SCOPE(PHASE_REGISTRY);
     std::lock_guard<std::mutex> lock(mutex);
     assert(object->ID >= 0);
     assert(object->ID < objects.size());
@@ -57,6 +61,7 @@ namespace owl {
     
   int ObjectRegistry::allocID()
   {
+    OWL_PERF_SCOPE(PHASE_REGISTRY);
     std::lock_guard<std::mutex> lock(mutex);
     if (previouslyReleasedIDs.empty()) {
       objects.push_back(nullptr);
@@ -84,6 +89,15 @@ namespace owl {
     return objects[ID];
   }
 
+  RegisteredObject *ObjectRegistry::tryGetPtr(int ID)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+      
+    if (ID < 0 || ID >= (int)objects.size())
+      return nullptr;
+    return objects[ID];
+  }
+
   template<>
   void ObjectRegistryT<Buffer>::reallocContextIDs(int newMaxIDs)
   {
@@ -41,6 +41,9 @@ namespace owl {
     void track(RegisteredObject *object);
     int allocID();
     RegisteredObject *getPtr(int ID);
+    /*! same as getPtr(), but returns null for IDs that are not (or
+        no longer) in use, rather than asserting */
+    RegisteredObject *tryGetPtr(int ID);
   private:
     /*! list of all tracked objects. note this are *NOT* shared-ptr's,
       else we'd never released objects because each object would
@@ -74,15 +77,14 @@ namespace owl {
     
     inline T *getPtr(int ID)
     { return (T*)ObjectRegistry::getPtr(ID); }
+    inline T *tryGetPtr(int ID)
+    { return (T*)ObjectRegistry::tryGetPtr(ID); }
 
     inline typename T::SP getSP(int ID)
     {
       T *ptr = getPtr(ID);
       assert(ptr);
-      Object::SP object = ptr->shared_from_this();
-      assert(object);
-      return object->as<T>();
-      // return ptr->shared_from_this()->as<T>();
+      return typename T::SP(ptr);
     }
     
     Context *const context;
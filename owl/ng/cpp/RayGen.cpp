@@ -45,6 +45,18 @@ namespace owl {
                     type->varStructSize);
   }
 
+  void RayGen::writeSBTRecord()
+  {
+    // if the ray gen records have to be built from scratch this gets
+    // called for *every* ray gen ID, not just ours
+    lloSbtRayGenBuild(context->llo,this->ID,
+                      [&](uint8_t *output, int devID, int rgID) {
+                        const RayGen *rayGen = context->rayGens.tryGetPtr(rgID);
+                        if (rayGen)
+                          rayGen->writeVariables(output,devID);
+                      });
+  }
+
   void RayGen::launch(const vec2i &dims)
   {
     lloLaunch2D(context->llo,this->ID,dims.x,dims.y);
@@ -23,7 +23,7 @@
 namespace owl {
 
   struct RayGenType : public SBTObjectType {
-    typedef std::shared_ptr<RayGenType> SP;
+    typedef Ref<RayGenType> SP;
     RayGenType(Context *const context,
                Module::SP module,
                const std::string &progName,
@@ -37,13 +37,17 @@ namespace owl {
   };
   
   struct RayGen : public SBTObject<RayGenType> {
-    typedef std::shared_ptr<RayGen> SP;
+    typedef Ref<RayGen> SP;
     
     RayGen(Context *const context,
            RayGenType::SP type);
     
     virtual std::string toString() const { return "RayGen"; }
 
+    /*! re-writes (and uploads) only this ray gen's SBT record, with
+        the current values of its variables */
+    void writeSBTRecord();
+
     void launch(const vec2i &dims);
     void launch(const vec2i &dims, const LaunchParams::SP &launchParams);
   };
@@ -0,0 +1,146 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+// std
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+/*! by default, reference counts are plain integers - the node graph
+    is meant to be built and modified from one thread at a time, and
+    an atomic count would make every handle lookup and every copy of
+    a reference pay for a locked instruction. Apps that do share
+    objects between threads can build with OWL_ATOMIC_REFCOUNT=1
+    (cmake option of the same name) */
+#ifndef OWL_ATOMIC_REFCOUNT
+# define OWL_ATOMIC_REFCOUNT 0
+#endif
+
+namespace owl {
+
+  /*! base class for objects with an intrusive reference count (see
+      Ref<T>). Since the count lives in the object itself, a Ref can
+      be created from a plain pointer at any time (no
+      shared_from_this), and code that merely uses an object for the
+      duration of a call can take a plain ('borrowed') pointer
+      without touching the count at all */
+  struct RefCounted {
+    RefCounted() = default;
+    /*! copies are new objects, with no references to them yet */
+    RefCounted(const RefCounted &) {}
+    RefCounted &operator=(const RefCounted &) { return *this; }
+    virtual ~RefCounted() {}
+
+    inline void refInc() const
+    {
+#if OWL_ATOMIC_REFCOUNT
+      refCount.fetch_add(1,std::memory_order_relaxed);
+#else
+      ++refCount;
+#endif
+    }
+    
+    inline void refDec() const
+    {
+#if OWL_ATOMIC_REFCOUNT
+      if (refCount.fetch_sub(1,std::memory_order_acq_rel) == 1)
+        delete this;
+#else
+      if (--refCount == 0)
+        delete this;
+#endif
+    }
+
+    /*! number of Refs currently referring to this object */
+    inline uint32_t useCount() const { return refCount; }
+    
+  private:
+#if OWL_ATOMIC_REFCOUNT
+    mutable std::atomic<uint32_t> refCount { 0 };
+#else
+    mutable uint32_t refCount = 0;
+#endif
+  };
+
+  /*! owning reference to a RefCounted object; has the same
+      interface as the subset of std::shared_ptr that owl uses */
+  template<typename T>
+  struct Ref {
+    Ref() = default;
+    Ref(std::nullptr_t) {}
+    Ref(T *ptr) : ptr(ptr) { if (ptr) ptr->refInc(); }
+    Ref(const Ref &other) : Ref(other.ptr) {}
+    Ref(Ref &&other) : ptr(other.ptr) { other.ptr = nullptr; }
+    template<typename U,
+             typename = typename std::enable_if<std::is_convertible<U*,T*>::value>::type>
+    Ref(const Ref<U> &other) : Ref(other.get()) {}
+    template<typename U,
+             typename = typename std::enable_if<std::is_convertible<U*,T*>::value>::type>
+    Ref(Ref<U> &&other) : ptr(other.release()) {}
+    ~Ref() { if (ptr) ptr->refDec(); }
+
+    Ref &operator=(Ref other) { std::swap(ptr,other.ptr); return *this; }
+    Ref &operator=(std::nullptr_t) { reset(); return *this; }
+
+    inline T *get() const { return ptr; }
+    inline T *operator->() const { return ptr; }
+    inline T &operator*() const { return *ptr; }
+    inline explicit operator bool() const { return ptr != nullptr; }
+
+    inline void reset() { if (ptr) ptr->refDec(); ptr = nullptr; }
+    
+    /*! gives up our reference without releasing it, and returns the
+        object it referred to */
+    inline T *release() { T *result = ptr; ptr = nullptr; return result; }
+    
+  private:
+    T *ptr = nullptr;
+  };
+
+  template<typename T, typename U>
+  inline bool operator==(const Ref<T> &a, const Ref<U> &b)
+  { return a.get() == b.get(); }
+  template<typename T, typename U>
+  inline bool operator!=(const Ref<T> &a, const Ref<U> &b)
+  { return a.get() != b.get(); }
+  template<typename T>
+  inline bool operator==(const Ref<T> &a, std::nullptr_t)
+  { return a.get() == nullptr; }
+  template<typename T>
+  inline bool operator!=(const Ref<T> &a, std::nullptr_t)
+  { return a.get() != nullptr; }
+  template<typename T>
+  inline bool operator==(std::nullptr_t, const Ref<T> &b)
+  { return b.get() == nullptr; }
+  template<typename T>
+  inline bool operator!=(std::nullptr_t, const Ref<T> &b)
+  { return b.get() != nullptr; }
+
+  /*! creates a new object, and returns the (first) reference to it */
+  template<typename T, typename... Args>
+  inline Ref<T> makeRef(Args&&... args)
+  { return Ref<T>(new T(std::forward<Args>(args)...)); }
+
+  /*! equivalent of std::dynamic_pointer_cast */
+  template<typename T, typename U>
+  inline Ref<T> dynamicRefCast(const Ref<U> &ref)
+  { return Ref<T>(dynamic_cast<T*>(ref.get())); }
+  
+} // ::owl
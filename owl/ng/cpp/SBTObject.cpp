@@ -28,21 +28,52 @@ namespace owl {
   {
     for (auto &var : varDecls)
       assert(var.name != nullptr);
-    /* TODO: at least in debug mode, do some 'duplicate variable
-       name' and 'overlap of variables' checks etc */
+    if (OWL_VALIDATION_ACTIVE())
+      validateVarDecls();
   }
 
-  int SBTObjectType::getVariableIdx(const std::string &varName)
+  /*! (only called if validation is enabled) checks for duplicate
+    variable names, and for variables that overlap each other or
+    exceed the variable struct */
+  void SBTObjectType::validateVarDecls() const
   {
+    for (size_t i=0;i<varDecls.size();i++) {
+      const OWLVarDecl &var = varDecls[i];
+      OWL_VALIDATE(var.name != nullptr,"variable without a name");
+      if (var.type == OWL_BUFFER)
+        /* no device-side representation (yet), so no size either */
+        continue;
+      const size_t begin = var.offset;
+      const size_t end   = begin + sizeOf(var.type);
+      OWL_VALIDATE(end <= varStructSize,
+                   "variable '"+std::string(var.name)
+                   +"' exceeds the declared variable struct size");
+      for (size_t j=0;j<i;j++) {
+        const OWLVarDecl &other = varDecls[j];
+        OWL_VALIDATE(strcmp(var.name,other.name) != 0,
+                     "duplicate variable name '"+std::string(var.name)+"'");
+        if (other.type == OWL_BUFFER) continue;
+        const size_t otherBegin = other.offset;
+        const size_t otherEnd   = otherBegin + sizeOf(other.type);
+        OWL_VALIDATE(end <= otherBegin || otherEnd <= begin,
+                     "variables '"+std::string(var.name)+"' and '"
+                     +std::string(other.name)+"' overlap");
+      }
+    }
+  }
+
+  int SBTObjectType::getVariableIdx(const char *varName)
+  {
+    assert(varName);
     for (int i=0;i<varDecls.size();i++) {
       assert(varDecls[i].name);
-      if (!strcmp(varName.c_str(),varDecls[i].name))
+      if (!strcmp(varName,varDecls[i].name))
         return i;
     }
     return -1;
   }
 
-  bool SBTObjectType::hasVariable(const std::string &varName)
+  bool SBTObjectType::hasVariable(const char *varName)
   {
     return getVariableIdx(varName) >= 0;
   }
@@ -66,7 +97,7 @@ namespace owl {
   void SBTObjectBase::writeVariables(uint8_t *sbtEntryBase,
                                      int deviceID) const
   {
-    for (auto var : variables) {
+    for (auto &var : variables) {
       auto decl = var->varDecl;
       var->writeToSBT(sbtEntryBase + decl->offset,deviceID);
     }
@@ -23,15 +23,19 @@ namespace owl {
 
   struct SBTObjectType : public RegisteredObject
   {
-    typedef std::shared_ptr<SBTObjectType> SP;
+    typedef Ref<SBTObjectType> SP;
 
     SBTObjectType(Context *const context,
                   ObjectRegistry &registry,
                   size_t varStructSize,
                   const std::vector<OWLVarDecl> &varDecls);
     
-    int getVariableIdx(const std::string &varName);
-    bool hasVariable(const std::string &varName);
+    int getVariableIdx(const char *varName);
+    bool hasVariable(const char *varName);
+    int getVariableIdx(const std::string &varName)
+    { return getVariableIdx(varName.c_str()); }
+    bool hasVariable(const std::string &varName)
+    { return hasVariable(varName.c_str()); }
 
     virtual std::string toString() const { return "SBTObjectType"; }
     void declareVariable(const std::string &varName,
@@ -39,6 +43,10 @@ namespace owl {
                          size_t offset);
 
     std::vector<Variable::SP> instantiateVariables();
+
+    /*! (only called if validation is enabled) checks for duplicate
+        variable names, and for overlapping variables */
+    void validateVarDecls() const;
     
     /*! the total size of the variables struct */
     const size_t         varStructSize;
@@ -56,19 +64,29 @@ namespace owl {
   {
     SBTObjectBase(Context *const context,
                   ObjectRegistry &registry,
-                  std::shared_ptr<SBTObjectType> type)
+                  Ref<SBTObjectType> type)
       : RegisteredObject(context,registry),
         type(type),
         variables(type->instantiateVariables())
     {
     }
 
-    bool hasVariable(const std::string &name)
+    bool hasVariable(const char *name)
     {
       return type->hasVariable(name);
     }
+    bool hasVariable(const std::string &name)
+    {
+      return type->hasVariable(name.c_str());
+    }
     
     Variable::SP getVariable(const std::string &name)
+    {
+      return getVariable(name.c_str());
+    }
+    /*! same as above, but without having to create a std::string
+        first (this gets called for every owl<Object>Set<Type>()) */
+    Variable::SP getVariable(const char *name)
     {
       int varID = type->getVariableIdx(name);
       assert(varID >= 0);
@@ -91,17 +109,17 @@ namespace owl {
     
     /*! our own type description, that tells us which variables (of
       which type, etc) we have */
-    std::shared_ptr<SBTObjectType> const type;
+    Ref<SBTObjectType> const type;
   };
   
   template<typename ObjectType>
   struct SBTObject : public SBTObjectBase//RegisteredObject
   {
-    typedef std::shared_ptr<SBTObject> SP;
+    typedef Ref<SBTObject> SP;
 
     SBTObject(Context *const context,
               ObjectRegistry &registry,
-              std::shared_ptr<ObjectType> type)
+              Ref<ObjectType> type)
       : SBTObjectBase(context,registry,type),
       // : RegisteredObject(context,registry),
         type(type)
@@ -114,7 +132,7 @@ namespace owl {
     
     /*! our own type description, that tells us which variables (of
       which type, etc) we have */
-    std::shared_ptr<ObjectType> const type;
+    Ref<ObjectType> const type;
   };
 
 } // ::owl
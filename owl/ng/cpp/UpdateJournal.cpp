@@ -0,0 +1,300 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "UpdateJournal.h"
+// std
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace owl {
+  namespace journal {
+
+    /*! size of the header in front of each record */
+    static const size_t recordHeaderSize = 2*sizeof(uint32_t);
+
+    static inline size_t paddedSize(size_t numBytes)
+    {
+      return (numBytes+3) & ~size_t(3);
+    }
+
+    static inline uint64_t childKey(int32_t group, uint32_t child)
+    {
+      return (uint64_t(uint32_t(group)) << 32) | child;
+    }
+
+    /*! bounds-checked reads from one record's payload */
+    struct Reader {
+      Reader(const uint8_t *begin, size_t size)
+        : ptr(begin), end(begin+size)
+      {}
+
+      template<typename T>
+      T get()
+      {
+        T t;
+        getBytes(&t,sizeof(t));
+        return t;
+      }
+      void getBytes(void *out, size_t numBytes)
+      {
+        need(numBytes);
+        memcpy(out,ptr,numBytes);
+        ptr += numBytes;
+      }
+      const uint8_t *skip(size_t numBytes)
+      {
+        need(numBytes);
+        const uint8_t *result = ptr;
+        ptr += numBytes;
+        return result;
+      }
+      void need(size_t numBytes)
+      {
+        if (size_t(end-ptr) < numBytes)
+          throw std::runtime_error("malformed scene update stream: record "
+                                   "is shorter than its contents");
+      }
+      
+      const uint8_t *ptr;
+      const uint8_t *const end;
+    };
+
+    /*! the per-child part of TRANSFORMS, CHILDREN, and
+        VISIBILITY_MASKS records: group, first child, and count */
+    struct ChildRange {
+      int32_t  group;
+      uint32_t firstChild;
+      uint32_t count;
+    };
+
+    static ChildRange readChildRange(Reader &in, size_t bytesPerChild)
+    {
+      ChildRange range;
+      range.group      = in.get<int32_t>();
+      range.firstChild = in.get<uint32_t>();
+      range.count      = in.get<uint32_t>();
+      if (range.group < 0)
+        throw std::runtime_error("malformed scene update stream: invalid "
+                                 "group ID");
+      if (uint64_t(range.firstChild)+range.count > (uint64_t(1) << 32))
+        throw std::runtime_error("malformed scene update stream: child "
+                                 "range overflows");
+      in.need(size_t(range.count)*bytesPerChild);
+      return range;
+    }
+    
+    /*! keeps, per key, only the last value written: later updates of
+        a key overwrite the slot of its first occurrence */
+    template<typename T>
+    struct Coalescer {
+      Coalescer(std::vector<T> &out) : out(out) {}
+      
+      void add(uint64_t key, const T &value)
+      {
+        auto it = slotOf.insert({key,out.size()});
+        if (it.second)
+          out.push_back(value);
+        else
+          out[it.first->second] = value;
+      }
+      
+      std::vector<T> &out;
+      std::unordered_map<uint64_t,size_t> slotOf;
+    };
+    
+    Batch decode(const void *data, size_t numBytes)
+    {
+      const uint8_t *bytes = (const uint8_t *)data;
+      if (numBytes < 2*sizeof(uint32_t))
+        throw std::runtime_error("malformed scene update stream: missing "
+                                 "header");
+      uint32_t header[2];
+      memcpy(header,bytes,sizeof(header));
+      if (header[0] != MAGIC)
+        throw std::runtime_error("not a scene update stream (wrong magic "
+                                 "number)");
+      if (header[1] != VERSION)
+        throw std::runtime_error("unsupported scene update stream version "
+                                 +std::to_string(header[1]));
+      
+      Batch batch;
+      Coalescer<Batch::Transform> transforms(batch.transforms);
+      Coalescer<Batch::Child>     children(batch.children);
+      Coalescer<Batch::Mask>      masks(batch.masks);
+      Coalescer<Batch::Variable>  variables(batch.variables);
+      
+      size_t pos = sizeof(header);
+      while (pos < numBytes) {
+        if (numBytes-pos < recordHeaderSize)
+          throw std::runtime_error("malformed scene update stream: truncated "
+                                   "record header");
+        uint32_t recordHeader[2];
+        memcpy(recordHeader,bytes+pos,sizeof(recordHeader));
+        const uint32_t type        = recordHeader[0];
+        const uint32_t payloadSize = recordHeader[1];
+        pos += recordHeaderSize;
+        if (payloadSize % 4 != 0 || payloadSize > numBytes-pos)
+          throw std::runtime_error("malformed scene update stream: invalid "
+                                   "record size");
+        Reader in(bytes+pos,payloadSize);
+        pos += payloadSize;
+        batch.numRecords++;
+
+        switch (type) {
+        case TRANSFORMS: {
+          const ChildRange range = readChildRange(in,12*sizeof(float));
+          for (uint32_t i=0;i<range.count;i++) {
+            float f[12];
+            in.getBytes(f,sizeof(f));
+            Batch::Transform t;
+            t.group = range.group;
+            t.child = range.firstChild+i;
+            t.xfm   = affine3f(vec3f(f[0],f[1],f[2]),
+                               vec3f(f[3],f[4],f[5]),
+                               vec3f(f[6],f[7],f[8]),
+                               vec3f(f[9],f[10],f[11]));
+            transforms.add(childKey(t.group,t.child),t);
+          }
+          batch.numUpdatesBeforeCoalescing += range.count;
+        } break;
+        case CHILDREN: {
+          const ChildRange range = readChildRange(in,sizeof(int32_t));
+          for (uint32_t i=0;i<range.count;i++) {
+            Batch::Child c;
+            c.group    = range.group;
+            c.child    = range.firstChild+i;
+            c.newChild = in.get<int32_t>();
+            if (c.newChild < 0)
+              throw std::runtime_error("malformed scene update stream: "
+                                       "invalid child group ID");
+            children.add(childKey(c.group,c.child),c);
+          }
+          batch.numUpdatesBeforeCoalescing += range.count;
+        } break;
+        case VISIBILITY_MASKS: {
+          const ChildRange range = readChildRange(in,sizeof(uint8_t));
+          const uint8_t *values = in.skip(range.count);
+          for (uint32_t i=0;i<range.count;i++) {
+            Batch::Mask m;
+            m.group = range.group;
+            m.child = range.firstChild+i;
+            m.mask  = values[i];
+            masks.add(childKey(m.group,m.child),m);
+          }
+          batch.numUpdatesBeforeCoalescing += range.count;
+        } break;
+        case VARIABLE: {
+          Batch::Variable v;
+          v.target   = in.get<uint32_t>();
+          v.object   = in.get<int32_t>();
+          v.varIndex = in.get<uint32_t>();
+          v.dataSize = in.get<uint32_t>();
+          if (v.target > TARGET_MISSPROG || v.object < 0 || v.varIndex >= (1u<<16))
+            throw std::runtime_error("malformed scene update stream: invalid "
+                                     "variable target");
+          const uint8_t *value = in.skip(v.dataSize);
+          // note: values of overwritten variables stay in
+          // variableData; they're small, and this keeps appending O(1)
+          v.dataBegin = batch.variableData.size();
+          batch.variableData.insert(batch.variableData.end(),
+                                    value,value+v.dataSize);
+          // 16 bits for the variable, 2 for the target, and 32 for
+          // the object ID
+          variables.add((uint64_t(uint32_t(v.object)) << 18)
+                        | (uint64_t(v.target) << 16) | v.varIndex,v);
+          batch.numUpdatesBeforeCoalescing++;
+        } break;
+        default:
+          throw std::runtime_error("malformed scene update stream: unknown "
+                                   "record type "+std::to_string(type));
+        }
+      }
+      return batch;
+    }
+
+    Writer::Writer()
+    {
+      const uint32_t header[2] = { MAGIC, VERSION };
+      put(header,sizeof(header));
+    }
+
+    void Writer::beginRecord(uint32_t type, size_t payloadSize)
+    {
+      const uint32_t header[2] = { type, (uint32_t)paddedSize(payloadSize) };
+      put(header,sizeof(header));
+    }
+    
+    void Writer::put(const void *data, size_t numBytes)
+    {
+      bytes.insert(bytes.end(),(const uint8_t*)data,(const uint8_t*)data+numBytes);
+    }
+
+    void Writer::pad()
+    {
+      bytes.resize(paddedSize(bytes.size()),0);
+    }
+
+    void Writer::transforms(int32_t group, uint32_t firstChild, uint32_t count,
+                            const affine3f *xfms)
+    {
+      beginRecord(TRANSFORMS,3*sizeof(uint32_t)+count*12*sizeof(float));
+      const uint32_t range[3] = { (uint32_t)group, firstChild, count };
+      put(range,sizeof(range));
+      for (uint32_t i=0;i<count;i++) {
+        const affine3f &x = xfms[i];
+        const float f[12] = {
+          x.l.vx.x, x.l.vx.y, x.l.vx.z,
+          x.l.vy.x, x.l.vy.y, x.l.vy.z,
+          x.l.vz.x, x.l.vz.y, x.l.vz.z,
+          x.p.x,    x.p.y,    x.p.z
+        };
+        put(f,sizeof(f));
+      }
+    }
+    
+    void Writer::children(int32_t group, uint32_t firstChild, uint32_t count,
+                          const int32_t *newChildren)
+    {
+      beginRecord(CHILDREN,3*sizeof(uint32_t)+count*sizeof(int32_t));
+      const uint32_t range[3] = { (uint32_t)group, firstChild, count };
+      put(range,sizeof(range));
+      put(newChildren,count*sizeof(int32_t));
+    }
+    
+    void Writer::visibilityMasks(int32_t group, uint32_t firstChild, uint32_t count,
+                                 const uint8_t *masks)
+    {
+      beginRecord(VISIBILITY_MASKS,3*sizeof(uint32_t)+count);
+      const uint32_t range[3] = { (uint32_t)group, firstChild, count };
+      put(range,sizeof(range));
+      put(masks,count);
+      pad();
+    }
+    
+    void Writer::variable(uint32_t target, int32_t object, uint32_t varIndex,
+                          const void *value, uint32_t numBytes)
+    {
+      beginRecord(VARIABLE,4*sizeof(uint32_t)+numBytes);
+      const uint32_t head[4] = { target, (uint32_t)object, varIndex, numBytes };
+      put(head,sizeof(head));
+      put(value,numBytes);
+      pad();
+    }
+    
+  } // ::owl::journal
+} // ::owl
@@ -0,0 +1,128 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "owl/common/math/AffineSpace.h"
+// std
+#include <cstdint>
+#include <vector>
+
+namespace owl {
+  using owl::common::affine3f;
+
+  /*! host-side encoding and decoding of the binary scene update
+      format consumed by owlContextApplyUpdates() (see owl_host.h for
+      the format itself). Decoding validates the stream's structure
+      and coalesces redundant updates, but does not look at any
+      objects, so none of this needs a context (or a GPU). */
+  namespace journal {
+    enum {
+      MAGIC   = 0x4a4c574f, /* "OWLJ" */
+      VERSION = 1
+    };
+    
+    /*! record types; must match OWLUpdateType */
+    enum RecordType {
+      TRANSFORMS       = 1,
+      CHILDREN         = 2,
+      VISIBILITY_MASKS = 3,
+      VARIABLE         = 4
+    };
+
+    /*! kinds of objects a VARIABLE record can write to; must match
+        OWLUpdateTarget */
+    enum TargetKind {
+      TARGET_GEOM     = 0,
+      TARGET_RAYGEN   = 1,
+      TARGET_MISSPROG = 2
+    };
+
+    /*! one batch of updates, after coalescing: for each (group,child)
+        only the last transform, child, and mask, and for each
+        (object,variable) only the last value survive. Updates come
+        in the order in which their key was first seen */
+    struct Batch {
+      struct Transform {
+        int32_t  group;
+        uint32_t child;
+        affine3f xfm;
+      };
+      struct Child {
+        int32_t  group;
+        uint32_t child;
+        int32_t  newChild;
+      };
+      struct Mask {
+        int32_t  group;
+        uint32_t child;
+        uint8_t  mask;
+      };
+      struct Variable {
+        uint32_t target;
+        int32_t  object;
+        uint32_t varIndex;
+        /*! the value's bytes, in 'variableData' */
+        size_t   dataBegin;
+        uint32_t dataSize;
+      };
+      
+      std::vector<Transform> transforms;
+      std::vector<Child>     children;
+      std::vector<Mask>      masks;
+      std::vector<Variable>  variables;
+      std::vector<uint8_t>   variableData;
+
+      /*! number of records in the stream, and number of individual
+          updates in them before coalescing */
+      size_t numRecords = 0;
+      size_t numUpdatesBeforeCoalescing = 0;
+
+      /*! number of updates left after coalescing */
+      size_t numUpdates() const
+      {
+        return transforms.size()+children.size()+masks.size()+variables.size();
+      }
+    };
+
+    /*! decodes (and coalesces) the given update stream; throws a
+        std::runtime_error if the stream is malformed */
+    Batch decode(const void *data, size_t numBytes);
+
+    /*! helper for producers of update streams: appends records to a
+        byte vector, starting with the stream header */
+    struct Writer {
+      Writer();
+
+      void transforms(int32_t group, uint32_t firstChild, uint32_t count,
+                      const affine3f *xfms);
+      void children(int32_t group, uint32_t firstChild, uint32_t count,
+                    const int32_t *newChildren);
+      void visibilityMasks(int32_t group, uint32_t firstChild, uint32_t count,
+                           const uint8_t *masks);
+      void variable(uint32_t target, int32_t object, uint32_t varIndex,
+                    const void *value, uint32_t numBytes);
+
+      /*! the encoded stream so far */
+      std::vector<uint8_t> bytes;
+    private:
+      void beginRecord(uint32_t type, size_t payloadSize);
+      void put(const void *data, size_t numBytes);
+      void pad();
+    };
+    
+  } // ::owl::journal
+} // ::owl
@@ -48,13 +48,14 @@ namespace owl {
     
   template<typename T>
   struct VariableT : public Variable {
-    typedef std::shared_ptr<VariableT<T>> SP;
+    typedef Ref<VariableT<T>> SP;
 
     VariableT(const OWLVarDecl *const varDecl)
       : Variable(varDecl)
     {}
     
     void set(const T &value) override { this->value = value; }
+    void setRaw(const void *ptr) override { memcpy((void*)&value,ptr,sizeof(T)); }
 
     void writeToSBT(uint8_t *sbtEntry, int deviceID) const override
     {
@@ -65,7 +66,7 @@ namespace owl {
   };
 
   struct BufferPointerVariable : public Variable {
-    typedef std::shared_ptr<BufferPointerVariable> SP;
+    typedef Ref<BufferPointerVariable> SP;
 
     BufferPointerVariable(const OWLVarDecl *const varDecl)
       : Variable(varDecl)
@@ -74,6 +75,9 @@ namespace owl {
 
     void writeToSBT(uint8_t *sbtEntry, int deviceID) const override
     {
+      OWL_VALIDATE(!buffer || buffer->ID >= 0,
+                   "variable '"+std::string(varDecl->name)
+                   +"' refers to a buffer that was already destroyed");
       const void *value
         = buffer
         ? buffer->getPointer(deviceID)
@@ -85,7 +89,7 @@ namespace owl {
   };
   
   struct DeviceIndexVariable : public Variable {
-    typedef std::shared_ptr<BufferPointerVariable> SP;
+    typedef Ref<BufferPointerVariable> SP;
 
     DeviceIndexVariable(const OWLVarDecl *const varDecl)
       : Variable(varDecl)
@@ -104,7 +108,7 @@ namespace owl {
   };
   
   struct BufferVariable : public Variable {
-    typedef std::shared_ptr<BufferVariable> SP;
+    typedef Ref<BufferVariable> SP;
 
     BufferVariable(const OWLVarDecl *const varDecl)
       : Variable(varDecl)
@@ -115,14 +119,14 @@ namespace owl {
   };
   
   struct GroupVariable : public Variable {
-    typedef std::shared_ptr<GroupVariable> SP;
+    typedef Ref<GroupVariable> SP;
 
     GroupVariable(const OWLVarDecl *const varDecl)
       : Variable(varDecl)
     {}
     void set(const Group::SP &value) override
     {
-      if (value && !std::dynamic_pointer_cast<InstanceGroup>(value))
+      if (value && !dynamicRefCast<InstanceGroup>(value))
         throw std::runtime_error("OWL currently supports only instance groups to be passed to traversal; if you do want to trace rays into a single User or Triangle group, please put them into a single 'dummy' instance with jsut this one child and a identity transform");
       this->group = value;
     }
@@ -145,63 +149,63 @@ namespace owl {
     assert(decl);
     assert(decl->name);
     if (decl->type >= OWL_USER_TYPE_BEGIN)
-      return std::make_shared<UserTypeVariable>(decl);
+      return makeRef<UserTypeVariable>(decl);
     switch(decl->type) {
     case OWL_INT:
-      return std::make_shared<VariableT<int32_t>>(decl);
+      return makeRef<VariableT<int32_t>>(decl);
     case OWL_INT2:
-      return std::make_shared<VariableT<vec2i>>(decl);
+      return makeRef<VariableT<vec2i>>(decl);
     case OWL_INT3:
-      return std::make_shared<VariableT<vec3i>>(decl);
+      return makeRef<VariableT<vec3i>>(decl);
     case OWL_INT4:
-      return std::make_shared<VariableT<vec4i>>(decl);
+      return makeRef<VariableT<vec4i>>(decl);
 
     case OWL_UINT:
-      return std::make_shared<VariableT<uint32_t>>(decl);
+      return makeRef<VariableT<uint32_t>>(decl);
     case OWL_UINT2:
-      return std::make_shared<VariableT<vec2ui>>(decl);
+      return makeRef<VariableT<vec2ui>>(decl);
     case OWL_UINT3:
-      return std::make_shared<VariableT<vec3ui>>(decl);
+      return makeRef<VariableT<vec3ui>>(decl);
     case OWL_UINT4:
-      return std::make_shared<VariableT<vec4ui>>(decl);
+      return makeRef<VariableT<vec4ui>>(decl);
 
       
     case OWL_LONG:
-      return std::make_shared<VariableT<int64_t>>(decl);
+      return makeRef<VariableT<int64_t>>(decl);
     case OWL_LONG2:
-      return std::make_shared<VariableT<vec2l>>(decl);
+      return makeRef<VariableT<vec2l>>(decl);
     case OWL_LONG3:
-      return std::make_shared<VariableT<vec3l>>(decl);
+      return makeRef<VariableT<vec3l>>(decl);
     case OWL_LONG4:
-      return std::make_shared<VariableT<vec4l>>(decl);
+      return makeRef<VariableT<vec4l>>(decl);
 
     case OWL_ULONG:
-      return std::make_shared<VariableT<uint64_t>>(decl);
+      return makeRef<VariableT<uint64_t>>(decl);
     case OWL_ULONG2:
-      return std::make_shared<VariableT<vec2ul>>(decl);
+      return makeRef<VariableT<vec2ul>>(decl);
     case OWL_ULONG3:
-      return std::make_shared<VariableT<vec3ul>>(decl);
+      return makeRef<VariableT<vec3ul>>(decl);
     case OWL_ULONG4:
-      return std::make_shared<VariableT<vec4ul>>(decl);
+      return makeRef<VariableT<vec4ul>>(decl);
 
 
     case OWL_FLOAT:
-      return std::make_shared<VariableT<float>>(decl);
+      return makeRef<VariableT<float>>(decl);
     case OWL_FLOAT2:
-      return std::make_shared<VariableT<vec2f>>(decl);
+      return makeRef<VariableT<vec2f>>(decl);
     case OWL_FLOAT3:
-      return std::make_shared<VariableT<vec3f>>(decl);
+      return makeRef<VariableT<vec3f>>(decl);
     case OWL_FLOAT4:
-      return std::make_shared<VariableT<vec4f>>(decl);
+      return makeRef<VariableT<vec4f>>(decl);
 
     case OWL_GROUP:
-      return std::make_shared<GroupVariable>(decl);
+      return makeRef<GroupVariable>(decl);
     case OWL_BUFFER:
-      return std::make_shared<BufferVariable>(decl);
+      return makeRef<BufferVariable>(decl);
     case OWL_BUFFER_POINTER:
-      return std::make_shared<BufferPointerVariable>(decl);
+      return makeRef<BufferPointerVariable>(decl);
     case OWL_DEVICE:
-      return std::make_shared<DeviceIndexVariable>(decl);
+      return makeRef<DeviceIndexVariable>(decl);
     }
     throw std::runtime_error(std::string(__PRETTY_FUNCTION__)
                              +": not yet implemented for type "
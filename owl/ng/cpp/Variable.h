@@ -17,21 +17,25 @@
 #pragma once
 
 #include "Object.h"
+#include "owl/ll/HostAllocator.h"
 
 namespace owl {
 
   struct Buffer;
   struct Group;
   
-  struct Variable : public Object {
-    typedef std::shared_ptr<Variable> SP;
+  /*! variables come from HostAllocator, so they get counted
+      towards its 'variables' site */
+  struct Variable : public Object,
+                    public ll::HostAllocated<ll::HostAllocator::SITE_VARIABLES> {
+    typedef Ref<Variable> SP;
 
     Variable(const OWLVarDecl *const varDecl)
       : varDecl(varDecl)
     { assert(varDecl); }
     
-    virtual void set(const std::shared_ptr<Buffer> &value) { mismatchingType(); }
-    virtual void set(const std::shared_ptr<Group>  &value) { mismatchingType(); }
+    virtual void set(const Ref<Buffer> &value) { mismatchingType(); }
+    virtual void set(const Ref<Group>  &value) { mismatchingType(); }
     
     virtual void setRaw(const void *ptr)    { mismatchingType(); }
 
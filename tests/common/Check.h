@@ -0,0 +1,56 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+/*! \file tests/common/Check.h The check macro and pass/fail reporting
+    shared by all of owl's tests. Each test defines OWL_TEST_NAME
+    (eg, "t06") before including this file. */
+
+#pragma once
+
+// std
+#include <cstdlib>
+#include <iostream>
+
+#ifndef OWL_TEST_NAME
+# error "define OWL_TEST_NAME before including tests/common/Check.h"
+#endif
+
+/*! fails the test (with the condition, function and line) if 'cond'
+    does not hold */
+#define CHECK(cond)                                                     \
+  do {                                                                  \
+    if (!(cond)) {                                                      \
+      std::cerr << "#owl.test(" OWL_TEST_NAME "): check failed in "     \
+                << __FUNCTION__ << ", line " << __LINE__ << ": "        \
+                << #cond << std::endl;                                  \
+      exit(1);                                                          \
+    }                                                                   \
+  } while (0)
+
+namespace owl {
+  namespace test {
+
+    /*! reports that all of the test's checks of the given kind
+        passed; returns the test's exit code */
+    inline int allPassed(const char *what)
+    {
+      std::cout << "#owl.test(" OWL_TEST_NAME "): all " << what
+                << " tests passed" << std::endl;
+      return 0;
+    }
+
+  } // ::owl::test
+} // ::owl
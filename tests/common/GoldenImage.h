@@ -0,0 +1,435 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+/*! \file tests/common/GoldenImage.h A small, header-only harness for
+    golden-image regression tests: compares a rendered RGBA8 frame
+    buffer - from an OWL launch, or from any host-side reference
+    renderer - against a stored, known-good PNG, and reports the PSNR,
+    the largest per-channel error, and how many pixels differ, with a
+    heatmap of where. The diff runs over blocks of rows in parallel
+    (where TBB is available), four pixels at a time with SSE2.
+
+    Golden images live in the directory named by the OWL_GOLDEN_DIR
+    environment variable; with OWL_UPDATE_GOLDEN=1, checks (re-)write
+    them from the current frame instead of comparing against them.
+
+    PNG I/O goes through stb: the file that includes this header has
+    to define STB_IMAGE_IMPLEMENTATION and
+    STB_IMAGE_WRITE_IMPLEMENTATION first, and must not include the
+    stb headers itself. */
+
+#pragma once
+
+#include <owl/common/owl-common.h>
+#include <owl/common/math/vec.h>
+#include "owl/common/parallel/parallel_for.h"
+#include "stb/stb_image.h"
+#include "stb/stb_image_write.h"
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+// simd
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define OWL_GOLDEN_SSE2 1
+#else
+# define OWL_GOLDEN_SSE2 0
+#endif
+
+namespace owl {
+  namespace test {
+    using owl::common::vec2i;
+
+    /*! an RGBA8 image with one uint32 per pixel (red in the lowest
+        byte), first row first - the layout of the samples' frame
+        buffers, and of what they pass to stbi_write_png() */
+    struct Image {
+      Image() {}
+      Image(const vec2i &size)
+        : size(size), pixels(size_t(size.x)*size.y,0)
+      {}
+
+      bool load(const std::string &fileName)
+      {
+        int w, h, n;
+        stbi_uc *data = stbi_load(fileName.c_str(),&w,&h,&n,4);
+        if (!data) return false;
+        size = vec2i(w,h);
+        pixels.resize(size_t(w)*h);
+        memcpy(pixels.data(),data,pixels.size()*sizeof(uint32_t));
+        stbi_image_free(data);
+        return true;
+      }
+
+      bool save(const std::string &fileName) const
+      {
+        return stbi_write_png(fileName.c_str(),size.x,size.y,4,
+                              pixels.data(),size.x*sizeof(uint32_t)) != 0;
+      }
+
+      vec2i                 size { 0, 0 };
+      std::vector<uint32_t> pixels;
+    };
+
+    /*! what counts as a match */
+    struct DiffOptions {
+      /*! pixels whose channels all differ by at most this much (out
+          of 255) do not count as differing */
+      int    tolerance            = 2;
+      /*! images match if at most this fraction of their pixels
+          differ, and their PSNR is at least minPSNR */
+      double maxDifferingFraction = 0.;
+      double minPSNR              = 40.;
+      /*! whether alpha gets compared, too */
+      bool   compareAlpha         = false;
+      /*! whether to produce DiffResult::heatmap */
+      bool   makeHeatmap          = false;
+    };
+
+    struct DiffResult {
+      /*! the images had different sizes, and did not get compared */
+      bool   sizeMismatch  = false;
+      /*! compareToGolden() only: there was no golden image to
+          compare against, or it just got (re-)written */
+      bool   goldenMissing = false;
+      bool   goldenUpdated = false;
+
+      /*! mean squared error over all compared channels, and the
+          PSNR that corresponds to it (in dB; infinite for identical
+          images) */
+      double mse                = 0.;
+      double psnr               = std::numeric_limits<double>::infinity();
+      /*! largest per-channel difference, and the first pixel (in
+          row order) that has it */
+      int    maxError           = 0;
+      vec2i  maxErrorPixel      { -1, -1 };
+      /*! pixels with a channel that differs by more than the
+          tolerance */
+      size_t numDifferingPixels = 0;
+      bool   passed             = false;
+
+      /*! per pixel, its largest channel difference, from black (none)
+          via blue, green and yellow up to red (maxError) */
+      Image  heatmap;
+    };
+
+    namespace detail {
+      /*! results of one block of rows */
+      struct DiffPartial {
+        uint64_t sumSquares   = 0;
+        int      maxError     = 0;
+        int      maxErrorRow  = -1;
+        size_t   numDiffering = 0;
+      };
+
+      inline void diffPixel(uint32_t a, uint32_t b, uint32_t channelMask,
+                            int tolerance, uint64_t &sumSquares,
+                            int &maxError, size_t &numDiffering,
+                            uint8_t *pixelError)
+      {
+        int pixelMax = 0;
+        for (int c=0;c<4;c++) {
+          if (!((channelMask >> (8*c)) & 0xff)) continue;
+          const int d = std::abs(int((a >> (8*c)) & 0xff)
+                                 - int((b >> (8*c)) & 0xff));
+          sumSquares += d*d;
+          pixelMax = std::max(pixelMax,d);
+        }
+        maxError = std::max(maxError,pixelMax);
+        numDiffering += (pixelMax > tolerance);
+        if (pixelError) *pixelError = (uint8_t)pixelMax;
+      }
+
+      /*! diffs one row of pixels; if 'pixelErrors' is non-null it
+          gets each pixel's largest channel difference */
+      inline void diffRow(const uint32_t *a, const uint32_t *b, int width,
+                          uint32_t channelMask, int tolerance,
+                          uint64_t &sumSquares, int &maxError,
+                          size_t &numDiffering, uint8_t *pixelErrors)
+      {
+        int x = 0;
+#if OWL_GOLDEN_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i mask = _mm_set1_epi32((int)channelMask);
+        const __m128i tol  = _mm_set1_epi8((char)(uint8_t)tolerance);
+        __m128i maxBytes   = zero;
+        __m128i sums       = zero;
+        int sinceFlush     = 0;
+        // each 32-bit lane of 'sums' gains at most 4*255^2 per
+        // iteration, so flushing every 1024 can't overflow
+        auto flush = [&]() {
+          uint32_t lanes[4];
+          _mm_storeu_si128((__m128i*)lanes,sums);
+          sumSquares += uint64_t(lanes[0])+lanes[1]+lanes[2]+lanes[3];
+          sums = zero;
+          sinceFlush = 0;
+        };
+        for (;x+4<=width;x+=4) {
+          const __m128i va = _mm_loadu_si128((const __m128i*)(a+x));
+          const __m128i vb = _mm_loadu_si128((const __m128i*)(b+x));
+          const __m128i d
+            = _mm_and_si128(_mm_or_si128(_mm_subs_epu8(va,vb),
+                                         _mm_subs_epu8(vb,va)),
+                            mask);
+          maxBytes = _mm_max_epu8(maxBytes,d);
+          const __m128i lo = _mm_unpacklo_epi8(d,zero);
+          const __m128i hi = _mm_unpackhi_epi8(d,zero);
+          sums = _mm_add_epi32(sums,_mm_add_epi32(_mm_madd_epi16(lo,lo),
+                                                  _mm_madd_epi16(hi,hi)));
+          // a pixel is 'the same' if no channel exceeds the tolerance
+          const int same
+            = _mm_movemask_ps(_mm_castsi128_ps
+                              (_mm_cmpeq_epi32(_mm_subs_epu8(d,tol),zero)));
+          numDiffering += 4-((same&1)+((same>>1)&1)+((same>>2)&1)+((same>>3)&1));
+          if (pixelErrors) {
+            uint32_t px[4];
+            _mm_storeu_si128((__m128i*)px,d);
+            for (int i=0;i<4;i++)
+              pixelErrors[x+i]
+                = (uint8_t)std::max(std::max(px[i] & 0xff,(px[i] >> 8) & 0xff),
+                                    std::max((px[i] >> 16) & 0xff,px[i] >> 24));
+          }
+          if (++sinceFlush == 1024)
+            flush();
+        }
+        flush();
+        uint8_t bytes[16];
+        _mm_storeu_si128((__m128i*)bytes,maxBytes);
+        for (int i=0;i<16;i++)
+          maxError = std::max(maxError,(int)bytes[i]);
+#endif
+        for (;x<width;x++)
+          diffPixel(a[x],b[x],channelMask,tolerance,
+                    sumSquares,maxError,numDiffering,
+                    pixelErrors ? pixelErrors+x : nullptr);
+      }
+
+      /*! black for no error, then blue, green, yellow, and red for
+          'maxError' */
+      inline uint32_t heatColor(int error, int maxError)
+      {
+        if (error == 0) return 0xff000000;
+        static const float stops[4][3] = {
+          { 0.f,   0.f,   255.f },
+          { 0.f,   255.f, 0.f   },
+          { 255.f, 255.f, 0.f   },
+          { 255.f, 0.f,   0.f   }
+        };
+        const float t   = 3.f*error/std::max(maxError,1);
+        const int   seg = std::min(int(t),2);
+        const float f   = std::min(t-seg,1.f);
+        uint32_t color = 0xff000000;
+        for (int c=0;c<3;c++) {
+          const float v = (1.f-f)*stops[seg][c] + f*stops[seg+1][c];
+          color |= uint32_t(v+.5f) << (8*c);
+        }
+        return color;
+      }
+    }
+
+    /*! compares two images of the given size */
+    inline DiffResult diffImages(const uint32_t *actual,
+                                 const uint32_t *expected,
+                                 const vec2i &size,
+                                 const DiffOptions &options = DiffOptions())
+    {
+      DiffResult result;
+      const size_t   numPixels   = size_t(std::max(size.x,0))*std::max(size.y,0);
+      const uint32_t channelMask = options.compareAlpha ? 0xffffffff : 0x00ffffff;
+      const int      tolerance   = std::min(std::max(options.tolerance,0),255);
+      std::vector<uint8_t> pixelErrors(options.makeHeatmap ? numPixels : 0);
+
+      const int rowsPerBlock = 16;
+      const int numBlocks    = (std::max(size.y,0)+rowsPerBlock-1)/rowsPerBlock;
+      std::vector<detail::DiffPartial> partial(numBlocks);
+      owl::common::parallel_for
+        (numBlocks,[&](int blockID){
+          detail::DiffPartial &p = partial[blockID];
+          const int end = std::min(size.y,(blockID+1)*rowsPerBlock);
+          for (int y=blockID*rowsPerBlock;y<end;y++) {
+            const size_t row = size_t(y)*size.x;
+            int rowMax = 0;
+            detail::diffRow(actual+row,expected+row,size.x,
+                            channelMask,tolerance,
+                            p.sumSquares,rowMax,p.numDiffering,
+                            options.makeHeatmap ? pixelErrors.data()+row : nullptr);
+            if (rowMax > p.maxError) {
+              p.maxError    = rowMax;
+              p.maxErrorRow = y;
+            }
+          }
+        });
+
+      uint64_t sumSquares  = 0;
+      int      maxErrorRow = -1;
+      for (auto &p : partial) {
+        sumSquares += p.sumSquares;
+        result.numDifferingPixels += p.numDiffering;
+        if (p.maxError > result.maxError) {
+          result.maxError = p.maxError;
+          maxErrorRow     = p.maxErrorRow;
+        }
+      }
+      if (maxErrorRow >= 0) {
+        const size_t row = size_t(maxErrorRow)*size.x;
+        for (int x=0;x<size.x;x++) {
+          uint64_t ignoredSum  = 0;
+          size_t   ignoredDiff = 0;
+          int      pixelMax    = 0;
+          detail::diffPixel(actual[row+x],expected[row+x],channelMask,tolerance,
+                            ignoredSum,pixelMax,ignoredDiff,nullptr);
+          if (pixelMax == result.maxError) {
+            result.maxErrorPixel = vec2i(x,maxErrorRow);
+            break;
+          }
+        }
+      }
+
+      const int numChannels = options.compareAlpha ? 4 : 3;
+      if (numPixels)
+        result.mse = double(sumSquares)/(double(numPixels)*numChannels);
+      if (result.mse > 0.)
+        result.psnr = 10.*std::log10(255.*255./result.mse);
+      result.passed
+        =  result.psnr >= options.minPSNR
+        && result.numDifferingPixels <= options.maxDifferingFraction*numPixels;
+
+      if (options.makeHeatmap) {
+        result.heatmap = Image(size);
+        for (size_t i=0;i<numPixels;i++)
+          result.heatmap.pixels[i]
+            = detail::heatColor(pixelErrors[i],result.maxError);
+      }
+      return result;
+    }
+
+    inline DiffResult diffImages(const Image &actual,
+                                 const Image &expected,
+                                 const DiffOptions &options = DiffOptions())
+    {
+      if (actual.size != expected.size) {
+        DiffResult result;
+        result.sizeMismatch = true;
+        return result;
+      }
+      return diffImages(actual.pixels.data(),expected.pixels.data(),
+                        actual.size,options);
+    }
+
+    /*! whether OWL_UPDATE_GOLDEN=1 asks for re-writing golden images */
+    inline bool updateGoldenRequested()
+    {
+      const char *update = getenv("OWL_UPDATE_GOLDEN");
+      return update && std::string(update) == "1";
+    }
+
+    /*! compares the given frame buffer against the golden image in
+        'goldenFile' - or, if 'update' is set, writes it there as the
+        new golden image. Prints one line with the results; on
+        failure, writes the frame and a heatmap of the differences to
+        <name>.actual.png and <name>.heatmap.png in the current
+        directory, with <name> the golden file's name without its
+        path and extension */
+    inline DiffResult compareToGolden(const uint32_t *frame,
+                                      const vec2i &size,
+                                      const std::string &goldenFile,
+                                      DiffOptions options = DiffOptions(),
+                                      bool update = updateGoldenRequested())
+    {
+      const size_t slash = goldenFile.find_last_of("/\\");
+      std::string name = goldenFile.substr(slash == std::string::npos ? 0 : slash+1);
+      if (name.size() > 4 && name.substr(name.size()-4) == ".png")
+        name = name.substr(0,name.size()-4);
+
+      Image actual(size);
+      std::copy(frame,frame+actual.pixels.size(),actual.pixels.begin());
+
+      DiffResult result;
+      if (update) {
+        result.goldenUpdated = result.passed = actual.save(goldenFile);
+        std::cout << "#owl.golden(" << name << "): "
+                  << (result.passed ? "updated " : "could not write ")
+                  << goldenFile << std::endl;
+        return result;
+      }
+
+      Image golden;
+      if (!golden.load(goldenFile)) {
+        result.goldenMissing = true;
+        std::cout << "#owl.golden(" << name << "): no golden image '"
+                  << goldenFile << "' (run with OWL_UPDATE_GOLDEN=1 to "
+                  << "create it) - FAILED" << std::endl;
+      } else {
+        options.makeHeatmap = true;
+        result = diffImages(actual,golden,options);
+        std::cout << "#owl.golden(" << name << "): ";
+        if (result.sizeMismatch)
+          std::cout << "size " << size << " does not match the golden image's "
+                    << golden.size;
+        else {
+          std::cout << "PSNR ";
+          if (std::isinf(result.psnr))
+            std::cout << "inf";
+          else {
+            const std::ios::fmtflags flags = std::cout.flags();
+            const std::streamsize precision = std::cout.precision();
+            std::cout << std::fixed << std::setprecision(2) << result.psnr;
+            std::cout.flags(flags);
+            std::cout.precision(precision);
+          }
+          std::cout << " dB, max error " << result.maxError;
+          if (result.maxError)
+            std::cout << " at " << result.maxErrorPixel;
+          std::cout << ", " << result.numDifferingPixels << " pixel(s) differ";
+        }
+        std::cout << " - " << (result.passed ? "passed" : "FAILED") << std::endl;
+      }
+      if (!result.passed) {
+        actual.save(name+".actual.png");
+        if (!result.heatmap.pixels.empty())
+          result.heatmap.save(name+".heatmap.png");
+      }
+      return result;
+    }
+
+    /*! checks the given frame against <OWL_GOLDEN_DIR>/<name>.png;
+        returns true if it matches, or if OWL_GOLDEN_DIR is not set
+        (in which case there is nothing to compare against) */
+    inline bool checkGolden(const std::string &name,
+                            const uint32_t *frame,
+                            const vec2i &size,
+                            const DiffOptions &options = DiffOptions())
+    {
+      const char *goldenDir = getenv("OWL_GOLDEN_DIR");
+      if (!goldenDir) {
+        std::cout << "#owl.golden(" << name << "): OWL_GOLDEN_DIR not set, "
+                  << "skipping golden image check" << std::endl;
+        return true;
+      }
+      return compareToGolden(frame,size,std::string(goldenDir)+"/"+name+".png",
+                             options).passed;
+    }
+
+  } // ::owl::test
+} // ::owl
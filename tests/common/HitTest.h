@@ -0,0 +1,78 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+/*! \file tests/common/HitTest.h Types shared between the host and
+    device code of the GPU 'hit tests' (see HitTestScene.h and
+    hitTestPrograms.cu): each pixel of a [0,1]^2 grid shoots one ray
+    along +z, and records what it hit - which lets tests check what
+    ended up in the accels and SBT after going through owl's build
+    paths. */
+
+#pragma once
+
+#include <owl/owl.h>
+#include <owl/common/math/vec.h>
+
+namespace owl {
+  namespace test {
+
+    using owl::common::vec2f;
+    using owl::common::vec2i;
+    using owl::common::vec3f;
+    using owl::common::vec3i;
+
+    /*! what a pixel's ray hit; all -1 for rays that did not hit
+        anything */
+    struct HitRecord {
+      /*! the 'tag' variable of the geom that got hit */
+      int geomTag;
+      /*! optixGetInstanceId() of the innermost instance */
+      int instanceID;
+      /*! optixGetPrimitiveIndex() */
+      int primID;
+      /*! the hit primitive's index into its geom's own index
+          buffer */
+      int localPrimID;
+    };
+
+    /*! launch params of the 'hitTest' ray gen */
+    struct HitTestParams {
+      OptixTraversableHandle world;
+      HitRecord *hits;
+      vec2i      fbSize;
+      /*! visibility mask the rays get traced with */
+      int        rayMask;
+      /*! whether some group merges meshes, so the hit records hold
+          what owl::getPrimitiveIndexInGeom() needs; otherwise
+          localPrimID is just optixGetPrimitiveIndex() */
+      int        mergedMeshes;
+    };
+
+    /*! sbt data of both hit test ray gens; 'writeTag' writes 'tag'
+        into out[0].geomTag (and ignores the launch params), so tests
+        can tell which ray gen record a launch used */
+    struct HitTestRayGenData {
+      int        tag;
+      HitRecord *out;
+    };
+
+    /*! sbt data of the hit test triangles geoms */
+    struct HitTestGeomData {
+      int tag;
+    };
+
+  } // ::owl::test
+} // ::owl
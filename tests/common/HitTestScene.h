@@ -0,0 +1,218 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+/*! \file tests/common/HitTestScene.h Host side of the GPU hit tests:
+    a context with the hit test programs (tests/common/
+    hitTestPrograms.cu, embedded by the test as 'ptxCode'), helpers to
+    create tagged triangle geoms, and a render() that shoots one ray
+    per pixel over [0,1]^2 and returns what each one hit.
+
+    Tests that need a GPU build their scene through the regular owl
+    API with this, and then check the hit records - which is how they
+    exercise owl's accel and SBT build paths end to end. */
+
+#pragma once
+
+#include "tests/common/HitTest.h"
+#include <cuda_runtime.h>
+// std
+#include <algorithm>
+#include <vector>
+
+namespace owl {
+  namespace test {
+
+    struct HitTestScene {
+      /*! creates a context with the hit test programs; if
+          'configure' is given it gets called on the new context
+          before anything else gets created in it */
+      HitTestScene(const char *ptxCode,
+                   const vec2i &fbSize = vec2i(64),
+                   void (*configure)(OWLContext) = nullptr)
+        : fbSize(fbSize)
+      {
+        context = owlContextCreate(nullptr,1);
+        if (configure) configure(context);
+        module  = owlModuleCreate(context,ptxCode);
+
+        OWLVarDecl geomVars[] = {
+          { "tag", OWL_INT, OWL_OFFSETOF(HitTestGeomData,tag) },
+          { /* sentinel */ }
+        };
+        trianglesType
+          = owlGeomTypeCreate(context,OWL_GEOMETRY_TRIANGLES,
+                              sizeof(HitTestGeomData),geomVars,-1);
+        owlGeomTypeSetClosestHit(trianglesType,0,module,"hitTestTriangles");
+
+        hitBuffer = owlHostPinnedBufferCreate(context,
+                                              OWL_USER_TYPE(HitRecord),
+                                              fbSize.x*fbSize.y);
+        rayGen = createRayGen("hitTest",0);
+        owlMissProgCreate(context,module,"hitTestMiss",0,nullptr,-1);
+
+        OWLVarDecl paramsVars[] = {
+          { "world",   OWL_GROUP,  OWL_OFFSETOF(HitTestParams,world) },
+          { "hits",    OWL_BUFPTR, OWL_OFFSETOF(HitTestParams,hits) },
+          { "fbSize",  OWL_INT2,   OWL_OFFSETOF(HitTestParams,fbSize) },
+          { "rayMask", OWL_INT,    OWL_OFFSETOF(HitTestParams,rayMask) },
+          { "mergedMeshes", OWL_INT, OWL_OFFSETOF(HitTestParams,mergedMeshes) },
+          { /* sentinel */ }
+        };
+        launchParams
+          = owlLaunchParamsCreate(context,sizeof(HitTestParams),
+                                  paramsVars,-1);
+        owlLaunchParamsSetBuffer(launchParams,"hits",hitBuffer);
+        owlLaunchParamsSet2i(launchParams,"fbSize",fbSize.x,fbSize.y);
+      }
+
+      ~HitTestScene()
+      {
+        owlContextDestroy(context);
+      }
+
+      /*! creates another ray gen over the hit test programs
+          ("hitTest" or "writeTag"), with the given tag, and writing
+          into the hit buffer */
+      OWLRayGen createRayGen(const char *programName, int tag)
+      {
+        OWLVarDecl rayGenVars[] = {
+          { "tag", OWL_INT,    OWL_OFFSETOF(HitTestRayGenData,tag) },
+          { "out", OWL_BUFPTR, OWL_OFFSETOF(HitTestRayGenData,out) },
+          { /* sentinel */ }
+        };
+        OWLRayGen rg
+          = owlRayGenCreate(context,module,programName,
+                            sizeof(HitTestRayGenData),rayGenVars,-1);
+        owlRayGenSet1i(rg,"tag",tag);
+        owlRayGenSetBuffer(rg,"out",hitBuffer);
+        return rg;
+      }
+
+      /*! creates a triangles geom over the given mesh (with its own
+          vertex and index buffers), whose hits report 'tag' */
+      OWLGeom createTriangles(int tag,
+                              const std::vector<vec3f> &vertices,
+                              const std::vector<vec3i> &indices)
+      {
+        OWLBuffer vertexBuffer
+          = owlDeviceBufferCreate(context,OWL_FLOAT3,
+                                  vertices.size(),vertices.data());
+        OWLBuffer indexBuffer
+          = owlDeviceBufferCreate(context,OWL_INT3,
+                                  indices.size(),indices.data());
+        OWLGeom geom = owlGeomCreate(context,trianglesType);
+        owlTrianglesSetVertices(geom,vertexBuffer,
+                                vertices.size(),sizeof(vec3f),0);
+        owlTrianglesSetIndices(geom,indexBuffer,
+                               indices.size(),sizeof(vec3i),0);
+        owlGeomSet1i(geom,"tag",tag);
+        owlBufferRelease(vertexBuffer);
+        owlBufferRelease(indexBuffer);
+        return geom;
+      }
+
+      /*! the two triangles of the quad [lower,upper] at z=0 */
+      static std::vector<vec3f> quadVertices(const vec2f &lower,
+                                             const vec2f &upper)
+      {
+        return {
+          vec3f(lower.x,lower.y,0.f), vec3f(upper.x,lower.y,0.f),
+          vec3f(upper.x,upper.y,0.f), vec3f(lower.x,upper.y,0.f)
+        };
+      }
+      static std::vector<vec3i> quadIndices()
+      {
+        return { vec3i(0,1,2), vec3i(0,2,3) };
+      }
+
+      OWLGeom createQuad(int tag, const vec2f &lower, const vec2f &upper)
+      {
+        return createTriangles(tag,quadVertices(lower,upper),quadIndices());
+      }
+
+      /*! builds programs and pipeline; call once all geom types and
+          ray gens exist */
+      void buildPrograms()
+      {
+        owlBuildPrograms(context);
+        owlBuildPipeline(context);
+      }
+
+      /*! builds the SBT, traces one ray per pixel into 'world', and
+          returns what each pixel hit */
+      std::vector<HitRecord> render(OWLGroup world, int rayMask = 255)
+      {
+        owlLaunchParamsSetGroup(launchParams,"world",world);
+        owlLaunchParamsSet1i(launchParams,"rayMask",rayMask);
+        owlBuildSBT(context);
+        return launch();
+      }
+
+      /*! same as render(), but without (re-)building the SBT */
+      std::vector<HitRecord> launch()
+      {
+        owlParamsLaunch2D(rayGen,fbSize.x,fbSize.y,launchParams);
+        cudaDeviceSynchronize();
+        return readHits();
+      }
+
+      std::vector<HitRecord> readHits()
+      {
+        const HitRecord *hits
+          = (const HitRecord *)owlBufferGetPointer(hitBuffer,0);
+        return std::vector<HitRecord>(hits,hits+fbSize.x*fbSize.y);
+      }
+
+      /*! the hit record of the pixel that covers 'pos' (in
+          [0,1]^2) */
+      HitRecord hitAt(const std::vector<HitRecord> &hits,
+                      const vec2f &pos) const
+      {
+        const int x = std::min(fbSize.x-1,int(pos.x*fbSize.x));
+        const int y = std::min(fbSize.y-1,int(pos.y*fbSize.y));
+        return hits[x+fbSize.x*y];
+      }
+
+      /*! returns how many pixels hit a geom with the given tag */
+      static size_t countTag(const std::vector<HitRecord> &hits, int tag)
+      {
+        size_t count = 0;
+        for (auto &hit : hits)
+          if (hit.geomTag == tag) count++;
+        return count;
+      }
+
+      const vec2i     fbSize;
+      OWLContext      context;
+      OWLModule       module;
+      OWLGeomType     trianglesType;
+      OWLBuffer       hitBuffer;
+      OWLRayGen       rayGen;
+      OWLLaunchParams launchParams;
+    };
+
+    /*! a 12-float OWL_MATRIX_FORMAT_OWL transform that translates by
+        'delta' */
+    struct Translation {
+      Translation(const vec3f &delta)
+        : xfm{ 1.f,0.f,0.f, 0.f,1.f,0.f, 0.f,0.f,1.f,
+               delta.x,delta.y,delta.z }
+      {}
+      float xfm[12];
+    };
+
+  } // ::owl::test
+} // ::owl
@@ -0,0 +1,81 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// device programs of the GPU hit tests; see tests/common/HitTest.h
+
+#include "tests/common/HitTest.h"
+#include <optix_device.h>
+
+using namespace owl;
+using namespace owl::test;
+
+extern "C" __constant__ HitTestParams optixLaunchParams;
+
+OPTIX_RAYGEN_PROGRAM(hitTest)()
+{
+  const vec2i pixelID = owl::getLaunchIndex();
+  const HitTestParams &lp = optixLaunchParams;
+  if (pixelID.x >= lp.fbSize.x || pixelID.y >= lp.fbSize.y) return;
+
+  // orthographic rays along +z, one per pixel, over [0,1]^2
+  const vec3f origin((pixelID.x+.5f)/lp.fbSize.x,
+                     (pixelID.y+.5f)/lp.fbSize.y,
+                     -1.f);
+  const vec3f direction(0.f,0.f,1.f);
+  HitRecord hit;
+  unsigned int p0 = 0, p1 = 0;
+  owl::packPointer(&hit,p0,p1);
+  optixTrace(lp.world,
+             (const float3&)origin,
+             (const float3&)direction,
+             0.f,1e10f,0.f,
+             (OptixVisibilityMask)lp.rayMask,
+             OPTIX_RAY_FLAG_NONE,
+             /*SBToffset    */0,
+             /*SBTstride    */1,
+             /*missSBTIndex */0,
+             p0,p1);
+  lp.hits[pixelID.x+lp.fbSize.x*pixelID.y] = hit;
+}
+
+OPTIX_RAYGEN_PROGRAM(writeTag)()
+{
+  const HitTestRayGenData &self = owl::getProgramData<HitTestRayGenData>();
+  if (owl::getLaunchIndex() == vec2i(0))
+    self.out[0].geomTag = self.tag;
+}
+
+OPTIX_CLOSEST_HIT_PROGRAM(hitTestTriangles)()
+{
+  const HitTestGeomData &self = owl::getProgramData<HitTestGeomData>();
+  HitRecord &hit = owl::getPRD<HitRecord>();
+  hit.geomTag     = self.tag;
+  hit.instanceID  = optixGetInstanceId();
+  hit.primID      = optixGetPrimitiveIndex();
+  hit.localPrimID
+    = optixLaunchParams.mergedMeshes
+    ? owl::getPrimitiveIndexInGeom<HitTestGeomData>()
+    : (int)optixGetPrimitiveIndex();
+}
+
+OPTIX_MISS_PROGRAM(hitTestMiss)()
+{
+  HitRecord &hit = owl::getPRD<HitRecord>();
+  hit.geomTag     = -1;
+  hit.instanceID  = -1;
+  hit.primID      = -1;
+  hit.localPrimID = -1;
+}
@@ -20,9 +20,10 @@
 #include "owl/owl.h"
 // our device-side data structures
 #include "GeomTypes.h"
-// external helper stuff for image output
+// external helper stuff for image output, and golden image checks
+#define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "stb/stb_image_write.h"
+#include "tests/common/GoldenImage.h"
 
 #include <random>
 
@@ -253,12 +254,21 @@ int main(int ac, char **av)
                  fb,fbSize.x*sizeof(uint32_t));
   LOG_OK("written rendered frame buffer to file "<<outFileName);
 
+  // compare against the known-good image, if we have one (see
+  // tests/common/GoldenImage.h)
+  const bool matchesGolden
+    = owl::test::checkGolden("t01-manySpheres",fb,fbSize);
+
   // ##################################################################
   // and finally, clean up
   // ##################################################################
   
   LOG("destroying devicegroup ...");
   owlContextDestroy(context);
-  
+
+  if (!matchesGolden) {
+    LOG("rendered frame does not match the golden image");
+    return 1;
+  }
   LOG_OK("seems all went OK; app is done, this should be the last output ...");
 }
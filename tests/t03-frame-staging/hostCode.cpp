@@ -0,0 +1,141 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Tests the (host-only) book-keeping behind frame pipelining: which
+// SBT slot gets written, which one gets launched, and when the
+// owner has to wait for an in-flight launch.
+
+#include "owl/ll/FrameStaging.h"
+// std
+#include <iostream>
+#include <cstdlib>
+
+using owl::ll::FrameStaging;
+
+#define OWL_TEST_NAME "t03"
+#include "tests/common/Check.h"
+
+/*! default mode: one slot, written and launched in place, never any
+    waiting (exactly what OWL did before pipelining) */
+void testNonPipelined()
+{
+  FrameStaging fs;
+  CHECK(!fs.valid());
+  CHECK(!fs.isPipelined());
+
+  for (int frame=0;frame<4;frame++) {
+    const int w = fs.writeSlot();
+    CHECK(w == 0);
+    CHECK(!fs.needsWait(w));
+    fs.commit(w);
+    CHECK(fs.valid());
+    CHECK(fs.acquireForLaunch() == 0);
+    // even with the launch in flight, non-pipelined mode never waits
+    CHECK(!fs.needsWait(fs.writeSlot()));
+  }
+  CHECK(fs.slotVersion(0) == 4);
+  CHECK(fs.slotVersion(1) == 0);
+}
+
+/*! pipelined mode: builds go to the back slot while the front slot is
+    in flight, and launches pick up the newest version */
+void testPipelinedSwap()
+{
+  FrameStaging fs;
+  fs.setPipelined(true);
+
+  // frame 0
+  int w0 = fs.writeSlot();
+  CHECK(w0 == 1);
+  fs.commit(w0);
+  CHECK(fs.acquireForLaunch() == w0);
+  CHECK(fs.frontSlot() == w0);
+
+  // frame 1 is built while frame 0 is still in flight: must go to the
+  // other slot, without waiting
+  int w1 = fs.writeSlot();
+  CHECK(w1 != w0);
+  CHECK(!fs.needsWait(w1));
+  fs.commit(w1);
+  CHECK(fs.slotVersion(w1) > fs.slotVersion(w0));
+  // front doesn't change until the next launch ...
+  CHECK(fs.frontSlot() == w0);
+  // ... which then swaps
+  CHECK(fs.acquireForLaunch() == w1);
+
+  // frame 2 wants to write to w0 again - which frame 0 may still be
+  // reading from
+  int w2 = fs.writeSlot();
+  CHECK(w2 == w0);
+  CHECK(fs.needsWait(w2));
+  fs.retire(w2);
+  CHECK(!fs.needsWait(w2));
+  fs.commit(w2);
+  CHECK(fs.acquireForLaunch() == w2);
+}
+
+/*! launching without any new build must keep using the same slot;
+    several builds between two launches all go to the same back slot */
+void testPipelinedNoRebuild()
+{
+  FrameStaging fs;
+  fs.setPipelined(true);
+  int w = fs.writeSlot();
+  fs.commit(w);
+  CHECK(fs.acquireForLaunch() == w);
+  CHECK(fs.acquireForLaunch() == w);
+  CHECK(fs.acquireForLaunch() == w);
+
+  int b0 = fs.writeSlot();
+  fs.commit(b0);
+  int b1 = fs.writeSlot();
+  CHECK(b1 == b0);
+  CHECK(!fs.needsWait(b1));
+  fs.commit(b1);
+  CHECK(fs.frontSlot() == w);
+  CHECK(fs.acquireForLaunch() == b1);
+}
+
+/*! switching pipelining off must leave us on the newest version, even
+    if that was only built into the back slot */
+void testSwitchModes()
+{
+  FrameStaging fs;
+  fs.commit(fs.writeSlot());
+  fs.acquireForLaunch();
+  CHECK(fs.frontSlot() == 0);
+
+  fs.setPipelined(true);
+  int back = fs.writeSlot();
+  CHECK(back == 1);
+  fs.commit(back);
+  CHECK(fs.frontSlot() == 0);
+
+  fs.setPipelined(false);
+  CHECK(fs.frontSlot() == back);
+  CHECK(fs.writeSlot() == back);
+  CHECK(fs.newestSlot() == back);
+  CHECK(fs.acquireForLaunch() == back);
+}
+
+int main(int ac, char **av)
+{
+  testNonPipelined();
+  testPipelinedSwap();
+  testPipelinedNoRebuild();
+  testSwitchModes();
+  return owl::test::allPassed("frame staging");
+}
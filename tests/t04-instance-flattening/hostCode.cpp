@@ -0,0 +1,289 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Tests the host-side flattening of nested instance groups: the
+// composed transforms of the flat instance list have to match what
+// we get from applying the nested transforms one level at a time.
+
+#include "owl/ll/InstanceFlattening.h"
+// std
+#include <iostream>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <cmath>
+#include <algorithm>
+
+using namespace owl::ll;
+using owl::common::vec3f;
+using owl::common::linear3f;
+
+#define OWL_TEST_NAME "t04"
+#include "tests/common/Check.h"
+
+std::mt19937 rng(0x1234);
+
+float rnd(float lo, float hi)
+{
+  return std::uniform_real_distribution<float>(lo,hi)(rng);
+}
+
+affine3f randomXfm()
+{
+  const linear3f l(vec3f(rnd(-1,1),rnd(-1,1),rnd(-1,1)),
+                   vec3f(rnd(-1,1),rnd(-1,1),rnd(-1,1)),
+                   vec3f(rnd(-1,1),rnd(-1,1),rnd(-1,1)));
+  return affine3f(l,vec3f(rnd(-4,4),rnd(-4,4),rnd(-4,4)));
+}
+
+int addLeaf(std::vector<InstanceNode> &nodes)
+{
+  nodes.push_back(InstanceNode());
+  return (int)nodes.size()-1;
+}
+
+int addGroup(std::vector<InstanceNode> &nodes,
+             const std::vector<int> &children,
+             const std::vector<affine3f> &transforms)
+{
+  InstanceNode node;
+  node.isLeaf     = false;
+  node.children   = children;
+  node.transforms = transforms;
+  nodes.push_back(node);
+  return (int)nodes.size()-1;
+}
+
+/*! reference: the path from the root to a leaf, as a list of
+    (node,childID) steps */
+struct Step { int node; int childID; };
+
+void collectPaths(const std::vector<InstanceNode> &nodes,
+                  int nodeID,
+                  std::vector<Step> &path,
+                  std::vector<std::vector<Step>> &paths)
+{
+  const InstanceNode &node = nodes[nodeID];
+  if (node.isLeaf) {
+    paths.push_back(path);
+    return;
+  }
+  for (int childID=0;childID<(int)node.children.size();childID++) {
+    path.push_back({nodeID,childID});
+    collectPaths(nodes,node.children[childID],path,paths);
+    path.pop_back();
+  }
+}
+
+bool close(const vec3f &a, const vec3f &b)
+{
+  const vec3f d = a - b;
+  const float scale = 1.f + std::max(std::max(fabsf(a.x),fabsf(a.y)),fabsf(a.z));
+  return fabsf(d.x) < 1e-4f*scale
+    &&   fabsf(d.y) < 1e-4f*scale
+    &&   fabsf(d.z) < 1e-4f*scale;
+}
+
+/*! checks the flattened list against a serial reference traversal
+    that transforms a few test points one level at a time (innermost
+    transform first) */
+void checkAgainstReference(const std::vector<InstanceNode> &nodes,
+                           int root,
+                           const std::vector<FlatInstance> &flat)
+{
+  std::vector<std::vector<Step>> paths;
+  std::vector<Step> path;
+  collectPaths(nodes,root,path,paths);
+  CHECK(paths.size() == flat.size());
+
+  const vec3f testPoints[3] = {
+    vec3f(0.f), vec3f(1.f,2.f,3.f), vec3f(-.5f,.25f,7.f)
+  };
+  for (size_t i=0;i<flat.size();i++) {
+    const std::vector<Step> &p = paths[i];
+    const Step &last = p.back();
+    CHECK(flat[i].leaf == nodes[last.node].children[last.childID]);
+    CHECK(flat[i].rootChild == p.front().childID);
+    // masks get and'ed along the path; flags come from the last step
+    uint8_t expectedMask = 255;
+    for (auto &step : p)
+      if (!nodes[step.node].masks.empty())
+        expectedMask &= nodes[step.node].masks[step.childID];
+    CHECK(flat[i].mask == expectedMask);
+    const uint32_t expectedFlags
+      = nodes[last.node].flags.empty()
+      ? 0 : nodes[last.node].flags[last.childID];
+    CHECK(flat[i].flags == expectedFlags);
+    for (auto P : testPoints) {
+      vec3f expected = P;
+      for (int s=(int)p.size()-1;s>=0;--s) {
+        const InstanceNode &node = nodes[p[s].node];
+        if (!node.transforms.empty())
+          expected = xfmPoint(node.transforms[p[s].childID],expected);
+      }
+      CHECK(close(xfmPoint(flat[i].xfm,P),expected));
+    }
+  }
+}
+
+/*! a small, hand-built three-level graph with a shared sub-group */
+void testNested()
+{
+  std::vector<InstanceNode> nodes;
+  const int leaf0 = addLeaf(nodes);
+  const int leaf1 = addLeaf(nodes);
+  const int mid   = addGroup(nodes,{leaf0,leaf1},{randomXfm(),randomXfm()});
+  const int top   = addGroup(nodes,{mid,mid,leaf1},
+                             {randomXfm(),randomXfm(),randomXfm()});
+  const int root  = addGroup(nodes,{leaf0,top},{randomXfm(),randomXfm()});
+
+  const std::vector<FlatInstance> flat = flattenInstanceGraph(nodes,root,100);
+  CHECK(flat.size() == 1+2+2+1);
+  checkAgainstReference(nodes,root,flat);
+  CHECK(flat[0].rootChild == 0 && flat[0].leaf == leaf0);
+  for (size_t i=1;i<flat.size();i++)
+    CHECK(flat[i].rootChild == 1);
+}
+
+/*! groups without transforms default to identity */
+void testIdentityDefaults()
+{
+  std::vector<InstanceNode> nodes;
+  const int leaf  = addLeaf(nodes);
+  const affine3f xfm = randomXfm();
+  const int inner = addGroup(nodes,{leaf},{xfm});
+  const int root  = addGroup(nodes,{inner,leaf},{});
+
+  const std::vector<FlatInstance> flat = flattenInstanceGraph(nodes,root,100);
+  CHECK(flat.size() == 2);
+  checkAgainstReference(nodes,root,flat);
+  CHECK(close(xfmPoint(flat[1].xfm,vec3f(1.f,2.f,3.f)),vec3f(1.f,2.f,3.f)));
+}
+
+/*! a deep, wide graph (3^8 instances) that gets split into many
+    parallel tasks; result has to be identical to the serial
+    reference, in the same order */
+void testDeepGraph()
+{
+  std::vector<InstanceNode> nodes;
+  int level = addLeaf(nodes);
+  for (int depth=0;depth<8;depth++)
+    level = addGroup(nodes,{level,level,level},
+                     {randomXfm(),randomXfm(),randomXfm()});
+  const std::vector<FlatInstance> flat
+    = flattenInstanceGraph(nodes,level,1<<20);
+  CHECK(flat.size() == 3*3*3*3*3*3*3*3);
+  checkAgainstReference(nodes,level,flat);
+}
+
+/*! visibility masks and instance flags on several levels of a graph
+    large enough to get flattened in parallel */
+void testMasksAndFlags()
+{
+  std::vector<InstanceNode> nodes;
+  int level = addLeaf(nodes);
+  for (int depth=0;depth<8;depth++) {
+    level = addGroup(nodes,{level,level,level},{});
+    if (depth % 3 != 1)
+      nodes[level].masks = { 0xff, 0x0f, 0x3c };
+    if (depth % 2 == 0)
+      nodes[level].flags = { 0u, 1u<<depth, 1u<<(depth+8) };
+  }
+  const std::vector<FlatInstance> flat
+    = flattenInstanceGraph(nodes,level,1<<20);
+  CHECK(flat.size() == 3*3*3*3*3*3*3*3);
+  checkAgainstReference(nodes,level,flat);
+
+  // a single-level group's masks and flags go through unchanged
+  std::vector<InstanceNode> single;
+  const int leaf = addLeaf(single);
+  const int root = addGroup(single,{leaf,leaf},{});
+  single[root].masks = { 0x01, 0x80 };
+  single[root].flags = { 4u, 2u };
+  const std::vector<FlatInstance> flatSingle
+    = flattenInstanceGraph(single,root,10);
+  CHECK(flatSingle.size() == 2);
+  CHECK(flatSingle[0].mask == 0x01 && flatSingle[0].flags == 4u);
+  CHECK(flatSingle[1].mask == 0x80 && flatSingle[1].flags == 2u);
+
+  // per-child arrays must match the child count
+  single[root].masks = { 0x01 };
+  bool threw = false;
+  try {
+    flattenInstanceGraph(single,root,10);
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  CHECK(threw);
+}
+
+/*! exceeding the cap throws, hitting it exactly does not */
+void testInstanceCap()
+{
+  std::vector<InstanceNode> nodes;
+  int level = addLeaf(nodes);
+  for (int depth=0;depth<4;depth++)
+    level = addGroup(nodes,{level,level},{});
+  CHECK(flattenInstanceGraph(nodes,level,16).size() == 16);
+  bool threw = false;
+  try {
+    flattenInstanceGraph(nodes,level,15);
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  CHECK(threw);
+}
+
+/*! cyclic graphs cannot be flattened */
+void testCycle()
+{
+  std::vector<InstanceNode> nodes;
+  const int leaf = addLeaf(nodes);
+  const int a    = addGroup(nodes,{leaf},{});
+  const int b    = addGroup(nodes,{a},{});
+  nodes[a].children.push_back(b);
+  bool threw = false;
+  try {
+    flattenInstanceGraph(nodes,b,1000);
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  CHECK(threw);
+}
+
+/*! empty groups contribute nothing */
+void testEmptyGroups()
+{
+  std::vector<InstanceNode> nodes;
+  const int leaf  = addLeaf(nodes);
+  const int empty = addGroup(nodes,{},{});
+  const int root  = addGroup(nodes,{empty,leaf,empty},{});
+  const std::vector<FlatInstance> flat = flattenInstanceGraph(nodes,root,10);
+  CHECK(flat.size() == 1);
+  CHECK(flat[0].leaf == leaf && flat[0].rootChild == 1);
+}
+
+int main(int ac, char **av)
+{
+  testNested();
+  testIdentityDefaults();
+  testDeepGraph();
+  testMasksAndFlags();
+  testInstanceCap();
+  testCycle();
+  testEmptyGroups();
+  return owl::test::allPassed("instance flattening");
+}
@@ -0,0 +1,191 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Tests the host-side partitioning used for automatically splitting
+// groups that exceed optix' per-accel limits, using artificially low
+// limits.
+
+#include "owl/ll/GroupSplitting.h"
+// std
+#include <iostream>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <algorithm>
+
+using namespace owl::ll;
+
+#define OWL_TEST_NAME "t05"
+#include "tests/common/Check.h"
+
+std::mt19937 rng(0x4321);
+
+float rnd(float lo, float hi)
+{
+  return std::uniform_real_distribution<float>(lo,hi)(rng);
+}
+
+/*! checks that the parts cover every instance exactly once, and
+    that none of them exceeds the limit */
+void checkInstanceParts(const std::vector<std::vector<int>> &parts,
+                        size_t numInstances,
+                        size_t maxPerPart)
+{
+  std::vector<int> seen(numInstances,0);
+  for (auto &part : parts) {
+    CHECK(!part.empty());
+    CHECK(part.size() <= maxPerPart);
+    for (auto id : part) {
+      CHECK(id >= 0 && id < (int)numInstances);
+      seen[id]++;
+    }
+  }
+  for (auto s : seen)
+    CHECK(s == 1);
+}
+
+/*! random instances get split into the minimum number of parts */
+void testInstancesWithinLimit()
+{
+  for (size_t maxPerPart : { 1, 7, 64, 100, 1000, 5000 }) {
+    std::vector<vec3f> positions(1000);
+    for (auto &p : positions)
+      p = vec3f(rnd(-10,10),rnd(-10,10),rnd(-10,10));
+    const std::vector<std::vector<int>> parts
+      = partitionInstances(positions,maxPerPart);
+    checkInstanceParts(parts,positions.size(),maxPerPart);
+    CHECK(parts.size() == (positions.size()+maxPerPart-1)/maxPerPart);
+  }
+}
+
+/*! instances in well-separated clusters must not get mixed up
+    across parts when each cluster fits exactly into one part */
+void testInstancesSpatiallyCoherent()
+{
+  const int    numClusters = 8;
+  const size_t perCluster  = 50;
+  std::vector<vec3f> positions;
+  std::vector<int>   clusterOf;
+  for (int c=0;c<numClusters;c++) {
+    const vec3f center(100.f*(c&1),100.f*((c>>1)&1),100.f*((c>>2)&1));
+    for (size_t i=0;i<perCluster;i++) {
+      positions.push_back(center+vec3f(rnd(-1,1),rnd(-1,1),rnd(-1,1)));
+      clusterOf.push_back(c);
+    }
+  }
+  const std::vector<std::vector<int>> parts
+    = partitionInstances(positions,perCluster);
+  checkInstanceParts(parts,positions.size(),perCluster);
+  CHECK(parts.size() == numClusters);
+  for (auto &part : parts)
+    for (auto id : part)
+      CHECK(clusterOf[id] == clusterOf[part[0]]);
+}
+
+/*! degenerate inputs: nothing to split, everything at the same
+    position, and an invalid limit */
+void testInstancesDegenerate()
+{
+  CHECK(partitionInstances({},16).empty());
+  
+  std::vector<vec3f> samePos(33,vec3f(1.f,2.f,3.f));
+  const std::vector<std::vector<int>> parts = partitionInstances(samePos,8);
+  checkInstanceParts(parts,samePos.size(),8);
+  CHECK(parts.size() == 5);
+
+  bool threw = false;
+  try {
+    partitionInstances(samePos,0);
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  CHECK(threw);
+}
+
+/*! checks all the properties geom group splitting relies on: every
+    prim of every child is covered exactly once, parts stay within the
+    limit, and the children of each part are consecutive (so the
+    part's SBT offset is that of its first child) */
+void checkPrimParts(const std::vector<std::vector<PrimRange>> &parts,
+                    const std::vector<size_t> &primCounts,
+                    size_t maxPerPart)
+{
+  CHECK(!parts.empty());
+  std::vector<size_t> nextPrim(primCounts.size(),0);
+  for (auto &part : parts) {
+    size_t numPrims = 0;
+    for (size_t i=0;i<part.size();i++) {
+      const PrimRange &range = part[i];
+      CHECK(range.child == part[0].child + (int)i);
+      CHECK(range.begin <= range.end);
+      CHECK(range.begin == nextPrim[range.child]);
+      CHECK(range.end   <= primCounts[range.child]);
+      nextPrim[range.child] = range.end;
+      numPrims += range.end - range.begin;
+    }
+    CHECK(numPrims <= maxPerPart);
+  }
+  for (size_t child=0;child<primCounts.size();child++)
+    CHECK(nextPrim[child] == primCounts[child]);
+}
+
+void testPrimRanges()
+{
+  const std::vector<size_t> primCounts = { 5, 0, 12, 3, 0, 1, 30 };
+  size_t sumPrims = 0;
+  for (auto c : primCounts) sumPrims += c;
+  for (size_t maxPerPart : { 1, 2, 8, 13, 51, 1000 }) {
+    const std::vector<std::vector<PrimRange>> parts
+      = partitionPrimRanges(primCounts,maxPerPart);
+    checkPrimParts(parts,primCounts,maxPerPart);
+    CHECK(parts.size() == std::max(size_t(1),(sumPrims+maxPerPart-1)/maxPerPart));
+  }
+
+  // a single huge geom (eg, a point cloud) gets split into prim
+  // ranges of the same geom
+  const std::vector<std::vector<PrimRange>> parts
+    = partitionPrimRanges({ 1000 },64);
+  checkPrimParts(parts,{ 1000 },64);
+  CHECK(parts.size() == 16);
+  for (auto &part : parts)
+    CHECK(part.size() == 1 && part[0].child == 0);
+}
+
+void testPrimRangesDegenerate()
+{
+  // no children still gives one (empty) part to build
+  const std::vector<std::vector<PrimRange>> parts
+    = partitionPrimRanges({},16);
+  CHECK(parts.size() == 1 && parts[0].empty());
+
+  bool threw = false;
+  try {
+    partitionPrimRanges({ 3 },0);
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  CHECK(threw);
+}
+
+int main(int ac, char **av)
+{
+  testInstancesWithinLimit();
+  testInstancesSpatiallyCoherent();
+  testInstancesDegenerate();
+  testPrimRanges();
+  testPrimRangesDegenerate();
+  return owl::test::allPassed("group splitting");
+}
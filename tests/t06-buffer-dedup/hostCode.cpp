@@ -0,0 +1,172 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Tests the host-side logic behind buffer deduplication: the content
+// hash, and the table that shares allocations between buffers with
+// identical contents.
+
+#include "owl/ll/BufferDedup.h"
+// std
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace owl::ll;
+
+#define OWL_TEST_NAME "t06"
+#include "tests/common/Check.h"
+
+std::vector<uint8_t> randomBytes(size_t numBytes, uint32_t seed)
+{
+  std::mt19937 rng(seed);
+  std::vector<uint8_t> bytes(numBytes);
+  for (auto &b : bytes) b = (uint8_t)rng();
+  return bytes;
+}
+
+/*! same contents always hash the same, no matter where in memory
+    they are (or how they're aligned) */
+void testHashDeterministic()
+{
+  for (size_t numBytes : { 0, 1, 7, 8, 31, 32, 33, 1000, 300*1000, 3000*1000 }) {
+    const std::vector<uint8_t> bytes = randomBytes(numBytes,(uint32_t)numBytes);
+    const uint64_t h = contentHash64(bytes.data(),numBytes);
+    CHECK(contentHash64(bytes.data(),numBytes) == h);
+    
+    std::vector<uint8_t> shifted(numBytes+3);
+    memcpy(shifted.data()+3,bytes.data(),numBytes);
+    CHECK(contentHash64(shifted.data()+3,numBytes) == h);
+  }
+}
+
+/*! changing any single byte (also in the tail, and in chunks other
+    than the first) has to change the hash; and so does the size */
+void testHashSensitivity()
+{
+  const size_t numBytes = 1000*1000+13;
+  std::vector<uint8_t> bytes = randomBytes(numBytes,42);
+  const uint64_t h = contentHash64(bytes.data(),numBytes);
+  
+  std::set<uint64_t> seen;
+  seen.insert(h);
+  for (size_t pos : { size_t(0), size_t(1), size_t(31), size_t(32),
+        size_t(256*1024-1), size_t(256*1024), numBytes/2,
+        numBytes-9, numBytes-1 }) {
+    bytes[pos] ^= 1;
+    const uint64_t hFlipped = contentHash64(bytes.data(),numBytes);
+    bytes[pos] ^= 1;
+    CHECK(seen.find(hFlipped) == seen.end());
+    seen.insert(hFlipped);
+  }
+  CHECK(contentHash64(bytes.data(),numBytes) == h);
+  CHECK(contentHash64(bytes.data(),numBytes-1) != h);
+
+  // all-zero buffers of different sizes must not collide either
+  std::vector<uint8_t> zeros(1000,0);
+  CHECK(contentHash64(zeros.data(),999) != contentHash64(zeros.data(),1000));
+}
+
+/*! no collisions among many small, similar buffers (eg, thousands
+    of tiny meshes that only differ by a few vertices) */
+void testHashNoCollisions()
+{
+  std::set<uint64_t> seen;
+  std::vector<float> vertices(12,0.f);
+  for (int i=0;i<100000;i++) {
+    vertices[i % 12] += 1.f;
+    seen.insert(contentHash64(vertices.data(),vertices.size()*sizeof(float)));
+  }
+  CHECK(seen.size() == 100000);
+}
+
+struct FakeAllocation { int id; };
+
+void testTableSharing()
+{
+  ContentDedupTable<FakeAllocation> table;
+  CHECK(table.find(123,100) == nullptr);
+
+  auto a = std::make_shared<FakeAllocation>();
+  table.insert(123,100,a);
+  CHECK(table.find(123,100) == a);
+  CHECK(table.find(123,100) == a);
+  CHECK(table.bytesSaved == 200);
+  CHECK(table.numDeduped == 2);
+  
+  // same hash but different size is different content
+  CHECK(table.find(123,101) == nullptr);
+  CHECK(table.find(124,100) == nullptr);
+  CHECK(table.bytesSaved == 200);
+}
+
+/*! the table must not keep allocations alive by itself */
+void testTableExpiry()
+{
+  ContentDedupTable<FakeAllocation> table;
+  std::weak_ptr<FakeAllocation> weak;
+  {
+    auto a = std::make_shared<FakeAllocation>();
+    weak = a;
+    table.insert(7,64,a);
+    std::shared_ptr<FakeAllocation> b = table.find(7,64);
+    CHECK(b == a);
+    a = nullptr;
+    // still alive through 'b'
+    CHECK(table.find(7,64) == b);
+  }
+  CHECK(weak.expired());
+  CHECK(table.find(7,64) == nullptr);
+  CHECK(table.size() == 0);
+
+  // and a new allocation with the same contents can take its place
+  auto c = std::make_shared<FakeAllocation>();
+  table.insert(7,64,c);
+  CHECK(table.find(7,64) == c);
+}
+
+/*! with a verification predicate, a (hash,size) match that does
+    not really hold the same contents must neither be returned nor
+    count as saved */
+void testTableVerification()
+{
+  ContentDedupTable<FakeAllocation> table;
+  auto a = std::make_shared<FakeAllocation>();
+  a->id = 1;
+  table.insert(5,32,a);
+  auto holds = [](int id) {
+    return [id](const FakeAllocation &alloc) { return alloc.id == id; };
+  };
+  CHECK(table.find(5,32,holds(2)) == nullptr);
+  CHECK(table.bytesSaved == 0);
+  CHECK(table.numDeduped == 0);
+  CHECK(table.find(5,32,holds(1)) == a);
+  CHECK(table.bytesSaved == 32);
+  CHECK(table.numDeduped == 1);
+}
+
+int main(int ac, char **av)
+{
+  testHashDeterministic();
+  testHashSensitivity();
+  testHashNoCollisions();
+  testTableSharing();
+  testTableExpiry();
+  testTableVerification();
+  return owl::test::allPassed("buffer dedup");
+}
@@ -0,0 +1,234 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Tests the host-side logic for merging many small triangle meshes
+// into shared build inputs: which children get merged, and whether
+// the merged arrays and remap tables lead back to the original
+// meshes' triangles.
+
+#include "owl/ll/MeshMerging.h"
+// std
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+using namespace owl::ll;
+
+#define OWL_TEST_NAME "t07"
+#include "tests/common/Check.h"
+
+std::mt19937 rng(0x7007);
+
+int rndInt(int lo, int hi)
+{
+  return std::uniform_int_distribution<int>(lo,hi)(rng);
+}
+
+/*! checks that the runs cover all children exactly once, in order */
+void checkRunsCoverChildren(const std::vector<MeshRun> &runs,
+                            size_t numChildren)
+{
+  int next = 0;
+  for (auto &run : runs) {
+    CHECK(run.numChildren >= 1);
+    CHECK(run.firstChild == next);
+    next += run.numChildren;
+  }
+  CHECK(next == (int)numChildren);
+}
+
+void testPlanning()
+{
+  // no children, no runs
+  CHECK(planMeshMerging({},{},12,1000).empty());
+
+  // all small, same type: a single run
+  {
+    std::vector<size_t> counts(10,12);
+    std::vector<int>    types(10,0);
+    auto runs = planMeshMerging(counts,types,12,1000);
+    CHECK(runs.size() == 1);
+    checkRunsCoverChildren(runs,counts.size());
+  }
+  // large children break runs, and don't get merged themselves
+  {
+    std::vector<size_t> counts = { 12, 12, 500, 12, 600, 700, 12, 12, 12 };
+    std::vector<int>    types(counts.size(),0);
+    auto runs = planMeshMerging(counts,types,12,1000);
+    checkRunsCoverChildren(runs,counts.size());
+    CHECK(runs.size() == 6);
+    CHECK(runs[0].numChildren == 2);
+    CHECK(runs[1].firstChild == 2 && runs[1].numChildren == 1);
+    CHECK(runs[2].firstChild == 3 && runs[2].numChildren == 1);
+    CHECK(runs[3].firstChild == 4 && runs[3].numChildren == 1);
+    CHECK(runs[4].firstChild == 5 && runs[4].numChildren == 1);
+    CHECK(runs[5].firstChild == 6 && runs[5].numChildren == 3);
+  }
+  // different geom types never end up in the same run
+  {
+    std::vector<size_t> counts(6,2);
+    std::vector<int>    types = { 0, 0, 1, 1, 1, 0 };
+    auto runs = planMeshMerging(counts,types,12,1000);
+    checkRunsCoverChildren(runs,counts.size());
+    CHECK(runs.size() == 3);
+    for (auto &run : runs)
+      for (int i=0;i<run.numChildren;i++)
+        CHECK(types[run.firstChild+i] == types[run.firstChild]);
+  }
+  // runs are limited in size
+  {
+    std::vector<size_t> counts(100,10);
+    std::vector<int>    types(100,0);
+    auto runs = planMeshMerging(counts,types,12,35);
+    checkRunsCoverChildren(runs,counts.size());
+    for (auto &run : runs)
+      CHECK(run.numChildren*10 <= 35);
+    CHECK(runs.size() == 34);
+  }
+  // randomized: cover, type, threshold and size-limit properties
+  for (int rep=0;rep<100;rep++) {
+    const size_t numChildren = rndInt(0,200);
+    std::vector<size_t> counts(numChildren);
+    std::vector<int>    types(numChildren);
+    for (size_t i=0;i<numChildren;i++) {
+      counts[i] = rndInt(0,40);
+      types[i]  = rndInt(0,2);
+    }
+    const size_t threshold = rndInt(0,30);
+    const size_t maxRun    = rndInt(1,100);
+    auto runs = planMeshMerging(counts,types,threshold,maxRun);
+    checkRunsCoverChildren(runs,numChildren);
+    for (auto &run : runs) {
+      if (run.numChildren == 1) continue;
+      size_t sum = 0;
+      for (int i=0;i<run.numChildren;i++) {
+        const int child = run.firstChild+i;
+        CHECK(counts[child] <= threshold);
+        CHECK(types[child] == types[run.firstChild]);
+        sum += counts[child];
+      }
+      CHECK(sum <= maxRun);
+    }
+  }
+}
+
+/*! a test mesh, stored with arbitrary (padded) strides */
+struct TestMesh {
+  size_t vertexStride, indexStride;
+  size_t vertexCount, indexCount;
+  std::vector<uint8_t> vertices, indices;
+
+  TestMesh(size_t vertexCount, size_t indexCount,
+           size_t vertexStride, size_t indexStride)
+    : vertexStride(vertexStride), indexStride(indexStride),
+      vertexCount(vertexCount), indexCount(indexCount),
+      vertices(vertexCount*vertexStride), indices(indexCount*indexStride)
+  {
+    for (size_t i=0;i<vertexCount;i++) {
+      float v[3] = { (float)rndInt(-1000,1000),
+                     (float)rndInt(-1000,1000),
+                     (float)rndInt(-1000,1000) };
+      memcpy(vertices.data()+i*vertexStride,v,sizeof(v));
+    }
+    for (size_t i=0;i<indexCount;i++) {
+      int idx[3] = { rndInt(0,(int)vertexCount-1),
+                     rndInt(0,(int)vertexCount-1),
+                     rndInt(0,(int)vertexCount-1) };
+      memcpy(indices.data()+i*indexStride,idx,sizeof(idx));
+    }
+  }
+  MeshView view() const
+  {
+    return { vertices.data(), vertexStride, vertexCount,
+             indices.data(), indexStride, indexCount };
+  }
+  vec3f vertex(int i) const
+  {
+    float v[3];
+    memcpy(v,vertices.data()+i*vertexStride,sizeof(v));
+    return vec3f(v[0],v[1],v[2]);
+  }
+  vec3i index(size_t i) const
+  {
+    int idx[3];
+    memcpy(idx,indices.data()+i*indexStride,sizeof(idx));
+    return vec3i(idx[0],idx[1],idx[2]);
+  }
+};
+
+void testMerging()
+{
+  // empty input
+  {
+    MergedMesh merged = mergeMeshes({});
+    CHECK(merged.vertices.empty() && merged.indices.empty());
+  }
+  for (int rep=0;rep<20;rep++) {
+    std::vector<TestMesh> meshes;
+    const int numMeshes = rndInt(1,300);
+    for (int i=0;i<numMeshes;i++) {
+      const int numVertices = rndInt(0,4) == 0 ? 0 : rndInt(1,24);
+      meshes.push_back(TestMesh(numVertices,
+                                numVertices ? rndInt(0,12) : 0,
+                                rndInt(0,1) ? 12 : 16+4*rndInt(0,3),
+                                rndInt(0,1) ? 12 : 16+4*rndInt(0,3)));
+    }
+    std::vector<MeshView> views;
+    size_t numPrims = 0, numVertices = 0;
+    for (auto &mesh : meshes) {
+      views.push_back(mesh.view());
+      numPrims    += mesh.indexCount;
+      numVertices += mesh.vertexCount;
+    }
+    MergedMesh merged = mergeMeshes(views);
+    CHECK(merged.vertices.size()    == numVertices);
+    CHECK(merged.indices.size()     == numPrims);
+    CHECK(merged.meshOfPrim.size()  == numPrims);
+    CHECK(merged.primBegin.size()   == meshes.size());
+    CHECK(merged.vertexBegin.size() == meshes.size());
+
+    // every merged triangle maps back to its original triangle -
+    // same vertex positions, and the SBT index offset selects its
+    // original mesh
+    for (size_t primID=0;primID<numPrims;primID++) {
+      const uint32_t meshID = merged.meshOfPrim[primID];
+      CHECK(meshID < meshes.size());
+      const TestMesh &mesh = meshes[meshID];
+      CHECK(primID >= merged.primBegin[meshID]);
+      const size_t local = primID - merged.primBegin[meshID];
+      CHECK(local < mesh.indexCount);
+
+      const vec3i orgIndex = mesh.index(local);
+      const vec3i newIndex = merged.indices[primID];
+      CHECK(newIndex == orgIndex + vec3i((int)merged.vertexBegin[meshID]));
+      CHECK(merged.vertices[newIndex.x] == mesh.vertex(orgIndex.x));
+      CHECK(merged.vertices[newIndex.y] == mesh.vertex(orgIndex.y));
+      CHECK(merged.vertices[newIndex.z] == mesh.vertex(orgIndex.z));
+    }
+    // ... and each mesh's prims are one contiguous range, in order
+    for (size_t meshID=0;meshID<meshes.size();meshID++)
+      for (size_t i=0;i<meshes[meshID].indexCount;i++)
+        CHECK(merged.meshOfPrim[merged.primBegin[meshID]+i] == meshID);
+  }
+}
+
+int main(int ac, char **av)
+{
+  testPlanning();
+  testMerging();
+  return owl::test::allPassed("mesh merging");
+}
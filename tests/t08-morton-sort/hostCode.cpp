@@ -0,0 +1,161 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Tests the morton code generation and radix sort used for spatially
+// sorting instances before building an instance accel.
+
+#include "owl/ll/MortonSort.h"
+// std
+#include <iostream>
+#include <cstdlib>
+#include <random>
+#include <algorithm>
+
+using namespace owl::ll;
+
+#define OWL_TEST_NAME "t08"
+#include "tests/common/Check.h"
+
+std::mt19937_64 rng(0x8008);
+
+float rnd(float lo, float hi)
+{
+  return std::uniform_real_distribution<float>(lo,hi)(rng);
+}
+
+/*! checks that 'order' is a permutation of [0,n) */
+void checkIsPermutation(const std::vector<uint32_t> &order, size_t n)
+{
+  CHECK(order.size() == n);
+  std::vector<int> seen(n,0);
+  for (auto i : order) {
+    CHECK(i < n);
+    seen[i]++;
+  }
+  for (auto s : seen)
+    CHECK(s == 1);
+}
+
+void testMortonCodes()
+{
+  const box3f unit(vec3f(0.f),vec3f(1.f));
+  CHECK(mortonCode63(vec3f(0.f),unit) == 0);
+  // all 63 bits set in the far corner
+  CHECK(mortonCode63(vec3f(1.f),unit) == (1ULL<<63)-1);
+  // x goes into the highest bit of each triple
+  CHECK(mortonCode63(vec3f(1.f,0.f,0.f),unit) == 0x4924924924924924ULL);
+  CHECK(mortonCode63(vec3f(0.f,1.f,0.f),unit) == 0x2492492492492492ULL);
+  CHECK(mortonCode63(vec3f(0.f,0.f,1.f),unit) == 0x1249249249249249ULL);
+  // points outside get clamped
+  CHECK(mortonCode63(vec3f(-5.f),unit) == 0);
+  CHECK(mortonCode63(vec3f(5.f),unit) == (1ULL<<63)-1);
+  // degenerate (flat) bounds don't produce garbage
+  const box3f flat(vec3f(0.f,0.f,2.f),vec3f(1.f,1.f,2.f));
+  CHECK(mortonCode63(vec3f(0.f,0.f,2.f),flat) == 0);
+  CHECK(mortonCode63(vec3f(1.f,1.f,2.f),flat) == 0x6db6db6db6db6db6ULL);
+  // the top-level octants come in z-order
+  for (int i=0;i<8;i++) {
+    const vec3f p((i&4)?.75f:.25f,(i&2)?.75f:.25f,(i&1)?.75f:.25f);
+    CHECK((mortonCode63(p,unit) >> 60) == (uint64_t)i);
+  }
+}
+
+void testRadixSort()
+{
+  CHECK(radixSortOrder({}).empty());
+  CHECK(radixSortOrder({ 42 }) == std::vector<uint32_t>({ 0 }));
+  
+  for (size_t n : { 2, 100, 12345, 300000 }) {
+    for (int bits : { 4, 20, 63 }) {
+      std::vector<uint64_t> keys(n);
+      for (auto &key : keys)
+        key = rng() & ((1ULL<<bits)-1);
+      const std::vector<uint32_t> order = radixSortOrder(keys);
+      checkIsPermutation(order,n);
+
+      // same as a (stable) reference sort, including the order of
+      // equal keys
+      std::vector<uint32_t> reference(n);
+      for (size_t i=0;i<n;i++) reference[i] = (uint32_t)i;
+      std::stable_sort(reference.begin(),reference.end(),
+                       [&](uint32_t a, uint32_t b){ return keys[a] < keys[b]; });
+      CHECK(order == reference);
+    }
+  }
+  // all-equal keys keep their order
+  {
+    std::vector<uint64_t> keys(100000,0x1234567890ULL);
+    const std::vector<uint32_t> order = radixSortOrder(keys);
+    for (size_t i=0;i<order.size();i++)
+      CHECK(order[i] == i);
+  }
+}
+
+void testMortonOrder()
+{
+  CHECK(mortonOrder({}).empty());
+  
+  // a regular 8^3 grid, shuffled: neighbours in the sorted order are
+  // (mostly) neighbours in space, and the order is a z-curve
+  {
+    std::vector<vec3f> points;
+    for (int z=0;z<8;z++)
+      for (int y=0;y<8;y++)
+        for (int x=0;x<8;x++)
+          points.push_back(vec3f((float)x,(float)y,(float)z));
+    std::shuffle(points.begin(),points.end(),rng);
+    const std::vector<uint32_t> order = mortonOrder(points);
+    checkIsPermutation(order,points.size());
+    // each aligned block of 8 consecutive points is one 2^3 cell
+    for (size_t begin=0;begin<order.size();begin+=8) {
+      box3f cell;
+      for (size_t i=begin;i<begin+8;i++)
+        cell.extend(points[order[i]]);
+      CHECK(cell.span() == vec3f(1.f));
+      CHECK(int(cell.lower.x) % 2 == 0);
+      CHECK(int(cell.lower.y) % 2 == 0);
+      CHECK(int(cell.lower.z) % 2 == 0);
+    }
+  }
+  // random points: sorted keys come out non-decreasing
+  {
+    std::vector<vec3f> points(200000);
+    for (auto &p : points)
+      p = vec3f(rnd(-1000.f,1000.f),rnd(0.f,1.f),rnd(-5.f,5.f));
+    const std::vector<uint32_t> order = mortonOrder(points);
+    checkIsPermutation(order,points.size());
+    box3f bounds;
+    for (auto &p : points) bounds.extend(p);
+    for (size_t i=1;i<order.size();i++)
+      CHECK(mortonCode63(points[order[i-1]],bounds)
+            <= mortonCode63(points[order[i]],bounds));
+  }
+  // all-identical points keep their input order
+  {
+    std::vector<vec3f> points(1000,vec3f(3.f,4.f,5.f));
+    const std::vector<uint32_t> order = mortonOrder(points);
+    for (size_t i=0;i<order.size();i++)
+      CHECK(order[i] == i);
+  }
+}
+
+int main(int ac, char **av)
+{
+  testMortonCodes();
+  testRadixSort();
+  testMortonOrder();
+  return owl::test::allPassed("morton sort");
+}
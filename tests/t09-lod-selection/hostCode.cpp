@@ -0,0 +1,124 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Tests the host-side level-of-detail selection used by
+// owlInstanceGroupSelectLOD: which level gets picked for a given
+// distance and error threshold, and that only changed children get
+// reported.
+
+#include "owl/ll/LODSelection.h"
+// std
+#include <iostream>
+#include <cstdlib>
+#include <random>
+
+using namespace owl::ll;
+
+#define OWL_TEST_NAME "t09"
+#include "tests/common/Check.h"
+
+std::mt19937 rng(0x9009);
+
+float rnd(float lo, float hi)
+{
+  return std::uniform_real_distribution<float>(lo,hi)(rng);
+}
+
+void testSingleLevel()
+{
+  const std::vector<float> errors = { 0.f, 1.f, 4.f, 16.f };
+  // close up, or with zero threshold: always the finest level
+  CHECK(selectLODLevel(errors,0.f,1.f,.01f) == 0);
+  CHECK(selectLODLevel(errors,1e6f,1.f,0.f) == 0);
+  // error/distance of level k within threshold .01 requires
+  // distance >= 100*error
+  CHECK(selectLODLevel(errors,99.f,1.f,.01f) == 0);
+  CHECK(selectLODLevel(errors,100.f,1.f,.01f) == 1);
+  CHECK(selectLODLevel(errors,399.f,1.f,.01f) == 1);
+  CHECK(selectLODLevel(errors,400.f,1.f,.01f) == 2);
+  CHECK(selectLODLevel(errors,1600.f,1.f,.01f) == 3);
+  CHECK(selectLODLevel(errors,1e9f,1.f,.01f) == 3);
+  // scaled-up instances have larger errors, so switch later
+  CHECK(selectLODLevel(errors,400.f,2.f,.01f) == 1);
+  CHECK(selectLODLevel(errors,800.f,2.f,.01f) == 2);
+  // a set with only one level never changes
+  CHECK(selectLODLevel({ 5.f },1e9f,1.f,1.f) == 0);
+}
+
+void testSelectChangedOnly()
+{
+  const std::vector<std::vector<float>> lodSetErrors = {
+    { 0.f, 1.f, 2.f },
+    { 0.f, 10.f }
+  };
+  const size_t numChildren = 100000;
+  std::vector<LODChild> children(numChildren);
+  for (size_t i=0;i<numChildren;i++) {
+    children[i].lodSet   = (i % 7 == 0) ? -1 : (int)(i % 2);
+    children[i].position = vec3f(rnd(-1000.f,1000.f),
+                                 rnd(-1000.f,1000.f),
+                                 rnd(-1000.f,1000.f));
+    children[i].scale    = rnd(.5f,2.f);
+  }
+  std::vector<int> levels(numChildren,0);
+
+  // first selection: everything that is not at level 0 is reported,
+  // in order, and levels match a per-child reference
+  const vec3f camera0(0.f);
+  const float threshold = .01f;
+  std::vector<int> changed = selectLODs(children,lodSetErrors,camera0,
+                                        threshold,levels);
+  size_t numNonZero = 0;
+  for (size_t i=0;i<numChildren;i++) {
+    const LODChild &c = children[i];
+    if (c.lodSet < 0) {
+      CHECK(levels[i] == 0);
+      continue;
+    }
+    const int expected
+      = selectLODLevel(lodSetErrors[c.lodSet],
+                       length(c.position-camera0),c.scale,threshold);
+    CHECK(levels[i] == expected);
+    if (expected != 0) numNonZero++;
+  }
+  CHECK(changed.size() == numNonZero);
+  CHECK(numNonZero > 0);
+  for (size_t i=1;i<changed.size();i++)
+    CHECK(changed[i-1] < changed[i]);
+
+  // same camera again: nothing changes
+  CHECK(selectLODs(children,lodSetErrors,camera0,threshold,levels).empty());
+
+  // moved camera: exactly the children whose level differs get reported
+  const std::vector<int> before = levels;
+  const vec3f camera1(500.f,-200.f,50.f);
+  changed = selectLODs(children,lodSetErrors,camera1,threshold,levels);
+  std::vector<char> isChanged(numChildren,0);
+  for (auto c : changed) {
+    CHECK(c >= 0 && c < (int)numChildren);
+    CHECK(!isChanged[c]);
+    isChanged[c] = 1;
+  }
+  for (size_t i=0;i<numChildren;i++)
+    CHECK((levels[i] != before[i]) == (isChanged[i] != 0));
+}
+
+int main(int ac, char **av)
+{
+  testSingleLevel();
+  testSelectChangedOnly();
+  return owl::test::allPassed("LOD selection");
+}
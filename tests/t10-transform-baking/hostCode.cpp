@@ -0,0 +1,182 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Tests the host-side logic behind owlInstanceGroupSetTransformBaking:
+// which groups the planner decides to bake under the various limits,
+// that the (SIMD) point transform matches the scalar one, and that
+// baking instances produces the right world-space vertices, rebased
+// indices, and per-triangle SBT indices.
+
+#include "owl/ll/TransformBaking.h"
+// std
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <random>
+
+using namespace owl::ll;
+using owl::common::linear3f;
+
+#define OWL_TEST_NAME "t10"
+#include "tests/common/Check.h"
+
+std::mt19937 rng(0x1010);
+
+float rnd(float lo, float hi)
+{
+  return std::uniform_real_distribution<float>(lo,hi)(rng);
+}
+
+affine3f randomTransform()
+{
+  return affine3f(vec3f(rnd(-2,2),rnd(-2,2),rnd(-2,2)),
+                  vec3f(rnd(-2,2),rnd(-2,2),rnd(-2,2)),
+                  vec3f(rnd(-2,2),rnd(-2,2),rnd(-2,2)),
+                  vec3f(rnd(-100,100),rnd(-100,100),rnd(-100,100)));
+}
+
+bool close(const vec3f &a, const vec3f &b)
+{
+  return fabsf(a.x-b.x) <= 1e-4f*(1.f+fabsf(b.x))
+    &&   fabsf(a.y-b.y) <= 1e-4f*(1.f+fabsf(b.y))
+    &&   fabsf(a.z-b.z) <= 1e-4f*(1.f+fabsf(b.z));
+}
+
+void testPlan()
+{
+  // three groups: small, small, and one too large
+  const std::vector<size_t> tris  = { 12, 100, 5000 };
+  const std::vector<size_t> verts = {  8,  60, 3000 };
+  // group 1 is used first; -1 is an instance that can't be baked
+  const std::vector<int> instances = { 1, 0, -1, 0, 2, 1, 0 };
+  const size_t unlimited = size_t(-1);
+
+  std::vector<bool> bake
+    = planTransformBaking(tris,verts,instances,1000,unlimited,
+                          unlimited,unlimited);
+  CHECK(bake.size() == 3);
+  CHECK(bake[0] && bake[1] && !bake[2]);
+
+  // instance count limit: group 0 has three instances
+  bake = planTransformBaking(tris,verts,instances,1000,2,
+                             unlimited,unlimited);
+  CHECK(!bake[0] && bake[1] && !bake[2]);
+
+  // memory budget: only room for group 1 (considered first)
+  const size_t bytes1 = 2*bakedBytesPerInstance(100,60);
+  const size_t bytes0 = 3*bakedBytesPerInstance(12,8);
+  bake = planTransformBaking(tris,verts,instances,1000,unlimited,
+                             bytes1,unlimited);
+  CHECK(!bake[0] && bake[1] && !bake[2]);
+  // ... but a group that comes later can still fill what's left
+  bake = planTransformBaking(tris,verts,instances,1000,unlimited,
+                             bytes1+bytes0,unlimited);
+  CHECK(bake[0] && bake[1] && !bake[2]);
+  bake = planTransformBaking(tris,verts,instances,1000,unlimited,
+                             bytes0,unlimited);
+  CHECK(bake[0] && !bake[1] && !bake[2]);
+
+  // total triangle limit
+  bake = planTransformBaking(tris,verts,instances,1000,unlimited,
+                             unlimited,200);
+  CHECK(!bake[0] && bake[1] && !bake[2]);
+
+  // unused groups never get baked
+  bake = planTransformBaking(tris,verts,{ -1, -1 },1000,unlimited,
+                             unlimited,unlimited);
+  CHECK(!bake[0] && !bake[1] && !bake[2]);
+}
+
+void testTransformPoints()
+{
+  // strided input (with some padding between points), and enough
+  // points to cover the last-element path
+  for (size_t count : { 0, 1, 2, 7, 1000 }) {
+    const size_t stride = 5*sizeof(float);
+    std::vector<float> in(count*5);
+    for (auto &f : in) f = rnd(-10,10);
+    const affine3f xfm = randomTransform();
+    // one guard element past the end, which must not get touched
+    std::vector<vec3f> out(count+1,vec3f(-42.f));
+    transformPoints(xfm,in.data(),stride,count,out.data());
+    for (size_t i=0;i<count;i++)
+      CHECK(close(out[i],xfmPoint(xfm,vec3f(in[5*i],in[5*i+1],in[5*i+2]))));
+    CHECK(out[count].x == -42.f && out[count].y == -42.f
+          && out[count].z == -42.f);
+  }
+}
+
+void testBake()
+{
+  // two groups: a single-triangle mesh, and a group with two meshes
+  // (a quad and a triangle), with non-trivial strides
+  std::vector<float> triVerts  = { 0,0,0, 1,0,0, 0,1,0 };
+  std::vector<int>   triIdx    = { 0,1,2 };
+  std::vector<float> quadVerts = { 0,0,0,-1, 1,0,0,-1, 1,1,0,-1, 0,1,0,-1 };
+  std::vector<int>   quadIdx   = { 0,1,2,7, 0,2,3,7 };
+
+  std::vector<std::vector<BakeMesh>> groups(2);
+  groups[0].push_back({ { triVerts.data(),  3*sizeof(float), 3,
+                          triIdx.data(),    3*sizeof(int),   1 }, 5 });
+  groups[1].push_back({ { quadVerts.data(), 4*sizeof(float), 4,
+                          quadIdx.data(),   4*sizeof(int),   2 }, 7 });
+  groups[1].push_back({ { triVerts.data(),  3*sizeof(float), 3,
+                          triIdx.data(),    3*sizeof(int),   1 }, 8 });
+
+  std::vector<BakeInstance> instances;
+  for (int i=0;i<100;i++)
+    instances.push_back({ i%3 == 0 ? 0 : 1, randomTransform() });
+
+  const BakedGeometry baked = bakeInstances(groups,instances);
+  size_t vertexPos = 0, triPos = 0;
+  for (auto &inst : instances) {
+    for (auto &bm : groups[inst.group]) {
+      const float *v = (const float *)bm.mesh.vertices;
+      const size_t vstride = bm.mesh.vertexStride/sizeof(float);
+      for (size_t i=0;i<bm.mesh.vertexCount;i++)
+        CHECK(close(baked.vertices[vertexPos+i],
+                    xfmPoint(inst.xfm,vec3f(v[i*vstride],
+                                            v[i*vstride+1],
+                                            v[i*vstride+2]))));
+      const int *idx = (const int *)bm.mesh.indices;
+      const size_t istride = bm.mesh.indexStride/sizeof(int);
+      for (size_t i=0;i<bm.mesh.indexCount;i++) {
+        const vec3i expected
+          = vec3i(idx[i*istride],idx[i*istride+1],idx[i*istride+2])
+          + vec3i((int)vertexPos);
+        CHECK(baked.indices[triPos+i] == expected);
+        CHECK(baked.sbtIndices[triPos+i] == bm.sbtIndex);
+      }
+      vertexPos += bm.mesh.vertexCount;
+      triPos    += bm.mesh.indexCount;
+    }
+  }
+  CHECK(baked.vertices.size()   == vertexPos);
+  CHECK(baked.indices.size()    == triPos);
+  CHECK(baked.sbtIndices.size() == triPos);
+
+  // nothing to bake
+  const BakedGeometry empty = bakeInstances(groups,{});
+  CHECK(empty.vertices.empty() && empty.indices.empty());
+}
+
+int main(int ac, char **av)
+{
+  testPlan();
+  testTransformPoints();
+  testBake();
+  return owl::test::allPassed("transform baking");
+}
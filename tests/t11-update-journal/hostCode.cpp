@@ -0,0 +1,207 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Tests the host-side part of owlContextApplyUpdates: that streams
+// written with journal::Writer decode to the same updates, that
+// redundant updates get coalesced (last value wins, in order of
+// first occurrence), and that malformed streams get rejected.
+
+#include "owl/ng/cpp/UpdateJournal.h"
+// std
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+using namespace owl;
+using namespace owl::journal;
+using owl::common::vec3f;
+
+#define OWL_TEST_NAME "t11"
+#include "tests/common/Check.h"
+
+affine3f makeTransform(float f)
+{
+  return affine3f(vec3f(f,0,0),vec3f(0,f,0),vec3f(0,0,f),vec3f(f,2*f,3*f));
+}
+
+bool equal(const affine3f &a, const affine3f &b)
+{
+  return memcmp(&a,&b,sizeof(a)) == 0;
+}
+
+bool rejects(const std::vector<uint8_t> &bytes)
+{
+  try {
+    decode(bytes.data(),bytes.size());
+  } catch (const std::runtime_error &) {
+    return true;
+  }
+  return false;
+}
+
+void setUint(std::vector<uint8_t> &bytes, size_t offset, uint32_t value)
+{
+  memcpy(bytes.data()+offset,&value,sizeof(value));
+}
+
+void testRoundTrip()
+{
+  Writer writer;
+  std::vector<affine3f> xfms;
+  for (int i=0;i<5;i++) xfms.push_back(makeTransform(float(i+1)));
+  writer.transforms(3,10,5,xfms.data());
+  const int32_t newChildren[2] = { 7, 8 };
+  writer.children(3,0,2,newChildren);
+  const uint8_t masks[3] = { 0, 1, 255 };
+  writer.visibilityMasks(4,1,3,masks);
+  const float color[3] = { .1f, .2f, .3f };
+  writer.variable(TARGET_RAYGEN,2,1,color,sizeof(color));
+  CHECK(writer.bytes.size() % 4 == 0);
+
+  const Batch batch = decode(writer.bytes.data(),writer.bytes.size());
+  CHECK(batch.numRecords == 4);
+  CHECK(batch.numUpdatesBeforeCoalescing == 11);
+  CHECK(batch.numUpdates() == 11);
+
+  CHECK(batch.transforms.size() == 5);
+  for (int i=0;i<5;i++) {
+    CHECK(batch.transforms[i].group == 3);
+    CHECK(batch.transforms[i].child == uint32_t(10+i));
+    CHECK(equal(batch.transforms[i].xfm,xfms[i]));
+  }
+  CHECK(batch.children.size() == 2);
+  CHECK(batch.children[1].child == 1 && batch.children[1].newChild == 8);
+  CHECK(batch.masks.size() == 3);
+  CHECK(batch.masks[0].group == 4 && batch.masks[0].child == 1);
+  CHECK(batch.masks[2].mask == 255);
+  CHECK(batch.variables.size() == 1);
+  const Batch::Variable &var = batch.variables[0];
+  CHECK(var.target == TARGET_RAYGEN && var.object == 2 && var.varIndex == 1);
+  CHECK(var.dataSize == sizeof(color));
+  CHECK(memcmp(batch.variableData.data()+var.dataBegin,color,sizeof(color)) == 0);
+
+  // a stream with only a header is valid, and empty
+  const Batch empty = decode(Writer().bytes.data(),Writer().bytes.size());
+  CHECK(empty.numRecords == 0 && empty.numUpdates() == 0);
+}
+
+void testCoalescing()
+{
+  Writer writer;
+  const affine3f a = makeTransform(1), b = makeTransform(2), c = makeTransform(3);
+  writer.transforms(0,5,1,&a);
+  writer.transforms(0,6,1,&b);
+  writer.transforms(1,5,1,&a);
+  // overwrites the first one, which has to stay in front
+  writer.transforms(0,5,1,&c);
+
+  const uint8_t hide = 0, show = 255;
+  writer.visibilityMasks(0,0,1,&hide);
+  writer.visibilityMasks(0,0,1,&show);
+
+  const int32_t first = 1, second = 2;
+  writer.variable(TARGET_GEOM,9,0,&first,sizeof(first));
+  writer.variable(TARGET_MISSPROG,9,0,&first,sizeof(first));
+  writer.variable(TARGET_GEOM,9,0,&second,sizeof(second));
+
+  const Batch batch = decode(writer.bytes.data(),writer.bytes.size());
+  CHECK(batch.numUpdatesBeforeCoalescing == 9);
+  CHECK(batch.numUpdates() == 6);
+
+  CHECK(batch.transforms.size() == 3);
+  CHECK(batch.transforms[0].group == 0 && batch.transforms[0].child == 5);
+  CHECK(equal(batch.transforms[0].xfm,c));
+  CHECK(batch.transforms[1].child == 6 && equal(batch.transforms[1].xfm,b));
+  CHECK(batch.transforms[2].group == 1 && equal(batch.transforms[2].xfm,a));
+
+  CHECK(batch.masks.size() == 1 && batch.masks[0].mask == 255);
+
+  // same object ID and variable, but different targets, are
+  // different variables
+  CHECK(batch.variables.size() == 2);
+  int32_t value;
+  memcpy(&value,batch.variableData.data()+batch.variables[0].dataBegin,4);
+  CHECK(batch.variables[0].target == TARGET_GEOM && value == 2);
+  memcpy(&value,batch.variableData.data()+batch.variables[1].dataBegin,4);
+  CHECK(batch.variables[1].target == TARGET_MISSPROG && value == 1);
+}
+
+void testMalformed()
+{
+  Writer writer;
+  const uint8_t mask = 1;
+  writer.visibilityMasks(0,0,1,&mask);
+  const std::vector<uint8_t> good = writer.bytes;
+  CHECK(!rejects(good));
+
+  // too short for a header
+  CHECK(rejects(std::vector<uint8_t>(good.begin(),good.begin()+4)));
+
+  std::vector<uint8_t> bad = good;
+  setUint(bad,0,0x12345678);
+  CHECK(rejects(bad));
+
+  bad = good;
+  setUint(bad,4,VERSION+1);
+  CHECK(rejects(bad));
+
+  // truncated record
+  CHECK(rejects(std::vector<uint8_t>(good.begin(),good.end()-4)));
+  CHECK(rejects(std::vector<uint8_t>(good.begin(),good.begin()+12)));
+
+  // unknown record type
+  bad = good;
+  setUint(bad,8,42);
+  CHECK(rejects(bad));
+
+  // payload size that is not a multiple of 4, or too small for its
+  // contents
+  bad = good;
+  setUint(bad,12,15);
+  CHECK(rejects(bad));
+  bad = good;
+  setUint(bad,12,8);
+  CHECK(rejects(std::vector<uint8_t>(bad.begin(),bad.end()-8)));
+
+  // child count that does not fit the payload
+  bad = good;
+  setUint(bad,24,1000);
+  CHECK(rejects(bad));
+
+  // negative group
+  bad = good;
+  setUint(bad,16,uint32_t(-1));
+  CHECK(rejects(bad));
+
+  // invalid variable target
+  Writer varWriter;
+  const float value = 1.f;
+  varWriter.variable(TARGET_GEOM,0,0,&value,sizeof(value));
+  bad = varWriter.bytes;
+  CHECK(!rejects(bad));
+  setUint(bad,16,7);
+  CHECK(rejects(bad));
+}
+
+int main(int ac, char **av)
+{
+  testRoundTrip();
+  testCoalescing();
+  testMalformed();
+  return owl::test::allPassed("update journal");
+}
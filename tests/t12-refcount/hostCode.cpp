@@ -0,0 +1,132 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Tests owl's intrusive reference counting (owl/ng/cpp/RefCounted.h):
+// that objects die exactly when their last Ref goes away, that Refs
+// can be (re-)created from plain pointers at any time, and that
+// conversions and casts between Refs keep the counts right.
+
+#include "owl/ng/cpp/RefCounted.h"
+// std
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+
+using namespace owl;
+
+#define OWL_TEST_NAME "t12"
+#include "tests/common/Check.h"
+
+int numAlive = 0;
+
+struct Base : public RefCounted {
+  typedef Ref<Base> SP;
+  Base()  { numAlive++; }
+  Base(const Base &other) : RefCounted(other) { numAlive++; }
+  ~Base() { numAlive--; }
+};
+
+struct Derived : public Base {
+  typedef Ref<Derived> SP;
+  Derived(int value) : value(value) {}
+  int value;
+};
+
+struct Other : public Base {
+};
+
+void testLifetime()
+{
+  {
+    Base::SP a = makeRef<Base>();
+    CHECK(numAlive == 1 && a->useCount() == 1);
+    {
+      Base::SP b = a;
+      CHECK(a->useCount() == 2);
+      Base::SP c = std::move(b);
+      CHECK(!b && c == a && a->useCount() == 2);
+    }
+    CHECK(a->useCount() == 1);
+
+    // a ref created from a plain ('borrowed') pointer shares the
+    // object's count - there is no separate control block
+    Base *borrowed = a.get();
+    Base::SP fromRaw = borrowed;
+    CHECK(a->useCount() == 2);
+    a = nullptr;
+    CHECK(numAlive == 1 && fromRaw->useCount() == 1);
+    fromRaw.reset();
+    CHECK(numAlive == 0);
+  }
+  
+  // re-assigning releases the old object
+  Base::SP a = makeRef<Base>();
+  a = makeRef<Base>();
+  CHECK(numAlive == 1);
+  a = a;
+  CHECK(numAlive == 1 && a->useCount() == 1);
+  a = nullptr;
+  CHECK(numAlive == 0);
+
+  // refs in containers
+  {
+    std::vector<Base::SP> refs(10,makeRef<Base>());
+    CHECK(numAlive == 1 && refs[0]->useCount() == 10);
+    refs.resize(3);
+    CHECK(refs[2]->useCount() == 3);
+  }
+  CHECK(numAlive == 0);
+
+  // copies of an object are new objects, with their own count
+  {
+    Derived::SP a = makeRef<Derived>(1);
+    Derived::SP b = makeRef<Derived>(*a);
+    CHECK(numAlive == 2 && a->useCount() == 1 && b->useCount() == 1);
+  }
+  CHECK(numAlive == 0);
+}
+
+void testCasts()
+{
+  Derived::SP derived = makeRef<Derived>(42);
+  Base::SP base = derived;
+  CHECK(derived->useCount() == 2);
+
+  Derived::SP back = dynamicRefCast<Derived>(base);
+  CHECK(back && back->value == 42 && derived->useCount() == 3);
+  Ref<Other> other = dynamicRefCast<Other>(base);
+  CHECK(!other && other == nullptr && derived->useCount() == 3);
+
+  Base::SP moved = std::move(back);
+  CHECK(!back && derived->useCount() == 3);
+
+  Derived *released = derived.release();
+  CHECK(!derived && released->useCount() == 3);
+  Derived::SP adopted = released;
+  released->refDec();
+  CHECK(adopted->useCount() == 3);
+
+  base = moved = adopted = nullptr;
+  CHECK(numAlive == 0);
+}
+
+int main(int ac, char **av)
+{
+  testLifetime();
+  testCasts();
+  return owl::test::allPassed("refcount");
+}
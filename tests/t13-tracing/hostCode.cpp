@@ -0,0 +1,145 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Tests the tracer behind owlEnableTracing (owl/ll/Tracing.h): that
+// nothing gets recorded while it's off, that scopes record properly
+// nested events with their arguments, that each thread gets a ring
+// of its own that keeps only the most recent events, and that the
+// dump is the trace_event JSON that chrome://tracing expects.
+
+#include "owl/ll/Tracing.h"
+// std
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace owl::ll;
+
+#define OWL_TEST_NAME "t13"
+#include "tests/common/Check.h"
+
+const char *traceFile = "test13-trace.json";
+
+std::string dumpToString()
+{
+  CHECK(Tracing::dump(traceFile));
+  std::ifstream in(traceFile);
+  std::stringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+size_t count(const std::string &s, const std::string &what)
+{
+  size_t result = 0;
+  for (size_t pos = s.find(what);pos != std::string::npos;pos = s.find(what,pos+1))
+    result++;
+  return result;
+}
+
+void testDisabled()
+{
+  Tracing::setEnabled(false,nullptr);
+  Tracing::clear();
+  for (int i=0;i<100;i++) {
+    OWL_TRACE_SCOPE("test","disabled");
+  }
+  CHECK(count(dumpToString(),"\"ph\":\"X\"") == 0);
+}
+
+void testScopes()
+{
+  Tracing::setEnabled(true,nullptr);
+  Tracing::clear();
+  {
+    OWL_TRACE_SCOPE("test","outer","numPixels",int64_t(1)<<40);
+    {
+      OWL_TRACE_SCOPE("test","inner","groupID",7,"child",-3);
+    }
+  }
+  Tracing::setEnabled(false,nullptr);
+  
+  const std::string json = dumpToString();
+  CHECK(json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[") == 0);
+  CHECK(json.substr(json.size()-4) == "\n]}\n");
+  CHECK(count(json,"\"ph\":\"X\"") == 2);
+  CHECK(count(json,"\"thread_name\"") == 1);
+  // the inner scope ends first, so gets recorded first
+  CHECK(json.find("\"inner\"") < json.find("\"outer\""));
+  CHECK(json.find("\"args\":{\"groupID\":7,\"child\":-3}") != std::string::npos);
+  CHECK(json.find("\"args\":{\"numPixels\":1099511627776}") != std::string::npos);
+  CHECK(json.find("\"cat\":\"test\"") != std::string::npos);
+}
+
+void testTimestamps()
+{
+  Tracing::Event event;
+  event.category = "test";
+  event.name     = "with \"quotes\"";
+  event.begin    = 1234567;
+  event.end      = 1234567+2001;
+  event.argNames[0] = event.argNames[1] = nullptr;
+  Tracing::clear();
+  Tracing::record(event);
+  const std::string json = dumpToString();
+  // microseconds, with nanosecond fractions
+  CHECK(json.find("\"ts\":1234.567,\"dur\":2.001") != std::string::npos);
+  CHECK(json.find("\"with \\\"quotes\\\"\"") != std::string::npos);
+}
+
+void testThreadsAndWrapAround()
+{
+  Tracing::setEnabled(true,nullptr);
+  Tracing::clear();
+  const int numThreads = 4;
+  const int numEvents  = Tracing::RING_SIZE+100;
+  std::vector<std::thread> threads;
+  for (int t=0;t<numThreads;t++)
+    threads.push_back(std::thread([&](){
+          for (int i=0;i<numEvents;i++) {
+            OWL_TRACE_SCOPE("test","event","i",i);
+          }
+        }));
+  for (auto &thread : threads) thread.join();
+  Tracing::setEnabled(false,nullptr);
+
+  const std::string json = dumpToString();
+  CHECK(count(json,"\"ph\":\"X\"") == size_t(numThreads)*Tracing::RING_SIZE);
+  // each thread kept its most recent events only
+  CHECK(count(json,"\"args\":{\"i\":99}") == 0);
+  CHECK(count(json,"\"args\":{\"i\":100}") == size_t(numThreads));
+  CHECK(count(json,"\"args\":{\"i\":"+std::to_string(numEvents-1)+"}")
+        == size_t(numThreads));
+  // threads get their own IDs (including the main thread's from
+  // the earlier tests)
+  CHECK(count(json,"\"thread_name\"") == size_t(numThreads+1));
+}
+
+int main(int ac, char **av)
+{
+  testDisabled();
+  testScopes();
+  testTimestamps();
+  testThreadsAndWrapAround();
+  std::remove(traceFile);
+  return owl::test::allPassed("tracing");
+}
@@ -0,0 +1,159 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Tests OWL's logging (owl/ll/Logging.h): that only messages up to
+// the current level get logged, that disabled messages don't even
+// get formatted, that a custom sink gets the plain messages with
+// their levels, and that messages from different threads never
+// reach the sink concurrently.
+
+#include "owl/ll/Logging.h"
+// std
+#include <atomic>
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace owl::ll;
+
+#define OWL_TEST_NAME "t14"
+#include "tests/common/Check.h"
+
+struct Received {
+  std::vector<int>         levels;
+  std::vector<std::string> messages;
+  /*! number of sink calls currently in flight */
+  std::atomic<int>         inSink { 0 };
+  bool                     overlapped = false;
+};
+
+void collect(int32_t level, const char *message, void *userData)
+{
+  Received *received = (Received *)userData;
+  if (received->inSink++ != 0)
+    received->overlapped = true;
+  received->levels.push_back(level);
+  received->messages.push_back(message);
+  received->inSink--;
+}
+
+int numFormatted = 0;
+
+/*! something expensive to log; counts how often it got evaluated */
+std::string expensive()
+{
+  numFormatted++;
+  return "expensive";
+}
+
+void testLevels()
+{
+  Received received;
+  Logging::setSink(collect,&received);
+  Logging::setLevel(Logging::LEVEL_WARNING);
+  OWL_LOG(LEVEL_ERROR,"error " << 1);
+  OWL_LOG(LEVEL_WARNING,"warning " << 2);
+  OWL_LOG(LEVEL_INFO,"info " << 3);
+  OWL_LOG(LEVEL_DEBUG,"debug " << 4);
+  CHECK(received.messages.size() == 2);
+  CHECK(received.levels[0] == Logging::LEVEL_ERROR);
+  CHECK(received.messages[0] == "error 1");
+  CHECK(received.levels[1] == Logging::LEVEL_WARNING);
+  CHECK(received.messages[1] == "warning 2");
+
+  Logging::setLevel(Logging::LEVEL_NONE);
+  OWL_LOG(LEVEL_ERROR,"not even errors");
+  CHECK(received.messages.size() == 2);
+
+  Logging::setLevel(Logging::LEVEL_DEBUG);
+  OWL_LOG(LEVEL_DEBUG,"debug");
+  CHECK(received.messages.size() == 3);
+  CHECK(OWL_LOG_ENABLED(LEVEL_DEBUG));
+  Logging::setSink(nullptr,nullptr);
+}
+
+void testLazyFormatting()
+{
+  Received received;
+  Logging::setSink(collect,&received);
+  Logging::setLevel(Logging::LEVEL_INFO);
+  numFormatted = 0;
+  for (int i=0;i<100;i++)
+    OWL_LOG(LEVEL_DEBUG,"value: " << expensive());
+  CHECK(numFormatted == 0);
+  CHECK(received.messages.empty());
+  
+  OWL_LOG(LEVEL_INFO,"value: " << expensive());
+  CHECK(numFormatted == 1);
+  CHECK(received.messages.size() == 1);
+  CHECK(received.messages[0] == "value: expensive");
+
+  // has to behave like a single statement
+  if (numFormatted == 0)
+    OWL_LOG(LEVEL_INFO,"wrong branch");
+  else
+    OWL_LOG(LEVEL_INFO,"right branch");
+  CHECK(received.messages.back() == "right branch");
+  Logging::setSink(nullptr,nullptr);
+}
+
+void testColoredMessages()
+{
+  Received received;
+  Logging::setSink(collect,&received);
+  Logging::setLevel(Logging::LEVEL_INFO);
+  OWL_LOG_COLOR(LEVEL_INFO,OWL_TERMINAL_GREEN,"ok");
+  // custom sinks get the plain message, without escape codes
+  CHECK(received.messages.size() == 1);
+  CHECK(received.messages[0] == "ok");
+  Logging::setSink(nullptr,nullptr);
+}
+
+void testThreads()
+{
+  Received received;
+  Logging::setSink(collect,&received);
+  Logging::setLevel(Logging::LEVEL_DEBUG);
+  const int numThreads = 8;
+  const int numPerThread = 1000;
+  std::vector<std::thread> threads;
+  for (int t=0;t<numThreads;t++)
+    threads.push_back(std::thread([t](){
+          for (int i=0;i<numPerThread;i++)
+            OWL_LOG(LEVEL_DEBUG,"thread " << t << " message " << i);
+        }));
+  for (auto &thread : threads) thread.join();
+  CHECK(!received.overlapped);
+  CHECK(received.messages.size() == size_t(numThreads*numPerThread));
+  Logging::setSink(nullptr,nullptr);
+}
+
+int main(int ac, char **av)
+{
+  testLevels();
+  testLazyFormatting();
+  testColoredMessages();
+  testThreads();
+
+  // default sink must still work after all that
+  Logging::setLevel(Logging::LEVEL_INFO);
+  OWL_LOG(LEVEL_INFO,"#owl.test(t14): default sink still works");
+  
+  return owl::test::allPassed("logging");
+}
@@ -0,0 +1,152 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Tests the metrics registry behind owlContextGetMetrics
+// (owl/ll/Metrics.h): that counts from different threads - including
+// ones that already exited - all end up in the merged snapshot, that
+// histograms put values into the right log2 buckets, and that the
+// text exporter writes valid Prometheus text format.
+
+#include "owl/ll/Metrics.h"
+// std
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace owl::ll;
+
+#define OWL_TEST_NAME "t15"
+#include "tests/common/Check.h"
+
+bool contains(const std::string &s, const std::string &what)
+{
+  return s.find(what) != std::string::npos;
+}
+
+void testIDs()
+{
+  const int a = Metrics::counterID("test_ids_total");
+  const int b = Metrics::counterID("test_ids_total{kind=\"b\"}");
+  CHECK(a != b);
+  CHECK(Metrics::counterID("test_ids_total") == a);
+  // histograms have IDs of their own
+  CHECK(Metrics::histogramID("test_ids_total") >= 0);
+}
+
+void testCounters()
+{
+  for (int i=0;i<10;i++)
+    OWL_COUNTER_ADD("test_single_thread_total",3);
+  Metrics::Snapshot snapshot = Metrics::snapshot();
+  CHECK(snapshot.counter("test_single_thread_total") == 30);
+  CHECK(snapshot.counter("test_does_not_exist") == 0);
+  // sorted by name
+  for (size_t i=1;i<snapshot.counters.size();i++)
+    CHECK(snapshot.counters[i-1].name < snapshot.counters[i].name);
+}
+
+void testThreads()
+{
+  const int numThreads = 8;
+  const int numPerThread = 100000;
+  // two rounds, so the second one reuses the blocks of the first
+  // one's (exited) threads
+  for (int round=0;round<2;round++) {
+    std::vector<std::thread> threads;
+    for (int t=0;t<numThreads;t++)
+      threads.push_back(std::thread([](){
+            for (int i=0;i<numPerThread;i++)
+              OWL_COUNTER_ADD("test_threads_total",1);
+          }));
+    // snapshots may get taken while threads count
+    Metrics::Snapshot during = Metrics::snapshot();
+    CHECK(during.counter("test_threads_total")
+          <= uint64_t(round+1)*numThreads*numPerThread);
+    for (auto &thread : threads) thread.join();
+    CHECK(Metrics::snapshot().counter("test_threads_total")
+          == uint64_t(round+1)*numThreads*numPerThread);
+  }
+}
+
+void testHistograms()
+{
+  CHECK(Metrics::bucketOf(0) == 0);
+  CHECK(Metrics::bucketOf(1) == 1);
+  CHECK(Metrics::bucketOf(2) == 2);
+  CHECK(Metrics::bucketOf(3) == 2);
+  CHECK(Metrics::bucketOf(4) == 3);
+  CHECK(Metrics::bucketOf(1000) == 10);
+  CHECK(Metrics::bucketOf(uint64_t(-1)) == Metrics::NUM_BUCKETS-1);
+
+  const int id = Metrics::histogramID("test_latency_seconds{kind=\"x\"}");
+  Metrics::record(id,0);
+  Metrics::record(id,1000);
+  Metrics::record(id,1023);
+  Metrics::record(id,1000000);
+  std::thread([id](){ Metrics::record(id,5); }).join();
+
+  Metrics::Snapshot snapshot = Metrics::snapshot();
+  const Metrics::Snapshot::Histogram *h
+    = snapshot.histogram("test_latency_seconds{kind=\"x\"}");
+  CHECK(h != nullptr);
+  CHECK(h->count == 5);
+  CHECK(h->sum == 0+1000+1023+1000000+5);
+  CHECK(h->max == 1000000);
+  CHECK(h->buckets[0] == 1);
+  CHECK(h->buckets[3] == 1);
+  CHECK(h->buckets[10] == 2);
+  CHECK(h->buckets[20] == 1);
+
+  // scoped timers record once per scope
+  for (int i=0;i<3;i++) {
+    OWL_HISTOGRAM_SCOPE("test_scope_seconds");
+  }
+  CHECK(Metrics::snapshot().histogram("test_scope_seconds")->count == 3);
+}
+
+void testText()
+{
+  Metrics::Snapshot snapshot = Metrics::snapshot();
+  snapshot.gauges.push_back({"test_gauge",42});
+  const std::string text = snapshot.toText();
+  CHECK(contains(text,"# TYPE test_single_thread_total counter\ntest_single_thread_total 30\n"));
+  // one TYPE line per metric, even with several labels
+  CHECK(contains(text,"# TYPE test_ids_total counter\n"
+                 "test_ids_total 0\n"
+                 "test_ids_total{kind=\"b\"} 0\n"));
+  CHECK(contains(text,"# TYPE test_gauge gauge\ntest_gauge 42\n"));
+  CHECK(contains(text,"# TYPE test_latency_seconds histogram\n"));
+  // cumulative buckets, labels merged with 'le', in seconds
+  CHECK(contains(text,"test_latency_seconds_bucket{kind=\"x\",le=\"1e-09\"} 1\n"));
+  CHECK(contains(text,"test_latency_seconds_bucket{kind=\"x\",le=\"1.024e-06\"} 4\n"));
+  CHECK(contains(text,"test_latency_seconds_bucket{kind=\"x\",le=\"+Inf\"} 5\n"));
+  CHECK(contains(text,"test_latency_seconds_count{kind=\"x\"} 5\n"));
+  CHECK(contains(text,"test_latency_seconds_sum{kind=\"x\"} 0.001002028\n"));
+  CHECK(contains(text,"test_scope_seconds_count 3\n"));
+}
+
+int main(int ac, char **av)
+{
+  testIDs();
+  testCounters();
+  testThreads();
+  testHistograms();
+  testText();
+  return owl::test::allPassed("metrics");
+}
@@ -0,0 +1,110 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Tests the build stats behind owlContextSetBuildStatsCallback
+// (owl/ll/BuildStats.h): that the stats of group builds made of
+// several optix builds (split groups, baked transforms) sum up output
+// and compacted sizes but only keep the peak temp size, that the
+// compaction ratio handles builds without output, and that the log
+// line has all the numbers in it.
+
+#include "owl/ll/BuildStats.h"
+// std
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace owl::ll;
+
+#define OWL_TEST_NAME "t16"
+#include "tests/common/Check.h"
+
+bool contains(const std::string &s, const std::string &what)
+{
+  return s.find(what) != std::string::npos;
+}
+
+void testSingleAccel()
+{
+  BuildStats stats;
+  CHECK(stats.numAccels == 0);
+  CHECK(stats.compactionRatio() == 1.);
+
+  stats.addAccel(3,1000,4000,1000);
+  CHECK(stats.numAccels == 1);
+  CHECK(stats.numBuildInputs == 3);
+  CHECK(stats.tempSizeInBytes == 1000);
+  CHECK(stats.outputSizeInBytes == 4000);
+  CHECK(stats.compactedSizeInBytes == 1000);
+  CHECK(std::fabs(stats.compactionRatio()-.25) < 1e-12);
+}
+
+void testSplitGroup()
+{
+  // two parts of a split geom group, plus the instance accel over
+  // them; the temp buffers get allocated one after another
+  BuildStats stats;
+  stats.addAccel(2,5000,8000,6000);
+  stats.addAccel(1,7000,2000,2000);
+  stats.addAccel(1,100,200,200);
+  CHECK(stats.numAccels == 3);
+  CHECK(stats.numBuildInputs == 4);
+  CHECK(stats.tempSizeInBytes == 7000);
+  CHECK(stats.outputSizeInBytes == 10200);
+  CHECK(stats.compactedSizeInBytes == 8200);
+  CHECK(stats.compactionRatio() < 1.);
+
+  // builds that don't get compacted keep a ratio of 1
+  BuildStats instances;
+  instances.addAccel(1,64,512,512);
+  CHECK(instances.compactionRatio() == 1.);
+}
+
+void testText()
+{
+  BuildStats stats;
+  stats.groupID            = 7;
+  stats.kind               = BuildStats::KIND_USER;
+  stats.numPrimitives      = 2000000;
+  stats.boundsSizeInBytes  = 48*1024*1024;
+  stats.hostBuildSeconds   = .0125;
+  stats.deviceBuildSeconds = .002;
+  stats.addAccel(1,2048,4096,2048);
+  const std::string text = stats.toText();
+  CHECK(contains(text,"user group #7"));
+  CHECK(contains(text,"1.91M prims in 1 input(s), 1 accel(s)"));
+  CHECK(contains(text,"48.00MB bounds"));
+  CHECK(contains(text,"2.00KB temp"));
+  CHECK(contains(text,"4.00KB output"));
+  CHECK(contains(text,"(50%)"));
+  CHECK(contains(text,"12.500ms host"));
+  CHECK(contains(text,"2.000ms device"));
+
+  // no bounds for other kinds of groups
+  stats.kind = BuildStats::KIND_TRIANGLES;
+  stats.boundsSizeInBytes = 0;
+  CHECK(contains(stats.toText(),"triangles group #7"));
+  CHECK(!contains(stats.toText(),"bounds"));
+}
+
+int main(int ac, char **av)
+{
+  testSingleAccel();
+  testSplitGroup();
+  testText();
+  return owl::test::allPassed("build stats");
+}
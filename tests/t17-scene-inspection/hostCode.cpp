@@ -0,0 +1,334 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Tests the scene inspector behind owlContextDumpStats
+// (owl/ll/SceneInspection.h) on synthetic scene descriptions: the
+// structure histograms, SBT padding, duplicate and tiny-object
+// detection, memory per category, the recommendations and their
+// savings estimates, that invalid and cyclic graphs get rejected, and
+// that large scenes get inspected in linear time.
+
+#include "owl/ll/SceneInspection.h"
+#include "owl/common/owl-common.h"
+// std
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace owl::ll;
+
+#define OWL_TEST_NAME "t17"
+#include "tests/common/Check.h"
+
+bool contains(const std::string &s, const std::string &what)
+{
+  return s.find(what) != std::string::npos;
+}
+
+InspectBuffer makeBuffer(size_t size, uint64_t fingerprint)
+{
+  InspectBuffer buffer;
+  buffer.valid       = true;
+  buffer.sizeInBytes = size;
+  buffer.fingerprint = fingerprint;
+  return buffer;
+}
+
+InspectGeom makeMesh(size_t numTriangles, int vertexBuffer, int indexBuffer,
+                     size_t sbtDataSize)
+{
+  InspectGeom geom;
+  geom.kind         = InspectGeom::TRIANGLES;
+  geom.numPrims     = numTriangles;
+  geom.vertexBuffer = vertexBuffer;
+  geom.indexBuffer  = indexBuffer;
+  geom.sbtDataSize  = sbtDataSize;
+  return geom;
+}
+
+InspectGroup makeGroup(int kind, const std::vector<int> &children,
+                       size_t accelSize = 0)
+{
+  InspectGroup group;
+  group.kind             = kind;
+  group.children         = children;
+  group.accelSizeInBytes = accelSize;
+  return group;
+}
+
+/*! two meshes with identical (duplicate) buffers in one triangles
+    group, a user geom with large SBT data in a user group, and one
+    instance group over them, traced with two ray types */
+SceneDescription makeTwoLevelScene()
+{
+  SceneDescription scene;
+  scene.numRayTypes = 2;
+  scene.buffers.push_back(makeBuffer(1200,11));
+  scene.buffers.push_back(makeBuffer(240,22));
+  scene.buffers.push_back(makeBuffer(1200,11));
+  scene.buffers.push_back(makeBuffer(240,22));
+  // contents unknown: never a duplicate
+  scene.buffers.push_back(makeBuffer(1000,0));
+  scene.buffers.push_back(makeBuffer(1000,0));
+  // a destroyed buffer
+  scene.buffers.push_back(InspectBuffer());
+
+  scene.geoms.push_back(makeMesh(20,0,1,16));
+  scene.geoms.push_back(makeMesh(20,2,3,16));
+  InspectGeom user;
+  user.kind        = InspectGeom::USER;
+  user.numPrims    = 1000;
+  user.sbtDataSize = 100;
+  scene.geoms.push_back(user);
+
+  scene.groups.push_back(makeGroup(InspectGroup::TRIANGLES,{0,1},5000));
+  scene.groups.push_back(makeGroup(InspectGroup::USER,{2},7000));
+  scene.groups.push_back(makeGroup(InspectGroup::INSTANCE,{0,0,1},1240));
+  return scene;
+}
+
+/*! with mesh merging on in any group, all hit records also carry a
+    prim base */
+void testMergingRecords()
+{
+  SceneDescription scene = makeTwoLevelScene();
+  scene.groups[0].meshMerging = true;
+  const SceneReport report = inspectScene(scene);
+  // 100 bytes of data and 4 of prim base still fit 112 bytes, but the
+  // meshes' records now need 32 of them (16 bytes of data, plus the
+  // prim base) - so do records that only fit the meshes' data
+  CHECK(report.sbtRecordSize == 144);
+  CHECK(report.sbtPaddingBytes == 2*2*80);
+  bool foundShrink = false;
+  for (auto &rec : report.recommendations)
+    if (contains(rec.text,"shrinks records to")) {
+      foundShrink = true;
+      CHECK(contains(rec.text,"shrinks records to 64"));
+      CHECK(rec.estimatedBytesSaved == 6*(144-64));
+    }
+  CHECK(foundShrink);
+}
+
+void testTwoLevelScene()
+{
+  const SceneReport report = inspectScene(makeTwoLevelScene());
+  CHECK(report.numBuffers == 6);
+  CHECK(report.numTrianglesGeoms == 2);
+  CHECK(report.numUserGeoms == 1);
+  CHECK(report.numGeomGroups == 2);
+  CHECK(report.numInstanceGroups == 1);
+  CHECK(report.numInstances == 3);
+  CHECK(report.numRootGroups == 1);
+
+  CHECK(report.maxInstanceDepth == 1);
+  CHECK(report.depthHistogram == std::vector<size_t>({0,1}));
+  // three children fall into the [2,4) bin
+  CHECK(report.fanOutHistogram == std::vector<size_t>({0,0,1}));
+  CHECK(report.geomsPerGroupHistogram == std::vector<size_t>({0,1,1}));
+
+  // 32 bytes header plus 100 bytes of data rounded up to 16; three
+  // children times two ray types; the two meshes' records only need
+  // 16 of the 112 data bytes
+  CHECK(report.largestGeomDataSize == 100);
+  CHECK(report.sbtRecordSize == 144);
+  CHECK(report.numHitRecords == 6);
+  CHECK(report.sbtHitRecordBytes == 6*144);
+  CHECK(report.sbtPaddingBytes == 2*2*96);
+
+  CHECK(report.numDuplicateBuffers == 2);
+  CHECK(report.duplicateBytes == 1440);
+  CHECK(report.numTinyMeshes == 2);
+  CHECK(report.numTinyBLASes == 1);
+  CHECK(report.numTinyBLASInstances == 2);
+
+  CHECK(report.vertexBytes == 2400);
+  CHECK(report.indexBytes == 480);
+  CHECK(report.otherBufferBytes == 2000);
+  CHECK(report.geomAccelBytes == 12000);
+  CHECK(report.instanceAccelBytes == 1240);
+
+  // sorted by savings: dedup saves the duplicates; baking saves two
+  // instances and the tiny BLAS, but costs the baked copies of its 40
+  // triangles twice; moving the geom data into a buffer shrinks
+  // records to 48 bytes; merging only saves a build input
+  CHECK(report.recommendations.size() == 4);
+  CHECK(contains(report.recommendations[0].text,"owlContextSetBufferDedup"));
+  CHECK(report.recommendations[0].estimatedBytesSaved == 1440);
+  CHECK(contains(report.recommendations[1].text,
+                 "owlInstanceGroupSetTransformBaking"));
+  CHECK(report.recommendations[1].estimatedBytesSaved
+        == 2*80+5000-2*40*(3*12+12+4));
+  CHECK(contains(report.recommendations[2].text,"shrinks records to 48"));
+  CHECK(report.recommendations[2].estimatedBytesSaved == 6*(144-48));
+  CHECK(contains(report.recommendations[3].text,
+                 "owlTrianglesGeomGroupSetMeshMerging"));
+  CHECK(report.recommendations[3].estimatedBytesSaved == 0);
+
+  // higher thresholds do not change what the scene looks like, only
+  // what counts as tiny
+  InspectionOptions options;
+  options.tinyMeshPrims = 10;
+  options.tinyBLASPrims = 10;
+  const SceneReport strict = inspectScene(makeTwoLevelScene(),options);
+  CHECK(strict.numTinyMeshes == 0);
+  CHECK(strict.numTinyBLASes == 0);
+  CHECK(strict.recommendations.size() == 2);
+}
+
+void testDeepScene()
+{
+  // a mesh, instanced twice, that group instanced three times, that
+  // group instanced twice - none of it built yet
+  SceneDescription scene;
+  scene.geoms.push_back(makeMesh(1000,-1,-1,8));
+  scene.groups.push_back(makeGroup(InspectGroup::TRIANGLES,{0}));
+  scene.groups.push_back(makeGroup(InspectGroup::INSTANCE,{0,0}));
+  scene.groups.push_back(makeGroup(InspectGroup::INSTANCE,{1,1,1}));
+  scene.groups.push_back(makeGroup(InspectGroup::INSTANCE,{2,-1,2}));
+
+  const SceneReport report = inspectScene(scene);
+  CHECK(report.maxInstanceDepth == 3);
+  CHECK(report.depthHistogram == std::vector<size_t>({0,1,1,1}));
+  CHECK(report.numRootGroups == 1);
+  CHECK(report.numTinyBLASes == 0);
+  CHECK(report.numDuplicateBuffers == 0);
+
+  // flattening yields 12 instances in the root, instead of the 5
+  // instances of the two inner groups plus the root's 3 (one of which
+  // is not set); it's faster to trace, but costs memory
+  CHECK(report.recommendations.size() == 1);
+  const Recommendation &rec = report.recommendations[0];
+  CHECK(contains(rec.text,"owlInstanceGroupSetFlattening"));
+  CHECK(contains(rec.text,"up to 3 levels"));
+  CHECK(contains(rec.text,"12 instance(s)"));
+  CHECK(rec.estimatedBytesSaved == (3+2)*80 - (12-3)*80);
+}
+
+void testInvalidScenes()
+{
+  bool threw = false;
+  SceneDescription cyclic;
+  cyclic.groups.push_back(makeGroup(InspectGroup::INSTANCE,{1}));
+  cyclic.groups.push_back(makeGroup(InspectGroup::INSTANCE,{0}));
+  try { inspectScene(cyclic); }
+  catch (const std::runtime_error &) { threw = true; }
+  CHECK(threw);
+
+  threw = false;
+  SceneDescription dangling;
+  dangling.geoms.push_back(makeMesh(10,-1,-1,0));
+  dangling.groups.push_back(makeGroup(InspectGroup::TRIANGLES,{0,1}));
+  try { inspectScene(dangling); }
+  catch (const std::runtime_error &) { threw = true; }
+  CHECK(threw);
+
+  threw = false;
+  SceneDescription badBuffer;
+  badBuffer.geoms.push_back(makeMesh(10,3,-1,0));
+  try { inspectScene(badBuffer); }
+  catch (const std::runtime_error &) { threw = true; }
+  CHECK(threw);
+}
+
+void testFingerprint()
+{
+  std::vector<uint8_t> a(4*1024*1024+17);
+  for (size_t i=0;i<a.size();i++)
+    a[i] = uint8_t((i*2654435761ULL) >> 13);
+  std::vector<uint8_t> b = a;
+  CHECK(sampledContentHash(a.data(),a.size()) != 0);
+  CHECK(sampledContentHash(a.data(),a.size())
+        == sampledContentHash(b.data(),b.size()));
+  // the first and last bytes are always sampled
+  b[0] ^= 1;
+  CHECK(sampledContentHash(a.data(),a.size())
+        != sampledContentHash(b.data(),b.size()));
+  b[0] ^= 1;
+  b.back() ^= 1;
+  CHECK(sampledContentHash(a.data(),a.size())
+        != sampledContentHash(b.data(),b.size()));
+
+  // small blocks get hashed entirely
+  std::vector<uint8_t> c(a.begin(),a.begin()+1000), d = c;
+  d[500] ^= 1;
+  CHECK(sampledContentHash(c.data(),c.size())
+        != sampledContentHash(d.data(),d.size()));
+  CHECK(sampledContentHash(nullptr,0) != 0);
+}
+
+void testLargeScene()
+{
+  // one user geom in a million single-geom groups, all instanced by
+  // one root; this has to be quick
+  const size_t N = 1000000;
+  SceneDescription scene;
+  InspectGeom user;
+  user.kind     = InspectGeom::USER;
+  user.numPrims = 1;
+  scene.geoms.push_back(user);
+  scene.groups.resize(N+1);
+  std::vector<int> rootChildren(N);
+  for (size_t i=0;i<N;i++) {
+    scene.groups[i] = makeGroup(InspectGroup::USER,{0},1024);
+    rootChildren[i] = (int)i;
+  }
+  scene.groups[N] = makeGroup(InspectGroup::INSTANCE,rootChildren,N*80);
+
+  const double t0 = owl::common::getCurrentTime();
+  const SceneReport report = inspectScene(scene);
+  const double t1 = owl::common::getCurrentTime();
+  CHECK(report.numGeomGroups == N);
+  CHECK(report.numInstances == N);
+  CHECK(report.numHitRecords == N);
+  CHECK(report.geomAccelBytes == N*1024);
+  CHECK(report.maxInstanceDepth == 1);
+  CHECK(report.geomsPerGroupHistogram == std::vector<size_t>({0,N}));
+  std::cout << "#owl.test(t17): inspected " << N << " groups in "
+            << int((t1-t0)*1000) << "ms" << std::endl;
+}
+
+void testReport()
+{
+  std::stringstream ss;
+  writeReport(ss,inspectScene(makeTwoLevelScene()));
+  const std::string text = ss.str();
+  CHECK(contains(text,"#owl.inspect: scene"));
+  CHECK(contains(text,"#owl.inspect: structure"));
+  CHECK(contains(text,"fan-out histogram  2-3:1"));
+  CHECK(contains(text,"6 x 144 bytes"));
+  CHECK(contains(text,"#owl.inspect: memory"));
+  CHECK(contains(text,"[saves ~1.41KB]"));
+  CHECK(contains(text,"#owl.inspect: recommendations"));
+
+  std::stringstream empty;
+  writeReport(empty,inspectScene(SceneDescription()));
+  CHECK(contains(empty.str(),"(none)"));
+}
+
+int main(int ac, char **av)
+{
+  testTwoLevelScene();
+  testMergingRecords();
+  testDeepScene();
+  testInvalidScenes();
+  testFingerprint();
+  testLargeScene();
+  testReport();
+  return owl::test::allPassed("scene inspection");
+}
@@ -0,0 +1,238 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Tests the host allocator behind owlSetHostAllocator
+// (owl/ll/HostAllocator.h): that allocations get counted per site,
+// that app-provided functions get used (and can only be swapped while
+// nothing is live), that containers and classes built on it go
+// through it, and that a warm free list - as used for API handles -
+// no longer allocates.
+
+#include "owl/ll/HostAllocator.h"
+// std
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace owl::ll;
+
+#define OWL_TEST_NAME "t18"
+#include "tests/common/Check.h"
+
+bool contains(const std::string &s, const std::string &what)
+{
+  return s.find(what) != std::string::npos;
+}
+
+/*! an app-side allocator that keeps its own counts */
+struct AppAllocator {
+  size_t numAllocs = 0;
+  size_t numFrees  = 0;
+  size_t bytesLive = 0;
+};
+
+void *appAlloc(size_t numBytes, void *userData)
+{
+  AppAllocator *app = (AppAllocator *)userData;
+  app->numAllocs++;
+  app->bytesLive += numBytes;
+  return malloc(numBytes);
+}
+
+void appFree(void *ptr, size_t numBytes, void *userData)
+{
+  AppAllocator *app = (AppAllocator *)userData;
+  app->numFrees++;
+  app->bytesLive -= numBytes;
+  free(ptr);
+}
+
+void testCounting()
+{
+  const HostAllocator::Stats before
+    = HostAllocator::stats(HostAllocator::SITE_LAUNCH);
+  void *a = HostAllocator::allocate(100,HostAllocator::SITE_LAUNCH);
+  void *b = HostAllocator::allocate(28,HostAllocator::SITE_LAUNCH);
+  CHECK(a && b && a != b);
+  HostAllocator::Stats s = HostAllocator::stats(HostAllocator::SITE_LAUNCH);
+  CHECK(s.numAllocs == before.numAllocs+2);
+  CHECK(s.bytesAllocated == before.bytesAllocated+128);
+  CHECK(s.bytesLive() == before.bytesLive()+128);
+
+  HostAllocator::free(a,100,HostAllocator::SITE_LAUNCH);
+  HostAllocator::free(b,28,HostAllocator::SITE_LAUNCH);
+  // freeing null is a no-op, same as free()
+  HostAllocator::free(nullptr,64,HostAllocator::SITE_LAUNCH);
+  s = HostAllocator::stats(HostAllocator::SITE_LAUNCH);
+  CHECK(s.numFrees == before.numFrees+2);
+  CHECK(s.bytesLive() == before.bytesLive());
+
+  // other sites are not affected
+  CHECK(HostAllocator::stats(HostAllocator::SITE_ACCEL).numAllocs == 0);
+
+  // zero-byte requests still return a unique pointer
+  void *z = HostAllocator::allocate(0,HostAllocator::SITE_LAUNCH);
+  CHECK(z != nullptr);
+  HostAllocator::free(z,0,HostAllocator::SITE_LAUNCH);
+
+  bool threw = false;
+  try { HostAllocator::stats(HostAllocator::NUM_SITES); }
+  catch (std::runtime_error &) { threw = true; }
+  CHECK(threw);
+}
+
+void testAppAllocator()
+{
+  AppAllocator app;
+  HostAllocator::set(appAlloc,appFree,&app);
+  void *ptr = HostAllocator::allocate(256,HostAllocator::SITE_VARIABLES);
+  CHECK(app.numAllocs == 1);
+  CHECK(app.bytesLive == 256);
+
+  // can't swap allocators while owl holds memory from this one
+  bool threw = false;
+  try { HostAllocator::set(nullptr,nullptr,nullptr); }
+  catch (std::runtime_error &) { threw = true; }
+  CHECK(threw);
+
+  // the block goes back to where it came from
+  HostAllocator::free(ptr,256,HostAllocator::SITE_VARIABLES);
+  CHECK(app.numFrees == 1);
+  CHECK(app.bytesLive == 0);
+
+  // back to malloc; app functions no longer get called
+  HostAllocator::set(nullptr,nullptr,nullptr);
+  ptr = HostAllocator::allocate(16,HostAllocator::SITE_VARIABLES);
+  HostAllocator::free(ptr,16,HostAllocator::SITE_VARIABLES);
+  CHECK(app.numAllocs == 1);
+
+  // only one of the two functions is an error
+  threw = false;
+  try { HostAllocator::set(appAlloc,nullptr,&app); }
+  catch (std::runtime_error &) { threw = true; }
+  CHECK(threw);
+}
+
+void testHostVector()
+{
+  const HostAllocator::Stats before
+    = HostAllocator::stats(HostAllocator::SITE_ACCEL);
+  {
+    HostVector<int,HostAllocator::SITE_ACCEL> v;
+    v.assign(1000,1);
+    const HostAllocator::Stats s
+      = HostAllocator::stats(HostAllocator::SITE_ACCEL);
+    CHECK(s.numAllocs > before.numAllocs);
+    CHECK(s.bytesLive() >= before.bytesLive()+1000*sizeof(int));
+
+    // re-assigning (as rebuilds do) re-uses the capacity
+    for (int i=0;i<10;i++)
+      v.assign(1000-i,i);
+    CHECK(HostAllocator::stats(HostAllocator::SITE_ACCEL).numAllocs
+          == s.numAllocs);
+  }
+  CHECK(HostAllocator::stats(HostAllocator::SITE_ACCEL).bytesLive()
+        == before.bytesLive());
+}
+
+struct Base {
+  virtual ~Base() {}
+};
+
+struct Derived : public Base,
+                 public HostAllocated<HostAllocator::SITE_VARIABLES> {
+  double payload[7];
+};
+
+void testHostAllocated()
+{
+  const HostAllocator::Stats before
+    = HostAllocator::stats(HostAllocator::SITE_VARIABLES);
+  Base *obj = new Derived;
+  HostAllocator::Stats s
+    = HostAllocator::stats(HostAllocator::SITE_VARIABLES);
+  CHECK(s.numAllocs == before.numAllocs+1);
+  CHECK(s.bytesLive() == before.bytesLive()+sizeof(Derived));
+
+  // deleting through the base frees the full size
+  delete obj;
+  s = HostAllocator::stats(HostAllocator::SITE_VARIABLES);
+  CHECK(s.numFrees == before.numFrees+1);
+  CHECK(s.bytesLive() == before.bytesLive());
+}
+
+void testFreeList()
+{
+  const int N = 100;
+  const HostAllocator::Stats before
+    = HostAllocator::stats(HostAllocator::SITE_HANDLES);
+  HostFreeList freeList(48,HostAllocator::SITE_HANDLES);
+  void *blocks[N];
+
+  // cold: every block comes from the allocator
+  for (int i=0;i<N;i++)
+    blocks[i] = freeList.allocate(40);
+  for (int i=0;i<N;i++)
+    freeList.free(blocks[i]);
+  const HostAllocator::Stats warm
+    = HostAllocator::stats(HostAllocator::SITE_HANDLES);
+  CHECK(warm.numAllocs == before.numAllocs+N);
+  CHECK(warm.numFrees  == before.numFrees);
+
+  // warm: create/destroy cycles no longer allocate
+  for (int frame=0;frame<10;frame++) {
+    for (int i=0;i<N;i++)
+      blocks[i] = freeList.allocate(48);
+    for (int i=0;i<N;i++)
+      freeList.free(blocks[i]);
+  }
+  CHECK(HostAllocator::stats(HostAllocator::SITE_HANDLES).numAllocs
+        == warm.numAllocs);
+
+  bool threw = false;
+  try { freeList.allocate(49); }
+  catch (std::runtime_error &) { threw = true; }
+  CHECK(threw);
+
+  // trimming gives everything back
+  freeList.trim();
+  const HostAllocator::Stats trimmed
+    = HostAllocator::stats(HostAllocator::SITE_HANDLES);
+  CHECK(trimmed.numFrees == before.numFrees+N);
+  CHECK(trimmed.bytesLive() == before.bytesLive());
+}
+
+void testReport()
+{
+  const std::string report = HostAllocator::report();
+  for (int site=0;site<HostAllocator::NUM_SITES;site++)
+    CHECK(contains(report,HostAllocator::siteName(site)));
+  CHECK(contains(report,"allocs"));
+  CHECK(contains(report,"live"));
+  CHECK(std::string(HostAllocator::siteName(-1)) == "invalid");
+}
+
+int main(int ac, char **av)
+{
+  testCounting();
+  testAppAllocator();
+  testHostVector();
+  testHostAllocated();
+  testFreeList();
+  testReport();
+  return owl::test::allPassed("host allocator");
+}
@@ -0,0 +1,50 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#include "deviceCode.h"
+#include <optix_device.h>
+
+using namespace owl;
+
+extern "C" __constant__ LaunchParams optixLaunchParams;
+
+OPTIX_RAYGEN_PROGRAM(renderFrame)()
+{
+  const vec2i pixelID = owl::getLaunchIndex();
+  const LaunchParams &lp = optixLaunchParams;
+
+  // orthographic rays along +z, one per pixel, over [0,1]^2
+  owl::Ray ray(vec3f((pixelID.x+.5f)/lp.fbSize.x,
+                     (pixelID.y+.5f)/lp.fbSize.y,
+                     -1.f),
+               vec3f(0.f,0.f,1.f),
+               0.f,1e10f);
+  vec3f color = 0.f;
+  owl::traceRay(lp.world,ray,color);
+  lp.fbPtr[pixelID.x+lp.fbSize.x*pixelID.y] = owl::make_rgba(color);
+}
+
+OPTIX_CLOSEST_HIT_PROGRAM(triangles)()
+{
+  const TrianglesGeomData &self = owl::getProgramData<TrianglesGeomData>();
+  owl::getPRD<vec3f>() = self.color * optixLaunchParams.tint;
+}
+
+OPTIX_MISS_PROGRAM(miss)()
+{
+  owl::getPRD<vec3f>() = vec3f(0.f);
+}
@@ -0,0 +1,42 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#pragma once
+
+#include <owl/owl.h>
+#include <owl/common/math/vec.h>
+
+using owl::common::vec2i;
+using owl::common::vec3f;
+
+/*! launch params of the steady-state test; everything that changes
+    per frame lives here, or in the geom's variables */
+struct LaunchParams {
+  OptixTraversableHandle world;
+  uint32_t *fbPtr;
+  vec2i     fbSize;
+  vec3f     tint;
+  int       frameID;
+};
+
+struct RayGenData {
+  int unused;
+};
+
+struct TrianglesGeomData {
+  vec3f color;
+};
@@ -0,0 +1,203 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Checks that OWL's common update-and-launch loop - setting launch
+// params and geom variables, moving instances, rebuilding the
+// instance accel and the SBT, and launching - makes no host
+// allocations once it is warm: neither through OWL's host allocator
+// (owlGetHostAllocStats), nor through the global operator new.
+
+#include "deviceCode.h"
+#include <cuda_runtime.h>
+// std
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#define OWL_TEST_NAME "t19"
+#include "tests/common/Check.h"
+
+extern "C" char ptxCode[];
+
+// ------------------------------------------------------------------
+// count every global operator new - from OWL, and from anything it
+// uses - while the steady-state frames are running
+// ------------------------------------------------------------------
+static std::atomic<bool>     countingNew { false };
+static std::atomic<uint64_t> numGlobalNews { 0 };
+
+void *operator new(size_t size)
+{
+  if (countingNew) numGlobalNews++;
+  if (void *ptr = malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { free(ptr); }
+
+// ------------------------------------------------------------------
+// the app's host allocator, so we can also check OWL really uses it
+// ------------------------------------------------------------------
+static std::atomic<uint64_t> numAppAllocs { 0 };
+
+void *appAlloc(size_t numBytes, void *) { numAppAllocs++; return malloc(numBytes); }
+void  appFree(void *ptr, size_t, void *) { free(ptr); }
+
+const int   numInstances = 16;
+const vec2i fbSize(64,64);
+const int   numWarmupFrames = 3;
+const int   numFrames       = 50;
+
+uint64_t totalOwlAllocs()
+{
+  uint64_t sum = 0;
+  for (int site=0;site<OWL_HOST_ALLOC_NUM_SITES;site++)
+    sum += owlGetHostAllocStats((OWLHostAllocSite)site).numAllocs;
+  return sum;
+}
+
+int main(int ac, char **av)
+{
+  owlSetHostAllocator(appAlloc,appFree,nullptr);
+  // the steady-state guarantee holds without validation and without
+  // info-level logging (both of which format strings)
+  owlEnableValidation(0);
+  owlSetLogLevel(OWL_LOG_ERROR);
+
+  OWLContext context = owlContextCreate(nullptr,1);
+  OWLModule  module  = owlModuleCreate(context,ptxCode);
+
+  // ------------------------------------------------------------------
+  // one quad, instanced numInstances times
+  // ------------------------------------------------------------------
+  OWLVarDecl trianglesVars[] = {
+    { "color", OWL_FLOAT3, OWL_OFFSETOF(TrianglesGeomData,color) },
+    { /* sentinel */ }
+  };
+  OWLGeomType trianglesType
+    = owlGeomTypeCreate(context,OWL_GEOMETRY_TRIANGLES,
+                        sizeof(TrianglesGeomData),trianglesVars,-1);
+  owlGeomTypeSetClosestHit(trianglesType,0,module,"triangles");
+
+  const vec3f vertices[4] = {
+    { 0.f,0.f,0.f }, { .1f,0.f,0.f }, { .1f,.1f,0.f }, { 0.f,.1f,0.f }
+  };
+  const owl::common::vec3i indices[2] = { { 0,1,2 }, { 0,2,3 } };
+  OWLBuffer vertexBuffer
+    = owlDeviceBufferCreate(context,OWL_FLOAT3,4,vertices);
+  OWLBuffer indexBuffer
+    = owlDeviceBufferCreate(context,OWL_INT3,2,indices);
+  OWLGeom quad = owlGeomCreate(context,trianglesType);
+  owlTrianglesSetVertices(quad,vertexBuffer,4,sizeof(vec3f),0);
+  owlTrianglesSetIndices(quad,indexBuffer,2,sizeof(owl::common::vec3i),0);
+  owlGeomSet3f(quad,"color",1.f,1.f,1.f);
+
+  OWLGroup quadGroup = owlTrianglesGeomGroupCreate(context,1,&quad);
+  owlGroupBuildAccel(quadGroup);
+  OWLGroup world = owlInstanceGroupCreate(context,numInstances);
+  for (int i=0;i<numInstances;i++)
+    owlInstanceGroupSetChild(world,i,quadGroup);
+
+  // ------------------------------------------------------------------
+  // programs and launch params
+  // ------------------------------------------------------------------
+  OWLVarDecl rayGenVars[] = {
+    { "unused", OWL_INT, OWL_OFFSETOF(RayGenData,unused) },
+    { /* sentinel */ }
+  };
+  OWLRayGen rayGen
+    = owlRayGenCreate(context,module,"renderFrame",
+                      sizeof(RayGenData),rayGenVars,-1);
+  owlMissProgCreate(context,module,"miss",/* no sbt data: */0,nullptr,-1);
+
+  OWLVarDecl launchParamsVars[] = {
+    { "world",   OWL_GROUP,  OWL_OFFSETOF(LaunchParams,world) },
+    { "fbPtr",   OWL_BUFPTR, OWL_OFFSETOF(LaunchParams,fbPtr) },
+    { "fbSize",  OWL_INT2,   OWL_OFFSETOF(LaunchParams,fbSize) },
+    { "tint",    OWL_FLOAT3, OWL_OFFSETOF(LaunchParams,tint) },
+    { "frameID", OWL_INT,    OWL_OFFSETOF(LaunchParams,frameID) },
+    { /* sentinel */ }
+  };
+  OWLLaunchParams launchParams
+    = owlLaunchParamsCreate(context,sizeof(LaunchParams),
+                            launchParamsVars,-1);
+  OWLBuffer fb
+    = owlHostPinnedBufferCreate(context,OWL_INT,fbSize.x*fbSize.y);
+  owlLaunchParamsSetBuffer(launchParams,"fbPtr",fb);
+  owlLaunchParamsSet2i(launchParams,"fbSize",fbSize.x,fbSize.y);
+
+  owlBuildPrograms(context);
+  owlBuildPipeline(context);
+
+  // ------------------------------------------------------------------
+  // the update-and-launch loop
+  // ------------------------------------------------------------------
+  auto renderFrame = [&](int frameID) {
+    for (int i=0;i<numInstances;i++) {
+      // a 4x4 grid of quads, wiggling a bit every frame
+      const float dx = .01f*((frameID+i)%4);
+      const float xfm[12] = {
+        1.f,0.f,0.f,  0.f,1.f,0.f,  0.f,0.f,1.f,
+        .25f*(i%4)+dx, .25f*(i/4), 0.f
+      };
+      owlInstanceGroupSetTransform(world,i,xfm,OWL_MATRIX_FORMAT_OWL);
+    }
+    owlGroupBuildAccel(world);
+    owlGeomSet3f(quad,"color",1.f,.5f+.5f*(frameID%2),1.f);
+    owlLaunchParamsSetGroup(launchParams,"world",world);
+    owlLaunchParamsSet3f(launchParams,"tint",1.f,1.f,.5f);
+    owlLaunchParamsSet1i(launchParams,"frameID",frameID);
+    owlBuildSBT(context);
+    owlParamsLaunch2D(rayGen,fbSize.x,fbSize.y,launchParams);
+    cudaDeviceSynchronize();
+  };
+
+  for (int frameID=0;frameID<numWarmupFrames;frameID++)
+    renderFrame(frameID);
+  // owl did use the app's allocator while setting things up
+  CHECK(numAppAllocs > 0);
+
+  const uint64_t owlAllocsBefore = totalOwlAllocs();
+  const uint64_t appAllocsBefore = numAppAllocs;
+  countingNew = true;
+  for (int frameID=numWarmupFrames;frameID<numWarmupFrames+numFrames;frameID++)
+    renderFrame(frameID);
+  countingNew = false;
+  CHECK(totalOwlAllocs() == owlAllocsBefore);
+  CHECK(numAppAllocs == appAllocsBefore);
+  CHECK(numGlobalNews == 0);
+
+  // and it did actually render something
+  const uint32_t *pixels = (const uint32_t *)owlBufferGetPointer(fb,0);
+  // pixel (3,3) is always covered by the first quad
+  CHECK((pixels[3+fbSize.x*3] & 0xffffff) != 0);
+
+  owlContextDestroy(context);
+  std::cout << "#owl.test(t19): no host allocations in "
+            << numFrames << " steady-state frames" << std::endl;
+
+  // with the last context gone OWL holds no more handle memory, so
+  // the app can switch back to malloc/free
+  CHECK(owlGetHostAllocStats(OWL_HOST_ALLOC_HANDLES).bytesFreed
+        == owlGetHostAllocStats(OWL_HOST_ALLOC_HANDLES).bytesAllocated);
+  owlSetHostAllocator(nullptr,nullptr,nullptr);
+  return owl::test::allPassed("steady-state allocation");
+}
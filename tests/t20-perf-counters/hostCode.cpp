@@ -0,0 +1,130 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Tests the per-phase hardware performance counters behind
+// owlEnablePerfCounters (owl/ll/PerfCounters.h): that phases and
+// events map to the metric names we document, that disabled counters
+// record nothing, and that enabling them either works - in which case
+// a scope's counts end up in the metrics registry - or falls back to
+// 'off' without failing, as it does on machines that do not let us
+// open perf events.
+
+#include "owl/ll/PerfCounters.h"
+#include "owl/ll/Metrics.h"
+// std
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace owl::ll;
+
+#define OWL_TEST_NAME "t20"
+#include "tests/common/Check.h"
+
+bool startsWith(const std::string &s, const std::string &prefix)
+{
+  return s.compare(0,prefix.size(),prefix) == 0;
+}
+
+/*! something for the counters to count */
+volatile uint64_t sink = 0;
+void busyWork()
+{
+  uint64_t sum = 0;
+  for (int i=0;i<1000000;i++)
+    sum += (i*i) ^ (sum >> 3);
+  sink = sum;
+}
+
+uint64_t count(int phase, int event)
+{
+  return Metrics::snapshot().counter(PerfCounters::metricName(phase,event));
+}
+
+void testNames()
+{
+  CHECK(std::string(PerfCounters::phaseName(PerfCounters::PHASE_SBT_BUILD))
+        == "sbt_build");
+  CHECK(std::string(PerfCounters::phaseName(PerfCounters::PHASE_REGISTRY))
+        == "registry");
+  CHECK(std::string(PerfCounters::eventName(PerfCounters::EVENT_CACHE_MISSES))
+        == "cache_misses");
+  CHECK(PerfCounters::metricName(PerfCounters::PHASE_INSTANCE_PACKING,
+                                 PerfCounters::EVENT_CYCLES)
+        == "owl_perf_cycles_total{phase=\"instance_packing\"}");
+  CHECK(PerfCounters::metricName(PerfCounters::PHASE_VARIABLE_WRITES,-1)
+        == "owl_perf_scopes_total{phase=\"variable_writes\"}");
+  CHECK(std::string(PerfCounters::phaseName(PerfCounters::NUM_PHASES))
+        == "invalid");
+}
+
+void testDisabled()
+{
+  PerfCounters::setEnabled(false);
+  CHECK(!PerfCounters::active);
+  const uint64_t before = count(PerfCounters::PHASE_SBT_BUILD,-1);
+  {
+    PerfScope scope(PerfCounters::PHASE_SBT_BUILD);
+    busyWork();
+  }
+  CHECK(count(PerfCounters::PHASE_SBT_BUILD,-1) == before);
+}
+
+void testEnabled()
+{
+  const int phase = PerfCounters::PHASE_REGISTRY;
+  const uint64_t scopesBefore = count(phase,-1);
+  const uint64_t instsBefore
+    = count(phase,PerfCounters::EVENT_INSTRUCTIONS);
+
+  const bool active = PerfCounters::setEnabled(true);
+  CHECK(active == PerfCounters::active);
+  {
+    PerfScope scope(phase);
+    busyWork();
+  }
+  if (active) {
+    std::cout << "#owl.test(t20): perf counters are available" << std::endl;
+    CHECK(PerfCounters::status() == "active");
+    CHECK(count(phase,-1) == scopesBefore+1);
+    // a million loop iterations can't take fewer instructions than
+    // that - unless the machine has no instruction counter at all,
+    // in which case there is nothing to check
+    const uint64_t insts
+      = count(phase,PerfCounters::EVENT_INSTRUCTIONS) - instsBefore;
+    CHECK(insts == 0 || insts >= 1000000);
+  } else {
+    // the graceful fallback: no exception, a reason, and scopes are
+    // no-ops
+    std::cout << "#owl.test(t20): perf counters not available ("
+              << PerfCounters::status() << ")" << std::endl;
+    CHECK(startsWith(PerfCounters::status(),"unavailable: "));
+    CHECK(count(phase,-1) == scopesBefore);
+  }
+
+  PerfCounters::setEnabled(false);
+  CHECK(!PerfCounters::active);
+  if (active)
+    CHECK(PerfCounters::status() == "disabled");
+}
+
+int main(int ac, char **av)
+{
+  testNames();
+  testDisabled();
+  testEnabled();
+  return owl::test::allPassed("perf counter");
+}
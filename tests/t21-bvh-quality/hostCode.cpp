@@ -0,0 +1,244 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Tests the reference-BVH quality analysis (owl/ll/BVHQuality.h):
+// that well-separated inputs give a tree without overlap, that a huge
+// prim shows up as the worst offender, that invalid bounds get
+// skipped, that triangles and their bounds give the same tree, and
+// that large (parallel) builds are complete and deterministic.
+
+#include "owl/ll/BVHQuality.h"
+// std
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace owl::ll;
+
+#define OWL_TEST_NAME "t21"
+#include "tests/common/Check.h"
+
+bool contains(const std::string &s, const std::string &what)
+{
+  return s.find(what) != std::string::npos;
+}
+
+/*! unit boxes on a grid with gaps between them */
+std::vector<box3f> gridBoxes(int n)
+{
+  std::vector<box3f> boxes;
+  for (int z=0;z<n;z++)
+    for (int y=0;y<n;y++)
+      for (int x=0;x<n;x++) {
+        const vec3f lower(2.f*x,2.f*y,2.f*z);
+        boxes.push_back(box3f(lower,lower+vec3f(1.f)));
+      }
+  return boxes;
+}
+
+/*! small random boxes, from a fixed seed */
+std::vector<box3f> randomBoxes(size_t count)
+{
+  std::vector<box3f> boxes;
+  uint32_t state = 0x12345;
+  auto random = [&]() {
+    state = state*1664525u+1013904223u;
+    return (state >> 8)*(1.f/(1<<24));
+  };
+  for (size_t i=0;i<count;i++) {
+    const vec3f lower(100.f*random(),100.f*random(),100.f*random());
+    const vec3f size(random(),random(),random());
+    boxes.push_back(box3f(lower,lower+size));
+  }
+  return boxes;
+}
+
+size_t primsInLeaves(const BVHQualityReport &report)
+{
+  size_t sum = 0;
+  for (size_t size=0;size<report.leafSizeHistogram.size();size++)
+    sum += size*report.leafSizeHistogram[size];
+  return sum;
+}
+
+void testSeparated()
+{
+  const std::vector<box3f> boxes = gridBoxes(16);
+  BVHQualityConfig config;
+  config.maxLeafSize = 4;
+  const BVHQualityReport report
+    = analyzeBVHQuality(boxes.data(),boxes.size(),config);
+  CHECK(report.numPrims == boxes.size());
+  CHECK(report.numInvalidPrims == 0);
+  CHECK(report.numLeaves == report.numInnerNodes+1);
+  CHECK(primsInLeaves(report) == boxes.size());
+  CHECK(report.leafSizeHistogram.size() <= 5);
+  // gaps between all boxes: siblings never overlap
+  CHECK(report.overlapArea == 0.);
+  CHECK(report.meanOverlapRatio == 0.);
+  // (a leaf is at least as large as each of its prims)
+  CHECK(report.sumPrimArea > 0. && report.sumPrimArea <= 1.0001*report.sahLeafCost);
+  CHECK(report.sahCost > 0. && report.sahCost < report.flatCost);
+  CHECK(std::abs(report.sahCost-report.sahInnerCost-report.sahLeafCost) < 1e-6);
+  CHECK(report.maxDepth >= 10);
+  CHECK(report.largestPrims.size() == 10);
+  CHECK(report.costliestLeaves.size() == 10);
+  for (size_t i=1;i<report.costliestLeaves.size();i++)
+    CHECK(report.costliestLeaves[i-1].cost >= report.costliestLeaves[i].cost);
+}
+
+void testHugePrim()
+{
+  std::vector<box3f> boxes = gridBoxes(8);
+  const int hugeID = 100;
+  boxes[hugeID] = box3f(vec3f(-1.f),vec3f(16.f));
+  const BVHQualityReport report
+    = analyzeBVHQuality(boxes.data(),boxes.size());
+  CHECK(report.largestPrims[0].primID == hugeID);
+  CHECK(std::abs(report.largestPrims[0].area-1.f) < 1e-5f);
+  CHECK(report.largestPrims[1].area < 0.01f);
+  CHECK(report.overlapArea > 0.);
+  // the huge prim sits high up in the tree, and its leaf costs most
+  bool found = false;
+  for (auto primID : report.costliestLeaves[0].primIDs)
+    found |= (primID == hugeID);
+  CHECK(found);
+}
+
+void testInvalid()
+{
+  std::vector<box3f> boxes = gridBoxes(4);
+  boxes[3].lower.x = std::numeric_limits<float>::quiet_NaN();
+  boxes[7] = box3f();
+  boxes[9].upper.y = std::numeric_limits<float>::infinity();
+  const BVHQualityReport report
+    = analyzeBVHQuality(boxes.data(),boxes.size());
+  CHECK(report.numPrims == boxes.size());
+  CHECK(report.numInvalidPrims == 3);
+  CHECK(primsInLeaves(report) == boxes.size()-3);
+  CHECK(std::isfinite(report.sahCost));
+
+  const BVHQualityReport empty = analyzeBVHQuality((const box3f *)nullptr,0);
+  CHECK(empty.numLeaves == 0);
+  CHECK(empty.sahCost == 0.);
+}
+
+void testDegenerate()
+{
+  // all prims in the same spot: nothing to split by SAH, but leaves
+  // still must not get larger than allowed
+  std::vector<box3f> boxes(1000,box3f(vec3f(1.f),vec3f(2.f)));
+  BVHQualityConfig config;
+  config.maxLeafSize = 4;
+  const BVHQualityReport report
+    = analyzeBVHQuality(boxes.data(),boxes.size(),config);
+  CHECK(primsInLeaves(report) == boxes.size());
+  CHECK(report.leafSizeHistogram.size() <= 5);
+  CHECK(report.meanOverlapRatio == 1.);
+}
+
+void testTriangles()
+{
+  // two triangles per unit quad, on a grid with gaps
+  const int n = 20;
+  std::vector<vec3f> vertices;
+  std::vector<vec3i> indices;
+  std::vector<box3f> bounds;
+  for (int y=0;y<n;y++)
+    for (int x=0;x<n;x++) {
+      const int base = (int)vertices.size();
+      vertices.push_back(vec3f(2.f*x,    2.f*y,    0.f));
+      vertices.push_back(vec3f(2.f*x+1.f,2.f*y,    .5f));
+      vertices.push_back(vec3f(2.f*x+1.f,2.f*y+1.f,0.f));
+      vertices.push_back(vec3f(2.f*x,    2.f*y+1.f,.5f));
+      indices.push_back(vec3i(base,base+1,base+2));
+      indices.push_back(vec3i(base,base+2,base+3));
+      for (int t=0;t<2;t++) {
+        const vec3i &tri = indices[indices.size()-2+t];
+        box3f box;
+        for (int i=0;i<3;i++) box.extend(vertices[tri[i]]);
+        bounds.push_back(box);
+      }
+    }
+  const BVHQualityReport fromTriangles
+    = analyzeBVHQuality(vertices.data(),vertices.size(),
+                        indices.data(),indices.size());
+  const BVHQualityReport fromBounds
+    = analyzeBVHQuality(bounds.data(),bounds.size());
+  CHECK(fromTriangles.numPrims == indices.size());
+  CHECK(fromTriangles.sahCost == fromBounds.sahCost);
+  CHECK(fromTriangles.leafSizeHistogram == fromBounds.leafSizeHistogram);
+
+  indices[17].y = (int)vertices.size();
+  bool threw = false;
+  try {
+    analyzeBVHQuality(vertices.data(),vertices.size(),
+                      indices.data(),indices.size());
+  } catch (std::runtime_error &e) {
+    threw = contains(e.what(),"#17");
+  }
+  CHECK(threw);
+}
+
+void testLarge()
+{
+  // large enough for parallel binning and sub-tree builds
+  const std::vector<box3f> boxes = randomBoxes(300000);
+  const BVHQualityReport a = analyzeBVHQuality(boxes.data(),boxes.size());
+  const BVHQualityReport b = analyzeBVHQuality(boxes.data(),boxes.size());
+  CHECK(primsInLeaves(a) == boxes.size());
+  CHECK(a.leafSizeHistogram.size() <= 9);
+  CHECK(a.numLeaves == a.numInnerNodes+1);
+  CHECK(a.sahCost < a.flatCost);
+  CHECK(a.sahCost == b.sahCost);
+  CHECK(a.overlapArea == b.overlapArea);
+  CHECK(a.leafSizeHistogram == b.leafSizeHistogram);
+  CHECK(a.maxDepth == b.maxDepth);
+  CHECK(a.costliestLeaves[0].primIDs == b.costliestLeaves[0].primIDs);
+}
+
+void testReport()
+{
+  std::vector<box3f> boxes = gridBoxes(4);
+  boxes[5] = box3f();
+  const BVHQualityReport report
+    = analyzeBVHQuality(boxes.data(),boxes.size());
+  std::stringstream ss;
+  writeReport(ss,report);
+  const std::string text = ss.str();
+  CHECK(contains(text,"SAH cost"));
+  CHECK(contains(text,"leaf sizes"));
+  CHECK(contains(text,"largest prims"));
+  CHECK(contains(text,"costliest leaves"));
+  CHECK(contains(text,"1 with empty or non-finite bounds"));
+}
+
+int main(int ac, char **av)
+{
+  testSeparated();
+  testHugePrim();
+  testInvalid();
+  testDegenerate();
+  testTriangles();
+  testLarge();
+  testReport();
+  return owl::test::allPassed("bvh quality");
+}
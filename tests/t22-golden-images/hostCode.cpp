@@ -0,0 +1,281 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Tests the golden-image harness (tests/common/GoldenImage.h) on
+// frames from a small host-side reference renderer, so it can run
+// without a GPU: that the (SIMD, parallel) diff agrees with a plain
+// per-pixel one, that PSNR and max error come out right, and that
+// golden images get created, matched, and - with a heatmap of the
+// differences - rejected.
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "tests/common/GoldenImage.h"
+// std
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace owl::test;
+using owl::common::vec3f;
+
+#define OWL_TEST_NAME "t22"
+#include "tests/common/Check.h"
+
+inline uint32_t packRGBA(const vec3f &color)
+{
+  uint32_t rgba = 0xff000000;
+  for (int c=0;c<3;c++) {
+    const float v = std::min(std::max(color[c],0.f),1.f);
+    rgba |= uint32_t(255.99f*v) << (8*c);
+  }
+  return rgba;
+}
+
+/*! the reference renderer: a row of diffuse spheres over a sky
+    gradient, ray cast with an orthographic camera; 'offset' moves
+    the middle sphere */
+Image renderReference(const vec2i &size, float offset = 0.f)
+{
+  const vec3f center[3] = {
+    vec3f(-.6f,0.f,0.f), vec3f(offset,0.f,0.f), vec3f(.6f,0.f,0.f)
+  };
+  const vec3f color[3] = {
+    vec3f(.8f,.2f,.2f), vec3f(.2f,.8f,.2f), vec3f(.2f,.2f,.8f)
+  };
+  const vec3f lightDir = normalize(vec3f(1.f,1.f,1.f));
+  const float radius = .25f;
+
+  Image image(size);
+  owl::common::parallel_for
+    (size.y,[&](int y){
+      for (int x=0;x<size.x;x++) {
+        const float u = (x+.5f)/size.x*2.f-1.f;
+        const float v = ((y+.5f)/size.y*2.f-1.f)*size.y/size.x;
+        vec3f result
+          = (1.f-.5f*(v+1.f))*vec3f(1.f) + .5f*(v+1.f)*vec3f(.5f,.7f,1.f);
+        for (int i=0;i<3;i++) {
+          const float dx = u-center[i].x, dy = v-center[i].y;
+          const float d2 = dx*dx+dy*dy;
+          if (d2 > radius*radius) continue;
+          const vec3f N(dx/radius,dy/radius,std::sqrt(1.f-d2/(radius*radius)));
+          result = color[i]*(.2f+.8f*std::max(dot(N,lightDir),0.f));
+        }
+        image.pixels[size_t(y)*size.x+x] = packRGBA(result);
+      }
+    });
+  return image;
+}
+
+/*! the plain per-pixel diff the harness' diff has to agree with */
+void bruteForceDiff(const Image &a, const Image &b, int tolerance,
+                    bool compareAlpha, uint64_t &sumSquares,
+                    int &maxError, vec2i &maxErrorPixel,
+                    size_t &numDiffering)
+{
+  sumSquares = 0; maxError = 0; numDiffering = 0;
+  maxErrorPixel = vec2i(-1);
+  for (int y=0;y<a.size.y;y++)
+    for (int x=0;x<a.size.x;x++) {
+      const size_t i = size_t(y)*a.size.x+x;
+      int pixelMax = 0;
+      for (int c=0;c<(compareAlpha?4:3);c++) {
+        const int d = std::abs(int((a.pixels[i] >> (8*c)) & 0xff)
+                               - int((b.pixels[i] >> (8*c)) & 0xff));
+        sumSquares += d*d;
+        pixelMax = std::max(pixelMax,d);
+      }
+      if (pixelMax > maxError) {
+        maxError      = pixelMax;
+        maxErrorPixel = vec2i(x,y);
+      }
+      numDiffering += (pixelMax > tolerance);
+    }
+}
+
+/*! 'image' with pseudo-random noise of up to +/-amplitude in some
+    pixels' channels, alpha included */
+Image addNoise(const Image &image, int amplitude, uint32_t seed)
+{
+  Image result = image;
+  uint32_t state = seed;
+  for (auto &pixel : result.pixels) {
+    state = state*1664525u+1013904223u;
+    if ((state >> 28) > 3) continue;
+    uint32_t noisy = 0;
+    for (int c=0;c<4;c++) {
+      state = state*1664525u+1013904223u;
+      const int delta = int((state >> 16) % (2*amplitude+1)) - amplitude;
+      const int v = std::min(std::max(int((pixel >> (8*c)) & 0xff)+delta,0),255);
+      noisy |= uint32_t(v) << (8*c);
+    }
+    pixel = noisy;
+  }
+  return result;
+}
+
+void testIdentical()
+{
+  const Image image = renderReference(vec2i(64,48));
+  const DiffResult result = diffImages(image,image);
+  CHECK(result.passed);
+  CHECK(std::isinf(result.psnr));
+  CHECK(result.mse == 0.);
+  CHECK(result.maxError == 0);
+  CHECK(result.maxErrorPixel == vec2i(-1));
+  CHECK(result.numDifferingPixels == 0);
+}
+
+void testAgainstBruteForce()
+{
+  // odd widths exercise the non-SIMD tail; the large one the
+  // parallel blocks
+  const vec2i sizes[] = { vec2i(37,23), vec2i(3,5), vec2i(1000,700) };
+  for (auto size : sizes)
+    for (int compareAlpha=0;compareAlpha<2;compareAlpha++) {
+      const Image a = renderReference(size);
+      const Image b = addNoise(a,6,size.x*7+compareAlpha);
+      DiffOptions options;
+      options.tolerance    = 3;
+      options.compareAlpha = compareAlpha;
+      options.makeHeatmap  = true;
+      const DiffResult result = diffImages(b,a,options);
+
+      uint64_t sumSquares;
+      int      maxError;
+      vec2i    maxErrorPixel;
+      size_t   numDiffering;
+      bruteForceDiff(b,a,3,compareAlpha,
+                     sumSquares,maxError,maxErrorPixel,numDiffering);
+      const size_t numValues = a.pixels.size()*(compareAlpha?4:3);
+      CHECK(result.mse == double(sumSquares)/numValues);
+      CHECK(result.maxError == maxError);
+      CHECK(result.maxErrorPixel == maxErrorPixel);
+      CHECK(result.numDifferingPixels == numDiffering);
+      CHECK(result.heatmap.size == size);
+      for (size_t i=0;i<a.pixels.size();i++) {
+        const uint32_t mask = compareAlpha ? 0xffffffff : 0x00ffffff;
+        const bool same = ((a.pixels[i]^b.pixels[i]) & mask) == 0;
+        CHECK(same == (result.heatmap.pixels[i] == 0xff000000));
+      }
+    }
+}
+
+void testPSNR()
+{
+  // every pixel's red off by exactly 4: mse = 16/3
+  Image a(vec2i(33,17));
+  for (size_t i=0;i<a.pixels.size();i++)
+    a.pixels[i] = 0xff000000 | uint32_t(i*7 % 200) | (uint32_t(i % 256) << 8);
+  Image b = a;
+  for (auto &pixel : b.pixels)
+    pixel += 4;
+  const DiffResult result = diffImages(a,b);
+  const double expected = 10.*std::log10(255.*255.*3./16.);
+  CHECK(std::abs(result.psnr-expected) < 1e-9);
+  CHECK(result.maxError == 4);
+  CHECK(result.maxErrorPixel == vec2i(0,0));
+  // above the default tolerance of 2, so all pixels differ...
+  CHECK(result.numDifferingPixels == a.pixels.size());
+  CHECK(!result.passed);
+  // ... but not above a tolerance of 4
+  DiffOptions options;
+  options.tolerance = 4;
+  CHECK(diffImages(a,b,options).passed);
+
+  // alpha only counts if asked to
+  Image c = a;
+  c.pixels[5] &= 0x00ffffff;
+  CHECK(diffImages(a,c).passed);
+  options.compareAlpha = true;
+  CHECK(!diffImages(a,c,options).passed);
+}
+
+bool fileExists(const std::string &fileName)
+{
+  FILE *file = fopen(fileName.c_str(),"rb");
+  if (file) fclose(file);
+  return file != nullptr;
+}
+
+void testGolden()
+{
+  const std::string golden = "t22-golden.png";
+  const vec2i size(160,120);
+  std::remove(golden.c_str());
+  std::remove("t22-golden.actual.png");
+  std::remove("t22-golden.heatmap.png");
+
+  const Image frame = renderReference(size);
+  DiffResult result
+    = compareToGolden(frame.pixels.data(),size,golden,DiffOptions(),false);
+  CHECK(result.goldenMissing);
+  CHECK(!result.passed);
+  // (the frame still gets written, so it can be checked and copied)
+  CHECK(fileExists("t22-golden.actual.png"));
+  std::remove("t22-golden.actual.png");
+
+  result = compareToGolden(frame.pixels.data(),size,golden,DiffOptions(),true);
+  CHECK(result.goldenUpdated);
+  CHECK(result.passed);
+  Image stored;
+  CHECK(stored.load(golden));
+  CHECK(stored.size == size);
+  CHECK(stored.pixels == frame.pixels);
+
+  // the same frame matches, and so does one with a bit of noise
+  result = compareToGolden(frame.pixels.data(),size,golden,DiffOptions(),false);
+  CHECK(result.passed);
+  const Image noisy = addNoise(frame,1,42);
+  result = compareToGolden(noisy.pixels.data(),size,golden,DiffOptions(),false);
+  CHECK(result.passed);
+  CHECK(result.maxError == 1);
+  CHECK(!fileExists("t22-golden.actual.png"));
+
+  // a moved sphere does not, and leaves the frame and a heatmap
+  const Image moved = renderReference(size,.05f);
+  result = compareToGolden(moved.pixels.data(),size,golden,DiffOptions(),false);
+  CHECK(!result.passed);
+  CHECK(result.numDifferingPixels > 0);
+  Image heatmap, actual;
+  CHECK(heatmap.load("t22-golden.heatmap.png"));
+  CHECK(heatmap.size == size);
+  CHECK(actual.load("t22-golden.actual.png"));
+  CHECK(actual.pixels == moved.pixels);
+
+  // so does a frame of a different size
+  const Image smaller = renderReference(vec2i(80,60));
+  result = compareToGolden(smaller.pixels.data(),smaller.size,golden,
+                           DiffOptions(),false);
+  CHECK(result.sizeMismatch);
+  CHECK(!result.passed);
+
+  std::remove(golden.c_str());
+  std::remove("t22-golden.actual.png");
+  std::remove("t22-golden.heatmap.png");
+}
+
+int main(int ac, char **av)
+{
+  testIdentical();
+  testAgainstBruteForce();
+  testPSNR();
+  testGolden();
+  return owl::test::allPassed("golden image");
+}
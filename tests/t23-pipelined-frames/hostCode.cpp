@@ -0,0 +1,116 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Checks frame pipelining (owlContextSetFramePipelining) end to end:
+// SBT builds that happen while the previous frame's launch is still
+// in flight must not change what that launch sees, and each launch
+// has to pick up the newest SBT that was built before it.
+
+#include "tests/common/HitTestScene.h"
+
+#define OWL_TEST_NAME "t23"
+#include "tests/common/Check.h"
+
+using namespace owl::test;
+
+extern "C" char ptxCode[];
+
+void enablePipelining(OWLContext context)
+{
+  owlContextSetFramePipelining(context,1);
+}
+
+int main(int ac, char **av)
+{
+  HitTestScene scene(ptxCode,vec2i(64),enablePipelining);
+  OWLGeom quad = scene.createQuad(0,vec2f(.25f),vec2f(.75f));
+  OWLGroup world = owlTrianglesGeomGroupCreate(scene.context,1,&quad);
+  owlGroupBuildAccel(world);
+  scene.buildPrograms();
+
+  // one frame at a time: every launch sees the SBT built right
+  // before it, no matter which of the two copies that went to
+  for (int frameID=0;frameID<8;frameID++) {
+    owlGeomSet1i(quad,"tag",100+frameID);
+    const std::vector<HitRecord> hits = scene.render(world);
+    CHECK(scene.hitAt(hits,vec2f(.5f)).geomTag == 100+frameID);
+    CHECK(scene.hitAt(hits,vec2f(.1f)).geomTag == -1);
+  }
+
+  // launches that are still in flight while the next frame's SBT
+  // gets built, each writing into its own buffer: every launch has
+  // to see the build right before it. Alternating between two sets
+  // of launch params also puts them on two different streams.
+  const int numFrames = 32;
+  OWLVarDecl paramsVars[] = {
+    { "world",   OWL_GROUP,  OWL_OFFSETOF(HitTestParams,world) },
+    { "hits",    OWL_BUFPTR, OWL_OFFSETOF(HitTestParams,hits) },
+    { "fbSize",  OWL_INT2,   OWL_OFFSETOF(HitTestParams,fbSize) },
+    { "rayMask", OWL_INT,    OWL_OFFSETOF(HitTestParams,rayMask) },
+    { "mergedMeshes", OWL_INT, OWL_OFFSETOF(HitTestParams,mergedMeshes) },
+    { /* sentinel */ }
+  };
+  OWLLaunchParams launchParams[2] = {
+    scene.launchParams,
+    owlLaunchParamsCreate(scene.context,sizeof(HitTestParams),
+                          paramsVars,-1)
+  };
+  owlLaunchParamsSetGroup(launchParams[1],"world",world);
+  owlLaunchParamsSet2i(launchParams[1],"fbSize",
+                       scene.fbSize.x,scene.fbSize.y);
+  owlLaunchParamsSet1i(launchParams[1],"rayMask",255);
+  // (allocating pinned memory can sync the device, so do that up
+  // front)
+  std::vector<OWLBuffer> frameHits(numFrames);
+  for (auto &buffer : frameHits)
+    buffer = owlHostPinnedBufferCreate(scene.context,OWL_USER_TYPE(HitRecord),
+                                       scene.fbSize.x*scene.fbSize.y);
+  for (int frameID=0;frameID<numFrames;frameID++) {
+    OWLLaunchParams lp = launchParams[frameID%2];
+    owlLaunchParamsSetBuffer(lp,"hits",frameHits[frameID]);
+    owlGeomSet1i(quad,"tag",200+frameID);
+    owlBuildSBT(scene.context);
+    owlParamsLaunch2D(scene.rayGen,scene.fbSize.x,scene.fbSize.y,lp);
+  }
+  cudaDeviceSynchronize();
+  for (int frameID=0;frameID<numFrames;frameID++) {
+    const HitRecord *hits
+      = (const HitRecord *)owlBufferGetPointer(frameHits[frameID],0);
+    const std::vector<HitRecord> frame(hits,hits+scene.fbSize.x*scene.fbSize.y);
+    CHECK(scene.hitAt(frame,vec2f(.5f)).geomTag == 200+frameID);
+    // and nothing of any other frame's build
+    CHECK(HitTestScene::countTag(frame,200+frameID)
+          + HitTestScene::countTag(frame,-1) == frame.size());
+  }
+  owlLaunchParamsSetBuffer(scene.launchParams,"hits",scene.hitBuffer);
+  for (auto buffer : frameHits)
+    owlBufferRelease(buffer);
+
+  // launching again without a rebuild re-uses the newest copy
+  std::vector<HitRecord> hits = scene.launch();
+  CHECK(scene.hitAt(hits,vec2f(.5f)).geomTag == 200+numFrames-1);
+
+  // and switching pipelining off in between keeps everything intact
+  owlContextSetFramePipelining(scene.context,0);
+  owlGeomSet1i(quad,"tag",300);
+  hits = scene.render(world);
+  CHECK(scene.hitAt(hits,vec2f(.5f)).geomTag == 300);
+
+  owlGeomRelease(quad);
+  owlGroupRelease(world);
+  return allPassed("pipelined frame");
+}
@@ -0,0 +1,126 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Checks the validation layer (owlEnableValidation) on a real
+// context: handles to destroyed objects and broken variable
+// declarations have to throw - and leave the context in a state where
+// things keep working - while valid node graphs (and the variables
+// of a real SBT build) must pass all checks and render as usual.
+
+#include "tests/common/HitTestScene.h"
+// std
+#include <stdexcept>
+#include <string>
+
+#define OWL_TEST_NAME "t24"
+#include "tests/common/Check.h"
+
+using namespace owl::test;
+
+extern "C" char ptxCode[];
+
+void configure(OWLContext context)
+{
+  owlEnableValidation(1);
+  owlSetMaxInstancingDepth(context,2);
+}
+
+/*! calls 'f', and returns the message of the exception it threw, or
+    an empty string if it didn't throw */
+template<typename Lambda>
+std::string errorOf(const Lambda &f)
+{
+  try { f(); }
+  catch (std::exception &e) { return e.what(); }
+  return "";
+}
+
+bool contains(const std::string &s, const std::string &what)
+{
+  return s.find(what) != std::string::npos;
+}
+
+int main(int ac, char **av)
+{
+  HitTestScene scene(ptxCode,vec2i(64),configure);
+  OWLGeom  quad  = scene.createQuad(7,vec2f(.25f),vec2f(.75f));
+  OWLGroup quads = owlTrianglesGeomGroupCreate(scene.context,1,&quad);
+  owlGroupBuildAccel(quads);
+  OWLGroup inner = owlInstanceGroupCreate(scene.context,1,&quads);
+  owlGroupBuildAccel(inner);
+  OWLGroup outer = owlInstanceGroupCreate(scene.context,1,&inner);
+  owlGroupBuildAccel(outer);
+  scene.buildPrograms();
+
+  std::vector<HitRecord> hits = scene.render(outer);
+  CHECK(scene.hitAt(hits,vec2f(.5f)).geomTag == 7);
+
+  // using a handle whose buffer was destroyed
+  OWLBuffer scratch
+    = owlDeviceBufferCreate(scene.context,OWL_USER_TYPE(HitRecord),1,nullptr);
+  owlBufferDestroy(scratch);
+  const HitRecord record = { 1,2,3,4 };
+  CHECK(contains(errorOf([&]{ owlBufferUpload(scratch,&record); }),
+                 "already destroyed"));
+
+  // variable declarations with duplicate names, or overlapping
+  OWLVarDecl duplicateVars[] = {
+    { "tag", OWL_INT, 0 },
+    { "tag", OWL_INT, 4 },
+    { /* sentinel */ }
+  };
+  CHECK(contains(errorOf([&]{
+          owlGeomTypeCreate(scene.context,OWL_GEOMETRY_TRIANGLES,
+                            8,duplicateVars,-1); }),
+      "duplicate variable name"));
+  OWLVarDecl overlappingVars[] = {
+    { "a", OWL_INT2, 0 },
+    { "b", OWL_INT,  4 },
+    { /* sentinel */ }
+  };
+  CHECK(contains(errorOf([&]{
+          owlGeomTypeCreate(scene.context,OWL_GEOMETRY_TRIANGLES,
+                            8,overlappingVars,-1); }),
+      "overlap"));
+
+  // a two-level-instancing graph, with two children of the same
+  // group, passes validation (at the configured max depth of 2)
+  OWLGroup pair = owlInstanceGroupCreate(scene.context,2);
+  owlInstanceGroupSetChild(pair,0,quads);
+  owlInstanceGroupSetChild(pair,1,quads);
+  owlInstanceGroupSetTransform(pair,1,Translation(vec3f(-.5f,0.f,0.f)).xfm,
+                               OWL_MATRIX_FORMAT_OWL);
+  CHECK(errorOf([&]{ owlGroupBuildAccel(pair); }).empty());
+  OWLGroup top = owlInstanceGroupCreate(scene.context,1,&pair);
+  CHECK(errorOf([&]{ owlGroupBuildAccel(top); }).empty());
+
+  // and the context keeps working after all these errors
+  hits = scene.render(top);
+  CHECK(scene.hitAt(hits,vec2f(.5f)).geomTag == 7);
+  CHECK(scene.hitAt(hits,vec2f(.1f,.5f)).geomTag == 7);
+  CHECK(scene.hitAt(hits,vec2f(.1f,.5f)).instanceID == 1);
+  hits = scene.render(outer);
+  CHECK(scene.hitAt(hits,vec2f(.5f)).geomTag == 7);
+
+  owlGroupRelease(top);
+  owlGroupRelease(pair);
+  owlGroupRelease(outer);
+  owlGroupRelease(inner);
+  owlGroupRelease(quads);
+  owlGeomRelease(quad);
+  return allPassed("validation");
+}
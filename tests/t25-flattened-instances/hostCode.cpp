@@ -0,0 +1,105 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Checks instance flattening (owlInstanceGroupSetFlattening) end to
+// end: a three-level instance graph under a flattening group has to
+// render with a max instancing depth of one (and pass validation),
+// with composed transforms, the top group's instance IDs, and
+// and'ed visibility masks.
+
+#include "tests/common/HitTestScene.h"
+
+#define OWL_TEST_NAME "t25"
+#include "tests/common/Check.h"
+
+using namespace owl::test;
+
+extern "C" char ptxCode[];
+
+void configure(OWLContext context)
+{
+  owlEnableValidation(1);
+}
+
+void setTranslation(OWLGroup group, int childID, const vec3f &delta)
+{
+  owlInstanceGroupSetTransform(group,childID,Translation(delta).xfm,
+                               OWL_MATRIX_FORMAT_OWL);
+}
+
+int main(int ac, char **av)
+{
+  HitTestScene scene(ptxCode,vec2i(64),configure);
+  OWLGeom  quad  = scene.createQuad(3,vec2f(0.f),vec2f(.2f));
+  OWLGroup quads = owlTrianglesGeomGroupCreate(scene.context,1,&quad);
+  owlGroupBuildAccel(quads);
+
+  // top -> mid (2x) -> leaf (1x) -> quads: four quads in a 2x2 grid
+  OWLGroup leaf = owlInstanceGroupCreate(scene.context,1,&quads);
+  setTranslation(leaf,0,vec3f(.05f,.05f,0.f));
+  owlGroupBuildAccel(leaf);
+  OWLGroup mid = owlInstanceGroupCreate(scene.context,2);
+  owlInstanceGroupSetChild(mid,0,leaf);
+  owlInstanceGroupSetChild(mid,1,leaf);
+  setTranslation(mid,1,vec3f(.5f,0.f,0.f));
+  owlInstanceGroupSetVisibilityMask(mid,1,0x2);
+  OWLGroup top = owlInstanceGroupCreate(scene.context,2);
+  owlInstanceGroupSetChild(top,0,mid);
+  owlInstanceGroupSetChild(top,1,mid);
+  setTranslation(top,1,vec3f(0.f,.5f,0.f));
+  owlInstanceGroupSetInstanceID(top,1,7);
+  owlInstanceGroupSetFlattening(top,1,16);
+  owlGroupBuildAccel(top);
+  scene.buildPrograms();
+
+  std::vector<HitRecord> hits = scene.render(top);
+  const vec2f quadCenter[4] = {
+    vec2f(.15f,.15f), vec2f(.65f,.15f), vec2f(.15f,.65f), vec2f(.65f,.65f)
+  };
+  for (int i=0;i<4;i++) {
+    const HitRecord hit = scene.hitAt(hits,quadCenter[i]);
+    CHECK(hit.geomTag == 3);
+    // the instance ID of the child of 'top' the hit came through
+    CHECK(hit.instanceID == (i < 2 ? 0 : 7));
+  }
+  // nothing outside of the (translated) quads
+  CHECK(scene.hitAt(hits,vec2f(.02f,.02f)).geomTag == -1);
+  CHECK(scene.hitAt(hits,vec2f(.4f,.4f)).geomTag == -1);
+  CHECK(HitTestScene::countTag(hits,3) > 0);
+
+  // mid's mask on its second child carries over into the flattened
+  // instances
+  hits = scene.render(top,0x1);
+  CHECK(scene.hitAt(hits,quadCenter[0]).geomTag == 3);
+  CHECK(scene.hitAt(hits,quadCenter[1]).geomTag == -1);
+  CHECK(scene.hitAt(hits,quadCenter[2]).geomTag == 3);
+  CHECK(scene.hitAt(hits,quadCenter[3]).geomTag == -1);
+
+  // moving a nested instance shows up after rebuilding the top group
+  setTranslation(leaf,0,vec3f(.25f,.25f,0.f));
+  owlGroupBuildAccel(top);
+  hits = scene.render(top);
+  CHECK(scene.hitAt(hits,quadCenter[0]).geomTag == -1);
+  CHECK(scene.hitAt(hits,vec2f(.35f,.35f)).geomTag == 3);
+
+  owlGroupRelease(top);
+  owlGroupRelease(mid);
+  owlGroupRelease(leaf);
+  owlGroupRelease(quads);
+  owlGeomRelease(quad);
+  return allPassed("flattened instance");
+}
@@ -0,0 +1,114 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Checks group splitting (owlContextSetGroupSplitting) of geom groups
+// end to end: with OWL_MAX_PRIMS_PER_GAS=2 (see CMakeLists.txt), a
+// geom group of six triangles gets split into three parts, and has
+// to render with the same tags, primitive IDs, and - when instanced
+// - the same instance IDs and visibility masks as if it had not been
+// split.
+
+#include "tests/common/HitTestScene.h"
+
+#define OWL_TEST_NAME "t26"
+#include "tests/common/Check.h"
+
+using namespace owl::test;
+
+extern "C" char ptxCode[];
+
+void configure(OWLContext context)
+{
+  owlContextSetGroupSplitting(context,1);
+}
+
+int main(int ac, char **av)
+{
+  // otherwise nothing would get split, and this test be meaningless
+  CHECK(getenv("OWL_MAX_PRIMS_PER_GAS") != nullptr);
+  
+  HitTestScene scene(ptxCode,vec2i(64),configure);
+  // one quad with tag 1, and one geom of two quads with tag 2 - whose
+  // four triangles end up in two different parts
+  std::vector<vec3f> vertices
+    = HitTestScene::quadVertices(vec2f(.3f,0.f),vec2f(.5f,.2f));
+  std::vector<vec3i> indices = HitTestScene::quadIndices();
+  for (auto v : HitTestScene::quadVertices(vec2f(.6f,0.f),vec2f(.8f,.2f)))
+    vertices.push_back(v);
+  for (auto idx : HitTestScene::quadIndices())
+    indices.push_back(idx+vec3i(4));
+  OWLGeom geoms[2] = {
+    scene.createQuad(1,vec2f(0.f),vec2f(.2f)),
+    scene.createTriangles(2,vertices,indices)
+  };
+  OWLGroup split = owlTrianglesGeomGroupCreate(scene.context,2,geoms);
+  owlGroupBuildAccel(split);
+
+  OWLGroup world = owlInstanceGroupCreate(scene.context,2);
+  owlInstanceGroupSetChild(world,0,split);
+  owlInstanceGroupSetChild(world,1,split);
+  owlInstanceGroupSetTransform(world,1,Translation(vec3f(0.f,.5f,0.f)).xfm,
+                               OWL_MATRIX_FORMAT_OWL);
+  owlInstanceGroupSetInstanceID(world,0,11);
+  owlInstanceGroupSetInstanceID(world,1,12);
+  owlInstanceGroupSetVisibilityMask(world,1,0x2);
+  owlGroupBuildAccel(world);
+  scene.buildPrograms();
+
+  std::vector<HitRecord> hits = scene.render(world);
+  for (int i=0;i<2;i++) {
+    const float y = i ? .6f : .1f;
+    const int instanceID = i ? 12 : 11;
+    HitRecord hit = scene.hitAt(hits,vec2f(.1f,y));
+    CHECK(hit.geomTag == 1);
+    CHECK(hit.instanceID == instanceID);
+    CHECK(hit.primID == 0 || hit.primID == 1);
+    hit = scene.hitAt(hits,vec2f(.4f,y));
+    CHECK(hit.geomTag == 2);
+    CHECK(hit.instanceID == instanceID);
+    CHECK(hit.primID == 0 || hit.primID == 1);
+    hit = scene.hitAt(hits,vec2f(.7f,y));
+    CHECK(hit.geomTag == 2);
+    CHECK(hit.instanceID == instanceID);
+    CHECK(hit.primID == 2 || hit.primID == 3);
+  }
+  CHECK(scene.hitAt(hits,vec2f(.25f,.1f)).geomTag == -1);
+  CHECK(scene.hitAt(hits,vec2f(.7f,.35f)).geomTag == -1);
+
+  // the second instance's mask applies to all of its parts
+  hits = scene.render(world,0x1);
+  CHECK(scene.hitAt(hits,vec2f(.1f,.1f)).geomTag == 1);
+  CHECK(scene.hitAt(hits,vec2f(.7f,.1f)).geomTag == 2);
+  CHECK(scene.hitAt(hits,vec2f(.1f,.6f)).geomTag == -1);
+  CHECK(scene.hitAt(hits,vec2f(.7f,.6f)).geomTag == -1);
+
+  // traced directly, the split group still finds the right SBT
+  // records and primitive IDs, with an instance ID of 0
+  hits = scene.render(split);
+  HitRecord hit = scene.hitAt(hits,vec2f(.1f,.1f));
+  CHECK(hit.geomTag == 1 && hit.instanceID == 0);
+  hit = scene.hitAt(hits,vec2f(.7f,.1f));
+  CHECK(hit.geomTag == 2 && hit.instanceID == 0);
+  CHECK(hit.primID == 2 || hit.primID == 3);
+  CHECK(scene.hitAt(hits,vec2f(.1f,.6f)).geomTag == -1);
+
+  owlGroupRelease(world);
+  owlGroupRelease(split);
+  owlGeomRelease(geoms[0]);
+  owlGeomRelease(geoms[1]);
+  return allPassed("split geom group");
+}
@@ -0,0 +1,133 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Checks buffer dedup (owlContextSetBufferDedup) end to end: two
+// geoms whose vertex buffers got deduplicated, and that then get
+// uploaded to (and resized) one after the other, have to render with
+// their own, current vertices after rebuilding their groups - without
+// the upload to one of them changing the other.
+
+#include "tests/common/HitTestScene.h"
+
+#define OWL_TEST_NAME "t27"
+#include "tests/common/Check.h"
+
+using namespace owl::test;
+
+extern "C" char ptxCode[];
+
+void configure(OWLContext context)
+{
+  owlContextSetBufferDedup(context,1);
+}
+
+int main(int ac, char **av)
+{
+  HitTestScene scene(ptxCode,vec2i(64),configure);
+  const std::vector<vec3f> quad0
+    = HitTestScene::quadVertices(vec2f(0.f,0.f),vec2f(.2f,.2f));
+  const std::vector<vec3f> quad1
+    = HitTestScene::quadVertices(vec2f(.3f,0.f),vec2f(.5f,.2f));
+  const std::vector<vec3f> quad2
+    = HitTestScene::quadVertices(vec2f(.6f,0.f),vec2f(.8f,.2f));
+  const std::vector<vec3i> indices = HitTestScene::quadIndices();
+
+  // two geoms with identical vertex and index buffers, which thus
+  // share their allocations
+  OWLBuffer vertexBuffers[2], indexBuffers[2];
+  OWLGroup  groups[2];
+  for (int i=0;i<2;i++) {
+    vertexBuffers[i] = owlDeviceBufferCreate(scene.context,OWL_FLOAT3,
+                                             quad0.size(),quad0.data());
+    indexBuffers[i]  = owlDeviceBufferCreate(scene.context,OWL_INT3,
+                                             indices.size(),indices.data());
+    OWLGeom geom = owlGeomCreate(scene.context,scene.trianglesType);
+    owlTrianglesSetVertices(geom,vertexBuffers[i],
+                            quad0.size(),sizeof(vec3f),0);
+    owlTrianglesSetIndices(geom,indexBuffers[i],
+                           indices.size(),sizeof(vec3i),0);
+    owlGeomSet1i(geom,"tag",i+1);
+    groups[i] = owlTrianglesGeomGroupCreate(scene.context,1,&geom);
+    owlGeomRelease(geom);
+    owlGroupBuildAccel(groups[i]);
+  }
+  CHECK(owlContextGetBufferDedupBytesSaved(scene.context)
+        == quad0.size()*sizeof(vec3f)+indices.size()*sizeof(vec3i));
+  
+  // geom 2 ends up half a unit above geom 1
+  OWLGroup world = owlInstanceGroupCreate(scene.context,2,groups);
+  owlInstanceGroupSetTransform(world,1,Translation(vec3f(0.f,.5f,0.f)).xfm,
+                               OWL_MATRIX_FORMAT_OWL);
+  owlGroupBuildAccel(world);
+  scene.buildPrograms();
+
+  std::vector<HitRecord> hits = scene.render(world);
+  CHECK(scene.hitAt(hits,vec2f(.1f,.1f)).geomTag == 1);
+  CHECK(scene.hitAt(hits,vec2f(.1f,.6f)).geomTag == 2);
+
+  auto rebuild = [&](int groupID) {
+    owlGroupBuildAccel(groups[groupID]);
+    owlGroupBuildAccel(world);
+    return scene.render(world);
+  };
+  
+  // uploading to the first buffer while it is still shared must not
+  // affect the second geom...
+  owlBufferUpload(vertexBuffers[0],quad1.data());
+  hits = rebuild(0);
+  CHECK(scene.hitAt(hits,vec2f(.1f,.1f)).geomTag == -1);
+  CHECK(scene.hitAt(hits,vec2f(.4f,.1f)).geomTag == 1);
+  CHECK(scene.hitAt(hits,vec2f(.1f,.6f)).geomTag == 2);
+  CHECK(scene.hitAt(hits,vec2f(.4f,.6f)).geomTag == -1);
+
+  // ... and the second one, now the only user of the original
+  // allocation, gets uploaded to in place
+  owlBufferUpload(vertexBuffers[1],quad2.data());
+  hits = rebuild(1);
+  CHECK(scene.hitAt(hits,vec2f(.4f,.1f)).geomTag == 1);
+  CHECK(scene.hitAt(hits,vec2f(.1f,.6f)).geomTag == -1);
+  CHECK(scene.hitAt(hits,vec2f(.7f,.6f)).geomTag == 2);
+
+  // resizing moves the buffer, too
+  owlBufferResize(vertexBuffers[0],quad0.size());
+  owlBufferUpload(vertexBuffers[0],quad0.data());
+  hits = rebuild(0);
+  CHECK(scene.hitAt(hits,vec2f(.1f,.1f)).geomTag == 1);
+  CHECK(scene.hitAt(hits,vec2f(.4f,.1f)).geomTag == -1);
+  CHECK(scene.hitAt(hits,vec2f(.7f,.6f)).geomTag == 2);
+
+  // a new buffer with the second geom's original contents must not
+  // alias the (since changed) allocation it used to share
+  OWLBuffer late = owlDeviceBufferCreate(scene.context,OWL_FLOAT3,
+                                         quad0.size(),quad0.data());
+  const vec3f *lateVertices
+    = (const vec3f *)owlBufferGetPointer(late,0);
+  CHECK(lateVertices != owlBufferGetPointer(vertexBuffers[1],0));
+  std::vector<vec3f> downloaded(quad0.size());
+  cudaMemcpy(downloaded.data(),lateVertices,
+             downloaded.size()*sizeof(vec3f),cudaMemcpyDeviceToHost);
+  CHECK(downloaded == quad0);
+
+  owlBufferRelease(late);
+  owlGroupRelease(world);
+  for (int i=0;i<2;i++) {
+    owlGroupRelease(groups[i]);
+    owlBufferRelease(vertexBuffers[i]);
+    owlBufferRelease(indexBuffers[i]);
+  }
+  return allPassed("dedup upload");
+}
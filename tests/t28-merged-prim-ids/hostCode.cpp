@@ -0,0 +1,75 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Checks mesh merging (owlTrianglesGeomGroupSetMeshMerging) end to
+// end: all geoms of a group get merged into a single build input,
+// yet each hit has to find its own geom's SBT record, and
+// owl::getPrimitiveIndexInGeom() has to map the merged primitive IDs
+// back to the geoms' own.
+
+#include "tests/common/HitTestScene.h"
+
+#define OWL_TEST_NAME "t28"
+#include "tests/common/Check.h"
+
+using namespace owl::test;
+
+extern "C" char ptxCode[];
+
+int main(int ac, char **av)
+{
+  HitTestScene scene(ptxCode);
+  // the third geom has two quads, so its upper quad's triangles are
+  // its primitives 2 and 3
+  std::vector<vec3f> vertices
+    = HitTestScene::quadVertices(vec2f(.6f,0.f),vec2f(.8f,.2f));
+  std::vector<vec3i> indices = HitTestScene::quadIndices();
+  for (auto v : HitTestScene::quadVertices(vec2f(.6f,.3f),vec2f(.8f,.5f)))
+    vertices.push_back(v);
+  for (auto idx : HitTestScene::quadIndices())
+    indices.push_back(idx+vec3i(4));
+  OWLGeom geoms[3] = {
+    scene.createQuad(1,vec2f(0.f,0.f),vec2f(.2f,.2f)),
+    scene.createQuad(2,vec2f(.3f,0.f),vec2f(.5f,.2f)),
+    scene.createTriangles(3,vertices,indices)
+  };
+  OWLGroup group = owlTrianglesGeomGroupCreate(scene.context,3,geoms);
+  owlTrianglesGeomGroupSetMeshMerging(group,8);
+  owlGroupBuildAccel(group);
+  scene.buildPrograms();
+  owlLaunchParamsSet1i(scene.launchParams,"mergedMeshes",1);
+
+  const std::vector<HitRecord> hits = scene.render(group);
+  struct { vec2f pos; int tag; int firstPrim; int firstMerged; } expected[] = {
+    { vec2f(.1f,.1f), 1, 0, 0 },
+    { vec2f(.4f,.1f), 2, 0, 2 },
+    { vec2f(.7f,.1f), 3, 0, 4 },
+    { vec2f(.7f,.4f), 3, 2, 6 }
+  };
+  for (auto &e : expected) {
+    const HitRecord hit = scene.hitAt(hits,e.pos);
+    CHECK(hit.geomTag == e.tag);
+    CHECK(hit.primID == e.firstMerged || hit.primID == e.firstMerged+1);
+    CHECK(hit.localPrimID == hit.primID - e.firstMerged + e.firstPrim);
+  }
+  CHECK(scene.hitAt(hits,vec2f(.4f,.4f)).geomTag == -1);
+
+  owlGroupRelease(group);
+  for (auto geom : geoms)
+    owlGeomRelease(geom);
+  return allPassed("merged primitive ID");
+}
@@ -0,0 +1,76 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Checks spatial sorting of instances (owlInstanceGroupSetSpatialSort)
+// end to end: the instances of a grid, created in anything but
+// spatial order, get re-ordered in the accel, but every hit still has
+// to report the instance ID of the child it came from - both the
+// default (child index) and explicitly set ones.
+
+#include "tests/common/HitTestScene.h"
+
+#define OWL_TEST_NAME "t29"
+#include "tests/common/Check.h"
+
+using namespace owl::test;
+
+extern "C" char ptxCode[];
+
+int main(int ac, char **av)
+{
+  HitTestScene scene(ptxCode);
+  OWLGeom  quad  = scene.createQuad(1,vec2f(0.f),vec2f(.1f));
+  OWLGroup quads = owlTrianglesGeomGroupCreate(scene.context,1,&quad);
+  owlGroupBuildAccel(quads);
+
+  // 4x4 grid of cells of size .25, in reverse order of the children
+  const int gridSize = 4;
+  const int numChildren = gridSize*gridSize;
+  auto cellOf = [&](int childID) {
+    const int cellID = numChildren-1-childID;
+    return vec2i(cellID % gridSize, cellID / gridSize);
+  };
+  OWLGroup world = owlInstanceGroupCreate(scene.context,numChildren);
+  for (int childID=0;childID<numChildren;childID++) {
+    const vec2f origin = vec2f(cellOf(childID))*.25f;
+    owlInstanceGroupSetChild(world,childID,quads);
+    owlInstanceGroupSetTransform(world,childID,
+                                 Translation(vec3f(origin.x,origin.y,0.f)).xfm,
+                                 OWL_MATRIX_FORMAT_OWL);
+  }
+  const int explicitChild = 5, explicitID = 1000;
+  owlInstanceGroupSetInstanceID(world,explicitChild,explicitID);
+  owlInstanceGroupSetSpatialSort(world,1);
+  owlGroupBuildAccel(world);
+  scene.buildPrograms();
+
+  const std::vector<HitRecord> hits = scene.render(world);
+  for (int childID=0;childID<numChildren;childID++) {
+    const vec2f center = vec2f(cellOf(childID))*.25f + vec2f(.05f);
+    const HitRecord hit = scene.hitAt(hits,center);
+    CHECK(hit.geomTag == 1);
+    CHECK(hit.instanceID
+          == (childID == explicitChild ? explicitID : childID));
+  }
+  CHECK(HitTestScene::countTag(hits,1) > 0);
+  CHECK(scene.hitAt(hits,vec2f(.2f,.2f)).geomTag == -1);
+
+  owlGroupRelease(world);
+  owlGroupRelease(quads);
+  owlGeomRelease(quad);
+  return allPassed("sorted instance");
+}
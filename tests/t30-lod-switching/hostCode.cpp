@@ -0,0 +1,89 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Checks level-of-detail selection (owlInstanceGroupSelectLOD) end
+// to end: two instances of a two-level LOD set have to render the
+// level that got selected for each of them, after rebuilding the
+// instance group's accel.
+
+#include "tests/common/HitTestScene.h"
+
+#define OWL_TEST_NAME "t30"
+#include "tests/common/Check.h"
+
+using namespace owl::test;
+
+extern "C" char ptxCode[];
+
+int main(int ac, char **av)
+{
+  HitTestScene scene(ptxCode);
+  // the same quad, with tag 1 for the fine and tag 2 for the coarse
+  // level
+  OWLGeom  geoms[2];
+  OWLGroup levels[2];
+  for (int i=0;i<2;i++) {
+    geoms[i]  = scene.createQuad(i+1,vec2f(0.f),vec2f(.2f));
+    levels[i] = owlTrianglesGeomGroupCreate(scene.context,1,&geoms[i]);
+    owlGroupBuildAccel(levels[i]);
+  }
+  const float errors[2] = { 0.f, 1.f };
+  OWLLODSet lodSet = owlLODSetCreate(scene.context,2,levels,errors);
+
+  OWLGroup world = owlInstanceGroupCreate(scene.context,2);
+  for (int childID=0;childID<2;childID++)
+    owlInstanceGroupSetChildLOD(world,childID,lodSet);
+  owlInstanceGroupSetTransform(world,1,Translation(vec3f(.5f,0.f,0.f)).xfm,
+                               OWL_MATRIX_FORMAT_OWL);
+  owlGroupBuildAccel(world);
+  scene.buildPrograms();
+
+  const vec2f center[2] = { vec2f(.1f,.1f), vec2f(.6f,.1f) };
+  auto renderTags = [&](int tag0, int tag1) {
+    const std::vector<HitRecord> hits = scene.render(world);
+    return scene.hitAt(hits,center[0]).geomTag == tag0
+      &&   scene.hitAt(hits,center[1]).geomTag == tag1;
+  };
+  
+  // children start out at the finest level
+  CHECK(renderTags(1,1));
+
+  // far away, both switch to the coarse level ...
+  const vec3f farAway(0.f,0.f,-100.f);
+  CHECK(owlInstanceGroupSelectLOD(world,&farAway.x,.1f) == 2);
+  owlGroupBuildAccel(world);
+  CHECK(renderTags(2,2));
+  // ... and selecting again changes nothing
+  CHECK(owlInstanceGroupSelectLOD(world,&farAway.x,.1f) == 0);
+
+  // close to the first child (at a distance of about .24, where its
+  // error of 1 exceeds the allowed 3*.24), but further from the
+  // second one (about .46, allowing 1.37): only the first child
+  // switches back to the fine level
+  const vec3f close(.1f,.1f,-.2f);
+  CHECK(owlInstanceGroupSelectLOD(world,&close.x,3.f) == 1);
+  owlGroupBuildAccel(world);
+  CHECK(renderTags(1,2));
+
+  owlGroupRelease(world);
+  owlLODSetRelease(lodSet);
+  for (int i=0;i<2;i++) {
+    owlGroupRelease(levels[i]);
+    owlGeomRelease(geoms[i]);
+  }
+  return allPassed("LOD switching");
+}
@@ -0,0 +1,86 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Checks transform baking (owlInstanceGroupSetTransformBaking) end to
+// end: baked instances of two different geom groups have to show up
+// in world space, with their geoms' own SBT records, and with the
+// documented instance ID; an instance with a non-default mask must
+// not get baked.
+
+#include "tests/common/HitTestScene.h"
+
+#define OWL_TEST_NAME "t31"
+#include "tests/common/Check.h"
+
+using namespace owl::test;
+
+extern "C" char ptxCode[];
+
+int main(int ac, char **av)
+{
+  HitTestScene scene(ptxCode);
+  OWLGeom  geoms[2];
+  OWLGroup groups[2];
+  for (int i=0;i<2;i++) {
+    geoms[i]  = scene.createQuad(i+1,vec2f(0.f),vec2f(.2f));
+    groups[i] = owlTrianglesGeomGroupCreate(scene.context,1,&geoms[i]);
+    owlGroupBuildAccel(groups[i]);
+  }
+
+  // one instance per quadrant; the third one of the second group,
+  // the fourth one with a mask that keeps it from getting baked
+  const int numChildren = 4;
+  const vec2f origin[numChildren] = {
+    vec2f(0.f,0.f), vec2f(.5f,0.f), vec2f(0.f,.5f), vec2f(.5f,.5f)
+  };
+  const int tag[numChildren] = { 1, 1, 2, 1 };
+  OWLGroup world = owlInstanceGroupCreate(scene.context,numChildren);
+  for (int childID=0;childID<numChildren;childID++) {
+    owlInstanceGroupSetChild(world,childID,groups[tag[childID]-1]);
+    owlInstanceGroupSetTransform
+      (world,childID,
+       Translation(vec3f(origin[childID].x,origin[childID].y,0.f)).xfm,
+       OWL_MATRIX_FORMAT_OWL);
+  }
+  owlInstanceGroupSetVisibilityMask(world,3,0x3);
+  owlInstanceGroupSetTransformBaking(world,8,8,1<<20);
+  owlGroupBuildAccel(world);
+  scene.buildPrograms();
+
+  const OWLTransformBakingStats stats
+    = owlInstanceGroupGetTransformBakingStats(world);
+  CHECK(stats.instancesBefore == 4);
+  CHECK(stats.instancesBaked  == 3);
+  CHECK(stats.trianglesBaked  == 6);
+  CHECK(stats.instancesAfter  == 2);
+
+  const std::vector<HitRecord> hits = scene.render(world);
+  for (int childID=0;childID<numChildren;childID++) {
+    const HitRecord hit = scene.hitAt(hits,origin[childID]+vec2f(.1f));
+    CHECK(hit.geomTag == tag[childID]);
+    // baked triangles report the group's number of children
+    CHECK(hit.instanceID == (childID == 3 ? 3 : numChildren));
+  }
+  CHECK(scene.hitAt(hits,vec2f(.3f,.3f)).geomTag == -1);
+
+  owlGroupRelease(world);
+  for (int i=0;i<2;i++) {
+    owlGroupRelease(groups[i]);
+    owlGeomRelease(geoms[i]);
+  }
+  return allPassed("baked transform");
+}
@@ -0,0 +1,69 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Checks owlRayGenBuildSBT() with several ray gens: each ray gen has
+// to see its own variables, both when only its own record gets
+// re-written, and when adding a ray gen makes owl re-build all ray
+// gen records from scratch.
+
+#include "tests/common/HitTestScene.h"
+
+#define OWL_TEST_NAME "t32"
+#include "tests/common/Check.h"
+
+using namespace owl::test;
+
+extern "C" char ptxCode[];
+
+/*! launches the given 'writeTag' ray gen, and returns what it wrote */
+int launchTag(HitTestScene &scene, OWLRayGen rayGen)
+{
+  owlRayGenLaunch2D(rayGen,1,1);
+  cudaDeviceSynchronize();
+  return scene.readHits()[0].geomTag;
+}
+
+int main(int ac, char **av)
+{
+  HitTestScene scene(ptxCode);
+  OWLRayGen first = scene.createRayGen("writeTag",11);
+  scene.buildPrograms();
+  owlBuildSBT(scene.context);
+  CHECK(launchTag(scene,first) == 11);
+
+  // a new ray gen changes the layout of the ray gen records, so this
+  // re-builds all of them - each with its own variables
+  OWLRayGen second = scene.createRayGen("writeTag",22);
+  scene.buildPrograms();
+  owlRayGenBuildSBT(second);
+  CHECK(launchTag(scene,second) == 22);
+  CHECK(launchTag(scene,first) == 11);
+
+  // and from now on, only the given ray gen's record changes
+  owlRayGenSet1i(first,"tag",33);
+  owlRayGenSet1i(second,"tag",44);
+  owlRayGenBuildSBT(first);
+  CHECK(launchTag(scene,first) == 33);
+  CHECK(launchTag(scene,second) == 22);
+  owlRayGenBuildSBT(second);
+  CHECK(launchTag(scene,second) == 44);
+  CHECK(launchTag(scene,first) == 33);
+
+  owlRayGenRelease(second);
+  owlRayGenRelease(first);
+  return allPassed("ray gen SBT");
+}
@@ -0,0 +1,92 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Checks owlContextApplyUpdates() end to end: a batch that moves one
+// instance (twice - only the last one may count), hides another one,
+// and changes a geom variable has to show up in the next launch
+// without any other rebuilds - which takes rebuilding the modified
+// instance group, the group above it, and the SBT.
+
+#include "tests/common/HitTestScene.h"
+#include "owl/ng/cpp/UpdateJournal.h"
+
+#define OWL_TEST_NAME "t33"
+#include "tests/common/Check.h"
+
+using namespace owl::test;
+using namespace owl::journal;
+using owl::affine3f;
+
+extern "C" char ptxCode[];
+
+void configure(OWLContext context)
+{
+  owlSetMaxInstancingDepth(context,2);
+}
+
+int main(int ac, char **av)
+{
+  HitTestScene scene(ptxCode,vec2i(64),configure);
+  OWLGeom  quad  = scene.createQuad(1,vec2f(0.f),vec2f(.2f));
+  OWLGroup quads = owlTrianglesGeomGroupCreate(scene.context,1,&quad);
+  owlGroupBuildAccel(quads);
+
+  // top -> world -> two instances of the quad
+  OWLGroup world = owlInstanceGroupCreate(scene.context,2);
+  owlInstanceGroupSetChild(world,0,quads);
+  owlInstanceGroupSetChild(world,1,quads);
+  owlInstanceGroupSetTransform(world,1,Translation(vec3f(.5f,0.f,0.f)).xfm,
+                               OWL_MATRIX_FORMAT_OWL);
+  owlGroupBuildAccel(world);
+  OWLGroup top = owlInstanceGroupCreate(scene.context,1,&world);
+  owlGroupBuildAccel(top);
+  scene.buildPrograms();
+
+  std::vector<HitRecord> hits = scene.render(top);
+  CHECK(scene.hitAt(hits,vec2f(.1f,.1f)).geomTag == 1);
+  CHECK(scene.hitAt(hits,vec2f(.6f,.1f)).geomTag == 1);
+  CHECK(scene.hitAt(hits,vec2f(.6f,.6f)).geomTag == -1);
+
+  Writer writer;
+  const affine3f moves[2] = {
+    affine3f::translate(vec3f(0.f,.5f,0.f)),
+    affine3f::translate(vec3f(.5f,.5f,0.f))
+  };
+  const int32_t worldID = owlGroupGetID(world);
+  writer.transforms(worldID,1,1,&moves[0]);
+  writer.transforms(worldID,1,1,&moves[1]);
+  const uint8_t hidden = 0;
+  writer.visibilityMasks(worldID,0,1,&hidden);
+  const int32_t newTag = 7;
+  writer.variable(OWL_UPDATE_TARGET_GEOM,owlGeomGetID(quad),
+                  /* "tag" */0,&newTag,sizeof(newTag));
+  CHECK(owlContextApplyUpdates(scene.context,
+                               writer.bytes.data(),writer.bytes.size()) == 3);
+
+  // no owlBuildSBT() or accel builds of our own
+  hits = scene.launch();
+  CHECK(scene.hitAt(hits,vec2f(.1f,.1f)).geomTag == -1);
+  CHECK(scene.hitAt(hits,vec2f(.6f,.1f)).geomTag == -1);
+  CHECK(scene.hitAt(hits,vec2f(.1f,.6f)).geomTag == -1);
+  CHECK(scene.hitAt(hits,vec2f(.6f,.6f)).geomTag == newTag);
+
+  owlGroupRelease(top);
+  owlGroupRelease(world);
+  owlGroupRelease(quads);
+  owlGeomRelease(quad);
+  return allPassed("applied update");
+}
@@ -0,0 +1,86 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Checks reference counting of node graph objects end to end: geoms,
+// buffers and groups whose handles the app already released have to
+// stay alive - and keep being built, written into the SBT, and
+// traced - as long as other objects use them, and replacing the last
+// user has to let them go without disturbing the rest of the scene.
+
+#include "tests/common/HitTestScene.h"
+
+#define OWL_TEST_NAME "t34"
+#include "tests/common/Check.h"
+
+using namespace owl::test;
+
+extern "C" char ptxCode[];
+
+/*! a geom group over a single quad with the given tag, of which the
+    caller only gets the group's handle */
+OWLGroup createQuadGroup(HitTestScene &scene, int tag,
+                         const vec2f &lower, const vec2f &upper)
+{
+  // (createQuad() already released the quad's buffers)
+  OWLGeom  quad  = scene.createQuad(tag,lower,upper);
+  OWLGroup group = owlTrianglesGeomGroupCreate(scene.context,1,&quad);
+  owlGeomRelease(quad);
+  return group;
+}
+
+int main(int ac, char **av)
+{
+  HitTestScene scene(ptxCode);
+  OWLGroup quads = createQuadGroup(scene,1,vec2f(0.f),vec2f(.2f));
+  // built only after its geom's handle is gone
+  owlGroupBuildAccel(quads);
+  OWLGroup world = owlInstanceGroupCreate(scene.context,2);
+  owlInstanceGroupSetChild(world,0,quads);
+  owlInstanceGroupSetChild(world,1,quads);
+  owlInstanceGroupSetTransform(world,1,Translation(vec3f(.5f,0.f,0.f)).xfm,
+                               OWL_MATRIX_FORMAT_OWL);
+  owlGroupRelease(quads);
+  owlGroupBuildAccel(world);
+  scene.buildPrograms();
+
+  std::vector<HitRecord> hits = scene.render(world);
+  CHECK(scene.hitAt(hits,vec2f(.1f,.1f)).geomTag == 1);
+  CHECK(scene.hitAt(hits,vec2f(.6f,.1f)).geomTag == 1);
+
+  // replacing one of the two uses keeps the group alive for the
+  // other one ...
+  OWLGroup other = createQuadGroup(scene,2,vec2f(0.f),vec2f(.2f));
+  owlGroupBuildAccel(other);
+  owlInstanceGroupSetChild(world,0,other);
+  owlGroupBuildAccel(world);
+  hits = scene.render(world);
+  CHECK(scene.hitAt(hits,vec2f(.1f,.1f)).geomTag == 2);
+  CHECK(scene.hitAt(hits,vec2f(.6f,.1f)).geomTag == 1);
+
+  // ... and replacing the last one lets it (and its geom) go, while
+  // the rest of the scene still renders
+  owlInstanceGroupSetChild(world,1,other);
+  owlGroupBuildAccel(world);
+  hits = scene.render(world);
+  CHECK(scene.hitAt(hits,vec2f(.1f,.1f)).geomTag == 2);
+  CHECK(scene.hitAt(hits,vec2f(.6f,.1f)).geomTag == 2);
+  CHECK(HitTestScene::countTag(hits,1) == 0);
+
+  owlGroupRelease(other);
+  owlGroupRelease(world);
+  return allPassed("released handle");
+}
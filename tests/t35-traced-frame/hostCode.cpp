@@ -0,0 +1,84 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Checks tracing (owlEnableTracing) end to end: setting up and
+// rendering a frame has to record the API calls as well as the
+// internal phases they trigger - program, pipeline, accel and SBT
+// builds, and the launch - and owlDumpTrace() has to write them out
+// as trace_event JSON.
+
+#include "tests/common/HitTestScene.h"
+// std
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#define OWL_TEST_NAME "t35"
+#include "tests/common/Check.h"
+
+using namespace owl::test;
+
+extern "C" char ptxCode[];
+
+const char *traceFile = "test35-trace.json";
+
+/*! whether the trace has an event of the given category and name */
+bool hasEvent(const std::string &json,
+              const std::string &category,
+              const std::string &name)
+{
+  return json.find("{\"name\":\""+name+"\",\"cat\":\""+category+"\"")
+    != std::string::npos;
+}
+
+int main(int ac, char **av)
+{
+  owlEnableTracing(1,nullptr);
+  {
+    HitTestScene scene(ptxCode);
+    OWLGeom  quad  = scene.createQuad(1,vec2f(0.f),vec2f(.2f));
+    OWLGroup quads = owlTrianglesGeomGroupCreate(scene.context,1,&quad);
+    owlGroupBuildAccel(quads);
+    scene.buildPrograms();
+    const std::vector<HitRecord> hits = scene.render(quads);
+    CHECK(scene.hitAt(hits,vec2f(.1f,.1f)).geomTag == 1);
+    owlGroupRelease(quads);
+    owlGeomRelease(quad);
+  }
+  owlEnableTracing(0,nullptr);
+  owlDumpTrace(traceFile);
+
+  std::ifstream in(traceFile);
+  std::stringstream ss;
+  ss << in.rdbuf();
+  const std::string json = ss.str();
+  CHECK(json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[") == 0);
+  
+  CHECK(hasEvent(json,"api","owlContextCreate"));
+  CHECK(hasEvent(json,"api","owlGroupBuildAccel"));
+  CHECK(hasEvent(json,"api","owlBuildSBT"));
+  CHECK(hasEvent(json,"api","owlParamsLaunch2D"));
+  CHECK(hasEvent(json,"build","buildPrograms"));
+  CHECK(hasEvent(json,"build","createPipeline"));
+  CHECK(hasEvent(json,"accel","groupBuildAccel"));
+  CHECK(hasEvent(json,"sbt","sbtHitProgsBuild"));
+  CHECK(hasEvent(json,"sbt","sbtRayGensBuild"));
+  CHECK(hasEvent(json,"launch","launch"));
+  // nothing after tracing got disabled again
+  CHECK(!hasEvent(json,"api","owlDumpTrace"));
+  return allPassed("traced frame");
+}
@@ -0,0 +1,92 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Checks logging (owlSetLogCallback, owlSetLogLevel) end to end: a
+// log callback has to receive the messages of a real context
+// creation and accel build - with their levels, and without
+// terminal colors or trailing newlines - and nothing above the
+// current log level.
+
+#include "tests/common/HitTestScene.h"
+// std
+#include <string>
+#include <vector>
+
+#define OWL_TEST_NAME "t36"
+#include "tests/common/Check.h"
+
+using namespace owl::test;
+
+extern "C" char ptxCode[];
+
+struct Received {
+  std::vector<OWLLogLevel> levels;
+  std::vector<std::string> messages;
+
+  /*! whether we got a message of the given level that contains
+      'what' */
+  bool has(OWLLogLevel level, const std::string &what) const
+  {
+    for (size_t i=0;i<messages.size();i++)
+      if (levels[i] == level && messages[i].find(what) != std::string::npos)
+        return true;
+    return false;
+  }
+};
+
+void collect(OWLLogLevel level, const char *message, void *userData)
+{
+  Received *received = (Received *)userData;
+  received->levels.push_back(level);
+  received->messages.push_back(message);
+}
+
+int main(int ac, char **av)
+{
+  Received received;
+  owlSetLogCallback(collect,&received);
+  owlSetLogLevel(OWL_LOG_DEBUG);
+  {
+    HitTestScene scene(ptxCode);
+    CHECK(received.has(OWL_LOG_INFO,"successfully created owl device"));
+
+    OWLGeom  quad  = scene.createQuad(1,vec2f(0.f),vec2f(.2f));
+    OWLGroup quads = owlTrianglesGeomGroupCreate(scene.context,1,&quad);
+    owlGroupBuildAccel(quads);
+    CHECK(received.has(OWL_LOG_DEBUG,"building triangles accel over 1 geometries"));
+    CHECK(received.has(OWL_LOG_DEBUG,"successfully build triangles geom group accel"));
+    for (auto &message : received.messages) {
+      CHECK(message.find('\033') == std::string::npos);
+      CHECK(message.empty() || message.back() != '\n');
+    }
+
+    // nothing but errors from here on - and there are none
+    owlSetLogLevel(OWL_LOG_ERROR);
+    received.levels.clear();
+    received.messages.clear();
+    owlGroupBuildAccel(quads);
+    scene.buildPrograms();
+    const std::vector<HitRecord> hits = scene.render(quads);
+    CHECK(scene.hitAt(hits,vec2f(.1f,.1f)).geomTag == 1);
+    CHECK(received.messages.empty());
+
+    owlGroupRelease(quads);
+    owlGeomRelease(quad);
+  }
+  owlSetLogCallback(nullptr,nullptr);
+  return allPassed("logged build");
+}
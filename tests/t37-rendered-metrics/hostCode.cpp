@@ -0,0 +1,114 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Checks owlContextGetMetrics end to end: building and rendering a
+// frame has to show up in the counters (API calls, SBT records and
+// bytes, per kind) and the accel build histograms - by exactly what
+// that frame did, as counters are totals since process start.
+
+#include "tests/common/HitTestScene.h"
+// std
+#include <string>
+
+#define OWL_TEST_NAME "t37"
+#include "tests/common/Check.h"
+
+using namespace owl::test;
+
+extern "C" char ptxCode[];
+
+/*! value of the given counter in the snapshot; 0 if it isn't in
+    there (yet) */
+uint64_t counter(const OWLMetrics *metrics, const std::string &name)
+{
+  for (size_t i=0;i<metrics->numCounters;i++)
+    if (metrics->counters[i].name == name)
+      return metrics->counters[i].value;
+  return 0;
+}
+
+/*! number of values in the given histogram; 0 if it isn't in there
+    (yet) */
+uint64_t histogramCount(const OWLMetrics *metrics, const std::string &name)
+{
+  for (size_t i=0;i<metrics->numHistograms;i++)
+    if (metrics->histograms[i].name == name)
+      return metrics->histograms[i].count;
+  return 0;
+}
+
+bool hasGauge(const OWLMetrics *metrics, const std::string &name)
+{
+  for (size_t i=0;i<metrics->numGauges;i++)
+    if (metrics->gauges[i].name == name)
+      return true;
+  return false;
+}
+
+int main(int ac, char **av)
+{
+  HitTestScene scene(ptxCode);
+  OWLGeom  quad  = scene.createQuad(1,vec2f(0.f),vec2f(.5f));
+  OWLGroup quads = owlTrianglesGeomGroupCreate(scene.context,1,&quad);
+  scene.buildPrograms();
+
+  const OWLMetrics *before = owlContextGetMetrics(scene.context);
+  owlGroupBuildAccel(quads);
+  const std::vector<HitRecord> hits = scene.render(quads);
+  const OWLMetrics *after = owlContextGetMetrics(scene.context);
+  CHECK(scene.hitAt(hits,vec2f(.25f,.25f)).geomTag == 1);
+
+  const std::string triangles
+    = "owl_accel_build_seconds{kind=\"triangles\"}";
+  const std::string instance
+    = "owl_accel_build_seconds{kind=\"instance\"}";
+  CHECK(histogramCount(after,triangles) == histogramCount(before,triangles)+1);
+  CHECK(histogramCount(after,instance) == histogramCount(before,instance));
+
+  // one ray type, one geom, one ray gen, one miss program
+  const char *kinds[] = { "hitgroup", "raygen", "miss" };
+  for (const char *kind : kinds) {
+    const std::string records
+      = std::string("owl_sbt_records_written_total{kind=\"")+kind+"\"}";
+    const std::string bytes
+      = std::string("owl_sbt_bytes_written_total{kind=\"")+kind+"\"}";
+    CHECK(counter(after,records) == counter(before,records)+1);
+    CHECK(counter(after,bytes) > counter(before,bytes));
+  }
+
+  const char *entries[] = { "owlGroupBuildAccel", "owlBuildSBT",
+                            "owlParamsLaunch2D" };
+  for (const char *entry : entries) {
+    const std::string calls
+      = std::string("owl_api_calls_total{entry=\"")+entry+"\"}";
+    CHECK(counter(after,calls) == counter(before,calls)+1);
+  }
+  CHECK(hasGauge(after,"owl_api_handles"));
+
+  // and the text export of a real snapshot has all of those
+  const std::string text = owlMetricsToText(after);
+  CHECK(text.find("owl_sbt_records_written_total{kind=\"hitgroup\"}")
+        != std::string::npos);
+  CHECK(text.find("owl_accel_build_seconds_count{kind=\"triangles\"}")
+        != std::string::npos);
+
+  owlMetricsRelease(before);
+  owlMetricsRelease(after);
+  owlGroupRelease(quads);
+  owlGeomRelease(quad);
+  return allPassed("rendered metrics");
+}
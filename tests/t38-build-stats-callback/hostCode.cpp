@@ -0,0 +1,112 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Checks owlContextSetBuildStatsCallback end to end: every group
+// build has to call the callback once (on our one device), with the
+// kind, group ID, and counts of what actually got built, and sizes
+// that are consistent with each other; and a null callback has to
+// stop the calls.
+
+#include "tests/common/HitTestScene.h"
+// std
+#include <cmath>
+#include <vector>
+
+#define OWL_TEST_NAME "t38"
+#include "tests/common/Check.h"
+
+using namespace owl::test;
+
+extern "C" char ptxCode[];
+
+void collect(const OWLBuildStats *stats, void *userData)
+{
+  ((std::vector<OWLBuildStats> *)userData)->push_back(*stats);
+}
+
+/*! what has to hold for the stats of any single-accel build */
+void checkSizes(const OWLBuildStats &stats)
+{
+  CHECK(stats.deviceID == 0);
+  CHECK(stats.numAccels == 1);
+  CHECK(stats.boundsSizeInBytes == 0);
+  CHECK(stats.tempSizeInBytes > 0);
+  CHECK(stats.outputSizeInBytes > 0);
+  CHECK(stats.compactedSizeInBytes > 0);
+  CHECK(stats.compactedSizeInBytes <= stats.outputSizeInBytes);
+  CHECK(std::fabs(stats.compactionRatio
+                  - double(stats.compactedSizeInBytes)
+                  / stats.outputSizeInBytes) < 1e-9);
+  CHECK(stats.hostBuildSeconds > 0.);
+  CHECK(stats.deviceBuildSeconds >= 0.);
+}
+
+int main(int ac, char **av)
+{
+  HitTestScene scene(ptxCode);
+  std::vector<OWLBuildStats> received;
+  owlContextSetBuildStatsCallback(scene.context,collect,&received);
+
+  OWLGeom quads[2] = {
+    scene.createQuad(1,vec2f(0.f),vec2f(.2f)),
+    scene.createQuad(2,vec2f(.5f),vec2f(.7f))
+  };
+  OWLGroup mesh = owlTrianglesGeomGroupCreate(scene.context,2,quads);
+  owlGroupBuildAccel(mesh);
+  CHECK(received.size() == 1);
+  CHECK(received[0].kind == OWL_BUILD_KIND_TRIANGLES);
+  CHECK(received[0].groupID == owlGroupGetID(mesh));
+  CHECK(received[0].numPrimitives == 4);
+  CHECK(received[0].numBuildInputs == 2);
+  checkSizes(received[0]);
+
+  // three instances of the mesh
+  OWLGroup world = owlInstanceGroupCreate(scene.context,3);
+  for (int i=0;i<3;i++) {
+    owlInstanceGroupSetChild(world,i,mesh);
+    owlInstanceGroupSetTransform(world,i,
+                                 Translation(vec3f(0.f,i*.25f,0.f)).xfm,
+                                 OWL_MATRIX_FORMAT_OWL);
+  }
+  owlGroupBuildAccel(world);
+  CHECK(received.size() == 2);
+  CHECK(received[1].kind == OWL_BUILD_KIND_INSTANCE);
+  CHECK(received[1].groupID == owlGroupGetID(world));
+  CHECK(received[1].numPrimitives == 3);
+  CHECK(received[1].numBuildInputs == 1);
+  // instance accels do not get compacted
+  CHECK(received[1].compactedSizeInBytes == received[1].outputSizeInBytes);
+  checkSizes(received[1]);
+
+  // the accels the stats were for are the ones that get traced
+  scene.buildPrograms();
+  const std::vector<HitRecord> hits = scene.render(world);
+  CHECK(scene.hitAt(hits,vec2f(.1f,.1f)).geomTag == 1);
+  CHECK(scene.hitAt(hits,vec2f(.1f,.6f)).geomTag == 1);
+  CHECK(scene.hitAt(hits,vec2f(.6f,.6f)).geomTag == 2);
+
+  owlContextSetBuildStatsCallback(scene.context,nullptr,nullptr);
+  owlGroupBuildAccel(mesh);
+  owlGroupBuildAccel(world);
+  CHECK(received.size() == 2);
+
+  owlGroupRelease(world);
+  owlGroupRelease(mesh);
+  owlGeomRelease(quads[0]);
+  owlGeomRelease(quads[1]);
+  return allPassed("build stats callback");
+}
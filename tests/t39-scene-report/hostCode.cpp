@@ -0,0 +1,101 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Checks owlContextDumpStats end to end: the report of a real
+// context - two identical meshes, each in a group of its own, and
+// instanced side by side - has to describe that scene, find the two
+// meshes' buffers as likely duplicates, recommend buffer dedup for
+// them, and know the sizes of the accels that got built.
+
+#include "tests/common/HitTestScene.h"
+// std
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#define OWL_TEST_NAME "t39"
+#include "tests/common/Check.h"
+
+using namespace owl::test;
+
+extern "C" char ptxCode[];
+
+bool contains(const std::string &s, const std::string &what)
+{
+  return s.find(what) != std::string::npos;
+}
+
+std::string readFile(const char *fileName)
+{
+  std::ifstream in(fileName);
+  std::stringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+int main(int ac, char **av)
+{
+  HitTestScene scene(ptxCode);
+  // same vertices and indices, so each one's buffers are copies of
+  // the other one's
+  OWLGeom quads[2] = {
+    scene.createQuad(1,vec2f(0.f),vec2f(.2f)),
+    scene.createQuad(2,vec2f(0.f),vec2f(.2f))
+  };
+  OWLGroup meshes[2] = {
+    owlTrianglesGeomGroupCreate(scene.context,1,&quads[0]),
+    owlTrianglesGeomGroupCreate(scene.context,1,&quads[1])
+  };
+  OWLGroup world = owlInstanceGroupCreate(scene.context,2);
+  for (int i=0;i<2;i++) {
+    owlGroupBuildAccel(meshes[i]);
+    owlInstanceGroupSetChild(world,i,meshes[i]);
+    owlInstanceGroupSetTransform(world,i,
+                                 Translation(vec3f(i*.5f,0.f,0.f)).xfm,
+                                 OWL_MATRIX_FORMAT_OWL);
+  }
+  owlGroupBuildAccel(world);
+  scene.buildPrograms();
+  const std::vector<HitRecord> hits = scene.render(world);
+  CHECK(scene.hitAt(hits,vec2f(.1f,.1f)).geomTag == 1);
+  CHECK(scene.hitAt(hits,vec2f(.6f,.1f)).geomTag == 2);
+
+  const char *fileName = "t39-scene-report.txt";
+  owlContextDumpStats(scene.context,fileName);
+  const std::string text = readFile(fileName);
+  std::remove(fileName);
+  CHECK(contains(text,"#owl.inspect: scene"));
+  CHECK(contains(text,"geoms              2 triangles, 0 user"));
+  CHECK(contains(text,"geom groups        2"));
+  CHECK(contains(text,"instance groups    1 (1 root(s), 2 instance(s))"));
+  CHECK(contains(text,"tiny meshes        2"));
+  // 4 vertices and 2 indices of the second quad
+  CHECK(contains(text,"likely duplicates  2 buffer(s), 72B"));
+  CHECK(contains(text,"owlContextSetBufferDedup"));
+  CHECK(contains(text,"[saves ~72B]"));
+  // the accels got built, so their sizes are known
+  CHECK(!contains(text,"geom accels        0B"));
+  CHECK(!contains(text,"instance accels    0B"));
+
+  owlGroupRelease(world);
+  for (int i=0;i<2;i++) {
+    owlGroupRelease(meshes[i]);
+    owlGeomRelease(quads[i]);
+  }
+  return allPassed("scene report");
+}
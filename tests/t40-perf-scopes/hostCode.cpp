@@ -0,0 +1,103 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Checks owlEnablePerfCounters end to end: with the counters active,
+// a real frame has to count each of its phases' scopes - one
+// instance packing per instance accel build, one SBT build scope
+// each for hit groups, miss programs, and ray gens - along with
+// their events; with them off (as on machines that do not let us
+// open perf events) the frame has to count nothing.
+
+#include "tests/common/HitTestScene.h"
+// std
+#include <iostream>
+#include <string>
+
+#define OWL_TEST_NAME "t40"
+#include "tests/common/Check.h"
+
+using namespace owl::test;
+
+extern "C" char ptxCode[];
+
+uint64_t counter(const OWLMetrics *metrics, const std::string &name)
+{
+  for (size_t i=0;i<metrics->numCounters;i++)
+    if (metrics->counters[i].name == name)
+      return metrics->counters[i].value;
+  return 0;
+}
+
+uint64_t gauge(const OWLMetrics *metrics, const std::string &name)
+{
+  for (size_t i=0;i<metrics->numGauges;i++)
+    if (metrics->gauges[i].name == name)
+      return metrics->gauges[i].value;
+  return 0;
+}
+
+std::string scopes(const char *phase)
+{
+  return std::string("owl_perf_scopes_total{phase=\"")+phase+"\"}";
+}
+
+int main(int ac, char **av)
+{
+  const bool active = owlEnablePerfCounters(1) != 0;
+  if (!active)
+    std::cout << "#owl.test(t40): perf counters not available, "
+              << "checking that nothing gets counted" << std::endl;
+
+  HitTestScene scene(ptxCode);
+  OWLGeom  quad = scene.createQuad(1,vec2f(0.f),vec2f(.5f));
+  OWLGroup mesh = owlTrianglesGeomGroupCreate(scene.context,1,&quad);
+  owlGroupBuildAccel(mesh);
+  OWLGroup world = owlInstanceGroupCreate(scene.context,1,&mesh);
+  scene.buildPrograms();
+
+  const OWLMetrics *before = owlContextGetMetrics(scene.context);
+  owlGroupBuildAccel(world);
+  const std::vector<HitRecord> hits = scene.render(world);
+  const OWLMetrics *after = owlContextGetMetrics(scene.context);
+  CHECK(scene.hitAt(hits,vec2f(.25f,.25f)).geomTag == 1);
+  CHECK(gauge(after,"owl_perf_counters_active") == (active ? 1 : 0));
+
+  const std::string packing = scopes("instance_packing");
+  const std::string sbtBuild = scopes("sbt_build");
+  const std::string sbtCycles
+    = "owl_perf_cycles_total{phase=\"sbt_build\"}";
+  if (active) {
+    CHECK(counter(after,packing) == counter(before,packing)+1);
+    CHECK(counter(after,sbtBuild) == counter(before,sbtBuild)+3);
+    CHECK(counter(after,sbtCycles) > counter(before,sbtCycles));
+    // the variable writes happen inside the SBT build
+    CHECK(counter(after,scopes("variable_writes"))
+          > counter(before,scopes("variable_writes")));
+  } else {
+    CHECK(counter(after,packing) == counter(before,packing));
+    CHECK(counter(after,sbtBuild) == counter(before,sbtBuild));
+    CHECK(counter(after,sbtCycles) == counter(before,sbtCycles));
+  }
+
+  owlMetricsRelease(before);
+  owlMetricsRelease(after);
+  owlEnablePerfCounters(0);
+  owlGroupRelease(world);
+  owlGroupRelease(mesh);
+  owlGeomRelease(quad);
+  return allPassed("perf scope");
+}
@@ -0,0 +1,211 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+// Tests camera path files and playback stats
+// (owl/common/viewerWidget/CameraPath.h): that saving and loading a
+// path gives back bit-identical cameras and timestamps, that
+// malformed files get rejected, and what the summary and CSV of a
+// playback look like.
+
+#include "owl/common/viewerWidget/CameraPath.h"
+// std
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace owl::viewer;
+
+#define OWL_TEST_NAME "t41"
+#include "tests/common/Check.h"
+
+const char *pathFile = "t41-camera-path.txt";
+
+bool sameBits(float a, float b)
+{
+  return memcmp(&a,&b,sizeof(a)) == 0;
+}
+
+bool sameBits(double a, double b)
+{
+  return memcmp(&a,&b,sizeof(a)) == 0;
+}
+
+bool sameBits(const vec3f &a, const vec3f &b)
+{
+  return sameBits(a.x,b.x) && sameBits(a.y,b.y) && sameBits(a.z,b.z);
+}
+
+bool sameCamera(const FullCamera &a, const FullCamera &b)
+{
+  return sameBits(a.position,b.position)
+    && sameBits(a.frame.vx,b.frame.vx)
+    && sameBits(a.frame.vy,b.frame.vy)
+    && sameBits(a.frame.vz,b.frame.vz)
+    && sameBits(a.poiDistance,b.poiDistance)
+    && sameBits(a.focalDistance,b.focalDistance)
+    && sameBits(a.upVector,b.upVector)
+    && a.forceUp == b.forceUp
+    && sameBits(a.motionSpeed,b.motionSpeed)
+    && sameBits(a.aspect,b.aspect)
+    && sameBits(a.fovyInDegrees,b.fovyInDegrees);
+}
+
+/*! whether loading 'fileName' throws */
+bool loadThrows(const std::string &fileName)
+{
+  try {
+    CameraPath::load(fileName);
+  } catch (const std::runtime_error &) {
+    return true;
+  }
+  return false;
+}
+
+void writeFile(const std::string &text)
+{
+  std::ofstream out(pathFile);
+  out << text;
+}
+
+void testRoundTrip()
+{
+  // values that don't survive a round trip through the stream's
+  // default precision
+  CameraPath path;
+  for (int i=0;i<5;i++) {
+    CameraPathFrame frame;
+    frame.time = i/3.+1e-12;
+    FullCamera &fc = frame.camera;
+    fc.position      = vec3f(1.f/3.f,-2.f/7.f,1e-38f*(i+1));
+    fc.frame.vx      = vec3f(0.1f,0.2f,0.3f+i);
+    fc.frame.vy      = vec3f(std::numeric_limits<float>::max(),
+                             std::numeric_limits<float>::min(),
+                             -0.f);
+    fc.frame.vz      = vec3f(std::nextafter(1.f,2.f),
+                             std::nextafter(1.f,0.f),
+                             -1.f/9.f);
+    fc.poiDistance   = 12345.678f;
+    fc.focalDistance = 1.f/(i+3);
+    fc.upVector      = vec3f(0.f,1.f,1e-7f);
+    fc.forceUp       = (i & 1);
+    fc.motionSpeed   = 0.57735027f;
+    fc.aspect        = 16.f/9.f;
+    fc.fovyInDegrees = 60.f+i/7.f;
+    path.frames.push_back(frame);
+  }
+  path.save(pathFile);
+  const CameraPath loaded = CameraPath::load(pathFile);
+  std::remove(pathFile);
+  
+  CHECK(loaded.frames.size() == path.frames.size());
+  for (size_t i=0;i<path.frames.size();i++) {
+    CHECK(sameBits(loaded.frames[i].time,path.frames[i].time));
+    CHECK(sameCamera(loaded.frames[i].camera,path.frames[i].camera));
+  }
+
+  // an empty path is still a valid file
+  CameraPath().save(pathFile);
+  CHECK(CameraPath::load(pathFile).frames.empty());
+  std::remove(pathFile);
+}
+
+void testMalformed()
+{
+  const std::string header = "owl-camera-path 1\n";
+  const std::string frame
+    = "0.5 0 -1 0 1 0 0 0 1 0 0 0 1 1 1 0 1 0 1 1 1.5 60";
+
+  // comments and empty lines get skipped
+  writeFile(header+"# a comment\n\n"+frame+"\n");
+  const CameraPath path = CameraPath::load(pathFile);
+  CHECK(path.frames.size() == 1);
+  CHECK(path.frames[0].time == .5);
+  CHECK(path.frames[0].camera.aspect == 1.5f);
+  CHECK(path.frames[0].camera.forceUp);
+
+  writeFile("");
+  CHECK(loadThrows(pathFile));
+  writeFile("owl-camera-path 2\n"+frame+"\n");
+  CHECK(loadThrows(pathFile));
+  writeFile(frame+"\n");
+  CHECK(loadThrows(pathFile));
+  // one field short, one too many, and one that's not a number
+  writeFile(header+frame.substr(0,frame.rfind(' '))+"\n");
+  CHECK(loadThrows(pathFile));
+  writeFile(header+frame+" 1\n");
+  CHECK(loadThrows(pathFile));
+  writeFile(header+"0.5 x"+frame.substr(frame.find(' ',4))+"\n");
+  CHECK(loadThrows(pathFile));
+  // a bad line after good ones still fails the whole file
+  writeFile(header+frame+"\n"+frame+"\n0.7\n");
+  CHECK(loadThrows(pathFile));
+  std::remove(pathFile);
+
+  CHECK(loadThrows("t41-no-such-camera-path.txt"));
+}
+
+CameraPathStats makeStats()
+{
+  CameraPathStats stats;
+  for (int i=1;i<=3;i++) {
+    CameraPathFrameTimes times;
+    times.pathTime   = .25*i;
+    times.updateTime = .001*i;
+    times.renderTime = .010*i;
+    stats.frames.push_back(times);
+  }
+  return stats;
+}
+
+void testSummary()
+{
+  std::ostringstream out;
+  makeStats().writeSummary(out);
+  CHECK(out.str() ==
+        "# viewer: camera path playback of 3 frames, 45.4545 fps\n"
+        "# viewer: update min 1 median 2 mean 2 max 3 (ms)\n"
+        "# viewer: render min 10 median 20 mean 20 max 30 (ms)\n");
+
+  std::ostringstream empty;
+  CameraPathStats().writeSummary(empty);
+  CHECK(empty.str() == "# viewer: camera path playback: no frames\n");
+}
+
+void testCSV()
+{
+  std::ostringstream out;
+  makeStats().writeCSV(out);
+  CHECK(out.str() ==
+        "frame,path_time,update_ms,render_ms\n"
+        "0,0.25,1,10\n"
+        "1,0.5,2,20\n"
+        "2,0.75,3,30\n");
+}
+
+int main(int ac, char **av)
+{
+  testRoundTrip();
+  testMalformed();
+  testSummary();
+  testCSV();
+  return owl::test::allPassed("camera path");
+}
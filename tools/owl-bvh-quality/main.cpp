@@ -0,0 +1,123 @@
+// ======================================================================== //
+// Copyright 2019 Ingo Wald                                                 //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+// Builds a reference binned-SAH BVH (see owl/ll/BVHQuality.h) over the
+// same inputs an app gives to owl's builders, and reports its
+// quality: SAH cost, overlap, leaf sizes, and the worst prims and
+// leaves. The inputs are raw binary dumps of the arrays the app
+// uploads - eg, written with a plain fwrite() of what goes into
+// owlDeviceBufferCreate():
+//
+//   --bounds <file>    box3f's of a user geom (6 floats per prim,
+//                      lower then upper), as for
+//                      lloUserGeomSetBoundsBuffer
+//   --vertices <file>  float3 vertices of a triangle mesh, and
+//   --indices <file>   its int3 indices
+//
+// Does not need a GPU.
+
+#include "owl/ll/BVHQuality.h"
+// std
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace owl::ll;
+
+/*! reads a file holding a raw array of T's */
+template<typename T>
+std::vector<T> readArray(const std::string &fileName)
+{
+  std::ifstream in(fileName,std::ios::binary|std::ios::ate);
+  if (!in)
+    throw std::runtime_error("could not open '"+fileName+"'");
+  const size_t numBytes = (size_t)in.tellg();
+  if (numBytes % sizeof(T))
+    throw std::runtime_error("size of '"+fileName+"' ("
+                             +std::to_string(numBytes)
+                             +" bytes) is not a multiple of "
+                             +std::to_string(sizeof(T)));
+  std::vector<T> result(numBytes/sizeof(T));
+  in.seekg(0);
+  in.read((char *)result.data(),numBytes);
+  if (!in)
+    throw std::runtime_error("could not read '"+fileName+"'");
+  return result;
+}
+
+void usage(const char *self)
+{
+  std::cerr
+    << "usage: " << self << " (--bounds <file> | --vertices <file> --indices <file>)" << std::endl
+    << "  [--bins <n>] [--max-leaf-size <n>] [--worst <n>]" << std::endl
+    << "  [--traversal-cost <c>] [--intersection-cost <c>]" << std::endl;
+  exit(1);
+}
+
+int main(int ac, char **av)
+{
+  std::string boundsFile, verticesFile, indicesFile;
+  BVHQualityConfig config;
+  for (int i=1;i<ac;i++) {
+    const std::string arg = av[i];
+    if (i+1 >= ac)
+      usage(av[0]);
+    if (arg == "--bounds")
+      boundsFile = av[++i];
+    else if (arg == "--vertices")
+      verticesFile = av[++i];
+    else if (arg == "--indices")
+      indicesFile = av[++i];
+    else if (arg == "--bins")
+      config.numBins = std::atoi(av[++i]);
+    else if (arg == "--max-leaf-size")
+      config.maxLeafSize = std::atoi(av[++i]);
+    else if (arg == "--worst")
+      config.numWorstOffenders = std::atoi(av[++i]);
+    else if (arg == "--traversal-cost")
+      config.traversalCost = (float)std::atof(av[++i]);
+    else if (arg == "--intersection-cost")
+      config.intersectionCost = (float)std::atof(av[++i]);
+    else
+      usage(av[0]);
+  }
+  const bool haveBounds    = !boundsFile.empty();
+  const bool haveTriangles = !verticesFile.empty() && !indicesFile.empty();
+  if (haveBounds == haveTriangles)
+    usage(av[0]);
+
+  try {
+    BVHQualityReport report;
+    if (haveBounds) {
+      const std::vector<box3f> bounds = readArray<box3f>(boundsFile);
+      report = analyzeBVHQuality(bounds.data(),bounds.size(),config);
+    } else {
+      const std::vector<vec3f> vertices = readArray<vec3f>(verticesFile);
+      const std::vector<vec3i> indices  = readArray<vec3i>(indicesFile);
+      report = analyzeBVHQuality(vertices.data(),vertices.size(),
+                                 indices.data(),indices.size(),
+                                 config);
+    }
+    writeReport(std::cout,report);
+  } catch (std::exception &e) {
+    std::cerr << "#owl.bvh: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}